@@ -443,7 +443,7 @@ main(void)
         // Erase the target sector.
         //
         DEBUG_PRINT("Erasing Sector %d\n", sector);
-        ui32Status = am_devices_mspi_flash_sector_erase(MSPI_TEST_MODULE, sector << 16);
+        ui32Status = am_devices_mspi_flash_sector_erase(MSPI_TEST_MODULE, sector * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE);
         if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != ui32Status)
         {
             DEBUG_PRINT("Failed to erase Flash Device sector!\n");
@@ -41,7 +41,8 @@
 //! SEQLOOP not defined - The CQ is programmed each iteration
 //! SEQLOOP - Advanced mode, to create sequence once, which repeats when triggered by callback at the end of each iteration
 //! SEQLOOP - RUN_AUTONOMOUS - Sequence created once, and it repeats indefintely till paused (as a result of timer)
-//! CQ_RAW - Uses Preconstructed CQ for IOM and MSPI - to save on the time to program the same at run time
+//! CQ_RAW - Uses CQ programs for IOM and MSPI, built with am_hal_cmdq_prog_*() and handed
+//! to the HAL in one request - to save on the time to program the same at run time
 //!
 //! Best way to see the example in action is to connect logic analyzer and monitor the signals
 //! Apart from the IO signals below, one can also monitor CPU_SLEEP_GPIO to monitor CPU in deep sleep
@@ -303,7 +304,7 @@ uint32_t        g_MspiQBuffer[(AM_HAL_MSPI_CQ_ENTRY_SIZE / 4) * (NUM_FRAGMENTS +
 uint32_t        g_IomQBuffer[(AM_HAL_IOM_CQ_ENTRY_SIZE / 4) * (4 + 1)];
 // Buffer for non-blocking transactions for MSPI - can be much smaller as the CQ is preconstructed in a separare memory
 // all the transactions
-uint32_t        g_MspiQBuffer[(AM_HAL_MSPI_CQ_ENTRY_SIZE / 4) * (4 + 1)];
+uint32_t        g_MspiQBuffer[(AM_HAL_MSPI_CQ_ENTRY_SIZE / 4) * 8];
 #endif
 
 // Temp Buffer in SRAM to read PSRAM data to, and write DISPLAY data from
@@ -777,7 +778,7 @@ init_mspi_flash_data(void)
         // Erase the target sector.
         //
         am_util_stdio_printf("Erasing Sector %d\n", sector);
-        ui32Status = am_devices_mspi_flash_sector_erase(MSPI_TEST_MODULE, sector << 16);
+        ui32Status = am_devices_mspi_flash_sector_erase(MSPI_TEST_MODULE, sector * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE);
         if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != ui32Status)
         {
             am_util_stdio_printf("Failed to erase Flash Device sector!\n");
@@ -861,141 +862,29 @@ fram_write_complete(void *pCallbackCtxt, uint32_t transactionStatus)
 #ifdef CQ_RAW
 // 2 blocks are includes in head and tail
 #define MAX_INT_BLOCKS    (NUM_FRAGMENTS - 2)
-// Jump - by reprogramming the CQADDR
-typedef struct
-{
-    uint32_t    ui32CQAddrAddr;
-    uint32_t    ui32CQAddrVal;
-} am_hal_cq_jmp_t;
-
-// IOM
-//
-// Command Queue entry structure.
-//
-typedef struct
-{
-    uint32_t    ui32PAUSENAddr;
-    uint32_t    ui32PAUSEENVal;
-    uint32_t    ui32PAUSEN2Addr;
-    uint32_t    ui32PAUSEEN2Val;
-    // Following 4 fields are only needed for first block
-    uint32_t    ui32OFFSETHIAddr;
-    uint32_t    ui32OFFSETHIVal;
-    uint32_t    ui32DEVCFGAddr;
-    uint32_t    ui32DEVCFGVal;
-
-    uint32_t    ui32DMACFGdis1Addr;
-    uint32_t    ui32DMACFGdis1Val;
-    uint32_t    ui32DMATOTCOUNTAddr;
-    uint32_t    ui32DMATOTCOUNTVal;
-    uint32_t    ui32DMATARGADDRAddr;
-    uint32_t    ui32DMATARGADDRVal;
-    uint32_t    ui32DMACFGAddr;
-    uint32_t    ui32DMACFGVal;
-    // CMDRPT register has been repurposed for DCX
-    uint32_t    ui32DCXAddr;
-    uint32_t    ui32DCXVal;
-    uint32_t    ui32CMDAddr;
-    uint32_t    ui32CMDVal;
-
-    uint32_t    ui32SETCLRAddr;
-    uint32_t    ui32SETCLRVal;
-} am_hal_iom_txn_head_t;
-
-typedef struct
-{
-    uint32_t    ui32PAUSENAddr;
-    uint32_t    ui32PAUSEENVal;
-    uint32_t    ui32PAUSEN2Addr;
-    uint32_t    ui32PAUSEEN2Val;
-
-    uint32_t    ui32DMACFGdis1Addr;
-    uint32_t    ui32DMACFGdis1Val;
-    uint32_t    ui32DMATOTCOUNTAddr;
-    uint32_t    ui32DMATOTCOUNTVal;
-    uint32_t    ui32DMATARGADDRAddr;
-    uint32_t    ui32DMATARGADDRVal;
-    uint32_t    ui32DMACFGAddr;
-    uint32_t    ui32DMACFGVal;
-    // CMDRPT register has been repurposed for DCX
-    uint32_t    ui32DCXAddr;
-    uint32_t    ui32DCXVal;
-    uint32_t    ui32CMDAddr;
-    uint32_t    ui32CMDVal;
 
-    uint32_t    ui32SETCLRAddr;
-    uint32_t    ui32SETCLRVal;
-} am_hal_iom_txn_seg_t;
-
-typedef struct
-{
-    // Each block will be max size transfer with CONT set
-    am_hal_iom_txn_seg_t block[MAX_INT_BLOCKS]; // Fixed
-    am_hal_cq_jmp_t  jmp; // Jump always to am_hal_iom_long_txn_t->tail
-} am_hal_iom_txn_seq_t;
-
-typedef struct
-{
-    // Head
-    // Max size transfer with CONT Set
-    am_hal_iom_txn_head_t    head; // Programmable per transaction: ui32OFFSETHIVal, ui32HdrDMATARGADDRVal, ui32HdrCMDVal
-    // Jmp
-    am_hal_cq_jmp_t          jmp; // Programmable address to jump inside am_hal_iom_txn_seq_t
-    // Tail
-    am_hal_iom_txn_seg_t     tail; // Programmable tail length, CMD Value
-    am_hal_cq_jmp_t          jmpOut; // Programmable address to jump back to the original CQ
-} am_hal_iom_long_txn_t;
-
-// MSPI
-//
-// Command Queue entry structure.
-//
-typedef struct
-{
-    uint32_t                    ui32PAUSENAddr;
-    uint32_t                    ui32PAUSEENVal;
-    uint32_t                    ui32PAUSEN2Addr;
-    uint32_t                    ui32PAUSEEN2Val;
-    uint32_t                    ui32DMATARGADDRAddr;
-    uint32_t                    ui32DMATARGADDRVal;
-    uint32_t                    ui32DMADEVADDRAddr;
-    uint32_t                    ui32DMADEVADDRVal;
-    uint32_t                    ui32DMATOTCOUNTAddr;
-    uint32_t                    ui32DMATOTCOUNTVal;
-    uint32_t                    ui32DMACFG1Addr;
-    uint32_t                    ui32DMACFG1Val;
-    // Need to disable the DMA to prepare for next reconfig
-    // Need to have this following the DMAEN for CMDQ
-    uint32_t                    ui32DMACFG2Addr;
-    uint32_t                    ui32DMACFG2Val;
-    uint32_t                    ui32SETCLRAddr;
-    uint32_t                    ui32SETCLRVal;
-} am_hal_mspi_txn_seg_t;
+// Program sizes in CQ entries
+// IOM: head (11), other blocks (9 each), exit jump
+#define IOM_PROG_ENTRIES  (11 + 9 * (NUM_FRAGMENTS - 1) + 1)
+// MSPI: blocks (8 each), exit jump
+#define MSPI_PROG_ENTRIES (8 * NUM_FRAGMENTS + 1)
 
+// Settings common to all the blocks of a transaction
 typedef struct
 {
-    // Each block will be max size transfer with CONT set
-    am_hal_mspi_txn_seg_t block[MAX_INT_BLOCKS]; // Fixed
-    am_hal_cq_jmp_t  jmp; // Jump always to am_hal_iom_long_txn_t->tail
-} am_hal_mspi_txn_seq_t;
+    uint32_t    ui32Module;
+    uint32_t    ui32DmaCfg;
+    uint32_t    ui32DevCfg;
+} cq_long_cfg_t;
 
+cq_long_cfg_t       gIomLongCfg;
+cq_long_cfg_t       gMspiLongCfg;
 
-typedef struct
-{
-    // Head
-    // Max size transfer with CONT Set
-    am_hal_mspi_txn_seg_t    head; // Programmable per transaction: ui32OFFSETHIVal, ui32HdrDMATARGADDRVal, ui32HdrCMDVal
-    // Jmp
-    am_hal_cq_jmp_t      jmp; // Programmable address to jump inside am_hal_iom_txn_seq_t
-    // Tail
-    am_hal_mspi_txn_seg_t     tail; // Programmable tail length, CMD Value
-    am_hal_cq_jmp_t      jmpOut; // Programmable address to jump back to the original CQ
-} am_hal_mspi_long_txn_t;
-
-am_hal_iom_long_txn_t  gIomLongTxn;
-am_hal_iom_txn_seq_t   gIomSequence;
-am_hal_mspi_long_txn_t gMspiLongTxn;
-am_hal_mspi_txn_seq_t  gMspiSequence;
+// CQ programs, built with am_hal_cmdq_prog_*() for each transaction
+am_hal_cmdq_entry_t gIomProg[IOM_PROG_ENTRIES];
+am_hal_cmdq_entry_t gMspiProg[MSPI_PROG_ENTRIES];
+uint32_t            *gpIomProgExit;
+uint32_t            *gpMspiProgExit;
 
 //*****************************************************************************
 //
@@ -1046,163 +935,64 @@ build_iom_cmd(uint32_t ui32CS,     uint32_t ui32Dir, uint32_t ui32Cont,
     return ui32Cmd;
 } // build_cmd()
 
-
-// One time initialization
-void iom_init_cq_long(uint32_t ui32Module)
+//
+// The tail block always uses the same ping-pong buffer, so the flags are in
+// the same state at the end of every transaction whatever its size.
+// Returns the buffer for block ui32Block of a ui32NumBlocks transaction.
+//
+static uint32_t
+cq_long_buffer(uint32_t ui32Block, uint32_t ui32NumBlocks)
 {
-    am_hal_iom_long_txn_t *pIomLong = &gIomLongTxn;
-    // Initialize the head block
-    // Initialize the tail block
-    //
-    // Command for OFFSETHI
-    //
-    pIomLong->head.ui32OFFSETHIAddr  = (uint32_t)&IOMn(ui32Module)->OFFSETHI;
-
-    //
-    // Command for I2C DEVADDR field in DEVCFG
-    //
-    pIomLong->head.ui32DEVCFGAddr    = (uint32_t)&IOMn(ui32Module)->DEVCFG;
-
-    //
-    // Command to disable DMA before writing TOTCOUNT.
-    //
-    pIomLong->tail.ui32DMACFGdis1Addr = pIomLong->head.ui32DMACFGdis1Addr   = (uint32_t)&IOMn(ui32Module)->DMACFG;
-    pIomLong->tail.ui32DMACFGdis1Val = pIomLong->head.ui32DMACFGdis1Val    = 0x0;
-
-    //
-    // Command to set DMATOTALCOUNT
-    //
-    pIomLong->tail.ui32DMATOTCOUNTAddr = pIomLong->head.ui32DMATOTCOUNTAddr = (uint32_t)&IOMn(ui32Module)->DMATOTCOUNT;
-
-    //
-    // Command to set DMATARGADDR
-    //
-    pIomLong->head.ui32DMATARGADDRAddr = (uint32_t)&IOMn(ui32Module)->DMATARGADDR;
-    pIomLong->tail.ui32DMATARGADDRAddr = (uint32_t)&IOMn(ui32Module)->DMATARGADDR;
-    pIomLong->tail.ui32DMATARGADDRVal = (MAX_INT_BLOCKS % 2) ? (uint32_t)&g_TempBuf[0] : (uint32_t)&g_TempBuf[1];
-    //
-    // Command to set DMACFG to start the DMA operation
-    //
-    pIomLong->tail.ui32DMACFGAddr = pIomLong->head.ui32DMACFGAddr    = (uint32_t)&IOMn(ui32Module)->DMACFG;
-
-    // CMDRPT register has been repurposed for DCX
-    pIomLong->head.ui32DCXAddr = pIomLong->tail.ui32DCXAddr = (uint32_t)&IOMn(ui32Module)->DCX;
-    pIomLong->head.ui32DCXVal = pIomLong->tail.ui32DCXVal = 0; // This will be replaced with DCX Alternate CS TODO
-
-    pIomLong->tail.ui32CMDAddr = pIomLong->head.ui32CMDAddr = (uint32_t)&IOMn(ui32Module)->CMD;
-
-    // Initialize the jumps
-    gIomSequence.jmp.ui32CQAddrAddr = pIomLong->jmpOut.ui32CQAddrAddr = pIomLong->jmp.ui32CQAddrAddr = (uint32_t)&IOMn(ui32Module)->CQADDR;
-    gIomSequence.jmp.ui32CQAddrVal = (uint32_t)&pIomLong->tail;
-    // Initialize the sequence blocks
-    for (uint32_t i = 0; i < MAX_INT_BLOCKS; i++)
-    {
-        gIomSequence.block[i].ui32PAUSENAddr = gIomSequence.block[i].ui32PAUSEN2Addr = (uint32_t)&IOMn(ui32Module)->CQPAUSEEN;
-        gIomSequence.block[i].ui32SETCLRAddr = (uint32_t)&IOMn(ui32Module)->CQSETCLEAR;
-        //
-        // Command to disable DMA before writing TOTCOUNT.
-        //
-        gIomSequence.block[i].ui32DMACFGdis1Addr = (uint32_t)&IOMn(ui32Module)->DMACFG;
-        gIomSequence.block[i].ui32DMACFGdis1Val = 0x0;
-
-        //
-        // Command to set DMATOTALCOUNT
-        //
-        gIomSequence.block[i].ui32DMATOTCOUNTAddr = (uint32_t)&IOMn(ui32Module)->DMATOTCOUNT;
-
-        //
-        // Command to set DMACFG to start the DMA operation
-        //
-        gIomSequence.block[i].ui32DMACFGAddr = (uint32_t)&IOMn(ui32Module)->DMACFG;
-
-        gIomSequence.block[i].ui32DCXAddr = (uint32_t)&IOMn(ui32Module)->DCX;
-        gIomSequence.block[i].ui32CMDAddr = (uint32_t)&IOMn(ui32Module)->CMD;
-        // Pause Conditions
-#if 0
-        // Normal Memory
-        // Set default values - these may be updated later
-        gIomSequence.block[i].ui32PAUSEENVal = AM_HAL_IOM_CQP_PAUSE_DEFAULT;
-        gIomSequence.block[i].ui32SETCLRVal = 0;
-#else
-        // This is the Pause Boundary for HiPrio transactions
-        gIomSequence.block[i].ui32PAUSEENVal = AM_HAL_IOM_CQP_PAUSE_DEFAULT | ((i % 2) ? IOM_WAIT_FOR_MSPI_BUFFER0 : IOM_WAIT_FOR_MSPI_BUFFER1);
-        gIomSequence.block[i].ui32PAUSEEN2Val = AM_HAL_IOM_PAUSE_DEFAULT;
-        gIomSequence.block[i].ui32SETCLRVal = (i % 2) ? IOM_SIGNAL_MSPI_BUFFER0 : IOM_SIGNAL_MSPI_BUFFER1;
-#endif
-        gIomSequence.block[i].ui32DMATARGADDRAddr = (uint32_t)&IOMn(ui32Module)->DMATARGADDR;
-        gIomSequence.block[i].ui32DMATARGADDRVal = (i % 2) ? (uint32_t)&g_TempBuf[0] : (uint32_t)&g_TempBuf[1];
-    }
-    // Initialize the Pause conditions
-    pIomLong->head.ui32PAUSENAddr = pIomLong->tail.ui32PAUSENAddr = (uint32_t)&IOMn(ui32Module)->CQPAUSEEN;
-    pIomLong->head.ui32PAUSEN2Addr = pIomLong->tail.ui32PAUSEN2Addr = (uint32_t)&IOMn(ui32Module)->CQPAUSEEN;
-    pIomLong->head.ui32SETCLRAddr = pIomLong->tail.ui32SETCLRAddr = (uint32_t)&IOMn(ui32Module)->CQSETCLEAR;
-
-    pIomLong->tail.ui32PAUSEEN2Val = AM_HAL_IOM_PAUSE_DEFAULT;
-    pIomLong->head.ui32PAUSEEN2Val = AM_HAL_IOM_PAUSE_DEFAULT;
-#if 0
-    // Normal Memory
-    // Set default values - these may be updated later
-    pIomLong->tail.ui32PAUSEENVal = AM_HAL_IOM_CQP_PAUSE_DEFAULT;
-    pIomLong->tail.ui32SETCLRVal = 0;
-#else
-    // This is the Pause Boundary for HiPrio transactions
-    pIomLong->tail.ui32PAUSEENVal = AM_HAL_IOM_CQP_PAUSE_DEFAULT | ((MAX_INT_BLOCKS % 2) ? IOM_WAIT_FOR_MSPI_BUFFER0 : IOM_WAIT_FOR_MSPI_BUFFER1);
-    pIomLong->tail.ui32SETCLRVal = (MAX_INT_BLOCKS % 2) ? IOM_SIGNAL_MSPI_BUFFER0 : IOM_SIGNAL_MSPI_BUFFER1;
-#endif
+    return (MAX_INT_BLOCKS + 2 - ui32NumBlocks + ui32Block) % 2;
 }
 
+// IOM
 // Initialize for each type of transacation
 void iom_setup_cq_long(uint32_t ui32Module, uint8_t ui8Priority, uint32_t ui32Dir, uint32_t blockSize, uint32_t ui32SpiChipSelect, uint32_t ui32I2CDevAddr)
 {
-    am_hal_iom_long_txn_t *pIomLong = &gIomLongTxn;
-    uint32_t ui32DMACFGVal;
-    ui32DMACFGVal     =
+    (void)blockSize;
+    (void)ui32SpiChipSelect;
+    gIomLongCfg.ui32Module = ui32Module;
+    gIomLongCfg.ui32DmaCfg =
         _VAL2FLD(IOM0_DMACFG_DMAPRI, ui8Priority)     |
         _VAL2FLD(IOM0_DMACFG_DMADIR, ui32Dir == AM_HAL_IOM_TX ? 1 : 0) |
         IOM0_DMACFG_DMAEN_Msk;
-
     // Command for I2C DEVADDR field in DEVCFG
-    pIomLong->head.ui32DEVCFGVal     = _VAL2FLD(IOM0_DEVCFG_DEVADDR, ui32I2CDevAddr);
-    //
-    // Command to set DMATOTALCOUNT
-    //
-    pIomLong->head.ui32DMATOTCOUNTVal = blockSize;
+    gIomLongCfg.ui32DevCfg = _VAL2FLD(IOM0_DEVCFG_DEVADDR, ui32I2CDevAddr);
+}
 
-    //
-    // Command to set DMACFG to start the DMA operation
-    //
-    pIomLong->tail.ui32DMACFGVal = pIomLong->head.ui32DMACFGVal = ui32DMACFGVal;
+//
+// One IOM block: wait for MSPI to fill the buffer, write it out, hand the
+// buffer back to MSPI.  The head block also carries OFFSETHI and DEVCFG.
+//
+static void
+iom_prog_block(am_hal_cmdq_prog_t *pProg, uint32_t ui32Buf, bool bHead,
+               uint32_t ui32OffsetHi, uint32_t ui32NumBytes, uint32_t ui32Cmd)
+{
+    IOM0_Type *pIom = IOMn(gIomLongCfg.ui32Module);
 
-    // Initialize the sequence blocks
-    for (uint32_t i = 0; i < MAX_INT_BLOCKS; i++)
+    // This is the Pause Boundary for HiPrio transactions
+    am_hal_cmdq_prog_wait(pProg, AM_HAL_IOM_PAUSE_FLAG_CQ |
+                          (ui32Buf ? IOM_WAIT_FOR_MSPI_BUFFER1 : IOM_WAIT_FOR_MSPI_BUFFER0));
+    if (bHead)
     {
-        uint32_t ui32Cmd;
-        //
-        // Command to start the transfer.
-        //
-        ui32Cmd = build_iom_cmd(ui32SpiChipSelect, // ChipSelect
-                            ui32Dir,          // ui32Dir
-                            true,           // ui32Cont
-                            0,           // ui32Offset
-                            0,        // ui32OffsetCnt
-                            blockSize);  // ui32Bytes
-
-        //
-        // Command to set DMATOTALCOUNT
-        //
-        gIomSequence.block[i].ui32DMATOTCOUNTVal = blockSize;
-
-        //
-        // Command to set DMACFG to start the DMA operation
-        //
-        gIomSequence.block[i].ui32DMACFGVal = ui32DMACFGVal;
-
-        // Command
-        gIomSequence.block[i].ui32CMDVal = ui32Cmd;
+        am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->OFFSETHI, ui32OffsetHi);
+        am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->DEVCFG, gIomLongCfg.ui32DevCfg);
     }
+    //
+    // Disable DMA before writing TOTCOUNT.
+    //
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->DMACFG, 0);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->DMATOTCOUNT, ui32NumBytes);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->DMATARGADDR, (uint32_t)&g_TempBuf[ui32Buf]);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->DMACFG, gIomLongCfg.ui32DmaCfg);
+    // CMDRPT register has been repurposed for DCX
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->DCX, 0);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pIom->CMD, ui32Cmd);
+    am_hal_cmdq_prog_signal(pProg, ui32Buf ? IOM_SIGNAL_MSPI_BUFFER1 : IOM_SIGNAL_MSPI_BUFFER0);
 }
 
-static void
+static uint32_t
 create_iom_mspi_read_transaction(uint32_t blockSize,
                                 uint32_t ui32Dir,
                                 uint32_t ui32NumBytes,
@@ -1210,225 +1000,108 @@ create_iom_mspi_read_transaction(uint32_t blockSize,
                                 uint32_t ui32InstrLen, // Address length
                                 uint32_t ui32SpiChipSelect)
 {
-    uint32_t ui32Cmd;
-    // initialize various fields
-    // initialize gIomLongTxn
-    // head: ui32OFFSETHIVal, ui32HdrDMATARGADDRVal, ui32HdrCMDVal
-    gIomLongTxn.head.ui32OFFSETHIVal   = (uint16_t)(ui32Instr >> 8);
-
+    am_hal_cmdq_prog_t sProg;
     uint32_t numBlocks = (ui32NumBytes + blockSize - 1) / blockSize;
+    uint32_t ui32Status;
 
-    // jmp: ui32CQAddrVal
-    if (numBlocks > 1)
-    {
-        ui32Cmd = build_iom_cmd(ui32SpiChipSelect, // ChipSelect
-                            ui32Dir,          // ui32Dir
-                            true,           // ui32Cont
-                            ui32Instr,           // ui32Offset
-                            ui32InstrLen,        // ui32OffsetCnt
-                            blockSize);  // ui32Bytes
-        gIomLongTxn.head.ui32CMDVal   = ui32Cmd;
-        if (numBlocks > 2)
-        {
-            // Identify where in the block array to jump to
-            gIomLongTxn.jmp.ui32CQAddrVal = (uint32_t)&gIomSequence.block[MAX_INT_BLOCKS - (numBlocks - 2)];
-        }
-        else
-        {
-            // Just jump to tail
-            gIomLongTxn.jmp.ui32CQAddrVal = (uint32_t)&gIomLongTxn.tail;
-        }
-        ui32NumBytes -= blockSize*(numBlocks - 1);
-        // tail: ui32HdrCMDVal & ui32DMATOTCOUNTVal
-        // Initialize the count & command for tail
-        gIomLongTxn.tail.ui32DMATOTCOUNTVal  = ui32NumBytes;
-        ui32Cmd = build_iom_cmd(ui32SpiChipSelect, // ChipSelect
-                            ui32Dir,          // ui32Dir
-                            false,           // ui32Cont
-                            0,           // ui32Offset
-                            0,        // ui32OffsetCnt
-                            ui32NumBytes);  // ui32Bytes
-        gIomLongTxn.tail.ui32CMDVal   = ui32Cmd;
-    }
-    else
+    ui32Status = am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_IOM0 + gIomLongCfg.ui32Module,
+                                       gIomProg, IOM_PROG_ENTRIES);
+    if (ui32Status)
     {
-        ui32Cmd = build_iom_cmd(ui32SpiChipSelect, // ChipSelect
-                            ui32Dir,          // ui32Dir
-                            false,           // ui32Cont
-                            ui32Instr,           // ui32Offset
-                            ui32InstrLen,        // ui32OffsetCnt
-                            ui32NumBytes);  // ui32Bytes
-        gIomLongTxn.head.ui32CMDVal   = ui32Cmd;
-        // Just jump to end
-        gIomLongTxn.jmp.ui32CQAddrVal = (uint32_t)&gIomLongTxn.jmpOut;
+        return ui32Status;
     }
 
-    // Initialize head - based on how many blocks
-    if ((MAX_INT_BLOCKS + 2 - numBlocks) % 2)
+    for (uint32_t i = 0; i < numBlocks; i++)
     {
-        gIomLongTxn.head.ui32DMATARGADDRVal = (uint32_t)&g_TempBuf[1];
-        // This is the Pause Boundary for HiPrio transactions
-        gIomLongTxn.head.ui32PAUSEENVal = AM_HAL_IOM_CQP_PAUSE_DEFAULT | IOM_WAIT_FOR_MSPI_BUFFER1;
-        gIomLongTxn.head.ui32SETCLRVal = IOM_SIGNAL_MSPI_BUFFER1;
-    }
-    else
-    {
-        gIomLongTxn.head.ui32DMATARGADDRVal = (uint32_t)&g_TempBuf[0];
-        // This is the Pause Boundary for HiPrio transactions
-        gIomLongTxn.head.ui32PAUSEENVal = AM_HAL_IOM_CQP_PAUSE_DEFAULT | IOM_WAIT_FOR_MSPI_BUFFER0;
-        gIomLongTxn.head.ui32SETCLRVal = IOM_SIGNAL_MSPI_BUFFER0;
-    }
-}
+        bool bLast = (i == (numBlocks - 1));
+        uint32_t ui32Bytes = bLast ? (ui32NumBytes - blockSize * i) : blockSize;
+        uint32_t ui32Cmd;
 
-// MSPI
-// One time initialization
-void mspi_init_cq_long(uint32_t ui32Module)
-{
-    am_hal_mspi_long_txn_t *pMspiLong = &gMspiLongTxn;
-    // Initialize the head block
-    // Initialize the tail block
-    pMspiLong->head.ui32PAUSENAddr = (uint32_t)&MSPIn(ui32Module)->CQPAUSE;
-    pMspiLong->head.ui32PAUSEN2Addr = (uint32_t)&MSPIn(ui32Module)->CQPAUSE;
-    pMspiLong->head.ui32DMATARGADDRAddr = (uint32_t)&MSPIn(ui32Module)->DMATARGADDR;
-    pMspiLong->head.ui32DMADEVADDRAddr = (uint32_t)&MSPIn(ui32Module)->DMADEVADDR;
-    pMspiLong->head.ui32DMATOTCOUNTAddr = (uint32_t)&MSPIn(ui32Module)->DMATOTCOUNT;
-    pMspiLong->head.ui32DMACFG1Addr = (uint32_t)&MSPIn(ui32Module)->DMACFG;
-    pMspiLong->head.ui32DMACFG2Addr = (uint32_t)&MSPIn(ui32Module)->DMACFG;
-    pMspiLong->head.ui32SETCLRAddr = (uint32_t)&MSPIn(ui32Module)->CQSETCLEAR;
-
-    pMspiLong->tail.ui32PAUSENAddr = (uint32_t)&MSPIn(ui32Module)->CQPAUSE;
-    pMspiLong->tail.ui32PAUSEN2Addr = (uint32_t)&MSPIn(ui32Module)->CQPAUSE;
-    pMspiLong->tail.ui32DMATARGADDRAddr = (uint32_t)&MSPIn(ui32Module)->DMATARGADDR;
-    pMspiLong->tail.ui32DMATOTCOUNTAddr = (uint32_t)&MSPIn(ui32Module)->DMATOTCOUNT;
-    pMspiLong->tail.ui32DMACFG1Addr = (uint32_t)&MSPIn(ui32Module)->DMACFG;
-    pMspiLong->tail.ui32DMACFG2Addr = (uint32_t)&MSPIn(ui32Module)->DMACFG;
-    pMspiLong->tail.ui32SETCLRAddr = (uint32_t)&MSPIn(ui32Module)->CQSETCLEAR;
-    pMspiLong->tail.ui32DMADEVADDRAddr = (uint32_t)&MSPIn(ui32Module)->DMADEVADDR;
-
-    pMspiLong->head.ui32DMACFG2Val = _VAL2FLD(MSPI_DMACFG_DMAEN, 0);
-    pMspiLong->tail.ui32DMACFG2Val = _VAL2FLD(MSPI_DMACFG_DMAEN, 0);
-
-    pMspiLong->tail.ui32DMATARGADDRVal = (MAX_INT_BLOCKS % 2) ? (uint32_t)&g_TempBuf[0] : (uint32_t)&g_TempBuf[1];
-
-    // Initialize the jumps
-    gMspiSequence.jmp.ui32CQAddrAddr = pMspiLong->jmpOut.ui32CQAddrAddr = pMspiLong->jmp.ui32CQAddrAddr = (uint32_t)&MSPIn(ui32Module)->CQADDR;
-    gMspiSequence.jmp.ui32CQAddrVal = (uint32_t)&pMspiLong->tail;
-    // Initialize the sequence blocks
-    for (uint32_t i = 0; i < MAX_INT_BLOCKS; i++)
-    {
-        gMspiSequence.block[i].ui32PAUSENAddr = (uint32_t)&MSPIn(ui32Module)->CQPAUSE;
-        gMspiSequence.block[i].ui32PAUSEN2Addr = (uint32_t)&MSPIn(ui32Module)->CQPAUSE;
-        gMspiSequence.block[i].ui32DMATARGADDRAddr = (uint32_t)&MSPIn(ui32Module)->DMATARGADDR;
-        gMspiSequence.block[i].ui32DMATOTCOUNTAddr = (uint32_t)&MSPIn(ui32Module)->DMATOTCOUNT;
-        gMspiSequence.block[i].ui32DMACFG1Addr = (uint32_t)&MSPIn(ui32Module)->DMACFG;
-        gMspiSequence.block[i].ui32DMACFG2Addr = (uint32_t)&MSPIn(ui32Module)->DMACFG;
-        gMspiSequence.block[i].ui32SETCLRAddr = (uint32_t)&MSPIn(ui32Module)->CQSETCLEAR;
-        gMspiSequence.block[i].ui32DMADEVADDRAddr = (uint32_t)&MSPIn(ui32Module)->DMADEVADDR;
-        // Pause Conditions
-#if 0
-        // Normal Memory
-        // Set default values - these may be updated later
-        gMspiSequence.block[i].ui32PAUSEENVal = AM_HAL_MSPI_CQP_PAUSE_DEFAULT;
-        gMspiSequence.block[i].ui32SETCLRVal = 0;
-#else
-        // This is the Pause Boundary for HiPrio transactions
-        gMspiSequence.block[i].ui32PAUSEENVal = AM_HAL_MSPI_CQP_PAUSE_DEFAULT | ((i % 2) ? MSPI_WAIT_FOR_IOM_BUFFER0 : MSPI_WAIT_FOR_IOM_BUFFER1);
-        gMspiSequence.block[i].ui32PAUSEEN2Val = AM_HAL_MSPI_PAUSE_DEFAULT;
-        gMspiSequence.block[i].ui32SETCLRVal = (i % 2) ? MSPI_SIGNAL_IOM_BUFFER0 : MSPI_SIGNAL_IOM_BUFFER1;
-#endif
-        gMspiSequence.block[i].ui32DMATARGADDRVal = (i % 2) ? (uint32_t)&g_TempBuf[0] : (uint32_t)&g_TempBuf[1];
-        gMspiSequence.block[i].ui32DMACFG2Val = _VAL2FLD(MSPI_DMACFG_DMAEN, 0);
+        //
+        // Only the head carries the address; all but the last hold CS.
+        //
+        ui32Cmd = build_iom_cmd(ui32SpiChipSelect, // ChipSelect
+                                ui32Dir,           // ui32Dir
+                                !bLast,            // ui32Cont
+                                i ? 0 : ui32Instr, // ui32Offset
+                                i ? 0 : ui32InstrLen, // ui32OffsetCnt
+                                ui32Bytes);        // ui32Bytes
+        iom_prog_block(&sProg, cq_long_buffer(i, numBlocks), (i == 0),
+                       (uint16_t)(ui32Instr >> 8), ui32Bytes, ui32Cmd);
     }
 
-    pMspiLong->tail.ui32PAUSEEN2Val = AM_HAL_MSPI_PAUSE_DEFAULT;
-    pMspiLong->head.ui32PAUSEEN2Val = AM_HAL_MSPI_PAUSE_DEFAULT;
-#if 0
-    // Normal Memory
-    // Set default values - these may be updated later
-    pMspiLong->tail.ui32PAUSEENVal = AM_HAL_MSPI_CQP_PAUSE_DEFAULT;
-    pMspiLong->tail.ui32SETCLRVal = 0;
-#else
-    // This is the Pause Boundary for HiPrio transactions
-    pMspiLong->tail.ui32PAUSEENVal = AM_HAL_MSPI_CQP_PAUSE_DEFAULT | ((MAX_INT_BLOCKS % 2) ? MSPI_WAIT_FOR_IOM_BUFFER0 : MSPI_WAIT_FOR_IOM_BUFFER1);
-    pMspiLong->tail.ui32SETCLRVal = (MAX_INT_BLOCKS % 2) ? MSPI_SIGNAL_IOM_BUFFER0 : MSPI_SIGNAL_IOM_BUFFER1;
-#endif
+    // Jump back to the original CQ - patched by the HAL
+    gpIomProgExit = am_hal_cmdq_prog_exit(&sProg);
+
+    return am_hal_cmdq_prog_end(&sProg, NULL);
 }
 
+// MSPI
 // Initialize for each type of transacation
 void mspi_setup_cq_long(uint32_t ui32Module, uint8_t ui8Priority, am_hal_mspi_dir_e eDirection, uint32_t blockSize)
 {
-    am_hal_mspi_long_txn_t *pMspiLong = &gMspiLongTxn;
-    uint32_t ui32DmaCfg =
+    (void)blockSize;
+    gMspiLongCfg.ui32Module = ui32Module;
+    gMspiLongCfg.ui32DmaCfg =
         _VAL2FLD(MSPI_DMACFG_DMAPWROFF, 0)   |  // DMA Auto Power-off not supported!
         _VAL2FLD(MSPI_DMACFG_DMAPRI, ui8Priority)    |
         _VAL2FLD(MSPI_DMACFG_DMADIR, eDirection)     |
         _VAL2FLD(MSPI_DMACFG_DMAEN, 3);
+}
 
-    pMspiLong->head.ui32DMATOTCOUNTVal = blockSize;
-    pMspiLong->head.ui32DMACFG1Val     = pMspiLong->tail.ui32DMACFG1Val = ui32DmaCfg;
+//
+// One MSPI block: wait for IOM to release the buffer, fill it from flash,
+// hand it to IOM.
+//
+static void
+mspi_prog_block(am_hal_cmdq_prog_t *pProg, uint32_t ui32Buf,
+                uint32_t ui32DevAddr, uint32_t ui32NumBytes)
+{
+    MSPI_Type *pMspi = MSPIn(gMspiLongCfg.ui32Module);
 
-    // Initialize the sequence blocks
-    for (uint32_t i = 0; i < MAX_INT_BLOCKS; i++)
-    {
-        gMspiSequence.block[i].ui32DMACFG1Val = ui32DmaCfg;
-        gMspiSequence.block[i].ui32DMATOTCOUNTVal = blockSize;
-    }
+    // This is the Pause Boundary for HiPrio transactions
+    am_hal_cmdq_prog_wait(pProg, AM_HAL_MSPI_PAUSE_FLAG_CQ |
+                          (ui32Buf ? MSPI_WAIT_FOR_IOM_BUFFER1 : MSPI_WAIT_FOR_IOM_BUFFER0));
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pMspi->DMATARGADDR, (uint32_t)&g_TempBuf[ui32Buf]);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pMspi->DMADEVADDR, ui32DevAddr);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pMspi->DMATOTCOUNT, ui32NumBytes);
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pMspi->DMACFG, gMspiLongCfg.ui32DmaCfg);
+    // Need to disable the DMA to prepare for next reconfig
+    // Need to have this following the DMAEN for CMDQ
+    am_hal_cmdq_prog_write(pProg, (uint32_t)&pMspi->DMACFG, _VAL2FLD(MSPI_DMACFG_DMAEN, 0));
+    am_hal_cmdq_prog_signal(pProg, ui32Buf ? MSPI_SIGNAL_IOM_BUFFER1 : MSPI_SIGNAL_IOM_BUFFER0);
 }
 
-static void
+static uint32_t
 create_mspi_iom_write_transaction(uint32_t blockSize,
                                 am_hal_mspi_dir_e eDirection,
                                 uint32_t ui32DevAddr,
                                 uint32_t ui32NumBytes)
 {
-    am_hal_mspi_long_txn_t *pMspiLong = &gMspiLongTxn;
+    am_hal_cmdq_prog_t sProg;
     uint32_t numBlocks = (ui32NumBytes + blockSize - 1) / blockSize;
+    uint32_t ui32Status;
 
-    pMspiLong->head.ui32DMADEVADDRVal = ui32DevAddr;
-    // jmp: ui32CQAddrVal
-    if (numBlocks > 1)
-    {
-        if (numBlocks > 2)
-        {
-            // Identify where in the block array to jump to
-            gMspiLongTxn.jmp.ui32CQAddrVal = (uint32_t)&gMspiSequence.block[MAX_INT_BLOCKS - (numBlocks - 2)];
-            for (uint32_t i = 0; i < (numBlocks - 2); i++)
-            {
-                gMspiSequence.block[MAX_INT_BLOCKS - (numBlocks - 2) + i].ui32DMADEVADDRVal = ui32DevAddr + (i + 1) * blockSize;
-            }
-        }
-        else
-        {
-            // Just jump to tail
-            gMspiLongTxn.jmp.ui32CQAddrVal = (uint32_t)&gMspiLongTxn.tail;
-        }
-        ui32NumBytes -= blockSize*(numBlocks - 1);
-        // tail: ui32HdrCMDVal & ui32DMATOTCOUNTVal
-        // Initialize the count & command for tail
-        gMspiLongTxn.tail.ui32DMADEVADDRVal = ui32DevAddr + (numBlocks-1)*blockSize;
-        gMspiLongTxn.tail.ui32DMATOTCOUNTVal  = ui32NumBytes;
-    }
-    else
+    (void)eDirection;
+    ui32Status = am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_MSPI,
+                                       gMspiProg, MSPI_PROG_ENTRIES);
+    if (ui32Status)
     {
-        // Just jump to end
-        gMspiLongTxn.jmp.ui32CQAddrVal = (uint32_t)&gMspiLongTxn.jmpOut;
+        return ui32Status;
     }
 
-    // Initialize head - based on how many blocks
-    if ((MAX_INT_BLOCKS + 2 - numBlocks) % 2)
+    for (uint32_t i = 0; i < numBlocks; i++)
     {
-        gMspiLongTxn.head.ui32DMATARGADDRVal = (uint32_t)&g_TempBuf[1];
-        // This is the Pause Boundary for HiPrio transactions
-        gMspiLongTxn.head.ui32PAUSEENVal = AM_HAL_MSPI_CQP_PAUSE_DEFAULT | MSPI_WAIT_FOR_IOM_BUFFER1;
-        gMspiLongTxn.head.ui32SETCLRVal = MSPI_SIGNAL_IOM_BUFFER1;
-    }
-    else
-    {
-        gMspiLongTxn.head.ui32DMATARGADDRVal = (uint32_t)&g_TempBuf[0];
-        // This is the Pause Boundary for HiPrio transactions
-        gMspiLongTxn.head.ui32PAUSEENVal = AM_HAL_MSPI_CQP_PAUSE_DEFAULT | MSPI_WAIT_FOR_IOM_BUFFER0;
-        gMspiLongTxn.head.ui32SETCLRVal = MSPI_SIGNAL_IOM_BUFFER0;
+        uint32_t ui32Bytes = (i == (numBlocks - 1)) ? (ui32NumBytes - blockSize * i) : blockSize;
+
+        mspi_prog_block(&sProg, cq_long_buffer(i, numBlocks),
+                        ui32DevAddr + i * blockSize, ui32Bytes);
     }
+
+    // Jump back to the original CQ - patched by the HAL
+    gpMspiProgExit = am_hal_cmdq_prog_exit(&sProg);
+
+    return am_hal_cmdq_prog_end(&sProg, NULL);
 }
 
 #endif
@@ -1453,9 +1126,7 @@ init_mspi_iom_xfer(void)
         return ui32Status;
     }
 #ifdef CQ_RAW
-    iom_init_cq_long(FRAM_IOM_MODULE);
     iom_setup_cq_long(FRAM_IOM_MODULE, 1, AM_HAL_IOM_TX, SPI_TXN_SIZE, g_FramChipSelect[FRAM_IOM_MODULE], 0);
-    mspi_init_cq_long(0);
     mspi_setup_cq_long(0, 1, AM_HAL_MSPI_RX, SPI_TXN_SIZE);
 #endif
     return ui32Status;
@@ -1520,12 +1191,17 @@ start_mspi_iom_xfer(void)
         // Queue up the CQ Raw
         am_hal_cmdq_entry_t jump;
         // MSPI
-        create_mspi_iom_write_transaction(SPI_TXN_SIZE,
+        ui32Status = create_mspi_iom_write_transaction(SPI_TXN_SIZE,
                                         AM_HAL_MSPI_RX,
                                         VARIABLE_SIZE_CHANGE*numIter,
                                         BLOCK_SIZE - VARIABLE_SIZE_CHANGE*numIter);
+        if (ui32Status)
+        {
+            DEBUG_PRINT("\nFailed to build MSPI CQ program\n");
+            while(1);
+        }
         jump.address = (uint32_t)&MSPIn(0)->CQADDR;
-        jump.value = (uint32_t)&gMspiLongTxn;
+        jump.value = (uint32_t)gMspiProg;
 
         am_hal_mspi_cq_raw_t rawMspiCfg;
         rawMspiCfg.ui32PauseCondition = MSPI_WAIT_FOR_IOM_BUFFER0;
@@ -1534,7 +1210,7 @@ start_mspi_iom_xfer(void)
         rawMspiCfg.numEntries = sizeof(am_hal_cmdq_entry_t) / 8;
         rawMspiCfg.pfnCallback = mspiCb;
         rawMspiCfg.pCallbackCtxt = 0;
-        rawMspiCfg.pJmpAddr = &gMspiLongTxn.jmpOut.ui32CQAddrVal;
+        rawMspiCfg.pJmpAddr = gpMspiProgExit;
         ui32Status = am_hal_mspi_control(g_MSPIHdl, AM_HAL_MSPI_REQ_CQ_RAW, &rawMspiCfg);
         if (ui32Status)
         {
@@ -1542,12 +1218,17 @@ start_mspi_iom_xfer(void)
             while(1);
         }
         // IOM
-        create_iom_mspi_read_transaction(SPI_TXN_SIZE,
+        ui32Status = create_iom_mspi_read_transaction(SPI_TXN_SIZE,
                                         AM_HAL_IOM_TX,
                                         BLOCK_SIZE - VARIABLE_SIZE_CHANGE*numIter,
                                         0, // address
                                         3, // TODO Address size - dependent on FRAM device - should be abstracted out in fram_device_func_t
                                         g_FramChipSelect[FRAM_IOM_MODULE]);
+        if (ui32Status)
+        {
+            DEBUG_PRINT("\nFailed to build IOM CQ program\n");
+            while(1);
+        }
         DEBUG_GPIO_HIGH(TEST_GPIO1);
         // Configure FRAM for writing
         ui32Status = fram_func.fram_nonblocking_write_adv(NULL, 0, 0,
@@ -1563,7 +1244,7 @@ start_mspi_iom_xfer(void)
         DEBUG_GPIO_LOW(TEST_GPIO1);
         // Queue up the CQ Raw
         jump.address = (uint32_t)&IOMn(FRAM_IOM_MODULE)->CQADDR;
-        jump.value = (uint32_t)&gIomLongTxn;
+        jump.value = (uint32_t)gIomProg;
 
         am_hal_iom_cq_raw_t rawIomCfg;
         rawIomCfg.ui32PauseCondition = IOM_WAIT_FOR_MSPI_BUFFER0;
@@ -1572,7 +1253,7 @@ start_mspi_iom_xfer(void)
         rawIomCfg.numEntries = sizeof(am_hal_cmdq_entry_t) / 8;
         rawIomCfg.pfnCallback = iomCb;
         rawIomCfg.pCallbackCtxt = 0;
-        rawIomCfg.pJmpAddr = &gIomLongTxn.jmpOut.ui32CQAddrVal;
+        rawIomCfg.pJmpAddr = gpIomProgExit;
         ui32Status = am_hal_iom_control(g_IOMHandle, AM_HAL_IOM_REQ_CQ_RAW, &rawIomCfg);
         if (ui32Status)
         {
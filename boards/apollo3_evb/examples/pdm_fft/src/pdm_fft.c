@@ -7,6 +7,10 @@
 //! Purpose: This example enables the PDM interface to record audio signals from an
 //! external microphone. The required pin connections are:
 //!
+//! Each spectrum is computed in a burst mode governor compute region, so the
+//! analysis runs at 96 MHz on parts that support burst mode and the core is
+//! back at 48 MHz while it sleeps between frames.
+//!
 //! Printing takes place over the ITM at 1M Baud.
 //!
 //! GPIO 10 - PDM DATA
@@ -58,6 +62,8 @@
 #include "am_mcu_apollo.h"
 #include "am_bsp.h"
 #include "am_util.h"
+#include "am_util_burst_governor.h"
+#include "spectrum.h"
 
 //*****************************************************************************
 //
@@ -66,6 +72,7 @@
 //*****************************************************************************
 #define PDM_FFT_SIZE                4096
 #define PDM_FFT_BYTES               (PDM_FFT_SIZE * 2)
+#define PDM_FRAME_COUNT             2
 #define PRINT_PDM_DATA              0
 #define PRINT_FFT_DATA              0
 
@@ -74,13 +81,50 @@
 // Global variables.
 //
 //*****************************************************************************
-volatile bool g_bPDMDataReady = false;
-uint32_t g_ui32PDMDataBuffer[PDM_FFT_SIZE];
-float g_fPDMTimeDomain[PDM_FFT_SIZE * 2];
-float g_fPDMFrequencyDomain[PDM_FFT_SIZE * 2];
-float g_fPDMMagnitudes[PDM_FFT_SIZE * 2];
+uint32_t g_ui32PDMDataBuffer[PDM_FRAME_COUNT * PDM_FFT_BYTES / 4];
 uint32_t g_ui32SampleFreq;
 
+//*****************************************************************************
+//
+// Spectrum analysis state. Windows of PDM_FFT_SIZE samples overlap by half,
+// so a new spectrum is produced every PDM_FFT_SIZE / 2 samples.
+//
+//*****************************************************************************
+spectrum_t g_sSpectrum;
+float g_fSpectrumWork[SPECTRUM_WORK_FLOATS(PDM_FFT_SIZE)];
+int16_t g_i16SpectrumHistory[SPECTRUM_HISTORY_SAMPLES(PDM_FFT_SIZE)];
+
+//
+// The PDM settings below give a 46875 Hz sample rate, so the top band stops
+// at the 23437 Hz Nyquist frequency.
+//
+const spectrum_band_t g_sSpectrumBands[] =
+{
+    {    0,   500 },
+    {  500,  2000 },
+    { 2000,  8000 },
+    { 8000, 23437 },
+};
+
+#define SPECTRUM_NUM_BANDS  (sizeof(g_sSpectrumBands) / sizeof(g_sSpectrumBands[0]))
+
+float g_fSpectrumBandEnergy[SPECTRUM_NUM_BANDS];
+
+//*****************************************************************************
+//
+// Burst mode governor.  Only compute regions switch burst mode here, so the
+// load thresholds are unused.
+//
+//*****************************************************************************
+const am_util_burst_governor_config_t g_sBurstConfig =
+{
+    .pfnTimeGet = am_hal_stimer_counter_get,
+    .ui32LoadHighPct = 90,
+    .ui32LoadLowPct = 50,
+    .ui32QueueHigh = 0,
+    .ui32DwellTicks = 0,
+};
+
 //*****************************************************************************
 //
 // PDM configuration information.
@@ -210,26 +254,23 @@ pdm_config_print(void)
 
 //*****************************************************************************
 //
-// Start a transaction to get some number of bytes from the PDM interface.
+// Start continuous capture into a ring of FFT-sized frames.
 //
 //*****************************************************************************
 void
 pdm_data_get(void)
 {
-    //
-    // Configure DMA and target address.
-    //
-    am_hal_pdm_transfer_t sTransfer;
-    sTransfer.ui32TargetAddr = (uint32_t ) g_ui32PDMDataBuffer;
-    sTransfer.ui32TotalCount = PDM_FFT_BYTES;
+    am_hal_pdm_stream_config_t sStream;
+    sStream.pui32Buffer = g_ui32PDMDataBuffer;
+    sStream.ui32FrameBytes = PDM_FFT_BYTES;
+    sStream.ui32NumFrames = PDM_FRAME_COUNT;
 
     //
     // Start the data transfer.
     //
     am_hal_pdm_enable(PDMHandle);
     am_util_delay_ms(100);
-    am_hal_pdm_fifo_flush(PDMHandle);
-    am_hal_pdm_dma_start(PDMHandle, &sTransfer);
+    am_hal_pdm_stream_start(PDMHandle, &sStream);
 }
 
 //*****************************************************************************
@@ -249,84 +290,112 @@ am_pdm0_isr(void)
     am_hal_pdm_interrupt_clear(PDMHandle, ui32Status);
 
     //
-    // Once our DMA transaction completes, we will disable the PDM and send a
-    // flag back down to the main routine. Disabling the PDM is only necessary
-    // because this example only implemented a single buffer for storing FFT
-    // data. More complex programs could use a system of multiple buffers to
-    // allow the CPU to run the FFT in one buffer while the DMA pulls PCM data
-    // into another buffer.
+    // Each completed DMA publishes a frame to the main routine and restarts
+    // the DMA on the next free frame, so capture never stops while the CPU
+    // runs the FFT.
     //
-    if (ui32Status & AM_HAL_PDM_INT_DCMP)
-    {
-        am_hal_pdm_disable(PDMHandle);
-        g_bPDMDataReady = true;
-    }
+    am_hal_pdm_stream_service(PDMHandle, ui32Status);
 }
 
 //*****************************************************************************
 //
-// Analyze and print frequency data.
+// Print the results of one spectrum window.
 //
 //*****************************************************************************
 void
-pcm_fft_print(void)
+pcm_fft_print(const spectrum_result_t *psResult, void *pvContext)
 {
-    float fMaxValue;
-    uint32_t ui32MaxIndex;
-    int16_t *pi16PDMData = (int16_t *) g_ui32PDMDataBuffer;
-    uint32_t ui32LoudestFrequency;
-
-    //
-    // Convert the PDM samples to floats, and arrange them in the format
-    // required by the FFT function.
-    //
-    for (uint32_t i = 0; i < PDM_FFT_SIZE; i++)
+    if (PRINT_FFT_DATA)
     {
-        if (PRINT_PDM_DATA)
+        for (uint32_t i = 0; i < SPECTRUM_NUM_BINS(PDM_FFT_SIZE); i++)
         {
-            am_util_stdio_printf("%d\n", pi16PDMData[i]);
+            am_util_stdio_printf("%f\n", psResult->pfPower[i]);
         }
 
-        g_fPDMTimeDomain[2 * i] = pi16PDMData[i] / 1.0;
-        g_fPDMTimeDomain[2 * i + 1] = 0.0;
+        am_util_stdio_printf("END\n");
+        am_util_stdio_printf("Loudest frequency bin: %d\n", psResult->ui32PeakBin);
+
+        for (uint32_t i = 0; i < SPECTRUM_NUM_BANDS; i++)
+        {
+            am_util_stdio_printf("Band %d-%d Hz: %f\n",
+                                 g_sSpectrumBands[i].ui32LowHz,
+                                 g_sSpectrumBands[i].ui32HighHz,
+                                 psResult->pfBandEnergy[i]);
+        }
     }
 
-    if (PRINT_PDM_DATA)
+    am_util_stdio_printf("Loudest frequency: %d         \r", psResult->ui32PeakHz);
+}
+
+//*****************************************************************************
+//
+// Set up the spectrum analyzer.
+//
+//*****************************************************************************
+void
+pcm_fft_init(void)
+{
+    spectrum_config_t sConfig =
     {
-        am_util_stdio_printf("END\n");
+        .ui32FFTSize = PDM_FFT_SIZE,
+        .ui32SampleRate = g_ui32SampleFreq,
+        .psBands = g_sSpectrumBands,
+        .ui32NumBands = SPECTRUM_NUM_BANDS,
+        .pfBandEnergy = g_fSpectrumBandEnergy,
+        .pfWork = g_fSpectrumWork,
+        .pi16History = g_i16SpectrumHistory,
+        .pfnCallback = pcm_fft_print,
+        .pvContext = NULL,
+    };
+
+    if (!spectrum_init(&g_sSpectrum, &sConfig))
+    {
+        am_util_stdio_printf("Spectrum configuration rejected.\n");
+        while (1);
     }
+}
 
-    //
-    // Perform the FFT.
-    //
-    arm_cfft_radix4_instance_f32 S;
-    arm_cfft_radix4_init_f32(&S, PDM_FFT_SIZE, 0, 1);
-    arm_cfft_radix4_f32(&S, g_fPDMTimeDomain);
-    arm_cmplx_mag_f32(g_fPDMTimeDomain, g_fPDMMagnitudes, PDM_FFT_SIZE);
+//*****************************************************************************
+//
+// Start the STIMER time base and the burst mode governor.
+//
+//*****************************************************************************
+void
+burst_governor_init(void)
+{
+    am_hal_stimer_config(AM_HAL_STIMER_CFG_CLEAR | AM_HAL_STIMER_CFG_FREEZE);
+    am_hal_stimer_config(AM_HAL_STIMER_XTAL_32KHZ);
 
-    if (PRINT_FFT_DATA)
+    if (am_util_burst_governor_init(&g_sBurstConfig) != AM_HAL_STATUS_SUCCESS)
     {
-        for (uint32_t i = 0; i < PDM_FFT_SIZE / 2; i++)
+        am_util_stdio_printf("Burst mode not available, running at 48 MHz.\n\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Analyze a frame of PCM data.
+//
+//*****************************************************************************
+void
+pcm_fft_process(int16_t *pi16PDMData)
+{
+    if (PRINT_PDM_DATA)
+    {
+        for (uint32_t i = 0; i < PDM_FFT_SIZE; i++)
         {
-            am_util_stdio_printf("%f\n", g_fPDMMagnitudes[i]);
+            am_util_stdio_printf("%d\n", pi16PDMData[i]);
         }
 
         am_util_stdio_printf("END\n");
     }
 
     //
-    // Find the frequency bin with the largest magnitude.
+    // Region calls fail harmlessly if burst mode is not available.
     //
-    arm_max_f32(g_fPDMMagnitudes, PDM_FFT_SIZE / 2, &fMaxValue, &ui32MaxIndex);
-
-    ui32LoudestFrequency = (g_ui32SampleFreq * ui32MaxIndex) / PDM_FFT_SIZE;
-
-    if (PRINT_FFT_DATA)
-    {
-        am_util_stdio_printf("Loudest frequency bin: %d\n", ui32MaxIndex);
-    }
-
-    am_util_stdio_printf("Loudest frequency: %d         \r", ui32LoudestFrequency);
+    am_util_burst_governor_region_enter();
+    spectrum_feed(&g_sSpectrum, pi16PDMData, PDM_FFT_SIZE);
+    am_util_burst_governor_region_exit();
 }
 
 //*****************************************************************************
@@ -359,11 +428,12 @@ main(void)
 
     //
     // Turn on the PDM, set it up for our chosen recording settings, and start
-    // the first DMA transaction.
+    // capturing.
     //
     pdm_init();
     pdm_config_print();
-    am_hal_pdm_fifo_flush(PDMHandle);
+    pcm_fft_init();
+    burst_governor_init();
     pdm_data_get();
 
     //
@@ -371,20 +441,27 @@ main(void)
     //
     while (1)
     {
+        void *pvFrame;
+
         am_hal_interrupt_master_disable();
 
-        if (g_bPDMDataReady)
+        if (am_hal_pdm_stream_frame_get(PDMHandle, &pvFrame) == AM_HAL_STATUS_SUCCESS)
         {
-            g_bPDMDataReady = false;
+            //
+            // Keep interrupts on so the PDM DMA can move on to the next frame
+            // while this one is analyzed.
+            //
+            am_hal_interrupt_master_enable();
 
-            pcm_fft_print();
+            pcm_fft_process((int16_t *) pvFrame);
 
             while (PRINT_PDM_DATA || PRINT_FFT_DATA);
 
             //
-            // Start converting the next set of PCM samples.
+            // Hand the frame back to the PDM.
             //
-            pdm_data_get();
+            am_hal_pdm_stream_frame_release(PDMHandle);
+            continue;
         }
 
         //
@@ -0,0 +1,253 @@
+//*****************************************************************************
+//
+//! @file spectrum.c
+//!
+//! @brief Streaming real-FFT spectrum analysis.
+//!
+//!
+//! Accepts PCM samples in arbitrary chunks and analyzes Hann windowed blocks
+//! with 50% overlap using the CMSIS-DSP real FFT. Each window produces a power
+//! spectrum, the peak bin and optional band energies. The module has no
+//! hardware dependencies beyond CMSIS-DSP.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <string.h>
+#include "spectrum.h"
+
+//*****************************************************************************
+//
+// Analyze the current window.
+//
+//*****************************************************************************
+static void
+spectrum_window_process(spectrum_t *psSpectrum)
+{
+    spectrum_config_t *psConfig = &psSpectrum->sConfig;
+    uint32_t ui32N = psConfig->ui32FFTSize;
+    uint32_t ui32Half = ui32N / 2;
+    int16_t *pi16History = psConfig->pi16History;
+    float *pfIn = psSpectrum->pfIn;
+    float *pfOut = psSpectrum->pfOut;
+    float *pfPower;
+    spectrum_result_t sResult;
+
+    //
+    // Apply the window. Only w[0..N/2] is stored since w[N - i] == w[i].
+    //
+    for (uint32_t i = 0; i < ui32Half; i++)
+    {
+        pfIn[i] = (float) pi16History[i] * psSpectrum->pfWindow[i];
+    }
+    for (uint32_t i = ui32Half; i < ui32N; i++)
+    {
+        pfIn[i] = (float) pi16History[i] * psSpectrum->pfWindow[ui32N - i];
+    }
+
+    arm_rfft_fast_f32(&psSpectrum->sFFT, pfIn, pfOut, 0);
+
+    //
+    // Convert to power in place of the (now consumed) input buffer. The FFT
+    // packs the real Nyquist term next to the DC term.
+    //
+    pfPower = pfIn;
+    pfPower[0] = pfOut[0] * pfOut[0];
+    pfPower[ui32Half] = pfOut[1] * pfOut[1];
+    arm_cmplx_mag_squared_f32(&pfOut[2], &pfPower[1], ui32Half - 1);
+
+    //
+    // Find the loudest bin, ignoring DC.
+    //
+    arm_max_f32(&pfPower[1], ui32Half, &sResult.fPeakPower, &sResult.ui32PeakBin);
+    sResult.ui32PeakBin += 1;
+    sResult.ui32PeakHz = (uint32_t) (((uint64_t) sResult.ui32PeakBin * psConfig->ui32SampleRate) / ui32N);
+
+    //
+    // Integrate the requested bands.
+    //
+    for (uint32_t b = 0; b < psConfig->ui32NumBands; b++)
+    {
+        uint32_t ui32Low = (uint32_t) (((uint64_t) psConfig->psBands[b].ui32LowHz * ui32N +
+                                        psConfig->ui32SampleRate - 1) / psConfig->ui32SampleRate);
+        uint32_t ui32High = (uint32_t) (((uint64_t) psConfig->psBands[b].ui32HighHz * ui32N +
+                                         psConfig->ui32SampleRate - 1) / psConfig->ui32SampleRate);
+        float fEnergy = 0.0f;
+
+        if (ui32High > ui32Half + 1)
+        {
+            ui32High = ui32Half + 1;
+        }
+
+        for (uint32_t k = ui32Low; k < ui32High; k++)
+        {
+            fEnergy += pfPower[k];
+        }
+
+        psConfig->pfBandEnergy[b] = fEnergy;
+    }
+
+    sResult.pfPower = pfPower;
+    sResult.pfBandEnergy = psConfig->pfBandEnergy;
+
+    if (psConfig->pfnCallback)
+    {
+        psConfig->pfnCallback(&sResult, psConfig->pvContext);
+    }
+}
+
+//*****************************************************************************
+//
+// Initialize an analyzer.
+//
+// Returns false if the configuration is not usable, including a band that is
+// empty or extends past half the sample rate.
+//
+//*****************************************************************************
+bool
+spectrum_init(spectrum_t *psSpectrum, const spectrum_config_t *psConfig)
+{
+    uint32_t ui32N;
+
+    if (!psSpectrum || !psConfig || !psConfig->pfWork || !psConfig->pi16History ||
+        (psConfig->ui32SampleRate == 0) ||
+        (psConfig->ui32NumBands && (!psConfig->psBands || !psConfig->pfBandEnergy)))
+    {
+        return false;
+    }
+
+    //
+    // Bands must be non-empty and end at or below the Nyquist frequency.
+    //
+    for (uint32_t b = 0; b < psConfig->ui32NumBands; b++)
+    {
+        if ((psConfig->psBands[b].ui32LowHz >= psConfig->psBands[b].ui32HighHz) ||
+            ((uint64_t) psConfig->psBands[b].ui32HighHz * 2 > psConfig->ui32SampleRate))
+        {
+            return false;
+        }
+    }
+
+    ui32N = psConfig->ui32FFTSize;
+
+    if (arm_rfft_fast_init_f32(&psSpectrum->sFFT, ui32N) != ARM_MATH_SUCCESS)
+    {
+        return false;
+    }
+
+    psSpectrum->sConfig = *psConfig;
+
+    //
+    // Lay out the work area as the window half, FFT input and FFT output.
+    //
+    psSpectrum->pfWindow = psConfig->pfWork;
+    psSpectrum->pfIn = psSpectrum->pfWindow + ui32N / 2 + 1;
+    psSpectrum->pfOut = psSpectrum->pfIn + ui32N;
+
+    //
+    // Periodic Hann window, which sums to a constant at 50% overlap.
+    //
+    for (uint32_t i = 0; i <= ui32N / 2; i++)
+    {
+        psSpectrum->pfWindow[i] = 0.5f - 0.5f * arm_cos_f32(2.0f * PI * (float) i / (float) ui32N);
+    }
+
+    spectrum_reset(psSpectrum);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Discard any partially collected window.
+//
+//*****************************************************************************
+void
+spectrum_reset(spectrum_t *psSpectrum)
+{
+    psSpectrum->ui32Fill = 0;
+}
+
+//*****************************************************************************
+//
+// Add samples to the analyzer.
+//
+// A window is analyzed each time half a window of new samples has been
+// collected, once the first full window is available. Returns the number of
+// windows analyzed.
+//
+//*****************************************************************************
+uint32_t
+spectrum_feed(spectrum_t *psSpectrum, const int16_t *pi16Samples, uint32_t ui32NumSamples)
+{
+    uint32_t ui32N = psSpectrum->sConfig.ui32FFTSize;
+    uint32_t ui32Half = ui32N / 2;
+    int16_t *pi16History = psSpectrum->sConfig.pi16History;
+    uint32_t ui32Windows = 0;
+
+    while (ui32NumSamples)
+    {
+        uint32_t ui32Take = ui32N - psSpectrum->ui32Fill;
+
+        if (ui32Take > ui32NumSamples)
+        {
+            ui32Take = ui32NumSamples;
+        }
+
+        memcpy(&pi16History[psSpectrum->ui32Fill], pi16Samples, ui32Take * sizeof(int16_t));
+        psSpectrum->ui32Fill += ui32Take;
+        pi16Samples += ui32Take;
+        ui32NumSamples -= ui32Take;
+
+        if (psSpectrum->ui32Fill == ui32N)
+        {
+            spectrum_window_process(psSpectrum);
+            ui32Windows++;
+
+            //
+            // Keep the newer half as the start of the next window.
+            //
+            memcpy(pi16History, &pi16History[ui32Half], ui32Half * sizeof(int16_t));
+            psSpectrum->ui32Fill = ui32Half;
+        }
+    }
+
+    return ui32Windows;
+}
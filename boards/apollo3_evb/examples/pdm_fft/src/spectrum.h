@@ -0,0 +1,162 @@
+//*****************************************************************************
+//
+//! @file spectrum.h
+//!
+//! @brief Streaming real-FFT spectrum analysis.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef ARM_MATH_CM4
+#define ARM_MATH_CM4
+#endif
+#include <arm_math.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Macro definitions.
+//
+//*****************************************************************************
+//
+// Number of frequency bins produced for an FFT of n samples (DC to Nyquist).
+//
+#define SPECTRUM_NUM_BINS(n)            ((n) / 2 + 1)
+
+//
+// Caller supplied storage, in elements, for an FFT of n samples.
+//
+#define SPECTRUM_WORK_FLOATS(n)         ((n) / 2 + 1 + 2 * (n))
+#define SPECTRUM_HISTORY_SAMPLES(n)     (n)
+
+//*****************************************************************************
+//
+// Type definitions.
+//
+//*****************************************************************************
+//
+// Frequency band, from ui32LowHz up to but not including ui32HighHz.
+// ui32HighHz may not exceed half the sample rate.
+//
+typedef struct
+{
+    uint32_t ui32LowHz;
+    uint32_t ui32HighHz;
+}
+spectrum_band_t;
+
+//
+// Result of one analysis window. pfPower holds SPECTRUM_NUM_BINS() squared
+// magnitudes and is only valid during the callback.
+//
+typedef struct
+{
+    const float *pfPower;
+    const float *pfBandEnergy;
+    uint32_t ui32PeakBin;
+    uint32_t ui32PeakHz;
+    float fPeakPower;
+}
+spectrum_result_t;
+
+typedef void (*spectrum_callback_t)(const spectrum_result_t *psResult, void *pvContext);
+
+typedef struct
+{
+    // Window length. A power of 2 from 32 to 4096.
+    uint32_t ui32FFTSize;
+
+    // Sample rate of the PCM stream.
+    uint32_t ui32SampleRate;
+
+    // Optional bands to integrate. pfBandEnergy receives one value per band.
+    const spectrum_band_t *psBands;
+    uint32_t ui32NumBands;
+    float *pfBandEnergy;
+
+    // Storage of SPECTRUM_WORK_FLOATS() and SPECTRUM_HISTORY_SAMPLES().
+    float *pfWork;
+    int16_t *pi16History;
+
+    // Called once per analysis window.
+    spectrum_callback_t pfnCallback;
+    void *pvContext;
+}
+spectrum_config_t;
+
+//
+// Analyzer state. Treat as opaque.
+//
+typedef struct
+{
+    spectrum_config_t sConfig;
+    arm_rfft_fast_instance_f32 sFFT;
+    float *pfWindow;
+    float *pfIn;
+    float *pfOut;
+    uint32_t ui32Fill;
+}
+spectrum_t;
+
+//*****************************************************************************
+//
+// External function definitions.
+//
+//*****************************************************************************
+extern bool spectrum_init(spectrum_t *psSpectrum, const spectrum_config_t *psConfig);
+extern uint32_t spectrum_feed(spectrum_t *psSpectrum, const int16_t *pi16Samples,
+                              uint32_t ui32NumSamples);
+extern void spectrum_reset(spectrum_t *psSpectrum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPECTRUM_H
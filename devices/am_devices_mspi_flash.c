@@ -44,6 +44,7 @@
 //
 //*****************************************************************************
 
+#include <string.h>
 #include "am_mcu_apollo.h"
 #include "am_devices_mspi_flash.h"
 #include "am_util_stdio.h"
@@ -1870,7 +1871,7 @@ am_devices_mspi_flash_sector_erase(uint32_t ui32Module, uint32_t ui32SectorAddre
     //
     // Send the command sequence to do the sector erase.
     //
-    ui32Status = am_device_command_write(ui32Module, AM_DEVICES_MSPI_FLASH_SECTOR_ERASE, true, ui32SectorAddress, g_PIOBuffer, 0);
+    ui32Status = am_device_command_write(ui32Module, AM_DEVICES_MSPI_FLASH_SECTOR_ERASE_CMD, true, ui32SectorAddress, g_PIOBuffer, 0);
     if (AM_HAL_STATUS_SUCCESS != ui32Status)
     {
         return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
@@ -2071,3 +2072,789 @@ am_devices_mspi_flash_disable_xip(uint32_t ui32Module)
 }
 
 
+
+//*****************************************************************************
+//
+// Asynchronous program/erase engine.
+//
+// Jobs are queued by am_devices_mspi_flash_async_program() and
+// am_devices_mspi_flash_async_erase() and advanced by
+// am_devices_mspi_flash_async_service(), which never waits on the device. It
+// is meant to be called from a periodic timer or the idle loop. Reads can be
+// serviced while an operation is in progress by suspending it.
+//
+// The engine shares the MSPI with the blocking API, so the blocking write
+// and erase functions must not be used while jobs are pending.
+//
+//*****************************************************************************
+#if defined (ADESTO_ATXP032)
+#define FLASH_ASYNC_SUSPEND             AM_DEVICES_ATXP032_PE_SUSPEND
+#define FLASH_ASYNC_RESUME              AM_DEVICES_ATXP032_PE_RESUME
+#elif defined (MACRONIX_MX25U12835F)
+#define FLASH_ASYNC_SUSPEND             AM_DEVICES_MX25U12835F_PE_SUSPEND
+#define FLASH_ASYNC_RESUME              AM_DEVICES_MX25U12835F_PE_RESUME
+#else
+#define FLASH_ASYNC_SUSPEND             AM_DEVICES_MSPI_FLASH_PE_SUSPEND
+#define FLASH_ASYNC_RESUME              AM_DEVICES_MSPI_FLASH_PE_RESUME
+#endif
+
+typedef enum
+{
+    FLASH_ASYNC_IDLE,
+    FLASH_ASYNC_DMA,            // Page data is being sent to the device.
+    FLASH_ASYNC_BUSY,           // The device is programming or erasing.
+    FLASH_ASYNC_SUSPENDING,     // Suspend sent, waiting for it to take effect.
+    FLASH_ASYNC_SUSPENDED
+} flash_async_state_e;
+
+typedef struct
+{
+    uint32_t                            ui32Module;
+    am_devices_mspi_flash_async_job_t   *pJobs;
+    uint32_t                            ui32MaxJobs;
+
+    //
+    // Monotonic job indices. Jobs in [Head, Cursor) have been handed to the
+    // device, and jobs in [Cursor, Tail) are waiting. The first
+    // ui32CursorOffset bytes of the job at Cursor have also been handed over.
+    //
+    volatile uint32_t                   ui32Head;
+    volatile uint32_t                   ui32Cursor;
+    volatile uint32_t                   ui32Tail;
+    uint32_t                            ui32CursorOffset;
+
+    volatile flash_async_state_e        eState;
+    volatile bool                       bLocked;
+    volatile bool                       bHeld;
+    volatile bool                       bDMAComplete;
+    volatile uint32_t                   ui32DMAStatus;
+
+    //
+    // Device range affected by the operation in progress.
+    //
+    bool                                bOpErase;
+    bool                                bOpFailed;
+    uint32_t                            ui32OpAddress;
+    uint32_t                            ui32OpBytes;
+
+    uint32_t                            ui32Page[AM_DEVICES_MSPI_FLASH_PAGE_SIZE / 4];
+} flash_async_t;
+
+static flash_async_t g_FlashAsync;
+
+//*****************************************************************************
+//
+// Take ownership of the engine state. Fails if another context holds it.
+//
+//*****************************************************************************
+static bool
+flash_async_lock(void)
+{
+    bool bAcquired;
+
+    AM_CRITICAL_BEGIN
+    bAcquired = !g_FlashAsync.bLocked;
+    g_FlashAsync.bLocked = true;
+    AM_CRITICAL_END
+
+    return bAcquired;
+}
+
+static void
+flash_async_unlock(void)
+{
+    g_FlashAsync.bLocked = false;
+}
+
+static void
+flash_async_dma_callback(void *pCallbackCtxt, uint32_t status)
+{
+    g_FlashAsync.ui32DMAStatus = status;
+    g_FlashAsync.bDMAComplete = true;
+}
+
+//*****************************************************************************
+//
+// Read the write-in-progress state of the device.
+//
+//*****************************************************************************
+static uint32_t
+flash_async_wip(bool *pbBusy)
+{
+    uint32_t ui32Module = g_FlashAsync.ui32Module;
+    uint32_t ui32Data[2] = {0, 0};
+    uint32_t ui32Status;
+
+#if defined (ADESTO_ATXP032)
+    switch ( g_psMSPISettings.eDeviceConfig )
+    {
+        case AM_HAL_MSPI_FLASH_SERIAL_CE0:
+        case AM_HAL_MSPI_FLASH_SERIAL_CE1:
+            ui32Status = am_device_command_read(ui32Module, AM_DEVICES_MSPI_FLASH_READ_STATUS, false, 0, ui32Data, 2);
+            *pbBusy = (0 != (ui32Data[0] & AM_DEVICES_ATXP032_WIP));
+            break;
+        case AM_HAL_MSPI_FLASH_QUAD_CE0:
+        case AM_HAL_MSPI_FLASH_QUAD_CE1:
+            ui32Status = am_device_command_read(ui32Module, AM_DEVICES_MSPI_FLASH_READ_STATUS, false, 0, ui32Data, 4);
+            *pbBusy = (0 != ((ui32Data[0] >> 16) & AM_DEVICES_ATXP032_WIP));
+            break;
+        case AM_HAL_MSPI_FLASH_OCTAL_CE0:
+        case AM_HAL_MSPI_FLASH_OCTAL_CE1:
+            ui32Status = am_device_command_read(ui32Module, AM_DEVICES_MSPI_FLASH_READ_STATUS, false, 0, ui32Data, 6);
+            *pbBusy = (0 != (ui32Data[1] & AM_DEVICES_ATXP032_WIP));
+            break;
+        default:
+            return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+#else
+    ui32Status = am_device_command_read(ui32Module, AM_DEVICES_MSPI_FLASH_READ_STATUS, false, 0, ui32Data, 1);
+    if ((AM_HAL_MSPI_FLASH_QUADPAIRED == g_psMSPISettings.eDeviceConfig) ||
+        (AM_HAL_MSPI_FLASH_QUADPAIRED_SERIAL == g_psMSPISettings.eDeviceConfig))
+    {
+        *pbBusy = ((0 != (ui32Data[0] & AM_DEVICES_MSPI_FLASH_WIP)) ||
+                   (0 != ((ui32Data[0] >> 8) & AM_DEVICES_MSPI_FLASH_WIP)));
+    }
+    else
+    {
+        *pbBusy = (0 != (ui32Data[0] & AM_DEVICES_MSPI_FLASH_WIP));
+    }
+#endif
+
+    return (AM_HAL_STATUS_SUCCESS == ui32Status) ?
+           AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS : AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+}
+
+//*****************************************************************************
+//
+// Check the outcome of an operation once the device is no longer busy.
+//
+//*****************************************************************************
+static uint32_t
+flash_async_result(void)
+{
+#if defined (CYPRESS_S25FS064S)
+    uint32_t ui32EraseStatus = 0;
+
+    if (g_FlashAsync.bOpErase)
+    {
+        if ( (AM_HAL_STATUS_SUCCESS != am_device_command_write(g_FlashAsync.ui32Module, AM_DEVICES_MSPI_FLASH_EVAL_ERASE_STATUS,
+                                                               true, g_FlashAsync.ui32OpAddress, g_PIOBuffer, 0)) ||
+             (AM_HAL_STATUS_SUCCESS != am_device_command_read(g_FlashAsync.ui32Module, AM_DEVICES_MSPI_FLASH_READ_STATUS2,
+                                                              false, 0, &ui32EraseStatus, 1)) ||
+             (0 == (ui32EraseStatus & AM_DEVICES_MSPI_FLASH_ERASE_SUCCESS)) )
+        {
+            return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+        }
+    }
+#endif
+
+    return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Retire every job handed to the device by the operation that just ended.
+//
+// On failure the partially programmed job at the cursor is dropped as well.
+//
+//*****************************************************************************
+static void
+flash_async_finish(uint32_t ui32Status)
+{
+    am_devices_mspi_flash_async_job_t *pJob;
+
+    if ( (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != ui32Status) &&
+         (g_FlashAsync.ui32CursorOffset != 0) )
+    {
+        g_FlashAsync.ui32Cursor++;
+        g_FlashAsync.ui32CursorOffset = 0;
+    }
+
+    g_FlashAsync.eState = FLASH_ASYNC_IDLE;
+
+    while (g_FlashAsync.ui32Head != g_FlashAsync.ui32Cursor)
+    {
+        pJob = &g_FlashAsync.pJobs[g_FlashAsync.ui32Head % g_FlashAsync.ui32MaxJobs];
+        g_FlashAsync.ui32Head++;
+
+        if (pJob->pfnCallback)
+        {
+            pJob->pfnCallback(pJob->pCallbackCtxt, ui32Status);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Start the job at the cursor.
+//
+// Consecutive program jobs that continue where the previous one ended are
+// gathered into a single page program.
+//
+//*****************************************************************************
+static uint32_t
+flash_async_start(void)
+{
+    am_devices_mspi_flash_async_job_t *pJob;
+    am_hal_mspi_dma_transfer_t Transaction;
+    uint32_t ui32Module = g_FlashAsync.ui32Module;
+    uint32_t ui32Status;
+
+    pJob = &g_FlashAsync.pJobs[g_FlashAsync.ui32Cursor % g_FlashAsync.ui32MaxJobs];
+
+    ui32Status = am_device_command_write(ui32Module, AM_DEVICES_MSPI_FLASH_WRITE_ENABLE, false, 0, g_PIOBuffer, 0);
+    if (AM_HAL_STATUS_SUCCESS != ui32Status)
+    {
+        g_FlashAsync.ui32Cursor++;
+        g_FlashAsync.ui32CursorOffset = 0;
+        flash_async_finish(AM_DEVICES_MSPI_FLASH_STATUS_ERROR);
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    if (pJob->eOp == AM_DEVICES_MSPI_FLASH_ASYNC_ERASE)
+    {
+        g_FlashAsync.bOpErase = true;
+        g_FlashAsync.bOpFailed = false;
+        g_FlashAsync.ui32OpAddress = pJob->ui32Address & ~(AM_DEVICES_MSPI_FLASH_SECTOR_SIZE - 1);
+        g_FlashAsync.ui32OpBytes = AM_DEVICES_MSPI_FLASH_SECTOR_SIZE;
+        g_FlashAsync.ui32Cursor++;
+
+#if defined (ADESTO_ATXP032)
+        ui32Status = am_device_command_write(ui32Module, AM_DEVICES_ATXP032_UNPROTECT_SECTOR, true, pJob->ui32Address, g_PIOBuffer, 0);
+        if (AM_HAL_STATUS_SUCCESS == ui32Status)
+        {
+            ui32Status = am_device_command_write(ui32Module, AM_DEVICES_MSPI_FLASH_WRITE_ENABLE, false, 0, g_PIOBuffer, 0);
+        }
+        if (AM_HAL_STATUS_SUCCESS == ui32Status)
+#endif
+        {
+            ui32Status = am_device_command_write(ui32Module, AM_DEVICES_MSPI_FLASH_SECTOR_ERASE_CMD, true, pJob->ui32Address, g_PIOBuffer, 0);
+        }
+        if (AM_HAL_STATUS_SUCCESS != ui32Status)
+        {
+            flash_async_finish(AM_DEVICES_MSPI_FLASH_STATUS_ERROR);
+            return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+        }
+
+        g_FlashAsync.eState = FLASH_ASYNC_BUSY;
+        return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+    }
+
+    //
+    // Gather up to the end of the current device page.
+    //
+    uint8_t *pui8Page = (uint8_t *)g_FlashAsync.ui32Page;
+    uint32_t ui32Address = pJob->ui32Address + g_FlashAsync.ui32CursorOffset;
+    uint32_t ui32PageEnd = (ui32Address | (AM_DEVICES_MSPI_FLASH_PAGE_SIZE - 1)) + 1;
+    uint32_t ui32Count = 0;
+
+    while (1)
+    {
+        uint32_t ui32Take = pJob->ui32NumBytes - g_FlashAsync.ui32CursorOffset;
+
+        if (ui32Take > ui32PageEnd - (ui32Address + ui32Count))
+        {
+            ui32Take = ui32PageEnd - (ui32Address + ui32Count);
+        }
+
+        memcpy(pui8Page + ui32Count, pJob->pui8Buffer + g_FlashAsync.ui32CursorOffset, ui32Take);
+        ui32Count += ui32Take;
+        g_FlashAsync.ui32CursorOffset += ui32Take;
+
+        if (g_FlashAsync.ui32CursorOffset < pJob->ui32NumBytes)
+        {
+            break;
+        }
+
+        g_FlashAsync.ui32Cursor++;
+        g_FlashAsync.ui32CursorOffset = 0;
+
+        if ( (g_FlashAsync.ui32Cursor == g_FlashAsync.ui32Tail) ||
+             (ui32Address + ui32Count == ui32PageEnd) )
+        {
+            break;
+        }
+
+        pJob = &g_FlashAsync.pJobs[g_FlashAsync.ui32Cursor % g_FlashAsync.ui32MaxJobs];
+        if ( (pJob->eOp != AM_DEVICES_MSPI_FLASH_ASYNC_PROGRAM) ||
+             (pJob->ui32Address != ui32Address + ui32Count) )
+        {
+            break;
+        }
+    }
+
+    g_FlashAsync.bOpErase = false;
+    g_FlashAsync.bOpFailed = false;
+    g_FlashAsync.ui32OpAddress = ui32Address;
+    g_FlashAsync.ui32OpBytes = ui32Count;
+
+    Transaction.ui8Priority = 1;
+    Transaction.eDirection = AM_HAL_MSPI_TX;
+    Transaction.ui32TransferCount = ui32Count;
+    Transaction.ui32DeviceAddress = ui32Address;
+    Transaction.ui32SRAMAddress = (uint32_t)pui8Page;
+    Transaction.ui32PauseCondition = 0;
+    Transaction.ui32StatusSetClr = 0;
+
+    g_FlashAsync.bDMAComplete = false;
+    g_FlashAsync.eState = FLASH_ASYNC_DMA;
+
+    ui32Status = am_hal_mspi_nonblocking_transfer(g_pMSPIHandle, &Transaction, AM_HAL_MSPI_TRANS_DMA,
+                                                  flash_async_dma_callback, NULL);
+    if (AM_HAL_STATUS_SUCCESS != ui32Status)
+    {
+        flash_async_finish(AM_DEVICES_MSPI_FLASH_STATUS_ERROR);
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Advance the engine by one step without waiting on the device.
+//
+// While the engine is held, an operation found in progress is sent a suspend
+// and the engine moves to FLASH_ASYNC_SUSPENDED once the device reports it is
+// no longer busy. A release that arrives before the suspend has taken effect
+// is turned into a resume at that point, since the device ignores a resume
+// it receives while still suspending.
+//
+//*****************************************************************************
+static uint32_t
+flash_async_step(void)
+{
+    uint32_t ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+    uint32_t ui32Module = g_FlashAsync.ui32Module;
+    bool bBusy;
+
+    if (g_FlashAsync.eState == FLASH_ASYNC_DMA)
+    {
+        if (!g_FlashAsync.bDMAComplete)
+        {
+            return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+        }
+
+        //
+        // The device may have started programming whatever it received, so
+        // a failed transfer is still polled to completion before the jobs
+        // are failed and the next operation is started.
+        //
+        if (AM_HAL_STATUS_SUCCESS != g_FlashAsync.ui32DMAStatus)
+        {
+            g_FlashAsync.bOpFailed = true;
+            ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+        }
+        g_FlashAsync.eState = FLASH_ASYNC_BUSY;
+    }
+
+    if ( (g_FlashAsync.eState == FLASH_ASYNC_BUSY) ||
+         (g_FlashAsync.eState == FLASH_ASYNC_SUSPENDING) )
+    {
+        ui32Status = flash_async_wip(&bBusy);
+        if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != ui32Status)
+        {
+            flash_async_finish(ui32Status);
+        }
+        else if (bBusy)
+        {
+            if ( (g_FlashAsync.eState == FLASH_ASYNC_BUSY) && g_FlashAsync.bHeld )
+            {
+                if (AM_HAL_STATUS_SUCCESS != am_device_command_write(ui32Module, FLASH_ASYNC_SUSPEND,
+                                                                     false, 0, g_PIOBuffer, 0))
+                {
+                    ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+                }
+                else
+                {
+                    g_FlashAsync.eState = FLASH_ASYNC_SUSPENDING;
+                }
+            }
+        }
+        else if (g_FlashAsync.eState == FLASH_ASYNC_SUSPENDING)
+        {
+            //
+            // Suspended, or the operation finished first. Either way the
+            // resume sorts it out, as status polling follows it.
+            //
+            if (g_FlashAsync.bHeld)
+            {
+                g_FlashAsync.eState = FLASH_ASYNC_SUSPENDED;
+            }
+            else
+            {
+                if (AM_HAL_STATUS_SUCCESS != am_device_command_write(ui32Module, FLASH_ASYNC_RESUME,
+                                                                     false, 0, g_PIOBuffer, 0))
+                {
+                    ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+                }
+                g_FlashAsync.eState = FLASH_ASYNC_BUSY;
+            }
+        }
+        else
+        {
+            ui32Status = g_FlashAsync.bOpFailed ? AM_DEVICES_MSPI_FLASH_STATUS_ERROR : flash_async_result();
+            flash_async_finish(ui32Status);
+        }
+    }
+
+    if ( (g_FlashAsync.eState == FLASH_ASYNC_IDLE) && !g_FlashAsync.bHeld &&
+         (g_FlashAsync.ui32Cursor != g_FlashAsync.ui32Tail) )
+    {
+        ui32Status = flash_async_start();
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Initialize the asynchronous program/erase engine.
+//!
+//! @param ui32Module - MSPI module the flash is attached to.
+//! @param pJobs - Storage for queued jobs.
+//! @param ui32MaxJobs - Number of entries in pJobs.
+//!
+//! The flash must already be initialized with am_devices_mspi_flash_init().
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_init(uint32_t ui32Module,
+                                 am_devices_mspi_flash_async_job_t *pJobs,
+                                 uint32_t ui32MaxJobs)
+{
+    if ( (pJobs == NULL) || (ui32MaxJobs == 0) )
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    memset(&g_FlashAsync, 0, sizeof(g_FlashAsync));
+    g_FlashAsync.ui32Module = ui32Module;
+    g_FlashAsync.pJobs = pJobs;
+    g_FlashAsync.ui32MaxJobs = ui32MaxJobs;
+
+    return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Add a job to the queue and try to start it.
+//
+//*****************************************************************************
+static uint32_t
+flash_async_submit(am_devices_mspi_flash_async_op_e eOp,
+                   uint8_t *pui8Buffer, uint32_t ui32Address, uint32_t ui32NumBytes,
+                   am_devices_mspi_flash_async_callback_t pfnCallback,
+                   void *pCallbackCtxt)
+{
+    am_devices_mspi_flash_async_job_t *pJob;
+    uint32_t ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+
+    if (g_FlashAsync.pJobs == NULL)
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    AM_CRITICAL_BEGIN
+    if ( (g_FlashAsync.ui32Tail - g_FlashAsync.ui32Head) < g_FlashAsync.ui32MaxJobs )
+    {
+        pJob = &g_FlashAsync.pJobs[g_FlashAsync.ui32Tail % g_FlashAsync.ui32MaxJobs];
+        pJob->eOp = eOp;
+        pJob->pui8Buffer = pui8Buffer;
+        pJob->ui32Address = ui32Address;
+        pJob->ui32NumBytes = ui32NumBytes;
+        pJob->pfnCallback = pfnCallback;
+        pJob->pCallbackCtxt = pCallbackCtxt;
+        g_FlashAsync.ui32Tail++;
+    }
+    else
+    {
+        ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+    AM_CRITICAL_END
+
+    if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS == ui32Status)
+    {
+        //
+        // Failures past this point are reported through the job callback.
+        //
+        am_devices_mspi_flash_async_service();
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Queue a program operation.
+//!
+//! @param pui8TxBuffer - Data to program. Must stay valid until the callback.
+//! @param ui32WriteAddress - Destination address in the external flash.
+//! @param ui32NumBytes - Number of bytes to program.
+//! @param pfnCallback - Called with the outcome once the data is programmed.
+//! @param pCallbackCtxt - Context passed to pfnCallback.
+//!
+//! The data is programmed one device page at a time. Contiguous program jobs
+//! queued back to back share page programs.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_program(uint8_t *pui8TxBuffer,
+                                    uint32_t ui32WriteAddress,
+                                    uint32_t ui32NumBytes,
+                                    am_devices_mspi_flash_async_callback_t pfnCallback,
+                                    void *pCallbackCtxt)
+{
+    if ( (pui8TxBuffer == NULL) || (ui32NumBytes == 0) )
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    return flash_async_submit(AM_DEVICES_MSPI_FLASH_ASYNC_PROGRAM, pui8TxBuffer,
+                              ui32WriteAddress, ui32NumBytes, pfnCallback, pCallbackCtxt);
+}
+
+//*****************************************************************************
+//
+//! @brief Queue a sector erase operation.
+//!
+//! @param ui32SectorAddress - Any address within the sector to erase.
+//! @param pfnCallback - Called with the outcome once the sector is erased.
+//! @param pCallbackCtxt - Context passed to pfnCallback.
+//!
+//! Erases AM_DEVICES_MSPI_FLASH_SECTOR_SIZE bytes, the same unit as
+//! am_devices_mspi_flash_sector_erase().
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_erase(uint32_t ui32SectorAddress,
+                                  am_devices_mspi_flash_async_callback_t pfnCallback,
+                                  void *pCallbackCtxt)
+{
+    return flash_async_submit(AM_DEVICES_MSPI_FLASH_ASYNC_ERASE, NULL,
+                              ui32SectorAddress, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE,
+                              pfnCallback, pCallbackCtxt);
+}
+
+//*****************************************************************************
+//
+//! @brief Advance the asynchronous engine.
+//!
+//! Checks the progress of the operation in flight, completes finished jobs
+//! and starts the next one. Never waits on the device, so it is safe to call
+//! from a timer interrupt. Job callbacks are made from this function.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_service(void)
+{
+    uint32_t ui32Status;
+
+    if (g_FlashAsync.pJobs == NULL)
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    //
+    // Another context is already using the engine. It will pick up any new
+    // work, or the next service call will.
+    //
+    if (!flash_async_lock())
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+    }
+
+    ui32Status = flash_async_step();
+
+    flash_async_unlock();
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Check for outstanding jobs.
+//!
+//! @return true if any queued job has not yet completed.
+//
+//*****************************************************************************
+bool
+am_devices_mspi_flash_async_busy(void)
+{
+    return g_FlashAsync.ui32Head != g_FlashAsync.ui32Tail;
+}
+
+//*****************************************************************************
+//
+//! @brief Suspend the program or erase in progress.
+//!
+//! Holds the engine and, if an operation is in progress, sends the device a
+//! suspend. Never waits for the device: the suspend takes effect after a
+//! device specific latency (or, for a page program, once its data transfer
+//! ends) and is picked up by the next call to this function or to
+//! am_devices_mspi_flash_async_service().
+//!
+//! Once this function returns AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS the flash
+//! array can be read, directly or through XIP, except for the page or sector
+//! being modified. No new operation is started until
+//! am_devices_mspi_flash_async_resume() is called.
+//!
+//! Must not be called from an interrupt that can preempt
+//! am_devices_mspi_flash_async_service().
+//!
+//! @return AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS once suspended or idle,
+//! AM_DEVICES_MSPI_FLASH_STATUS_BUSY while the suspend is still taking
+//! effect (the engine stays held; call again or resume), otherwise
+//! AM_DEVICES_MSPI_FLASH_STATUS_ERROR.
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_suspend(void)
+{
+    uint32_t ui32Status;
+
+    if ( (g_FlashAsync.pJobs == NULL) || !flash_async_lock() )
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    g_FlashAsync.bHeld = true;
+
+    //
+    // Retire anything that has already finished and send the suspend.
+    //
+    flash_async_step();
+
+    switch (g_FlashAsync.eState)
+    {
+        case FLASH_ASYNC_IDLE:
+        case FLASH_ASYNC_SUSPENDED:
+            ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+            break;
+
+        case FLASH_ASYNC_DMA:
+        case FLASH_ASYNC_SUSPENDING:
+            ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_BUSY;
+            break;
+
+        default:
+            //
+            // The suspend command could not be sent.
+            //
+            g_FlashAsync.bHeld = false;
+            ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+            break;
+    }
+
+    flash_async_unlock();
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Resume after am_devices_mspi_flash_async_suspend().
+//!
+//! Also cancels a suspend that has not taken effect yet.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_resume(void)
+{
+    uint32_t ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS;
+
+    if ( (g_FlashAsync.pJobs == NULL) || !flash_async_lock() )
+    {
+        return AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    g_FlashAsync.bHeld = false;
+
+    if (g_FlashAsync.eState == FLASH_ASYNC_SUSPENDED)
+    {
+        if (AM_HAL_STATUS_SUCCESS != am_device_command_write(g_FlashAsync.ui32Module, FLASH_ASYNC_RESUME,
+                                                             false, 0, g_PIOBuffer, 0))
+        {
+            ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+        }
+
+        //
+        // Status polling resolves the outcome either way.
+        //
+        g_FlashAsync.eState = FLASH_ASYNC_BUSY;
+    }
+    else if (g_FlashAsync.eState == FLASH_ASYNC_IDLE)
+    {
+        //
+        // Start any work that was queued while the engine was held.
+        //
+        flash_async_step();
+    }
+
+    flash_async_unlock();
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Read from the external flash while jobs are pending.
+//!
+//! @param pui8RxBuffer - Buffer to store the data read.
+//! @param ui32ReadAddress - Address of the data in the external flash.
+//! @param ui32NumBytes - Number of bytes to read.
+//!
+//! Suspends the operation in progress for the duration of the read instead
+//! of waiting for it to finish. Reads of the page or sector being modified
+//! fail, since the device cannot return valid data for it. Queued jobs that
+//! have not started yet are not reflected in the data.
+//!
+//! Returns AM_DEVICES_MSPI_FLASH_STATUS_BUSY without reading if the suspend
+//! has not taken effect yet. The engine is left held so that a later call
+//! finds it suspended; call am_devices_mspi_flash_async_resume() instead to
+//! give up on the read.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_flash_async_read(uint8_t *pui8RxBuffer,
+                                 uint32_t ui32ReadAddress,
+                                 uint32_t ui32NumBytes)
+{
+    uint32_t ui32Status;
+
+    ui32Status = am_devices_mspi_flash_async_suspend();
+    if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != ui32Status)
+    {
+        return ui32Status;
+    }
+
+    if ( (g_FlashAsync.eState == FLASH_ASYNC_SUSPENDED) &&
+         (ui32ReadAddress < g_FlashAsync.ui32OpAddress + g_FlashAsync.ui32OpBytes) &&
+         (g_FlashAsync.ui32OpAddress < ui32ReadAddress + ui32NumBytes) )
+    {
+        ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+    else
+    {
+        ui32Status = am_devices_mspi_flash_read(pui8RxBuffer, ui32ReadAddress, ui32NumBytes, true);
+    }
+
+    if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != am_devices_mspi_flash_async_resume())
+    {
+        ui32Status = AM_DEVICES_MSPI_FLASH_STATUS_ERROR;
+    }
+
+    return ui32Status;
+}
@@ -71,6 +71,8 @@ extern "C"
 #define AM_DEVICES_MSPI_FLASH_WRITE_ENHVOL_CFG  0x61
 #define AM_DEVICES_MSPI_FLASH_RESET_ENABLE      0x66
 #define AM_DEVICES_MSPI_FLASH_QUAD_READ         0x6B
+#define AM_DEVICES_MSPI_FLASH_PE_SUSPEND        0x75
+#define AM_DEVICES_MSPI_FLASH_PE_RESUME         0x7A
 #define AM_DEVICES_MSPI_FLASH_WRITE_VOL_CFG     0x81
 #define AM_DEVICES_MSPI_FLASH_RESET_MEMORY      0x99
 #define AM_DEVICES_MSPI_FLASH_READ_ID           0x9F
@@ -134,6 +136,7 @@ extern "C"
 #define AM_DEVICES_MSPI_FLASH_SUBSECTOR_SIZE  0x1000   //4K bytes
 #define AM_DEVICES_MSPI_FLASH_SECTOR_SIZE     0x10000  //64K bytes
 #define AM_DEVICES_MSPI_FLASH_MAX_SECTORS     256      // Sectors within 3-byte address range.
+#define AM_DEVICES_MSPI_FLASH_SECTOR_ERASE_CMD  AM_DEVICES_MSPI_FLASH_SECTOR_ERASE    // Erases one AM_DEVICES_MSPI_FLASH_SECTOR_SIZE.
 #endif
 
 #if defined (CYPRESS_S25FS064S)
@@ -183,6 +186,7 @@ extern "C"
 #define AM_DEVICES_MSPI_FLASH_SUBSECTOR_SIZE  0x1000   //4K bytes
 #define AM_DEVICES_MSPI_FLASH_SECTOR_SIZE     0x10000  //64K bytes.
 #define AM_DEVICES_MSPI_FLASH_MAX_SECTORS     128      // Sectors within 3-byte address range.
+#define AM_DEVICES_MSPI_FLASH_SECTOR_ERASE_CMD  AM_DEVICES_MSPI_FLASH_SECTOR_ERASE    // Erases one AM_DEVICES_MSPI_FLASH_SECTOR_SIZE.
 #endif
 
 #if defined (MACRONIX_MX25U12835F)
@@ -202,6 +206,8 @@ extern "C"
 #define AM_DEVICES_MSPI_FLASH_READ_CONFIG               0x15
 #define AM_DEVICES_MSPI_FLASH_ENABLE_QPI_MODE           0x35
 #define AM_DEVICES_MSPI_FLASH_DISABLE_QPI_MODE          0xF5
+#define AM_DEVICES_MX25U12835F_PE_SUSPEND               0xB0
+#define AM_DEVICES_MX25U12835F_PE_RESUME                0x30
 
 //*****************************************************************************
 //
@@ -221,6 +227,7 @@ extern "C"
 #define AM_DEVICES_MSPI_FLASH_BLOCK_SIZE      0x10000  //64K bytes.
 #define AM_DEVICES_MSPI_FLASH_MAX_SECTORS     4096     // Sectors within 3-byte address range.
 #define AM_DEVICES_MSPI_FLASH_MAX_BLOCKS      256
+#define AM_DEVICES_MSPI_FLASH_SECTOR_ERASE_CMD  AM_DEVICES_MSPI_FLASH_SUBSECTOR_ERASE // Erases one AM_DEVICES_MSPI_FLASH_SECTOR_SIZE.
 #endif
 
 #if defined (ADESTO_ATXP032)
@@ -239,6 +246,8 @@ extern "C"
 #define AM_DEVICES_ATXP032_ENTER_QUAD_MODE      0x38
 #define AM_DEVICES_ATXP032_UNPROTECT_SECTOR     0x39
 #define AM_DEVICES_ATXP032_WRITE_STATUS_CTRL    0x71
+#define AM_DEVICES_ATXP032_PE_SUSPEND           0xB0
+#define AM_DEVICES_ATXP032_PE_RESUME            0xD0
 #define AM_DEVICES_ATXP032_ENTER_OCTAL_MODE     0xE8
 #define AM_DEVICES_ATXP032_RETURN_TO_SPI_MODE   0xFF
 //*****************************************************************************
@@ -251,6 +260,7 @@ extern "C"
 #define AM_DEVICES_MSPI_FLASH_SECTOR_SIZE     0x1000   //4K bytes
 #define AM_DEVICES_MSPI_FLASH_MAX_BLOCKS      256
 #define AM_DEVICES_MSPI_FLASH_MAX_SECTORS     256      // Sectors within 4-byte address range.
+#define AM_DEVICES_MSPI_FLASH_SECTOR_ERASE_CMD  AM_DEVICES_MSPI_FLASH_SUBSECTOR_ERASE // Erases one AM_DEVICES_MSPI_FLASH_SECTOR_SIZE.
 
 //*****************************************************************************
 //
@@ -278,9 +288,35 @@ extern "C"
 typedef enum
 {
     AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS,
-    AM_DEVICES_MSPI_FLASH_STATUS_ERROR
+    AM_DEVICES_MSPI_FLASH_STATUS_ERROR,
+    AM_DEVICES_MSPI_FLASH_STATUS_BUSY
 } am_devices_mspi_flash_status_t;
 
+//
+// Asynchronous program/erase engine.
+//
+typedef void (*am_devices_mspi_flash_async_callback_t)(void *pCallbackCtxt, uint32_t ui32Status);
+
+typedef enum
+{
+    AM_DEVICES_MSPI_FLASH_ASYNC_PROGRAM,
+    AM_DEVICES_MSPI_FLASH_ASYNC_ERASE
+} am_devices_mspi_flash_async_op_e;
+
+//
+// Queued job. The array of jobs is supplied by the caller to
+// am_devices_mspi_flash_async_init() and managed by the driver.
+//
+typedef struct
+{
+    am_devices_mspi_flash_async_op_e        eOp;
+    uint8_t                                 *pui8Buffer;
+    uint32_t                                ui32Address;
+    uint32_t                                ui32NumBytes;
+    am_devices_mspi_flash_async_callback_t  pfnCallback;
+    void                                    *pCallbackCtxt;
+} am_devices_mspi_flash_async_job_t;
+
 //*****************************************************************************
 //
 // External function definitions.
@@ -337,6 +373,31 @@ am_devices_mspi_flash_read_hiprio(uint8_t *pui8RxBuffer,
                            uint32_t ui32NumBytes,
                            bool bWaitForCompletion);
 
+extern uint32_t am_devices_mspi_flash_async_init(uint32_t ui32Module,
+                                                 am_devices_mspi_flash_async_job_t *pJobs,
+                                                 uint32_t ui32MaxJobs);
+
+extern uint32_t am_devices_mspi_flash_async_program(uint8_t *pui8TxBuffer,
+                                                    uint32_t ui32WriteAddress,
+                                                    uint32_t ui32NumBytes,
+                                                    am_devices_mspi_flash_async_callback_t pfnCallback,
+                                                    void *pCallbackCtxt);
+
+extern uint32_t am_devices_mspi_flash_async_erase(uint32_t ui32SectorAddress,
+                                                  am_devices_mspi_flash_async_callback_t pfnCallback,
+                                                  void *pCallbackCtxt);
+
+extern uint32_t am_devices_mspi_flash_async_service(void);
+
+extern bool am_devices_mspi_flash_async_busy(void);
+
+extern uint32_t am_devices_mspi_flash_async_suspend(void);
+
+extern uint32_t am_devices_mspi_flash_async_resume(void);
+
+extern uint32_t am_devices_mspi_flash_async_read(uint8_t *pui8RxBuffer,
+                                                 uint32_t ui32ReadAddress,
+                                                 uint32_t ui32NumBytes);
 
 
 #ifdef __cplusplus
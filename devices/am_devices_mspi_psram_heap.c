@@ -0,0 +1,871 @@
+//*****************************************************************************
+//
+//! @file am_devices_mspi_psram_heap.c
+//!
+//! @brief Region allocator and buffered access layer for MSPI PSRAM.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "am_devices_mspi_psram.h"
+#include "am_devices_mspi_psram_heap.h"
+
+//*****************************************************************************
+//
+// Local definitions.
+//
+//*****************************************************************************
+#define PSRAM_HEAP_END              0xFFFF
+
+#define PSRAM_HEAP_BLOCK_UNUSED     0
+#define PSRAM_HEAP_BLOCK_FREE       1
+#define PSRAM_HEAP_BLOCK_ALLOC      2
+
+#define PSRAM_HEAP_ALIGN_UP(x, a)   (((x) + ((a) - 1)) & ~((a) - 1))
+#define PSRAM_HEAP_IS_POW2(x)       (((x) != 0) && (((x) & ((x) - 1)) == 0))
+
+//*****************************************************************************
+//
+// Find an unused block table entry.
+//
+//*****************************************************************************
+static uint16_t
+heap_block_get(am_devices_mspi_psram_heap_t *pHeap)
+{
+    for (uint32_t i = 0; i < pHeap->sConfig.ui32NumBlocks; i++)
+    {
+        if (pHeap->sConfig.pBlocks[i].ui8State == PSRAM_HEAP_BLOCK_UNUSED)
+        {
+            return (uint16_t)i;
+        }
+    }
+
+    return PSRAM_HEAP_END;
+}
+
+//*****************************************************************************
+//
+// Resolve a handle and byte range to a PSRAM address.
+//
+//*****************************************************************************
+static uint32_t
+heap_block_lookup(am_devices_mspi_psram_heap_t *pHeap,
+                  am_devices_mspi_psram_heap_handle_t hBlock,
+                  uint32_t ui32Offset, uint32_t ui32NumBytes,
+                  uint32_t *pui32Address)
+{
+    am_devices_mspi_psram_heap_block_t *pBlock;
+
+    if ( (pHeap == NULL) ||
+         (hBlock == AM_DEVICES_MSPI_PSRAM_HEAP_INVALID_HANDLE) ||
+         (hBlock > pHeap->sConfig.ui32NumBlocks) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    pBlock = &pHeap->sConfig.pBlocks[hBlock - 1];
+    if ( (pBlock->ui8State != PSRAM_HEAP_BLOCK_ALLOC) ||
+         (ui32Offset > pBlock->ui32Size) ||
+         (ui32NumBytes > pBlock->ui32Size - ui32Offset) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    *pui32Address = pBlock->ui32Address + ui32Offset;
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Compute the overlap of a PSRAM range with the data held in the cached line.
+//
+// Returns the number of overlapping bytes, and their PSRAM address in
+// *pui32Start.
+//
+//*****************************************************************************
+static uint32_t
+heap_cache_overlap(am_devices_mspi_psram_heap_t *pHeap,
+                   uint32_t ui32Address, uint32_t ui32NumBytes,
+                   uint32_t *pui32Start)
+{
+    uint32_t ui32Start, ui32End, ui32LineStart, ui32LineEnd;
+
+    if (!pHeap->bCacheValid)
+    {
+        return 0;
+    }
+
+    ui32LineStart = pHeap->ui32CacheAddress + pHeap->ui32CacheStart;
+    ui32LineEnd = pHeap->ui32CacheAddress + pHeap->ui32CacheEnd;
+
+    ui32Start = (ui32Address > ui32LineStart) ? ui32Address : ui32LineStart;
+    ui32End = ((ui32Address + ui32NumBytes) < ui32LineEnd) ? (ui32Address + ui32NumBytes) : ui32LineEnd;
+
+    if (ui32End <= ui32Start)
+    {
+        return 0;
+    }
+
+    *pui32Start = ui32Start;
+
+    return ui32End - ui32Start;
+}
+
+//*****************************************************************************
+//
+// Write the cached line back to the device if it holds unwritten data.
+//
+//*****************************************************************************
+static uint32_t
+heap_cache_flush(am_devices_mspi_psram_heap_t *pHeap)
+{
+    uint32_t ui32Status;
+
+    if (!pHeap->bCacheValid || !pHeap->bCacheDirty)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+    }
+
+    ui32Status = pHeap->sConfig.pfnWrite((uint8_t *)pHeap->sConfig.pui32Cache + pHeap->ui32CacheStart,
+                                         pHeap->ui32CacheAddress + pHeap->ui32CacheStart,
+                                         pHeap->ui32CacheEnd - pHeap->ui32CacheStart,
+                                         true);
+    pHeap->ui32DeviceWrites++;
+    if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    pHeap->bCacheDirty = false;
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Check whether a write of a PSRAM range within the cached line would leave
+// the data held by the line contiguous.
+//
+//*****************************************************************************
+static bool
+heap_cache_joins(am_devices_mspi_psram_heap_t *pHeap,
+                 uint32_t ui32Address, uint32_t ui32NumBytes)
+{
+    uint32_t ui32Offset;
+
+    if ( !pHeap->bCacheValid || (ui32Address < pHeap->ui32CacheAddress) ||
+         (ui32Address >= pHeap->ui32CacheAddress + pHeap->sConfig.ui32CacheSize) )
+    {
+        return false;
+    }
+
+    ui32Offset = ui32Address - pHeap->ui32CacheAddress;
+
+    return (ui32Offset <= pHeap->ui32CacheEnd) &&
+           (ui32Offset + ui32NumBytes >= pHeap->ui32CacheStart);
+}
+
+//*****************************************************************************
+//
+// Make the line containing ui32LineAddress the cached line, ready to read or
+// write ui32NumBytes at ui32Offset within it.
+//
+// A read that misses loads the whole line. A write that misses takes over the
+// line without reading it, so the line only holds what has been written to
+// it; this is also how a write that would leave a gap in the held data is
+// handled, after the held data is written back.
+//
+//*****************************************************************************
+static uint32_t
+heap_cache_load(am_devices_mspi_psram_heap_t *pHeap, uint32_t ui32LineAddress,
+                uint32_t ui32Offset, uint32_t ui32NumBytes, bool bWrite)
+{
+    uint32_t ui32Status;
+
+    if ( pHeap->bCacheValid && (pHeap->ui32CacheAddress == ui32LineAddress) &&
+         (!bWrite || heap_cache_joins(pHeap, ui32LineAddress + ui32Offset, ui32NumBytes)) )
+    {
+        pHeap->ui32CacheHits++;
+        return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+    }
+
+    pHeap->ui32CacheMisses++;
+
+    ui32Status = heap_cache_flush(pHeap);
+    if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+    {
+        return ui32Status;
+    }
+
+    pHeap->bCacheValid = false;
+
+    if (bWrite)
+    {
+        //
+        // Nothing is held yet; the caller's write sets the range.
+        //
+        pHeap->ui32CacheStart = ui32Offset;
+        pHeap->ui32CacheEnd = ui32Offset;
+    }
+    else
+    {
+        ui32Status = pHeap->sConfig.pfnRead((uint8_t *)pHeap->sConfig.pui32Cache,
+                                            ui32LineAddress,
+                                            pHeap->sConfig.ui32CacheSize,
+                                            true);
+        pHeap->ui32DeviceReads++;
+        if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+        {
+            return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+        }
+
+        pHeap->ui32CacheStart = 0;
+        pHeap->ui32CacheEnd = pHeap->sConfig.ui32CacheSize;
+    }
+
+    pHeap->ui32CacheAddress = ui32LineAddress;
+    pHeap->bCacheValid = true;
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Initialize a PSRAM heap.
+//!
+//! @param pHeap - Heap state to initialize.
+//! @param psConfig - Address range, block table, cache and transfer functions.
+//!
+//! The whole range starts out as a single free region. The PSRAM device must
+//! already be initialized with am_devices_mspi_psram_init() unless custom
+//! transfer functions are supplied.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_init(am_devices_mspi_psram_heap_t *pHeap,
+                                const am_devices_mspi_psram_heap_config_t *psConfig)
+{
+    if ( (pHeap == NULL) || (psConfig == NULL) ||
+         (psConfig->pBlocks == NULL) ||
+         (psConfig->ui32NumBlocks == 0) ||
+         (psConfig->ui32NumBlocks >= PSRAM_HEAP_END) ||
+         (psConfig->ui32Size == 0) ||
+         (psConfig->ui32Base % AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN) ||
+         (psConfig->ui32Size % AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    if ( (psConfig->pui32Cache != NULL) &&
+         ( !PSRAM_HEAP_IS_POW2(psConfig->ui32CacheSize) ||
+           (psConfig->ui32CacheSize < AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN) ||
+           (psConfig->ui32Base & (psConfig->ui32CacheSize - 1)) ||
+           (psConfig->ui32Size & (psConfig->ui32CacheSize - 1)) ) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    memset(pHeap, 0, sizeof(am_devices_mspi_psram_heap_t));
+    pHeap->sConfig = *psConfig;
+
+    if (pHeap->sConfig.pfnRead == NULL)
+    {
+        pHeap->sConfig.pfnRead = am_devices_mspi_psram_read;
+    }
+    if (pHeap->sConfig.pfnWrite == NULL)
+    {
+        pHeap->sConfig.pfnWrite = am_devices_mspi_psram_write;
+    }
+
+    memset(psConfig->pBlocks, 0,
+           psConfig->ui32NumBlocks * sizeof(am_devices_mspi_psram_heap_block_t));
+
+    psConfig->pBlocks[0].ui32Address = psConfig->ui32Base;
+    psConfig->pBlocks[0].ui32Size = psConfig->ui32Size;
+    psConfig->pBlocks[0].ui16Next = PSRAM_HEAP_END;
+    psConfig->pBlocks[0].ui8State = PSRAM_HEAP_BLOCK_FREE;
+    pHeap->ui16Head = 0;
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Allocate a block of PSRAM.
+//!
+//! @param pHeap - Heap to allocate from.
+//! @param ui32Size - Number of bytes required. Rounded up to a whole word.
+//! @param ui32Align - Required alignment of the block address. Must be a
+//! power of 2; values below AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN are raised
+//! to it.
+//! @param ui32Flags - AM_DEVICES_MSPI_PSRAM_HEAP_NO_PAGE_CROSS or 0.
+//! @param pHandle - Receives the handle of the new block.
+//!
+//! Uses first fit. If the block table has no spare entry to hold the unused
+//! tail of a region, the tail is folded into the allocation.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_alloc(am_devices_mspi_psram_heap_t *pHeap,
+                                 uint32_t ui32Size,
+                                 uint32_t ui32Align,
+                                 uint32_t ui32Flags,
+                                 am_devices_mspi_psram_heap_handle_t *pHandle)
+{
+    am_devices_mspi_psram_heap_block_t *pBlocks;
+    uint16_t ui16Prev = PSRAM_HEAP_END;
+    bool bNoPageCross;
+
+    if ( (pHeap == NULL) || (pHandle == NULL) || (ui32Size == 0) ||
+         ((ui32Align != 0) && !PSRAM_HEAP_IS_POW2(ui32Align)) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    *pHandle = AM_DEVICES_MSPI_PSRAM_HEAP_INVALID_HANDLE;
+
+    if (ui32Size > pHeap->sConfig.ui32Size)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    ui32Size = PSRAM_HEAP_ALIGN_UP(ui32Size, AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN);
+    if (ui32Align < AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN)
+    {
+        ui32Align = AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN;
+    }
+
+    bNoPageCross = (ui32Flags & AM_DEVICES_MSPI_PSRAM_HEAP_NO_PAGE_CROSS) &&
+                   (ui32Size <= AM_DEVICES_MSPI_PSRAM_PAGE_SIZE);
+
+    pBlocks = pHeap->sConfig.pBlocks;
+
+    for (uint16_t i = pHeap->ui16Head; i != PSRAM_HEAP_END;
+         ui16Prev = i, i = pBlocks[i].ui16Next)
+    {
+        uint32_t ui32Start, ui32Pad, ui32Tail;
+
+        if (pBlocks[i].ui8State != PSRAM_HEAP_BLOCK_FREE)
+        {
+            continue;
+        }
+
+        ui32Start = PSRAM_HEAP_ALIGN_UP(pBlocks[i].ui32Address, ui32Align);
+        if ( bNoPageCross &&
+             ((ui32Start / AM_DEVICES_MSPI_PSRAM_PAGE_SIZE) !=
+              ((ui32Start + ui32Size - 1) / AM_DEVICES_MSPI_PSRAM_PAGE_SIZE)) )
+        {
+            //
+            // Move to the next page. A page boundary satisfies any alignment
+            // up to the page size, and a larger alignment never crosses.
+            //
+            ui32Start = PSRAM_HEAP_ALIGN_UP(ui32Start, AM_DEVICES_MSPI_PSRAM_PAGE_SIZE);
+        }
+
+        ui32Pad = ui32Start - pBlocks[i].ui32Address;
+        if ( (ui32Pad > pBlocks[i].ui32Size) ||
+             (ui32Size > pBlocks[i].ui32Size - ui32Pad) )
+        {
+            continue;
+        }
+        ui32Tail = pBlocks[i].ui32Size - ui32Pad - ui32Size;
+
+        //
+        // Split off the alignment padding as its own free region. Without a
+        // spare entry the padding would be lost, so try the next region.
+        //
+        if (ui32Pad)
+        {
+            uint16_t j = heap_block_get(pHeap);
+
+            if (j == PSRAM_HEAP_END)
+            {
+                continue;
+            }
+
+            pBlocks[j].ui32Address = pBlocks[i].ui32Address;
+            pBlocks[j].ui32Size = ui32Pad;
+            pBlocks[j].ui16Next = i;
+            pBlocks[j].ui8State = PSRAM_HEAP_BLOCK_FREE;
+
+            if (ui16Prev == PSRAM_HEAP_END)
+            {
+                pHeap->ui16Head = j;
+            }
+            else
+            {
+                pBlocks[ui16Prev].ui16Next = j;
+            }
+
+            pBlocks[i].ui32Address = ui32Start;
+            pBlocks[i].ui32Size -= ui32Pad;
+        }
+
+        //
+        // Return the unused tail to the free list.
+        //
+        if (ui32Tail)
+        {
+            uint16_t k = heap_block_get(pHeap);
+
+            if (k != PSRAM_HEAP_END)
+            {
+                pBlocks[k].ui32Address = ui32Start + ui32Size;
+                pBlocks[k].ui32Size = ui32Tail;
+                pBlocks[k].ui16Next = pBlocks[i].ui16Next;
+                pBlocks[k].ui8State = PSRAM_HEAP_BLOCK_FREE;
+
+                pBlocks[i].ui16Next = k;
+                pBlocks[i].ui32Size = ui32Size;
+            }
+        }
+
+        pBlocks[i].ui8State = PSRAM_HEAP_BLOCK_ALLOC;
+        *pHandle = (am_devices_mspi_psram_heap_handle_t)i + 1;
+
+        return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+    }
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+}
+
+//*****************************************************************************
+//
+//! @brief Release a block of PSRAM.
+//!
+//! @param pHeap - Heap the block was allocated from.
+//! @param hBlock - Handle returned by am_devices_mspi_psram_heap_alloc().
+//!
+//! The region is merged with any free neighbours. Cached data for the block
+//! is left in place and written back with the rest of its line.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_free(am_devices_mspi_psram_heap_t *pHeap,
+                                am_devices_mspi_psram_heap_handle_t hBlock)
+{
+    am_devices_mspi_psram_heap_block_t *pBlocks;
+    uint16_t ui16Prev = PSRAM_HEAP_END;
+    uint16_t i, ui16Next;
+
+    if ( (pHeap == NULL) ||
+         (hBlock == AM_DEVICES_MSPI_PSRAM_HEAP_INVALID_HANDLE) ||
+         (hBlock > pHeap->sConfig.ui32NumBlocks) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    pBlocks = pHeap->sConfig.pBlocks;
+    i = (uint16_t)(hBlock - 1);
+
+    if (pBlocks[i].ui8State != PSRAM_HEAP_BLOCK_ALLOC)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    pBlocks[i].ui8State = PSRAM_HEAP_BLOCK_FREE;
+
+    //
+    // Merge with the following region.
+    //
+    ui16Next = pBlocks[i].ui16Next;
+    if ( (ui16Next != PSRAM_HEAP_END) &&
+         (pBlocks[ui16Next].ui8State == PSRAM_HEAP_BLOCK_FREE) )
+    {
+        pBlocks[i].ui32Size += pBlocks[ui16Next].ui32Size;
+        pBlocks[i].ui16Next = pBlocks[ui16Next].ui16Next;
+        pBlocks[ui16Next].ui8State = PSRAM_HEAP_BLOCK_UNUSED;
+    }
+
+    //
+    // Merge with the preceding region.
+    //
+    for (uint16_t j = pHeap->ui16Head; j != i; j = pBlocks[j].ui16Next)
+    {
+        ui16Prev = j;
+    }
+
+    if ( (ui16Prev != PSRAM_HEAP_END) &&
+         (pBlocks[ui16Prev].ui8State == PSRAM_HEAP_BLOCK_FREE) )
+    {
+        pBlocks[ui16Prev].ui32Size += pBlocks[i].ui32Size;
+        pBlocks[ui16Prev].ui16Next = pBlocks[i].ui16Next;
+        pBlocks[i].ui8State = PSRAM_HEAP_BLOCK_UNUSED;
+    }
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Get the PSRAM address and size of a block.
+//!
+//! @param pHeap - Heap the block was allocated from.
+//! @param hBlock - Block handle.
+//! @param pui32Address - Receives the PSRAM address of the block.
+//! @param pui32Size - Receives the usable size of the block. May be NULL.
+//!
+//! Useful for handing a block to the raw PSRAM or XIP interfaces. Call
+//! am_devices_mspi_psram_heap_flush() first if the block was written through
+//! the cache.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_address(am_devices_mspi_psram_heap_t *pHeap,
+                                   am_devices_mspi_psram_heap_handle_t hBlock,
+                                   uint32_t *pui32Address,
+                                   uint32_t *pui32Size)
+{
+    uint32_t ui32Status;
+
+    if (pui32Address == NULL)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    ui32Status = heap_block_lookup(pHeap, hBlock, 0, 0, pui32Address);
+    if ( (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS == ui32Status) && (pui32Size != NULL) )
+    {
+        *pui32Size = pHeap->sConfig.pBlocks[hBlock - 1].ui32Size;
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Read from a PSRAM block.
+//!
+//! @param pHeap - Heap the block was allocated from.
+//! @param hBlock - Block handle.
+//! @param ui32Offset - Byte offset within the block.
+//! @param pui8RxBuffer - Destination buffer.
+//! @param ui32NumBytes - Number of bytes to read.
+//!
+//! Reads held in the cache are served from it. A read within a single line
+//! that is not cached loads the line with one full line burst. Other reads go
+//! straight to the device, with any unwritten cached bytes patched into the
+//! result.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_read(am_devices_mspi_psram_heap_t *pHeap,
+                                am_devices_mspi_psram_heap_handle_t hBlock,
+                                uint32_t ui32Offset,
+                                uint8_t *pui8RxBuffer,
+                                uint32_t ui32NumBytes)
+{
+    uint32_t ui32Address, ui32Status;
+    uint32_t ui32LineSize, ui32Line, ui32Start;
+
+    if (pui8RxBuffer == NULL)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    ui32Status = heap_block_lookup(pHeap, hBlock, ui32Offset, ui32NumBytes, &ui32Address);
+    if ( (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status) || (ui32NumBytes == 0) )
+    {
+        return ui32Status;
+    }
+
+    ui32LineSize = pHeap->sConfig.ui32CacheSize;
+    ui32Line = ui32Address & ~(ui32LineSize - 1);
+
+    //
+    // Only go through the cache if that costs at most the one transfer a
+    // direct read would.
+    //
+    if ( (pHeap->sConfig.pui32Cache == NULL) ||
+         ( (heap_cache_overlap(pHeap, ui32Address, ui32NumBytes, &ui32Start) != ui32NumBytes) &&
+           ( (ui32Address + ui32NumBytes > ui32Line + ui32LineSize) ||
+             (pHeap->bCacheValid && (pHeap->ui32CacheAddress == ui32Line)) ) ) )
+    {
+        uint32_t ui32Overlap;
+
+        ui32Status = pHeap->sConfig.pfnRead(pui8RxBuffer, ui32Address, ui32NumBytes, true);
+        pHeap->ui32DeviceReads++;
+        if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+        {
+            return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+        }
+
+        ui32Overlap = heap_cache_overlap(pHeap, ui32Address, ui32NumBytes, &ui32Start);
+        if (ui32Overlap && pHeap->bCacheDirty)
+        {
+            memcpy(pui8RxBuffer + (ui32Start - ui32Address),
+                   (uint8_t *)pHeap->sConfig.pui32Cache + (ui32Start - pHeap->ui32CacheAddress),
+                   ui32Overlap);
+        }
+
+        return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+    }
+
+    ui32Status = heap_cache_load(pHeap, ui32Line, ui32Address - ui32Line, ui32NumBytes, false);
+    if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+    {
+        return ui32Status;
+    }
+
+    memcpy(pui8RxBuffer, (uint8_t *)pHeap->sConfig.pui32Cache + (ui32Address - ui32Line), ui32NumBytes);
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Write to a PSRAM block.
+//!
+//! @param pHeap - Heap the block was allocated from.
+//! @param hBlock - Block handle.
+//! @param ui32Offset - Byte offset within the block.
+//! @param pui8TxBuffer - Source buffer.
+//! @param ui32NumBytes - Number of bytes to write.
+//!
+//! Writes within a single line, and writes that continue the data held in the
+//! cached line into the next one, are merged into the cache and reach the
+//! device when the line is evicted or flushed. The line is never read from
+//! the device for a write. Other writes go straight to the device, and any
+//! cached copy of the same bytes is updated to match.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_write(am_devices_mspi_psram_heap_t *pHeap,
+                                 am_devices_mspi_psram_heap_handle_t hBlock,
+                                 uint32_t ui32Offset,
+                                 const uint8_t *pui8TxBuffer,
+                                 uint32_t ui32NumBytes)
+{
+    uint32_t ui32Address, ui32Status;
+    uint32_t ui32LineSize;
+
+    if (pui8TxBuffer == NULL)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    ui32Status = heap_block_lookup(pHeap, hBlock, ui32Offset, ui32NumBytes, &ui32Address);
+    if ( (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status) || (ui32NumBytes == 0) )
+    {
+        return ui32Status;
+    }
+
+    ui32LineSize = pHeap->sConfig.ui32CacheSize;
+
+    //
+    // A write that spans two lines costs one write back per line through the
+    // cache, so only take that path when the first line is already owed one.
+    //
+    if ( (pHeap->sConfig.pui32Cache == NULL) || (ui32NumBytes >= ui32LineSize) ||
+         ( ((ui32Address & (ui32LineSize - 1)) + ui32NumBytes > ui32LineSize) &&
+           !(pHeap->bCacheDirty && heap_cache_joins(pHeap, ui32Address, ui32NumBytes)) ) )
+    {
+        uint32_t ui32Start, ui32Overlap;
+
+        ui32Status = pHeap->sConfig.pfnWrite((uint8_t *)pui8TxBuffer, ui32Address, ui32NumBytes, true);
+        pHeap->ui32DeviceWrites++;
+        if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+        {
+            return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+        }
+
+        ui32Overlap = heap_cache_overlap(pHeap, ui32Address, ui32NumBytes, &ui32Start);
+        if (ui32Overlap)
+        {
+            memcpy((uint8_t *)pHeap->sConfig.pui32Cache + (ui32Start - pHeap->ui32CacheAddress),
+                   pui8TxBuffer + (ui32Start - ui32Address),
+                   ui32Overlap);
+        }
+
+        return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+    }
+
+    while (ui32NumBytes)
+    {
+        uint32_t ui32Line = ui32Address & ~(ui32LineSize - 1);
+        uint32_t ui32LineOffset = ui32Address - ui32Line;
+        uint32_t ui32Chunk = ui32LineSize - ui32LineOffset;
+
+        if (ui32Chunk > ui32NumBytes)
+        {
+            ui32Chunk = ui32NumBytes;
+        }
+
+        ui32Status = heap_cache_load(pHeap, ui32Line, ui32LineOffset, ui32Chunk, true);
+        if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS != ui32Status)
+        {
+            return ui32Status;
+        }
+
+        memcpy((uint8_t *)pHeap->sConfig.pui32Cache + ui32LineOffset, pui8TxBuffer, ui32Chunk);
+        pHeap->bCacheDirty = true;
+        if (ui32LineOffset < pHeap->ui32CacheStart)
+        {
+            pHeap->ui32CacheStart = ui32LineOffset;
+        }
+        if (ui32LineOffset + ui32Chunk > pHeap->ui32CacheEnd)
+        {
+            pHeap->ui32CacheEnd = ui32LineOffset + ui32Chunk;
+        }
+
+        pui8TxBuffer += ui32Chunk;
+        ui32Address += ui32Chunk;
+        ui32NumBytes -= ui32Chunk;
+    }
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Write any cached data back to the device.
+//!
+//! @param pHeap - Heap to flush.
+//!
+//! Must be called before the PSRAM is accessed other than through this heap,
+//! for example before enabling XIP or powering the device down.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_flush(am_devices_mspi_psram_heap_t *pHeap)
+{
+    if (pHeap == NULL)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    return heap_cache_flush(pHeap);
+}
+
+//*****************************************************************************
+//
+//! @brief Flush and then drop the cached line.
+//!
+//! @param pHeap - Heap to invalidate.
+//!
+//! Must be called after the PSRAM has been modified other than through this
+//! heap, for example by a DMA transfer issued with the raw driver API.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_invalidate(am_devices_mspi_psram_heap_t *pHeap)
+{
+    uint32_t ui32Status;
+
+    if (pHeap == NULL)
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    ui32Status = heap_cache_flush(pHeap);
+    if (AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS == ui32Status)
+    {
+        pHeap->bCacheValid = false;
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+//! @brief Report heap usage and cache statistics.
+//!
+//! @param pHeap - Heap to query.
+//! @param psStats - Receives the statistics.
+//!
+//! @return 32-bit status
+//
+//*****************************************************************************
+uint32_t
+am_devices_mspi_psram_heap_stats(am_devices_mspi_psram_heap_t *pHeap,
+                                 am_devices_mspi_psram_heap_stats_t *psStats)
+{
+    am_devices_mspi_psram_heap_block_t *pBlocks;
+
+    if ( (pHeap == NULL) || (psStats == NULL) )
+    {
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+
+    memset(psStats, 0, sizeof(am_devices_mspi_psram_heap_stats_t));
+
+    pBlocks = pHeap->sConfig.pBlocks;
+    for (uint16_t i = pHeap->ui16Head; i != PSRAM_HEAP_END; i = pBlocks[i].ui16Next)
+    {
+        if (pBlocks[i].ui8State == PSRAM_HEAP_BLOCK_FREE)
+        {
+            psStats->ui32BytesFree += pBlocks[i].ui32Size;
+            if (pBlocks[i].ui32Size > psStats->ui32LargestFree)
+            {
+                psStats->ui32LargestFree = pBlocks[i].ui32Size;
+            }
+        }
+        else
+        {
+            psStats->ui32NumAllocated++;
+        }
+    }
+
+    psStats->ui32CacheHits = pHeap->ui32CacheHits;
+    psStats->ui32CacheMisses = pHeap->ui32CacheMisses;
+    psStats->ui32DeviceReads = pHeap->ui32DeviceReads;
+    psStats->ui32DeviceWrites = pHeap->ui32DeviceWrites;
+
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
@@ -0,0 +1,224 @@
+//*****************************************************************************
+//
+//! @file am_devices_mspi_psram_heap.h
+//!
+//! @brief Region allocator and buffered access layer for MSPI PSRAM.
+//!
+//!
+//! Carves a PSRAM address range into handles using a caller supplied block
+//! table, and services reads and writes through an optional single line SRAM
+//! write-back cache so that small record accesses are batched into full MSPI
+//! DMA bursts. A write that misses the cache takes over the line without
+//! reading it from the device first. The low level transfer functions are
+//! pluggable so that the module can be run against a RAM backed model of the
+//! device.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#ifndef AM_DEVICES_MSPI_PSRAM_HEAP_H
+#define AM_DEVICES_MSPI_PSRAM_HEAP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Global definitions.
+//
+//*****************************************************************************
+//
+// Minimum alignment of every block. The MSPI DMA engine moves whole words, so
+// every block starts and ends on a word boundary.
+//
+#define AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN    4
+
+//
+// Allocation flag: keep the block within a single PSRAM page. Only honored
+// for blocks no larger than AM_DEVICES_MSPI_PSRAM_PAGE_SIZE.
+//
+#define AM_DEVICES_MSPI_PSRAM_HEAP_NO_PAGE_CROSS    0x1
+
+//
+// Handle value that never refers to a block.
+//
+#define AM_DEVICES_MSPI_PSRAM_HEAP_INVALID_HANDLE   0
+
+//*****************************************************************************
+//
+// Global type definitions.
+//
+//*****************************************************************************
+typedef uint32_t am_devices_mspi_psram_heap_handle_t;
+
+//
+// Transfer function used to move data between SRAM and PSRAM. The signature
+// matches am_devices_mspi_psram_read() and am_devices_mspi_psram_write().
+//
+typedef uint32_t (*am_devices_mspi_psram_heap_xfer_t)(uint8_t *pui8Buffer,
+                                                      uint32_t ui32Address,
+                                                      uint32_t ui32NumBytes,
+                                                      bool bWaitForCompletion);
+
+//
+// Block table entry. The table is supplied by the caller and is managed
+// entirely by the heap.
+//
+typedef struct
+{
+    uint32_t    ui32Address;
+    uint32_t    ui32Size;
+    uint16_t    ui16Next;
+    uint8_t     ui8State;
+} am_devices_mspi_psram_heap_block_t;
+
+typedef struct
+{
+    //
+    // PSRAM address range managed by the heap. When a cache is used, both
+    // must be multiples of ui32CacheSize.
+    //
+    uint32_t                            ui32Base;
+    uint32_t                            ui32Size;
+
+    //
+    // Block table. Every allocation uses one entry, and splitting a free
+    // region around an aligned allocation may use up to two more.
+    //
+    am_devices_mspi_psram_heap_block_t  *pBlocks;
+    uint32_t                            ui32NumBlocks;
+
+    //
+    // Optional write-back cache line. ui32CacheSize must be a power of 2 no
+    // smaller than AM_DEVICES_MSPI_PSRAM_HEAP_MIN_ALIGN. Set pui32Cache to
+    // NULL to send every access straight to the device.
+    //
+    uint32_t                            *pui32Cache;
+    uint32_t                            ui32CacheSize;
+
+    //
+    // Transfer functions. NULL selects am_devices_mspi_psram_read() and
+    // am_devices_mspi_psram_write().
+    //
+    am_devices_mspi_psram_heap_xfer_t   pfnRead;
+    am_devices_mspi_psram_heap_xfer_t   pfnWrite;
+} am_devices_mspi_psram_heap_config_t;
+
+typedef struct
+{
+    uint32_t    ui32BytesFree;
+    uint32_t    ui32LargestFree;
+    uint32_t    ui32NumAllocated;
+    uint32_t    ui32CacheHits;
+    uint32_t    ui32CacheMisses;
+    uint32_t    ui32DeviceReads;
+    uint32_t    ui32DeviceWrites;
+} am_devices_mspi_psram_heap_stats_t;
+
+//
+// Heap state. Allocated by the caller and treated as opaque.
+//
+typedef struct
+{
+    am_devices_mspi_psram_heap_config_t sConfig;
+    uint16_t                            ui16Head;
+    bool                                bCacheValid;
+    bool                                bCacheDirty;
+    uint32_t                            ui32CacheAddress;
+    //
+    // Byte range of the line that holds data. A read miss loads the whole
+    // line; a write miss starts an empty range that writes then extend.
+    //
+    uint32_t                            ui32CacheStart;
+    uint32_t                            ui32CacheEnd;
+    uint32_t                            ui32CacheHits;
+    uint32_t                            ui32CacheMisses;
+    uint32_t                            ui32DeviceReads;
+    uint32_t                            ui32DeviceWrites;
+} am_devices_mspi_psram_heap_t;
+
+//*****************************************************************************
+//
+// External function definitions.
+//
+//*****************************************************************************
+extern uint32_t am_devices_mspi_psram_heap_init(am_devices_mspi_psram_heap_t *pHeap,
+                                                const am_devices_mspi_psram_heap_config_t *psConfig);
+
+extern uint32_t am_devices_mspi_psram_heap_alloc(am_devices_mspi_psram_heap_t *pHeap,
+                                                 uint32_t ui32Size,
+                                                 uint32_t ui32Align,
+                                                 uint32_t ui32Flags,
+                                                 am_devices_mspi_psram_heap_handle_t *pHandle);
+
+extern uint32_t am_devices_mspi_psram_heap_free(am_devices_mspi_psram_heap_t *pHeap,
+                                                am_devices_mspi_psram_heap_handle_t hBlock);
+
+extern uint32_t am_devices_mspi_psram_heap_address(am_devices_mspi_psram_heap_t *pHeap,
+                                                   am_devices_mspi_psram_heap_handle_t hBlock,
+                                                   uint32_t *pui32Address,
+                                                   uint32_t *pui32Size);
+
+extern uint32_t am_devices_mspi_psram_heap_read(am_devices_mspi_psram_heap_t *pHeap,
+                                                am_devices_mspi_psram_heap_handle_t hBlock,
+                                                uint32_t ui32Offset,
+                                                uint8_t *pui8RxBuffer,
+                                                uint32_t ui32NumBytes);
+
+extern uint32_t am_devices_mspi_psram_heap_write(am_devices_mspi_psram_heap_t *pHeap,
+                                                 am_devices_mspi_psram_heap_handle_t hBlock,
+                                                 uint32_t ui32Offset,
+                                                 const uint8_t *pui8TxBuffer,
+                                                 uint32_t ui32NumBytes);
+
+extern uint32_t am_devices_mspi_psram_heap_flush(am_devices_mspi_psram_heap_t *pHeap);
+
+extern uint32_t am_devices_mspi_psram_heap_invalidate(am_devices_mspi_psram_heap_t *pHeap);
+
+extern uint32_t am_devices_mspi_psram_heap_stats(am_devices_mspi_psram_heap_t *pHeap,
+                                                 am_devices_mspi_psram_heap_stats_t *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_DEVICES_MSPI_PSRAM_HEAP_H
@@ -1127,6 +1127,167 @@ uint32_t am_hal_adc_samples_read(void *pHandle, bool bFullSample,
     return AM_HAL_STATUS_SUCCESS;
 }
 
+//*****************************************************************************
+//
+// ADC sample demultiplexer initialization
+//
+//*****************************************************************************
+uint32_t
+am_hal_adc_demux_init(am_hal_adc_demux_t *psDemux,
+                      const am_hal_adc_demux_config_t *psConfig)
+{
+    uint32_t ui32Shift;
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (NULL == psDemux) || (NULL == psConfig) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    //
+    // The decimation factor is applied as a shift.
+    //
+    for ( ui32Shift = 0; ui32Shift <= 8; ui32Shift++ )
+    {
+        if ( psConfig->ui32Decimation == (1u << ui32Shift) )
+        {
+            break;
+        }
+    }
+
+    if ( ui32Shift > 8 )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    psDemux->sConfig = *psConfig;
+    psDemux->ui32DecimationShift = ui32Shift;
+
+    for ( uint32_t i = 0; i < AM_HAL_ADC_MAX_SLOTS; i++ )
+    {
+        psDemux->ui32Accum[i] = 0;
+        psDemux->ui32AccumCount[i] = 0;
+    }
+
+    return am_hal_adc_demux_reset(psDemux);
+}
+
+//*****************************************************************************
+//
+// ADC sample demultiplexer output reset
+//
+//*****************************************************************************
+uint32_t
+am_hal_adc_demux_reset(am_hal_adc_demux_t *psDemux)
+{
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( NULL == psDemux )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    for ( uint32_t i = 0; i < AM_HAL_ADC_MAX_SLOTS; i++ )
+    {
+        psDemux->ui32Count[i] = 0;
+        psDemux->ui32Overflows[i] = 0;
+        psDemux->ui32TriggerIndex[i] = AM_HAL_ADC_DEMUX_NO_TRIGGER;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// ADC sample demultiplexer
+//
+// Each FIFO word carries its slot number and a 14.6 fixed point sample. The
+// fractional bits are kept while accumulating so that averaging gains
+// precision before the result is rounded back to the integer part.
+//
+//*****************************************************************************
+uint32_t
+am_hal_adc_samples_demux(am_hal_adc_demux_t *psDemux,
+                         const uint32_t *pui32InSampleBuffer,
+                         uint32_t ui32NumSamples,
+                         uint32_t *pui32TriggerMask)
+{
+    uint32_t ui32Decimation;
+    uint32_t ui32OutShift;
+    uint32_t ui32Round;
+    uint32_t ui32TriggerMask = 0;
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (NULL == psDemux) || ((NULL == pui32InSampleBuffer) && ui32NumSamples) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    ui32Decimation = psDemux->sConfig.ui32Decimation;
+    ui32OutShift = psDemux->ui32DecimationShift + 6;
+    ui32Round = 1u << (ui32OutShift - 1);
+
+    while ( ui32NumSamples-- )
+    {
+        uint32_t ui32Word = *pui32InSampleBuffer++;
+        uint32_t ui32Slot = AM_HAL_ADC_FIFO_SLOT(ui32Word);
+        const am_hal_adc_demux_slot_config_t *psSlot;
+        int16_t i16Out;
+
+        //
+        // Without decimation every word is an output sample, so skip the
+        // accumulator.
+        //
+        if ( ui32Decimation > 1 )
+        {
+            psDemux->ui32Accum[ui32Slot] += AM_HAL_ADC_FIFO_FULL_SAMPLE(ui32Word);
+            if ( ++psDemux->ui32AccumCount[ui32Slot] < ui32Decimation )
+            {
+                continue;
+            }
+
+            i16Out = (int16_t)((psDemux->ui32Accum[ui32Slot] + ui32Round) >> ui32OutShift);
+            psDemux->ui32Accum[ui32Slot] = 0;
+            psDemux->ui32AccumCount[ui32Slot] = 0;
+        }
+        else
+        {
+            i16Out = (int16_t)((AM_HAL_ADC_FIFO_FULL_SAMPLE(ui32Word) + ui32Round) >> ui32OutShift);
+        }
+
+        psSlot = &psDemux->sConfig.sSlot[ui32Slot];
+        if ( NULL == psSlot->pi16Buffer )
+        {
+            continue;
+        }
+
+        if ( psDemux->ui32Count[ui32Slot] >= psSlot->ui32Capacity )
+        {
+            psDemux->ui32Overflows[ui32Slot]++;
+            continue;
+        }
+
+        if ( psSlot->bTriggerEnable &&
+             (psDemux->ui32TriggerIndex[ui32Slot] == AM_HAL_ADC_DEMUX_NO_TRIGGER) &&
+             ((i16Out > psSlot->i16TriggerHigh) || (i16Out < psSlot->i16TriggerLow)) )
+        {
+            psDemux->ui32TriggerIndex[ui32Slot] = psDemux->ui32Count[ui32Slot];
+            ui32TriggerMask |= (1u << ui32Slot);
+        }
+
+        psSlot->pi16Buffer[psDemux->ui32Count[ui32Slot]++] = i16Out;
+    }
+
+    if ( pui32TriggerMask )
+    {
+        *pui32TriggerMask = ui32TriggerMask;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
 //*****************************************************************************
 //
 //! @brief Issue Software Trigger to the ADC.
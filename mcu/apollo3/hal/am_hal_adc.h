@@ -229,6 +229,72 @@ typedef struct
   uint32_t      ui32Slot;
 } am_hal_adc_sample_t;
 
+//
+// Value of am_hal_adc_demux_t.ui32TriggerIndex for a slot whose trigger has
+// not fired.
+//
+#define AM_HAL_ADC_DEMUX_NO_TRIGGER     0xFFFFFFFF
+
+//
+// Per-slot output and trigger settings for the sample demultiplexer.
+//
+typedef struct
+{
+    //
+    // Destination for this slot's decimated samples. NULL discards the slot.
+    //
+    int16_t       *pi16Buffer;
+    uint32_t      ui32Capacity;
+
+    //
+    // Fire when an output sample is above i16TriggerHigh or below
+    // i16TriggerLow.
+    //
+    bool          bTriggerEnable;
+    int16_t       i16TriggerHigh;
+    int16_t       i16TriggerLow;
+} am_hal_adc_demux_slot_config_t;
+
+//
+// Sample demultiplexer configuration.
+//
+typedef struct
+{
+    am_hal_adc_demux_slot_config_t sSlot[AM_HAL_ADC_MAX_SLOTS];
+
+    //
+    // Number of consecutive samples of a slot averaged into one output
+    // sample. Must be a power of 2 from 1 to 256.
+    //
+    uint32_t      ui32Decimation;
+} am_hal_adc_demux_config_t;
+
+//
+// Sample demultiplexer state. The counters may be read directly.
+//
+typedef struct
+{
+    am_hal_adc_demux_config_t sConfig;
+    uint32_t      ui32DecimationShift;
+    uint32_t      ui32Accum[AM_HAL_ADC_MAX_SLOTS];
+    uint32_t      ui32AccumCount[AM_HAL_ADC_MAX_SLOTS];
+
+    //
+    // Output samples written to each slot's buffer.
+    //
+    uint32_t      ui32Count[AM_HAL_ADC_MAX_SLOTS];
+
+    //
+    // Output samples dropped because the slot's buffer was full.
+    //
+    uint32_t      ui32Overflows[AM_HAL_ADC_MAX_SLOTS];
+
+    //
+    // Buffer index of the first output sample that fired the trigger.
+    //
+    uint32_t      ui32TriggerIndex[AM_HAL_ADC_MAX_SLOTS];
+} am_hal_adc_demux_t;
+
 
 //*****************************************************************************
 //
@@ -632,6 +698,61 @@ extern "C"
                                           uint32_t *pui32InOutNumberSamples,
                                           am_hal_adc_sample_t *pui32OutBuffer);
 
+  //*****************************************************************************
+  //
+  //! @brief ADC sample demultiplexer initialization
+  //!
+  //! @param psDemux      - demultiplexer state.
+  //! @param psConfig     - per-slot buffers, triggers and decimation.
+  //!
+  //! This function prepares a demultiplexer for
+  //! am_hal_adc_samples_demux().
+  //!
+  //! @return status      - generic or interface specific status.
+  //
+  //*****************************************************************************
+  extern uint32_t am_hal_adc_demux_init(am_hal_adc_demux_t *psDemux,
+                                        const am_hal_adc_demux_config_t *psConfig);
+
+  //*****************************************************************************
+  //
+  //! @brief ADC sample demultiplexer output reset
+  //!
+  //! @param psDemux      - demultiplexer state.
+  //!
+  //! This function restarts every slot's output at the start of its buffer
+  //! and re-arms the triggers. Partially accumulated samples are kept, so the
+  //! decimated stream stays continuous.
+  //!
+  //! @return status      - generic or interface specific status.
+  //
+  //*****************************************************************************
+  extern uint32_t am_hal_adc_demux_reset(am_hal_adc_demux_t *psDemux);
+
+  //*****************************************************************************
+  //
+  //! @brief ADC sample demultiplexer
+  //!
+  //! @param psDemux          - demultiplexer state.
+  //! @param pui32InSampleBuffer - samples returned by a DMA operation.
+  //! @param ui32NumSamples   - number of samples in the buffer.
+  //! @param pui32TriggerMask - returns a bit per slot whose trigger fired
+  //!                           during this call. May be NULL.
+  //!
+  //! This function sorts raw FIFO words by slot into packed int16 buffers in
+  //! a single pass, averaging ui32Decimation samples of each slot into one
+  //! output sample. Output samples are in the same units as
+  //! AM_HAL_ADC_FIFO_SAMPLE(). Unlike am_hal_adc_samples_read() it does not
+  //! touch the hardware, so it may run on data from any source.
+  //!
+  //! @return status      - generic or interface specific status.
+  //
+  //*****************************************************************************
+  extern uint32_t am_hal_adc_samples_demux(am_hal_adc_demux_t *psDemux,
+                                           const uint32_t *pui32InSampleBuffer,
+                                           uint32_t ui32NumSamples,
+                                           uint32_t *pui32TriggerMask);
+
   //*****************************************************************************
   //
   //! @brief ADC FIFO trigger function
@@ -138,11 +138,6 @@ am_hal_ble_state_t g_sBLEState[AM_REG_BLEIF_NUM_MODULES];
 // Static function prototypes.
 //
 //*****************************************************************************
-#if 0
-static void am_hal_ble_fifo_write(void *pHandle, uint32_t *pui32Data, uint32_t ui32NumBytes);
-static uint32_t am_hal_ble_fifo_fill(void *pHandle);
-static bool am_hal_ble_lock_and_check_status(am_hal_ble_state_t *pBle);
-#endif
 static bool am_hal_ble_bus_lock(am_hal_ble_state_t *pBle);
 static void am_hal_ble_bus_release(am_hal_ble_state_t *pBle);
 static uint32_t am_hal_ble_fifo_drain(void *pHandle);
@@ -153,6 +148,7 @@ static uint32_t am_hal_ble_cmd_write(void *pHandle, am_hal_ble_transfer_t *psTra
 static uint32_t am_hal_ble_load_modex_trim_set(void *pHandle);
 static uint32_t nonblocking_write(am_hal_ble_state_t *pBle, am_hal_ble_transfer_t *psTransfer);
 static uint32_t nonblocking_read(am_hal_ble_state_t *pBle, am_hal_ble_transfer_t *psTransfer);
+static void hci_read_body(am_hal_ble_state_t *pBle);
 static uint8_t am_hal_ble_read_trimdata_from_info1(void);
 
 //*****************************************************************************
@@ -383,6 +379,7 @@ am_hal_ble_initialize(uint32_t ui32Module, void **ppHandle)
     g_sBLEState[ui32Module].bCmdComplete = 0;
     g_sBLEState[ui32Module].bDmaComplete = 0;
     g_sBLEState[ui32Module].bFlowControlComplete = 0;
+    g_sBLEState[ui32Module].bHciReadLength = false;
     g_sBLEState[ui32Module].bUseDefaultPatches = false;
 
     //
@@ -431,6 +428,7 @@ am_hal_ble_deinitialize(void *pHandle)
     pBLE->bCmdComplete = 0;
     pBLE->bDmaComplete = 0;
     pBLE->bFlowControlComplete = 0;
+    pBLE->bHciReadLength = false;
 
     //
     // Return the status.
@@ -1595,7 +1593,8 @@ am_hal_ble_nonblocking_hci_write(void *pHandle, uint8_t ui8Type,
 
 //*****************************************************************************
 //
-// Returns the number of bytes received.
+// Start a nonblocking HCI read. Only the length is read here; the body is
+// started from am_hal_ble_int_service().
 //
 //*****************************************************************************
 uint32_t
@@ -1606,19 +1605,17 @@ am_hal_ble_nonblocking_hci_read(void *pHandle, uint32_t *pui32Data,
     uint32_t ui32Status;
     am_hal_ble_state_t *pBle = pHandle;
 
-    am_hal_ble_buffer(2) sLengthBytes;
-
     am_hal_ble_transfer_t HciRead =
     {
-        .pui32Data = sLengthBytes.words,
+        .pui32Data = 0x0,
         .pui8Offset = {0x0, 0x0, 0x0},
         .ui8OffsetLen = 0,
         .ui16Length = 2,
         .ui8Command = AM_HAL_BLE_READ,
         .ui8RepeatCount = 0,
         .bContinue = false,
-        .pfnTransferCompleteCB = pfnCallback,
-        .pvContext = pvContext,
+        .pfnTransferCompleteCB = 0x0,
+        .pvContext = 0x0,
     };
 
     //
@@ -1632,33 +1629,73 @@ am_hal_ble_nonblocking_hci_read(void *pHandle, uint32_t *pui32Data,
     //
     // Make sure the IRQ signal is set.
     //
-    if ( am_hal_ble_check_irq(pBle) )
+    if ( !am_hal_ble_check_irq(pBle) )
     {
-        //
-        // Read the length bytes.
-        //
-        ui32Status = am_hal_ble_blocking_transfer(pHandle, &HciRead);
+        return AM_HAL_STATUS_FAIL;
+    }
 
-        if ( ui32Status != AM_HAL_STATUS_SUCCESS )
-        {
-            return ui32Status;
-        }
+    //
+    // Read the length bytes. The BLE interrupt takes it from there.
+    //
+    HciRead.pui32Data = pBle->sHciReadLength.words;
 
-        //
-        // Read the rest of the packet.
-        //
-        HciRead.pfnTransferCompleteCB = pfnCallback;
-        HciRead.pui32Data = pui32Data;
-        HciRead.ui16Length = (sLengthBytes.bytes[0] +
-                              (sLengthBytes.bytes[1] << 8));
+    AM_CRITICAL_BEGIN;
 
-        return am_hal_ble_nonblocking_transfer(pHandle, &HciRead);
+    ui32Status = nonblocking_read(pBle, &HciRead);
+
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        pBle->bHciReadLength = true;
+        pBle->pui32HciReadData = pui32Data;
+        pBle->pfnHciReadCB = pfnCallback;
+        pBle->pvHciReadContext = pvContext;
     }
 
+    AM_CRITICAL_END;
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// The length of a nonblocking HCI read is in. Start reading the body, or end
+// the read with a length of zero if there's nothing sensible to read.
+//
+//*****************************************************************************
+static void
+hci_read_body(am_hal_ble_state_t *pBle)
+{
+    uint32_t ui32Status = AM_HAL_STATUS_FAIL;
+
+    am_hal_ble_transfer_t HciRead =
+    {
+        .pui32Data = pBle->pui32HciReadData,
+        .pui8Offset = {0x0, 0x0, 0x0},
+        .ui8OffsetLen = 0,
+        .ui16Length = (pBle->sHciReadLength.bytes[0] +
+                       (pBle->sHciReadLength.bytes[1] << 8)),
+        .ui8Command = AM_HAL_BLE_READ,
+        .ui8RepeatCount = 0,
+        .bContinue = false,
+        .pfnTransferCompleteCB = pBle->pfnHciReadCB,
+        .pvContext = pBle->pvHciReadContext,
+    };
+
+    pBle->bHciReadLength = false;
+
     //
-    // If we get here, return fail.
+    // Same limit as the blocking read.
     //
-    return AM_HAL_STATUS_FAIL;
+    if ((HciRead.ui16Length != 0) && (HciRead.ui16Length <= 256))
+    {
+        ui32Status = nonblocking_read(pBle, &HciRead);
+    }
+
+    if ((ui32Status != AM_HAL_STATUS_SUCCESS) && HciRead.pfnTransferCompleteCB)
+    {
+        HciRead.pfnTransferCompleteCB((uint8_t *) HciRead.pui32Data, 0,
+                                      HciRead.pvContext);
+    }
 }
 
 //*****************************************************************************
@@ -1918,12 +1955,6 @@ am_hal_ble_blocking_transfer(void *pHandle, am_hal_ble_transfer_t *psTransfer)
     //
     if (psTransfer->ui8Command == AM_HAL_BLE_WRITE)
     {
-#if 0   // 0 for FIFO handling with IOM hal style
-        while (pBle->ui32TransferIndex < pBle->sCurrentTransfer.ui16Length)
-        {
-            am_hal_ble_fifo_fill(pHandle);
-        }
-#else   // 0 for FIFO handling with IOM hal style
         bool bCmdCmp = false;
         uint32_t numWait = 0;
         // Adjust the byte count to be sent/received for repeat count
@@ -1983,7 +2014,6 @@ am_hal_ble_blocking_transfer(void *pHandle, am_hal_ble_transfer_t *psTransfer)
                 }
             }
         }
-#endif //0 for FIFO handling with IOM hal style
     }
     else
     {
@@ -2144,9 +2174,12 @@ nonblocking_write(am_hal_ble_state_t *pBle, am_hal_ble_transfer_t *psTransfer)
 
         //
         // With the obvious error cases out of the way, we can claim the bus and
-        // start the transaction.
+        // start the transaction. Parts that wait for the STATUS falling edge
+        // before completing a write have already given the controller its
+        // spacing.
         //
-        if ( pBle->bLastPacketWasTX == true )
+        if ( (pBle->bLastPacketWasTX == true) &&
+             (!APOLLO3_GE_B0 || SKIP_FALLING_EDGES) )
         {
             delay_us(AM_BLE_TX_PACKET_SPACING_US);
         }
@@ -2233,9 +2266,12 @@ nonblocking_read(am_hal_ble_state_t *pBle, am_hal_ble_transfer_t *psTransfer)
 
         //
         // With the obvious error cases out of the way, we can claim the bus and
-        // start the transaction.
+        // start the transaction. Parts that wait for the STATUS falling edge
+        // before completing a write have already given the controller its
+        // spacing.
         //
-        if ( pBle->bLastPacketWasTX == true )
+        if ( (pBle->bLastPacketWasTX == true) &&
+             (!APOLLO3_GE_B0 || SKIP_FALLING_EDGES) )
         {
             delay_us(AM_BLE_TX_PACKET_SPACING_US);
         }
@@ -2271,135 +2307,6 @@ nonblocking_read(am_hal_ble_state_t *pBle, am_hal_ble_transfer_t *psTransfer)
     return ui32Status;
 }
 
-#if 0
-//*****************************************************************************
-//
-// Write ui32NumBytes to the TX FIFO.
-//
-//*****************************************************************************
-static void
-am_hal_ble_fifo_write(void *pHandle, uint32_t *pui32Data, uint32_t ui32NumBytes)
-{
-    uint32_t ui32Index;
-    uint32_t ui32Module = ((am_hal_ble_state_t *) pHandle)->ui32Module;
-
-    for (ui32Index = 0; (ui32Index * 4) < ui32NumBytes; ui32Index++)
-    {
-        BLEIFn(ui32Module)->FIFOPUSH = pui32Data[ui32Index];
-    }
-
-    // we need to have 10us delay to not overwrite FIFO.
-    delay_us(10);
-}
-
-//*****************************************************************************
-//
-// Refill the fifo for transmit.
-//
-//*****************************************************************************
-static uint32_t
-am_hal_ble_fifo_fill(void *pHandle)
-{
-    uint32_t ui32Module;
-    uint32_t ui32FifoFillSize, ui32Space, ui32BytesLeft;
-    uint32_t *pSrc;
-
-    //
-    // Check the handle.
-    //
-    if (!AM_HAL_BLE_CHK_HANDLE(pHandle))
-    {
-        return 0;
-    }
-
-    //
-    // Handle is good, so get the module number.
-    //
-    ui32Module = ((am_hal_ble_state_t *) pHandle)->ui32Module;
-
-    //
-    // Rename some pointers for convenience.
-    //
-    am_hal_ble_state_t *pBle = pHandle;
-    am_hal_ble_transfer_t *pTransfer = &pBle->sCurrentTransfer;
-
-    //
-    // Check to see how much space there is in the FIFO, and also how many
-    // bytes are remaining in the transfer.
-    //
-    ui32Space = BLEIFn(ui32Module)->FIFOPTR_b.FIFO0REM;
-    ui32BytesLeft = (pTransfer->ui16Length - pBle->ui32TransferIndex);
-
-    //
-    // Calculate how much we can fill the fifo. If our data doesn't all fit
-    // right now, fill up the fifo as much as we can, up to the closest
-    // multiple of 4.
-    //
-    if (ui32Space == 0)
-    {
-        return 0;
-    }
-    else if (ui32Space >= ui32BytesLeft)
-    {
-        ui32FifoFillSize = ui32BytesLeft;
-    }
-    else
-    {
-        ui32FifoFillSize = ui32Space & (~0x3);
-    }
-
-    //
-    // Calculate the place where we last left off, feed the FIFO starting from
-    // that location, and update the index to match.
-    //
-    pSrc = &pTransfer->pui32Data[pBle->ui32TransferIndex / 4];
-
-    am_hal_ble_fifo_write(pHandle, pSrc, ui32FifoFillSize);
-
-    pBle->ui32TransferIndex += ui32FifoFillSize;
-
-    //
-    // Return the number of bytes we wrote.
-    //
-    return ui32FifoFillSize;
-}
-
-//*****************************************************************************
-//
-// Mark the BLE interface busy so it doesn't get used by more than one
-// interface.
-//
-//*****************************************************************************
-static bool
-am_hal_ble_lock_and_check_status(am_hal_ble_state_t *pBle)
-{
-    bool bLockObtained = false;
-
-    //
-    // In one atomic sweep, check to see if the bus is busy, and reserve it if
-    // it isn't.
-    //
-    AM_CRITICAL_BEGIN;
-
-    BLEIFn(0)->BLEDBG_b.IOCLKON = 1;
-    delay_us(5);
-
-    if ( am_hal_ble_check_status(pBle) && am_hal_ble_bus_lock(pBle) )
-    {
-        bLockObtained = true;
-    }
-
-    BLEIFn(0)->BLEDBG_b.IOCLKON = 0;
-
-    AM_CRITICAL_END;
-
-    //
-    // Tell the caller if we successfully locked the bus.
-    //
-    return bLockObtained;
-}
-#endif
-
 //*****************************************************************************
 //
 // Mark the BLE interface busy so it doesn't get used by more than one
@@ -2682,10 +2589,12 @@ am_hal_ble_int_service(void *pHandle, uint32_t ui32Status)
     // For revision A parts, "command complete" means that the DMA operation
     // and the BLE SPI interface have both finished their operations. For rev B
     // parts, we will also wait for the flow control signal (either STATUS or
-    // IRQ) to be removed.
+    // IRQ) to be removed. IRQ stays up after the length bytes of an HCI read,
+    // so that phase doesn't wait for it.
     //
     if ( pBle->bCmdComplete && pBle->bDmaComplete &&
-         ((pBle->bFlowControlComplete) || (!APOLLO3_GE_B0) || SKIP_FALLING_EDGES) )
+         ((pBle->bFlowControlComplete) || (!APOLLO3_GE_B0) || SKIP_FALLING_EDGES ||
+          pBle->bHciReadLength) )
     {
         //
         // Clean up our state flags.
@@ -2729,7 +2638,14 @@ am_hal_ble_int_service(void *pHandle, uint32_t ui32Status)
 
         am_hal_ble_bus_release(pBle);
 
-        if ( pBle->sCurrentTransfer.pfnTransferCompleteCB )
+        //
+        // Go straight on to the body of an HCI read.
+        //
+        if ( pBle->bHciReadLength )
+        {
+            hci_read_body(pBle);
+        }
+        else if ( pBle->sCurrentTransfer.pfnTransferCompleteCB )
         {
             am_hal_ble_transfer_complete_cb_t pfnCallback;
             uint32_t ui32Length;
@@ -391,6 +391,17 @@ typedef struct
 
     // Has the BLE core's flow control signal been reset?
     bool bFlowControlComplete;
+
+    // Is the current transfer the length phase of a nonblocking HCI read?
+    bool bHciReadLength;
+
+    // Length bytes of the HCI packet being read.
+    am_hal_ble_buffer(2) sHciReadLength;
+
+    // Destination and completion callback for the HCI packet body.
+    uint32_t *pui32HciReadData;
+    am_hal_ble_transfer_complete_cb_t pfnHciReadCB;
+    void *pvHciReadContext;
 }
 am_hal_ble_state_t;
 
@@ -671,6 +682,24 @@ extern uint32_t am_hal_ble_blocking_hci_write(void *pHandle,
                                               uint32_t *pui32Data,
                                               uint32_t ui32NumBytes);
 
+//*****************************************************************************
+//
+//! @brief Read an HCI packet from the BLE core without blocking.
+//!
+//! @param pHandle - Handle for the BLE module.
+//! @param pui32Data - Buffer for the packet, at least 256 bytes.
+//! @param pfnCallback - Called from am_hal_ble_int_service() when done.
+//! @param pvContext - Passed to the callback.
+//!
+//! BLEIRQ must be high. The 2-byte packet length and the packet body are both
+//! read by DMA, and the body is started from am_hal_ble_int_service() once the
+//! length is in, so the CMDCMP and DCMP interrupts must be enabled. If the
+//! length is zero or over 256 bytes nothing more is read and the callback is
+//! given a length of zero.
+//!
+//! @return BLE status code.
+//
+//*****************************************************************************
 extern uint32_t am_hal_ble_nonblocking_hci_read(void *pHandle,
                                                 uint32_t *pui32Data,
                                                 am_hal_ble_transfer_complete_cb_t pfnCallback,
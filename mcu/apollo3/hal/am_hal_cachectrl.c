@@ -450,6 +450,32 @@ am_hal_cachectrl_status_get(am_hal_cachectrl_status_t *psStatus)
 
 } // am_hal_cachectrl_status_get()
 
+//*****************************************************************************
+//
+//  Cache monitor read function
+//
+//*****************************************************************************
+uint32_t
+am_hal_cachectrl_monitor_get(am_hal_cachectrl_monitor_t *psMonitor)
+{
+    if ( psMonitor == NULL )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    psMonitor->ui32DataAccesses  = CACHECTRL->DMON0;
+    psMonitor->ui32DataLookups   = CACHECTRL->DMON1;
+    psMonitor->ui32DataHits      = CACHECTRL->DMON2;
+    psMonitor->ui32DataLineHits  = CACHECTRL->DMON3;
+    psMonitor->ui32InstrAccesses = CACHECTRL->IMON0;
+    psMonitor->ui32InstrLookups  = CACHECTRL->IMON1;
+    psMonitor->ui32InstrHits     = CACHECTRL->IMON2;
+    psMonitor->ui32InstrLineHits = CACHECTRL->IMON3;
+
+    return AM_HAL_STATUS_SUCCESS;
+
+} // am_hal_cachectrl_monitor_get()
+
 
 //*****************************************************************************
 //
@@ -71,6 +71,22 @@ typedef struct
     bool     bCacheReady;
 } am_hal_cachectrl_status_t;
 
+//
+// Cache monitor counters.  The counters run while the monitor is enabled
+// (AM_HAL_CACHECTRL_CONTROL_MONITOR_ENABLE) and wrap at 32 bits.
+//
+typedef struct
+{
+    uint32_t ui32DataAccesses;
+    uint32_t ui32DataLookups;
+    uint32_t ui32DataHits;
+    uint32_t ui32DataLineHits;
+    uint32_t ui32InstrAccesses;
+    uint32_t ui32InstrLookups;
+    uint32_t ui32InstrHits;
+    uint32_t ui32InstrLineHits;
+} am_hal_cachectrl_monitor_t;
+
 // ****************************************************************************
 //
 //! @name Cache Config
@@ -282,6 +298,20 @@ extern uint32_t am_hal_cachectrl_control(am_hal_cachectrl_control_e eControl,
 // ****************************************************************************
 extern uint32_t am_hal_cachectrl_status_get(am_hal_cachectrl_status_t *psStatus);
 
+// ****************************************************************************
+//
+//! @brief Cache monitor read function
+//!
+//! This function returns a snapshot of the cache hit/miss monitor counters.
+//! A lookup that does not hit is a miss that was serviced from flash.
+//!
+//! @param psMonitor - ptr to a structure to receive the counters.
+//!
+//! @return status      - generic or interface specific status.
+//
+// ****************************************************************************
+extern uint32_t am_hal_cachectrl_monitor_get(am_hal_cachectrl_monitor_t *psMonitor);
+
 #ifdef __cplusplus
 }
 #endif
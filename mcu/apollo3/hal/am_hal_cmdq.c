@@ -98,6 +98,7 @@ typedef struct
     uint32_t                bitMaskCQStatTIP;
     uint32_t                bitMaskCQStatErr;
     uint32_t                bitMaskCQStatPaused;
+    volatile uint32_t*      regCQSetClr;
 } am_hal_cmdq_registers_t;
 
 typedef struct
@@ -126,7 +127,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &IOM0->CQCURIDX,        &IOM0->CQENDIDX,
         &IOM0->CQPAUSEEN,       IOM0_CQPAUSEEN_CQPEN_IDXEQ,
         &IOM0->CQSTAT,          IOM0_CQSTAT_CQTIP_Msk,
-        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk
+        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk,
+        &IOM0->CQSETCLEAR
     },
     // AM_HAL_CMDQ_IF_IOM1
     {
@@ -134,7 +136,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &IOM1->CQCURIDX,        &IOM1->CQENDIDX,
         &IOM1->CQPAUSEEN,       IOM0_CQPAUSEEN_CQPEN_IDXEQ,
         &IOM1->CQSTAT,          IOM0_CQSTAT_CQTIP_Msk,
-        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk
+        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk,
+        &IOM1->CQSETCLEAR
     },
     // AM_HAL_CMDQ_IF_IOM2
     {
@@ -142,7 +145,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &IOM2->CQCURIDX,        &IOM2->CQENDIDX,
         &IOM2->CQPAUSEEN,       IOM0_CQPAUSEEN_CQPEN_IDXEQ,
         &IOM2->CQSTAT,          IOM0_CQSTAT_CQTIP_Msk,
-        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk
+        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk,
+        &IOM2->CQSETCLEAR
     },
     // AM_HAL_CMDQ_IF_IOM3
     {
@@ -150,7 +154,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &IOM3->CQCURIDX,        &IOM3->CQENDIDX,
         &IOM3->CQPAUSEEN,       IOM0_CQPAUSEEN_CQPEN_IDXEQ,
         &IOM3->CQSTAT,          IOM0_CQSTAT_CQTIP_Msk,
-        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk
+        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk,
+        &IOM3->CQSETCLEAR
         },
     // AM_HAL_CMDQ_IF_IOM4
     {
@@ -158,7 +163,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &IOM4->CQCURIDX,        &IOM4->CQENDIDX,
         &IOM4->CQPAUSEEN,       IOM0_CQPAUSEEN_CQPEN_IDXEQ,
         &IOM4->CQSTAT,          IOM0_CQSTAT_CQTIP_Msk,
-        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk
+        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk,
+        &IOM4->CQSETCLEAR
     },
     // AM_HAL_CMDQ_IF_IOM5
     {
@@ -166,7 +172,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &IOM5->CQCURIDX,        &IOM5->CQENDIDX,
         &IOM5->CQPAUSEEN,       IOM0_CQPAUSEEN_CQPEN_IDXEQ,
         &IOM5->CQSTAT,          IOM0_CQSTAT_CQTIP_Msk,
-        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk
+        IOM0_CQSTAT_CQERR_Msk,  IOM0_CQSTAT_CQPAUSED_Msk,
+        &IOM5->CQSETCLEAR
     },
     // AM_HAL_CMDQ_IF_MSPI
     {
@@ -174,7 +181,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &MSPI->CQCURIDX,        &MSPI->CQENDIDX,
         &MSPI->CQPAUSE,         MSPI_CQPAUSE_CQMASK_CQIDX,
         &MSPI->CQSTAT,          MSPI_CQSTAT_CQTIP_Msk,
-        MSPI_CQSTAT_CQERR_Msk,  MSPI_CQSTAT_CQPAUSED_Msk
+        MSPI_CQSTAT_CQERR_Msk,  MSPI_CQSTAT_CQPAUSED_Msk,
+        &MSPI->CQSETCLEAR
     },
     // AM_HAL_CMDQ_IF_BLEIF
     {
@@ -182,7 +190,8 @@ static const am_hal_cmdq_registers_t gAmHalCmdQReg[AM_HAL_CMDQ_IF_MAX] =
         &BLEIF->CQCURIDX,       &BLEIF->CQENDIDX,
         &BLEIF->CQPAUSEEN,      BLEIF_CQPAUSEEN_CQPEN_CNTEQ,
         &BLEIF->CQSTAT,         BLEIF_CQSTAT_CQTIP_Msk,
-        BLEIF_CQSTAT_CQERR_Msk, BLEIF_CQSTAT_CQPAUSED_Msk
+        BLEIF_CQSTAT_CQERR_Msk, BLEIF_CQSTAT_CQPAUSED_Msk,
+        &BLEIF->CQSETCLEAR
     },
 };
 
@@ -845,3 +854,220 @@ uint32_t am_hal_cmdq_post_loop_block(void *pHandle, bool bInt)
     AM_REGVAL(pCmdQ->pReg->regEndIdx) = pCmdQ->endIdx & AM_HAL_CMDQ_HW_IDX_MAX;
     return AM_HAL_STATUS_SUCCESS;
 }
+
+//*****************************************************************************
+//
+// Append one entry to a CQ program, tracking overflow.
+//
+//*****************************************************************************
+static am_hal_cmdq_entry_t *
+prog_append(am_hal_cmdq_prog_t *pProg, uint32_t address, uint32_t value)
+{
+    am_hal_cmdq_entry_t *pEntry = NULL;
+
+    if (pProg->pEntries)
+    {
+        if (pProg->numEntries < pProg->maxEntries)
+        {
+            pEntry = &pProg->pEntries[pProg->numEntries];
+            pEntry->address = address;
+            pEntry->value = value;
+        }
+        else if (pProg->status == AM_HAL_STATUS_SUCCESS)
+        {
+            pProg->status = AM_HAL_STATUS_OUT_OF_RANGE;
+        }
+    }
+    pProg->numEntries++;
+    return pEntry;
+}
+
+//*****************************************************************************
+//
+//! @brief  Start building a Command Queue program
+//!
+//! A program is a list of CQ entries built in caller memory, run by one
+//! interface's CQ.  Programs on different interfaces hand off to each other
+//! through the linked CQ flags (e.g. AM_HAL_MSPI_REQ_LINK_IOM) using
+//! am_hal_cmdq_prog_signal() and am_hal_cmdq_prog_wait().
+//!
+//! Passing a NULL buffer builds nothing and only counts entries, so the same
+//! build code can be run once to size the buffer.
+//!
+//! @param  pProg Program being built
+//! @param  hwIf Interface whose CQ will run the program
+//! @param  pBuf Entry buffer, or NULL to size the program
+//! @param  maxEntries Size of pBuf in entries (8 bytes each)
+//!
+//! @return Returns 0 on success
+//
+//*****************************************************************************
+uint32_t am_hal_cmdq_prog_init(am_hal_cmdq_prog_t *pProg, am_hal_cmdq_if_e hwIf,
+                               am_hal_cmdq_entry_t *pBuf, uint32_t maxEntries)
+{
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if (!pProg)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+    if (hwIf >= AM_HAL_CMDQ_IF_MAX)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+    pProg->hwIf = hwIf;
+    pProg->pEntries = pBuf;
+    pProg->maxEntries = pBuf ? maxEntries : 0;
+    pProg->numEntries = 0;
+    pProg->status = AM_HAL_STATUS_SUCCESS;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief  Add a register write to a CQ program
+//!
+//! @param  pProg Program being built
+//! @param  address Register address (word aligned)
+//! @param  value Value to write
+//
+//*****************************************************************************
+void am_hal_cmdq_prog_write(am_hal_cmdq_prog_t *pProg, uint32_t address, uint32_t value)
+{
+    if ((address == 0) || (address & 0x3))
+    {
+        pProg->status = AM_HAL_STATUS_INVALID_ARG;
+    }
+    prog_append(pProg, address, value);
+}
+
+//*****************************************************************************
+//
+//! @brief  Add a prebuilt block of entries to a CQ program
+//!
+//! @param  pProg Program being built
+//! @param  pBlock Entries to copy
+//! @param  numEntries Number of entries in pBlock
+//
+//*****************************************************************************
+void am_hal_cmdq_prog_block(am_hal_cmdq_prog_t *pProg,
+                            const am_hal_cmdq_entry_t *pBlock, uint32_t numEntries)
+{
+    uint32_t i;
+
+    for (i = 0; i < numEntries; i++)
+    {
+        prog_append(pProg, pBlock[i].address, pBlock[i].value);
+    }
+}
+
+//*****************************************************************************
+//
+//! @brief  Gate a CQ program on flags
+//!
+//! The CQ stalls at this point while any of the flags is in its pausing
+//! state (set for IOM and BLEIF, clear for MSPI).  The index pause is kept
+//! enabled across the gate.
+//!
+//! @param  pProg Program being built
+//! @param  flags Pause enable mask
+//
+//*****************************************************************************
+void am_hal_cmdq_prog_wait(am_hal_cmdq_prog_t *pProg, uint32_t flags)
+{
+    const am_hal_cmdq_registers_t *pReg = &gAmHalCmdQReg[pProg->hwIf];
+
+    prog_append(pProg, (uint32_t)pReg->regCQPause, pReg->bitMaskCQPauseIdx | flags);
+    prog_append(pProg, (uint32_t)pReg->regCQPause, pReg->bitMaskCQPauseIdx);
+}
+
+//*****************************************************************************
+//
+//! @brief  Set or clear CQ flags from a CQ program
+//!
+//! @param  pProg Program being built
+//! @param  setClr Value for the interface's CQSETCLEAR register
+//
+//*****************************************************************************
+void am_hal_cmdq_prog_signal(am_hal_cmdq_prog_t *pProg, uint32_t setClr)
+{
+    prog_append(pProg, (uint32_t)gAmHalCmdQReg[pProg->hwIf].regCQSetClr, setClr);
+}
+
+//*****************************************************************************
+//
+//! @brief  Get a label for the next entry of a CQ program
+//!
+//! @param  pProg Program being built
+//!
+//! @return Label usable with am_hal_cmdq_prog_jump()
+//
+//*****************************************************************************
+uint32_t am_hal_cmdq_prog_label(am_hal_cmdq_prog_t *pProg)
+{
+    return pProg->numEntries;
+}
+
+//*****************************************************************************
+//
+//! @brief  Jump back to a label in a CQ program
+//!
+//! Used to build loops.  Only labels already emitted are valid targets.
+//!
+//! @param  pProg Program being built
+//! @param  label Value returned by am_hal_cmdq_prog_label()
+//
+//*****************************************************************************
+void am_hal_cmdq_prog_jump(am_hal_cmdq_prog_t *pProg, uint32_t label)
+{
+    if (label >= pProg->numEntries)
+    {
+        pProg->status = AM_HAL_STATUS_INVALID_ARG;
+    }
+    prog_append(pProg, (uint32_t)gAmHalCmdQReg[pProg->hwIf].regCQAddr,
+                pProg->pEntries ? (uint32_t)&pProg->pEntries[label] : 0);
+}
+
+//*****************************************************************************
+//
+//! @brief  End a CQ program with a jump to be patched later
+//!
+//! The returned pointer is the jump target, suitable as pJmpAddr of
+//! AM_HAL_IOM_REQ_CQ_RAW or AM_HAL_MSPI_REQ_CQ_RAW so the driver can return
+//! to its own queue.
+//!
+//! @param  pProg Program being built
+//!
+//! @return Pointer to the jump target, NULL when sizing or on overflow
+//
+//*****************************************************************************
+uint32_t *am_hal_cmdq_prog_exit(am_hal_cmdq_prog_t *pProg)
+{
+    am_hal_cmdq_entry_t *pEntry;
+
+    pEntry = prog_append(pProg, (uint32_t)gAmHalCmdQReg[pProg->hwIf].regCQAddr, 0);
+    return pEntry ? &pEntry->value : NULL;
+}
+
+//*****************************************************************************
+//
+//! @brief  Finish a CQ program
+//!
+//! @param  pProg Program being built
+//! @param  pNumEntries Return parameter - entries used (or needed when sizing)
+//!
+//! @return Returns 0 if the program is complete and valid
+//
+//*****************************************************************************
+uint32_t am_hal_cmdq_prog_end(am_hal_cmdq_prog_t *pProg, uint32_t *pNumEntries)
+{
+    if (pNumEntries)
+    {
+        *pNumEntries = pProg->numEntries;
+    }
+    if ((pProg->status == AM_HAL_STATUS_SUCCESS) && (pProg->numEntries == 0))
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+    return pProg->status;
+}
@@ -85,6 +85,19 @@ typedef struct
     uint32_t    value;
 } am_hal_cmdq_entry_t;
 
+//
+// Command Queue program under construction.
+// See am_hal_cmdq_prog_init().
+//
+typedef struct
+{
+    am_hal_cmdq_if_e        hwIf;
+    am_hal_cmdq_entry_t     *pEntries;
+    uint32_t                maxEntries;
+    uint32_t                numEntries;
+    uint32_t                status;
+} am_hal_cmdq_prog_t;
+
 typedef struct
 {
     uint32_t    lastIdxProcessed;
@@ -279,4 +292,32 @@ uint32_t am_hal_cmdq_reset(void *pHandle);
 //*****************************************************************************
 uint32_t am_hal_cmdq_post_loop_block(void *pHandle, bool bInt);
 
+//*****************************************************************************
+//
+// Command Queue program builder
+//
+// Builds a CQ program (loops, flag gates, register writes, hand-offs between
+// linked interfaces) in caller memory, to be entered through the CQ_RAW
+// request of the IOM or MSPI driver.  For example, an MSPI program reads
+// flash into a buffer then signals the IOM, while an IOM program waits on
+// that flag and writes the buffer to a display, each looping back with
+// am_hal_cmdq_prog_jump().
+//
+// Run the build once with a NULL buffer to get the number of entries needed.
+// Errors (overflow, bad address, bad label) are latched and reported by
+// am_hal_cmdq_prog_end().
+//
+//*****************************************************************************
+uint32_t am_hal_cmdq_prog_init(am_hal_cmdq_prog_t *pProg, am_hal_cmdq_if_e hwIf,
+                               am_hal_cmdq_entry_t *pBuf, uint32_t maxEntries);
+void am_hal_cmdq_prog_write(am_hal_cmdq_prog_t *pProg, uint32_t address, uint32_t value);
+void am_hal_cmdq_prog_block(am_hal_cmdq_prog_t *pProg,
+                            const am_hal_cmdq_entry_t *pBlock, uint32_t numEntries);
+void am_hal_cmdq_prog_wait(am_hal_cmdq_prog_t *pProg, uint32_t flags);
+void am_hal_cmdq_prog_signal(am_hal_cmdq_prog_t *pProg, uint32_t setClr);
+uint32_t am_hal_cmdq_prog_label(am_hal_cmdq_prog_t *pProg);
+void am_hal_cmdq_prog_jump(am_hal_cmdq_prog_t *pProg, uint32_t label);
+uint32_t *am_hal_cmdq_prog_exit(am_hal_cmdq_prog_t *pProg);
+uint32_t am_hal_cmdq_prog_end(am_hal_cmdq_prog_t *pProg, uint32_t *pNumEntries);
+
 #endif // AM_HAL_CMDQ_H
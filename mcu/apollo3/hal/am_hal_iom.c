@@ -161,7 +161,9 @@ typedef struct
     uint32_t                    ui32SETCLRVal;
 } am_hal_iom_cq_loop_entry_t;
 
-#define AM_HAL_IOM_MAX_PENDING_TRANSACTIONS      256 // Must be power of 2 for the implementation below
+// Upper bound on the pending transaction ring carved from pNBTxnBuf.
+// Must be power of 2 for the implementation below
+#define AM_HAL_IOM_MAX_PENDING_TRANSACTIONS      256
 #define AM_HAL_IOM_CQUPD_INT_FLAG                (0x00000001)
 
 typedef struct
@@ -224,9 +226,10 @@ typedef struct
     volatile uint32_t       ui32NumPendTransactions;
     //
     // Stores the CQ callbacks.
+    // These point into the tail of pNBTxnBuf, ui32MaxTransactions deep.
     //
-    am_hal_iom_callback_t   pfnCallback[AM_HAL_IOM_MAX_PENDING_TRANSACTIONS];
-    void                    *pCallbackCtxt[AM_HAL_IOM_MAX_PENDING_TRANSACTIONS];
+    am_hal_iom_callback_t   *pfnCallback;
+    void                    **pCallbackCtxt;
 #if (AM_HAL_IOM_CQ == 1)
     void                    *pCmdQHdl;
     // To support sequence
@@ -272,6 +275,85 @@ am_hal_iom_state_t          g_IOMhandles[AM_REG_IOM_NUM_MODULES];
 // Internal Functions.
 //
 //*****************************************************************************
+
+//*****************************************************************************
+//
+// Carve the pending transaction callback ring out of the tail of the
+// caller supplied transaction buffer.
+//
+// The ring depth is the number of transactions (ui32TxnBytes each, plus one
+// callback and context) that fit in the buffer, capped at
+// AM_HAL_IOM_MAX_PENDING_TRANSACTIONS.  For CQ operation the CQ index is
+// masked into the ring, so the depth is a power of 2 instead: the one that
+// lets the most transactions be pending, with the rest of the buffer left to
+// the CQ.  The CQ then limits the pending count when it holds fewer than the
+// ring.
+//
+// Returns the number of words left at the head of the buffer.
+//
+//*****************************************************************************
+static uint32_t
+iom_callback_ring_init(am_hal_iom_state_t *pIOMState, uint32_t *pui32Buf,
+                       uint32_t ui32Length, uint32_t ui32TxnBytes, bool bPow2)
+{
+    uint32_t ui32SlotBytes = sizeof(am_hal_iom_callback_t) + sizeof(void *);
+    uint32_t ui32Bytes = ui32Length * 4;
+    uint32_t ui32Depth;
+    uint32_t ui32RingWords;
+
+    if (bPow2)
+    {
+        //
+        // Find the largest depth that leaves the CQ room for as many
+        // transactions, then take the next one up if the CQ would still have
+        // room for more than that.
+        //
+        ui32Depth = 1;
+        while ((ui32Depth < AM_HAL_IOM_MAX_PENDING_TRANSACTIONS) &&
+               (2 * ui32Depth * (ui32TxnBytes + ui32SlotBytes) <= ui32Bytes))
+        {
+            ui32Depth <<= 1;
+        }
+        if ((ui32Depth < AM_HAL_IOM_MAX_PENDING_TRANSACTIONS) &&
+            (2 * ui32Depth * ui32SlotBytes < ui32Bytes) &&
+            ((ui32Bytes - 2 * ui32Depth * ui32SlotBytes) / ui32TxnBytes > ui32Depth))
+        {
+            ui32Depth <<= 1;
+        }
+        if (ui32Depth * ui32SlotBytes + ui32TxnBytes > ui32Bytes)
+        {
+            ui32Depth = 0;
+        }
+    }
+    else
+    {
+        ui32Depth = ui32Bytes / (ui32TxnBytes + ui32SlotBytes);
+        if (ui32Depth > AM_HAL_IOM_MAX_PENDING_TRANSACTIONS)
+        {
+            ui32Depth = AM_HAL_IOM_MAX_PENDING_TRANSACTIONS;
+        }
+    }
+
+    pIOMState->ui32MaxTransactions = ui32Depth;
+    if (ui32Depth == 0)
+    {
+        pIOMState->pfnCallback = NULL;
+        pIOMState->pCallbackCtxt = NULL;
+        return ui32Length;
+    }
+
+    ui32RingWords = (ui32Depth * ui32SlotBytes + 3) / 4;
+    pIOMState->pfnCallback = (am_hal_iom_callback_t *)&pui32Buf[ui32Length - ui32RingWords];
+    pIOMState->pCallbackCtxt = (void **)&pIOMState->pfnCallback[ui32Depth];
+    for (uint32_t i = 0; i < ui32Depth; i++)
+    {
+        pIOMState->pfnCallback[i] = NULL;
+        pIOMState->pCallbackCtxt[i] = NULL;
+    }
+
+    return ui32Length - ui32RingWords;
+} // iom_callback_ring_init()
+
 static uint32_t
 get_pause_val(am_hal_iom_state_t *pIOMState, uint32_t pause)
 {
@@ -801,16 +883,26 @@ am_hal_iom_CQInit(void *pHandle, uint32_t ui32Length,
     uint32_t            ui32Status = AM_HAL_STATUS_SUCCESS;
 
     pIOMState->pCmdQHdl = NULL;
-    pIOMState->ui32MaxTransactions = 0;
+
+    //
+    // Each transaction uses its command list plus the CQ index update entry.
+    //
+    ui32Length = iom_callback_ring_init(pIOMState, pTCB, ui32Length,
+                                        sizeof(am_hal_iom_txn_cmdlist_t) + sizeof(am_hal_cmdq_entry_t),
+                                        true);
+    if (pIOMState->ui32MaxTransactions == 0)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
 
     cqCfg.pCmdQBuf = pTCB;
     cqCfg.cmdQSize = ui32Length / 2;
     cqCfg.priority = AM_HAL_CMDQ_PRIO_HI;
     ui32Status = am_hal_cmdq_init((am_hal_cmdq_if_e)(AM_HAL_CMDQ_IF_IOM0 + ui32Module),
                       &cqCfg, &pIOMState->pCmdQHdl);
-    if (ui32Status == AM_HAL_STATUS_SUCCESS)
+    if (ui32Status != AM_HAL_STATUS_SUCCESS)
     {
-        pIOMState->ui32MaxTransactions = AM_HAL_IOM_MAX_PENDING_TRANSACTIONS;
+        pIOMState->ui32MaxTransactions = 0;
     }
     return ui32Status;
 } // am_hal_iom_CQInit()
@@ -875,7 +967,7 @@ am_hal_iom_CQAddTransaction(void *pHandle,
     //
     // Check to see if there is enough room in the CQ
     //
-    if ((pIOMState->ui32NumPendTransactions == AM_HAL_IOM_MAX_PENDING_TRANSACTIONS) ||
+    if ((pIOMState->ui32NumPendTransactions == pIOMState->ui32MaxTransactions) ||
         (am_hal_cmdq_alloc_block(pIOMState->pCmdQHdl, sizeof(am_hal_iom_txn_cmdlist_t) / 8, &pCQBlock, &index)))
     {
         return AM_HAL_STATUS_OUT_OF_RANGE;
@@ -902,8 +994,8 @@ am_hal_iom_CQAddTransaction(void *pHandle,
     //
     // Store the callback function pointer.
     //
-    pIOMState->pfnCallback[index & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1)] = pfnCallback;
-    pIOMState->pCallbackCtxt[index & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1)] = pCallbackCtxt;
+    pIOMState->pfnCallback[index & (pIOMState->ui32MaxTransactions - 1)] = pfnCallback;
+    pIOMState->pCallbackCtxt[index & (pIOMState->ui32MaxTransactions - 1)] = pCallbackCtxt;
 
     return AM_HAL_STATUS_SUCCESS;
 } // am_hal_iom_CQAddTransaction()
@@ -1326,7 +1418,7 @@ am_hal_iom_initialize(uint32_t ui32Module, void **ppHandle)
 {
     // Compile time check to ensure ENTRY_SIZE macros are defined correctly
     // incorrect definition will cause divide by 0 error at build time
-    am_ct_assert((sizeof(am_hal_iom_txn_cmdlist_t) + 8) == AM_HAL_IOM_CQ_ENTRY_SIZE);
+    am_ct_assert((sizeof(am_hal_iom_txn_cmdlist_t) + 8 + 2 * (sizeof(am_hal_iom_callback_t) + sizeof(void *))) == AM_HAL_IOM_CQ_ENTRY_SIZE);
     am_ct_assert(sizeof(am_hal_iom_dma_entry_t) == AM_HAL_IOM_HIPRIO_ENTRY_SIZE);
 
 #ifndef AM_HAL_DISABLE_API_VALIDATION
@@ -1424,13 +1516,11 @@ am_hal_iom_enable(void *pHandle)
                                    pIOMState->pNBTxnBuf);
 #else
         // Determine the maximum number of transactions based on the memory provided
-        pIOMState->ui32MaxTransactions = pIOMState->ui32NBTxnBufLength * 4 / sizeof(am_hal_iom_txn_cmdlist_t);
+        iom_callback_ring_init(pIOMState, pIOMState->pNBTxnBuf,
+                               pIOMState->ui32NBTxnBufLength,
+                               sizeof(am_hal_iom_txn_cmdlist_t), false);
         if (pIOMState->ui32MaxTransactions > 0)
         {
-            if (pIOMState->ui32MaxTransactions > AM_HAL_IOM_MAX_PENDING_TRANSACTIONS)
-            {
-                pIOMState->ui32MaxTransactions = AM_HAL_IOM_MAX_PENDING_TRANSACTIONS;
-            }
             pIOMState->ui32NextIdx = pIOMState->ui32LastIdxProcessed + 1;
             pIOMState->pTransactions = (am_hal_iom_txn_cmdlist_t *)pIOMState->pNBTxnBuf;
         }
@@ -1814,7 +1904,7 @@ uint32_t am_hal_iom_interrupt_service(void *pHandle, uint32_t ui32IntMask)
             {
                 pIOMState->ui32LastIdxProcessed++;
                 pIOMState->ui32NumPendTransactions--;
-                index = pIOMState->ui32LastIdxProcessed & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1);
+                index = pIOMState->ui32LastIdxProcessed & (pIOMState->ui32MaxTransactions - 1);
                 if ( pIOMState->pfnCallback[index] != NULL )
                 {
                     pIOMState->pfnCallback[index](pIOMState->pCallbackCtxt[index], AM_HAL_STATUS_SUCCESS);
@@ -1836,7 +1926,7 @@ uint32_t am_hal_iom_interrupt_service(void *pHandle, uint32_t ui32IntMask)
                     // Need to determine the error, call the callback with proper status
                     pIOMState->ui32LastIdxProcessed++;
                     pIOMState->ui32NumPendTransactions--;
-                    index = pIOMState->ui32LastIdxProcessed & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1);
+                    index = pIOMState->ui32LastIdxProcessed & (pIOMState->ui32MaxTransactions - 1);
                     if ( pIOMState->pfnCallback[index] != NULL )
                     {
                         pIOMState->pfnCallback[index](pIOMState->pCallbackCtxt[index], internal_iom_get_int_err(ui32Module, ui32IntMask));
@@ -3255,6 +3345,15 @@ uint32_t am_hal_iom_control(void *pHandle, am_hal_iom_request_e eReq, void *pArg
                 return AM_HAL_STATUS_INVALID_OPERATION;
             }
 #endif // AM_HAL_DISABLE_API_VALIDATION
+            //
+            // The loop entry, and the loopback callback entry if there is
+            // one, each take a slot in the callback ring.
+            //
+            if ((pIOMState->ui32NumPendTransactions + (((pLoop->bLoop) && (!pIOMState->bAutonomous)) ? 2 : 1)) >
+                pIOMState->ui32MaxTransactions)
+            {
+                return AM_HAL_STATUS_OUT_OF_RANGE;
+            }
             if (pIOMState->block)
             {
                 // End the block if the sequence is ending
@@ -3277,8 +3376,8 @@ uint32_t am_hal_iom_control(void *pHandle, am_hal_iom_request_e eReq, void *pArg
                     //
                     // Store the callback function pointer.
                     //
-                    pIOMState->pfnCallback[index & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1)] = iom_seq_loopback;
-                    pIOMState->pCallbackCtxt[index & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1)] = (void *)pIOMState;
+                    pIOMState->pfnCallback[index & (pIOMState->ui32MaxTransactions - 1)] = iom_seq_loopback;
+                    pIOMState->pCallbackCtxt[index & (pIOMState->ui32MaxTransactions - 1)] = (void *)pIOMState;
 
                     // Dummy Entry
                     pCQBlock->address = (uint32_t)&IOMn(pIOMState->ui32Module)->CQSETCLEAR;
@@ -3466,7 +3565,7 @@ uint32_t am_hal_iom_control(void *pHandle, am_hal_iom_request_e eReq, void *pArg
             //
             // Check to see if there is enough room in the CQ
             //
-            if ((pIOMState->ui32NumPendTransactions == AM_HAL_IOM_MAX_PENDING_TRANSACTIONS) ||
+            if ((pIOMState->ui32NumPendTransactions == pIOMState->ui32MaxTransactions) ||
                 (am_hal_cmdq_alloc_block(pIOMState->pCmdQHdl, pCqRaw->numEntries + 3, &pCQBlock, &index)))
             {
                 return AM_HAL_STATUS_OUT_OF_RANGE;
@@ -3494,8 +3593,8 @@ uint32_t am_hal_iom_control(void *pHandle, am_hal_iom_request_e eReq, void *pArg
             //
             // Store the callback function pointer.
             //
-            pIOMState->pfnCallback[index & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1)] = pCqRaw->pfnCallback;
-            pIOMState->pCallbackCtxt[index & (AM_HAL_IOM_MAX_PENDING_TRANSACTIONS - 1)] = pCqRaw->pCallbackCtxt;
+            pIOMState->pfnCallback[index & (pIOMState->ui32MaxTransactions - 1)] = pCqRaw->pfnCallback;
+            pIOMState->pCallbackCtxt[index & (pIOMState->ui32MaxTransactions - 1)] = pCqRaw->pCallbackCtxt;
 
             //
             // Need to protect access of ui32NumPendTransactions as it is accessed
@@ -78,7 +78,10 @@
 #define AM_HAL_IOM_CQ                   1
 
 // Size guideline for allocation of application supploed buffers
-#define AM_HAL_IOM_CQ_ENTRY_SIZE               (24 * sizeof(uint32_t))
+// A CQ entry includes two slots of the pending transaction callback ring,
+// whose depth is rounded up to a power of 2.  A pNBTxnBuf of
+// AM_HAL_IOM_CQ_ENTRY_SIZE * (N + 1) bytes holds N pending transactions.
+#define AM_HAL_IOM_CQ_ENTRY_SIZE               (24 * sizeof(uint32_t) + 2 * (sizeof(am_hal_iom_callback_t) + sizeof(void *)))
 #define AM_HAL_IOM_HIPRIO_ENTRY_SIZE           (8 * sizeof(uint32_t))
 
 #define AM_HAL_IOM_SC_CLEAR(flag)              ((flag) << 16)
@@ -209,6 +212,8 @@ typedef struct
     // Non-Blocking transaction memory configuration
     // Set length and pointer to Transfer Control Buffer.
     // Length is in 4 byte multiples
+    // The tail of this buffer also holds the pending transaction callbacks,
+    // so it sets the maximum number of outstanding transactions.
     //
     uint32_t *pNBTxnBuf;
     uint32_t ui32NBTxnBufLength;
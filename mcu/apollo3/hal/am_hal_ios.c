@@ -608,6 +608,10 @@ uint32_t am_hal_ios_fifo_space_used(void *pHandle, uint32_t *pui32UsedSpace)
 //! This function returns the available space in the overall FIFO to accept
 //! new data. This takes into account the SRAM buffer and hardware FIFO
 //!
+//! Once the SRAM buffer holds data, am_hal_ios_fifo_write() appends behind it
+//! and cannot use the free space in the hardware FIFO, so only the free space
+//! in the SRAM buffer is reported.
+//!
 //! @return success or error code
 //
 //*****************************************************************************
@@ -634,12 +638,18 @@ uint32_t am_hal_ios_fifo_space_left(void *pHandle, uint32_t *pui32LeftSpace)
     //
     AM_CRITICAL_BEGIN
 
-    //
-    // We waste one byte in HW FIFO
-    //
-    ui32Val = g_sSRAMBuffer.ui32Capacity + ((am_hal_ios_state_t*)pHandle)->ui32HwFifoSize - 1;
-    ui32Val -= g_sSRAMBuffer.ui32Length;
-    ui32Val -= IOSLAVEn(ui32Module)->FIFOPTR_b.FIFOSIZ;
+    if ( g_sSRAMBuffer.ui32Length )
+    {
+        ui32Val = g_sSRAMBuffer.ui32Capacity - g_sSRAMBuffer.ui32Length;
+    }
+    else
+    {
+        //
+        // We waste one byte in HW FIFO
+        //
+        ui32Val = g_sSRAMBuffer.ui32Capacity + ((am_hal_ios_state_t*)pHandle)->ui32HwFifoSize - 1;
+        ui32Val -= IOSLAVEn(ui32Module)->FIFOPTR_b.FIFOSIZ;
+    }
 
     //
     // End the critical section
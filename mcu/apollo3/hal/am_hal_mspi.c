@@ -62,6 +62,8 @@
 #define AM_HAL_MAGIC_MSPI               0xBEBEBE
 #define AM_HAL_MSPI_CHK_HANDLE(h)       ((h) && ((am_hal_handle_prefix_t *)(h))->s.bInit && (((am_hal_handle_prefix_t *)(h))->s.magic == AM_HAL_MAGIC_MSPI))
 #define AM_HAL_MSPI_HW_IDX_MAX          (AM_REG_MSPI_CQCURIDX_CQCURIDX_M >> AM_REG_MSPI_CQCURIDX_CQCURIDX_S)    // 8 bit value
+// Upper bound on the pending transaction ring carved from pTCB.
+// Must be power of 2 for the CQ index masking.
 #define AM_HAL_MSPI_MAX_CQ_ENTRIES      (256)
 
 
@@ -230,13 +232,15 @@ typedef struct
     uint32_t ui32LastIdxProcessed;
     uint32_t ui32NumCQEntries;
     uint32_t ui32TxnInt;
+    uint32_t ui32MaxTransactions;
 
     //
     // Stores the CQ callbacks.
+    // These point into the tail of pTCB, ui32MaxTransactions deep.
     //
-    am_hal_mspi_callback_t pfnCallback[AM_HAL_MSPI_MAX_CQ_ENTRIES];
+    am_hal_mspi_callback_t *pfnCallback;
 
-    void                   *pCallbackCtxt[AM_HAL_MSPI_MAX_CQ_ENTRIES];
+    void                   **pCallbackCtxt;
 #if MSPI_USE_CQ
     //
     // Command Queue.
@@ -258,7 +262,6 @@ typedef struct
     uint32_t                      ui32LastHPIdxProcessed;
     am_hal_mspi_dma_entry_t       *pHPTransactions;
 #else
-    uint32_t                      ui32MaxTransactions;
     uint32_t                      ui32NextIdx;
     am_hal_mspi_cq_dma_entry_t    *pTransactions;
 #endif
@@ -290,6 +293,84 @@ void *g_pCallbackCtxt[AM_REG_MSPI_NUM_MODULES];
 // Internal Functions.
 //
 //*****************************************************************************
+
+//*****************************************************************************
+//
+// Carve the pending transaction callback ring out of the tail of the
+// caller supplied TCB.
+//
+// The ring depth is the number of transactions (ui32TxnBytes each, plus one
+// callback and context) that fit in the buffer, capped at
+// AM_HAL_MSPI_MAX_CQ_ENTRIES.  For CQ operation the CQ index is masked into
+// the ring, so the depth is a power of 2 instead: the one that lets the most
+// transactions be pending, with the rest of the buffer left to the CQ.  The
+// CQ then limits the pending count when it holds fewer than the ring.
+//
+// Returns the number of words left at the head of the buffer.
+//
+//*****************************************************************************
+static uint32_t
+mspi_callback_ring_init(am_hal_mspi_state_t *pMSPIState, uint32_t *pui32Buf,
+                        uint32_t ui32Length, uint32_t ui32TxnBytes, bool bPow2)
+{
+    uint32_t ui32SlotBytes = sizeof(am_hal_mspi_callback_t) + sizeof(void *);
+    uint32_t ui32Bytes = ui32Length * 4;
+    uint32_t ui32Depth;
+    uint32_t ui32RingWords;
+
+    if (bPow2)
+    {
+        //
+        // Find the largest depth that leaves the CQ room for as many
+        // transactions, then take the next one up if the CQ would still have
+        // room for more than that.
+        //
+        ui32Depth = 1;
+        while ((ui32Depth < AM_HAL_MSPI_MAX_CQ_ENTRIES) &&
+               (2 * ui32Depth * (ui32TxnBytes + ui32SlotBytes) <= ui32Bytes))
+        {
+            ui32Depth <<= 1;
+        }
+        if ((ui32Depth < AM_HAL_MSPI_MAX_CQ_ENTRIES) &&
+            (2 * ui32Depth * ui32SlotBytes < ui32Bytes) &&
+            ((ui32Bytes - 2 * ui32Depth * ui32SlotBytes) / ui32TxnBytes > ui32Depth))
+        {
+            ui32Depth <<= 1;
+        }
+        if (ui32Depth * ui32SlotBytes + ui32TxnBytes > ui32Bytes)
+        {
+            ui32Depth = 0;
+        }
+    }
+    else
+    {
+        ui32Depth = ui32Bytes / (ui32TxnBytes + ui32SlotBytes);
+        if (ui32Depth > AM_HAL_MSPI_MAX_CQ_ENTRIES)
+        {
+            ui32Depth = AM_HAL_MSPI_MAX_CQ_ENTRIES;
+        }
+    }
+
+    pMSPIState->ui32MaxTransactions = ui32Depth;
+    if (ui32Depth == 0)
+    {
+        pMSPIState->pfnCallback = NULL;
+        pMSPIState->pCallbackCtxt = NULL;
+        return ui32Length;
+    }
+
+    ui32RingWords = (ui32Depth * ui32SlotBytes + 3) / 4;
+    pMSPIState->pfnCallback = (am_hal_mspi_callback_t *)&pui32Buf[ui32Length - ui32RingWords];
+    pMSPIState->pCallbackCtxt = (void **)&pMSPIState->pfnCallback[ui32Depth];
+    for (uint32_t i = 0; i < ui32Depth; i++)
+    {
+        pMSPIState->pfnCallback[i] = NULL;
+        pMSPIState->pCallbackCtxt[i] = NULL;
+    }
+
+    return ui32Length - ui32RingWords;
+} // mspi_callback_ring_init()
+
 static uint32_t
 get_pause_val(am_hal_mspi_state_t *pMSPIState, uint32_t pause)
 {
@@ -664,6 +745,17 @@ mspi_cq_init(uint32_t ui32Module, uint32_t ui32Length,
 {
     am_hal_cmdq_cfg_t cqCfg;
 
+    //
+    // Size for the largest (DMA) entry plus the CQ index update entry.
+    //
+    ui32Length = mspi_callback_ring_init(&g_MSPIState[ui32Module], pTCB, ui32Length,
+                                         sizeof(am_hal_mspi_cq_dma_entry_t) + sizeof(am_hal_cmdq_entry_t),
+                                         true);
+    if (g_MSPIState[ui32Module].ui32MaxTransactions == 0)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
     cqCfg.pCmdQBuf = pTCB;
     cqCfg.cmdQSize = ui32Length / 2;
     cqCfg.priority = AM_HAL_CMDQ_PRIO_HI;
@@ -750,7 +842,7 @@ mspi_cq_add_transaction(void *pHandle,
     //
     // Check to see if there is enough room in the CQ
     //
-    if (pMSPIState->ui32NumCQEntries == AM_HAL_MSPI_MAX_CQ_ENTRIES)
+    if (pMSPIState->ui32NumCQEntries == pMSPIState->ui32MaxTransactions)
     {
         return AM_HAL_STATUS_OUT_OF_RANGE;
     }
@@ -779,8 +871,8 @@ mspi_cq_add_transaction(void *pHandle,
     //
     // Store the callback function pointer.
     //
-    pMSPIState->pfnCallback[index & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1)] = pfnCallback;
-    pMSPIState->pCallbackCtxt[index & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1)] = pCallbackCtxt;
+    pMSPIState->pfnCallback[index & (pMSPIState->ui32MaxTransactions - 1)] = pfnCallback;
+    pMSPIState->pCallbackCtxt[index & (pMSPIState->ui32MaxTransactions - 1)] = pCallbackCtxt;
 
     //
     // Return the status.
@@ -1075,7 +1167,7 @@ am_hal_mspi_initialize(uint32_t ui32Module, void **ppHandle)
 {
     // Compile time check to ensure ENTRY_SIZE macros are defined correctly
     // incorrect definition will cause divide by 0 error at build time
-    am_ct_assert((sizeof(am_hal_mspi_cq_dma_entry_t) + 8) == AM_HAL_MSPI_CQ_ENTRY_SIZE);
+    am_ct_assert((sizeof(am_hal_mspi_cq_dma_entry_t) + 8 + 2 * (sizeof(am_hal_mspi_callback_t) + sizeof(void *))) == AM_HAL_MSPI_CQ_ENTRY_SIZE);
     am_ct_assert(sizeof(am_hal_mspi_dma_entry_t) == AM_HAL_MSPI_HIPRIO_ENTRY_SIZE);
 
 #ifndef AM_HAL_DISABLE_API_VALIDATION
@@ -1444,6 +1536,9 @@ uint32_t
 am_hal_mspi_enable(void *pHandle)
 {
     am_hal_mspi_state_t           *pMSPIState = (am_hal_mspi_state_t *)pHandle;
+#if MSPI_USE_CQ
+    uint32_t                      ui32Status;
+#endif // MSPI_USE_CQ
 
 #ifndef AM_HAL_DISABLE_API_VALIDATION
     //
@@ -1466,7 +1561,11 @@ am_hal_mspi_enable(void *pHandle)
         //
         // Initialize the Command Queue service with memory supplied by the application.
         //
-        mspi_cq_init(pMSPIState->ui32Module, pMSPIState->ui32TCBSize, pMSPIState->pTCB);
+        ui32Status = mspi_cq_init(pMSPIState->ui32Module, pMSPIState->ui32TCBSize, pMSPIState->pTCB);
+        if (AM_HAL_STATUS_SUCCESS != ui32Status)
+        {
+            return ui32Status;
+        }
         // Initialize Flags used to force CQ Pause
         MSPIn(pMSPIState->ui32Module)->CQSETCLEAR = AM_HAL_MSPI_SC_UNPAUSE_CQ | AM_HAL_MSPI_SC_PAUSE_SEQLOOP;
         pMSPIState->pHPTransactions = NULL;
@@ -1481,13 +1580,11 @@ am_hal_mspi_enable(void *pHandle)
 #else
         // Use the buffer for software queuing for DMA
         // Determine the maximum number of transactions based on the memory provided
-        pMSPIState->ui32MaxTransactions = pMSPIState->ui32TCBSize * 4 / sizeof(am_hal_mspi_cq_dma_entry_t);
+        mspi_callback_ring_init(pMSPIState, pMSPIState->pTCB,
+                                pMSPIState->ui32TCBSize,
+                                sizeof(am_hal_mspi_cq_dma_entry_t), false);
         if (pMSPIState->ui32MaxTransactions > 0)
         {
-            if (pMSPIState->ui32MaxTransactions > AM_HAL_MSPI_MAX_CQ_ENTRIES)
-            {
-                pMSPIState->ui32MaxTransactions = AM_HAL_MSPI_MAX_CQ_ENTRIES;
-            }
             pMSPIState->ui32NextIdx = pMSPIState->ui32LastIdxProcessed + 1;
             pMSPIState->pTransactions = (am_hal_mspi_cq_dma_entry_t *)pMSPIState->pTCB;
         }
@@ -1730,6 +1827,15 @@ uint32_t am_hal_mspi_control(void *pHandle,
                 return AM_HAL_STATUS_INVALID_OPERATION;
             }
 #endif // AM_HAL_DISABLE_API_VALIDATION
+            //
+            // The loop entry, and the loopback callback entry if there is
+            // one, each take a slot in the callback ring.
+            //
+            if ((pMSPIState->ui32NumCQEntries + (((pLoop->bLoop) && (!pMSPIState->bAutonomous)) ? 2 : 1)) >
+                pMSPIState->ui32MaxTransactions)
+            {
+                return AM_HAL_STATUS_OUT_OF_RANGE;
+            }
             if (pMSPIState->block)
             {
                 // End the block if the sequence is ending
@@ -1751,8 +1857,8 @@ uint32_t am_hal_mspi_control(void *pHandle,
                     //
                     // Store the callback function pointer.
                     //
-                    pMSPIState->pfnCallback[index & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1)] = mspi_seq_loopback;
-                    pMSPIState->pCallbackCtxt[index & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1)] = (void *)pMSPIState;
+                    pMSPIState->pfnCallback[index & (pMSPIState->ui32MaxTransactions - 1)] = mspi_seq_loopback;
+                    pMSPIState->pCallbackCtxt[index & (pMSPIState->ui32MaxTransactions - 1)] = (void *)pMSPIState;
 
                     // Dummy Entry
                     pCQBlock->address = (uint32_t)&MSPIn(ui32Module)->CQSETCLEAR;
@@ -1936,7 +2042,7 @@ uint32_t am_hal_mspi_control(void *pHandle,
             //
             // Check to see if there is enough room in the CQ
             //
-            if ((pMSPIState->ui32NumCQEntries == AM_HAL_MSPI_MAX_CQ_ENTRIES) ||
+            if ((pMSPIState->ui32NumCQEntries == pMSPIState->ui32MaxTransactions) ||
                 (am_hal_cmdq_alloc_block(pMSPIState->CQ.pCmdQHdl, pCqRaw->numEntries + 3, &pCQBlock, &index)))
             {
                 return AM_HAL_STATUS_OUT_OF_RANGE;
@@ -1964,8 +2070,8 @@ uint32_t am_hal_mspi_control(void *pHandle,
             //
             // Store the callback function pointer.
             //
-            pMSPIState->pfnCallback[index & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1)] = pCqRaw->pfnCallback;
-            pMSPIState->pCallbackCtxt[index & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1)] = pCqRaw->pCallbackCtxt;
+            pMSPIState->pfnCallback[index & (pMSPIState->ui32MaxTransactions - 1)] = pCqRaw->pfnCallback;
+            pMSPIState->pCallbackCtxt[index & (pMSPIState->ui32MaxTransactions - 1)] = pCqRaw->pCallbackCtxt;
 
             //
             // Need to protect access of ui32NumPendTransactions as it is accessed
@@ -2710,7 +2816,7 @@ uint32_t am_hal_mspi_interrupt_service(void *pHandle, uint32_t ui32IntStatus)
 
                     pMSPIState->ui32LastIdxProcessed++;
                     pMSPIState->ui32NumCQEntries--;
-                    index = pMSPIState->ui32LastIdxProcessed & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1);
+                    index = pMSPIState->ui32LastIdxProcessed & (pMSPIState->ui32MaxTransactions - 1);
                     if ( pMSPIState->pfnCallback[index] != NULL )
                     {
                         pMSPIState->pfnCallback[index](pMSPIState->pCallbackCtxt[index], AM_HAL_STATUS_SUCCESS);
@@ -2731,7 +2837,7 @@ uint32_t am_hal_mspi_interrupt_service(void *pHandle, uint32_t ui32IntStatus)
                     {
                         pMSPIState->ui32LastIdxProcessed++;
                         pMSPIState->ui32NumCQEntries--;
-                        index = pMSPIState->ui32LastIdxProcessed & (AM_HAL_MSPI_MAX_CQ_ENTRIES - 1);
+                        index = pMSPIState->ui32LastIdxProcessed & (pMSPIState->ui32MaxTransactions - 1);
                         if ( pMSPIState->pfnCallback[index] != NULL )
                         {
                             pMSPIState->pfnCallback[index](pMSPIState->pCallbackCtxt[index], AM_HAL_STATUS_FAIL);
@@ -73,7 +73,10 @@ extern "C"
 #define AM_HAL_MSPI_DEFAULT_BURST_COUNT         32
 
 // Size guideline for allocation of application supploed buffers
-#define AM_HAL_MSPI_CQ_ENTRY_SIZE               (18 * sizeof(uint32_t))
+// A CQ entry includes two slots of the pending transaction callback ring,
+// whose depth is rounded up to a power of 2.  A pTCB of
+// AM_HAL_MSPI_CQ_ENTRY_SIZE * (N + 1) bytes holds N pending transactions.
+#define AM_HAL_MSPI_CQ_ENTRY_SIZE               (18 * sizeof(uint32_t) + 2 * (sizeof(am_hal_mspi_callback_t) + sizeof(void *)))
 #define AM_HAL_MSPI_HIPRIO_ENTRY_SIZE           (6 * sizeof(uint32_t))
 
 #define AM_HAL_MSPI_SC_CLEAR(flag)              ((flag) << 16)
@@ -373,6 +376,8 @@ extern "C"
     uint32_t                    ui32TCBSize;
 
     //! DMA Transfer Control Buffer
+    //! The tail of this buffer also holds the pending transaction callbacks,
+    //! so it sets the maximum number of outstanding transactions.
     uint32_t                    *pTCB;
 
     //
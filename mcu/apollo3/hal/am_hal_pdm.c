@@ -136,6 +136,27 @@ typedef struct
     am_hal_handle_prefix_t prefix;
     am_hal_pdm_register_state_t sRegState;
     uint32_t ui32Module;
+
+    //
+    // Last DMA size and the FIFO threshold found for it.
+    //
+    uint32_t ui32ThresholdCount;
+    uint32_t ui32Threshold;
+
+    //
+    // Streaming capture. ui32FramesDone counts frames published to the
+    // consumer and ui32FramesReleased counts frames handed back, so the DMA
+    // target is always frame (ui32FramesDone % ui32NumFrames).
+    //
+    volatile bool bStreaming;
+    uint32_t *pui32StreamBuffer;
+    uint32_t ui32FrameBytes;
+    uint32_t ui32NumFrames;
+    volatile uint32_t ui32FramesDone;
+    volatile uint32_t ui32FramesReleased;
+    volatile uint32_t ui32FramesCaptured;
+    volatile uint32_t ui32Overruns;
+    volatile uint32_t ui32DmaErrors;
 }
 am_hal_pdm_state_t;
 
@@ -185,6 +206,8 @@ am_hal_pdm_initialize(uint32_t ui32Module, void **ppHandle)
     g_am_hal_pdm_states[ui32Module].prefix.s.magic = AM_HAL_MAGIC_PDM;
     g_am_hal_pdm_states[ui32Module].ui32Module = ui32Module;
     g_am_hal_pdm_states[ui32Module].sRegState.bValid = false;
+    g_am_hal_pdm_states[ui32Module].ui32ThresholdCount = 0;
+    g_am_hal_pdm_states[ui32Module].bStreaming = false;
 
     //
     // Return the handle.
@@ -400,58 +423,56 @@ am_hal_pdm_disable(void *pHandle)
 
 //*****************************************************************************
 //
-// Starts a DMA transaction from the PDM directly to SRAM
+// Find the FIFO threshold for a DMA of ui32TotalCount bytes.
+//
+// The PDM DMA hardware can only perform transactions where the total count is
+// an integer multiple of the threshold value. The search is repeated only
+// when the count changes.
 //
 //*****************************************************************************
-uint32_t
-am_hal_pdm_dma_start(void *pHandle, am_hal_pdm_transfer_t *pDmaCfg)
+static uint32_t
+pdm_dma_threshold(am_hal_pdm_state_t *pState, uint32_t ui32TotalCount)
 {
-    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
-    uint32_t ui32Module = pState->ui32Module;
-    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+    uint32_t ui32NumReloads;
 
-    //
-    // Calculate a FIFO threshold that will work. The PDM DMA hardware can only
-    // perform transactions where the total count is an integer multiple of the
-    // threshold value. We will loop here to try to find a threshold value and
-    // an integer multiple (ui32NumReloads) that will fit the total count the
-    // user asked for.
-    //
-    uint32_t ui32Threshold = 0;
-    uint32_t ui32NumReloads = 1;
+    if (pState->ui32ThresholdCount == ui32TotalCount)
+    {
+        return pState->ui32Threshold;
+    }
 
-    for (ui32NumReloads = 1; ui32NumReloads < pDmaCfg->ui32TotalCount; ui32NumReloads++)
+    pState->ui32ThresholdCount = ui32TotalCount;
+    pState->ui32Threshold = 0;
+
+    for (ui32NumReloads = 1; ui32NumReloads < ui32TotalCount; ui32NumReloads++)
     {
         //
         // Check to make sure the total count is evenly divisible into chunks
         // that are smaller than the maximum threshold size.
         //
-        if (((pDmaCfg->ui32TotalCount % ui32NumReloads) == 0) &&
-            ((pDmaCfg->ui32TotalCount / ui32NumReloads) <= 0x1F))
+        if (((ui32TotalCount % ui32NumReloads) == 0) &&
+            ((ui32TotalCount / ui32NumReloads) <= 0x1F))
         {
-            ui32Threshold = pDmaCfg->ui32TotalCount / ui32NumReloads;
+            pState->ui32Threshold = ui32TotalCount / ui32NumReloads;
             break;
         }
     }
 
-    //
-    // If we didn't find a threshold that will work, throw an error.
-    //
-    if (ui32Threshold == 0)
-    {
-        return AM_HAL_PDM_STATUS_BAD_TOTALCOUNT;
-    }
-
-    PDMn(ui32Module)->FIFOTHR = ui32Threshold;
+    return pState->ui32Threshold;
+}
 
-    //
-    // Configure DMA.
-    //
+//*****************************************************************************
+//
+// Point the DMA at a new target and start it.
+//
+//*****************************************************************************
+static void
+pdm_dma_arm(uint32_t ui32Module, uint32_t ui32TargetAddr, uint32_t ui32TotalCount)
+{
     PDMn(ui32Module)->DMACFG = 0;
     PDMn(ui32Module)->DMACFG_b.DMAPRI = PDM_DMACFG_DMAPRI_LOW;
     PDMn(ui32Module)->DMACFG_b.DMADIR = PDM_DMACFG_DMADIR_P2M;
-    PDMn(ui32Module)->DMATOTCOUNT = pDmaCfg->ui32TotalCount;
-    PDMn(ui32Module)->DMATARGADDR = pDmaCfg->ui32TargetAddr;
+    PDMn(ui32Module)->DMATOTCOUNT = ui32TotalCount;
+    PDMn(ui32Module)->DMATARGADDR = ui32TargetAddr;
 
     //
     // Make sure the trigger is set for threshold.
@@ -462,6 +483,36 @@ am_hal_pdm_dma_start(void *pHandle, am_hal_pdm_transfer_t *pDmaCfg)
     // Enable DMA
     //
     PDMn(ui32Module)->DMACFG_b.DMAEN = PDM_DMACFG_DMAEN_EN;
+}
+
+//*****************************************************************************
+//
+// Starts a DMA transaction from the PDM directly to SRAM
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_dma_start(void *pHandle, am_hal_pdm_transfer_t *pDmaCfg)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    uint32_t ui32Module = pState->ui32Module;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+    uint32_t ui32Threshold = pdm_dma_threshold(pState, pDmaCfg->ui32TotalCount);
+
+    //
+    // If we didn't find a threshold that will work, throw an error.
+    //
+    if (ui32Threshold == 0)
+    {
+        return AM_HAL_PDM_STATUS_BAD_TOTALCOUNT;
+    }
+
+    PDMn(ui32Module)->FIFOTHR = ui32Threshold;
+
+    //
+    // Configure and start the DMA.
+    //
+    pdm_dma_arm(ui32Module, pDmaCfg->ui32TargetAddr, pDmaCfg->ui32TotalCount);
 
 //    //
 //    // Reset the voice module.
@@ -476,6 +527,219 @@ am_hal_pdm_dma_start(void *pHandle, am_hal_pdm_transfer_t *pDmaCfg)
     return AM_HAL_STATUS_SUCCESS;
 }
 
+//*****************************************************************************
+//
+// Start continuous capture into a ring of frames.
+//
+// The DMA is re-armed from am_hal_pdm_stream_service(), which must be called
+// from the PDM interrupt handler with the DCMP and DERR interrupts enabled.
+// The FIFO keeps collecting samples while the handler runs, so no samples are
+// lost as long as the handler runs within one FIFO's worth of samples.
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_stream_start(void *pHandle, am_hal_pdm_stream_config_t *psConfig)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    uint32_t ui32Module = pState->ui32Module;
+    uint32_t ui32Threshold;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if (!psConfig || !psConfig->pui32Buffer ||
+        (psConfig->ui32NumFrames < 2) ||
+        (psConfig->ui32FrameBytes == 0) ||
+        (psConfig->ui32FrameBytes & 0x3))
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    if (pState->bStreaming)
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    ui32Threshold = pdm_dma_threshold(pState, psConfig->ui32FrameBytes);
+    if (ui32Threshold == 0)
+    {
+        return AM_HAL_PDM_STATUS_BAD_TOTALCOUNT;
+    }
+
+    pState->pui32StreamBuffer = psConfig->pui32Buffer;
+    pState->ui32FrameBytes = psConfig->ui32FrameBytes;
+    pState->ui32NumFrames = psConfig->ui32NumFrames;
+    pState->ui32FramesDone = 0;
+    pState->ui32FramesReleased = 0;
+    pState->ui32FramesCaptured = 0;
+    pState->ui32Overruns = 0;
+    pState->ui32DmaErrors = 0;
+    pState->bStreaming = true;
+
+    PDMn(ui32Module)->FIFOTHR = ui32Threshold;
+    PDMn(ui32Module)->FIFOFLUSH = 1;
+
+    pdm_dma_arm(ui32Module, (uint32_t)pState->pui32StreamBuffer, pState->ui32FrameBytes);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Stop continuous capture.
+//
+// Frames already captured remain available to the consumer.
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_stream_stop(void *pHandle)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    uint32_t ui32Module = pState->ui32Module;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+    pState->bStreaming = false;
+    PDMn(ui32Module)->DMACFG_b.DMAEN = PDM_DMACFG_DMAEN_DIS;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Streaming interrupt service.
+//
+// Publishes the frame the DMA just filled and re-arms the DMA on the next
+// free frame. If the consumer still holds every other frame, the newest
+// captured frame is overwritten instead and counted as an overrun.
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_stream_service(void *pHandle, uint32_t ui32IntStatus)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    uint32_t ui32Module = pState->ui32Module;
+    uint32_t ui32Slot;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+    if (!pState->bStreaming ||
+        !(ui32IntStatus & (AM_HAL_PDM_INT_DCMP | AM_HAL_PDM_INT_DERR)))
+    {
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    if (ui32IntStatus & AM_HAL_PDM_INT_DERR)
+    {
+        //
+        // The frame contents are unreliable. Capture it again.
+        //
+        pState->ui32DmaErrors++;
+    }
+    else
+    {
+        pState->ui32FramesCaptured++;
+
+        if ((pState->ui32FramesDone + 1 - pState->ui32FramesReleased) < pState->ui32NumFrames)
+        {
+            pState->ui32FramesDone++;
+        }
+        else
+        {
+            pState->ui32Overruns++;
+        }
+    }
+
+    ui32Slot = pState->ui32FramesDone % pState->ui32NumFrames;
+    pdm_dma_arm(ui32Module,
+                (uint32_t)pState->pui32StreamBuffer + ui32Slot * pState->ui32FrameBytes,
+                pState->ui32FrameBytes);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Get the oldest captured frame.
+//
+// The frame is returned in place and stays valid until it is handed back with
+// am_hal_pdm_stream_frame_release(). Only one frame is handed out at a time;
+// calling this again before the release returns the same frame.
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_stream_frame_get(void *pHandle, void **ppFrame)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    uint32_t ui32Slot;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if (!ppFrame)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    if (pState->ui32FramesDone == pState->ui32FramesReleased)
+    {
+        *ppFrame = NULL;
+        return AM_HAL_PDM_STATUS_NO_FRAME;
+    }
+
+    ui32Slot = pState->ui32FramesReleased % pState->ui32NumFrames;
+    *ppFrame = (void *)((uint32_t)pState->pui32StreamBuffer + ui32Slot * pState->ui32FrameBytes);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Hand the frame returned by am_hal_pdm_stream_frame_get() back to the DMA.
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_stream_frame_release(void *pHandle)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+    if (pState->ui32FramesDone == pState->ui32FramesReleased)
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    pState->ui32FramesReleased++;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Return the streaming statistics.
+//
+//*****************************************************************************
+uint32_t
+am_hal_pdm_stream_status_get(void *pHandle, am_hal_pdm_stream_status_t *psStatus)
+{
+    am_hal_pdm_state_t *pState = (am_hal_pdm_state_t *) pHandle;
+    AM_HAL_PDM_HANDLE_CHECK(pHandle);
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if (!psStatus)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    AM_CRITICAL_BEGIN
+    psStatus->ui32FramesCaptured = pState->ui32FramesCaptured;
+    psStatus->ui32FramesReady = pState->ui32FramesDone - pState->ui32FramesReleased;
+    psStatus->ui32Overruns = pState->ui32Overruns;
+    psStatus->ui32DmaErrors = pState->ui32DmaErrors;
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
 //*****************************************************************************
 //
 // Flush the PDM FIFO
@@ -79,6 +79,12 @@ typedef enum
     // ui32TotalCount value to a more evenly divisible number.
     //
     AM_HAL_PDM_STATUS_BAD_TOTALCOUNT = AM_HAL_STATUS_MODULE_SPECIFIC_START,
+
+    //
+    // Returned by am_hal_pdm_stream_frame_get() when no captured frame is
+    // waiting to be consumed.
+    //
+    AM_HAL_PDM_STATUS_NO_FRAME,
 }
 am_hal_pdm_status_e;
 
@@ -262,6 +268,45 @@ typedef struct
 }
 am_hal_pdm_transfer_t;
 
+//*****************************************************************************
+//
+// Streaming capture configuration.
+//
+// The buffer is divided into ui32NumFrames frames of ui32FrameBytes each. The
+// DMA always fills one frame while the others hold captured data, so at least
+// two frames are required. ui32FrameBytes has the same restrictions as
+// ui32TotalCount in am_hal_pdm_transfer_t.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t *pui32Buffer;
+    uint32_t ui32FrameBytes;
+    uint32_t ui32NumFrames;
+}
+am_hal_pdm_stream_config_t;
+
+//*****************************************************************************
+//
+// Streaming capture status.
+//
+//*****************************************************************************
+typedef struct
+{
+    // Frames filled by the DMA since the stream was started.
+    uint32_t ui32FramesCaptured;
+
+    // Captured frames not yet released by the consumer.
+    uint32_t ui32FramesReady;
+
+    // Frames discarded because the consumer held every other frame.
+    uint32_t ui32Overruns;
+
+    // Frames discarded because of a DMA error.
+    uint32_t ui32DmaErrors;
+}
+am_hal_pdm_stream_status_t;
+
 
 // Init/De-init.
 extern uint32_t am_hal_pdm_initialize(uint32_t ui32Module, void **ppHandle);
@@ -280,6 +325,14 @@ extern uint32_t am_hal_pdm_disable(void *pHandle);
 // Gather PDM data.
 extern uint32_t am_hal_pdm_dma_start(void *pHandle, am_hal_pdm_transfer_t *pDmaCfg);
 
+// Continuous capture into a ring of frames.
+extern uint32_t am_hal_pdm_stream_start(void *pHandle, am_hal_pdm_stream_config_t *psConfig);
+extern uint32_t am_hal_pdm_stream_stop(void *pHandle);
+extern uint32_t am_hal_pdm_stream_service(void *pHandle, uint32_t ui32IntStatus);
+extern uint32_t am_hal_pdm_stream_frame_get(void *pHandle, void **ppFrame);
+extern uint32_t am_hal_pdm_stream_frame_release(void *pHandle);
+extern uint32_t am_hal_pdm_stream_status_get(void *pHandle, am_hal_pdm_stream_status_t *psStatus);
+
 // Flush the PDM FIFO.
 extern uint32_t am_hal_pdm_fifo_flush(void *pHandle);
 
@@ -270,6 +270,19 @@ am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral)
 uint32_t
 am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral)
 {
+    uint32_t ui32DomainEnable = 0;
+
+    //
+    // Collect the enables of every peripheral sharing this one's power domain.
+    //
+    for ( uint32_t i = 0; i < AM_HAL_PWRCTRL_PERIPH_MAX; i++ )
+    {
+        if ( am_hal_pwrctrl_peripheral_control[i].ui32PeriphStatus ==
+             am_hal_pwrctrl_peripheral_control[ePeripheral].ui32PeriphStatus )
+        {
+            ui32DomainEnable |= am_hal_pwrctrl_peripheral_control[i].ui32PeriphEnable;
+        }
+    }
 
     //
     // Disable power domain for the given device.
@@ -278,6 +291,14 @@ am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral)
     PWRCTRL->DEVPWREN &= ~am_hal_pwrctrl_peripheral_control[ePeripheral].ui32PeriphEnable;
     AM_CRITICAL_END
 
+    //
+    // The domain stays up while another of its peripherals is enabled.
+    //
+    if ( PWRCTRL->DEVPWREN & ui32DomainEnable )
+    {
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
 
     for (uint32_t wait_usecs = 0; wait_usecs < AM_HAL_PWRCTRL_MAX_WFE; wait_usecs += 10)
     {
@@ -528,6 +549,397 @@ am_hal_pwrctrl_low_power_init(void)
     return AM_HAL_STATUS_SUCCESS;
 }
 
+// ****************************************************************************
+//
+//  Reference counted power manager.
+//
+// ****************************************************************************
+typedef struct
+{
+    uint32_t      ui32RefCount;
+    uint32_t      ui32IdleTicks;
+    uint32_t      ui32OffTime;
+    uint32_t      ui32OnTime;
+    bool          bPowered;
+    bool          bOffPending;
+    uint32_t      ui32PowerOns;
+    uint64_t      ui64OnTicks;
+} am_hal_pwrctrl_auto_state_t;
+
+typedef struct
+{
+    uint32_t      ui32Powered;
+    uint32_t      ui32OnTime;
+    uint32_t      ui32PowerOns;
+    uint64_t      ui64OnTicks;
+} am_hal_pwrctrl_domain_state_t;
+
+static am_hal_pwrctrl_auto_config_t g_sPwrctrlAutoConfig;
+static am_hal_pwrctrl_auto_state_t g_sPwrctrlAuto[AM_HAL_PWRCTRL_PERIPH_MAX];
+static am_hal_pwrctrl_domain_state_t g_sPwrctrlDomain[AM_HAL_PWRCTRL_DOMAIN_MAX];
+
+//
+// Power domain of a peripheral, from the status bit that reports it in
+// am_hal_pwrctrl_peripheral_control[].
+//
+static am_hal_pwrctrl_domain_e
+pwrctrl_periph_domain(am_hal_pwrctrl_periph_e ePeripheral)
+{
+    switch ( am_hal_pwrctrl_peripheral_control[ePeripheral].ui32PeriphStatus )
+    {
+        case PWRCTRL_DEVPWRSTATUS_HCPA_Msk:     return AM_HAL_PWRCTRL_DOMAIN_HCPA;
+        case PWRCTRL_DEVPWRSTATUS_HCPB_Msk:     return AM_HAL_PWRCTRL_DOMAIN_HCPB;
+        case PWRCTRL_DEVPWRSTATUS_HCPC_Msk:     return AM_HAL_PWRCTRL_DOMAIN_HCPC;
+        case PWRCTRL_DEVPWRSTATUS_PWRADC_Msk:   return AM_HAL_PWRCTRL_DOMAIN_ADC;
+        case PWRCTRL_DEVPWRSTATUS_PWRMSPI_Msk:  return AM_HAL_PWRCTRL_DOMAIN_MSPI;
+        case PWRCTRL_DEVPWRSTATUS_PWRPDM_Msk:   return AM_HAL_PWRCTRL_DOMAIN_PDM;
+        case PWRCTRL_DEVPWRSTATUS_BLEL_Msk:     return AM_HAL_PWRCTRL_DOMAIN_BLEL;
+        default:                                return AM_HAL_PWRCTRL_DOMAIN_MAX;
+    }
+}
+
+//
+// Read the power manager time base.
+//
+static uint32_t
+pwrctrl_auto_time(void)
+{
+    return g_sPwrctrlAutoConfig.pfnTimeGet ? g_sPwrctrlAutoConfig.pfnTimeGet() : 0;
+}
+
+//
+// Switch a managed peripheral and account for the transition.  Must be called
+// in a critical section.
+//
+static uint32_t
+pwrctrl_auto_switch(am_hal_pwrctrl_periph_e ePeripheral, bool bPower,
+                    uint32_t ui32Now)
+{
+    am_hal_pwrctrl_auto_state_t *psState = &g_sPwrctrlAuto[ePeripheral];
+    am_hal_pwrctrl_domain_state_t *psDomain =
+        &g_sPwrctrlDomain[pwrctrl_periph_domain(ePeripheral)];
+    uint32_t ui32Status;
+
+    if ( bPower )
+    {
+        ui32Status = am_hal_pwrctrl_periph_enable(ePeripheral);
+        if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+        {
+            return ui32Status;
+        }
+
+        psState->bPowered = true;
+        psState->ui32OnTime = ui32Now;
+        psState->ui32PowerOns++;
+
+        if ( psDomain->ui32Powered++ == 0 )
+        {
+            psDomain->ui32OnTime = ui32Now;
+            psDomain->ui32PowerOns++;
+        }
+    }
+    else
+    {
+        ui32Status = am_hal_pwrctrl_periph_disable(ePeripheral);
+        if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+        {
+            return ui32Status;
+        }
+
+        psState->bPowered = false;
+        psState->ui64OnTicks += ui32Now - psState->ui32OnTime;
+
+        if ( --psDomain->ui32Powered == 0 )
+        {
+            psDomain->ui64OnTicks += ui32Now - psDomain->ui32OnTime;
+        }
+    }
+
+    if ( g_sPwrctrlAutoConfig.pfnTrace )
+    {
+        g_sPwrctrlAutoConfig.pfnTrace(ePeripheral, bPower, ui32Now);
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_auto_config()
+//  Configure the reference counted power manager.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_auto_config(const am_hal_pwrctrl_auto_config_t *psConfig)
+{
+    if ( psConfig == NULL )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    AM_CRITICAL_BEGIN
+    g_sPwrctrlAutoConfig = *psConfig;
+    for ( uint32_t i = 0; i < AM_HAL_PWRCTRL_PERIPH_MAX; i++ )
+    {
+        g_sPwrctrlAuto[i].ui32IdleTicks = psConfig->ui32IdleTicks;
+    }
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_periph_idle_set()
+//  Set the idle hysteresis of one peripheral.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_periph_idle_set(am_hal_pwrctrl_periph_e ePeripheral,
+                               uint32_t ui32IdleTicks)
+{
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (ePeripheral == AM_HAL_PWRCTRL_PERIPH_NONE) ||
+         (ePeripheral >= AM_HAL_PWRCTRL_PERIPH_MAX) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    g_sPwrctrlAuto[ePeripheral].ui32IdleTicks = ui32IdleTicks;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_periph_acquire()
+//  Take a reference to a peripheral's power.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_periph_acquire(am_hal_pwrctrl_periph_e ePeripheral)
+{
+    am_hal_pwrctrl_auto_state_t *psState;
+    uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (ePeripheral == AM_HAL_PWRCTRL_PERIPH_NONE) ||
+         (ePeripheral >= AM_HAL_PWRCTRL_PERIPH_MAX) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    psState = &g_sPwrctrlAuto[ePeripheral];
+
+    //
+    // The power up wait is short, and holding the critical section across it
+    // keeps a caller at another priority from seeing the reference before the
+    // peripheral is powered.
+    //
+    AM_CRITICAL_BEGIN
+
+    psState->bOffPending = false;
+    if ( !psState->bPowered )
+    {
+        ui32Status = pwrctrl_auto_switch(ePeripheral, true, pwrctrl_auto_time());
+    }
+    else if ( !(PWRCTRL->DEVPWREN &
+                am_hal_pwrctrl_peripheral_control[ePeripheral].ui32PeriphEnable) )
+    {
+        //
+        // A direct am_hal_pwrctrl_periph_disable() turned it off under the
+        // manager.  Turn it back on; the statistics treat it as having stayed
+        // on.
+        //
+        ui32Status = am_hal_pwrctrl_periph_enable(ePeripheral);
+    }
+
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        psState->ui32RefCount++;
+    }
+
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_periph_release()
+//  Drop a reference to a peripheral's power.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_periph_release(am_hal_pwrctrl_periph_e ePeripheral)
+{
+    am_hal_pwrctrl_auto_state_t *psState;
+    uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (ePeripheral == AM_HAL_PWRCTRL_PERIPH_NONE) ||
+         (ePeripheral >= AM_HAL_PWRCTRL_PERIPH_MAX) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    psState = &g_sPwrctrlAuto[ePeripheral];
+
+    AM_CRITICAL_BEGIN
+
+    if ( psState->ui32RefCount == 0 )
+    {
+        ui32Status = AM_HAL_STATUS_INVALID_OPERATION;
+    }
+    else if ( --psState->ui32RefCount == 0 )
+    {
+        uint32_t ui32Now = pwrctrl_auto_time();
+
+        if ( (g_sPwrctrlAutoConfig.pfnTimeGet == NULL) ||
+             (psState->ui32IdleTicks == 0) )
+        {
+            ui32Status = pwrctrl_auto_switch(ePeripheral, false, ui32Now);
+        }
+        else
+        {
+            psState->bOffPending = true;
+            psState->ui32OffTime = ui32Now + psState->ui32IdleTicks;
+        }
+    }
+
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_auto_service()
+//  Power down idle peripherals whose hysteresis has expired.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_auto_service(uint32_t *pui32NextTicks)
+{
+    uint32_t ui32Next = 0xFFFFFFFF;
+    uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+
+    AM_CRITICAL_BEGIN
+
+    uint32_t ui32Now = pwrctrl_auto_time();
+
+    for ( uint32_t i = 1; i < AM_HAL_PWRCTRL_PERIPH_MAX; i++ )
+    {
+        am_hal_pwrctrl_auto_state_t *psState = &g_sPwrctrlAuto[i];
+        int32_t i32Remaining;
+
+        if ( !psState->bOffPending )
+        {
+            continue;
+        }
+
+        i32Remaining = (int32_t)(psState->ui32OffTime - ui32Now);
+        if ( i32Remaining > 0 )
+        {
+            if ( (uint32_t)i32Remaining < ui32Next )
+            {
+                ui32Next = i32Remaining;
+            }
+            continue;
+        }
+
+        psState->bOffPending = false;
+        if ( pwrctrl_auto_switch((am_hal_pwrctrl_periph_e)i, false, ui32Now) !=
+             AM_HAL_STATUS_SUCCESS )
+        {
+            ui32Status = AM_HAL_STATUS_FAIL;
+        }
+    }
+
+    AM_CRITICAL_END
+
+    if ( pui32NextTicks )
+    {
+        *pui32NextTicks = ui32Next;
+    }
+
+    return ui32Status;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_periph_stats_get()
+//  Get power statistics for a peripheral.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_periph_stats_get(am_hal_pwrctrl_periph_e ePeripheral,
+                                am_hal_pwrctrl_stats_t *psStats)
+{
+    am_hal_pwrctrl_auto_state_t *psState;
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (ePeripheral == AM_HAL_PWRCTRL_PERIPH_NONE) ||
+         (ePeripheral >= AM_HAL_PWRCTRL_PERIPH_MAX) || (psStats == NULL) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    psState = &g_sPwrctrlAuto[ePeripheral];
+
+    AM_CRITICAL_BEGIN
+    psStats->bPowered = psState->bPowered;
+    psStats->ui32RefCount = psState->ui32RefCount;
+    psStats->ui32PowerOns = psState->ui32PowerOns;
+    psStats->ui64OnTicks = psState->ui64OnTicks;
+    if ( psState->bPowered )
+    {
+        psStats->ui64OnTicks += pwrctrl_auto_time() - psState->ui32OnTime;
+    }
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+// ****************************************************************************
+//
+//  am_hal_pwrctrl_domain_stats_get()
+//  Get power statistics for a power domain.
+//
+// ****************************************************************************
+uint32_t
+am_hal_pwrctrl_domain_stats_get(am_hal_pwrctrl_domain_e eDomain,
+                                am_hal_pwrctrl_stats_t *psStats)
+{
+    am_hal_pwrctrl_domain_state_t *psDomain;
+
+#ifndef AM_HAL_DISABLE_API_VALIDATION
+    if ( (eDomain >= AM_HAL_PWRCTRL_DOMAIN_MAX) || (psStats == NULL) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+#endif // AM_HAL_DISABLE_API_VALIDATION
+
+    psDomain = &g_sPwrctrlDomain[eDomain];
+
+    AM_CRITICAL_BEGIN
+    psStats->bPowered = (psDomain->ui32Powered != 0);
+    psStats->ui32RefCount = psDomain->ui32Powered;
+    psStats->ui32PowerOns = psDomain->ui32PowerOns;
+    psStats->ui64OnTicks = psDomain->ui64OnTicks;
+    if ( psDomain->ui32Powered )
+    {
+        psStats->ui64OnTicks += pwrctrl_auto_time() - psDomain->ui32OnTime;
+    }
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
 //*****************************************************************************
 //
 // End Doxygen group.
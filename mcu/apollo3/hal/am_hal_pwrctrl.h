@@ -103,6 +103,68 @@ typedef enum
 #define AM_HAL_PWRCTRL_MEM_FLASH_MIN    AM_HAL_PWRCTRL_MEM_FLASH_512K
 #define AM_HAL_PWRCTRL_MEM_FLASH_MAX    AM_HAL_PWRCTRL_MEM_FLASH_1M
 
+//
+// Hardware power domains.  Several peripherals may share one domain, which
+// stays powered while any of them is enabled.
+//
+typedef enum
+{
+  AM_HAL_PWRCTRL_DOMAIN_HCPA,       // IOS, UART0, UART1, SCARD
+  AM_HAL_PWRCTRL_DOMAIN_HCPB,       // IOM0, IOM1, IOM2
+  AM_HAL_PWRCTRL_DOMAIN_HCPC,       // IOM3, IOM4, IOM5
+  AM_HAL_PWRCTRL_DOMAIN_ADC,
+  AM_HAL_PWRCTRL_DOMAIN_MSPI,
+  AM_HAL_PWRCTRL_DOMAIN_PDM,
+  AM_HAL_PWRCTRL_DOMAIN_BLEL,
+  AM_HAL_PWRCTRL_DOMAIN_MAX
+} am_hal_pwrctrl_domain_e;
+
+//
+// Time base for the reference counted power manager, in caller defined
+// ticks (e.g. am_hal_stimer_counter_get).
+//
+typedef uint32_t (*am_hal_pwrctrl_time_get_t)(void);
+
+//
+// Called on every power transition made by the power manager.
+//
+typedef void (*am_hal_pwrctrl_trace_t)(am_hal_pwrctrl_periph_e ePeripheral,
+                                       bool bPowered, uint32_t ui32Time);
+
+//
+// Reference counted power manager configuration.
+//
+typedef struct
+{
+  //
+  // Time base.  If NULL, peripherals are powered down as soon as their last
+  // reference is released and no on-time is recorded.
+  //
+  am_hal_pwrctrl_time_get_t pfnTimeGet;
+
+  //
+  // Default time a peripheral stays powered after its last release.
+  //
+  uint32_t                  ui32IdleTicks;
+
+  //
+  // Optional transition trace.
+  //
+  am_hal_pwrctrl_trace_t    pfnTrace;
+} am_hal_pwrctrl_auto_config_t;
+
+//
+// Power statistics for a peripheral or a domain.  ui64OnTicks includes the
+// current on period.
+//
+typedef struct
+{
+  bool                      bPowered;
+  uint32_t                  ui32RefCount;
+  uint32_t                  ui32PowerOns;
+  uint64_t                  ui64OnTicks;
+} am_hal_pwrctrl_stats_t;
+
 
 //*****************************************************************************
 //
@@ -127,7 +189,8 @@ typedef enum
 //! @param ePeripheral - The peripheral to enable.
 //!
 //! This function enables power to the peripheral and waits for a
-//! confirmation from the hardware.
+//! confirmation from the hardware.  It does not take a power manager
+//! reference; see am_hal_pwrctrl_auto_config().
 //!
 //! @return status - generic or interface specific status.
 //
@@ -141,7 +204,8 @@ extern uint32_t am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral
 //! @param ePeripheral - The peripheral to disable.
 //!
 //! This function disables power to the peripheral and waits for a
-//! confirmation from the hardware.
+//! confirmation from the hardware.  It ignores power manager references;
+//! see am_hal_pwrctrl_auto_config().
 //!
 //! @return status - generic or interface specific status.
 //
@@ -194,6 +258,111 @@ extern uint32_t am_hal_pwrctrl_memory_enable(am_hal_pwrctrl_mem_e eMemConfig);
 //*****************************************************************************
 extern uint32_t am_hal_pwrctrl_low_power_init(void);
 
+//*****************************************************************************
+//
+//! @brief Configure the reference counted power manager.
+//!
+//! @param psConfig - time base, default idle hysteresis and trace hook.
+//!
+//! The power manager powers a peripheral on its first
+//! am_hal_pwrctrl_periph_acquire() and powers it down once it has had no
+//! references for its idle time.  Peripherals it manages should not also be
+//! switched with am_hal_pwrctrl_periph_enable()/disable().  Those calls are
+//! not counted: a direct disable powers the peripheral off under its
+//! holders until their next am_hal_pwrctrl_periph_acquire(), and a
+//! peripheral enabled directly is still powered down by the manager's last
+//! release.  The statistics do not see either.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_auto_config(const am_hal_pwrctrl_auto_config_t *psConfig);
+
+//*****************************************************************************
+//
+//! @brief Set the idle hysteresis of one peripheral.
+//!
+//! @param ePeripheral - The peripheral.
+//! @param ui32IdleTicks - Time the peripheral stays powered after its last
+//!                        release.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_periph_idle_set(am_hal_pwrctrl_periph_e ePeripheral,
+                                               uint32_t ui32IdleTicks);
+
+//*****************************************************************************
+//
+//! @brief Take a reference to a peripheral's power.
+//!
+//! @param ePeripheral - The peripheral.
+//!
+//! Powers the peripheral up if it is off and cancels any pending power down.
+//! The peripheral is powered when this function returns successfully, even
+//! if it was switched off with am_hal_pwrctrl_periph_disable() while held.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_periph_acquire(am_hal_pwrctrl_periph_e ePeripheral);
+
+//*****************************************************************************
+//
+//! @brief Drop a reference to a peripheral's power.
+//!
+//! @param ePeripheral - The peripheral.
+//!
+//! When the last reference is dropped the peripheral is scheduled to power
+//! down after its idle time, or powered down at once if that is 0.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_periph_release(am_hal_pwrctrl_periph_e ePeripheral);
+
+//*****************************************************************************
+//
+//! @brief Power down idle peripherals whose hysteresis has expired.
+//!
+//! @param pui32NextTicks - Returns the time until the next scheduled power
+//!                         down, or 0xFFFFFFFF if none is pending.  May be
+//!                         NULL.
+//!
+//! Call this periodically, e.g. before going to sleep.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_auto_service(uint32_t *pui32NextTicks);
+
+//*****************************************************************************
+//
+//! @brief Get power statistics for a peripheral.
+//!
+//! @param ePeripheral - The peripheral.
+//! @param psStats - Returns the statistics.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_periph_stats_get(am_hal_pwrctrl_periph_e ePeripheral,
+                                                am_hal_pwrctrl_stats_t *psStats);
+
+//*****************************************************************************
+//
+//! @brief Get power statistics for a power domain.
+//!
+//! @param eDomain - The power domain.
+//! @param psStats - Returns the statistics.  ui32RefCount is the number of
+//!                  peripherals in the domain powered by the power manager.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+extern uint32_t am_hal_pwrctrl_domain_stats_get(am_hal_pwrctrl_domain_e eDomain,
+                                                am_hal_pwrctrl_stats_t *psStats);
+
 #endif // AM_HAL_PWRCTRL_H
 
 //*****************************************************************************
@@ -126,6 +126,15 @@ static uint32_t g_lastSTimerVal = 0;
 #endif
 #endif
 
+#if configUSE_TICKLESS_STATS == 1
+#if ( configOVERRIDE_DEFAULT_TICK_CONFIGURATION == 0 ) || !defined( AM_FREERTOS_USE_STIMER_FOR_TICK )
+#error "configUSE_TICKLESS_STATS == 1 supported only with the STimer tick and configUSE_TICKLESS_IDLE = 2"
+#endif
+#if ( configTICKLESS_STATS_LOG_LENGTH & ( configTICKLESS_STATS_LOG_LENGTH - 1 ) ) != 0
+#error "configTICKLESS_STATS_LOG_LENGTH must be a power of 2"
+#endif
+#endif
+
 #ifndef __VFP_FP__
 	#error This port can only be used when the project options are configured to enable hardware floating point support.
 #endif
@@ -145,12 +154,16 @@ static uint32_t g_lastSTimerVal = 0;
 #define portNVIC_SYSTICK_LOAD_REG			( * ( ( volatile uint32_t * ) 0xe000e014 ) )
 #define portNVIC_SYSTICK_CURRENT_VALUE_REG	( * ( ( volatile uint32_t * ) 0xe000e018 ) )
 #define portNVIC_SYSPRI2_REG				( * ( ( volatile uint32_t * ) 0xe000ed20 ) )
+#define portNVIC_ISER0_REG					( * ( ( volatile uint32_t * ) 0xe000e100 ) )
+#define portNVIC_ISPR0_REG					( * ( ( volatile uint32_t * ) 0xe000e200 ) )
+#define portSCB_SCR_REG						( * ( ( volatile uint32_t * ) 0xe000ed10 ) )
 /* ...then bits in the registers. */
 #define portNVIC_SYSTICK_INT_BIT			( 1UL << 1UL )
 #define portNVIC_SYSTICK_ENABLE_BIT			( 1UL << 0UL )
 #define portNVIC_SYSTICK_COUNT_FLAG_BIT		( 1UL << 16UL )
 #define portNVIC_PENDSVCLEAR_BIT 			( 1UL << 27UL )
 #define portNVIC_PEND_SYSTICK_CLEAR_BIT		( 1UL << 25UL )
+#define portSCB_SCR_SLEEPDEEP_BIT			( 1UL << 2UL )
 
 /* Constants used to detect a Cortex-M7 r0p1 core, which should use the ARM_CM7
 r0p1 port. */
@@ -882,12 +895,169 @@ static void vPortEnableVFP( void )
  */
 	static uint32_t xMaximumPossibleSuppressedTicks = 0;
 
+#if( configUSE_TICKLESS_STATS == 1 )
+	/* Only changed by the idle task with interrupts disabled, and read by
+	tasks from within a critical section. */
+	static TicklessStats_t xTicklessStats;
+
+	/* STIMER count ullElapsedCounts has been brought up to. */
+	static uint32_t ulTicklessLastCount = 0;
+
+	/* g_lastSTimerVal and the tick count when the statistics were reset, for
+	the drift. */
+	static uint32_t ulTicklessBaseSTimerVal = 0;
+	static TickType_t xTicklessBaseTickCount = 0;
+
+	#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+		static TicklessSleep_t xTicklessLog[ configTICKLESS_STATS_LOG_LENGTH ];
+		static uint32_t ulTicklessLogHead = 0;
+		static uint32_t ulTicklessLogTail = 0;
+	#endif
+
+static void prvTicklessStatsElapsed( uint32_t ulNow )
+{
+	xTicklessStats.ullElapsedCounts += ( uint32_t ) ( ulNow - ulTicklessLastCount );
+	ulTicklessLastCount = ulNow;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTicklessStatsReset( void )
+{
+	xTicklessStats = ( TicklessStats_t ) { 0 };
+	ulTicklessLastCount = am_hal_stimer_counter_get();
+	ulTicklessBaseSTimerVal = g_lastSTimerVal;
+	xTicklessBaseTickCount = xTaskGetTickCount();
+
+	#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+	{
+		ulTicklessLogTail = ulTicklessLogHead;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvTicklessStatsRecord( const TicklessSleep_t *pxSleep )
+{
+uint32_t ulWakeInterrupts = pxSleep->ulWakeInterrupts;
+
+	prvTicklessStatsElapsed( pxSleep->ulStartCount + pxSleep->ulSleepCounts );
+
+	xTicklessStats.ulSleeps++;
+	xTicklessStats.ullSleepCounts += pxSleep->ulSleepCounts;
+	if( pxSleep->ucClamped != pdFALSE )
+	{
+		xTicklessStats.ulClampedSleeps++;
+		xTicklessStats.ullClampedSteppedTicks += pxSleep->xSteppedTicks;
+	}
+	else
+	{
+		xTicklessStats.ullExpectedIdleTicks += pxSleep->xExpectedIdleTime;
+		xTicklessStats.ullSteppedTicks += pxSleep->xSteppedTicks;
+	}
+
+	if( pxSleep->ucDeepSleep != pdFALSE )
+	{
+		xTicklessStats.ulDeepSleeps++;
+		xTicklessStats.ullDeepSleepCounts += pxSleep->ulSleepCounts;
+	}
+
+	if( pxSleep->ucEarlyWake != pdFALSE )
+	{
+		xTicklessStats.ulEarlyWakes++;
+	}
+
+	if( ulWakeInterrupts == 0 )
+	{
+		xTicklessStats.ulWakeSources[ portTICKLESS_WAKE_NONE ]++;
+	}
+
+	while( ulWakeInterrupts != 0 )
+	{
+		xTicklessStats.ulWakeSources[ __builtin_ctz( ulWakeInterrupts ) ]++;
+		ulWakeInterrupts &= ulWakeInterrupts - 1;
+	}
+
+	#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+	{
+		if( ( ulTicklessLogHead - ulTicklessLogTail ) < configTICKLESS_STATS_LOG_LENGTH )
+		{
+			xTicklessLog[ ulTicklessLogHead & ( configTICKLESS_STATS_LOG_LENGTH - 1 ) ] = *pxSleep;
+			ulTicklessLogHead++;
+		}
+		else
+		{
+			xTicklessStats.ulLogDropped++;
+		}
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetTicklessStats( TicklessStats_t *pxStats )
+{
+	taskENTER_CRITICAL();
+	{
+		prvTicklessStatsElapsed( am_hal_stimer_counter_get() );
+
+		/* g_lastSTimerVal only moves a whole number of ticks at a time, and
+		the tick count moves with it, so any difference is time the tick count
+		has lost or gained. */
+		xTicklessStats.lDriftCounts = ( int32_t ) ( ( g_lastSTimerVal - ulTicklessBaseSTimerVal ) -
+			( uint32_t ) ( xTaskGetTickCount() - xTicklessBaseTickCount ) * ulTimerCountsForOneTick );
+
+		*pxStats = xTicklessStats;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vPortResetTicklessStats( void )
+{
+	taskENTER_CRITICAL();
+	{
+		prvTicklessStatsReset();
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGetTicklessSleep( TicklessSleep_t *pxSleep )
+{
+BaseType_t xReturn = pdFALSE;
+
+	#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( ulTicklessLogTail != ulTicklessLogHead )
+			{
+				*pxSleep = xTicklessLog[ ulTicklessLogTail & ( configTICKLESS_STATS_LOG_LENGTH - 1 ) ];
+				ulTicklessLogTail++;
+				xReturn = pdTRUE;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+	#else
+	{
+		( void ) pxSleep;
+	}
+	#endif
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+#endif /* configUSE_TICKLESS_STATS */
+
 void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 {
 	uint32_t ulReloadValue;
     uint32_t New_Timer, Delta_Sleep;
 	TickType_t xModifiableIdleTime;
     uint32_t elapsed_time;
+#if( configUSE_TICKLESS_STATS == 1 )
+	TicklessSleep_t xSleep;
+#endif
 
 	/* Make sure the SysTick reload value does not overflow the counter. */
 	if( xExpectedIdleTime > xMaximumPossibleSuppressedTicks )
@@ -923,6 +1093,9 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 	{
 #ifndef AM_FREERTOS_USE_STIMER_FOR_TICK
         am_hal_ctimer_start(configCTIMER_NUM, AM_HAL_CTIMER_BOTH);
+#endif
+#if( configUSE_TICKLESS_STATS == 1 )
+		xTicklessStats.ulAbortedSleeps++;
 #endif
 		/* Re-enable interrupts - see comments above the cpsid instruction()
 		above. */
@@ -948,6 +1121,10 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 		time variable must remain unmodified, so a copy is taken. */
 		xModifiableIdleTime = xExpectedIdleTime;
 
+#if( configUSE_TICKLESS_STATS == 1 )
+		xSleep.ulStartCount = am_hal_stimer_counter_get();
+#endif
+
 		configPRE_SLEEP_PROCESSING( xModifiableIdleTime );       // Turn OFF all Periphials in this function
 
 		if( xModifiableIdleTime > 0 )
@@ -957,6 +1134,15 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 			__asm volatile( "isb" );
 		}
 
+#if( configUSE_TICKLESS_STATS == 1 )
+		/* Interrupts are still disabled, so whatever ended the sleep is still
+		pending. */
+		xSleep.ulSleepCounts = am_hal_stimer_counter_get() - xSleep.ulStartCount;
+		xSleep.ulWakeInterrupts = portNVIC_ISPR0_REG & portNVIC_ISER0_REG;
+		xSleep.ucDeepSleep = ( ( portSCB_SCR_REG & portSCB_SCR_SLEEPDEEP_BIT ) != 0 ) ? pdTRUE : pdFALSE;
+		xSleep.ucEarlyWake = ( ( am_hal_stimer_int_status_get(false) & AM_HAL_STIMER_INT_COMPAREA ) == 0 ) ? pdTRUE : pdFALSE;
+#endif
+
 		configPOST_SLEEP_PROCESSING( xExpectedIdleTime );       // Turn ON all Periphials in this function
 
         // Any interrupt may have woken us up
@@ -991,6 +1177,15 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
         // Correct System Tick after Sleep
         vTaskStepTick( Delta_Sleep );
 
+#if( configUSE_TICKLESS_STATS == 1 )
+		xSleep.xExpectedIdleTime = xExpectedIdleTime;
+		/* The kernel asks for the full reach only when it has no timeout to
+		wait for, so treat an exact fit as clamped too. */
+		xSleep.ucClamped = ( xExpectedIdleTime >= xMaximumPossibleSuppressedTicks ) ? pdTRUE : pdFALSE;
+		xSleep.xSteppedTicks = Delta_Sleep;
+		prvTicklessStatsRecord( &xSleep );
+#endif
+
 		/* Restart System Tick */
 #ifdef AM_FREERTOS_USE_STIMER_FOR_TICK
 
@@ -1184,6 +1379,9 @@ void vPortSetupTimerInterrupt( void )
     oldCfg = am_hal_stimer_config(AM_HAL_STIMER_CFG_FREEZE);
     g_lastSTimerVal = am_hal_stimer_counter_get();
     am_hal_stimer_compare_delta_set(0, ulTimerCountsForOneTick);
+#if( configUSE_TICKLESS_STATS == 1 )
+    prvTicklessStatsReset();
+#endif
 #if AM_CMSIS_REGS
     am_hal_stimer_config((oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE|CTIMER_STCFG_CLKSEL_Msk)) | configSTIMER_CLOCK | AM_HAL_STIMER_CFG_COMPARE_A_ENABLE);
 #else // AM_CMSIS_REGS
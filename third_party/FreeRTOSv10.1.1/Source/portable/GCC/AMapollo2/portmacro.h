@@ -117,6 +117,65 @@ not necessary for to use this port.  They are defined so the common demo files
 	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
 	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
 #endif
+
+/* Tickless idle statistics, kept by vPortSuppressTicksAndSleep() when
+configUSE_TICKLESS_IDLE is 2 and the STIMER provides the tick.  Times are in
+STIMER counts (configSTIMER_CLOCK_HZ). */
+#ifndef configUSE_TICKLESS_STATS
+	#define configUSE_TICKLESS_STATS 0
+#endif
+
+#if( configUSE_TICKLESS_STATS == 1 )
+
+	/* Number of sleeps kept for xPortGetTicklessSleep(), a power of 2.  0 keeps
+	only the totals. */
+	#ifndef configTICKLESS_STATS_LOG_LENGTH
+		#define configTICKLESS_STATS_LOG_LENGTH 16
+	#endif
+
+	/* Wakes are counted per interrupt line (0-31), and in the last entry when no
+	enabled interrupt was pending. */
+	#define portTICKLESS_WAKE_NONE		32
+	#define portTICKLESS_WAKE_SOURCES	( portTICKLESS_WAKE_NONE + 1 )
+
+	/* One sleep. */
+	typedef struct xTICKLESS_SLEEP
+	{
+		uint32_t ulStartCount;			/* STIMER count when the core went to sleep. */
+		uint32_t ulSleepCounts;			/* Time asleep, up to the wake. */
+		TickType_t xExpectedIdleTime;	/* Ticks the kernel expected to be idle, after clamping to what the timer can reach. */
+		TickType_t xSteppedTicks;		/* Ticks the tick count was stepped by on wake. */
+		uint32_t ulWakeInterrupts;		/* Enabled interrupts pending on wake, one bit per line. */
+		uint8_t ucDeepSleep;			/* pdTRUE if the core was set for deep sleep. */
+		uint8_t ucEarlyWake;			/* pdTRUE if something other than the tick timer ended the sleep. */
+		uint8_t ucClamped;				/* pdTRUE if the kernel expected to be idle for at least as long as the timer can reach, as it does when every task is blocked indefinitely. */
+	} TicklessSleep_t;
+
+	/* Totals since the scheduler started or vPortResetTicklessStats(). */
+	typedef struct xTICKLESS_STATS
+	{
+		uint32_t ulSleeps;				/* Sleeps entered. */
+		uint32_t ulAbortedSleeps;		/* Sleeps abandoned because a task became ready or the idle time was too short. */
+		uint32_t ulEarlyWakes;			/* Sleeps ended before the tick timer expired. */
+		uint32_t ulDeepSleeps;			/* Sleeps with the core set for deep sleep. */
+		uint64_t ullElapsedCounts;		/* Time the statistics cover. */
+		uint64_t ullSleepCounts;		/* Time asleep. */
+		uint64_t ullDeepSleepCounts;	/* Time in deep sleep. */
+		uint32_t ulClampedSleeps;		/* Sleeps with ucClamped set.  Their expected idle time is only the timer's reach, so they are left out of the next two sums. */
+		uint64_t ullExpectedIdleTicks;	/* Sum of the ticks the kernel expected to be idle, over sleeps that were not clamped. */
+		uint64_t ullSteppedTicks;		/* Sum of the ticks stepped on wake, over the same sleeps. */
+		uint64_t ullClampedSteppedTicks;	/* Sum of the ticks stepped on wake by clamped sleeps. */
+		int32_t lDriftCounts;			/* STIMER time at the last tick less the time the tick count accounts for.  Stays 0 unless ticks are lost or gained. */
+		uint32_t ulLogDropped;			/* Sleeps not logged because the log was full. */
+		uint32_t ulWakeSources[ portTICKLESS_WAKE_SOURCES ];
+	} TicklessStats_t;
+
+	/* These must be called from a task. */
+	void vPortGetTicklessStats( TicklessStats_t *pxStats );
+	void vPortResetTicklessStats( void );
+	BaseType_t xPortGetTicklessSleep( TicklessSleep_t *pxSleep );
+
+#endif /* configUSE_TICKLESS_STATS */
 /*-----------------------------------------------------------*/
 
 /* Architecture specific optimisations. */
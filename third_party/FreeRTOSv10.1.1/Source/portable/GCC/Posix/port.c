@@ -0,0 +1,1025 @@
+/*
+ * FreeRTOS Kernel V10.1.1
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the Posix (Linux)
+ * host simulator port.
+ *
+ * Each task runs on its own pthread and only the thread of the running task
+ * makes progress: a context switch wakes the next thread and parks the
+ * current one.  Interrupts are simulated with signals.  SIGALRM is the STIMER
+ * compare interrupt that drives the tick and SIGUSR1 carries the simulated
+ * peripheral interrupt lines.  Only the running task leaves these signals
+ * unblocked, so handlers always run on top of the running task, as an ISR
+ * would.  Masking interrupts blocks the signals.
+ *
+ * The tick and tickless idle code follow the STIMER implementation in the
+ * AMapollo2 port, so host runs exercise the same tick accounting.
+ *
+ * A signal can switch tasks while the running task is inside the C library.
+ * Tasks must not share non async-signal-safe library state (stdio, malloc)
+ * unless they hold a critical section around it.
+ *----------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef configSTIMER_CLOCK_HZ
+#define configSTIMER_CLOCK_HZ   32768
+#endif
+
+/* The Stimer is a 32-bit counter. */
+#define portMAX_32_BIT_NUMBER		( 0xffffffffUL )
+
+/* Signals used for the simulated interrupts. */
+#define portSIM_TICK_SIGNAL			SIGALRM
+#define portSIM_INTERRUPT_SIGNAL	SIGUSR1
+
+#define portNS_PER_SECOND			1000000000ULL
+
+/*-----------------------------------------------------------*/
+
+/* Binary event a thread can wait on. */
+typedef struct xPORT_SIM_EVENT
+{
+	pthread_mutex_t xMutex;
+	pthread_cond_t xCond;
+	BaseType_t xSet;
+} PortSimEvent_t;
+
+/* Thread that runs a task.  It is kept at the top of the task's stack, and
+the task's pxTopOfStack points at it.  The thread itself runs on a host
+stack, as FreeRTOS stack sizes are far too small for the C library. */
+typedef struct xPORT_SIM_THREAD
+{
+	pthread_t xThread;
+	TaskFunction_t pxCode;
+	void *pvParameters;
+	PortSimEvent_t xEvent;
+	volatile BaseType_t xDying;
+} PortSimThread_t;
+
+/*-----------------------------------------------------------*/
+
+/* The TCB of the running task.  The first TCB member is pxTopOfStack. */
+extern void * volatile pxCurrentTCB;
+
+static pthread_once_t xPortSetupOnce = PTHREAD_ONCE_INIT;
+static sigset_t xInterruptSignals;
+static timer_t xStimerCompare;
+static uint64_t ullStimerStartNs;
+static PortSimEvent_t xSchedulerEnd;
+
+/* Critical nesting of the running task.  Each thread saves its own value
+while it is switched out. */
+static volatile UBaseType_t uxCriticalNesting = 0;
+
+static volatile BaseType_t xInsideInterrupt = pdFALSE;
+static volatile BaseType_t xSwitchPending = pdFALSE;
+
+/* Simulated peripheral interrupt lines. */
+static void ( * volatile pxInterruptHandlers[ portSIM_INTERRUPT_LINES ] )( void );
+static uint32_t ulInterruptsPending;
+static uint64_t ullInterruptTriggerNs[ portSIM_INTERRUPT_LINES ];
+
+static PortSimStats_t xStats;
+static uint64_t ullSchedulerStartNs;
+static uint64_t ullSchedulerEndNs;
+
+/* Number of STIMER counts in one tick. */
+static uint32_t ulTimerCountsForOneTick = 0;
+
+/* Keeps the snapshot of the STimer corresponding to last tick update */
+static uint32_t g_lastSTimerVal = 0;
+
+#if configUSE_TICKLESS_IDLE != 0
+	/* The maximum number of tick periods that can be suppressed is limited
+	by the 32 bit resolution of the STIMER. */
+	static uint32_t xMaximumPossibleSuppressedTicks = 0;
+#endif
+
+/* Simulated SCB->SCR SLEEPDEEP. */
+static volatile BaseType_t xSleepDeep = pdFALSE;
+
+#if configUSE_TICKLESS_STATS == 1
+#if configUSE_TICKLESS_IDLE == 0
+#error "configUSE_TICKLESS_STATS == 1 needs configUSE_TICKLESS_IDLE"
+#endif
+#if ( configTICKLESS_STATS_LOG_LENGTH & ( configTICKLESS_STATS_LOG_LENGTH - 1 ) ) != 0
+#error "configTICKLESS_STATS_LOG_LENGTH must be a power of 2"
+#endif
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Setup the tick interrupt.
+ */
+void vPortSetupTimerInterrupt( void );
+
+static void prvPortSetup( void );
+static void prvInterruptHandler( int iSignal );
+static void *prvThreadStart( void *pvParameters );
+static void prvStimerCompareDeltaSet( uint32_t ulDelta );
+static void prvStimerIntClear( void );
+static void prvStimerTickHandler( void );
+
+#if configUSE_TICKLESS_STATS == 1
+	static void prvTicklessStatsReset( void );
+#endif
+
+/*-----------------------------------------------------------*/
+
+static void prvEventInit( PortSimEvent_t *pxEvent )
+{
+	pthread_mutex_init( &pxEvent->xMutex, NULL );
+	pthread_cond_init( &pxEvent->xCond, NULL );
+	pxEvent->xSet = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventDelete( PortSimEvent_t *pxEvent )
+{
+	pthread_cond_destroy( &pxEvent->xCond );
+	pthread_mutex_destroy( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventSignal( PortSimEvent_t *pxEvent )
+{
+	pthread_mutex_lock( &pxEvent->xMutex );
+	pxEvent->xSet = pdTRUE;
+	pthread_cond_signal( &pxEvent->xCond );
+	pthread_mutex_unlock( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventWait( PortSimEvent_t *pxEvent )
+{
+	pthread_mutex_lock( &pxEvent->xMutex );
+	while( pxEvent->xSet == pdFALSE )
+	{
+		pthread_cond_wait( &pxEvent->xCond, &pxEvent->xMutex );
+	}
+	pxEvent->xSet = pdFALSE;
+	pthread_mutex_unlock( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static PortSimThread_t *prvGetThreadFromTask( void *pxTask )
+{
+	return *( PortSimThread_t ** ) pxTask;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSuspendSelf( PortSimThread_t *pxThread )
+{
+	prvEventWait( &pxThread->xEvent );
+
+	if( pxThread->xDying != pdFALSE )
+	{
+		pthread_exit( NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchThread( PortSimThread_t *pxThreadToResume, PortSimThread_t *pxThreadToSuspend )
+{
+UBaseType_t uxSavedCriticalNesting;
+
+	if( pxThreadToResume != pxThreadToSuspend )
+	{
+		xStats.ulContextSwitches++;
+
+		uxSavedCriticalNesting = uxCriticalNesting;
+		prvEventSignal( &pxThreadToResume->xEvent );
+		prvSuspendSelf( pxThreadToSuspend );
+		uxCriticalNesting = uxSavedCriticalNesting;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Select the next task and switch to it.  Called with interrupts masked.
+ */
+static void prvYield( void )
+{
+PortSimThread_t *pxThreadToSuspend;
+
+	pxThreadToSuspend = prvGetThreadFromTask( pxCurrentTCB );
+	vTaskSwitchContext();
+	prvSwitchThread( prvGetThreadFromTask( pxCurrentTCB ), pxThreadToSuspend );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+PortSimThread_t *pxThread;
+sigset_t xSavedMask;
+int iResult;
+
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+
+	pxThread = ( PortSimThread_t * ) ( ( ( portPOINTER_SIZE_TYPE ) ( pxTopOfStack + 1 ) - sizeof( PortSimThread_t ) ) &
+									   ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) );
+	memset( pxThread, 0, sizeof( PortSimThread_t ) );
+	pxThread->pxCode = pxCode;
+	pxThread->pvParameters = pvParameters;
+	prvEventInit( &pxThread->xEvent );
+
+	/* The thread inherits masked interrupts and unmasks them when it is
+	first scheduled.  Masking also keeps a switch from landing inside
+	pthread_create(). */
+	pthread_sigmask( SIG_BLOCK, &xInterruptSignals, &xSavedMask );
+	iResult = pthread_create( &pxThread->xThread, NULL, prvThreadStart, pxThread );
+	pthread_sigmask( SIG_SETMASK, &xSavedMask, NULL );
+
+	configASSERT( iResult == 0 );
+	( void ) iResult;
+
+	return ( StackType_t * ) pxThread;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvThreadStart( void *pvParameters )
+{
+PortSimThread_t *pxThread = ( PortSimThread_t * ) pvParameters;
+
+	/* Wait to be scheduled for the first time. */
+	prvSuspendSelf( pxThread );
+
+	uxCriticalNesting = 0;
+	vPortEnableInterrupts();
+
+	pxThread->pxCode( pxThread->pvParameters );
+
+	/* A function that implements a task must not exit or attempt to return
+	to its caller as there is nothing to return to.  If a task wants to exit
+	it should instead call vTaskDelete( NULL ). */
+	configASSERT( pdFALSE );
+	vPortDisableInterrupts();
+	for( ;; )
+	{
+		pause();
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCancelThread( void *pxTaskToDelete )
+{
+PortSimThread_t *pxThread = prvGetThreadFromTask( pxTaskToDelete );
+
+	/* The thread of a deleted task is always parked.  Wake it so that it
+	exits, then reclaim it before its stack is freed. */
+	pxThread->xDying = pdTRUE;
+	prvEventSignal( &pxThread->xEvent );
+	pthread_join( pxThread->xThread, NULL );
+	prvEventDelete( &pxThread->xEvent );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+BaseType_t xPortStartScheduler( void )
+{
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+
+	/* The thread that starts the scheduler is not a task, so it never takes
+	an interrupt. */
+	vPortDisableInterrupts();
+
+	ullSchedulerStartNs = ullPortSimTimeNs();
+	ullSchedulerEndNs = 0;
+
+	/* Start the timer that generates the tick ISR. */
+	vPortSetupTimerInterrupt();
+
+	/* Start the first task. */
+	prvEventSignal( &prvGetThreadFromTask( pxCurrentTCB )->xEvent );
+
+	/* Wait for vPortEndScheduler(). */
+	prvEventWait( &xSchedulerEnd );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Stops the simulation and returns from xPortStartScheduler().  Unlike on
+ * the target, this may be called from a thread that is not a task, which
+ * lets a test harness end a run.
+ */
+void vPortEndScheduler( void )
+{
+struct itimerspec xDisarm;
+
+	memset( &xDisarm, 0, sizeof( xDisarm ) );
+	timer_settime( xStimerCompare, 0, &xDisarm, NULL );
+	ullSchedulerEndNs = ullPortSimTimeNs();
+
+	prvEventSignal( &xSchedulerEnd );
+
+	/* A task that ends the scheduler never runs again. */
+	if( pthread_equal( prvGetThreadFromTask( pxCurrentTCB )->xThread, pthread_self() ) )
+	{
+		vPortDisableInterrupts();
+		for( ;; )
+		{
+			pause();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	if( xInsideInterrupt != pdFALSE )
+	{
+		xSwitchPending = pdTRUE;
+		return;
+	}
+
+	vPortEnterCritical();
+	prvYield();
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndSwitchingISR( BaseType_t xSwitchRequired )
+{
+	if( xSwitchRequired != pdFALSE )
+	{
+		vPortYield();
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortIsInsideInterrupt( void )
+{
+	return xInsideInterrupt;
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+	pthread_sigmask( SIG_BLOCK, &xInterruptSignals, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+	pthread_sigmask( SIG_UNBLOCK, &xInterruptSignals, NULL );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+sigset_t xSavedMask;
+
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+	pthread_sigmask( SIG_BLOCK, &xInterruptSignals, &xSavedMask );
+
+	return ( UBaseType_t ) sigismember( &xSavedMask, portSIM_TICK_SIGNAL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxMask )
+{
+	if( uxMask == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	configASSERT( uxCriticalNesting );
+	uxCriticalNesting--;
+	if( uxCriticalNesting == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPortSetup( void )
+{
+struct sigaction xAction;
+struct sigevent xCompareEvent;
+
+	sigemptyset( &xInterruptSignals );
+	sigaddset( &xInterruptSignals, portSIM_TICK_SIGNAL );
+	sigaddset( &xInterruptSignals, portSIM_INTERRUPT_SIGNAL );
+
+	/* Interrupts do not nest. */
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvInterruptHandler;
+	xAction.sa_mask = xInterruptSignals;
+	xAction.sa_flags = SA_RESTART;
+	sigaction( portSIM_TICK_SIGNAL, &xAction, NULL );
+	sigaction( portSIM_INTERRUPT_SIGNAL, &xAction, NULL );
+
+	/* The STIMER compare is a one-shot host timer on the same clock as the
+	simulated counter. */
+	memset( &xCompareEvent, 0, sizeof( xCompareEvent ) );
+	xCompareEvent.sigev_notify = SIGEV_SIGNAL;
+	xCompareEvent.sigev_signo = portSIM_TICK_SIGNAL;
+	timer_create( CLOCK_MONOTONIC, &xCompareEvent, &xStimerCompare );
+
+	prvEventInit( &xSchedulerEnd );
+	ullStimerStartNs = ullPortSimTimeNs();
+}
+/*-----------------------------------------------------------*/
+
+static void prvInterruptHandler( int iSignal )
+{
+uint32_t ulPending;
+uint64_t ullLatencyNs;
+UBaseType_t uxLine;
+int iSavedErrno = errno;
+
+	/* Interrupts stay masked until the handler returns. */
+	uxCriticalNesting++;
+	xInsideInterrupt = pdTRUE;
+
+	if( iSignal == portSIM_TICK_SIGNAL )
+	{
+		xStats.ulTickInterrupts++;
+		prvStimerTickHandler();
+	}
+	else
+	{
+		ulPending = __atomic_exchange_n( &ulInterruptsPending, 0, __ATOMIC_ACQ_REL );
+
+		for( uxLine = 0; ulPending != 0; uxLine++, ulPending >>= 1 )
+		{
+			if( ( ( ulPending & 1UL ) != 0 ) && ( pxInterruptHandlers[ uxLine ] != NULL ) )
+			{
+				ullLatencyNs = ullPortSimTimeNs() - __atomic_load_n( &ullInterruptTriggerNs[ uxLine ], __ATOMIC_ACQUIRE );
+				xStats.ulInterrupts++;
+				xStats.ullInterruptLatencyNs += ullLatencyNs;
+				if( ullLatencyNs > xStats.ullMaxInterruptLatencyNs )
+				{
+					xStats.ullMaxInterruptLatencyNs = ullLatencyNs;
+				}
+
+				pxInterruptHandlers[ uxLine ]();
+			}
+		}
+	}
+
+	xInsideInterrupt = pdFALSE;
+
+	/* Switch on the way out of the interrupt, as PendSV would. */
+	if( xSwitchPending != pdFALSE )
+	{
+		xSwitchPending = pdFALSE;
+		prvYield();
+	}
+
+	uxCriticalNesting--;
+	errno = iSavedErrno;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * STIMER compare interrupt.  Counts every tick period that has passed since
+ * the last tick update, as on the target, so that interrupt latency does not
+ * lose ticks.
+ */
+static void prvStimerTickHandler( void )
+{
+uint32_t remainder = 0;
+uint32_t curSTimer;
+uint32_t timerCounts;
+uint32_t numTicksElapsed;
+
+	curSTimer = ulPortSimStimerCounterGet();
+
+	/* Configure the compare for the next tick. */
+	prvStimerCompareDeltaSet( ulTimerCountsForOneTick );
+
+	timerCounts = curSTimer - g_lastSTimerVal;
+	numTicksElapsed = timerCounts / ulTimerCountsForOneTick;
+	remainder = timerCounts % ulTimerCountsForOneTick;
+	g_lastSTimerVal = curSTimer - remainder;
+
+	while( numTicksElapsed-- )
+	{
+		if( xTaskIncrementTick() != pdFALSE )
+		{
+			/* A context switch is required on the way out of the
+			interrupt. */
+			xSwitchPending = pdTRUE;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetupTimerInterrupt( void )
+{
+	/* Calculate the constants required to configure the tick interrupt. */
+	ulTimerCountsForOneTick = configSTIMER_CLOCK_HZ / configTICK_RATE_HZ;
+	#if configUSE_TICKLESS_IDLE != 0
+	{
+		xMaximumPossibleSuppressedTicks = portMAX_32_BIT_NUMBER / ulTimerCountsForOneTick;
+	}
+	#endif
+
+	g_lastSTimerVal = ulPortSimStimerCounterGet();
+	prvStimerCompareDeltaSet( ulTimerCountsForOneTick );
+
+	#if configUSE_TICKLESS_STATS == 1
+	{
+		prvTicklessStatsReset();
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+#if configUSE_TICKLESS_STATS == 1
+
+	/* Only changed by the idle task with interrupts masked, and read by
+	tasks from within a critical section. */
+	static TicklessStats_t xTicklessStats;
+
+	/* STIMER count ullElapsedCounts has been brought up to. */
+	static uint32_t ulTicklessLastCount = 0;
+
+	/* g_lastSTimerVal and the tick count when the statistics were reset, for
+	the drift. */
+	static uint32_t ulTicklessBaseSTimerVal = 0;
+	static TickType_t xTicklessBaseTickCount = 0;
+
+	#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+		static TicklessSleep_t xTicklessLog[ configTICKLESS_STATS_LOG_LENGTH ];
+		static uint32_t ulTicklessLogHead = 0;
+		static uint32_t ulTicklessLogTail = 0;
+	#endif
+
+	static void prvTicklessStatsElapsed( uint32_t ulNow )
+	{
+		xTicklessStats.ullElapsedCounts += ( uint32_t ) ( ulNow - ulTicklessLastCount );
+		ulTicklessLastCount = ulNow;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTicklessStatsReset( void )
+	{
+		memset( &xTicklessStats, 0, sizeof( xTicklessStats ) );
+		ulTicklessLastCount = ulPortSimStimerCounterGet();
+		ulTicklessBaseSTimerVal = g_lastSTimerVal;
+		xTicklessBaseTickCount = xTaskGetTickCount();
+
+		#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+		{
+			ulTicklessLogTail = ulTicklessLogHead;
+		}
+		#endif
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTicklessStatsRecord( const TicklessSleep_t *pxSleep )
+	{
+	uint32_t ulWakeInterrupts = pxSleep->ulWakeInterrupts;
+
+		prvTicklessStatsElapsed( pxSleep->ulStartCount + pxSleep->ulSleepCounts );
+
+		xTicklessStats.ulSleeps++;
+		xTicklessStats.ullSleepCounts += pxSleep->ulSleepCounts;
+		if( pxSleep->ucClamped != pdFALSE )
+		{
+			xTicklessStats.ulClampedSleeps++;
+			xTicklessStats.ullClampedSteppedTicks += pxSleep->xSteppedTicks;
+		}
+		else
+		{
+			xTicklessStats.ullExpectedIdleTicks += pxSleep->xExpectedIdleTime;
+			xTicklessStats.ullSteppedTicks += pxSleep->xSteppedTicks;
+		}
+
+		if( pxSleep->ucDeepSleep != pdFALSE )
+		{
+			xTicklessStats.ulDeepSleeps++;
+			xTicklessStats.ullDeepSleepCounts += pxSleep->ulSleepCounts;
+		}
+
+		if( pxSleep->ucEarlyWake != pdFALSE )
+		{
+			xTicklessStats.ulEarlyWakes++;
+		}
+
+		if( ulWakeInterrupts == 0 )
+		{
+			xTicklessStats.ulWakeSources[ portTICKLESS_WAKE_NONE ]++;
+		}
+
+		while( ulWakeInterrupts != 0 )
+		{
+			xTicklessStats.ulWakeSources[ __builtin_ctz( ulWakeInterrupts ) ]++;
+			ulWakeInterrupts &= ulWakeInterrupts - 1;
+		}
+
+		#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+		{
+			if( ( ulTicklessLogHead - ulTicklessLogTail ) < configTICKLESS_STATS_LOG_LENGTH )
+			{
+				xTicklessLog[ ulTicklessLogHead & ( configTICKLESS_STATS_LOG_LENGTH - 1 ) ] = *pxSleep;
+				ulTicklessLogHead++;
+			}
+			else
+			{
+				xTicklessStats.ulLogDropped++;
+			}
+		}
+		#endif
+	}
+	/*-----------------------------------------------------------*/
+
+	/*
+	 * Enabled interrupt lines with an interrupt pending, and whether the tick
+	 * compare is pending.  Called with interrupts masked.
+	 */
+	static uint32_t prvPendingInterrupts( BaseType_t *pxTickPending )
+	{
+	sigset_t xPending;
+	uint32_t ulPending;
+	UBaseType_t uxLine;
+
+		sigpending( &xPending );
+		*pxTickPending = ( sigismember( &xPending, portSIM_TICK_SIGNAL ) == 1 ) ? pdTRUE : pdFALSE;
+
+		ulPending = __atomic_load_n( &ulInterruptsPending, __ATOMIC_ACQUIRE );
+		for( uxLine = 0; uxLine < portSIM_INTERRUPT_LINES; uxLine++ )
+		{
+			if( pxInterruptHandlers[ uxLine ] == NULL )
+			{
+				ulPending &= ~( 1UL << uxLine );
+			}
+		}
+
+		return ulPending;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortGetTicklessStats( TicklessStats_t *pxStats )
+	{
+		portENTER_CRITICAL();
+		{
+			prvTicklessStatsElapsed( ulPortSimStimerCounterGet() );
+
+			/* g_lastSTimerVal only moves a whole number of ticks at a time,
+			and the tick count moves with it, so any difference is time the
+			tick count has lost or gained. */
+			xTicklessStats.lDriftCounts = ( int32_t ) ( ( g_lastSTimerVal - ulTicklessBaseSTimerVal ) -
+				( uint32_t ) ( xTaskGetTickCount() - xTicklessBaseTickCount ) * ulTimerCountsForOneTick );
+
+			*pxStats = xTicklessStats;
+		}
+		portEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortResetTicklessStats( void )
+	{
+		portENTER_CRITICAL();
+		{
+			prvTicklessStatsReset();
+		}
+		portEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xPortGetTicklessSleep( TicklessSleep_t *pxSleep )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		#if( configTICKLESS_STATS_LOG_LENGTH > 0 )
+		{
+			portENTER_CRITICAL();
+			{
+				if( ulTicklessLogTail != ulTicklessLogHead )
+				{
+					*pxSleep = xTicklessLog[ ulTicklessLogTail & ( configTICKLESS_STATS_LOG_LENGTH - 1 ) ];
+					ulTicklessLogTail++;
+					xReturn = pdTRUE;
+				}
+			}
+			portEXIT_CRITICAL();
+		}
+		#else
+		{
+			( void ) pxSleep;
+		}
+		#endif
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* configUSE_TICKLESS_STATS */
+
+#if configUSE_TICKLESS_IDLE != 0
+
+	void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+	{
+	uint32_t ulReloadValue;
+	uint32_t ulElapsed;
+	uint32_t ulNow;
+	uint32_t ulCompleteTickPeriods;
+	int32_t lNextTick;
+	TickType_t xModifiableIdleTime;
+	uint64_t ullSleepStartNs;
+	#if configUSE_TICKLESS_STATS == 1
+		TicklessSleep_t xSleep;
+		BaseType_t xTickPending;
+	#endif
+
+		/* Make sure the reload value does not overflow the counter. */
+		if( xExpectedIdleTime > xMaximumPossibleSuppressedTicks )
+		{
+			xExpectedIdleTime = xMaximumPossibleSuppressedTicks;
+		}
+
+		/* Calculate the reload value required to wait xExpectedIdleTime
+		tick periods.  -1 is used because this code will execute part way
+		through one of the tick periods. */
+		ulReloadValue = ulTimerCountsForOneTick * ( xExpectedIdleTime - 1 );
+
+		/* Mask interrupts without entering a critical section, so that an
+		interrupt still ends the sleep. */
+		vPortDisableInterrupts();
+
+		/* Adjust for the time already elapsed */
+		ulElapsed = ulPortSimStimerCounterGet() - g_lastSTimerVal;
+
+		/* If a context switch is pending or a task is waiting for the
+		scheduler to be unsuspended then abandon the low power entry.
+		Abandon low power entry if the sleep time is too short */
+		if( ( eTaskConfirmSleepModeStatus() == eAbortSleep ) || ( ( ulElapsed + ulTimerCountsForOneTick ) > ulReloadValue ) )
+		{
+			#if configUSE_TICKLESS_STATS == 1
+			{
+				xTicklessStats.ulAbortedSleeps++;
+			}
+			#endif
+
+			vPortEnableInterrupts();
+		}
+		else
+		{
+			ulReloadValue -= ulElapsed;
+			prvStimerCompareDeltaSet( ulReloadValue );
+
+			/* Sleep until something happens.  configPRE_SLEEP_PROCESSING()
+			can set its parameter to 0 to indicate that its implementation
+			contains its own wait for interrupt, and so the wait should not
+			be executed again.  However, the original expected idle time
+			variable must remain unmodified, so a copy is taken. */
+			xModifiableIdleTime = xExpectedIdleTime;
+			ullSleepStartNs = ullPortSimTimeNs();
+
+			#if configUSE_TICKLESS_STATS == 1
+			{
+				xSleep.ulStartCount = ulPortSimStimerCounterGet();
+			}
+			#endif
+
+			configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+			if( xModifiableIdleTime > 0 )
+			{
+				vPortSimWaitForInterrupt();
+			}
+
+			#if configUSE_TICKLESS_STATS == 1
+			{
+				/* Interrupts are still masked, so whatever ended the sleep is
+				still pending. */
+				xSleep.ulSleepCounts = ulPortSimStimerCounterGet() - xSleep.ulStartCount;
+				xSleep.ulWakeInterrupts = prvPendingInterrupts( &xTickPending );
+				xSleep.ucDeepSleep = ( uint8_t ) xSleepDeep;
+				xSleep.ucEarlyWake = ( xTickPending == pdFALSE ) ? pdTRUE : pdFALSE;
+			}
+			#endif
+
+			configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+			xStats.ulSleeps++;
+			xStats.ullSleepNs += ullPortSimTimeNs() - ullSleepStartNs;
+
+			/* Step the tick count over the tick periods slept.  A host
+			thread can wake later than the compare, so never step past the
+			next unblock time; the tick interrupt counts whatever is left. */
+			ulNow = ulPortSimStimerCounterGet();
+			ulCompleteTickPeriods = ( ulNow - g_lastSTimerVal ) / ulTimerCountsForOneTick;
+			if( ulCompleteTickPeriods > ( xExpectedIdleTime - 1 ) )
+			{
+				ulCompleteTickPeriods = xExpectedIdleTime - 1;
+			}
+			g_lastSTimerVal += ulCompleteTickPeriods * ulTimerCountsForOneTick;
+			vTaskStepTick( ulCompleteTickPeriods );
+
+			#if configUSE_TICKLESS_STATS == 1
+			{
+				xSleep.xExpectedIdleTime = xExpectedIdleTime;
+				/* The kernel asks for the full reach only when it has no
+				timeout to wait for, so treat an exact fit as clamped too. */
+				xSleep.ucClamped = ( xExpectedIdleTime >= xMaximumPossibleSuppressedTicks ) ? pdTRUE : pdFALSE;
+				xSleep.xSteppedTicks = ulCompleteTickPeriods;
+				prvTicklessStatsRecord( &xSleep );
+			}
+			#endif
+
+			/* Clear the interrupt - to avoid extra tick counting in ISR - and
+			restart the tick at the next tick boundary. */
+			prvStimerIntClear();
+			lNextTick = ( int32_t ) ( g_lastSTimerVal + ulTimerCountsForOneTick - ulNow );
+			prvStimerCompareDeltaSet( ( lNextTick > 0 ) ? ( uint32_t ) lNextTick : 0 );
+
+			/* Re-enable interrupts to let the interrupt that ended the sleep
+			run. */
+			vPortEnableInterrupts();
+		}
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
+static void prvStimerCompareDeltaSet( uint32_t ulDelta )
+{
+struct itimerspec xCompare;
+uint64_t ullCounts;
+uint64_t ullTargetNs;
+
+	ullCounts = ( ( ullPortSimTimeNs() - ullStimerStartNs ) * configSTIMER_CLOCK_HZ ) / portNS_PER_SECOND;
+	ullTargetNs = ullStimerStartNs +
+				  ( ( ( ullCounts + ulDelta ) * portNS_PER_SECOND ) + configSTIMER_CLOCK_HZ - 1 ) / configSTIMER_CLOCK_HZ;
+
+	memset( &xCompare, 0, sizeof( xCompare ) );
+	xCompare.it_value.tv_sec = ( time_t ) ( ullTargetNs / portNS_PER_SECOND );
+	xCompare.it_value.tv_nsec = ( long ) ( ullTargetNs % portNS_PER_SECOND );
+	timer_settime( xStimerCompare, TIMER_ABSTIME, &xCompare, NULL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Drop a pending compare interrupt.  Called with interrupts masked.
+ */
+static void prvStimerIntClear( void )
+{
+sigset_t xTickSignal;
+struct timespec xNoWait = { 0, 0 };
+
+	sigemptyset( &xTickSignal );
+	sigaddset( &xTickSignal, portSIM_TICK_SIGNAL );
+
+	while( sigtimedwait( &xTickSignal, NULL, &xNoWait ) == portSIM_TICK_SIGNAL )
+	{
+	}
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortSimTimeNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+	return ( ( uint64_t ) xNow.tv_sec * portNS_PER_SECOND ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortSimStimerCounterGet( void )
+{
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+
+	return ( uint32_t ) ( ( ( ullPortSimTimeNs() - ullStimerStartNs ) * configSTIMER_CLOCK_HZ ) / portNS_PER_SECOND );
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimInterruptRegister( UBaseType_t uxLine, void ( *pxHandler )( void ) )
+{
+	configASSERT( uxLine < portSIM_INTERRUPT_LINES );
+
+	pxInterruptHandlers[ uxLine ] = pxHandler;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimInterruptTrigger( UBaseType_t uxLine )
+{
+	configASSERT( uxLine < portSIM_INTERRUPT_LINES );
+
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+
+	__atomic_store_n( &ullInterruptTriggerNs[ uxLine ], ullPortSimTimeNs(), __ATOMIC_RELEASE );
+	__atomic_fetch_or( &ulInterruptsPending, 1UL << uxLine, __ATOMIC_ACQ_REL );
+
+	/* Delivered to whichever task is running, or held pending until one
+	unmasks interrupts. */
+	kill( getpid(), portSIM_INTERRUPT_SIGNAL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Wait for an interrupt, as WFI does.  With interrupts masked, the interrupt
+ * that ends the wait stays pending and runs once they are unmasked.
+ */
+void vPortSimWaitForInterrupt( void )
+{
+sigset_t xSavedMask;
+sigset_t xWaitMask;
+int iSignal;
+
+	pthread_once( &xPortSetupOnce, prvPortSetup );
+	pthread_sigmask( SIG_BLOCK, &xInterruptSignals, &xSavedMask );
+
+	if( sigismember( &xSavedMask, portSIM_TICK_SIGNAL ) )
+	{
+		do
+		{
+			iSignal = sigwaitinfo( &xInterruptSignals, NULL );
+		} while( ( iSignal < 0 ) && ( errno == EINTR ) );
+
+		if( iSignal > 0 )
+		{
+			pthread_kill( pthread_self(), iSignal );
+		}
+	}
+	else
+	{
+		xWaitMask = xSavedMask;
+		sigdelset( &xWaitMask, portSIM_TICK_SIGNAL );
+		sigdelset( &xWaitMask, portSIM_INTERRUPT_SIGNAL );
+		sigsuspend( &xWaitMask );
+		pthread_sigmask( SIG_SETMASK, &xSavedMask, NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimSetSleepDeep( BaseType_t xSleepDeepSet )
+{
+	xSleepDeep = xSleepDeepSet;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSimGetStats( PortSimStats_t *pxStats )
+{
+uint64_t ullEndNs = ullSchedulerEndNs;
+
+	*pxStats = xStats;
+
+	if( ullSchedulerStartNs != 0 )
+	{
+		pxStats->ullRunNs = ( ( ullEndNs != 0 ) ? ullEndNs : ullPortSimTimeNs() ) - ullSchedulerStartNs;
+	}
+}
@@ -0,0 +1,248 @@
+/*
+ * FreeRTOS Kernel V10.1.1
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*-----------------------------------------------------------
+ * Port specific definitions.
+ *
+ * The settings in this file configure FreeRTOS correctly for the
+ * given hardware and compiler.
+ *
+ * These settings should not be altered.
+ *-----------------------------------------------------------
+ */
+
+/* Type definitions. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	unsigned long
+#define portBASE_TYPE	long
+#define portPOINTER_SIZE_TYPE	uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffff
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+
+	/* 32-bit tick type, so reads of the tick count do not need to be guarded
+	with a critical section. */
+	#define portTICK_TYPE_IS_ATOMIC 1
+#endif
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+/*-----------------------------------------------------------*/
+
+/* Scheduler utilities. */
+extern void vPortYield( void );
+extern void vPortEndSwitchingISR( BaseType_t xSwitchRequired );
+
+#define portYIELD()									vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )	vPortEndSwitchingISR( xSwitchRequired )
+#define portYIELD_FROM_ISR( x )						portEND_SWITCHING_ISR( x )
+/*-----------------------------------------------------------*/
+
+/* Critical section management.  Interrupts are simulated with signals, so
+masking interrupts blocks those signals in the calling thread. */
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+extern void vPortDisableInterrupts( void );
+extern void vPortEnableInterrupts( void );
+extern UBaseType_t uxPortSetInterruptMask( void );
+extern void vPortClearInterruptMask( UBaseType_t uxMask );
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()		uxPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	vPortClearInterruptMask(x)
+#define portDISABLE_INTERRUPTS()				vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()					vPortEnableInterrupts()
+#define portENTER_CRITICAL()					vPortEnterCritical()
+#define portEXIT_CRITICAL()						vPortExitCritical()
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site.  These are
+not necessary for to use this port.  They are defined so the common demo files
+(which build with all the ports) will build. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+/*-----------------------------------------------------------*/
+
+/* Each task runs on its own thread, which is joined when the task is
+deleted. */
+extern void vPortCancelThread( void *pxTaskToDelete );
+#define portCLEAN_UP_TCB( pxTCB )	vPortCancelThread( pxTCB )
+/*-----------------------------------------------------------*/
+
+/* Tickless idle/low power functionality. */
+#ifndef portSUPPRESS_TICKS_AND_SLEEP
+	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+
+/* Tickless idle statistics, kept by vPortSuppressTicksAndSleep() as in the
+GCC AMapollo2 port.  Times are in simulated STIMER counts
+(configSTIMER_CLOCK_HZ). */
+#ifndef configUSE_TICKLESS_STATS
+	#define configUSE_TICKLESS_STATS 0
+#endif
+
+#if( configUSE_TICKLESS_STATS == 1 )
+
+	/* Number of sleeps kept for xPortGetTicklessSleep(), a power of 2.  0 keeps
+	only the totals. */
+	#ifndef configTICKLESS_STATS_LOG_LENGTH
+		#define configTICKLESS_STATS_LOG_LENGTH 16
+	#endif
+
+	/* Wakes are counted per simulated interrupt line (0-31), and in the last
+	entry when no enabled line was pending.  The simulated STIMER compare has
+	no line, so a sleep it ends counts only in the last entry. */
+	#define portTICKLESS_WAKE_NONE		32
+	#define portTICKLESS_WAKE_SOURCES	( portTICKLESS_WAKE_NONE + 1 )
+
+	/* One sleep. */
+	typedef struct xTICKLESS_SLEEP
+	{
+		uint32_t ulStartCount;			/* STIMER count when the core went to sleep. */
+		uint32_t ulSleepCounts;			/* Time asleep, up to the wake. */
+		TickType_t xExpectedIdleTime;	/* Ticks the kernel expected to be idle, after clamping to what the timer can reach. */
+		TickType_t xSteppedTicks;		/* Ticks the tick count was stepped by on wake. */
+		uint32_t ulWakeInterrupts;		/* Enabled interrupt lines pending on wake, one bit per line. */
+		uint8_t ucDeepSleep;			/* pdTRUE if the core was set for deep sleep. */
+		uint8_t ucEarlyWake;			/* pdTRUE if something other than the tick timer ended the sleep. */
+		uint8_t ucClamped;				/* pdTRUE if the kernel expected to be idle for at least as long as the timer can reach, as it does when every task is blocked indefinitely. */
+	} TicklessSleep_t;
+
+	/* Totals since the scheduler started or vPortResetTicklessStats(). */
+	typedef struct xTICKLESS_STATS
+	{
+		uint32_t ulSleeps;				/* Sleeps entered. */
+		uint32_t ulAbortedSleeps;		/* Sleeps abandoned because a task became ready or the idle time was too short. */
+		uint32_t ulEarlyWakes;			/* Sleeps ended before the tick timer expired. */
+		uint32_t ulDeepSleeps;			/* Sleeps with the core set for deep sleep. */
+		uint64_t ullElapsedCounts;		/* Time the statistics cover. */
+		uint64_t ullSleepCounts;		/* Time asleep. */
+		uint64_t ullDeepSleepCounts;	/* Time in deep sleep. */
+		uint32_t ulClampedSleeps;		/* Sleeps with ucClamped set.  Their expected idle time is only the timer's reach, so they are left out of the next two sums. */
+		uint64_t ullExpectedIdleTicks;	/* Sum of the ticks the kernel expected to be idle, over sleeps that were not clamped. */
+		uint64_t ullSteppedTicks;		/* Sum of the ticks stepped on wake, over the same sleeps. */
+		uint64_t ullClampedSteppedTicks;	/* Sum of the ticks stepped on wake by clamped sleeps. */
+		int32_t lDriftCounts;			/* STIMER time at the last tick less the time the tick count accounts for.  Stays 0 unless ticks are lost or gained. */
+		uint32_t ulLogDropped;			/* Sleeps not logged because the log was full. */
+		uint32_t ulWakeSources[ portTICKLESS_WAKE_SOURCES ];
+	} TicklessStats_t;
+
+	/* These must be called from a task, or once the scheduler has ended. */
+	void vPortGetTicklessStats( TicklessStats_t *pxStats );
+	void vPortResetTicklessStats( void );
+	BaseType_t xPortGetTicklessSleep( TicklessSleep_t *pxSleep );
+
+#endif /* configUSE_TICKLESS_STATS */
+/*-----------------------------------------------------------*/
+
+/* Only the generic task selection is supported. */
+#ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+	#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#endif
+
+#if configUSE_PORT_OPTIMISED_TASK_SELECTION == 1
+	#error configUSE_PORT_OPTIMISED_TASK_SELECTION is not supported by the Posix port.
+#endif
+
+/* portNOP() is not required by this port. */
+#define portNOP()
+
+#define portINLINE	__inline
+
+#ifndef portFORCE_INLINE
+	#define portFORCE_INLINE inline __attribute__(( always_inline))
+#endif
+
+extern BaseType_t xPortIsInsideInterrupt( void );
+/*-----------------------------------------------------------*/
+
+/*-----------------------------------------------------------
+ * Host simulation.
+ *
+ * The STIMER is simulated by a 32-bit counter running at configSTIMER_CLOCK_HZ
+ * from the host monotonic clock.  Its compare interrupt drives the tick and
+ * ends tickless sleep, as on Apollo parts.
+ *
+ * Peripheral interrupts are simulated on numbered lines.  Any thread may
+ * trigger a line; the registered handler then runs in interrupt context on
+ * the thread of the running task.  Threads that are not tasks must keep
+ * interrupts masked, so create them after calling portDISABLE_INTERRUPTS().
+ *
+ * vPortSimSetSleepDeep() stands in for SCB->SCR SLEEPDEEP, for code that
+ * sleeps through vPortSimWaitForInterrupt() to say which sleep it meant.
+ *-----------------------------------------------------------*/
+
+#define portSIM_INTERRUPT_LINES		32
+
+typedef struct xPORT_SIM_STATS
+{
+	uint32_t ulContextSwitches;			/* Task switches performed. */
+	uint32_t ulTickInterrupts;			/* Tick (STIMER compare) interrupts serviced. */
+	uint32_t ulInterrupts;				/* Simulated peripheral interrupts serviced. */
+	uint32_t ulSleeps;					/* Tickless sleeps entered. */
+	uint64_t ullSleepNs;				/* Time spent in tickless sleep. */
+	uint64_t ullRunNs;					/* Time since the scheduler started. */
+	uint64_t ullInterruptLatencyNs;		/* Sum of trigger to handler entry times. */
+	uint64_t ullMaxInterruptLatencyNs;	/* Longest trigger to handler entry time. */
+} PortSimStats_t;
+
+extern uint64_t ullPortSimTimeNs( void );
+extern uint32_t ulPortSimStimerCounterGet( void );
+extern void vPortSimInterruptRegister( UBaseType_t uxLine, void ( *pxHandler )( void ) );
+extern void vPortSimInterruptTrigger( UBaseType_t uxLine );
+extern void vPortSimWaitForInterrupt( void );
+extern void vPortSimSetSleepDeep( BaseType_t xSleepDeep );
+extern void vPortSimGetStats( PortSimStats_t *pxStats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
@@ -141,6 +141,12 @@ extern void vPortExitCritical( void );
 	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
 #endif
 
+/* Tickless idle statistics (vPortGetTicklessStats(), xPortGetTicklessSleep())
+are only kept by the GCC build of this port. */
+#if defined( configUSE_TICKLESS_STATS ) && ( configUSE_TICKLESS_STATS != 0 )
+	#error configUSE_TICKLESS_STATS is only supported by the GCC AMapollo2 port.
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Task function macros as described on the FreeRTOS.org WEB site.  These are
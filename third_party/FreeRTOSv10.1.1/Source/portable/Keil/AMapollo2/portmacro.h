@@ -116,6 +116,12 @@ extern void vPortExitCritical( void );
 	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
 	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
 #endif
+
+/* Tickless idle statistics (vPortGetTicklessStats(), xPortGetTicklessSleep())
+are only kept by the GCC build of this port. */
+#if defined( configUSE_TICKLESS_STATS ) && ( configUSE_TICKLESS_STATS != 0 )
+	#error configUSE_TICKLESS_STATS is only supported by the GCC AMapollo2 port.
+#endif
 /*-----------------------------------------------------------*/
 
 /* Port specific optimisations. */
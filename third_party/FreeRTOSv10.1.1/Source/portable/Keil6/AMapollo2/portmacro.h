@@ -117,6 +117,12 @@ not necessary for to use this port.  They are defined so the common demo files
 	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
 	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
 #endif
+
+/* Tickless idle statistics (vPortGetTicklessStats(), xPortGetTicklessSleep())
+are only kept by the GCC build of this port. */
+#if defined( configUSE_TICKLESS_STATS ) && ( configUSE_TICKLESS_STATS != 0 )
+	#error configUSE_TICKLESS_STATS is only supported by the GCC AMapollo2 port.
+#endif
 /*-----------------------------------------------------------*/
 
 /* Architecture specific optimisations. */
@@ -0,0 +1,691 @@
+/*
+ * FreeRTOS Kernel V10.1.1
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A two level segregated fit (TLSF) implementation of pvPortMalloc() and
+ * vPortFree().  Free blocks are kept in an array of lists indexed by size
+ * class, with a bitmap per level recording which lists are non-empty, so both
+ * functions execute in a bounded number of steps whatever the state of the
+ * heap.  Blocks are coalesced with their physical neighbours when they are
+ * freed.
+ *
+ * The first level splits sizes at powers of two and the second level splits
+ * each power of two range into 2^configTLSF_SL_INDEX_COUNT_LOG2 linear
+ * classes.  An allocation is taken from the first non-empty class whose
+ * smallest member is large enough, so no list is ever searched, at the cost
+ * of some internal fragmentation.
+ *
+ * The heap can be made up of several memory regions (for example internal
+ * SRAM and an external PSRAM), added by vPortDefineHeapRegions().  Unlike
+ * heap_5.c, regions can be added in any order and at any time.  Unless
+ * configTLSF_USE_STATIC_HEAP is set to 0, a configTOTAL_HEAP_SIZE byte array
+ * is also added as a region the first time the heap is used, as in heap_4.c.
+ *
+ * vPortGetHeapStats() reports the free space, the number and size range of
+ * the free blocks and the low water mark of the free space.  The amount of
+ * free space that cannot be handed out in one allocation, 1 - largest free
+ * block / free space, is a measure of the fragmentation.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of http://www.FreeRTOS.org
+ * for more information.
+ */
+#include <stddef.h>
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Number of second level classes per power of two, as a power of two. */
+#ifndef configTLSF_SL_INDEX_COUNT_LOG2
+	#define configTLSF_SL_INDEX_COUNT_LOG2	4
+#endif
+
+/* Blocks, and so heap regions, must be smaller than
+2^configTLSF_MAX_BLOCK_SIZE_LOG2 bytes.  Each power of two costs a row of free
+list heads, so this should not be set larger than needed. */
+#ifndef configTLSF_MAX_BLOCK_SIZE_LOG2
+	#define configTLSF_MAX_BLOCK_SIZE_LOG2	24
+#endif
+
+/* Set to 0 if all the heap memory is given by vPortDefineHeapRegions(). */
+#ifndef configTLSF_USE_STATIC_HEAP
+	#define configTLSF_USE_STATIC_HEAP		1
+#endif
+
+#if( portBYTE_ALIGNMENT == 32 )
+	#define tlsfALIGNMENT_LOG2	5
+#elif( portBYTE_ALIGNMENT == 16 )
+	#define tlsfALIGNMENT_LOG2	4
+#elif( portBYTE_ALIGNMENT == 8 )
+	#define tlsfALIGNMENT_LOG2	3
+#elif( portBYTE_ALIGNMENT == 4 )
+	#define tlsfALIGNMENT_LOG2	2
+#else
+	#error heap_tlsf.c needs portBYTE_ALIGNMENT to be at least 4
+#endif
+
+#if( configTLSF_SL_INDEX_COUNT_LOG2 > 5 )
+	#error configTLSF_SL_INDEX_COUNT_LOG2 must not be greater than 5
+#endif
+
+#if( configTLSF_MAX_BLOCK_SIZE_LOG2 > 31 )
+	#error configTLSF_MAX_BLOCK_SIZE_LOG2 must not be greater than 31
+#endif
+
+/* Sizes below tlsfSMALL_BLOCK_SIZE all map to the first row of the free list
+array, which is split linearly in steps of portBYTE_ALIGNMENT. */
+#define tlsfSL_INDEX_COUNT		( 1 << configTLSF_SL_INDEX_COUNT_LOG2 )
+#define tlsfFL_INDEX_SHIFT		( configTLSF_SL_INDEX_COUNT_LOG2 + tlsfALIGNMENT_LOG2 )
+#define tlsfFL_INDEX_COUNT		( configTLSF_MAX_BLOCK_SIZE_LOG2 - tlsfFL_INDEX_SHIFT + 1 )
+#define tlsfSMALL_BLOCK_SIZE	( ( size_t ) 1 << tlsfFL_INDEX_SHIFT )
+#define tlsfMAX_BLOCK_SIZE		( ( size_t ) 1 << configTLSF_MAX_BLOCK_SIZE_LOG2 )
+
+#if( tlsfFL_INDEX_COUNT < 1 )
+	#error configTLSF_MAX_BLOCK_SIZE_LOG2 is too small for the second level split and alignment
+#endif
+
+/* Block sizes are multiples of portBYTE_ALIGNMENT, so the bottom bit of the
+size is free to mark the block as being in the free lists. */
+#define tlsfBLOCK_FREE_BIT		( ( size_t ) 1 )
+#define tlsfBLOCK_SIZE( pxBlock )	( ( pxBlock )->xBlockSize & ~tlsfBLOCK_FREE_BIT )
+#define tlsfBLOCK_IS_FREE( pxBlock )	( ( ( pxBlock )->xBlockSize & tlsfBLOCK_FREE_BIT ) != 0 )
+#define tlsfNEXT_PHYS_BLOCK( pxBlock )	( ( TlsfBlock_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + tlsfBLOCK_SIZE( pxBlock ) ) )
+
+/* Allocate the memory for the heap. */
+#if( configTLSF_USE_STATIC_HEAP == 1 )
+	#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+		/* The application writer has already defined the array used for the RTOS
+		heap - probably so it can be placed in a special segment or address. */
+		extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+	#else
+		static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+	#endif /* configAPPLICATION_ALLOCATED_HEAP */
+#endif /* configTLSF_USE_STATIC_HEAP */
+
+/* The header at the start of every block.  Each region ends with a zero sized
+block that is never free, so the block after any real block can be read
+without a range check.  The free list links are only present in free blocks;
+in allocated blocks they are part of the memory given to the application. */
+typedef struct A_TLSF_BLOCK
+{
+	struct A_TLSF_BLOCK *pxPrevPhysBlock;	/*<< The block before this one in memory, NULL for the first block in a region. */
+	size_t xBlockSize;						/*<< The size of the block including the header, and tlsfBLOCK_FREE_BIT. */
+	struct A_TLSF_BLOCK *pxNextFreeBlock;	/*<< The next block in the same free list. */
+	struct A_TLSF_BLOCK *pxPrevFreeBlock;	/*<< The previous block in the same free list. */
+} TlsfBlock_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Index of the most and least significant set bits of a non-zero value.
+ */
+static BaseType_t prvFls( uint32_t ulValue );
+static BaseType_t prvFfs( uint32_t ulValue );
+
+/*
+ * Find the free list a block of the given size belongs in.
+ */
+static void prvMappingInsert( size_t xSize, BaseType_t *pxFl, BaseType_t *pxSl );
+
+/*
+ * Find the first free list whose blocks are all at least the given size.
+ * *pxFl is set past the last row if the size is too large for the heap.
+ */
+static void prvMappingSearch( size_t xSize, BaseType_t *pxFl, BaseType_t *pxSl );
+
+/*
+ * Return the first block in the first non-empty free list at or after the
+ * given one, updating the indexes to the list the block was found in.
+ */
+static TlsfBlock_t *prvFindSuitableBlock( BaseType_t *pxFl, BaseType_t *pxSl );
+
+/*
+ * Add and remove blocks from the free lists and bitmaps.
+ */
+static void prvInsertFreeBlock( TlsfBlock_t *pxBlock );
+static void prvRemoveFreeBlock( TlsfBlock_t *pxBlock );
+
+/*
+ * Make a region of memory into a free block and a terminating block.
+ */
+static void prvAddRegion( uint8_t *pucStartAddress, size_t xSizeInBytes );
+
+/*
+ * Called automatically to add the static heap the first time the heap is
+ * used.
+ */
+static void prvHeapInit( void );
+
+/*-----------------------------------------------------------*/
+
+/* The size of the header placed at the beginning of each allocated memory
+block must by correctly byte aligned. */
+static const size_t xHeapStructSize	= ( offsetof( TlsfBlock_t, pxNextFreeBlock ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* A free block must be able to hold the free list links. */
+static const size_t xMinimumBlockSize = ( sizeof( TlsfBlock_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The free lists, and bitmaps of the non-empty rows and lists. */
+static uint32_t ulFlBitmap = 0U;
+static uint32_t ulSlBitmap[ tlsfFL_INDEX_COUNT ];
+static TlsfBlock_t *pxFreeLists[ tlsfFL_INDEX_COUNT ][ tlsfSL_INDEX_COUNT ];
+
+static BaseType_t xHeapInitialised = pdFALSE;
+
+/* Keeps track of the number of free bytes remaining, but says nothing about
+fragmentation. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+static size_t xNumberOfSuccessfulAllocations = 0U;
+static size_t xNumberOfSuccessfulFrees = 0U;
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+TlsfBlock_t *pxBlock, *pxNewBlock;
+BaseType_t xFl, xSl;
+void *pvReturn = NULL;
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc then the static heap will need
+		adding. */
+		if( xHeapInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		/* The size check also keeps the arithmetic below from overflowing. */
+		if( ( xWantedSize > 0 ) && ( xWantedSize < tlsfMAX_BLOCK_SIZE ) )
+		{
+			/* The wanted size is increased so it can contain the block header
+			in addition to the requested amount of bytes, and rounded up to a
+			size that can hold the free list links once the block is freed. */
+			xWantedSize += xHeapStructSize;
+			xWantedSize = ( xWantedSize + ( size_t ) portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+			if( xWantedSize < xMinimumBlockSize )
+			{
+				xWantedSize = xMinimumBlockSize;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			prvMappingSearch( xWantedSize, &xFl, &xSl );
+
+			if( xFl < tlsfFL_INDEX_COUNT )
+			{
+				pxBlock = prvFindSuitableBlock( &xFl, &xSl );
+			}
+			else
+			{
+				pxBlock = NULL;
+			}
+
+			if( pxBlock != NULL )
+			{
+				prvRemoveFreeBlock( pxBlock );
+
+				/* If the block is larger than required it can be split into
+				two. */
+				if( ( tlsfBLOCK_SIZE( pxBlock ) - xWantedSize ) >= xMinimumBlockSize )
+				{
+					pxNewBlock = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+					configASSERT( ( ( ( size_t ) pxNewBlock ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+					pxNewBlock->xBlockSize = tlsfBLOCK_SIZE( pxBlock ) - xWantedSize;
+					pxNewBlock->pxPrevPhysBlock = pxBlock;
+					tlsfNEXT_PHYS_BLOCK( pxNewBlock )->pxPrevPhysBlock = pxNewBlock;
+					pxBlock->xBlockSize = xWantedSize;
+
+					/* The block after the original one is in use, else the two
+					would have been merged, so the remainder goes straight back
+					in the free lists. */
+					prvInsertFreeBlock( pxNewBlock );
+				}
+				else
+				{
+					pxBlock->xBlockSize &= ~tlsfBLOCK_FREE_BIT;
+				}
+
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				xNumberOfSuccessfulAllocations++;
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+TlsfBlock_t *pxBlock, *pxNeighbour;
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have a block header immediately before
+		it. */
+		pxBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+		/* Check the block is actually allocated. */
+		configASSERT( tlsfBLOCK_IS_FREE( pxBlock ) == pdFALSE );
+
+		vTaskSuspendAll();
+		{
+			xFreeBytesRemaining += pxBlock->xBlockSize;
+			xNumberOfSuccessfulFrees++;
+			traceFREE( pv, pxBlock->xBlockSize );
+
+			/* Merge with the block before, if it is free. */
+			pxNeighbour = pxBlock->pxPrevPhysBlock;
+			if( ( pxNeighbour != NULL ) && ( tlsfBLOCK_IS_FREE( pxNeighbour ) != pdFALSE ) )
+			{
+				prvRemoveFreeBlock( pxNeighbour );
+				pxNeighbour->xBlockSize += pxBlock->xBlockSize;
+				pxBlock = pxNeighbour;
+				tlsfNEXT_PHYS_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			/* Merge with the block after, if it is free.  The block at the end
+			of a region is never free. */
+			pxNeighbour = tlsfNEXT_PHYS_BLOCK( pxBlock );
+			if( tlsfBLOCK_IS_FREE( pxNeighbour ) != pdFALSE )
+			{
+				prvRemoveFreeBlock( pxNeighbour );
+				pxBlock->xBlockSize += tlsfBLOCK_SIZE( pxNeighbour );
+				tlsfNEXT_PHYS_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			prvInsertFreeBlock( pxBlock );
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+const HeapRegion_t *pxHeapRegion;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		for( pxHeapRegion = pxHeapRegions; pxHeapRegion->xSizeInBytes > 0; pxHeapRegion++ )
+		{
+			prvAddRegion( pxHeapRegion->pucStartAddress, pxHeapRegion->xSizeInBytes );
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+TlsfBlock_t *pxBlock;
+uint32_t ulFlMap, ulSlMap;
+BaseType_t xFl, xSl;
+size_t xBlocks = 0, xMaxSize = 0, xMinSize = 0;
+
+	/* Unlike the allocation functions this walks every free block. */
+	vTaskSuspendAll();
+	{
+		for( ulFlMap = ulFlBitmap; ulFlMap != 0U; ulFlMap &= ulFlMap - 1U )
+		{
+			xFl = prvFfs( ulFlMap );
+
+			for( ulSlMap = ulSlBitmap[ xFl ]; ulSlMap != 0U; ulSlMap &= ulSlMap - 1U )
+			{
+				xSl = prvFfs( ulSlMap );
+
+				for( pxBlock = pxFreeLists[ xFl ][ xSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+				{
+					if( tlsfBLOCK_SIZE( pxBlock ) > xMaxSize )
+					{
+						xMaxSize = tlsfBLOCK_SIZE( pxBlock );
+					}
+
+					if( ( xMinSize == 0 ) || ( tlsfBLOCK_SIZE( pxBlock ) < xMinSize ) )
+					{
+						xMinSize = tlsfBLOCK_SIZE( pxBlock );
+					}
+
+					xBlocks++;
+				}
+			}
+		}
+
+		pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+		pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+		pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+		pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFls( uint32_t ulValue )
+{
+	#if defined( __GNUC__ )
+	{
+		return ( BaseType_t ) ( 31 - __builtin_clz( ulValue ) );
+	}
+	#else
+	{
+	BaseType_t xBit = 0;
+
+		if( ( ulValue & 0xffff0000UL ) != 0U ) { ulValue >>= 16; xBit += 16; }
+		if( ( ulValue & 0x0000ff00UL ) != 0U ) { ulValue >>= 8; xBit += 8; }
+		if( ( ulValue & 0x000000f0UL ) != 0U ) { ulValue >>= 4; xBit += 4; }
+		if( ( ulValue & 0x0000000cUL ) != 0U ) { ulValue >>= 2; xBit += 2; }
+		if( ( ulValue & 0x00000002UL ) != 0U ) { xBit += 1; }
+
+		return xBit;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFfs( uint32_t ulValue )
+{
+	/* Isolate the least significant set bit. */
+	return prvFls( ulValue & ( ~ulValue + 1U ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize, BaseType_t *pxFl, BaseType_t *pxSl )
+{
+BaseType_t xFl;
+
+	if( xSize < tlsfSMALL_BLOCK_SIZE )
+	{
+		*pxFl = 0;
+		*pxSl = ( BaseType_t ) ( xSize >> tlsfALIGNMENT_LOG2 );
+	}
+	else
+	{
+		xFl = prvFls( ( uint32_t ) xSize );
+		*pxSl = ( BaseType_t ) ( ( xSize >> ( xFl - configTLSF_SL_INDEX_COUNT_LOG2 ) ) ^ ( ( size_t ) 1 << configTLSF_SL_INDEX_COUNT_LOG2 ) );
+		*pxFl = xFl - ( tlsfFL_INDEX_SHIFT - 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingSearch( size_t xSize, BaseType_t *pxFl, BaseType_t *pxSl )
+{
+	/* Round the size up to the start of the next class, so any block in the
+	class the search starts from is big enough.  xSize is below
+	tlsfMAX_BLOCK_SIZE, so this cannot overflow. */
+	if( xSize >= tlsfSMALL_BLOCK_SIZE )
+	{
+		xSize += ( ( size_t ) 1 << ( prvFls( ( uint32_t ) xSize ) - configTLSF_SL_INDEX_COUNT_LOG2 ) ) - 1U;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	prvMappingInsert( xSize, pxFl, pxSl );
+}
+/*-----------------------------------------------------------*/
+
+static TlsfBlock_t *prvFindSuitableBlock( BaseType_t *pxFl, BaseType_t *pxSl )
+{
+uint32_t ulMap;
+
+	/* Look for a non-empty list in the same row first, then take the first
+	list of the next non-empty row. */
+	ulMap = ulSlBitmap[ *pxFl ] & ( ~0UL << *pxSl );
+
+	if( ulMap == 0U )
+	{
+		ulMap = ulFlBitmap & ( ~0UL << ( *pxFl + 1 ) );
+
+		if( ulMap == 0U )
+		{
+			return NULL;
+		}
+
+		*pxFl = prvFfs( ulMap );
+		ulMap = ulSlBitmap[ *pxFl ];
+	}
+
+	*pxSl = prvFfs( ulMap );
+
+	return pxFreeLists[ *pxFl ][ *pxSl ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TlsfBlock_t *pxBlock )
+{
+BaseType_t xFl, xSl;
+
+	pxBlock->xBlockSize |= tlsfBLOCK_FREE_BIT;
+	prvMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &xFl, &xSl );
+
+	pxBlock->pxPrevFreeBlock = NULL;
+	pxBlock->pxNextFreeBlock = pxFreeLists[ xFl ][ xSl ];
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	pxFreeLists[ xFl ][ xSl ] = pxBlock;
+	ulFlBitmap |= 1UL << xFl;
+	ulSlBitmap[ xFl ] |= 1UL << xSl;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TlsfBlock_t *pxBlock )
+{
+BaseType_t xFl, xSl;
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		/* The block is at the head of its list, so the list has to be found
+		to update the head and, if the list is now empty, the bitmaps. */
+		prvMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &xFl, &xSl );
+		pxFreeLists[ xFl ][ xSl ] = pxBlock->pxNextFreeBlock;
+
+		if( pxBlock->pxNextFreeBlock == NULL )
+		{
+			ulSlBitmap[ xFl ] &= ~( 1UL << xSl );
+
+			if( ulSlBitmap[ xFl ] == 0U )
+			{
+				ulFlBitmap &= ~( 1UL << xFl );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+	/* The free bit is left set; the caller either merges the block into
+	another free block or takes it for an allocation. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddRegion( uint8_t *pucStartAddress, size_t xSizeInBytes )
+{
+TlsfBlock_t *pxFirstBlock, *pxEndBlock;
+size_t xAddress, xEndAddress;
+
+	/* Ensure the region starts and ends on correctly aligned boundaries. */
+	xAddress = ( ( size_t ) pucStartAddress + ( size_t ) portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+	xEndAddress = ( ( size_t ) pucStartAddress + xSizeInBytes ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	/* The region must hold one free block and the end marker, and must not
+	be so large that merged blocks fall outside the free list array. */
+	configASSERT( xEndAddress >= xAddress + xMinimumBlockSize + xHeapStructSize );
+	configASSERT( ( xEndAddress - xAddress ) <= tlsfMAX_BLOCK_SIZE );
+
+	/* The end marker is a zero sized block that is never free, so blocks
+	are not merged across the end of the region. */
+	pxEndBlock = ( TlsfBlock_t * ) ( xEndAddress - xHeapStructSize );
+	pxEndBlock->xBlockSize = 0;
+
+	/* To start with there is a single free block in the region that is
+	sized to take up all of it except the end marker. */
+	pxFirstBlock = ( TlsfBlock_t * ) xAddress;
+	pxFirstBlock->xBlockSize = ( size_t ) pxEndBlock - xAddress;
+	pxFirstBlock->pxPrevPhysBlock = NULL;
+	pxEndBlock->pxPrevPhysBlock = pxFirstBlock;
+
+	xFreeBytesRemaining += pxFirstBlock->xBlockSize;
+	xMinimumEverFreeBytesRemaining += pxFirstBlock->xBlockSize;
+
+	prvInsertFreeBlock( pxFirstBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+	xHeapInitialised = pdTRUE;
+
+	#if( configTLSF_USE_STATIC_HEAP == 1 )
+	{
+		prvAddRegion( ucHeap, configTOTAL_HEAP_SIZE );
+	}
+	#endif
+}
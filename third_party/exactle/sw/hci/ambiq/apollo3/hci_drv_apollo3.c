@@ -60,6 +60,7 @@
 
 #include "am_mcu_apollo.h"
 #include "am_util.h"
+#include "am_util_hci_snoop.h"
 #include "hci_drv_apollo3.h"
 
 #include <string.h>
@@ -68,8 +69,17 @@
 //
 // Use the interrupt-driven HCI driver?
 //
+// The interrupt-driven path moves every HCI packet with the BLEIF DMA engine,
+// which the FIFO thresholds pace, and runs the transfers from the BLE
+// interrupt: STATUS starts a queued write, IRQ starts a read, and the HAL
+// reads a packet's length and then its body from the command-complete
+// interrupts. Setting this to 0 from the build selects the blocking path,
+// which polls the FIFO and the STATUS and IRQ lines from the handler.
+//
 //*****************************************************************************
-#define USE_NONBLOCKING_HCI             0
+#ifndef USE_NONBLOCKING_HCI
+#define USE_NONBLOCKING_HCI             1
+#endif
 #define SKIP_FALLING_EDGES              0
 
 //*****************************************************************************
@@ -83,6 +93,20 @@
 //*****************************************************************************
 #define ENABLE_BLE_HEARTBEAT            1
 
+//*****************************************************************************
+//
+// Enable HCI snoop capture?
+//
+// Setting this to 1 records every packet sent to or read from the BLE core
+// with am_util_hci_snoop_record(). Nothing is recorded until the application
+// calls am_util_hci_snoop_init(), and the capture is drained in btsnoop format
+// with am_util_hci_snoop_drain().
+//
+//*****************************************************************************
+#ifndef HCI_DRV_SNOOP
+#define HCI_DRV_SNOOP                   0
+#endif
+
 //*****************************************************************************
 //
 // Configurable buffer sizes.
@@ -103,6 +127,38 @@
 #define HCI_DRV_MAX_TX_RETRIES           10000
 #define HCI_DRV_MAX_HCI_TRANSACTIONS     10000
 #define HCI_DRV_MAX_READ_PACKET          4   // max read in a row at a time
+#define HCI_DRV_MAX_READ_PACKET_LIMIT    16  // upper bound for the adaptive budget
+
+//*****************************************************************************
+//
+// Transmit coalescing.
+//
+// Queued HCI packets can be sent to the controller back-to-back in a single
+// wake/STATUS handshake. HCI_DRV_TX_BATCH_MAX limits the number of packets
+// per transfer, and HCI_DRV_TX_BATCH_BYTES limits the size of the combined
+// transfer. Coalescing is off (HCI_DRV_TX_BATCH_MAX of 1) until the
+// controller's handling of back-to-back packets has been validated on
+// hardware; raise it from the build to try it. With a limit of 1 the
+// staging buffer and flush timer are not built.
+//
+// If HCI_DRV_TX_FLUSH_MS is non-zero, ACL packets are held for up to that
+// long (rounded up to the WSF timer tick) to let a batch fill up. HCI
+// commands and full batches are always sent right away.
+//
+//*****************************************************************************
+#ifndef HCI_DRV_TX_BATCH_MAX
+#define HCI_DRV_TX_BATCH_MAX             1
+#endif
+
+#ifndef HCI_DRV_TX_BATCH_BYTES
+#define HCI_DRV_TX_BATCH_BYTES           HCI_DRV_MAX_TX_PACKET
+#endif
+
+#ifndef HCI_DRV_TX_FLUSH_MS
+#define HCI_DRV_TX_FLUSH_MS              0
+#endif
+
+#define HCI_DRV_TX_FLUSH_TIMER  ((HCI_DRV_TX_BATCH_MAX > 1) && HCI_DRV_TX_FLUSH_MS)
 
 //*****************************************************************************
 //
@@ -144,6 +200,33 @@ hci_drv_write_t;
 
 #endif
 
+//*****************************************************************************
+//
+// HCI snoop hooks.
+//
+//*****************************************************************************
+#if HCI_DRV_SNOOP
+
+#define HCI_DRV_SNOOP_TX(type, pData, len)                                    \
+    am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_SENT, (type), (pData), (len))
+
+#define HCI_DRV_SNOOP_RX(pBuf, len)                                           \
+    do                                                                        \
+    {                                                                         \
+        if ((len) > 0)                                                        \
+        {                                                                     \
+            am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_RECEIVED, (pBuf)[0],   \
+                                     &(pBuf)[1], (len) - 1);                  \
+        }                                                                     \
+    } while (0)
+
+#else
+
+#define HCI_DRV_SNOOP_TX(type, pData, len)
+#define HCI_DRV_SNOOP_RX(pBuf, len)
+
+#endif
+
 //*****************************************************************************
 //
 // Global variables.
@@ -160,22 +243,42 @@ uint8_t g_BLEMacAddress[6] = {0x01,0x02,0x03,0x04,0x05,0x06};
 wsfHandlerId_t g_HciDrvHandleID = 0;
 wsfTimer_t g_HeartBeatTimer;
 wsfTimer_t g_WakeTimer;
+#if HCI_DRV_TX_FLUSH_TIMER
+wsfTimer_t g_TxFlushTimer;
+#endif
 
 // Buffers for HCI write data.
 hci_drv_write_t g_psWriteBuffers[NUM_HCI_WRITE_BUFFERS];
 am_hal_queue_t g_sWriteQueue;
 
+// Staging buffer for coalesced writes, and the number of packets it holds.
+// Rounded up to whole words, since the BLEIF moves the last partial word too.
+#if HCI_DRV_TX_BATCH_MAX > 1
+static uint32_t g_pui32TxBatch[(HCI_DRV_TX_BATCH_BYTES + 3) / 4];
+#endif
+static uint32_t g_ui32TxBatchCount = 0;
+
 // Buffers for HCI read data.
 uint32_t g_pui32ReadBuffer[HCI_DRV_MAX_RX_PACKET / 4];
 uint8_t *g_pui8ReadBuffer = (uint8_t *) g_pui32ReadBuffer;
 volatile bool bReadBufferInUse = false;
 
+#if USE_NONBLOCKING_HCI
+// Set when the HAL ends a read without any data.
+static volatile bool g_bReadFailed = false;
+#endif
+
 uint32_t g_ui32NumBytes   = 0;
 uint32_t g_consumed_bytes = 0;
 
 // Counters for tracking read data.
 volatile uint32_t g_ui32InterruptsSeen = 0;
 
+#if !USE_NONBLOCKING_HCI
+// Number of packets the blocking handler may read before yielding.
+static uint32_t g_ui32ReadBudget = HCI_DRV_MAX_READ_PACKET;
+#endif
+
 void HciDrvEmptyWriteQueue(void);
 //*****************************************************************************
 //
@@ -577,7 +680,111 @@ update_wake(void)
 
     AM_CRITICAL_END;
 }
+
+//*****************************************************************************
+//
+// Start reading a packet into the read buffer.
+//
+// Does nothing if IRQ is low or the buffer still holds a packet the stack
+// hasn't taken; the handler starts the read once it has.
+//
+//*****************************************************************************
+static uint32_t
+start_read(void)
+{
+    uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+
+    AM_CRITICAL_BEGIN;
+
+    if ( !bReadBufferInUse && BLE_IRQ_CHECK() )
+    {
+        CRITICAL_PRINT("INFO: HCI Read started.\n");
+        bReadBufferInUse = true;
+        ui32Status = am_hal_ble_nonblocking_hci_read(BLE,
+                                                     g_pui32ReadBuffer,
+                                                     hciDrvReadCallback,
+                                                     0);
+        if (ui32Status == AM_HAL_STATUS_SUCCESS)
+        {
+            BLE_HEARTBEAT_RESTART();
+        }
+        else
+        {
+            bReadBufferInUse = false;
+        }
+    }
+
+    AM_CRITICAL_END;
+
+    return ui32Status;
+}
+#endif
+
+//*****************************************************************************
+//
+// Gather queued HCI packets into a single transfer.
+//
+// Starting from the head of the write queue, collect as many packets as fit
+// in the batch limits. A single packet is sent straight from its queue slot;
+// several are copied back-to-back into the staging buffer. The number of
+// packets covered is saved in g_ui32TxBatchCount so the caller can retire
+// them once the transfer succeeds.
+//
+//*****************************************************************************
+static uint32_t *
+build_tx_batch(uint32_t *pui32Length)
+{
+    hci_drv_write_t *psWriteBuffer = am_hal_queue_peek(&g_sWriteQueue);
+
+#if HCI_DRV_TX_BATCH_MAX > 1
+    uint8_t *pui8Batch = (uint8_t *) g_pui32TxBatch;
+    uint32_t ui32Items = am_hal_queue_items_left(&g_sWriteQueue);
+    uint32_t ui32Length = psWriteBuffer->ui32Length;
+    uint32_t ui32Count = 1;
+
+    if (ui32Items > HCI_DRV_TX_BATCH_MAX)
+    {
+        ui32Items = HCI_DRV_TX_BATCH_MAX;
+    }
+
+    while (ui32Count < ui32Items)
+    {
+        uint32_t ui32Index = (g_sWriteQueue.ui32ReadIndex +
+                              (ui32Count * sizeof(hci_drv_write_t))) %
+                             g_sWriteQueue.ui32Capacity;
+
+        hci_drv_write_t *psNext =
+            (hci_drv_write_t *) &g_sWriteQueue.pui8Data[ui32Index];
+
+        if ((ui32Length + psNext->ui32Length) > HCI_DRV_TX_BATCH_BYTES)
+        {
+            break;
+        }
+
+        //
+        // Only start copying once we know there will be more than one packet.
+        //
+        if (ui32Count == 1)
+        {
+            memcpy(pui8Batch, psWriteBuffer->pui32Data, ui32Length);
+        }
+
+        memcpy(pui8Batch + ui32Length, psNext->pui32Data, psNext->ui32Length);
+        ui32Length += psNext->ui32Length;
+        ui32Count++;
+    }
+
+    g_ui32TxBatchCount = ui32Count;
+    *pui32Length = ui32Length;
+
+    return (ui32Count > 1) ? g_pui32TxBatch : psWriteBuffer->pui32Data;
+#else
+    g_ui32TxBatchCount = 1;
+    *pui32Length = psWriteBuffer->ui32Length;
+
+    return psWriteBuffer->pui32Data;
 #endif
+}
 
 //*****************************************************************************
 //
@@ -610,6 +817,8 @@ hciDrvWrite(uint8_t type, uint16_t len, uint8_t *pData)
         ERROR_RETURN(HCI_DRV_TX_PACKET_TOO_LARGE, len);
     }
 
+    HCI_DRV_SNOOP_TX(type, pData, len);
+
     //
     // Get a pointer to the next item in the queue.
     //
@@ -643,10 +852,27 @@ hciDrvWrite(uint8_t type, uint16_t len, uint8_t *pData)
     update_wake();
 
 #else
+#if HCI_DRV_TX_FLUSH_TIMER
     //
-    // Send an event to the BLE transfer handler function.
+    // Hold ACL data briefly so more packets can join the batch. Commands and
+    // full batches go out immediately.
     //
-    WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
+    if ((type != HCI_CMD_TYPE) &&
+        (am_hal_queue_items_left(&g_sWriteQueue) < HCI_DRV_TX_BATCH_MAX))
+    {
+        if (!g_TxFlushTimer.isStarted)
+        {
+            WsfTimerStartMs(&g_TxFlushTimer, HCI_DRV_TX_FLUSH_MS);
+        }
+    }
+    else
+#endif
+    {
+        //
+        // Send an event to the BLE transfer handler function.
+        //
+        WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
+    }
 #endif
 
 #ifdef AM_CUSTOM_BDADDR
@@ -695,6 +921,11 @@ HciDrvHandlerInit(wsfHandlerId_t handlerId)
 
     g_WakeTimer.handlerId = handlerId;
     g_WakeTimer.msg.event = BLE_SET_WAKEUP;
+
+#if HCI_DRV_TX_FLUSH_TIMER
+    g_TxFlushTimer.handlerId = handlerId;
+    g_TxFlushTimer.msg.event = BLE_TRANSFER_NEEDED_EVENT;
+#endif
 }
 
 //*****************************************************************************
@@ -743,9 +974,13 @@ HciDrvIntService(void)
         am_hal_ble_wakeup_set(BLE, 0);
 
         //
-        // Prepare to read a message.
+        // Start reading the message. If the bus is still busy, let the
+        // handler try again.
         //
-        WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
+        if (start_read() != AM_HAL_STATUS_SUCCESS)
+        {
+            WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
+        }
     }
     else if (ui32Status & AM_HAL_BLE_INT_BLECSSTAT)
     {
@@ -757,14 +992,14 @@ HciDrvIntService(void)
         if ( !am_hal_queue_empty(&g_sWriteQueue) )
         {
             uint32_t ui32WriteStatus = 0;
-
-            hci_drv_write_t *psWriteBuffer = am_hal_queue_peek(&g_sWriteQueue);
+            uint32_t ui32BatchLength;
+            uint32_t *pui32BatchData = build_tx_batch(&ui32BatchLength);
 
             ui32WriteStatus =
                 am_hal_ble_nonblocking_hci_write(BLE,
                                                  AM_HAL_BLE_RAW,
-                                                 psWriteBuffer->pui32Data,
-                                                 psWriteBuffer->ui32Length,
+                                                 pui32BatchData,
+                                                 ui32BatchLength,
                                                  hciDrvWriteCallback,
                                                  0);
 
@@ -814,7 +1049,7 @@ hciDrvWriteCallback(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
 {
     CRITICAL_PRINT("INFO: HCI physical write complete.\n");
 
-    am_hal_queue_item_get(&g_sWriteQueue, 0, 1);
+    am_hal_queue_item_get(&g_sWriteQueue, 0, g_ui32TxBatchCount);
 
 #if TASK_LEVEL_DELAYS
 
@@ -823,23 +1058,29 @@ hciDrvWriteCallback(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
 
 #else // TASK_LEVEL_DELAYS
 
-    while ( BLEIFn(0)->BSTATUS_b.SPISTATUS )
+    //
+    // B0 parts report completion only after the SPI status falling edge, so
+    // the bus is already idle here. Older parts still have to poll for it.
+    //
+    if (!APOLLO3_GE_B0 || SKIP_FALLING_EDGES)
     {
-        am_util_delay_us(5);
+        while ( BLEIFn(0)->BSTATUS_b.SPISTATUS )
+        {
+            am_util_delay_us(5);
+        }
     }
 
     //
-    // Check the write queue, and possibly set wake again.
+    // If the controller raised IRQ during the write, read its packet now.
+    // Otherwise set wake again for the next queued write, if there is one.
     //
-    if ( !am_hal_queue_empty(&g_sWriteQueue) )
+    if (start_read() != AM_HAL_STATUS_SUCCESS)
     {
-        //
-        // In this case, we need to delay before setting wake. Instead of
-        // delaying here, we'll post an event to do it later.
-        //
         WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
     }
 
+    update_wake();
+
 #endif // TASK_LEVEL_DELAYS
 }
 
@@ -856,6 +1097,14 @@ hciDrvReadCallback(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
     //
     // CRITICAL_PRINT("INFO: HCI physical read complete.\n");
     g_ui32NumBytes = ui32Length;
+    if (ui32Length)
+    {
+        HCI_DRV_SNOOP_RX(g_pui8ReadBuffer, ui32Length);
+    }
+    else
+    {
+        g_bReadFailed = true;
+    }
     WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
 
 #if TASK_LEVEL_DELAYS
@@ -865,18 +1114,22 @@ hciDrvReadCallback(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
 
 #else // TASK_LEVEL_DELAYS
 
-    while ( BLE_IRQ_CHECK() )
+    //
+    // As above, B0 parts have already seen the IRQ falling edge by the time
+    // the read completes.
+    //
+    if (!APOLLO3_GE_B0 || SKIP_FALLING_EDGES)
     {
-        am_util_delay_us(5);
+        while ( BLE_IRQ_CHECK() )
+        {
+            am_util_delay_us(5);
+        }
     }
 
     //
     // Check the write queue, and possibly set wake.
     //
-    if ( !am_hal_queue_empty(&g_sWriteQueue) )
-    {
-        am_hal_ble_wakeup_set(BLE, 1);
-    }
+    update_wake();
 
 #endif // TASK_LEVEL_DELAYS
 }
@@ -892,9 +1145,7 @@ hciDrvReadCallback(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
 void
 HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
 {
-    uint32_t ui32ErrorStatus, ui32TxRetries = 0;
-    uint32_t ui32NumHciTransactions = 0;
-    uint32_t read_hci_packet_count = 0;
+    uint32_t ui32ErrorStatus;
 
     //
     // If this handler was called in response to a heartbeat event, then it's
@@ -920,6 +1171,18 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
         return;
     }
 
+    //
+    // The HAL ended the last read without data, so the packet framing can't
+    // be trusted any more.
+    //
+    if (g_bReadFailed)
+    {
+        g_bReadFailed = false;
+        g_ui32NumBytes = 0;
+        bReadBufferInUse = false;
+        ERROR_RECOVER(AM_HAL_BLE_HCI_PACKET_INCOMPLETE);
+    }
+
     //
     // Check to see if we read any bytes over the HCI interface that we haven't
     // already sent to the BLE stack.
@@ -954,55 +1217,28 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
         }
     }
 
-    if ( BLE_IRQ_CHECK() )
-    {
-        if (bReadBufferInUse == true)
-        {
-            CRITICAL_PRINT("Read buffer already in use.\n");
-            WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
-            return;
-        }
+    //
+    // Start the next read if the controller has a packet and the stack has
+    // taken the last one. A read already in flight sends this event again
+    // when it completes. A busy bus means a write is finishing, and its
+    // callback starts the read.
+    //
+    ui32ErrorStatus = start_read();
 
+    if ((ui32ErrorStatus != AM_HAL_STATUS_SUCCESS) &&
+        (ui32ErrorStatus != AM_HAL_BLE_STATUS_BUS_BUSY))
+    {
         //
-        // If the stack has used up all of the saved data we've accumulated so
-        // far, we should check to see if we need to read any *new* data.
+        // If the read didn't succeed for some physical reason, we need to
+        // know. We shouldn't get failures here, since start_read() checks
+        // the IRQ signal before starting the read.
         //
-        CRITICAL_PRINT("INFO: HCI Read started.\n");
-        bReadBufferInUse = true;
-        ui32ErrorStatus = am_hal_ble_nonblocking_hci_read(BLE,
-                                                          g_pui32ReadBuffer,
-                                                          hciDrvReadCallback,
-                                                          0);
+        CRITICAL_PRINT("HCI READ failed with status %d. "
+                       "Try recording with a logic analyzer "
+                       "to catch the error.\n",
+                       ui32ErrorStatus);
 
-        BLE_HEARTBEAT_RESTART();
-
-        if (g_ui32NumBytes > HCI_DRV_MAX_RX_PACKET)
-        {
-            CRITICAL_PRINT("ERROR: Trying to receive an HCI packet "
-                           "larger than the hci driver buffer size "
-                           "(needs %d bytes of space).\n",
-                           g_ui32NumBytes);
-
-            ERROR_CHECK_VOID(HCI_DRV_RX_PACKET_TOO_LARGE);
-        }
-
-        if (ui32ErrorStatus != AM_HAL_STATUS_SUCCESS)
-        {
-            //
-            // If the read didn't succeed for some physical reason, we need
-            // to know. We shouldn't get failures here. We checked the IRQ
-            // signal before calling the read function, and this driver
-            // only contains a single call to the blocking read function,
-            // so there shouldn't be any physical reason for the read to
-            // fail.
-            //
-            CRITICAL_PRINT("HCI READ failed with status %d. "
-                           "Try recording with a logic analyzer "
-                           "to catch the error.\n",
-                           ui32ErrorStatus);
-
-            ERROR_RECOVER(ui32ErrorStatus);
-        }
+        ERROR_RECOVER(ui32ErrorStatus);
     }
 }
 #else
@@ -1099,6 +1335,7 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
 
             if ( ui32ErrorStatus == AM_HAL_STATUS_SUCCESS)
             {
+                HCI_DRV_SNOOP_RX(g_pui8ReadBuffer, g_ui32NumBytes);
 
                 //
                 // If the read succeeded, we need to wait for the IRQ signal to
@@ -1125,6 +1362,11 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
 
                 if (g_consumed_bytes != g_ui32NumBytes)
                 {
+                    //
+                    // The stack is backing up, so drop back to the smallest
+                    // read burst until it catches up.
+                    //
+                    g_ui32ReadBudget = HCI_DRV_MAX_READ_PACKET;
 
                     // need to come back again
                     WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
@@ -1157,8 +1399,19 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
 
             am_hal_debug_gpio_clear(BLE_DEBUG_TRACE_02);
 
-            if (read_hci_packet_count >= HCI_DRV_MAX_READ_PACKET)
+            if (read_hci_packet_count >= g_ui32ReadBudget)
             {
+                //
+                // If the controller still has data waiting after a full
+                // burst, allow a longer burst next time so we spend less time
+                // bouncing through the WSF scheduler.
+                //
+                if (BLE_IRQ_CHECK() &&
+                    (g_ui32ReadBudget < HCI_DRV_MAX_READ_PACKET_LIMIT))
+                {
+                    g_ui32ReadBudget *= 2;
+                }
+
                 // It looks like there's time that we won't get interrupt even though
                 // there's packet waiting for host to grab.
                 WsfSetEvent(g_HciDrvHandleID, BLE_TRANSFER_NEEDED_EVENT);
@@ -1183,16 +1436,17 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
             else
             {
                 //
-                // If we do have something to write, just pop a single item
-                // from the queue and send it.
+                // If we do have something to write, gather as many queued
+                // packets as we can and send them in one wake cycle.
                 //
                 am_hal_debug_gpio_set(BLE_DEBUG_TRACE_07);
-                hci_drv_write_t *psWriteBuffer = am_hal_queue_peek(&g_sWriteQueue);
+                uint32_t ui32BatchLength;
+                uint32_t *pui32BatchData = build_tx_batch(&ui32BatchLength);
 
                 ui32ErrorStatus = am_hal_ble_blocking_hci_write(BLE,
                                                                 AM_HAL_BLE_RAW,
-                                                                psWriteBuffer->pui32Data,
-                                                                psWriteBuffer->ui32Length);
+                                                                pui32BatchData,
+                                                                ui32BatchLength);
 
                 //
                 // If we managed to actually send a packet, we can go ahead and
@@ -1205,7 +1459,7 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
                     //
                     BLE_HEARTBEAT_RESTART();
 
-                    am_hal_queue_item_get(&g_sWriteQueue, 0, 1);
+                    am_hal_queue_item_get(&g_sWriteQueue, 0, g_ui32TxBatchCount);
 
                     ui32TxRetries = 0;
                     // Resetting the cumulative count
@@ -1237,6 +1491,16 @@ HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
         ERROR_RECOVER(HCI_DRV_TOO_MANY_PACKETS);
     }
 
+    //
+    // Shrink the read budget again once traffic calms down so writes are not
+    // held off behind long read bursts.
+    //
+    if ((read_hci_packet_count < (g_ui32ReadBudget / 2)) &&
+        (g_ui32ReadBudget > HCI_DRV_MAX_READ_PACKET))
+    {
+        g_ui32ReadBudget /= 2;
+    }
+
     am_hal_debug_gpio_clear(BLE_DEBUG_TRACE_01);
 }
 #endif
@@ -1349,5 +1613,8 @@ HciDrvBleSleepSet(bool enable)
 void
 HciDrvEmptyWriteQueue(void)
 {
+#if HCI_DRV_TX_FLUSH_TIMER
+    WsfTimerStop(&g_TxFlushTimer);
+#endif
     am_hal_queue_from_array(&g_sWriteQueue, g_psWriteBuffers);
 }
@@ -33,6 +33,7 @@
 #include "hci_api.h"
 #include "hci_main.h"
 #include "l2c_defs.h"
+#include "att_defs.h"
 
 /**************************************************************************************************
   Macros
@@ -50,6 +51,11 @@
 #endif
 #endif
 
+/* Default number of ACL buffers a connection may send per round-robin turn */
+#ifndef HCI_ACL_TX_WEIGHT
+#define HCI_ACL_TX_WEIGHT         1
+#endif
+
 /* Default maximum ACL packet size for reassembly */
 #ifndef HCI_MAX_RX_ACL_LEN
 #define HCI_MAX_RX_ACL_LEN        HCI_ACL_DEFAULT_LEN
@@ -166,6 +172,13 @@ static void hciCoreConnAlloc(uint16_t handle)
       pConn->flowDisabled = FALSE;
       pConn->outBufs = 0;
       pConn->queuedBufs = 0;
+      WSF_QUEUE_INIT(&pConn->aclQueue);
+      WSF_QUEUE_INIT(&pConn->aclPriQueue);
+      pConn->txPriFrag = FALSE;
+      pConn->txWeight = HCI_ACL_TX_WEIGHT;
+      pConn->txDeficit = 0;
+
+      hciCoreCb.numConns++;
 
       return;
     }
@@ -174,6 +187,48 @@ static void hciCoreConnAlloc(uint16_t handle)
   HCI_TRACE_WARN0("HCI conn struct alloc failure");
 }
 
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreConnFlush
+ *
+ *  \brief  Free all TX and RX ACL buffers held by a connection structure.
+ *
+ *  \param  pConn    Pointer to connection structure.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void hciCoreConnFlush(hciCoreConn_t *pConn)
+{
+  uint8_t         *pData;
+  wsfHandlerId_t  handlerId;
+
+  /* free any fragmenting ACL packet */
+  if (pConn->pTxAclPkt != NULL)
+  {
+    WsfMsgFree(pConn->pTxAclPkt);
+    pConn->pTxAclPkt = NULL;
+  }
+  pConn->fragmenting = FALSE;
+  pConn->txAclRemLen = 0;
+
+  if (pConn->pRxAclPkt != NULL)
+  {
+    WsfMsgFree(pConn->pRxAclPkt);
+    pConn->pRxAclPkt = NULL;
+  }
+
+  /* free any queued TX ACL packets */
+  while ((pData = WsfMsgDeq(&pConn->aclPriQueue, &handlerId)) != NULL)
+  {
+    WsfMsgFree(pData);
+  }
+  while ((pData = WsfMsgDeq(&pConn->aclQueue, &handlerId)) != NULL)
+  {
+    WsfMsgFree(pData);
+  }
+}
+
 /*************************************************************************************************/
 /*!
  *  \fn     hciCoreConnFree
@@ -195,24 +250,12 @@ static void hciCoreConnFree(uint16_t handle)
   {
     if (pConn->handle == handle)
     {
-      /* free any fragmenting ACL packet */
-      if (pConn->pTxAclPkt != NULL)
-      {
-        WsfMsgFree(pConn->pTxAclPkt);
-        pConn->pTxAclPkt = NULL;
-      }
-      pConn->fragmenting = FALSE;
-
-      if (pConn->pRxAclPkt != NULL)
-      {
-        WsfMsgFree(pConn->pRxAclPkt);
-        pConn->pRxAclPkt = NULL;
-      }
+      /* free any fragmenting and queued ACL packets */
+      hciCoreConnFlush(pConn);
 
       /* free structure */
       pConn->handle = HCI_HANDLE_NONE;
-
-      /* optional: iterate through tx ACL queue and free any buffers with this handle */
+      hciCoreCb.numConns--;
 
       /* outstanding buffers are now available; service TX data path */
       hciCoreTxReady(pConn->outBufs);
@@ -278,6 +321,202 @@ static hciCoreConn_t *hciCoreNextConnFragment(void)
   return NULL;
 }
 
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreAclIsPriority
+ *
+ *  \brief  Check whether an ACL packet belongs in the priority TX queue.  L2CAP signaling and
+ *          ATT responses and confirmations are small and hold up the peer until they are
+ *          sent, so they are not made to wait behind bulk data on any connection.
+ *
+ *  \param  pData    WSF buffer containing an ACL packet.
+ *  \param  len      ACL packet length.
+ *
+ *  \return TRUE if priority packet, FALSE otherwise.
+ */
+/*************************************************************************************************/
+static bool_t hciCoreAclIsPriority(uint8_t *pData, uint16_t len)
+{
+  uint16_t cid;
+
+  if (len < L2C_HDR_LEN)
+  {
+    return FALSE;
+  }
+
+  BYTES_TO_UINT16(cid, &pData[HCI_ACL_HDR_LEN + 2]);
+
+  if (cid == L2C_CID_LE_SIGNALING)
+  {
+    return TRUE;
+  }
+
+  if (cid == L2C_CID_ATT && len > L2C_HDR_LEN)
+  {
+    switch (pData[L2C_PAYLOAD_START])
+    {
+      case ATT_PDU_ERR_RSP:
+      case ATT_PDU_MTU_RSP:
+      case ATT_PDU_FIND_INFO_RSP:
+      case ATT_PDU_FIND_TYPE_RSP:
+      case ATT_PDU_READ_TYPE_RSP:
+      case ATT_PDU_READ_RSP:
+      case ATT_PDU_READ_BLOB_RSP:
+      case ATT_PDU_READ_MULT_RSP:
+      case ATT_PDU_READ_GROUP_TYPE_RSP:
+      case ATT_PDU_WRITE_RSP:
+      case ATT_PDU_PREP_WRITE_RSP:
+      case ATT_PDU_EXEC_WRITE_RSP:
+      case ATT_PDU_VALUE_CNF:
+        return TRUE;
+
+      default:
+        break;
+    }
+  }
+
+  return FALSE;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreTxQuota
+ *
+ *  \brief  Get the maximum number of outstanding ACL buffers per connection.  Unless set with
+ *          HciSetAclConnQuota(), each connection leaves one controller buffer free for every
+ *          other connection, so a bulk sender cannot hold all of them.
+ *
+ *  \return Buffer quota.
+ */
+/*************************************************************************************************/
+static uint8_t hciCoreTxQuota(void)
+{
+  uint8_t quota = hciCoreCb.numBufs;
+
+  if (hciCoreCb.aclConnQuota != 0)
+  {
+    if (hciCoreCb.aclConnQuota < quota)
+    {
+      quota = hciCoreCb.aclConnQuota;
+    }
+  }
+  else if (hciCoreCb.numConns > 1)
+  {
+    quota = (quota >= hciCoreCb.numConns) ? (quota - (hciCoreCb.numConns - 1)) : 1;
+  }
+
+  return (quota > 0) ? quota : 1;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreTxPriPending
+ *
+ *  \brief  Check whether a connection has priority ACL data to send.  A packet already being
+ *          fragmented on the connection is finished first, at priority.
+ *
+ *  \param  pConn    Pointer to connection structure.
+ *
+ *  \return TRUE if data pending, FALSE otherwise.
+ */
+/*************************************************************************************************/
+static bool_t hciCoreTxPriPending(hciCoreConn_t *pConn)
+{
+  if (pConn->handle == HCI_HANDLE_NONE)
+  {
+    return FALSE;
+  }
+
+  if (pConn->fragmenting)
+  {
+    return (pConn->txAclRemLen > 0) &&
+           (pConn->txPriFrag || !WsfQueueEmpty(&pConn->aclPriQueue));
+  }
+
+  return !WsfQueueEmpty(&pConn->aclPriQueue);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreTxPending
+ *
+ *  \brief  Check whether a connection has regular ACL data to send.
+ *
+ *  \param  pConn    Pointer to connection structure.
+ *
+ *  \return TRUE if data pending, FALSE otherwise.
+ */
+/*************************************************************************************************/
+static bool_t hciCoreTxPending(hciCoreConn_t *pConn)
+{
+  if (pConn->handle == HCI_HANDLE_NONE)
+  {
+    return FALSE;
+  }
+
+  if (pConn->fragmenting)
+  {
+    return (pConn->txAclRemLen > 0) && !pConn->txPriFrag;
+  }
+
+  return !WsfQueueEmpty(&pConn->aclQueue);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreTxNextConn
+ *
+ *  \brief  Pick the connection to send the next ACL buffer.  Priority data goes first.  Regular
+ *          data is sent weighted round-robin in units of controller buffers, so a connection
+ *          sending large packets gets no more than its share, and only while it is within its
+ *          buffer quota.
+ *
+ *  \param  pPriority  Set to TRUE if the buffer is to be taken from the priority queue.
+ *
+ *  \return Pointer to connection structure or NULL if nothing can be sent.
+ */
+/*************************************************************************************************/
+static hciCoreConn_t *hciCoreTxNextConn(bool_t *pPriority)
+{
+  uint8_t         i;
+  uint8_t         quota;
+  hciCoreConn_t   *pConn;
+
+  /* priority data, not subject to the quota */
+  for (i = 0; i < DM_CONN_MAX; i++)
+  {
+    pConn = &hciCoreCb.conn[(hciCoreCb.txRrIdx + i) % DM_CONN_MAX];
+
+    if (hciCoreTxPriPending(pConn))
+    {
+      *pPriority = TRUE;
+      return pConn;
+    }
+  }
+
+  *pPriority = FALSE;
+  quota = hciCoreTxQuota();
+
+  /* regular data; visit every connection at most once */
+  for (i = 0; i <= DM_CONN_MAX; i++)
+  {
+    pConn = &hciCoreCb.conn[hciCoreCb.txRrIdx];
+
+    if (pConn->txDeficit > 0 && pConn->outBufs < quota && hciCoreTxPending(pConn))
+    {
+      pConn->txDeficit--;
+      return pConn;
+    }
+
+    /* turn is over; pass it to the next connection */
+    hciCoreCb.txRrIdx = (hciCoreCb.txRrIdx + 1) % DM_CONN_MAX;
+    pConn = &hciCoreCb.conn[hciCoreCb.txRrIdx];
+    pConn->txDeficit = hciCoreTxPending(pConn) ? pConn->txWeight : 0;
+  }
+
+  return NULL;
+}
+
 /*************************************************************************************************/
 /*!
  *  \fn     hciCoreConnOpen
@@ -359,9 +598,9 @@ void hciCoreTxReady(uint8_t bufs)
 {
   uint8_t         *pData;
   wsfHandlerId_t  handlerId;
-  uint16_t        handle;
   uint16_t        len;
   hciCoreConn_t   *pConn;
+  bool_t          priority;
 
   /* increment available buffers, with ceiling */
   if (bufs > 0)
@@ -373,38 +612,29 @@ void hciCoreTxReady(uint8_t bufs)
     }
   }
 
-  /* service ACL data queue and send as many buffers as we can */
+  /* service ACL data queues and send as many buffers as we can, one at a time */
   while (hciCoreCb.availBufs > 0)
   {
+    if ((pConn = hciCoreTxNextConn(&priority)) == NULL)
+    {
+      /* nothing to send, or all connections with data are over quota; we're done */
+      break;
+    }
+
     /* send continuation of any fragments first */
-    if (hciCoreTxAclContinue(NULL) == FALSE)
+    if (pConn->fragmenting)
     {
-      /* if no fragments then check for any queued ACL data */
-      if ((pData = WsfMsgDeq(&hciCoreCb.aclQueue, &handlerId)) != NULL)
-      {
-        /* parse handle and length */
-        BYTES_TO_UINT16(handle, pData);
-        BYTES_TO_UINT16(len, &pData[2]);
+      hciCoreTxAclContinue(pConn);
+    }
+    else
+    {
+      pData = WsfMsgDeq(priority ? &pConn->aclPriQueue : &pConn->aclQueue, &handlerId);
 
-        /* look up conn structure and send data */
-        if ((pConn = hciCoreConnByHandle(handle)) != NULL)
-        {
-          hciCoreTxAclStart(pConn, len, pData);
-        }
-        /* handle not found, connection must be closed */
-        else
-        {
-          /* discard buffer */
-          WsfMsgFree(pData);
+      /* parse length and send data */
+      BYTES_TO_UINT16(len, &pData[2]);
 
-          HCI_TRACE_WARN1("hciCoreTxReady discarding buffer, handle=%u", handle);
-        }
-      }
-      else
-      {
-        /* no fragments or queued data to send; we're done */
-        break;
-      }
+      pConn->txPriFrag = priority;
+      hciCoreTxAclStart(pConn, len, pData);
     }
   }
 }
@@ -449,11 +679,8 @@ void hciCoreTxAclStart(hciCoreConn_t *pConn, uint16_t len, uint8_t *pData)
     /* set acl len in packet to hci acl buf len */
     UINT16_TO_BUF(&pData[2], hciLen);
 
-    /* send the packet */
+    /* send the packet; hciCoreTxReady() schedules the remaining fragments */
     hciCoreSendAclData(pConn, pData);
-
-    /* send additional fragments while there are HCI buffers available */
-    while ((hciCoreCb.availBufs > 0) && hciCoreTxAclContinue(pConn));
   }
   else
   {
@@ -692,6 +919,132 @@ uint8_t *hciCoreAclReassembly(uint8_t *pData)
   return pDataRtn;
 }
 
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreAclRxDest
+ *
+ *  \brief  Get the reassembly buffer location for the payload of a received ACL packet, so
+ *          the transport can copy the payload there directly instead of allocating a buffer
+ *          for the fragment.  Must be followed by hciCoreAclRxDone() once the payload has
+ *          been copied.
+ *
+ *          This is only done when the RX queue is empty, so that connection and reassembly
+ *          state is current.  Single-fragment packets and anything unusual are left to the
+ *          normal receive path.  The queue and connection state are read without the WSF
+ *          stack lock, so this must be called from WSF task 0, as the HCI driver is.
+ *
+ *  \param  pHdr    ACL packet header.
+ *  \param  pData   ACL packet payload, or NULL if it is not yet available.
+ *
+ *  \return Pointer to copy the payload to, or NULL to use the normal receive path.
+ */
+/*************************************************************************************************/
+uint8_t *hciCoreAclRxDest(uint8_t *pHdr, uint8_t *pData)
+{
+  hciCoreConn_t *pConn;
+  uint16_t      handle;
+  uint16_t      aclLen;
+  uint16_t      l2cLen;
+  uint16_t      pbf;
+
+  hciCoreCb.pConnRx = NULL;
+
+  /* earlier packets still queued could change connection or reassembly state */
+  if (!WsfQueueEmpty(&hciCb.rxQueue))
+  {
+    return NULL;
+  }
+
+  BYTES_TO_UINT16(handle, pHdr);
+  pbf = handle & HCI_PB_FLAG_MASK;
+  handle &= HCI_HANDLE_MASK;
+  BYTES_TO_UINT16(aclLen, &pHdr[2]);
+
+  if ((pConn = hciCoreConnByHandle(handle)) == NULL)
+  {
+    return NULL;
+  }
+
+  /* if this is a start packet */
+  if (pbf == HCI_PB_START_C2H)
+  {
+    if ((pData == NULL) || (pConn->pRxAclPkt != NULL) || (aclLen < L2C_HDR_LEN))
+    {
+      return NULL;
+    }
+
+    BYTES_TO_UINT16(l2cLen, pData);
+
+    /* only packets that need reassembly and fit the configured maximum */
+    if (((l2cLen + L2C_HDR_LEN) <= aclLen) ||
+        ((l2cLen + L2C_HDR_LEN) > hciCoreCb.maxRxAclLen))
+    {
+      return NULL;
+    }
+
+    /* allocate buffer to store complete l2cap packet */
+    if ((pConn->pRxAclPkt = WsfMsgDataAlloc(l2cLen + L2C_HDR_LEN + HCI_ACL_HDR_LEN, 0)) == NULL)
+    {
+      return NULL;
+    }
+
+    /* build acl header; the payload goes right after it */
+    pConn->pNextRxFrag = pConn->pRxAclPkt;
+    UINT16_TO_BSTREAM(pConn->pNextRxFrag, handle);
+    UINT16_TO_BSTREAM(pConn->pNextRxFrag, l2cLen + L2C_HDR_LEN);
+    pConn->rxAclRemLen = l2cLen + L2C_HDR_LEN;
+  }
+  /* else if this is an expected continuation packet */
+  else if (pbf == HCI_PB_CONTINUE)
+  {
+    if ((pConn->pRxAclPkt == NULL) || (aclLen > pConn->rxAclRemLen))
+    {
+      return NULL;
+    }
+  }
+  else
+  {
+    return NULL;
+  }
+
+  hciCoreCb.pConnRx = pConn;
+
+  return pConn->pNextRxFrag;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciCoreAclRxDone
+ *
+ *  \brief  Complete a received ACL packet whose payload was copied to the location returned
+ *          by hciCoreAclRxDest().  When the L2CAP packet is complete it is queued for the
+ *          HCI handler.
+ *
+ *  \param  len     ACL payload length.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void hciCoreAclRxDone(uint16_t len)
+{
+  hciCoreConn_t *pConn = hciCoreCb.pConnRx;
+
+  WSF_ASSERT(pConn != NULL);
+
+  hciCoreCb.pConnRx = NULL;
+
+  pConn->pNextRxFrag += len;
+  pConn->rxAclRemLen -= len;
+
+  /* if reassembly complete queue reassembled packet */
+  if (pConn->rxAclRemLen == 0)
+  {
+    WsfMsgEnq(&hciCb.rxQueue, HCI_ACL_REASSEMBLED_TYPE, pConn->pRxAclPkt);
+    WsfSetEvent(hciCb.handlerId, HCI_EVT_RX);
+    pConn->pRxAclPkt = NULL;
+  }
+}
+
 /*************************************************************************************************/
 /*!
  *  \fn     hciCoreTxAclDataFragmented
@@ -721,13 +1074,17 @@ void HciCoreInit(void)
 {
   uint8_t   i;
 
-  WSF_QUEUE_INIT(&hciCoreCb.aclQueue);
-
   for (i = 0; i < DM_CONN_MAX; i++)
   {
     hciCoreCb.conn[i].handle = HCI_HANDLE_NONE;
+    WSF_QUEUE_INIT(&hciCoreCb.conn[i].aclQueue);
+    WSF_QUEUE_INIT(&hciCoreCb.conn[i].aclPriQueue);
   }
 
+  hciCoreCb.numConns = 0;
+  hciCoreCb.aclConnQuota = 0;
+  hciCoreCb.txRrIdx = 0;
+
   hciCoreCb.maxRxAclLen = HCI_MAX_RX_ACL_LEN;
   hciCoreCb.aclQueueHi = HCI_ACL_QUEUE_HI;
   hciCoreCb.aclQueueLo = HCI_ACL_QUEUE_LO;
@@ -765,30 +1122,19 @@ void HciResetSequence(void)
   /* find connection struct */
   for (i = DM_CONN_MAX; i > 0; i--, pConn++)
   {
-    /* free any fragmenting ACL packet */
-    if (pConn->pTxAclPkt != NULL)
-    {
-      WsfMsgFree(pConn->pTxAclPkt);
-      pConn->pTxAclPkt = NULL;
-    }
-    pConn->fragmenting = FALSE;
-
-    if (pConn->pRxAclPkt != NULL)
-    {
-      WsfMsgFree(pConn->pRxAclPkt);
-      pConn->pRxAclPkt = NULL;
-    }
+    /* free any fragmenting and queued ACL packets */
+    hciCoreConnFlush(pConn);
 
     /* free structure */
     pConn->handle = HCI_HANDLE_NONE;
 
-    /* optional: iterate through tx ACL queue and free any buffers with this handle */
-
     /* outstanding buffers are now available; service TX data path */
     hciCoreTxReady(pConn->outBufs);
 
   }
 
+  hciCoreCb.numConns = 0;
+
   /* set resetting state */
   hciCb.resetting = TRUE;
 
@@ -830,6 +1176,46 @@ void HciSetAclQueueWatermarks(uint8_t queueHi, uint8_t queueLo)
   hciCoreCb.aclQueueLo = queueLo;
 }
 
+/*************************************************************************************************/
+/*!
+ *  \fn     HciSetAclConnQuota
+ *
+ *  \brief  Set the maximum number of ACL buffers a connection may have outstanding in the
+ *          controller.  Priority data (L2CAP signaling and ATT responses) is not limited.
+ *
+ *  \param  quota     Buffer quota, or 0 to leave one buffer for every other connection.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void HciSetAclConnQuota(uint8_t quota)
+{
+  hciCoreCb.aclConnQuota = quota;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     HciSetAclConnWeight
+ *
+ *  \brief  Set the TX scheduling weight of a connection, the number of ACL buffers it may send
+ *          per round-robin turn.  The weight returns to the default when the connection closes.
+ *
+ *  \param  handle    Connection handle.
+ *  \param  weight    Scheduling weight, minimum 1.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void HciSetAclConnWeight(uint16_t handle, uint8_t weight)
+{
+  hciCoreConn_t   *pConn;
+
+  if ((pConn = hciCoreConnByHandle(handle)) != NULL)
+  {
+    pConn->txWeight = (weight > 0) ? weight : 1;
+  }
+}
+
 /*************************************************************************************************/
 /*!
 *  \fn      HciSetLeSupFeat
@@ -881,21 +1267,22 @@ void HciSendAclData(uint8_t *pData)
   /* look up connection structure */
   if ((pConn = hciCoreConnByHandle(handle)) != NULL)
   {
-    /* if queue empty and buffers available */
-    if (WsfQueueEmpty(&hciCoreCb.aclQueue) && hciCoreCb.availBufs > 0)
+    /* queue data - message handler ID 'handerId' not used */
+    if (hciCoreAclIsPriority(pData, len))
     {
-      /* send data */
-      hciCoreTxAclStart(pConn, len, pData);
+      WsfMsgEnq(&pConn->aclPriQueue, 0, pData);
     }
     else
     {
-      /* queue data - message handler ID 'handerId' not used */
-      WsfMsgEnq(&hciCoreCb.aclQueue, 0, pData);
+      WsfMsgEnq(&pConn->aclQueue, 0, pData);
     }
 
     /* increment buffer queue count for this connection with consideration for HCI fragmentation */
     pConn->queuedBufs += ((len - 1) / HciGetBufSize()) + 1;
 
+    /* send data if buffers available */
+    hciCoreTxReady(0);
+
     /* manage flow control to stack */
     if (pConn->queuedBufs >= hciCoreCb.aclQueueHi && pConn->flowDisabled == FALSE)
     {
@@ -178,6 +178,12 @@ void HciCoreHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
         /* Free buffer */
         WsfMsgFree(pBuf);
       }
+      /* Handle ACL data reassembled by the transport; nothing left to do */
+      else if (handlerId == HCI_ACL_REASSEMBLED_TYPE)
+      {
+        /* Call ACL callback; client will free buffer */
+        hciCb.aclCback(pBuf);
+      }
       /* Handle ACL data */
       else
       {
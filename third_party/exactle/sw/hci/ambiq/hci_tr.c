@@ -20,6 +20,7 @@
  */
 /*************************************************************************************************/
 
+#include <string.h>
 #include "wsf_types.h"
 #include "wsf_msg.h"
 #include "wsf_trace.h"
@@ -118,12 +119,92 @@ void hciTrSendCmd(uint8_t *pData)
 }
 
 
+/*************************************************************************************************/
+/*!
+ *  \fn     hciTrRxHdrLen
+ *
+ *  \brief  Get the header length of a received packet type.
+ *
+ *  \param  pktInd  Packet indicator.
+ *
+ *  \return Header length, or 0 if the packet type is not supported.
+ */
+/*************************************************************************************************/
+static uint8_t hciTrRxHdrLen(uint8_t pktInd)
+{
+  if (pktInd == HCI_EVT_TYPE)
+  {
+    return HCI_EVT_HDR_LEN;
+  }
+  else if (pktInd == HCI_ACL_TYPE)
+  {
+    return HCI_ACL_HDR_LEN;
+  }
+
+  return 0;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciTrRxDataLen
+ *
+ *  \brief  Extract the data length from a received packet header.
+ *
+ *  \param  pktInd  Packet indicator.
+ *  \param  pHdr    Packet header.
+ *
+ *  \return Data length.
+ */
+/*************************************************************************************************/
+static uint16_t hciTrRxDataLen(uint8_t pktInd, uint8_t *pHdr)
+{
+  uint16_t dataLen;
+
+  if (pktInd == HCI_EVT_TYPE)
+  {
+    dataLen = pHdr[1];
+  }
+  else
+  {
+    BYTES_TO_UINT16(dataLen, &pHdr[2]);
+  }
+
+  return dataLen;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     hciTrRxAlloc
+ *
+ *  \brief  Allocate a buffer for a received packet.
+ *
+ *  \param  pktInd  Packet indicator.
+ *  \param  len     Header plus data length.
+ *
+ *  \return Pointer to buffer or NULL if allocation failed.
+ */
+/*************************************************************************************************/
+static uint8_t *hciTrRxAlloc(uint8_t pktInd, uint16_t len)
+{
+  if (pktInd == HCI_ACL_TYPE)
+  {
+    return (uint8_t*)WsfMsgDataAlloc(len, 0);
+  }
+
+  return (uint8_t*)WsfMsgAlloc(len);
+}
+
 /*************************************************************************************************/
 /*!
  *  \fn     hciSerialRxIncoming
  *
  *  \brief  Receive function.  Gets called by external code when bytes are received.
  *
+ *          When a whole packet is present in the incoming buffer it is copied out in one
+ *          go; ACL fragments that are part of a longer L2CAP packet are copied straight
+ *          into the reassembly buffer.  Packets split across calls go through the header
+ *          and data states, which also copy as many bytes at a time as are available.
+ *
  *  \param  pBuf   Pointer to buffer of incoming bytes.
  *  \param  len    Number of bytes in incoming buffer.
  *
@@ -139,94 +220,102 @@ uint16_t hciTrSerialRxIncoming(uint8_t *pBuf, uint16_t len)
   static uint8_t    *pPktRx;
   static uint8_t    *pDataRx;
 
-  uint8_t   dataByte;
+  uint8_t   hdrLen;
+  uint16_t  dataLen;
+  uint16_t  chunk;
   uint16_t  consumed_bytes;
 
+  /* a single payload byte, as from a transport that delivers byte by byte, is
+   * stored without going round the state machine */
+  if (len == 1 && stateRx == HCI_RX_STATE_DATA && iRx > 1)
+  {
+    *pDataRx++ = *pBuf;
+    iRx--;
+    return 1;
+  }
+
   consumed_bytes = 0;
   /* loop until all bytes of incoming buffer are handled */
   while (len)
   {
-    /* read single byte from incoming buffer and advance to next byte */
-    dataByte = *pBuf;
- 
     /* --- Idle State --- */
     if (stateRx == HCI_RX_STATE_IDLE)
     {
       /* save the packet type */
-      pktIndRx = dataByte;
+      pktIndRx = *pBuf;
       iRx      = 0;
       stateRx  = HCI_RX_STATE_HEADER;
       g_bHCIReceivingPacket = TRUE;
       pBuf++;
       consumed_bytes++;
       len--;
+
+      /* fast path: header and data are all here */
+      hdrLen = hciTrRxHdrLen(pktIndRx);
+      if (hdrLen != 0 && len >= hdrLen)
+      {
+        dataLen = hciTrRxDataLen(pktIndRx, pBuf);
+
+        /* ACL fragments go straight into the core's reassembly buffer when possible */
+        if ((uint32_t)len >= (uint32_t)hdrLen + dataLen && pktIndRx == HCI_ACL_TYPE &&
+            (pDataRx = hciCoreAclRxDest(pBuf, &pBuf[hdrLen])) != NULL)
+        {
+          memcpy(pDataRx, &pBuf[hdrLen], dataLen);
+          hciCoreAclRxDone(dataLen);
+          pBuf += hdrLen + dataLen;
+          consumed_bytes += hdrLen + dataLen;
+          len -= hdrLen + dataLen;
+          pPktRx = NULL;
+          stateRx = HCI_RX_STATE_COMPLETE;
+        }
+        else if ((uint32_t)len >= (uint32_t)hdrLen + dataLen &&
+                 (pPktRx = hciTrRxAlloc(pktIndRx, hdrLen + dataLen)) != NULL)
+        {
+          memcpy(pPktRx, pBuf, hdrLen + dataLen);
+          pBuf += hdrLen + dataLen;
+          consumed_bytes += hdrLen + dataLen;
+          len -= hdrLen + dataLen;
+          stateRx = HCI_RX_STATE_COMPLETE;
+        }
+      }
     }
 
     /* --- Header State --- */
     else if (stateRx == HCI_RX_STATE_HEADER)
     {
-      uint8_t  hdrLen = 0;
-      uint16_t dataLen = 0;
-
       /* determine header length based on packet type */
-      if (pktIndRx == HCI_EVT_TYPE)
-      {
-        hdrLen = HCI_EVT_HDR_LEN;
-      }
-      else if (pktIndRx == HCI_ACL_TYPE)
-      {
-        hdrLen = HCI_ACL_HDR_LEN;
-      }
-      else
+      hdrLen = hciTrRxHdrLen(pktIndRx);
+      if (hdrLen == 0)
       {
         /* invalid packet type */
         WSF_ASSERT(0);
         return consumed_bytes;
       }
 
-      if (iRx != hdrLen) {
-        /* copy current byte into the temp header buffer */
-        hdrRx[iRx++] = dataByte;
-        pBuf++;
-        consumed_bytes++;
-        len--;
+      /* copy as much of the header as is available into the temp header buffer;
+       * it is at most a few bytes, so copy them directly rather than call memcpy */
+      chunk = (len < hdrLen - iRx) ? len : (hdrLen - iRx);
+      consumed_bytes += chunk;
+      len -= chunk;
+      while (chunk--)
+      {
+        hdrRx[iRx++] = *pBuf++;
       }
 
       /* see if entire header has been read */
       if (iRx == hdrLen)
       {
         /* extract data length from header */
-        if (pktIndRx == HCI_EVT_TYPE)
-        {
-          dataLen = hdrRx[1];
-        }
-        else if (pktIndRx == HCI_ACL_TYPE)
-        {
-          BYTES_TO_UINT16(dataLen, &hdrRx[2]);
-        }
+        dataLen = hciTrRxDataLen(pktIndRx, hdrRx);
 
         /* allocate data buffer to hold entire packet */
-        if (pktIndRx == HCI_ACL_TYPE)
-        {
-          pPktRx = (uint8_t*)WsfMsgDataAlloc(hdrLen + dataLen, 0);
-        }
-        else
-        {
-          pPktRx = (uint8_t*)WsfMsgAlloc(hdrLen + dataLen);
-        }
+        pPktRx = hciTrRxAlloc(pktIndRx, hdrLen + dataLen);
 
         if (pPktRx != NULL)
         {
-          pDataRx = pPktRx;
-
-          /* copy header into data packet (note: memcpy is not so portable) */
-          {
-            uint8_t  i;
-            for (i = 0; i < hdrLen; i++)
-            {
-              *pDataRx++ = hdrRx[i];
-            }
-          }
+          /* copy header into data packet */
+          memcpy(pPktRx, hdrRx, hdrLen);
+          pDataRx = pPktRx + hdrLen;
 
           /* save number of bytes left to read */
           iRx = dataLen;
@@ -244,25 +333,35 @@ uint16_t hciTrSerialRxIncoming(uint8_t *pBuf, uint16_t len)
           WSF_ASSERT(0); /* allocate falied */
           return consumed_bytes;
         }
-
       }
     }
 
     /* --- Data State --- */
     else if (stateRx == HCI_RX_STATE_DATA)
     {
-      /* write incoming byte to allocated buffer */
-      *pDataRx++ = dataByte;
+      /* copy as much of the data as is available into the allocated buffer;
+       * a single byte, as when the transport delivers byte by byte, is
+       * cheaper to copy directly than through memcpy */
+      chunk = (len < iRx) ? len : iRx;
+      if (chunk == 1)
+      {
+        *pDataRx = *pBuf;
+      }
+      else
+      {
+        memcpy(pDataRx, pBuf, chunk);
+      }
+      pDataRx += chunk;
+      pBuf += chunk;
+      consumed_bytes += chunk;
+      len -= chunk;
 
       /* determine if entire packet has been read */
-      iRx--;
+      iRx -= chunk;
       if (iRx == 0)
       {
         stateRx = HCI_RX_STATE_COMPLETE;
       }
-      pBuf++;
-      consumed_bytes++;
-      len--;
     }
 
     /* --- Complete State --- */
@@ -274,9 +373,7 @@ uint16_t hciTrSerialRxIncoming(uint8_t *pBuf, uint16_t len)
       /* deliver data */
       if (pPktRx != NULL)
       {
-        //am_hal_gpio_out_bit_set(13);
         hciCoreRecv(pktIndRx, pPktRx);
-        //am_hal_gpio_out_bit_clear(13);
       }
 
       /* reset state machine */
@@ -32,6 +32,13 @@
 extern "C" {
 #endif
 
+/**************************************************************************************************
+  Macros
+**************************************************************************************************/
+
+/* RX queue message type for an ACL packet already reassembled by the transport */
+#define HCI_ACL_REASSEMBLED_TYPE    0xFF
+
 /**************************************************************************************************
   Callback Function Types
 **************************************************************************************************/
@@ -56,6 +63,11 @@ typedef struct
   bool_t          flowDisabled;                 /* TRUE if data flow disabled */
   uint8_t         queuedBufs;                   /* Queued ACL buffers on this connection */
   uint8_t         outBufs;                      /* Outstanding ACL buffers sent to controller */
+  wsfQueue_t      aclQueue;                     /* TX ACL queue */
+  wsfQueue_t      aclPriQueue;                  /* TX ACL queue for L2CAP signaling and ATT responses */
+  bool_t          txPriFrag;                    /* TRUE if the fragmenting TX ACL packet is priority */
+  uint8_t         txWeight;                     /* ACL buffers sent per round-robin turn */
+  uint8_t         txDeficit;                    /* ACL buffers left in the current turn */
 } hciCoreConn_t;
 
 /* Main control block for dual-chip implementation */
@@ -64,7 +76,6 @@ typedef struct
   hciCoreConn_t   conn[DM_CONN_MAX];            /* Connection structures */
   uint8_t         leStates[HCI_LE_STATES_LEN];  /* Controller LE supported states */
   bdAddr_t        bdAddr;                       /* Bluetooth device address */
-  wsfQueue_t      aclQueue;                     /* HCI ACL TX queue */
   hciCoreConn_t   *pConnRx;                     /* Connection struct for current transport RX packet */
   uint16_t        maxRxAclLen;                  /* Maximum reassembled RX ACL packet length */
   uint16_t        bufSize;                      /* Controller ACL data buffer size */
@@ -72,6 +83,9 @@ typedef struct
   uint8_t         aclQueueLo;                   /* Enable flow when this many ACL buffers queued */
   uint8_t         availBufs;                    /* Current avail ACL data buffers */
   uint8_t         numBufs;                      /* Controller number of ACL data buffers */
+  uint8_t         numConns;                     /* Number of allocated connection structures */
+  uint8_t         aclConnQuota;                 /* Max outstanding ACL buffers per connection */
+  uint8_t         txRrIdx;                      /* Connection holding the ACL round-robin turn */
   uint8_t         whiteListSize;                /* Controller white list size */
   uint8_t         numCmdPkts;                   /* Controller command packed count */
   uint16_t        leSupFeat;                    /* Controller LE supported features */
@@ -117,6 +131,8 @@ void hciCoreTxAclStart(hciCoreConn_t *pConn, uint16_t len, uint8_t *pData);
 bool_t hciCoreTxAclContinue(hciCoreConn_t *pConn);
 void hciCoreTxAclComplete(hciCoreConn_t *pConn, uint8_t *pData);
 uint8_t *hciCoreAclReassembly(uint8_t *pData);
+uint8_t *hciCoreAclRxDest(uint8_t *pHdr, uint8_t *pData);
+void hciCoreAclRxDone(uint16_t len);
 bool_t hciCoreTxAclDataFragmented(hciCoreConn_t *pConn);
 
 #ifdef __cplusplus
@@ -696,6 +696,8 @@ void HciCoreInit(void);
 void HciCoreHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg);
 void HciSetMaxRxAclLen(uint16_t len);
 void HciSetAclQueueWatermarks(uint8_t queueHi, uint8_t queueLo);
+void HciSetAclConnQuota(uint8_t quota);
+void HciSetAclConnWeight(uint16_t handle, uint8_t weight);
 void HciSetLeSupFeat(uint16_t feat, bool_t flag);
 
 /*! Optimization interface */
@@ -34,6 +34,12 @@
 #include "wsf_msg.h"
 #include "wsf_cs.h"
 
+#ifdef AM_FREERTOS
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "semphr.h"
+#endif
+
 /**************************************************************************************************
   Compile time assert checks
 **************************************************************************************************/
@@ -51,6 +57,21 @@ WSF_CT_ASSERT(sizeof(uint32_t) == 4);
 #define WSF_MAX_HANDLERS      9
 #endif
 
+/* maximum number of tasks; the task is carried in the upper nibble of the handler ID */
+#ifndef WSF_MAX_TASKS
+#define WSF_MAX_TASKS         1
+#endif
+
+/* task that runs the stack handlers */
+#define WSF_STACK_TASK_ID     0
+
+WSF_CT_ASSERT(WSF_MAX_HANDLERS <= 16);
+WSF_CT_ASSERT(WSF_MAX_TASKS <= 16);
+
+#if defined(AM_FREERTOS) && (WSF_MAX_TASKS > 1) && !configUSE_RECURSIVE_MUTEXES
+#error "WSF_MAX_TASKS > 1 requires configUSE_RECURSIVE_MUTEXES in FreeRTOSConfig.h"
+#endif
+
 /**************************************************************************************************
   Data Types
 **************************************************************************************************/
@@ -63,12 +84,18 @@ typedef struct
   wsfQueue_t            msgQueue;
   wsfTaskEvent_t        taskEventMask;
   uint8_t               numHandler;
+#ifdef AM_FREERTOS
+  EventGroupHandle_t    eventObject;
+#endif
 } wsfOsTask_t;
 
 /* OS structure */
 typedef struct
 {
-  wsfOsTask_t           task;
+  wsfOsTask_t           task[WSF_MAX_TASKS];
+#if defined(AM_FREERTOS) && (WSF_MAX_TASKS > 1)
+  SemaphoreHandle_t     stackLock;
+#endif
 } wsfOs_t;
 
 /**************************************************************************************************
@@ -79,12 +106,6 @@ uint8_t csNesting = 0;
 
 wsfOs_t wsfOs;
 
-#ifdef AM_FREERTOS
-#include "FreeRTOS.h"
-#include "event_groups.h"
-EventGroupHandle_t xRadioTaskEventObject = NULL;
-#endif
-
 /*************************************************************************************************/
 /*!
  *  \fn     WsfCsEnter
@@ -169,10 +190,21 @@ void WsfTaskUnlock(void)
   WsfCsExit();
 }
 
-void WsfSetOsSpecificEvent(void)
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsSignalTask
+ *
+ *  \brief  Wake the RTOS task that runs the given WSF task.
+ *
+ *  \param  pTask   WSF task.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfOsSignalTask(wsfOsTask_t *pTask)
 {
 #ifdef AM_FREERTOS
-  if(xRadioTaskEventObject != NULL) 
+  if(pTask->eventObject != NULL) 
   {
 
       BaseType_t xHigherPriorityTaskWoken, xResult;
@@ -180,16 +212,16 @@ void WsfSetOsSpecificEvent(void)
       if(xPortIsInsideInterrupt() == pdTRUE) {
 
           //
-          // Send an event to the main radio task
+          // Send an event to the task
           //
           xHigherPriorityTaskWoken = pdFALSE;
 
-          xResult = xEventGroupSetBitsFromISR(xRadioTaskEventObject, 1,
+          xResult = xEventGroupSetBitsFromISR(pTask->eventObject, 1,
                                               &xHigherPriorityTaskWoken);
 
           //
-          // If the radio task is higher-priority than the context we're currently
-          // running from, we should yield now and run the radio task.
+          // If the task is higher-priority than the context we're currently
+          // running from, we should yield now and run the task.
           //
           if ( xResult != pdFAIL )
           {
@@ -199,10 +231,10 @@ void WsfSetOsSpecificEvent(void)
       }
       else {
 
-          xResult = xEventGroupSetBits(xRadioTaskEventObject, 1);
+          xResult = xEventGroupSetBits(pTask->eventObject, 1);
           //
-          // If the radio task is higher priority than the context we're currently
-          // running from, we should yield now and run the radio task.
+          // If the task is higher priority than the context we're currently
+          // running from, we should yield now and run the task.
           //
           if ( xResult != pdFAIL )
           {
@@ -214,6 +246,24 @@ void WsfSetOsSpecificEvent(void)
 #endif
 }
 
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsTaskFromId
+ *
+ *  \brief  Get the task for a handler ID.
+ *
+ *  \param  handlerId   Handler ID.
+ *
+ *  \return WSF task.
+ */
+/*************************************************************************************************/
+static wsfOsTask_t *wsfOsTaskFromId(wsfHandlerId_t handlerId)
+{
+  WSF_ASSERT(WSF_TASK_FROM_ID(handlerId) < WSF_MAX_TASKS);
+
+  return &wsfOs.task[WSF_TASK_FROM_ID(handlerId)];
+}
+
 /*************************************************************************************************/
 /*!
  *  \fn     WsfSetEvent
@@ -228,6 +278,8 @@ void WsfSetOsSpecificEvent(void)
 /*************************************************************************************************/
 void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event)
 {
+  wsfOsTask_t *pTask = wsfOsTaskFromId(handlerId);
+
   WSF_CS_INIT(cs);
 
   WSF_ASSERT(WSF_HANDLER_FROM_ID(handlerId) < WSF_MAX_HANDLERS);
@@ -235,13 +287,13 @@ void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event)
   WSF_TRACE_INFO2("WsfSetEvent handlerId:%u event:%u", handlerId, event);
 
   WSF_CS_ENTER(cs);
-  wsfOs.task.handlerEventMask[WSF_HANDLER_FROM_ID(handlerId)] |= event;
-  wsfOs.task.taskEventMask |= WSF_HANDLER_EVENT;
+  pTask->handlerEventMask[WSF_HANDLER_FROM_ID(handlerId)] |= event;
+  pTask->taskEventMask |= WSF_HANDLER_EVENT;
   WSF_CS_EXIT(cs);
 
   /* set event in OS */
 
-  WsfSetOsSpecificEvent();
+  wsfOsSignalTask(pTask);
 }
 
 /*************************************************************************************************/
@@ -258,15 +310,17 @@ void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event)
 /*************************************************************************************************/
 void WsfTaskSetReady(wsfHandlerId_t handlerId, wsfTaskEvent_t event)
 {
+  wsfOsTask_t *pTask = wsfOsTaskFromId(handlerId);
+
   WSF_CS_INIT(cs);
 
   WSF_CS_ENTER(cs);
-  wsfOs.task.taskEventMask |= event;
+  pTask->taskEventMask |= event;
   WSF_CS_EXIT(cs);
 
   /* set event in OS */
 
-  WsfSetOsSpecificEvent();
+  wsfOsSignalTask(pTask);
 }
 
 /*************************************************************************************************/
@@ -282,7 +336,7 @@ void WsfTaskSetReady(wsfHandlerId_t handlerId, wsfTaskEvent_t event)
 /*************************************************************************************************/
 wsfQueue_t *WsfTaskMsgQueue(wsfHandlerId_t handlerId)
 {
-  return &(wsfOs.task.msgQueue);
+  return &(wsfOsTaskFromId(handlerId)->msgQueue);
 }
 
 /*************************************************************************************************/
@@ -299,13 +353,37 @@ wsfQueue_t *WsfTaskMsgQueue(wsfHandlerId_t handlerId)
 /*************************************************************************************************/
 wsfHandlerId_t WsfOsSetNextHandler(wsfEventHandler_t handler)
 {
-  wsfHandlerId_t handlerId = wsfOs.task.numHandler++;
+  return WsfOsSetNextTaskHandler(WSF_STACK_TASK_ID, handler);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     WsfOsSetNextTaskHandler
+ *
+ *  \brief  Add a WSF handler function to the given task.  This function should only be called
+ *          as part of the stack initialization procedure.
+ *
+ *  \param  taskId     WSF task ID.
+ *  \param  handler    WSF handler function.
+ *
+ *  \return WSF handler ID for this handler.
+ */
+/*************************************************************************************************/
+wsfHandlerId_t WsfOsSetNextTaskHandler(wsfTaskId_t taskId, wsfEventHandler_t handler)
+{
+  wsfOsTask_t *pTask;
+  uint8_t     handlerIdx;
+
+  WSF_ASSERT(taskId < WSF_MAX_TASKS);
 
-  WSF_ASSERT(handlerId < WSF_MAX_HANDLERS);
+  pTask = &wsfOs.task[taskId];
+  handlerIdx = pTask->numHandler++;
 
-  wsfOs.task.handler[handlerId] = handler;
+  WSF_ASSERT(handlerIdx < WSF_MAX_HANDLERS);
 
-  return handlerId;
+  pTask->handler[handlerIdx] = handler;
+
+  return (wsfHandlerId_t) ((taskId << 4) | handlerIdx);
 }
 
 /*************************************************************************************************/
@@ -322,21 +400,50 @@ wsfHandlerId_t WsfOsSetNextHandler(wsfEventHandler_t handler)
 /*************************************************************************************************/
 bool_t wsfOsReadyToSleep(void)
 {
-  return (wsfOs.task.taskEventMask == 0);
+  uint8_t i;
+
+  for (i = 0; i < WSF_MAX_TASKS; i++)
+  {
+    if (wsfOs.task[i].taskEventMask != 0)
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
 }
 
 /*************************************************************************************************/
 /*!
- *  \fn     wsfOsDispatcher
+ *  \fn     wsfOsTaskReadyToSleep
  *
- *  \brief  Event dispatched.  Designed to be called repeatedly from infinite loop.
+ *  \brief  Check if a WSF task has nothing left to do.
  *
- *  \param  None.
+ *  \param  taskId      WSF task ID.
+ *
+ *  \return Return TRUE if there are no pending events for the task, FALSE otherwise.
+ */
+/*************************************************************************************************/
+bool_t wsfOsTaskReadyToSleep(wsfTaskId_t taskId)
+{
+  WSF_ASSERT(taskId < WSF_MAX_TASKS);
+
+  return (wsfOs.task[taskId].taskEventMask == 0);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsTaskDispatcher
+ *
+ *  \brief  Event dispatcher for one WSF task.  Designed to be called repeatedly from the
+ *          infinite loop of the RTOS task that runs the WSF task.
+ *
+ *  \param  taskId      WSF task ID.
  *
  *  \return None.
  */
 /*************************************************************************************************/
-void wsfOsDispatcher(void)
+void wsfOsTaskDispatcher(wsfTaskId_t taskId)
 {
   wsfOsTask_t       *pTask;
   void              *pMsg;
@@ -348,7 +455,15 @@ void wsfOsDispatcher(void)
 
   WSF_CS_INIT(cs);
 
-  pTask = &wsfOs.task;
+  WSF_ASSERT(taskId < WSF_MAX_TASKS);
+
+  pTask = &wsfOs.task[taskId];
+
+  /* the stack task holds the stack lock while its handlers run */
+  if (taskId == WSF_STACK_TASK_ID)
+  {
+    WsfOsLockStack();
+  }
 
   while (pTask->taskEventMask)
   {
@@ -363,8 +478,8 @@ void wsfOsDispatcher(void)
       /* handle msg queue */
       while ((pMsg = WsfMsgDeq(&pTask->msgQueue, &handlerId)) != NULL)
       {
-        WSF_ASSERT(handlerId < WSF_MAX_HANDLERS);
-        (*pTask->handler[handlerId])(0, pMsg);
+        WSF_ASSERT(WSF_HANDLER_FROM_ID(handlerId) < WSF_MAX_HANDLERS);
+        (*pTask->handler[WSF_HANDLER_FROM_ID(handlerId)])(0, pMsg);
         WsfMsgFree(pMsg);
       }
     }
@@ -372,10 +487,10 @@ void wsfOsDispatcher(void)
     if (taskEventMask & WSF_TIMER_EVENT)
     {
       /* service timers */
-      while ((pTimer = WsfTimerServiceExpired(0)) != NULL)
+      while ((pTimer = WsfTimerServiceExpired(taskId)) != NULL)
       {
-        WSF_ASSERT(pTimer->handlerId < WSF_MAX_HANDLERS);
-        (*pTask->handler[pTimer->handlerId])(0, &pTimer->msg);
+        WSF_ASSERT(WSF_HANDLER_FROM_ID(pTimer->handlerId) < WSF_MAX_HANDLERS);
+        (*pTask->handler[WSF_HANDLER_FROM_ID(pTimer->handlerId)])(0, &pTimer->msg);
       }
     }
 
@@ -396,12 +511,105 @@ void wsfOsDispatcher(void)
       }
     }
   }
+
+  if (taskId == WSF_STACK_TASK_ID)
+  {
+    WsfOsUnlockStack();
+  }
 }
 
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsDispatcher
+ *
+ *  \brief  Event dispatched.  Designed to be called repeatedly from infinite loop.
+ *
+ *          Services every WSF task, for applications that run WSF from a single RTOS task.
+ *
+ *  \param  None.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void wsfOsDispatcher(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < WSF_MAX_TASKS; i++)
+  {
+    wsfOsTaskDispatcher(i);
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     WsfOsLockStack
+ *
+ *  \brief  Take the stack lock.  Code running outside the stack task must hold this lock
+ *          while it calls stack API functions.  The lock is recursive.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void WsfOsLockStack(void)
+{
+#if defined(AM_FREERTOS) && (WSF_MAX_TASKS > 1)
+  if (wsfOs.stackLock != NULL)
+  {
+    xSemaphoreTakeRecursive(wsfOs.stackLock, portMAX_DELAY);
+  }
+#endif
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     WsfOsUnlockStack
+ *
+ *  \brief  Release the stack lock.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void WsfOsUnlockStack(void)
+{
+#if defined(AM_FREERTOS) && (WSF_MAX_TASKS > 1)
+  if (wsfOs.stackLock != NULL)
+  {
+    xSemaphoreGiveRecursive(wsfOs.stackLock);
+  }
+#endif
+}
 
 void wsfOsSetEventObject(void *event_object)
 {
+  wsfOsSetTaskEventObject(WSF_STACK_TASK_ID, event_object);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsSetTaskEventObject
+ *
+ *  \brief  Pass the RTOS event object of the RTOS task that runs a WSF task.
+ *
+ *  \param  taskId          WSF task ID.
+ *  \param  event_object    The pointer to an event object for RTOS.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void wsfOsSetTaskEventObject(wsfTaskId_t taskId, void *event_object)
+{
+  WSF_ASSERT(taskId < WSF_MAX_TASKS);
+
   #ifdef AM_FREERTOS
-  xRadioTaskEventObject = (EventGroupHandle_t)event_object;
+  wsfOs.task[taskId].eventObject = (EventGroupHandle_t)event_object;
+
+#if WSF_MAX_TASKS > 1
+  if (wsfOs.stackLock == NULL)
+  {
+    wsfOs.stackLock = xSemaphoreCreateRecursiveMutex();
+    WSF_ASSERT(wsfOs.stackLock != NULL);
+  }
+#endif
   #endif
 }
@@ -87,6 +87,33 @@ bool_t wsfOsReadyToSleep(void);
 /*************************************************************************************************/
 void wsfOsDispatcher(void);
 
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsTaskReadyToSleep
+ *        
+ *  \brief  Check if a WSF task has nothing left to do.
+ *
+ *  \param  taskId      WSF task ID.
+ *
+ *  \return Return TRUE if there are no pending events for the task, FALSE otherwise.
+ */
+/*************************************************************************************************/
+bool_t wsfOsTaskReadyToSleep(wsfTaskId_t taskId);
+
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsTaskDispatcher
+ *        
+ *  \brief  Event dispatcher for one WSF task.  Designed to be called repeatedly from the
+ *          infinite loop of the RTOS task that runs the WSF task.
+ *
+ *  \param  taskId      WSF task ID.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void wsfOsTaskDispatcher(wsfTaskId_t taskId);
+
 /*************************************************************************************************/
 /*!
  *  \fn     WsfOsShutdown
@@ -308,22 +308,28 @@ wsfTimer_t *WsfTimerServiceExpired(wsfTaskId_t taskId)
   /* task schedule lock */
   WsfTaskLock();
 
-  /* find expired timers in queue */
-  if (((pElem = (wsfTimer_t *) wsfTimerTimerQueue.pHead) != NULL) &&
-      (pElem->ticks == 0))
+  /* find expired timers belonging to this task; expired timers are at the front of the queue */
+  pElem = (wsfTimer_t *) wsfTimerTimerQueue.pHead;
+  while ((pElem != NULL) && (pElem->ticks == 0))
   {
-    /* remove timer from queue */
-    WsfQueueRemove(&wsfTimerTimerQueue, pElem, pPrev);
+    if (WSF_TASK_FROM_ID(pElem->handlerId) == taskId)
+    {
+      /* remove timer from queue */
+      WsfQueueRemove(&wsfTimerTimerQueue, pElem, pPrev);
+
+      pElem->isStarted = FALSE;
 
-    pElem->isStarted = FALSE;
+      /* task schedule unlock */
+      WsfTaskUnlock();
 
-    /* task schedule unlock */
-    WsfTaskUnlock();
+      WSF_TRACE_INFO1("Timer expired pTimer:0x%x", pElem);
 
-    WSF_TRACE_INFO1("Timer expired pTimer:0x%x", pElem);
+      /* return timer */
+      return pElem;
+    }
 
-    /* return timer */
-    return pElem;
+    pPrev = pElem;
+    pElem = pElem->pNext;
   }
 
   /* task schedule unlock */
@@ -183,6 +183,75 @@ wsfHandlerId_t WsfOsSetNextHandler(wsfEventHandler_t handler);
 /*************************************************************************************************/
 void wsfOsSetEventObject(void *event_object);
 
+/*************************************************************************************************/
+/*!
+ *  \fn     WsfOsSetNextTaskHandler
+ *        
+ *  \brief  Add a WSF handler function to the given task.  This function should only be called
+ *          as part of the OS initialization procedure.
+ *
+ *          Task 0 runs the stack handlers.  Applications built with WSF_MAX_TASKS greater than
+ *          one can place their own handlers in other tasks, each run by its own RTOS task with
+ *          wsfOsTaskDispatcher().  Messages, timers and events are routed to the task that owns
+ *          the handler and wake only that RTOS task.  The HCI handler and the HCI driver must
+ *          stay in task 0; see WsfOsLockStack().
+ *
+ *  \param  taskId     WSF task ID.
+ *  \param  handler    WSF handler function.
+ *
+ *  \return WSF handler ID for this handler.
+ */
+/*************************************************************************************************/
+wsfHandlerId_t WsfOsSetNextTaskHandler(wsfTaskId_t taskId, wsfEventHandler_t handler);
+
+/*************************************************************************************************/
+/*!
+ *  \fn     wsfOsSetTaskEventObject
+ *        
+ *  \brief  Pass the RTOS event object of the RTOS task that runs a WSF task.  This function
+ *          should only be called as part of the OS (RTOS) initialization procedure.
+ *
+ *  \param  taskId          WSF task ID.
+ *  \param  event_object    The pointer to an event object for RTOS.
+ *
+ *  \return None
+ */
+/*************************************************************************************************/
+void wsfOsSetTaskEventObject(wsfTaskId_t taskId, void *event_object);
+
+/*************************************************************************************************/
+/*!
+ *  \fn     WsfOsLockStack
+ *        
+ *  \brief  Take the stack lock.
+ *
+ *          WSF message, queue, buffer, timer and event services may be used from any task or
+ *          interrupt.  The stack itself is not reentrant: its handlers run in task 0, which
+ *          holds this lock while dispatching.  Handlers in other tasks must hold the lock
+ *          while calling stack API functions (for example AttsHandleValueNtf()), and should
+ *          release it before long operations such as flash writes.  The lock is recursive.
+ *          It does nothing when WSF_MAX_TASKS is one or no RTOS is used.
+ *
+ *          The HCI receive path relies on running in task 0 rather than on this lock:
+ *          hciCoreAclRxDest() reads hciCb.rxQueue and connection state without taking it, so
+ *          the HCI handler and driver must not be moved to another task.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void WsfOsLockStack(void);
+
+/*************************************************************************************************/
+/*!
+ *  \fn     WsfOsUnlockStack
+ *        
+ *  \brief  Release the stack lock.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void WsfOsUnlockStack(void);
+
 
 #ifdef __cplusplus
 };
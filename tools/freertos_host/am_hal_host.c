@@ -0,0 +1,439 @@
+//*****************************************************************************
+//
+//! @file am_hal_host.c
+//!
+//! @brief Host implementation of the stub HAL, BSP and utilities.
+//!
+//!
+//! GPIO interrupts are latched here and delivered through the simulated
+//! interrupt lines of the Posix FreeRTOS port, using the Apollo3 interrupt
+//! numbers.  Sleep waits for the next simulated interrupt.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include "am_mcu_apollo.h"
+#include "am_bsp.h"
+#include "am_util.h"
+#include "FreeRTOS.h"
+
+//*****************************************************************************
+//
+// Interrupt service routines of the application.  Unused ones stay NULL.
+//
+//*****************************************************************************
+extern void am_ble_isr(void) __attribute__((weak));
+extern void am_gpio_isr(void) __attribute__((weak));
+extern void am_ctimer_isr(void) __attribute__((weak));
+extern void am_uart_isr(void) __attribute__((weak));
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static volatile uint64_t g_ui64GpioIntEnable;
+static uint64_t g_ui64GpioIntStatus;
+static volatile uint32_t g_pui32GpioLevel[AM_HAL_GPIO_MAX_PADS];
+static am_hal_gpio_handler_t g_pfnGpioHandlers[AM_HAL_GPIO_MAX_PADS];
+
+static volatile bool g_bPrintEnabled = true;
+static am_bsp_host_led_observer_t g_pfnLedObserver;
+static bool g_pbLedState[AM_BSP_NUM_LEDS];
+
+am_devices_led_t am_bsp_psLEDs[AM_BSP_NUM_LEDS] =
+{
+    {10, 0}, {30, 0}, {15, 0}, {14, 0}, {17, 0}
+};
+
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_BUTTON0 = {0};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_BUTTON1 = {0};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_BUTTON2 = {0};
+
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE = {0};
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_INPUT = {0};
+
+//
+// Pads idle low and a press drives them high, so the buttons read as
+// pressed when high.
+//
+am_devices_button_t am_bsp_psButtons[AM_BSP_NUM_BUTTONS] =
+{
+    AM_DEVICES_BUTTON(AM_BSP_GPIO_BUTTON0, AM_DEVICES_BUTTON_NORMAL_LOW),
+    AM_DEVICES_BUTTON(AM_BSP_GPIO_BUTTON1, AM_DEVICES_BUTTON_NORMAL_LOW),
+    AM_DEVICES_BUTTON(AM_BSP_GPIO_BUTTON2, AM_DEVICES_BUTTON_NORMAL_LOW),
+};
+
+UART0_Type am_hal_host_uart[AM_REG_UART_NUM_MODULES];
+
+//*****************************************************************************
+//
+// Core
+//
+//*****************************************************************************
+void
+am_hal_host_irq_enable(IRQn_Type eIRQ)
+{
+    switch ( eIRQ )
+    {
+        case BLE_IRQn:
+            vPortSimInterruptRegister(eIRQ, am_ble_isr);
+            break;
+
+        case GPIO_IRQn:
+            vPortSimInterruptRegister(eIRQ, am_gpio_isr);
+            break;
+
+        case CTIMER_IRQn:
+            vPortSimInterruptRegister(eIRQ, am_ctimer_isr);
+            break;
+
+        case UART0_IRQn:
+            vPortSimInterruptRegister(eIRQ, am_uart_isr);
+            break;
+    }
+}
+
+void
+am_hal_host_irq_disable(IRQn_Type eIRQ)
+{
+    vPortSimInterruptRegister(eIRQ, NULL);
+}
+
+//
+// Interrupt masking belongs to the kernel on the host.
+//
+uint32_t
+am_hal_interrupt_master_enable(void)
+{
+    return 0;
+}
+
+uint32_t
+am_hal_interrupt_master_disable(void)
+{
+    return 0;
+}
+
+void
+am_hal_sysctrl_sleep(bool bSleepDeep)
+{
+    vPortSimSetSleepDeep(bSleepDeep ? pdTRUE : pdFALSE);
+    vPortSimWaitForInterrupt();
+}
+
+//*****************************************************************************
+//
+// GPIO
+//
+//*****************************************************************************
+uint32_t
+am_hal_gpio_pinconfig(uint32_t ui32Pin, am_hal_gpio_pincfg_t bfGpioCfg)
+{
+    (void) ui32Pin;
+    (void) bfGpioCfg;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_state_read(uint32_t ui32Pin, am_hal_gpio_read_type_e eReadType,
+                       uint32_t *pu32RetVal)
+{
+    (void) eReadType;
+
+    *pu32RetVal = (ui32Pin < AM_HAL_GPIO_MAX_PADS) ? g_pui32GpioLevel[ui32Pin] : 0;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_interrupt_enable(uint64_t ui64InterruptMask)
+{
+    __atomic_fetch_or(&g_ui64GpioIntEnable, ui64InterruptMask, __ATOMIC_ACQ_REL);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_interrupt_disable(uint64_t ui64InterruptMask)
+{
+    __atomic_fetch_and(&g_ui64GpioIntEnable, ~ui64InterruptMask, __ATOMIC_ACQ_REL);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_interrupt_clear(uint64_t ui64InterruptMask)
+{
+    __atomic_fetch_and(&g_ui64GpioIntStatus, ~ui64InterruptMask, __ATOMIC_ACQ_REL);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_interrupt_status_get(bool bEnabledOnly, uint64_t *pui64IntStatus)
+{
+    *pui64IntStatus = __atomic_load_n(&g_ui64GpioIntStatus, __ATOMIC_ACQUIRE);
+
+    if ( bEnabledOnly )
+    {
+        *pui64IntStatus &= g_ui64GpioIntEnable;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_interrupt_register(uint32_t ui32GPIONumber,
+                               am_hal_gpio_handler_t pfnHandler)
+{
+    if ( ui32GPIONumber >= AM_HAL_GPIO_MAX_PADS )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    g_pfnGpioHandlers[ui32GPIONumber] = pfnHandler;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_gpio_interrupt_service(uint64_t ui64Status)
+{
+    for ( uint32_t ui32Pin = 0; ui32Pin < AM_HAL_GPIO_MAX_PADS; ui32Pin++ )
+    {
+        if ( (ui64Status & AM_HAL_GPIO_BIT(ui32Pin)) && g_pfnGpioHandlers[ui32Pin] )
+        {
+            g_pfnGpioHandlers[ui32Pin]();
+        }
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Drive a pad from the simulation.  A rising edge on a pad with its
+// interrupt enabled latches the interrupt and raises GPIO_IRQn.
+//
+//*****************************************************************************
+void
+am_hal_host_gpio_set(uint32_t ui32Pin, uint32_t ui32Level)
+{
+    uint32_t ui32Old;
+
+    if ( ui32Pin >= AM_HAL_GPIO_MAX_PADS )
+    {
+        return;
+    }
+
+    ui32Old = g_pui32GpioLevel[ui32Pin];
+    g_pui32GpioLevel[ui32Pin] = ui32Level;
+
+    if ( !ui32Old && ui32Level && (g_ui64GpioIntEnable & AM_HAL_GPIO_BIT(ui32Pin)) )
+    {
+        __atomic_fetch_or(&g_ui64GpioIntStatus, AM_HAL_GPIO_BIT(ui32Pin), __ATOMIC_ACQ_REL);
+        vPortSimInterruptTrigger(GPIO_IRQn);
+    }
+}
+
+uint32_t
+am_hal_host_gpio_get(uint32_t ui32Pin)
+{
+    return (ui32Pin < AM_HAL_GPIO_MAX_PADS) ? g_pui32GpioLevel[ui32Pin] : 0;
+}
+
+//*****************************************************************************
+//
+// CTIMER.  No timers are simulated.
+//
+//*****************************************************************************
+void
+am_hal_ctimer_int_clear(uint32_t ui32Interrupt)
+{
+    (void) ui32Interrupt;
+}
+
+uint32_t
+am_hal_ctimer_int_status_get(bool bEnabledOnly)
+{
+    (void) bEnabledOnly;
+
+    return 0;
+}
+
+void
+am_hal_ctimer_int_service(uint32_t ui32Status)
+{
+    (void) ui32Status;
+}
+
+//*****************************************************************************
+//
+// BSP
+//
+//*****************************************************************************
+void
+am_bsp_low_power_init(void)
+{
+}
+
+void
+am_bsp_itm_printf_enable(void)
+{
+    g_bPrintEnabled = true;
+}
+
+void
+am_bsp_itm_printf_disable(void)
+{
+    g_bPrintEnabled = false;
+}
+
+void
+am_bsp_host_led_observer_set(am_bsp_host_led_observer_t pfnObserver)
+{
+    g_pfnLedObserver = pfnObserver;
+}
+
+static void
+led_set(uint32_t ui32LEDNum, bool bOn)
+{
+    if ( ui32LEDNum >= AM_BSP_NUM_LEDS )
+    {
+        return;
+    }
+
+    g_pbLedState[ui32LEDNum] = bOn;
+
+    if ( g_pfnLedObserver )
+    {
+        g_pfnLedObserver(ui32LEDNum, bOn);
+    }
+}
+
+void
+am_devices_led_array_init(am_devices_led_t *psLEDs, uint32_t ui32NumLEDs)
+{
+    (void) psLEDs;
+
+    for ( uint32_t i = 0; (i < ui32NumLEDs) && (i < AM_BSP_NUM_LEDS); i++ )
+    {
+        g_pbLedState[i] = false;
+    }
+}
+
+void
+am_devices_led_on(am_devices_led_t *psLEDs, uint32_t ui32LEDNum)
+{
+    (void) psLEDs;
+
+    led_set(ui32LEDNum, true);
+}
+
+void
+am_devices_led_off(am_devices_led_t *psLEDs, uint32_t ui32LEDNum)
+{
+    (void) psLEDs;
+
+    led_set(ui32LEDNum, false);
+}
+
+void
+am_devices_led_toggle(am_devices_led_t *psLEDs, uint32_t ui32LEDNum)
+{
+    (void) psLEDs;
+
+    if ( ui32LEDNum < AM_BSP_NUM_LEDS )
+    {
+        led_set(ui32LEDNum, !g_pbLedState[ui32LEDNum]);
+    }
+}
+
+//*****************************************************************************
+//
+// Utilities
+//
+//*****************************************************************************
+void
+am_util_delay_ms(uint32_t ui32MilliSeconds)
+{
+    struct timespec sDelay;
+
+    sDelay.tv_sec = ui32MilliSeconds / 1000;
+    sDelay.tv_nsec = (long) (ui32MilliSeconds % 1000) * 1000000L;
+
+    while ( (nanosleep(&sDelay, &sDelay) != 0) && (errno == EINTR) )
+    {
+    }
+}
+
+//
+// Output is written with interrupts masked, so a task switch cannot land
+// while stdio is locked.
+//
+uint32_t
+am_util_stdio_printf(const char *pcFmt, ...)
+{
+    UBaseType_t uxMask;
+    va_list pArgs;
+    int iLen;
+
+    if ( !g_bPrintEnabled )
+    {
+        return 0;
+    }
+
+    uxMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    va_start(pArgs, pcFmt);
+    iLen = vprintf(pcFmt, pArgs);
+    va_end(pArgs);
+    fflush(stdout);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(uxMask);
+
+    return (iLen > 0) ? (uint32_t) iLen : 0;
+}
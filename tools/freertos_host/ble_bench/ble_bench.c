@@ -0,0 +1,369 @@
+//*****************************************************************************
+//
+//! @file ble_bench.c
+//!
+//! @brief Host benchmark of the RTOS parts of the ble_freertos examples.
+//!
+//!
+//! Builds an example's rtos.c and radio_task.c, unchanged, against the stub
+//! stack in ble_stack_stub.c and runs them on the Posix FreeRTOS port.  The
+//! controller is modelled here: it holds a connection, raises BLE_IRQn once
+//! per connection interval, and reports the notifications the profile sent
+//! since the last interval as complete.
+//!
+//! Measures the time from each controller interrupt to the HCI handler, with
+//! the context switches, ticks and tickless idle residency of the run.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "am_util.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "wsf_types.h"
+#include "rtos.h"
+#include "ble_bench.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define BENCH_SETTLE_MS             100
+#define BENCH_RX_RING_SIZE          16
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static uint32_t g_ui32RunMs = 2000;
+static uint32_t g_ui32IntervalUs = 7500;
+static uint32_t g_ui32NotifyMs = 100;
+static uint32_t g_ui32Failures;
+
+//
+// Packets from the controller.  The controller thread writes the head and
+// the radio task reads the tail.
+//
+static ble_bench_packet_t g_psRxRing[BENCH_RX_RING_SIZE];
+static uint32_t g_ui32RxHead;
+static uint32_t g_ui32RxTail;
+
+static volatile bool g_bConnected;
+static uint32_t g_ui32TxPending;
+
+static uint32_t g_ui32ConnEvents;
+static uint32_t g_ui32RxDropped;
+static uint32_t g_ui32RxHandled;
+static uint32_t g_ui32TxSent;
+static uint32_t g_ui32TxCompleted;
+static uint32_t g_ui32AllocFailures;
+static uint64_t g_ui64LatencyNs;
+static uint64_t g_ui64MaxLatencyNs;
+
+//*****************************************************************************
+//
+// Support for the WSF sources.
+//
+//*****************************************************************************
+void
+WsfAssert(const char *pFile, uint16_t line)
+{
+    printf("WSF assert %s:%u\n", pFile, line);
+    exit(1);
+}
+
+//*****************************************************************************
+//
+// Controller side of the stub stack.
+//
+//*****************************************************************************
+bool
+ble_bench_rx_get(ble_bench_packet_t *psPacket)
+{
+    uint32_t ui32Tail = g_ui32RxTail;
+
+    if ( ui32Tail == __atomic_load_n(&g_ui32RxHead, __ATOMIC_ACQUIRE) )
+    {
+        return false;
+    }
+
+    *psPacket = g_psRxRing[ui32Tail % BENCH_RX_RING_SIZE];
+    __atomic_store_n(&g_ui32RxTail, ui32Tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+void
+ble_bench_rx_handled(const ble_bench_packet_t *psPacket)
+{
+    uint64_t ui64LatencyNs = ullPortSimTimeNs() - psPacket->ui64TriggerNs;
+
+    g_ui32RxHandled++;
+    g_ui32TxCompleted += psPacket->ui32Completed;
+    g_ui64LatencyNs += ui64LatencyNs;
+    if ( ui64LatencyNs > g_ui64MaxLatencyNs )
+    {
+        g_ui64MaxLatencyNs = ui64LatencyNs;
+    }
+}
+
+//
+// Notifications are only counted while the controller holds the connection.
+//
+void
+ble_bench_tx(void)
+{
+    if ( g_bConnected )
+    {
+        g_ui32TxSent++;
+        __atomic_fetch_add(&g_ui32TxPending, 1, __ATOMIC_ACQ_REL);
+    }
+}
+
+uint32_t
+ble_bench_notify_ms(void)
+{
+    return g_ui32NotifyMs;
+}
+
+void
+ble_bench_alloc_failed(void)
+{
+    g_ui32AllocFailures++;
+}
+
+//*****************************************************************************
+//
+// Controller.
+//
+//*****************************************************************************
+static void
+sleep_us(uint32_t ui32Us)
+{
+    struct timespec sDelay;
+
+    sDelay.tv_sec = ui32Us / 1000000;
+    sDelay.tv_nsec = (long) (ui32Us % 1000000) * 1000L;
+    nanosleep(&sDelay, NULL);
+}
+
+//
+// Queue one packet for the host, reporting the notifications sent since the
+// last one, and raise the interrupt.
+//
+static void
+connection_event(void)
+{
+    uint32_t ui32Head = g_ui32RxHead;
+    ble_bench_packet_t *psPacket;
+
+    g_ui32ConnEvents++;
+
+    if ( (ui32Head - __atomic_load_n(&g_ui32RxTail, __ATOMIC_ACQUIRE)) >= BENCH_RX_RING_SIZE )
+    {
+        g_ui32RxDropped++;
+        return;
+    }
+
+    psPacket = &g_psRxRing[ui32Head % BENCH_RX_RING_SIZE];
+    psPacket->ui32Completed = __atomic_exchange_n(&g_ui32TxPending, 0, __ATOMIC_ACQ_REL);
+    psPacket->ui64TriggerNs = ullPortSimTimeNs();
+    __atomic_store_n(&g_ui32RxHead, ui32Head + 1, __ATOMIC_RELEASE);
+
+    vPortSimInterruptTrigger(BLE_IRQn);
+}
+
+static void *
+controller_thread(void *pvArg)
+{
+    uint64_t ui64EndNs, ui64NextNs, ui64NowNs;
+
+    (void) pvArg;
+
+    sleep_us(BENCH_SETTLE_MS * 1000);
+
+    g_bConnected = true;
+
+    ui64NowNs = ullPortSimTimeNs();
+    ui64EndNs = ui64NowNs + (uint64_t) g_ui32RunMs * 1000000ULL;
+    ui64NextNs = ui64NowNs;
+
+    while ( (ui64NowNs = ullPortSimTimeNs()) < ui64EndNs )
+    {
+        if ( ui64NowNs >= ui64NextNs )
+        {
+            connection_event();
+            ui64NextNs += (uint64_t) g_ui32IntervalUs * 1000ULL;
+        }
+        else
+        {
+            sleep_us((uint32_t) ((ui64NextNs - ui64NowNs) / 1000));
+        }
+    }
+
+    //
+    // Drop the connection, then report the last notifications once any that
+    // were under way have been counted.
+    //
+    g_bConnected = false;
+    sleep_us(BENCH_SETTLE_MS * 1000);
+    connection_event();
+
+    sleep_us(BENCH_SETTLE_MS * 1000);
+    vPortEndScheduler();
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Main.  Stands in for the example's main(), which only sets up the core
+// before calling run_tasks().
+//
+//*****************************************************************************
+#define BENCH_CHECK(cond)                                                   \
+    do                                                                      \
+    {                                                                       \
+        if ( !(cond) )                                                      \
+        {                                                                   \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+            g_ui32Failures++;                                               \
+        }                                                                   \
+    } while (0)
+
+int
+main(int argc, char **argv)
+{
+    PortSimStats_t sStats;
+    pthread_t xController;
+    uint32_t ui32Expected;
+    int iOpt;
+
+    while ( (iOpt = getopt(argc, argv, "t:i:n:")) != -1 )
+    {
+        switch ( iOpt )
+        {
+            case 't':
+                g_ui32RunMs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 'i':
+                g_ui32IntervalUs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 'n':
+                g_ui32NotifyMs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            default:
+                fprintf(stderr, "usage: %s [-t run_ms] [-i interval_us] [-n notify_ms]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if ( (g_ui32IntervalUs == 0) || (g_ui32NotifyMs == 0) )
+    {
+        fprintf(stderr, "%s: the interval and notify period must be non-zero\n", argv[0]);
+        return 2;
+    }
+
+    //
+    // Simulation threads must not take interrupts, so create this one with
+    // them masked.
+    //
+    portDISABLE_INTERRUPTS();
+    pthread_create(&xController, NULL, controller_thread, NULL);
+
+    am_util_debug_printf("BLE example on the Posix port\n");
+    run_tasks();
+    pthread_join(xController, NULL);
+
+    vPortSimGetStats(&sStats);
+
+    printf("connection interval   %8u us, notification every %u ms\n",
+           g_ui32IntervalUs, g_ui32NotifyMs);
+    printf("run time              %8.1f ms\n", sStats.ullRunNs / 1e6);
+    printf("connection events     %8u\n", g_ui32ConnEvents);
+    printf("packets handled       %8u\n", g_ui32RxHandled);
+    printf("stack latency avg/max %8.1f / %.1f us\n",
+           g_ui32RxHandled ? g_ui64LatencyNs / 1e3 / g_ui32RxHandled : 0.0,
+           g_ui64MaxLatencyNs / 1e3);
+    printf("notifications sent    %8u (every %.1f ms)\n", g_ui32TxSent,
+           g_ui32TxSent ? (double) g_ui32RunMs / g_ui32TxSent : 0.0);
+    printf("context switches      %8u\n", sStats.ulContextSwitches);
+    printf("tick interrupts       %8u\n", sStats.ulTickInterrupts);
+    printf("tickless sleeps       %8u\n", sStats.ulSleeps);
+    printf("idle residency        %8.1f %%\n",
+           sStats.ullRunNs ? 100.0 * sStats.ullSleepNs / sStats.ullRunNs : 0.0);
+    printf("interrupts            %8u\n", sStats.ulInterrupts);
+    printf("irq latency avg/max   %8.1f / %.1f us\n",
+           sStats.ulInterrupts ? sStats.ullInterruptLatencyNs / 1e3 / sStats.ulInterrupts : 0.0,
+           sStats.ullMaxInterruptLatencyNs / 1e3);
+
+    //
+    // Every packet reaches the HCI handler, and every notification is
+    // reported back.  The notify timer runs on WSF ticks, so it can run slow
+    // but never fast: update_scheduler_timers() in the examples drops the
+    // part of a WSF tick left over at each update, and with a connection
+    // event every few milliseconds that adds up.
+    //
+    ui32Expected = g_ui32RunMs / g_ui32NotifyMs;
+    BENCH_CHECK(g_ui32RxDropped == 0);
+    BENCH_CHECK(g_ui32AllocFailures == 0);
+    BENCH_CHECK(g_ui32RxHandled == g_ui32ConnEvents);
+    BENCH_CHECK(g_ui32TxSent > 0);
+    BENCH_CHECK(g_ui32TxCompleted == g_ui32TxSent);
+    BENCH_CHECK(g_ui32TxSent <= ui32Expected + 1);
+    BENCH_CHECK(sStats.ulSleeps > 0);
+
+    printf("%s: %u failure(s)\n", g_ui32Failures ? "FAIL" : "PASS", g_ui32Failures);
+
+    return g_ui32Failures ? 1 : 0;
+}
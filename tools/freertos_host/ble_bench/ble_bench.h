@@ -0,0 +1,89 @@
+//*****************************************************************************
+//
+//! @file ble_bench.h
+//!
+//! @brief Interface between the BLE example benchmark and the stub stack.
+//!
+//!
+//! The benchmark models the BLE controller.  ble_stack_stub.c stands in for the
+//! Cordio stack library and the Apollo3 HCI driver, and passes packets between
+//! the controller model and the stack handlers the examples register.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef BLE_BENCH_H
+#define BLE_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// A packet from the controller.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint64_t    ui64TriggerNs;      // When the controller raised the interrupt.
+    uint32_t    ui32Completed;      // Transmit packets it reports as sent.
+}
+ble_bench_packet_t;
+
+//*****************************************************************************
+//
+// Controller side, in ble_bench.c.
+//
+//*****************************************************************************
+extern bool ble_bench_rx_get(ble_bench_packet_t *psPacket);
+extern void ble_bench_rx_handled(const ble_bench_packet_t *psPacket);
+extern void ble_bench_tx(void);
+extern uint32_t ble_bench_notify_ms(void);
+extern void ble_bench_alloc_failed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLE_BENCH_H
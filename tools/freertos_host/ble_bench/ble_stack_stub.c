@@ -0,0 +1,327 @@
+//*****************************************************************************
+//
+//! @file ble_stack_stub.c
+//!
+//! @brief Stub Cordio stack and HCI driver for the BLE example benchmark.
+//!
+//!
+//! Provides what the examples' radio tasks link against from the stack
+//! library and hci_drv_apollo3.c.  The initialization calls do nothing.  The
+//! HCI driver handler moves each controller packet into a WSF message for the
+//! HCI handler, as the real driver hands them to the HCI core.  The profile
+//! sends a notification on a WSF timer, which the controller later reports
+//! complete.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#include <stdbool.h>
+#include <stdint.h>
+#include "am_mcu_apollo.h"
+#include "wsf_types.h"
+#include "wsf_os.h"
+#include "wsf_msg.h"
+#include "wsf_timer.h"
+#include "sec_api.h"
+#include "hci_api.h"
+#include "hci_handler.h"
+#include "dm_api.h"
+#include "dm_handler.h"
+#include "l2c_api.h"
+#include "l2c_handler.h"
+#include "att_api.h"
+#include "att_handler.h"
+#include "smp_api.h"
+#include "smp_handler.h"
+#include "app_api.h"
+#include "app_ui.h"
+#include "hci_drv_apollo.h"
+#include "hci_drv_apollo3.h"
+#include "ble_bench.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define BLE_STUB_RX_EVENT           0x01
+#define BLE_STUB_NOTIFY_EVENT       0x01
+
+//*****************************************************************************
+//
+// Types
+//
+//*****************************************************************************
+typedef struct
+{
+    wsfMsgHdr_t         hdr;
+    ble_bench_packet_t  sPacket;
+}
+ble_stub_msg_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static wsfHandlerId_t g_HciHandlerId;
+static wsfHandlerId_t g_HciDrvHandlerId;
+static wsfTimer_t g_NotifyTimer;
+
+//*****************************************************************************
+//
+// HCI driver.
+//
+//*****************************************************************************
+void
+HciDrvRadioBoot(bool bColdBoot)
+{
+    (void) bColdBoot;
+
+    NVIC_EnableIRQ(BLE_IRQn);
+}
+
+void
+HciDrvUartISR(uint32_t ui32Status)
+{
+    (void) ui32Status;
+}
+
+void
+HciDrvIntService(void)
+{
+    WsfSetEvent(g_HciDrvHandlerId, BLE_STUB_RX_EVENT);
+}
+
+void
+HciDrvHandlerInit(wsfHandlerId_t handlerId)
+{
+    g_HciDrvHandlerId = handlerId;
+}
+
+void
+HciDrvHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
+{
+    ble_stub_msg_t *psMsg;
+
+    (void) pMsg;
+
+    if ( !(event & BLE_STUB_RX_EVENT) )
+    {
+        return;
+    }
+
+    //
+    // Read everything the controller has queued.  A packet is only taken
+    // once there is a message to carry it.
+    //
+    while ( 1 )
+    {
+        psMsg = WsfMsgAlloc(sizeof(ble_stub_msg_t) - sizeof(wsfMsgHdr_t));
+        if ( psMsg == NULL )
+        {
+            ble_bench_alloc_failed();
+            return;
+        }
+
+        if ( !ble_bench_rx_get(&psMsg->sPacket) )
+        {
+            WsfMsgFree(psMsg);
+            return;
+        }
+
+        WsfMsgSend(g_HciHandlerId, psMsg);
+    }
+}
+
+//*****************************************************************************
+//
+// HCI.
+//
+//*****************************************************************************
+void
+HciHandlerInit(wsfHandlerId_t handlerId)
+{
+    g_HciHandlerId = handlerId;
+}
+
+void
+HciHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
+{
+    (void) event;
+
+    if ( pMsg != NULL )
+    {
+        ble_bench_rx_handled(&((ble_stub_msg_t *) pMsg)->sPacket);
+    }
+}
+
+void
+HciSetMaxRxAclLen(uint16_t len)
+{
+    (void) len;
+}
+
+//*****************************************************************************
+//
+// Security.
+//
+//*****************************************************************************
+void SecInit(void) {}
+void SecAesInit(void) {}
+void SecCmacInit(void) {}
+void SecEccInit(void) {}
+
+//*****************************************************************************
+//
+// Device manager.
+//
+//*****************************************************************************
+void DmDevVsInit(uint8_t param) { (void) param; }
+void DmAdvInit(void) {}
+void DmScanInit(void) {}
+void DmConnInit(void) {}
+void DmConnMasterInit(void) {}
+void DmConnSlaveInit(void) {}
+void DmSecInit(void) {}
+void DmSecLescInit(void) {}
+void DmPrivInit(void) {}
+void DmHandlerInit(wsfHandlerId_t handlerId) { (void) handlerId; }
+void DmHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) { (void) event; (void) pMsg; }
+
+//*****************************************************************************
+//
+// L2CAP, ATT and SMP.
+//
+//*****************************************************************************
+void L2cInit(void) {}
+void L2cMasterInit(void) {}
+void L2cSlaveInit(void) {}
+void L2cSlaveHandlerInit(wsfHandlerId_t handlerId) { (void) handlerId; }
+void L2cSlaveHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) { (void) event; (void) pMsg; }
+
+void AttsInit(void) {}
+void AttsIndInit(void) {}
+void AttcInit(void) {}
+void AttHandlerInit(wsfHandlerId_t handlerId) { (void) handlerId; }
+void AttHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) { (void) event; (void) pMsg; }
+
+void SmpiInit(void) {}
+void SmpiScInit(void) {}
+void SmprInit(void) {}
+void SmprScInit(void) {}
+void SmpHandlerInit(wsfHandlerId_t handlerId) { (void) handlerId; }
+void SmpHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) { (void) event; (void) pMsg; }
+
+//*****************************************************************************
+//
+// Application framework.
+//
+//*****************************************************************************
+void AppHandlerInit(wsfHandlerId_t handlerId) { (void) handlerId; }
+void AppHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) { (void) event; (void) pMsg; }
+void AppUiBtnTest(uint8_t btn) { (void) btn; }
+
+//*****************************************************************************
+//
+// Profiles.  Each example starts one; they all send a notification every
+// ble_bench_notify_ms().
+//
+//*****************************************************************************
+static void
+profile_handler_init(wsfHandlerId_t handlerId)
+{
+    g_NotifyTimer.handlerId = handlerId;
+    g_NotifyTimer.msg.event = BLE_STUB_NOTIFY_EVENT;
+}
+
+static void
+profile_handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
+{
+    (void) event;
+
+    if ( (pMsg != NULL) && (pMsg->event == BLE_STUB_NOTIFY_EVENT) )
+    {
+        ble_bench_tx();
+        WsfTimerStartMs(&g_NotifyTimer, ble_bench_notify_ms());
+    }
+}
+
+static void
+profile_start(void)
+{
+    WsfTimerStartMs(&g_NotifyTimer, ble_bench_notify_ms());
+}
+
+#define BLE_STUB_PROFILE(name)                                                \
+    void name##HandlerInit(wsfHandlerId_t handlerId);                         \
+    void name##Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg);              \
+    void name##Start(void);                                                   \
+                                                                              \
+    void name##HandlerInit(wsfHandlerId_t handlerId)                          \
+    {                                                                         \
+        profile_handler_init(handlerId);                                      \
+    }                                                                         \
+                                                                              \
+    void name##Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)               \
+    {                                                                         \
+        profile_handler(event, pMsg);                                         \
+    }                                                                         \
+                                                                              \
+    void name##Start(void)                                                    \
+    {                                                                         \
+        profile_start();                                                      \
+    }
+
+BLE_STUB_PROFILE(Amdtp)
+BLE_STUB_PROFILE(Amdtpc)
+BLE_STUB_PROFILE(Amota)
+BLE_STUB_PROFILE(Ancs)
+BLE_STUB_PROFILE(Fit)
+BLE_STUB_PROFILE(Vole)
+BLE_STUB_PROFILE(Watch)
+
+//
+// Called by the ancs example's test task when button 2 is held.
+//
+bool
+ancsRejectCall(void)
+{
+    return false;
+}
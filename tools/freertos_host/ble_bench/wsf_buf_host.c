@@ -0,0 +1,134 @@
+//*****************************************************************************
+//
+//! @file wsf_buf_host.c
+//!
+//! @brief Host build of the WSF buffer module.
+//!
+//! WsfBufInit() carves the pool memory into units the size of a pointer plus
+//! the free check word, so a 64-bit host needs more memory than the target
+//! for the same pools.  This file builds wsf_buf.c with WsfBufInit() renamed
+//! and supplies one that hands it memory sized for the host, then reports the
+//! length the target would have used so the examples' own pool size checks
+//! still hold.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdlib.h>
+#include "wsf_types.h"
+#include "wsf_buf.h"
+
+#define WsfBufInit              WsfBufInitTarget
+#include "wsf_buf.c"
+#undef WsfBufInit
+
+//*****************************************************************************
+//
+// Target layout: 32-bit pointers.
+//
+//*****************************************************************************
+#define WSF_BUF_TARGET_PTR_SIZE     4
+
+#if WSF_BUF_FREE_CHECK == TRUE
+#define WSF_BUF_TARGET_UNIT         (WSF_BUF_TARGET_PTR_SIZE + sizeof(uint32_t))
+#else
+#define WSF_BUF_TARGET_UNIT         WSF_BUF_TARGET_PTR_SIZE
+#endif
+
+#if WSF_BUF_STATS == TRUE
+#define WSF_BUF_TARGET_POOL_SIZE    (sizeof(wsfBufPoolDesc_t) + 2 * WSF_BUF_TARGET_PTR_SIZE + 4)
+#else
+#define WSF_BUF_TARGET_POOL_SIZE    (sizeof(wsfBufPoolDesc_t) + 2 * WSF_BUF_TARGET_PTR_SIZE)
+#endif
+
+//*****************************************************************************
+//
+// Memory needed by numPools pools with the given unit and pool header sizes.
+//
+//*****************************************************************************
+static uint32_t
+buf_mem_len(uint8_t numPools, const wsfBufPoolDesc_t *pDesc, uint32_t ui32Unit,
+            uint32_t ui32PoolSize)
+{
+    uint32_t ui32Len = numPools * ui32PoolSize;
+
+    for (uint8_t i = 0; i < numPools; i++)
+    {
+        uint32_t ui32BufLen = (pDesc[i].len < ui32Unit) ? ui32Unit :
+            (pDesc[i].len + ui32Unit - 1) / ui32Unit * ui32Unit;
+
+        ui32Len += ui32BufLen * pDesc[i].num;
+    }
+
+    return ui32Len;
+}
+
+//*****************************************************************************
+//
+// Host WsfBufInit().  The pools live in a block sized for the host and the
+// caller's memory is left unused.
+//
+//*****************************************************************************
+uint16_t
+WsfBufInit(uint16_t bufMemLen, uint8_t *pBufMem, uint8_t numPools,
+           wsfBufPoolDesc_t *pDesc)
+{
+    static uint8_t *pui8HostMem;
+    uint32_t ui32HostLen;
+
+    (void) bufMemLen;
+    (void) pBufMem;
+
+    ui32HostLen = buf_mem_len(numPools, pDesc, sizeof(wsfBufMem_t),
+                              sizeof(wsfBufPool_t));
+    WSF_ASSERT(ui32HostLen <= UINT16_MAX);
+
+    free(pui8HostMem);
+    pui8HostMem = malloc(ui32HostLen);
+    WSF_ASSERT(pui8HostMem != NULL);
+
+    if (WsfBufInitTarget(ui32HostLen, pui8HostMem, numPools, pDesc) == 0)
+    {
+        return 0;
+    }
+
+    return buf_mem_len(numPools, pDesc, WSF_BUF_TARGET_UNIT,
+                       WSF_BUF_TARGET_POOL_SIZE);
+}
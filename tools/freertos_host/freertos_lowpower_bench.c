@@ -0,0 +1,407 @@
+//*****************************************************************************
+//
+//! @file freertos_lowpower_bench.c
+//!
+//! @brief Host benchmark of the freertos_lowpower example.
+//!
+//!
+//! Runs the example's tasks on the Posix FreeRTOS port and presses the
+//! buttons from a simulation thread.  Reports context switches, idle
+//! residency in tickless sleep, interrupt latency, and the latency from a
+//! button edge to the LED task acting on it.
+//!
+//! Usage: freertos_lowpower_bench [-t run_ms] [-p press_interval_ms]
+//!
+//! The exit status is non-zero if any button press was not acted on.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "freertos_lowpower.h"
+#include "rtos.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define BENCH_NUM_BUTTONS           3
+#define BENCH_SETTLE_MS             100
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static const uint32_t g_pui32ButtonPins[BENCH_NUM_BUTTONS] =
+{
+    AM_BSP_GPIO_BUTTON0, AM_BSP_GPIO_BUTTON1, AM_BSP_GPIO_BUTTON2
+};
+
+static uint32_t g_ui32RunMs = 2000;
+static uint32_t g_ui32PressMs = 50;
+static uint32_t g_ui32PeriodMs = 20;
+
+static volatile uint64_t g_pui64PressNs[BENCH_NUM_BUTTONS];
+static volatile uint32_t g_ui32Presses;
+static volatile uint32_t g_ui32Handled;
+static volatile uint64_t g_ui64LatencyNs;
+static volatile uint64_t g_ui64MaxLatencyNs;
+
+//*****************************************************************************
+//
+// Provided by freertos_lowpower.c on the target, which also holds main().
+//
+//*****************************************************************************
+void
+disable_print_interface(void)
+{
+    am_bsp_itm_printf_disable();
+}
+
+//*****************************************************************************
+//
+// The LED task toggles the LED of each button it sees pressed.
+//
+//*****************************************************************************
+static void
+led_observer(uint32_t ui32LEDNum, bool bOn)
+{
+    uint64_t ui64LatencyNs;
+
+    (void) bOn;
+
+    if ( (ui32LEDNum >= BENCH_NUM_BUTTONS) || (g_pui64PressNs[ui32LEDNum] == 0) )
+    {
+        return;
+    }
+
+    ui64LatencyNs = ullPortSimTimeNs() - g_pui64PressNs[ui32LEDNum];
+    g_pui64PressNs[ui32LEDNum] = 0;
+
+    g_ui32Handled++;
+    g_ui64LatencyNs += ui64LatencyNs;
+    if ( ui64LatencyNs > g_ui64MaxLatencyNs )
+    {
+        g_ui64MaxLatencyNs = ui64LatencyNs;
+    }
+}
+
+static void
+sleep_ms(uint32_t ui32Ms)
+{
+    struct timespec sDelay;
+
+    sDelay.tv_sec = ui32Ms / 1000;
+    sDelay.tv_nsec = (long) (ui32Ms % 1000) * 1000000L;
+    nanosleep(&sDelay, NULL);
+}
+
+//*****************************************************************************
+//
+// Wakes every g_ui32PeriodMs for the first half of the run, so those sleeps
+// have a timeout to wait for, then blocks for good so the rest only have
+// the buttons to wait for and are clamped to the STIMER's reach.
+//
+//*****************************************************************************
+static void
+periodic_task(void *pvParameters)
+{
+    TickType_t xEnd;
+
+    (void) pvParameters;
+
+    xEnd = xTaskGetTickCount() + pdMS_TO_TICKS(BENCH_SETTLE_MS + g_ui32RunMs / 2);
+    while ( (int32_t) (xEnd - xTaskGetTickCount()) > 0 )
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(g_ui32PeriodMs));
+    }
+
+    //
+    // Nothing notifies this task.  vTaskDelay() and vTaskDelete() are not in
+    // this configuration.
+    //
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+//*****************************************************************************
+//
+// Simulation thread.  Presses the buttons in turn, then ends the run.
+//
+//*****************************************************************************
+static void *
+stimulus_thread(void *pvArg)
+{
+    uint64_t ui64EndNs;
+    uint32_t ui32Button;
+
+    (void) pvArg;
+
+    sleep_ms(BENCH_SETTLE_MS);
+
+    ui64EndNs = ullPortSimTimeNs() + (uint64_t) g_ui32RunMs * 1000000ULL;
+    while ( ullPortSimTimeNs() < ui64EndNs )
+    {
+        ui32Button = g_ui32Presses % BENCH_NUM_BUTTONS;
+
+        g_pui64PressNs[ui32Button] = ullPortSimTimeNs();
+        g_ui32Presses++;
+        am_hal_host_gpio_set(g_pui32ButtonPins[ui32Button], 1);
+
+        sleep_ms(g_ui32PressMs);
+        am_hal_host_gpio_set(g_pui32ButtonPins[ui32Button], 0);
+    }
+
+    sleep_ms(BENCH_SETTLE_MS);
+    vPortEndScheduler();
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Print the port's tickless idle statistics and check them against the
+// simulator's own accounting.  Returns the number of failed checks.
+//
+//*****************************************************************************
+#define BENCH_CHECK(expr)                                                     \
+    do                                                                        \
+    {                                                                         \
+        if ( !(expr) )                                                        \
+        {                                                                     \
+            fprintf(stderr, "tickless check failed: %s\n", #expr);           \
+            ui32Failed++;                                                     \
+        }                                                                     \
+    } while (0)
+
+static uint64_t
+counts_to_ns(uint64_t ui64Counts)
+{
+    return ui64Counts * 1000000000ULL / configSTIMER_CLOCK_HZ;
+}
+
+static uint32_t
+tickless_stats_check(const PortSimStats_t *psSimStats)
+{
+    TicklessStats_t sStats;
+    TicklessSleep_t sSleep;
+    uint64_t ui64Wakes;
+    uint64_t ui64ElapsedNs;
+    uint64_t ui64SleepNs;
+    uint32_t ui32Logged;
+    uint32_t ui32ClampedLogged;
+    uint32_t ui32BadSleeps;
+    uint32_t ui32Failed;
+    uint32_t i;
+
+    ui32Failed = 0;
+    ui32Logged = 0;
+    ui32ClampedLogged = 0;
+    ui32BadSleeps = 0;
+
+    vPortGetTicklessStats(&sStats);
+
+    //
+    // Every logged sleep must have stepped the tick count by less than the
+    // kernel allowed.  The step also covers ticks that were still pending
+    // when the core went to sleep, so it is not bounded by the time asleep.
+    //
+    while ( xPortGetTicklessSleep(&sSleep) )
+    {
+        ui32Logged++;
+        if ( sSleep.ucClamped )
+        {
+            ui32ClampedLogged++;
+        }
+
+        if ( sSleep.xSteppedTicks >= sSleep.xExpectedIdleTime )
+        {
+            ui32BadSleeps++;
+        }
+    }
+
+    ui64Wakes = 0;
+    for ( i = 0; i < portTICKLESS_WAKE_SOURCES; i++ )
+    {
+        ui64Wakes += sStats.ulWakeSources[i];
+    }
+
+    ui64ElapsedNs = counts_to_ns(sStats.ullElapsedCounts);
+    ui64SleepNs = counts_to_ns(sStats.ullSleepCounts);
+
+    printf("\n");
+    printf("tickless stats\n");
+    printf("  elapsed             %8.1f ms\n", ui64ElapsedNs / 1e6);
+    printf("  sleeps / aborted    %8u / %u\n", sStats.ulSleeps, sStats.ulAbortedSleeps);
+    printf("  deep sleeps         %8u\n", sStats.ulDeepSleeps);
+    printf("  early wakes         %8u\n", sStats.ulEarlyWakes);
+    printf("  wakes gpio / none   %8u / %u\n",
+           sStats.ulWakeSources[GPIO_IRQn], sStats.ulWakeSources[portTICKLESS_WAKE_NONE]);
+    printf("  time asleep         %8.1f ms\n", ui64SleepNs / 1e6);
+    printf("  clamped sleeps      %8u\n", sStats.ulClampedSleeps);
+    printf("  ticks expected      %8llu\n", (unsigned long long) sStats.ullExpectedIdleTicks);
+    printf("  ticks stepped       %8llu + %llu clamped\n", (unsigned long long) sStats.ullSteppedTicks,
+           (unsigned long long) sStats.ullClampedSteppedTicks);
+    printf("  drift               %8d counts\n", (int) sStats.lDriftCounts);
+    printf("  logged / dropped    %8u / %u\n", ui32Logged, sStats.ulLogDropped);
+
+    BENCH_CHECK(sStats.ulSleeps == psSimStats->ulSleeps);
+    BENCH_CHECK(sStats.ulSleeps > 0);
+    BENCH_CHECK(sStats.ulDeepSleeps == sStats.ulSleeps);
+    BENCH_CHECK((sStats.ulEarlyWakes > 0) && (sStats.ulEarlyWakes <= sStats.ulSleeps));
+    BENCH_CHECK(sStats.ulWakeSources[GPIO_IRQn] > 0);
+    BENCH_CHECK(ui64Wakes >= sStats.ulSleeps);
+    BENCH_CHECK(sStats.lDriftCounts == 0);
+    BENCH_CHECK(sStats.ullSleepCounts <= sStats.ullElapsedCounts);
+    BENCH_CHECK(ui32ClampedLogged <= sStats.ulClampedSleeps);
+    BENCH_CHECK(sStats.ulClampedSleeps <= ui32ClampedLogged + sStats.ulLogDropped);
+    BENCH_CHECK(sStats.ullSteppedTicks + (sStats.ulSleeps - sStats.ulClampedSleeps) <=
+                sStats.ullExpectedIdleTicks);
+
+    //
+    // Clamped sleeps only come from the second half of the run, and the
+    // expected total only covers sleeps bounded by the periodic task.
+    //
+    if ( g_ui32PeriodMs )
+    {
+        BENCH_CHECK((sStats.ulClampedSleeps > 0) && (sStats.ulClampedSleeps < sStats.ulSleeps));
+        BENCH_CHECK(sStats.ullExpectedIdleTicks <=
+                    (uint64_t) (sStats.ulSleeps - sStats.ulClampedSleeps) * pdMS_TO_TICKS(g_ui32PeriodMs));
+    }
+    else
+    {
+        BENCH_CHECK(sStats.ulClampedSleeps == sStats.ulSleeps);
+        BENCH_CHECK(sStats.ullExpectedIdleTicks == 0);
+    }
+    BENCH_CHECK(ui32Logged + sStats.ulLogDropped == sStats.ulSleeps);
+    BENCH_CHECK(ui32BadSleeps == 0);
+
+    //
+    // The STIMER and the simulator's clock are the same clock, so they must
+    // agree to within the counter resolution on each edge of every sleep, and
+    // the statistics cover the whole run.
+    //
+    BENCH_CHECK(ui64SleepNs <= psSimStats->ullSleepNs + counts_to_ns(2ULL * sStats.ulSleeps));
+    BENCH_CHECK(psSimStats->ullSleepNs <= ui64SleepNs + counts_to_ns(2ULL * sStats.ulSleeps));
+    BENCH_CHECK(ui64ElapsedNs + 10000000ULL >= psSimStats->ullRunNs);
+    BENCH_CHECK(ui64ElapsedNs <= psSimStats->ullRunNs + 10000000ULL);
+
+    return ui32Failed;
+}
+
+int
+main(int argc, char **argv)
+{
+    PortSimStats_t sStats;
+    pthread_t xStimulus;
+    uint32_t ui32Failed;
+    int iOpt;
+
+    while ( (iOpt = getopt(argc, argv, "t:p:d:")) != -1 )
+    {
+        switch ( iOpt )
+        {
+            case 't':
+                g_ui32RunMs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 'p':
+                g_ui32PressMs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 'd':
+                g_ui32PeriodMs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            default:
+                fprintf(stderr, "usage: %s [-t run_ms] [-p press_interval_ms] [-d period_ms]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    am_bsp_host_led_observer_set(led_observer);
+
+    //
+    // Simulation threads must not take interrupts, so create this one with
+    // them masked.
+    //
+    portDISABLE_INTERRUPTS();
+    pthread_create(&xStimulus, NULL, stimulus_thread, NULL);
+
+    if ( g_ui32PeriodMs )
+    {
+        xTaskCreate(periodic_task, "Periodic", configMINIMAL_STACK_SIZE, 0, tskIDLE_PRIORITY + 1, NULL);
+    }
+
+    am_util_debug_printf("FreeRTOS Low Power Example\n");
+    run_tasks();
+
+    vPortSimGetStats(&sStats);
+
+    printf("run time              %8.1f ms\n", sStats.ullRunNs / 1e6);
+    printf("button presses        %8u\n", g_ui32Presses);
+    printf("presses handled       %8u\n", g_ui32Handled);
+    printf("context switches      %8u\n", sStats.ulContextSwitches);
+    printf("tick interrupts       %8u\n", sStats.ulTickInterrupts);
+    printf("tickless sleeps       %8u\n", sStats.ulSleeps);
+    printf("idle residency        %8.1f %%\n",
+           sStats.ullRunNs ? 100.0 * sStats.ullSleepNs / sStats.ullRunNs : 0.0);
+    printf("interrupts            %8u\n", sStats.ulInterrupts);
+    printf("irq latency avg/max   %8.1f / %.1f us\n",
+           sStats.ulInterrupts ? sStats.ullInterruptLatencyNs / 1e3 / sStats.ulInterrupts : 0.0,
+           sStats.ullMaxInterruptLatencyNs / 1e3);
+    printf("task latency avg/max  %8.1f / %.1f us\n",
+           g_ui32Handled ? g_ui64LatencyNs / 1e3 / g_ui32Handled : 0.0,
+           g_ui64MaxLatencyNs / 1e3);
+
+    ui32Failed = tickless_stats_check(&sStats);
+
+    return ((g_ui32Handled == g_ui32Presses) && (ui32Failed == 0)) ? 0 : 1;
+}
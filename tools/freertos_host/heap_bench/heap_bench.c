@@ -0,0 +1,747 @@
+//*****************************************************************************
+//
+//! @file heap_bench.c
+//!
+//! @brief Host stress benchmark of the FreeRTOS heaps.
+//!
+//!
+//! Replays an allocation trace against one of the FreeRTOS heap
+//! implementations (the Makefile builds one binary per heap) and reports the
+//! latency of pvPortMalloc() and vPortFree() and how fragmented the heap
+//! becomes.  The trace is generated from a mix of short lived BLE packets,
+//! sensor samples, long lived connection state and occasional large buffers,
+//! or read from a file written with -w.
+//!
+//! Each run of the trace is made in a fresh process so it starts from an
+//! empty heap.  The latency of each operation is the least seen over all the
+//! runs, which filters out preemption by the host OS, so the maximum is the
+//! worst case of the heap itself.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#ifndef BENCH_HEAP_NAME
+#define BENCH_HEAP_NAME             "heap"
+#endif
+
+//
+// Share of the heap given to the second region when the heap is built from
+// regions, standing in for external PSRAM.
+//
+#define BENCH_PSRAM_SHARE           4
+
+//
+// Lifetimes are counted in allocations and must be shorter than the wheel.
+//
+#define BENCH_WHEEL_SIZE            32768
+
+//
+// Operations between fragmentation samples.
+//
+#define BENCH_SAMPLE_OPS            1000
+
+#define BENCH_OP_FREE               0
+
+//*****************************************************************************
+//
+// Trace entry.  A size of BENCH_OP_FREE frees the allocation with this id.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Id;
+    uint32_t ui32Size;
+} bench_op_t;
+
+//*****************************************************************************
+//
+// Message classes of the generated trace.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Permille;
+    uint32_t ui32MinSize;
+    uint32_t ui32MaxSize;
+    uint32_t ui32MinLife;
+    uint32_t ui32MaxLife;
+} bench_class_t;
+
+static const bench_class_t g_psClasses[] =
+{
+    { "BLE packet",     600,   27,  251,    1,    64 },
+    { "sensor sample",  350,   16,  128,   16,  1024 },
+    { "connection",       3,  256, 2048, 1024, 16384 },
+    { "large buffer",    47, 1024, 4096,    1,   128 },
+};
+
+#define BENCH_NUM_CLASSES   (sizeof(g_psClasses) / sizeof(g_psClasses[0]))
+
+//*****************************************************************************
+//
+// Results of a run, shared with the parent process.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Failed;
+    uint32_t ui32FragFailed;
+    uint32_t ui32Samples;
+    double dFragSum;
+    double dFragMax;
+    size_t xMinFree;
+    size_t xMinLargest;
+    size_t xInitialFree;
+} bench_result_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static bench_op_t *g_psTrace;
+static uint32_t g_ui32TraceLen;
+static uint32_t g_ui32NumIds;
+
+#ifdef BENCH_USE_REGIONS
+static uint8_t g_pui8Sram[BENCH_HEAP_SIZE - BENCH_HEAP_SIZE / BENCH_PSRAM_SHARE];
+static uint8_t g_pui8Psram[BENCH_HEAP_SIZE / BENCH_PSRAM_SHARE];
+#endif
+
+//*****************************************************************************
+//
+// The heap is only used from one thread, so the scheduler calls it makes can
+// do nothing.
+//
+//*****************************************************************************
+void
+vTaskSuspendAll(void)
+{
+}
+
+BaseType_t
+xTaskResumeAll(void)
+{
+    return pdFALSE;
+}
+
+void
+heap_bench_assert_failed(const char *pcFile, int iLine)
+{
+    fprintf(stderr, "%s: assertion failed at %s:%d\n", BENCH_HEAP_NAME, pcFile, iLine);
+    abort();
+}
+
+static uint64_t
+time_ns(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (uint64_t) sNow.tv_sec * 1000000000ULL + (uint64_t) sNow.tv_nsec;
+}
+
+//*****************************************************************************
+//
+// xorshift64*, so a seed gives the same trace on every host.
+//
+//*****************************************************************************
+static uint64_t g_ui64Rand;
+
+static uint32_t
+rand_range(uint32_t ui32Min, uint32_t ui32Max)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+
+    return ui32Min + (uint32_t) (((g_ui64Rand * 2685821657736338717ULL) >> 32) %
+                                 (ui32Max - ui32Min + 1));
+}
+
+static void
+trace_append(uint32_t ui32Id, uint32_t ui32Size)
+{
+    static uint32_t ui32Capacity;
+
+    if ( g_ui32TraceLen == ui32Capacity )
+    {
+        ui32Capacity = ui32Capacity ? ui32Capacity * 2 : 65536;
+        g_psTrace = realloc(g_psTrace, ui32Capacity * sizeof(bench_op_t));
+        if ( g_psTrace == NULL )
+        {
+            perror("realloc");
+            exit(2);
+        }
+    }
+
+    g_psTrace[g_ui32TraceLen].ui32Id = ui32Id;
+    g_psTrace[g_ui32TraceLen].ui32Size = ui32Size;
+    g_ui32TraceLen++;
+
+    if ( ui32Id >= g_ui32NumIds )
+    {
+        g_ui32NumIds = ui32Id + 1;
+    }
+}
+
+//*****************************************************************************
+//
+// Generate a trace of ui32Allocs allocations.  Before each allocation, the
+// allocations whose lifetime has run out are freed.  Ids are reused once
+// freed, so they index a table no larger than the peak live count.
+//
+//*****************************************************************************
+static void
+trace_generate(uint32_t ui32Allocs, uint64_t ui64Seed)
+{
+    static int32_t pi32Wheel[BENCH_WHEEL_SIZE];
+    int32_t *pi32Next = NULL;
+    uint32_t *pui32FreeIds = NULL;
+    uint32_t ui32NumFreeIds = 0;
+    uint32_t ui32Capacity = 0;
+    uint32_t ui32NextId = 0;
+
+    g_ui64Rand = ui64Seed ? ui64Seed : 1;
+    memset(pi32Wheel, 0xff, sizeof(pi32Wheel));
+
+    for ( uint32_t t = 0; t < ui32Allocs + BENCH_WHEEL_SIZE; t++ )
+    {
+        int32_t *pi32Slot = &pi32Wheel[t % BENCH_WHEEL_SIZE];
+        const bench_class_t *psClass;
+        uint32_t ui32Pick, ui32Id, ui32Life;
+
+        //
+        // Free what expires now.
+        //
+        while ( *pi32Slot >= 0 )
+        {
+            ui32Id = (uint32_t) *pi32Slot;
+            *pi32Slot = pi32Next[ui32Id];
+            trace_append(ui32Id, BENCH_OP_FREE);
+            pui32FreeIds[ui32NumFreeIds++] = ui32Id;
+        }
+
+        if ( t >= ui32Allocs )
+        {
+            continue;
+        }
+
+        ui32Pick = rand_range(0, 999);
+        for ( psClass = g_psClasses; ui32Pick >= psClass->ui32Permille; psClass++ )
+        {
+            ui32Pick -= psClass->ui32Permille;
+        }
+
+        if ( ui32NumFreeIds )
+        {
+            ui32Id = pui32FreeIds[--ui32NumFreeIds];
+        }
+        else
+        {
+            ui32Id = ui32NextId++;
+            if ( ui32Id >= ui32Capacity )
+            {
+                ui32Capacity = ui32Capacity ? ui32Capacity * 2 : 4096;
+                pi32Next = realloc(pi32Next, ui32Capacity * sizeof(int32_t));
+                pui32FreeIds = realloc(pui32FreeIds, ui32Capacity * sizeof(uint32_t));
+                if ( (pi32Next == NULL) || (pui32FreeIds == NULL) )
+                {
+                    perror("realloc");
+                    exit(2);
+                }
+            }
+        }
+
+        trace_append(ui32Id, rand_range(psClass->ui32MinSize, psClass->ui32MaxSize));
+
+        ui32Life = rand_range(psClass->ui32MinLife, psClass->ui32MaxLife);
+        pi32Slot = &pi32Wheel[(t + ui32Life) % BENCH_WHEEL_SIZE];
+        pi32Next[ui32Id] = *pi32Slot;
+        *pi32Slot = (int32_t) ui32Id;
+    }
+
+    free(pi32Next);
+    free(pui32FreeIds);
+}
+
+//*****************************************************************************
+//
+// Trace files hold one operation per line: "a <id> <size>" or "f <id>".
+//
+//*****************************************************************************
+static bool
+trace_read(const char *pcPath)
+{
+    FILE *psFile = fopen(pcPath, "r");
+    char cOp;
+    unsigned int uiId, uiSize;
+
+    if ( psFile == NULL )
+    {
+        perror(pcPath);
+        return false;
+    }
+
+    while ( fscanf(psFile, " %c %u", &cOp, &uiId) == 2 )
+    {
+        if ( cOp == 'a' )
+        {
+            if ( (fscanf(psFile, "%u", &uiSize) != 1) || (uiSize == 0) )
+            {
+                break;
+            }
+            trace_append(uiId, uiSize);
+        }
+        else if ( cOp == 'f' )
+        {
+            trace_append(uiId, BENCH_OP_FREE);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if ( !feof(psFile) )
+    {
+        fprintf(stderr, "%s: bad trace entry %u\n", pcPath, g_ui32TraceLen + 1);
+        fclose(psFile);
+        return false;
+    }
+
+    fclose(psFile);
+    return true;
+}
+
+static bool
+trace_write(const char *pcPath)
+{
+    FILE *psFile = fopen(pcPath, "w");
+
+    if ( psFile == NULL )
+    {
+        perror(pcPath);
+        return false;
+    }
+
+    for ( uint32_t i = 0; i < g_ui32TraceLen; i++ )
+    {
+        if ( g_psTrace[i].ui32Size == BENCH_OP_FREE )
+        {
+            fprintf(psFile, "f %u\n", g_psTrace[i].ui32Id);
+        }
+        else
+        {
+            fprintf(psFile, "a %u %u\n", g_psTrace[i].ui32Id, g_psTrace[i].ui32Size);
+        }
+    }
+
+    return fclose(psFile) == 0;
+}
+
+//*****************************************************************************
+//
+// Largest block the heap can hand out, found by trying allocations.  This
+// works the same way for every heap, whatever statistics it keeps.
+//
+//*****************************************************************************
+static size_t
+largest_allocatable(void)
+{
+    size_t xLow = 0;
+    size_t xHigh = xPortGetFreeHeapSize() / portBYTE_ALIGNMENT;
+
+    while ( xLow < xHigh )
+    {
+        size_t xMid = (xLow + xHigh + 1) / 2;
+        void *pv = pvPortMalloc(xMid * portBYTE_ALIGNMENT);
+
+        if ( pv != NULL )
+        {
+            vPortFree(pv);
+            xLow = xMid;
+        }
+        else
+        {
+            xHigh = xMid - 1;
+        }
+    }
+
+    return xLow * portBYTE_ALIGNMENT;
+}
+
+//*****************************************************************************
+//
+// Fill the whole heap and free it again, so the heap sets itself up and its
+// pages are mapped before the timed operations.  This spoils the heap's own
+// low water mark, so the benchmark keeps its own.
+//
+//*****************************************************************************
+static void
+prefault_heap(void)
+{
+    void *pvBlocks = NULL;
+    size_t xSize;
+
+    //
+    // heap_4 reports no free space until it is first used.
+    //
+    vPortFree(pvPortMalloc(1));
+
+    while ( (xSize = largest_allocatable()) >= sizeof(void *) )
+    {
+        void **ppv = pvPortMalloc(xSize);
+
+        memset(ppv, 0, xSize);
+        *ppv = pvBlocks;
+        pvBlocks = ppv;
+    }
+
+    while ( pvBlocks != NULL )
+    {
+        void *pvNext = *(void **) pvBlocks;
+
+        vPortFree(pvBlocks);
+        pvBlocks = pvNext;
+    }
+}
+
+//*****************************************************************************
+//
+// Replay the trace once on a fresh heap.  The latency of each operation is
+// lowered in pui32Latency if this run was faster.  The first run also
+// samples the fragmentation between operations.
+//
+//*****************************************************************************
+static void
+bench_run(uint32_t *pui32Latency, bench_result_t *psResult, bool bSample)
+{
+    void **ppvLive = calloc(g_ui32NumIds, sizeof(void *));
+
+    if ( ppvLive == NULL )
+    {
+        perror("calloc");
+        exit(2);
+    }
+    memset(ppvLive, 0, g_ui32NumIds * sizeof(void *));
+
+#ifdef BENCH_USE_REGIONS
+    {
+        HeapRegion_t psRegions[3] = { { 0 } };
+        bool bSramFirst = (uintptr_t) g_pui8Sram < (uintptr_t) g_pui8Psram;
+
+        //
+        // heap_5 needs the regions in address order.
+        //
+        psRegions[bSramFirst ? 0 : 1].pucStartAddress = g_pui8Sram;
+        psRegions[bSramFirst ? 0 : 1].xSizeInBytes = sizeof(g_pui8Sram);
+        psRegions[bSramFirst ? 1 : 0].pucStartAddress = g_pui8Psram;
+        psRegions[bSramFirst ? 1 : 0].xSizeInBytes = sizeof(g_pui8Psram);
+        vPortDefineHeapRegions(psRegions);
+    }
+#endif
+
+    prefault_heap();
+
+    memset(psResult, 0, sizeof(bench_result_t));
+    psResult->xInitialFree = xPortGetFreeHeapSize();
+    psResult->xMinLargest = psResult->xInitialFree;
+    psResult->xMinFree = psResult->xInitialFree;
+
+    for ( uint32_t i = 0; i < g_ui32TraceLen; i++ )
+    {
+        const bench_op_t *psOp = &g_psTrace[i];
+        uint64_t ui64Start, ui64Ns;
+
+        if ( psOp->ui32Size != BENCH_OP_FREE )
+        {
+            size_t xFree = xPortGetFreeHeapSize();
+
+            ui64Start = time_ns();
+            ppvLive[psOp->ui32Id] = pvPortMalloc(psOp->ui32Size);
+            ui64Ns = time_ns() - ui64Start;
+
+            if ( xPortGetFreeHeapSize() < psResult->xMinFree )
+            {
+                psResult->xMinFree = xPortGetFreeHeapSize();
+            }
+
+            if ( ppvLive[psOp->ui32Id] == NULL )
+            {
+                psResult->ui32Failed++;
+
+                //
+                // Count it against fragmentation if the heap had room for it
+                // with a header and alignment to spare.
+                //
+                if ( xFree >= psOp->ui32Size + 4 * portBYTE_ALIGNMENT )
+                {
+                    psResult->ui32FragFailed++;
+                }
+            }
+        }
+        else
+        {
+            ui64Start = time_ns();
+            vPortFree(ppvLive[psOp->ui32Id]);
+            ui64Ns = time_ns() - ui64Start;
+
+            ppvLive[psOp->ui32Id] = NULL;
+        }
+
+        if ( ui64Ns < pui32Latency[i] )
+        {
+            pui32Latency[i] = (uint32_t) ui64Ns;
+        }
+
+        if ( bSample && ((i % BENCH_SAMPLE_OPS) == BENCH_SAMPLE_OPS - 1) )
+        {
+            size_t xFree = xPortGetFreeHeapSize();
+            size_t xLargest = largest_allocatable();
+            double dFrag = xFree ? 1.0 - (double) xLargest / (double) xFree : 0.0;
+
+            psResult->ui32Samples++;
+            psResult->dFragSum += dFrag;
+            if ( dFrag > psResult->dFragMax )
+            {
+                psResult->dFragMax = dFrag;
+            }
+            if ( xLargest < psResult->xMinLargest )
+            {
+                psResult->xMinLargest = xLargest;
+            }
+        }
+    }
+
+    free(ppvLive);
+}
+
+static int
+compare_u32(const void *pvA, const void *pvB)
+{
+    uint32_t ui32A = *(const uint32_t *) pvA;
+    uint32_t ui32B = *(const uint32_t *) pvB;
+
+    return (ui32A > ui32B) - (ui32A < ui32B);
+}
+
+static void
+print_latency(const char *pcName, uint32_t *pui32Ns, uint32_t ui32Count)
+{
+    double dSum = 0;
+
+    if ( ui32Count == 0 )
+    {
+        return;
+    }
+
+    qsort(pui32Ns, ui32Count, sizeof(uint32_t), compare_u32);
+    for ( uint32_t i = 0; i < ui32Count; i++ )
+    {
+        dSum += pui32Ns[i];
+    }
+
+    printf("%-8s mean %7.1f ns  p99 %6u ns  p99.9 %6u ns  max %7u ns\n", pcName,
+           dSum / ui32Count,
+           pui32Ns[(uint32_t) ((uint64_t) ui32Count * 990 / 1000)],
+           pui32Ns[(uint32_t) ((uint64_t) ui32Count * 999 / 1000)],
+           pui32Ns[ui32Count - 1]);
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Allocs = 1000000;
+    uint32_t ui32Runs = 5;
+    uint64_t ui64Seed = 1;
+    const char *pcReadPath = NULL;
+    const char *pcWritePath = NULL;
+    uint32_t *pui32Latency, *pui32Malloc, *pui32Free;
+    uint32_t ui32NumMalloc = 0, ui32NumFree = 0;
+    bench_result_t *psResult;
+    int iOpt;
+
+    while ( (iOpt = getopt(argc, argv, "n:s:R:r:w:")) != -1 )
+    {
+        switch ( iOpt )
+        {
+            case 'n':
+                ui32Allocs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 's':
+                ui64Seed = strtoull(optarg, NULL, 0);
+                break;
+
+            case 'R':
+                ui32Runs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 'r':
+                pcReadPath = optarg;
+                break;
+
+            case 'w':
+                pcWritePath = optarg;
+                break;
+
+            default:
+                fprintf(stderr, "usage: %s [-n allocations] [-s seed] [-R runs] "
+                        "[-r trace_in] [-w trace_out]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if ( pcReadPath == NULL )
+    {
+        trace_generate(ui32Allocs, ui64Seed);
+    }
+    else if ( !trace_read(pcReadPath) )
+    {
+        return 2;
+    }
+
+    if ( pcWritePath && !trace_write(pcWritePath) )
+    {
+        return 2;
+    }
+
+    //
+    // The heap is only touched by the child processes, so each run starts
+    // from an empty one.  The latencies and results come back through
+    // shared memory.
+    //
+    pui32Latency = mmap(NULL, g_ui32TraceLen * sizeof(uint32_t) + sizeof(bench_result_t),
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if ( pui32Latency == MAP_FAILED )
+    {
+        perror("mmap");
+        return 2;
+    }
+    memset(pui32Latency, 0xff, g_ui32TraceLen * sizeof(uint32_t));
+    psResult = (bench_result_t *) &pui32Latency[g_ui32TraceLen];
+
+    for ( uint32_t ui32Run = 0; ui32Run < (ui32Runs ? ui32Runs : 1); ui32Run++ )
+    {
+        pid_t xChild = fork();
+        int iStatus;
+
+        if ( xChild == 0 )
+        {
+            bench_result_t sResult;
+
+            bench_run(pui32Latency, &sResult, ui32Run == 0);
+            if ( ui32Run == 0 )
+            {
+                *psResult = sResult;
+            }
+            _exit(0);
+        }
+
+        if ( (xChild < 0) || (waitpid(xChild, &iStatus, 0) != xChild) ||
+             !WIFEXITED(iStatus) || (WEXITSTATUS(iStatus) != 0) )
+        {
+            fprintf(stderr, "%s: run %u failed\n", BENCH_HEAP_NAME, ui32Run);
+            return 1;
+        }
+    }
+
+    //
+    // Split the latencies by operation for the percentiles.
+    //
+    pui32Malloc = malloc(g_ui32TraceLen * sizeof(uint32_t));
+    pui32Free = malloc(g_ui32TraceLen * sizeof(uint32_t));
+    if ( (pui32Malloc == NULL) || (pui32Free == NULL) )
+    {
+        perror("malloc");
+        return 2;
+    }
+
+    for ( uint32_t i = 0; i < g_ui32TraceLen; i++ )
+    {
+        if ( g_psTrace[i].ui32Size != BENCH_OP_FREE )
+        {
+            pui32Malloc[ui32NumMalloc++] = pui32Latency[i];
+        }
+        else
+        {
+            pui32Free[ui32NumFree++] = pui32Latency[i];
+        }
+    }
+
+    printf("%s: %u allocations, %u byte heap, best of %u runs\n", BENCH_HEAP_NAME,
+           ui32NumMalloc, BENCH_HEAP_SIZE, ui32Runs ? ui32Runs : 1);
+    print_latency("malloc", pui32Malloc, ui32NumMalloc);
+    print_latency("free", pui32Free, ui32NumFree);
+    printf("failed allocations       %8u (%u with enough free space)\n",
+           psResult->ui32Failed, psResult->ui32FragFailed);
+    printf("usable heap              %8zu bytes\n", psResult->xInitialFree);
+    printf("high water               %8zu bytes\n", psResult->xInitialFree - psResult->xMinFree);
+    printf("smallest largest block   %8zu bytes\n", psResult->xMinLargest);
+    printf("fragmentation mean/max   %8.1f / %.1f %%\n",
+           psResult->ui32Samples ? 100.0 * psResult->dFragSum / psResult->ui32Samples : 0.0,
+           100.0 * psResult->dFragMax);
+
+    free(pui32Malloc);
+    free(pui32Free);
+
+    return 0;
+}
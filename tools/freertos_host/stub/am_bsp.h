@@ -0,0 +1,111 @@
+//*****************************************************************************
+//
+//! @file am_bsp.h
+//!
+//! @brief Host stand-in for the apollo3_evb BSP.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_BSP_H
+#define AM_BSP_H
+
+#include "am_mcu_apollo.h"
+#include "am_devices_button.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// LEDs
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32GPIONumber;
+    uint32_t ui32Polarity;
+}
+am_devices_led_t;
+
+#define AM_BSP_NUM_LEDS                 5
+extern am_devices_led_t am_bsp_psLEDs[AM_BSP_NUM_LEDS];
+
+//*****************************************************************************
+//
+// Buttons
+//
+//*****************************************************************************
+#define AM_BSP_GPIO_BUTTON0             16
+extern const am_hal_gpio_pincfg_t       g_AM_BSP_GPIO_BUTTON0;
+#define AM_BSP_GPIO_BUTTON1             18
+extern const am_hal_gpio_pincfg_t       g_AM_BSP_GPIO_BUTTON1;
+#define AM_BSP_GPIO_BUTTON2             19
+extern const am_hal_gpio_pincfg_t       g_AM_BSP_GPIO_BUTTON2;
+
+#define AM_BSP_NUM_BUTTONS              3
+extern am_devices_button_t am_bsp_psButtons[AM_BSP_NUM_BUTTONS];
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern void am_bsp_low_power_init(void);
+extern void am_bsp_itm_printf_enable(void);
+extern void am_bsp_itm_printf_disable(void);
+
+extern void am_devices_led_array_init(am_devices_led_t *psLEDs, uint32_t ui32NumLEDs);
+extern void am_devices_led_on(am_devices_led_t *psLEDs, uint32_t ui32LEDNum);
+extern void am_devices_led_off(am_devices_led_t *psLEDs, uint32_t ui32LEDNum);
+extern void am_devices_led_toggle(am_devices_led_t *psLEDs, uint32_t ui32LEDNum);
+
+//
+// Host simulation controls.  The observer is called on every LED change.
+//
+typedef void (*am_bsp_host_led_observer_t)(uint32_t ui32LEDNum, bool bOn);
+extern void am_bsp_host_led_observer_set(am_bsp_host_led_observer_t pfnObserver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_BSP_H
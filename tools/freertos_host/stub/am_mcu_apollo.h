@@ -0,0 +1,180 @@
+//*****************************************************************************
+//
+//! @file am_mcu_apollo.h
+//!
+//! @brief Host stand-in for the Apollo MCU headers.
+//!
+//!
+//! Declares the subset of the HAL used by the RTOS parts of the FreeRTOS
+//! examples, so they can be built against the Posix FreeRTOS port.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_MCU_APOLLO_H
+#define AM_MCU_APOLLO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Core.  Interrupt numbers follow Apollo3 and double as the simulated
+// interrupt lines of the Posix port.
+//
+//*****************************************************************************
+typedef enum
+{
+    BLE_IRQn        = 12,
+    GPIO_IRQn       = 13,
+    CTIMER_IRQn     = 14,
+    UART0_IRQn      = 15,
+} IRQn_Type;
+
+#define NVIC_EnableIRQ(irq)             am_hal_host_irq_enable(irq)
+#define NVIC_DisableIRQ(irq)            am_hal_host_irq_disable(irq)
+#define NVIC_SetPriority(irq, pri)      do { (void)(irq); (void)(pri); } while (0)
+
+//
+// Breakpoints in target code trap on the host.
+//
+#define __asm(...)                      __builtin_trap()
+
+#define AM_HAL_STATUS_SUCCESS           0
+#define AM_HAL_STATUS_INVALID_ARG       6
+
+//*****************************************************************************
+//
+// GPIO
+//
+//*****************************************************************************
+#define AM_HAL_GPIO_MAX_PADS            50
+#define AM_HAL_GPIO_BIT(n)              (((uint64_t) 0x1) << n)
+
+typedef enum
+{
+    AM_HAL_GPIO_INPUT_READ,
+    AM_HAL_GPIO_OUTPUT_READ,
+    AM_HAL_GPIO_ENABLE_READ
+} am_hal_gpio_read_type_e;
+
+typedef struct
+{
+    uint32_t    ui32Cfg;
+} am_hal_gpio_pincfg_t;
+
+typedef void (*am_hal_gpio_handler_t)(void);
+
+#define AM_APOLLO3_GPIO                 1
+
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE;
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_INPUT;
+
+#define am_hal_gpio_input_read(n)       am_hal_host_gpio_get(n)
+
+//*****************************************************************************
+//
+// UART.  Only the interrupt registers the examples' UART handlers touch.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t   MIS;
+    volatile uint32_t   IEC;
+} UART0_Type;
+
+#define AM_REG_UART_NUM_MODULES         2
+#define UARTn(n)                        (&am_hal_host_uart[n])
+
+extern UART0_Type am_hal_host_uart[AM_REG_UART_NUM_MODULES];
+
+//*****************************************************************************
+//
+// Sleep
+//
+//*****************************************************************************
+#define AM_HAL_SYSCTRL_SLEEP_DEEP       true
+#define AM_HAL_SYSCTRL_SLEEP_NORMAL     false
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_hal_interrupt_master_enable(void);
+extern uint32_t am_hal_interrupt_master_disable(void);
+extern void am_hal_sysctrl_sleep(bool bSleepDeep);
+
+extern uint32_t am_hal_gpio_pinconfig(uint32_t ui32Pin,
+                                      am_hal_gpio_pincfg_t bfGpioCfg);
+extern uint32_t am_hal_gpio_state_read(uint32_t ui32Pin,
+                                       am_hal_gpio_read_type_e eReadType,
+                                       uint32_t *pu32RetVal);
+extern uint32_t am_hal_gpio_interrupt_enable(uint64_t ui64InterruptMask);
+extern uint32_t am_hal_gpio_interrupt_disable(uint64_t ui64InterruptMask);
+extern uint32_t am_hal_gpio_interrupt_clear(uint64_t ui64InterruptMask);
+extern uint32_t am_hal_gpio_interrupt_status_get(bool bEnabledOnly,
+                                                 uint64_t *pui64IntStatus);
+extern uint32_t am_hal_gpio_interrupt_register(uint32_t ui32GPIONumber,
+                                               am_hal_gpio_handler_t pfnHandler);
+extern uint32_t am_hal_gpio_interrupt_service(uint64_t ui64Status);
+
+extern void am_hal_ctimer_int_clear(uint32_t ui32Interrupt);
+extern uint32_t am_hal_ctimer_int_status_get(bool bEnabledOnly);
+extern void am_hal_ctimer_int_service(uint32_t ui32Status);
+
+//
+// Host simulation controls.
+//
+extern void am_hal_host_irq_enable(IRQn_Type eIRQ);
+extern void am_hal_host_irq_disable(IRQn_Type eIRQ);
+extern void am_hal_host_gpio_set(uint32_t ui32Pin, uint32_t ui32Level);
+extern uint32_t am_hal_host_gpio_get(uint32_t ui32Pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_MCU_APOLLO_H
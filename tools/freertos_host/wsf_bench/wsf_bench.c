@@ -0,0 +1,537 @@
+//*****************************************************************************
+//
+//! @file wsf_bench.c
+//!
+//! @brief Host benchmark of HCI event latency with WSF handlers in two tasks.
+//!
+//!
+//! Runs WSF task 0 (the stack, here an HCI handler fed by a simulated HCI
+//! interrupt) and an application handler that burns CPU on the Posix
+//! FreeRTOS port, and measures the time from each HCI interrupt to the HCI
+//! handler.  Three phases are run:
+//!
+//!   one task    the application handler is in task 0, as with a single WSF
+//!               task
+//!   two tasks   the application handler is in task 1, run by a lower
+//!               priority RTOS task, and takes the stack lock only around a
+//!               short stack call
+//!   lock held   as two tasks, but the handler holds the stack lock for the
+//!               whole burn
+//!
+//! Checks that stack code never runs in two tasks at once, that moving the
+//! application handler out of task 0 takes its burn off the HCI latency,
+//! and that holding the stack lock puts it back.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+#include "wsf_types.h"
+#include "wsf_os.h"
+#include "wsf_os_int.h"
+#include "wsf_buf.h"
+#include "wsf_cs.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define BENCH_HCI_IRQ               1
+#define BENCH_APP_IRQ               2
+
+#define BENCH_HCI_TASK_PRIORITY     2
+#define BENCH_APP_TASK_PRIORITY     1
+
+#define BENCH_SETTLE_MS             50
+#define BENCH_APP_PERIOD_US         20000
+#define BENCH_STACK_CALL_US         50
+
+//
+// HCI events are sent one at a time, at random gaps, each after the last one
+// was handled.
+//
+#define BENCH_HCI_GAP_MIN_US        300
+#define BENCH_HCI_GAP_MAX_US        1500
+
+#define BENCH_EVENT                 0x01
+
+//*****************************************************************************
+//
+// Types
+//
+//*****************************************************************************
+typedef enum
+{
+    BENCH_ONE_TASK,
+    BENCH_TWO_TASKS,
+    BENCH_LOCK_HELD,
+    BENCH_NUM_PHASES
+}
+bench_phase_e;
+
+typedef struct
+{
+    uint32_t    ui32HciEvents;
+    uint64_t    ui64LatencyNs;
+    uint64_t    ui64MaxLatencyNs;
+    uint32_t    ui32AppRuns;
+    uint32_t    ui32AppWrongTask;
+}
+bench_stats_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static const char *g_ppcPhaseNames[BENCH_NUM_PHASES] =
+{
+    "one task", "two tasks", "lock held"
+};
+
+static uint32_t g_ui32PhaseMs = 1000;
+static uint32_t g_ui32BurnUs = 10000;
+
+static volatile bench_phase_e g_ePhase;
+static bench_stats_t g_psStats[BENCH_NUM_PHASES];
+static uint32_t g_ui32Failures;
+
+static wsfHandlerId_t g_hciHandlerId;
+static wsfHandlerId_t g_pAppHandlerId[BENCH_NUM_PHASES];
+
+static TaskHandle_t g_xHciTask;
+static TaskHandle_t g_xAppTask;
+static EventGroupHandle_t g_xHciEvents;
+static EventGroupHandle_t g_xAppEvents;
+
+static volatile uint64_t g_ui64HciTriggerNs;
+static volatile bool g_bHciHandled;
+
+//
+// Set while stack code runs, to catch two tasks in the stack at once.
+//
+static volatile bool g_bInStack;
+static volatile uint32_t g_ui32StackOverlaps;
+
+//*****************************************************************************
+//
+// Support for the WSF and FreeRTOS sources.
+//
+//*****************************************************************************
+void
+wsf_bench_assert_failed(const char *pcFile, int iLine)
+{
+    printf("FreeRTOS assert %s:%d\n", pcFile, iLine);
+    exit(1);
+}
+
+void
+WsfAssert(const char *pFile, uint16_t line)
+{
+    printf("WSF assert %s:%u\n", pFile, line);
+    exit(1);
+}
+
+//
+// No messages are sent here; the WSF message code only needs these to link.
+// malloc is not async-signal-safe, so it runs in a critical section.
+//
+void *
+WsfBufAlloc(uint16_t len)
+{
+    void *pBuf;
+
+    WsfCsEnter();
+    pBuf = malloc(len);
+    WsfCsExit();
+
+    return pBuf;
+}
+
+void
+WsfBufFree(void *pBuf)
+{
+    WsfCsEnter();
+    free(pBuf);
+    WsfCsExit();
+}
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+static void
+burn_us(uint32_t ui32Us)
+{
+    uint64_t ui64EndNs = ullPortSimTimeNs() + (uint64_t) ui32Us * 1000;
+
+    while ( ullPortSimTimeNs() < ui64EndNs )
+    {
+    }
+}
+
+static void
+sleep_us(uint32_t ui32Us)
+{
+    struct timespec sDelay;
+
+    sDelay.tv_sec = ui32Us / 1000000;
+    sDelay.tv_nsec = (long) (ui32Us % 1000000) * 1000L;
+    nanosleep(&sDelay, NULL);
+}
+
+static void
+stack_enter(void)
+{
+    if ( g_bInStack )
+    {
+        g_ui32StackOverlaps++;
+    }
+    g_bInStack = true;
+}
+
+static void
+stack_exit(void)
+{
+    g_bInStack = false;
+}
+
+//*****************************************************************************
+//
+// WSF handlers.
+//
+//*****************************************************************************
+//
+// Stands in for the HCI handler: stack code in task 0.
+//
+static void
+hci_handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
+{
+    bench_stats_t *psStats = &g_psStats[g_ePhase];
+    uint64_t ui64LatencyNs;
+
+    (void) pMsg;
+
+    if ( !(event & BENCH_EVENT) || g_bHciHandled )
+    {
+        return;
+    }
+
+    stack_enter();
+
+    ui64LatencyNs = ullPortSimTimeNs() - g_ui64HciTriggerNs;
+    psStats->ui32HciEvents++;
+    psStats->ui64LatencyNs += ui64LatencyNs;
+    if ( ui64LatencyNs > psStats->ui64MaxLatencyNs )
+    {
+        psStats->ui64MaxLatencyNs = ui64LatencyNs;
+    }
+
+    stack_exit();
+
+    g_bHciHandled = true;
+}
+
+//
+// Application handler that burns CPU and makes a stack call.  The same
+// function is registered in task 0 and in task 1.
+//
+static void
+app_handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg)
+{
+    bench_phase_e ePhase = g_ePhase;
+    bench_stats_t *psStats = &g_psStats[ePhase];
+
+    (void) pMsg;
+
+    if ( !(event & BENCH_EVENT) )
+    {
+        return;
+    }
+
+    psStats->ui32AppRuns++;
+    if ( xTaskGetCurrentTaskHandle() != ((ePhase == BENCH_ONE_TASK) ? g_xHciTask : g_xAppTask) )
+    {
+        psStats->ui32AppWrongTask++;
+    }
+
+    //
+    // In task 0 the lock is already held, and taking it again must not block.
+    //
+    WsfOsLockStack();
+    stack_enter();
+    burn_us((ePhase == BENCH_LOCK_HELD) ? g_ui32BurnUs : BENCH_STACK_CALL_US);
+    stack_exit();
+    WsfOsUnlockStack();
+
+    if ( ePhase != BENCH_LOCK_HELD )
+    {
+        burn_us(g_ui32BurnUs);
+    }
+}
+
+//*****************************************************************************
+//
+// Simulated interrupts.
+//
+//*****************************************************************************
+static void
+hci_isr(void)
+{
+    WsfSetEvent(g_hciHandlerId, BENCH_EVENT);
+}
+
+static void
+app_isr(void)
+{
+    WsfSetEvent(g_pAppHandlerId[g_ePhase], BENCH_EVENT);
+}
+
+//*****************************************************************************
+//
+// RTOS tasks, each running one WSF task.
+//
+//*****************************************************************************
+static void
+hci_task(void *pvParameters)
+{
+    (void) pvParameters;
+
+    while ( 1 )
+    {
+        wsfOsTaskDispatcher(0);
+        xEventGroupWaitBits(g_xHciEvents, 1, pdTRUE, pdFALSE, portMAX_DELAY);
+    }
+}
+
+static void
+app_task(void *pvParameters)
+{
+    (void) pvParameters;
+
+    while ( 1 )
+    {
+        wsfOsTaskDispatcher(1);
+        xEventGroupWaitBits(g_xAppEvents, 1, pdTRUE, pdFALSE, portMAX_DELAY);
+    }
+}
+
+//*****************************************************************************
+//
+// Simulation thread.  Runs each phase in turn, then ends the run.
+//
+//*****************************************************************************
+static void *
+stimulus_thread(void *pvArg)
+{
+    uint32_t ui32Phase;
+
+    (void) pvArg;
+
+    sleep_us(BENCH_SETTLE_MS * 1000);
+
+    for ( ui32Phase = 0; ui32Phase < BENCH_NUM_PHASES; ui32Phase++ )
+    {
+        uint64_t ui64EndNs, ui64NextAppNs, ui64NextHciNs, ui64NowNs, ui64WakeNs;
+
+        g_ePhase = (bench_phase_e) ui32Phase;
+
+        ui64NowNs = ullPortSimTimeNs();
+        ui64EndNs = ui64NowNs + (uint64_t) g_ui32PhaseMs * 1000000ULL;
+        ui64NextAppNs = ui64NowNs;
+        ui64NextHciNs = ui64NowNs + BENCH_HCI_GAP_MIN_US * 1000ULL;
+
+        while ( (ui64NowNs = ullPortSimTimeNs()) < ui64EndNs )
+        {
+            if ( ui64NowNs >= ui64NextAppNs )
+            {
+                vPortSimInterruptTrigger(BENCH_APP_IRQ);
+                ui64NextAppNs += BENCH_APP_PERIOD_US * 1000ULL;
+            }
+
+            if ( ui64NowNs >= ui64NextHciNs )
+            {
+                g_bHciHandled = false;
+                g_ui64HciTriggerNs = ullPortSimTimeNs();
+                vPortSimInterruptTrigger(BENCH_HCI_IRQ);
+
+                while ( !g_bHciHandled )
+                {
+                    sleep_us(50);
+                }
+
+                ui64NextHciNs = ullPortSimTimeNs() + 1000ULL *
+                    (BENCH_HCI_GAP_MIN_US + rand() % (BENCH_HCI_GAP_MAX_US - BENCH_HCI_GAP_MIN_US));
+            }
+
+            ui64WakeNs = (ui64NextHciNs < ui64NextAppNs) ? ui64NextHciNs : ui64NextAppNs;
+            ui64NowNs = ullPortSimTimeNs();
+            if ( ui64WakeNs > ui64NowNs )
+            {
+                sleep_us((uint32_t) ((ui64WakeNs - ui64NowNs) / 1000));
+            }
+        }
+
+        //
+        // Let the last application run finish inside its phase.
+        //
+        sleep_us(g_ui32BurnUs + BENCH_SETTLE_MS * 1000);
+    }
+
+    vPortEndScheduler();
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+#define BENCH_CHECK(cond)                                                   \
+    do                                                                      \
+    {                                                                       \
+        if ( !(cond) )                                                      \
+        {                                                                   \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+            g_ui32Failures++;                                               \
+        }                                                                   \
+    } while (0)
+
+int
+main(int argc, char **argv)
+{
+    pthread_t xStimulus;
+    bench_stats_t *psStats;
+    uint64_t ui64BurnNs;
+    uint32_t i;
+    int iOpt;
+
+    while ( (iOpt = getopt(argc, argv, "t:b:")) != -1 )
+    {
+        switch ( iOpt )
+        {
+            case 't':
+                g_ui32PhaseMs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            case 'b':
+                g_ui32BurnUs = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+
+            default:
+                fprintf(stderr, "usage: %s [-t phase_ms] [-b app_burn_us]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    //
+    // Task 0 runs the HCI handler and, for the first phase, the application
+    // handler.  Task 1 runs the application handler for the others.
+    //
+    g_hciHandlerId = WsfOsSetNextTaskHandler(0, hci_handler);
+    g_pAppHandlerId[BENCH_ONE_TASK] = WsfOsSetNextTaskHandler(0, app_handler);
+    g_pAppHandlerId[BENCH_TWO_TASKS] = WsfOsSetNextTaskHandler(1, app_handler);
+    g_pAppHandlerId[BENCH_LOCK_HELD] = g_pAppHandlerId[BENCH_TWO_TASKS];
+
+    g_xHciEvents = xEventGroupCreate();
+    g_xAppEvents = xEventGroupCreate();
+    wsfOsSetTaskEventObject(0, g_xHciEvents);
+    wsfOsSetTaskEventObject(1, g_xAppEvents);
+
+    xTaskCreate(hci_task, "HCI", 512, NULL, BENCH_HCI_TASK_PRIORITY, &g_xHciTask);
+    xTaskCreate(app_task, "App", 512, NULL, BENCH_APP_TASK_PRIORITY, &g_xAppTask);
+
+    vPortSimInterruptRegister(BENCH_HCI_IRQ, hci_isr);
+    vPortSimInterruptRegister(BENCH_APP_IRQ, app_isr);
+
+    //
+    // Simulation threads must not take interrupts, so create this one with
+    // them masked.
+    //
+    portDISABLE_INTERRUPTS();
+    pthread_create(&xStimulus, NULL, stimulus_thread, NULL);
+
+    vTaskStartScheduler();
+    pthread_join(xStimulus, NULL);
+
+    printf("Application handler burns %u us every %u us, %u ms per phase\n",
+           g_ui32BurnUs, BENCH_APP_PERIOD_US, g_ui32PhaseMs);
+    printf("phase        HCI events  latency avg / max (us)  app runs\n");
+    for ( i = 0; i < BENCH_NUM_PHASES; i++ )
+    {
+        psStats = &g_psStats[i];
+        printf("%-11s  %10u  %9.1f / %-9.1f  %8u\n", g_ppcPhaseNames[i],
+               psStats->ui32HciEvents,
+               psStats->ui32HciEvents ? psStats->ui64LatencyNs / 1e3 / psStats->ui32HciEvents : 0.0,
+               psStats->ui64MaxLatencyNs / 1e3, psStats->ui32AppRuns);
+
+        BENCH_CHECK(psStats->ui32HciEvents > 0);
+        BENCH_CHECK(psStats->ui32AppRuns > 0);
+        BENCH_CHECK(psStats->ui32AppWrongTask == 0);
+    }
+    printf("stack entered by two tasks at once: %u\n", g_ui32StackOverlaps);
+
+    //
+    // With the application in task 0, or holding the lock, an HCI event can
+    // wait for a whole burn.  In its own task, outside the lock, it can't.
+    //
+    ui64BurnNs = (uint64_t) g_ui32BurnUs * 1000;
+    BENCH_CHECK(g_ui32StackOverlaps == 0);
+    BENCH_CHECK(g_psStats[BENCH_ONE_TASK].ui64MaxLatencyNs > ui64BurnNs / 2);
+    BENCH_CHECK(g_psStats[BENCH_TWO_TASKS].ui64MaxLatencyNs < ui64BurnNs / 4);
+    BENCH_CHECK(g_psStats[BENCH_LOCK_HELD].ui64MaxLatencyNs > ui64BurnNs / 2);
+
+    printf("%s: %u failure(s)\n", g_ui32Failures ? "FAIL" : "PASS", g_ui32Failures);
+
+    return g_ui32Failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+//*****************************************************************************
+//
+//! @file wsf_os_host.c
+//!
+//! @brief Host build of the ambiq WSF OS module.
+//!
+//! wsf_os.c masks interrupts with cpsid/cpsie when built with GCC.  This file
+//! builds it with the CMSIS __disable_irq()/__enable_irq() branch instead,
+//! mapped onto the interrupt mask of the Posix FreeRTOS port, so WSF critical
+//! sections keep out the simulated interrupts and task switches as they do on
+//! the target.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+//
+// Everything wsf_os.c includes, while __GNUC__ is still defined.
+//
+#include <string.h>
+#include "wsf_types.h"
+#include "wsf_os.h"
+#include "wsf_assert.h"
+#include "wsf_trace.h"
+#include "wsf_timer.h"
+#include "wsf_queue.h"
+#include "wsf_buf.h"
+#include "wsf_msg.h"
+#include "wsf_cs.h"
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "semphr.h"
+
+//
+// WsfCsEnter() masks on the outermost entry only, so one saved mask is
+// enough.  Restoring it rather than unmasking keeps interrupts masked when a
+// handler uses a WSF service from interrupt context.
+//
+static UBaseType_t g_uxWsfCsMask;
+
+#define __disable_irq()         (g_uxWsfCsMask = portSET_INTERRUPT_MASK_FROM_ISR())
+#define __enable_irq()          portCLEAR_INTERRUPT_MASK_FROM_ISR(g_uxWsfCsMask)
+
+#undef __GNUC__
+#define __CC_ARM
+
+#include "wsf_os.c"
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+# Convert the output of am_util_hci_snoop_drain() into a btsnoop file that
+# Wireshark can open.
+
+import argparse
+import binascii
+import struct
+import sys
+
+BTSNOOP_MAGIC = b'btsnoop\x00'
+BTSNOOP_FILE_HDR = struct.Struct('>8sII')
+BTSNOOP_REC_HDR = struct.Struct('>IIIIq')
+BTSNOOP_DATALINK_H4 = 1002
+
+#******************************************************************************
+#
+# Main function
+#
+#******************************************************************************
+def main():
+
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=1)
+        print('Capturing from {} (Ctrl-C to stop)...'.format(args.port), flush=True)
+    elif args.input == '-':
+        source = sys.stdin.buffer
+    else:
+        source = open(args.input, 'rb')
+
+    parser = SnoopParser()
+    records = 0
+
+    with open(args.output, 'wb') as out:
+        out.write(BTSNOOP_FILE_HDR.pack(BTSNOOP_MAGIC, 1, BTSNOOP_DATALINK_H4))
+        try:
+            for chunk in read_chunks(source):
+                for rec in parser.feed(chunk):
+                    out.write(rec)
+                    records += 1
+                out.flush()
+        except KeyboardInterrupt:
+            pass
+
+    print('Wrote {} records to {} ({} bytes skipped).'.format(records, args.output,
+                                                              parser.skipped))
+
+#******************************************************************************
+#
+# Read the capture in chunks.  With --hex, the input is text and every pair of
+# hex digits is one byte; anything else on the line is ignored.
+#
+#******************************************************************************
+def read_chunks(source):
+
+    while True:
+        if args.hex:
+            line = source.readline()
+            if not line:
+                if args.port:
+                    continue
+                return
+            digits = bytes(c for c in line if chr(c) in '0123456789abcdefABCDEF')
+            chunk = binascii.unhexlify(digits[:len(digits) & ~1])
+        else:
+            chunk = source.read(4096)
+            if not chunk:
+                if args.port:
+                    continue
+                return
+        yield chunk
+
+#******************************************************************************
+#
+# Incremental btsnoop stream parser.
+#
+# The target sends a file header after every am_util_hci_snoop_init(), so the
+# parser waits for one before accepting records.  If a record header does not
+# make sense (bytes were lost on the link), it drops back to searching for the
+# next file header.
+#
+#******************************************************************************
+class SnoopParser:
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.synced = False
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            if not self.synced:
+                idx = self.buf.find(BTSNOOP_MAGIC)
+                if idx < 0:
+                    keep = len(BTSNOOP_MAGIC) - 1
+                    self.skip(max(0, len(self.buf) - keep))
+                    return
+                self.skip(idx)
+                if len(self.buf) < BTSNOOP_FILE_HDR.size:
+                    return
+                _, version, datalink = BTSNOOP_FILE_HDR.unpack_from(self.buf)
+                if version != 1 or datalink != BTSNOOP_DATALINK_H4:
+                    self.skip(1)
+                    continue
+                del self.buf[:BTSNOOP_FILE_HDR.size]
+                self.synced = True
+                continue
+
+            # A new file header means the target restarted the capture.
+            if self.buf[:len(BTSNOOP_MAGIC)] == BTSNOOP_MAGIC:
+                self.synced = False
+                continue
+
+            if len(self.buf) < BTSNOOP_REC_HDR.size:
+                return
+            orig, incl, flags, _, _ = BTSNOOP_REC_HDR.unpack_from(self.buf)
+            if incl == 0 or incl > orig or orig > 0x10000 or flags > 3:
+                self.synced = False
+                self.skip(1)
+                continue
+
+            size = BTSNOOP_REC_HDR.size + incl
+            if len(self.buf) < size:
+                return
+            rec = bytes(self.buf[:size])
+            del self.buf[:size]
+            yield rec
+
+    def skip(self, count):
+        self.skipped += count
+        del self.buf[:count]
+
+#******************************************************************************
+#
+# Main program flow
+#
+#******************************************************************************
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(
+        description='Convert an Apollo3 HCI snoop capture to a btsnoop file.')
+
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('-i', '--input',
+                        help='Captured data file, or - for stdin')
+    source.add_argument('-p', '--port',
+                        help='Serial port to capture from (requires pyserial)')
+
+    parser.add_argument('-b', '--baud', type=int, default=115200,
+                        help='Serial baud rate (default 115200)')
+    parser.add_argument('--hex', action='store_true',
+                        help='Input is hex text (e.g. from an ITM/SWO console)')
+    parser.add_argument('-o', '--output', required=True,
+                        help='btsnoop file to write')
+
+    args = parser.parse_args()
+
+    main()
@@ -0,0 +1,434 @@
+//*****************************************************************************
+//
+//! @file adc_demux_test.c
+//!
+//! @brief Host test and benchmark of am_hal_adc_samples_demux().
+//!
+//!
+//! Checks the demultiplexer against a reference model over random FIFO data
+//! delivered in random chunk sizes: per-slot output, decimation rounding,
+//! overflow counts, trigger positions and the per-call trigger mask.
+//!
+//! The benchmark then sorts the same DMA buffer per slot two ways:
+//! am_hal_adc_samples_read() into am_hal_adc_sample_t followed by a copy
+//! loop, which is what callers did before, and am_hal_adc_samples_demux().
+//! Times are host nanoseconds per FIFO word, useful as a ratio only.
+//!
+//! Usage: adc_demux_test [-n iterations] [-s seed]
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define DMA_WORDS                   1024
+#define OUT_CAPACITY                (DMA_WORDS * 4)
+#define BENCH_RUNS                  5
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static void *g_pHandle;
+
+static uint32_t g_pui32Dma[DMA_WORDS * 8];
+static int16_t g_i16Out[AM_HAL_ADC_MAX_SLOTS][OUT_CAPACITY];
+static int16_t g_i16Ref[AM_HAL_ADC_MAX_SLOTS][OUT_CAPACITY];
+static am_hal_adc_sample_t g_sSamples[DMA_WORDS];
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the ADC module links against.
+//
+//*****************************************************************************
+uint32_t am_hal_flash_load_ui32(uint32_t *pui32Address) { (void)pui32Address; return 0; }
+uint32_t am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+
+//*****************************************************************************
+//
+// Build a FIFO word the way the ADC DMA writes it.
+//
+//*****************************************************************************
+static uint32_t
+fifo_word(uint32_t ui32Slot, uint32_t ui32FullSample)
+{
+    return _VAL2FLD(ADC_FIFO_SLOTNUM, ui32Slot) |
+           _VAL2FLD(ADC_FIFO_COUNT, rand_next() & 0xFF) |
+           _VAL2FLD(ADC_FIFO_DATA, ui32FullSample);
+}
+
+//*****************************************************************************
+//
+// Reference model.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint64_t ui64Sum[AM_HAL_ADC_MAX_SLOTS];
+    uint32_t ui32N[AM_HAL_ADC_MAX_SLOTS];
+    uint32_t ui32Count[AM_HAL_ADC_MAX_SLOTS];
+    uint32_t ui32Overflows[AM_HAL_ADC_MAX_SLOTS];
+    uint32_t ui32Trigger[AM_HAL_ADC_MAX_SLOTS];
+} ref_t;
+
+static uint32_t
+ref_feed(ref_t *psRef, const am_hal_adc_demux_config_t *psConfig,
+         const uint32_t *pui32Words, uint32_t ui32Num)
+{
+    uint32_t ui32Mask = 0;
+
+    for (uint32_t i = 0; i < ui32Num; i++)
+    {
+        uint32_t ui32Slot = (pui32Words[i] >> 28) & 0x7;
+        const am_hal_adc_demux_slot_config_t *psSlot = &psConfig->sSlot[ui32Slot];
+        uint64_t ui64Div = 64ull * psConfig->ui32Decimation;
+        int16_t i16Out;
+
+        psRef->ui64Sum[ui32Slot] += pui32Words[i] & 0xFFFFF;
+        if (++psRef->ui32N[ui32Slot] < psConfig->ui32Decimation)
+        {
+            continue;
+        }
+
+        //
+        // Round half up to an integer sample.
+        //
+        i16Out = (int16_t)((psRef->ui64Sum[ui32Slot] + ui64Div / 2) / ui64Div);
+        psRef->ui64Sum[ui32Slot] = 0;
+        psRef->ui32N[ui32Slot] = 0;
+
+        if (!psSlot->pi16Buffer)
+        {
+            continue;
+        }
+        if (psRef->ui32Count[ui32Slot] >= psSlot->ui32Capacity)
+        {
+            psRef->ui32Overflows[ui32Slot]++;
+            continue;
+        }
+        if (psSlot->bTriggerEnable && (psRef->ui32Trigger[ui32Slot] == AM_HAL_ADC_DEMUX_NO_TRIGGER) &&
+            ((i16Out > psSlot->i16TriggerHigh) || (i16Out < psSlot->i16TriggerLow)))
+        {
+            psRef->ui32Trigger[ui32Slot] = psRef->ui32Count[ui32Slot];
+            ui32Mask |= 1u << ui32Slot;
+        }
+        g_i16Ref[ui32Slot][psRef->ui32Count[ui32Slot]++] = i16Out;
+    }
+
+    return ui32Mask;
+}
+
+//*****************************************************************************
+//
+// Random configurations and data against the reference model.
+//
+//*****************************************************************************
+static void
+test_model(uint32_t ui32Rounds)
+{
+    for (uint32_t r = 0; r < ui32Rounds; r++)
+    {
+        am_hal_adc_demux_config_t sConfig;
+        am_hal_adc_demux_t sDemux;
+        ref_t sRef;
+        uint32_t ui32Slots = 1 + rand_next() % AM_HAL_ADC_MAX_SLOTS;
+        uint32_t ui32Words = rand_next() % (DMA_WORDS * 8);
+        uint32_t ui32Done = 0;
+
+        memset(&sConfig, 0, sizeof(sConfig));
+        memset(&sRef, 0, sizeof(sRef));
+        sConfig.ui32Decimation = 1u << (rand_next() % 9);
+
+        for (uint32_t s = 0; s < AM_HAL_ADC_MAX_SLOTS; s++)
+        {
+            uint32_t ui32Roll = rand_next() % 8;
+
+            sConfig.sSlot[s].pi16Buffer = (ui32Roll == 0) ? NULL : g_i16Out[s];
+            sConfig.sSlot[s].ui32Capacity = (ui32Roll == 1) ? rand_next() % 16 : OUT_CAPACITY;
+            sConfig.sSlot[s].bTriggerEnable = (rand_next() & 1);
+            sConfig.sSlot[s].i16TriggerHigh = (int16_t)(rand_next() % 0x4000);
+            sConfig.sSlot[s].i16TriggerLow = (int16_t)(rand_next() % 0x1000);
+            sRef.ui32Trigger[s] = AM_HAL_ADC_DEMUX_NO_TRIGGER;
+        }
+
+        //
+        // Slow ramps with noise, so thresholds are crossed part way through.
+        //
+        for (uint32_t i = 0; i < ui32Words; i++)
+        {
+            uint32_t ui32Slot = (rand_next() % 4) ? (i % ui32Slots) : rand_next() % ui32Slots;
+            uint32_t ui32Value = ((i * 64) + (rand_next() % 0x8000)) & 0xFFFFF;
+
+            g_pui32Dma[i] = fifo_word(ui32Slot, ui32Value);
+        }
+
+        CHECK(am_hal_adc_demux_init(&sDemux, &sConfig) == AM_HAL_STATUS_SUCCESS);
+
+        while (ui32Done < ui32Words)
+        {
+            uint32_t ui32Chunk = rand_next() % 300;
+            uint32_t ui32Mask = 0xFFFFFFFF, ui32RefMask;
+
+            if (ui32Chunk > ui32Words - ui32Done)
+            {
+                ui32Chunk = ui32Words - ui32Done;
+            }
+
+            CHECK(am_hal_adc_samples_demux(&sDemux, &g_pui32Dma[ui32Done], ui32Chunk, &ui32Mask) ==
+                  AM_HAL_STATUS_SUCCESS);
+            ui32RefMask = ref_feed(&sRef, &sConfig, &g_pui32Dma[ui32Done], ui32Chunk);
+            CHECK(ui32Mask == ui32RefMask);
+            ui32Done += ui32Chunk;
+        }
+
+        for (uint32_t s = 0; s < AM_HAL_ADC_MAX_SLOTS; s++)
+        {
+            CHECK(sDemux.ui32Count[s] == sRef.ui32Count[s]);
+            CHECK(sDemux.ui32Overflows[s] == sRef.ui32Overflows[s]);
+            CHECK(sDemux.ui32TriggerIndex[s] == sRef.ui32Trigger[s]);
+            CHECK(memcmp(g_i16Out[s], g_i16Ref[s], sRef.ui32Count[s] * sizeof(int16_t)) == 0);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Argument checks.
+//
+//*****************************************************************************
+static void
+test_api(void)
+{
+    am_hal_adc_demux_config_t sConfig;
+    am_hal_adc_demux_t sDemux;
+
+    memset(&sConfig, 0, sizeof(sConfig));
+
+    sConfig.ui32Decimation = 0;
+    CHECK(am_hal_adc_demux_init(&sDemux, &sConfig) == AM_HAL_STATUS_INVALID_ARG);
+    sConfig.ui32Decimation = 3;
+    CHECK(am_hal_adc_demux_init(&sDemux, &sConfig) == AM_HAL_STATUS_INVALID_ARG);
+    sConfig.ui32Decimation = 512;
+    CHECK(am_hal_adc_demux_init(&sDemux, &sConfig) == AM_HAL_STATUS_INVALID_ARG);
+    sConfig.ui32Decimation = 256;
+    CHECK(am_hal_adc_demux_init(&sDemux, &sConfig) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_hal_adc_samples_demux(&sDemux, NULL, 1, NULL) == AM_HAL_STATUS_INVALID_ARG);
+    CHECK(am_hal_adc_samples_demux(&sDemux, NULL, 0, NULL) == AM_HAL_STATUS_SUCCESS);
+
+    //
+    // Full scale input at the largest decimation must not wrap.
+    //
+    sConfig.sSlot[0].pi16Buffer = g_i16Out[0];
+    sConfig.sSlot[0].ui32Capacity = 1;
+    CHECK(am_hal_adc_demux_init(&sDemux, &sConfig) == AM_HAL_STATUS_SUCCESS);
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        g_pui32Dma[i] = fifo_word(0, 0xFFFFF);
+    }
+    CHECK(am_hal_adc_samples_demux(&sDemux, g_pui32Dma, 256, NULL) == AM_HAL_STATUS_SUCCESS);
+    CHECK(sDemux.ui32Count[0] == 1);
+    CHECK(g_i16Out[0][0] == 0x4000);
+}
+
+//*****************************************************************************
+//
+// Benchmark.
+//
+//*****************************************************************************
+static double
+now_ns(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return sTime.tv_sec * 1e9 + sTime.tv_nsec;
+}
+
+static void
+bench(uint32_t ui32Slots, uint32_t ui32Iterations)
+{
+    am_hal_adc_demux_config_t sConfig;
+    am_hal_adc_demux_t sDemux;
+    uint32_t ui32Count[AM_HAL_ADC_MAX_SLOTS];
+    double dStart, dRead, dDemux;
+
+    //
+    // samples_read() truncates the 6 fractional bits and the demultiplexer
+    // rounds them, so use whole samples to let the outputs be compared.
+    //
+    for (uint32_t i = 0; i < DMA_WORDS; i++)
+    {
+        g_pui32Dma[i] = fifo_word(i % ui32Slots, rand_next() & 0xFFFC0);
+    }
+
+    memset(&sConfig, 0, sizeof(sConfig));
+    sConfig.ui32Decimation = 1;
+    for (uint32_t s = 0; s < ui32Slots; s++)
+    {
+        sConfig.sSlot[s].pi16Buffer = g_i16Out[s];
+        sConfig.sSlot[s].ui32Capacity = OUT_CAPACITY;
+    }
+    am_hal_adc_demux_init(&sDemux, &sConfig);
+
+    //
+    // Best of several runs of each, to keep scheduling noise out.
+    //
+    dRead = dDemux = 1e30;
+    for (uint32_t r = 0; r < BENCH_RUNS; r++)
+    {
+        double dTime;
+
+        //
+        // Before: expand every word to an 8-byte am_hal_adc_sample_t, then
+        // copy each slot's samples out.
+        //
+        dStart = now_ns();
+        for (uint32_t n = 0; n < ui32Iterations; n++)
+        {
+            uint32_t ui32Num = DMA_WORDS;
+
+            am_hal_adc_samples_read(g_pHandle, false, g_pui32Dma, &ui32Num, g_sSamples);
+            memset(ui32Count, 0, sizeof(ui32Count));
+            for (uint32_t i = 0; i < ui32Num; i++)
+            {
+                uint32_t ui32Slot = g_sSamples[i].ui32Slot;
+
+                g_i16Ref[ui32Slot][ui32Count[ui32Slot]++] = (int16_t) g_sSamples[i].ui32Sample;
+            }
+        }
+        dTime = (now_ns() - dStart) / ((double) ui32Iterations * DMA_WORDS);
+        dRead = (dTime < dRead) ? dTime : dRead;
+
+        dStart = now_ns();
+        for (uint32_t n = 0; n < ui32Iterations; n++)
+        {
+            am_hal_adc_demux_reset(&sDemux);
+            am_hal_adc_samples_demux(&sDemux, g_pui32Dma, DMA_WORDS, NULL);
+        }
+        dTime = (now_ns() - dStart) / ((double) ui32Iterations * DMA_WORDS);
+        dDemux = (dTime < dDemux) ? dTime : dDemux;
+    }
+
+    //
+    // Both must have produced the same per-slot samples.
+    //
+    for (uint32_t s = 0; s < ui32Slots; s++)
+    {
+        CHECK(sDemux.ui32Count[s] == ui32Count[s]);
+        CHECK(memcmp(g_i16Out[s], g_i16Ref[s], ui32Count[s] * sizeof(int16_t)) == 0);
+    }
+
+    printf("%u slot(s): samples_read + sort %.2f ns/word, %u scratch bytes; "
+           "samples_demux %.2f ns/word, 0 scratch bytes (%.1fx)\n",
+           (unsigned) ui32Slots, dRead, (unsigned) sizeof(g_sSamples), dDemux, dRead / dDemux);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Iterations = 4000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Iterations = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    //
+    // am_hal_adc_samples_read() reads FIFOPR for every word.
+    //
+    host_regs_map(ADC_BASE, sizeof(ADC_Type));
+    if (am_hal_adc_initialize(0, &g_pHandle) != AM_HAL_STATUS_SUCCESS)
+    {
+        printf("FAIL: am_hal_adc_initialize\n");
+        return 1;
+    }
+
+    test_api();
+    test_model(200);
+    bench(1, ui32Iterations);
+    bench(4, ui32Iterations);
+    bench(8, ui32Iterations);
+
+    return host_test_result();
+}
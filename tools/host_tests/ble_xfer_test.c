@@ -0,0 +1,1272 @@
+//*****************************************************************************
+//
+//! @file ble_xfer_test.c
+//!
+//! @brief Timing test of the BLEIF HCI transfers on a model of the BLE controller.
+//!
+//! Builds the real am_hal_ble.c into this file so that every BLEIF register
+//! access first brings a model of the interface and the controller up to
+//! date: the WAKE, STATUS and IRQ lines and their edge interrupts, the 8 MHz
+//! SPI, both FIFOs and the DMA engine.  Time advances by a fixed cost per
+//! register access and through am_hal_flash_delay().
+//!
+//! HCI packets are written and read with the blocking calls and with the
+//! nonblocking calls driven from an emulated BLE interrupt, as
+//! hci_drv_apollo3.c uses them.  Each run reports the round trip and the CPU
+//! time spent in the HAL per packet, checks the data, and checks when the
+//! nonblocking path reports completion on B0 and on A1 parts.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// The BLE HAL, with every register access bringing the model up to date.
+//
+//*****************************************************************************
+static void model_sync(void);
+
+#undef BLEIFn
+#define BLEIFn(n)                   ((void)(n), model_sync(), BLEIF)
+
+#include "am_hal_ble.c"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define BLEIF_REGS_SIZE             sizeof(BLEIF_Type)
+#define MCUCTRL_REGS_SIZE           sizeof(MCUCTRL_Type)
+
+#define FIFO_WORDS                  8
+#define MAX_PACKET                  256
+#define PAD_BYTE                    0xEE
+
+//
+// Timing, in ns.  One BLEIF register access; 8 MHz SPI; chip select and
+// command phase per transfer; controller response to WAKE; STATUS and IRQ
+// release after the last byte; BLE interrupt entry; one idle CPU step; what
+// two interrupt entries and a falling edge may add to a round trip.
+//
+#define REG_NS                      100
+#define BYTE_NS                     1000
+#define XFER_SETUP_NS               1000
+#define WAKE_NS                     30000
+#define STATUS_FALL_NS              2000
+#define IRQ_FALL_NS                 1000
+#define ISR_LATENCY_NS              500
+#define IDLE_NS                     250
+#define RTT_SLACK_NS                5000
+#define PACKET_TIMEOUT_NS           20000000
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static uint64_t g_ui64Now;
+static uint32_t g_ui32WakeNs = WAKE_NS;
+
+//
+// BLEIF and controller state not held in the registers.
+//
+typedef struct
+{
+    uint32_t    ui32Data;
+    uint32_t    ui32Valid;
+}
+fifo_word_t;
+
+static struct
+{
+    uint64_t    ui64Time;
+
+    //
+    // Controller lines.  A zero time means no edge is scheduled.
+    //
+    bool        bWake;
+    bool        bStatus;
+    bool        bIrq;
+    bool        bWriteDone;
+    uint64_t    ui64StatusRiseAt;
+    uint64_t    ui64StatusFallAt;
+    uint64_t    ui64IrqFallAt;
+    uint64_t    ui64StatusFell;
+    uint64_t    ui64IrqFell;
+
+    //
+    // SPI transfer in progress.
+    //
+    bool        bXfer;
+    uint32_t    ui32Cmd;
+    uint32_t    ui32XferLen;
+    uint32_t    ui32XferDone;
+    uint32_t    ui32TxPushed;
+    uint64_t    ui64NextByteAt;
+
+    //
+    // FIFO0 (TX) and FIFO1 (RX).  The RX side assembles bytes into a word
+    // before it becomes visible.
+    //
+    fifo_word_t psTx[FIFO_WORDS];
+    uint32_t    ui32TxWords;
+    fifo_word_t psRx[FIFO_WORDS];
+    uint32_t    ui32RxWords;
+    fifo_word_t sRxPartial;
+    bool        bPopPresented;
+    uint32_t    ui32PopValue;
+
+    //
+    // DMA engine.
+    //
+    bool        bDmaArmed;
+
+    //
+    // Controller RX packet: the 2-byte length, then the body.
+    //
+    bool        bRxPending;
+    uint32_t    ui32RxPhase;
+    uint32_t    ui32RxPos;
+    uint32_t    ui32RxLength;
+    uint8_t     pui8RxPacket[MAX_PACKET];
+
+    //
+    // Last packet written by the host.
+    //
+    uint32_t    ui32GotLength;
+    uint8_t     pui8Got[MAX_PACKET + 4];
+    uint32_t    ui32Errors;
+} g_sModel;
+
+//
+// The application: an emulation of the nonblocking parts of
+// hci_drv_apollo3.c.
+//
+static struct
+{
+    void        *pvBle;
+    bool        bIrqPending;
+    uint64_t    ui64IrqAt;
+    uint64_t    ui64BusyNs;
+    bool        bWritePending;
+    uint32_t    ui32WriteLength;
+    uint32_t    ui32WritesQueued;
+    uint32_t    ui32WritesBad;
+    bool        bDone;
+    uint64_t    ui64DoneAt;
+    bool        bStatusAtDone;
+    bool        bIrqAtDone;
+    uint32_t    ui32DoneLength;
+} g_sApp;
+
+//
+// Transfer buffers.  The DMA engine takes 32-bit addresses, so these stay
+// static and the test links without PIE.
+//
+static uint32_t g_pui32TxBuffer[(MAX_PACKET + 4) / 4];
+static uint32_t g_pui32RxBuffer[(MAX_PACKET + 4) / 4];
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//
+// Packet bytes are never zero, so no FIFO word is zero; the model uses zero
+// to tell CPU FIFO accesses apart.
+//
+static uint8_t
+rand_byte(void)
+{
+    return 1 + rand_next() % 255;
+}
+
+//*****************************************************************************
+//
+// HAL entry points the BLE HAL links against.
+//
+//*****************************************************************************
+void
+am_hal_debug_error(const char *pcFile, uint32_t ui32Line, const char *pcMessage)
+{
+    printf("FAIL %s:%u: HAL assert %s\n", pcFile, (unsigned)ui32Line, pcMessage ? pcMessage : "");
+    g_ui32Failures++;
+}
+
+uint32_t am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+
+static void model_update(void);
+
+//
+// Three cycles per iteration at 48 MHz.
+//
+void
+am_hal_flash_delay(uint32_t ui32Iterations)
+{
+    g_ui64Now += (uint64_t)ui32Iterations * 3000 / AM_HAL_CLKGEN_FREQ_MAX_MHZ;
+    model_update();
+}
+
+//*****************************************************************************
+//
+// BLEIF and controller model.
+//
+//*****************************************************************************
+static void
+model_reset(void)
+{
+    memset(&g_sModel, 0, sizeof(g_sModel));
+    memset((void *)BLEIF, 0, BLEIF_REGS_SIZE);
+}
+
+static void
+model_set_chiprev(bool bB0)
+{
+    if (bB0)
+    {
+        MCUCTRL->CHIPREV = _VAL2FLD(MCUCTRL_CHIPREV_REVMAJ, MCUCTRL_CHIPREV_REVMAJ_B) |
+                           _VAL2FLD(MCUCTRL_CHIPREV_REVMIN, MCUCTRL_CHIPREV_REVMIN_REV0);
+    }
+    else
+    {
+        MCUCTRL->CHIPREV = _VAL2FLD(MCUCTRL_CHIPREV_REVMAJ, MCUCTRL_CHIPREV_REVMAJ_A) |
+                           _VAL2FLD(MCUCTRL_CHIPREV_REVMIN, MCUCTRL_CHIPREV_REVMIN_REV1);
+    }
+}
+
+static void
+model_rx_commit(void)
+{
+    if (g_sModel.sRxPartial.ui32Valid)
+    {
+        while (g_sModel.sRxPartial.ui32Valid < 4)
+        {
+            g_sModel.sRxPartial.ui32Data |= (uint32_t)PAD_BYTE << (8 * g_sModel.sRxPartial.ui32Valid);
+            g_sModel.sRxPartial.ui32Valid++;
+        }
+
+        g_sModel.psRx[g_sModel.ui32RxWords++] = g_sModel.sRxPartial;
+        memset(&g_sModel.sRxPartial, 0, sizeof(g_sModel.sRxPartial));
+    }
+}
+
+static uint32_t
+model_rx_pop(void)
+{
+    uint32_t ui32Data = g_sModel.psRx[0].ui32Data;
+
+    g_sModel.ui32RxWords--;
+    memmove(&g_sModel.psRx[0], &g_sModel.psRx[1], g_sModel.ui32RxWords * sizeof(fifo_word_t));
+    return ui32Data;
+}
+
+static void
+model_tx_push(uint32_t ui32Data)
+{
+    uint32_t ui32Valid = 4;
+
+    if (g_sModel.ui32TxWords == FIFO_WORDS)
+    {
+        g_sModel.ui32Errors++;
+        return;
+    }
+
+    if (g_sModel.bXfer && (g_sModel.ui32Cmd == AM_HAL_BLE_WRITE))
+    {
+        ui32Valid = g_sModel.ui32XferLen - g_sModel.ui32TxPushed;
+        ui32Valid = ui32Valid < 4 ? ui32Valid : 4;
+        g_sModel.ui32TxPushed += ui32Valid;
+    }
+
+    if (ui32Valid == 0)
+    {
+        g_sModel.ui32Errors++;
+        return;
+    }
+
+    g_sModel.psTx[g_sModel.ui32TxWords].ui32Data = ui32Data;
+    g_sModel.psTx[g_sModel.ui32TxWords].ui32Valid = ui32Valid;
+    g_sModel.ui32TxWords++;
+}
+
+//
+// A new command word.  Writes need the controller to hold STATUS, reads need
+// IRQ.  The HAL writes the command word twice for blocking writes, which the
+// model takes as a restart as long as no data has moved.
+//
+static void
+model_command(uint32_t ui32CmdWord)
+{
+    if (g_sModel.bXfer && g_sModel.ui32XferDone)
+    {
+        g_sModel.ui32Errors++;
+    }
+
+    g_sModel.bXfer = true;
+    g_sModel.ui32Cmd = _FLD2VAL(BLEIF_CMD_CMD, ui32CmdWord);
+    g_sModel.ui32XferLen = _FLD2VAL(BLEIF_CMD_TSIZE, ui32CmdWord);
+    g_sModel.ui32XferDone = 0;
+    g_sModel.ui32TxPushed = 0;
+    g_sModel.ui64NextByteAt = g_sModel.ui64Time + XFER_SETUP_NS +
+                              _FLD2VAL(BLEIF_CMD_OFFSETCNT, ui32CmdWord) * BYTE_NS;
+
+    if (g_sModel.ui32Cmd == AM_HAL_BLE_WRITE)
+    {
+        g_sModel.ui32GotLength = 0;
+        if (!g_sModel.bStatus)
+        {
+            g_sModel.ui32Errors++;
+        }
+    }
+    else if (!g_sModel.bIrq || !g_sModel.bRxPending)
+    {
+        g_sModel.ui32Errors++;
+    }
+}
+
+//
+// Apply the register writes the CPU has made since the last call.
+//
+static void
+model_apply(void)
+{
+    if (BLEIF->INTCLR)
+    {
+        BLEIF->INTSTAT &= ~BLEIF->INTCLR;
+        BLEIF->INTCLR = 0;
+    }
+
+    if (BLEIF->INTSET)
+    {
+        BLEIF->INTSTAT |= BLEIF->INTSET;
+        BLEIF->INTSET = 0;
+    }
+
+    if (BLEIF->CMD)
+    {
+        model_command(BLEIF->CMD);
+        BLEIF->CMD = 0;
+    }
+
+    if (BLEIF->FIFOPUSH)
+    {
+        model_tx_push(BLEIF->FIFOPUSH);
+        BLEIF->FIFOPUSH = 0;
+    }
+
+    //
+    // With FIFO protection the HAL pops a word by writing FIFOPOP.
+    //
+    if (g_sModel.bPopPresented && (BLEIF->FIFOPOP != g_sModel.ui32PopValue))
+    {
+        if (g_sModel.ui32RxWords)
+        {
+            model_rx_pop();
+        }
+        g_sModel.bPopPresented = false;
+    }
+
+    g_sModel.bWake = (BLEIF->BLECFG_b.WAKEUPCTL == BLEIF_BLECFG_WAKEUPCTL_ON);
+}
+
+//
+// The DMA engine moves words between memory and the FIFOs as soon as it
+// can, and flags DCMP when its count runs out.
+//
+static void
+model_dma(void)
+{
+    uint32_t ui32Cfg = BLEIF->DMACFG;
+
+    if (!(ui32Cfg & BLEIF_DMACFG_DMAEN_Msk))
+    {
+        g_sModel.bDmaArmed = false;
+        return;
+    }
+
+    if (!g_sModel.bDmaArmed)
+    {
+        if (BLEIF->DMATOTCOUNT == 0)
+        {
+            return;
+        }
+        g_sModel.bDmaArmed = true;
+    }
+
+    while (BLEIF->DMATOTCOUNT)
+    {
+        uint32_t ui32Count = BLEIF->DMATOTCOUNT < 4 ? BLEIF->DMATOTCOUNT : 4;
+        uint8_t *pui8Mem = (uint8_t *)(uintptr_t)BLEIF->DMATARGADDR;
+
+        if (_FLD2VAL(BLEIF_DMACFG_DMADIR, ui32Cfg) == BLEIF_DMACFG_DMADIR_M2P)
+        {
+            uint32_t ui32Data = 0;
+
+            if (g_sModel.ui32TxWords == FIFO_WORDS)
+            {
+                break;
+            }
+
+            memcpy(&ui32Data, pui8Mem, ui32Count);
+            model_tx_push(ui32Data);
+        }
+        else
+        {
+            uint32_t ui32Data;
+
+            if (g_sModel.ui32RxWords == 0)
+            {
+                break;
+            }
+
+            ui32Data = model_rx_pop();
+            memcpy(pui8Mem, &ui32Data, ui32Count);
+        }
+
+        BLEIF->DMATARGADDR += ui32Count;
+        BLEIF->DMATOTCOUNT -= ui32Count;
+    }
+
+    if (g_sModel.bDmaArmed && (BLEIF->DMATOTCOUNT == 0))
+    {
+        g_sModel.bDmaArmed = false;
+        BLEIF->INTSTAT |= BLEIF_INTSTAT_DCMP_Msk;
+    }
+}
+
+//
+// Line changes that follow from the current state: STATUS answers WAKE when
+// the controller is idle and drops once a write is done or WAKE goes away;
+// IRQ rises for a pending packet while STATUS is low.
+//
+static void
+model_lines(void)
+{
+    uint64_t ui64Time = g_sModel.ui64Time;
+
+    if (g_sModel.bWake && !g_sModel.bStatus && !g_sModel.bIrq &&
+        !g_sModel.bXfer && !g_sModel.ui64StatusRiseAt)
+    {
+        g_sModel.ui64StatusRiseAt = ui64Time + g_ui32WakeNs;
+    }
+    else if (!g_sModel.bWake || g_sModel.bIrq)
+    {
+        g_sModel.ui64StatusRiseAt = 0;
+    }
+
+    if (g_sModel.bStatus && !g_sModel.bXfer &&
+        (g_sModel.bWriteDone || !g_sModel.bWake) && !g_sModel.ui64StatusFallAt)
+    {
+        g_sModel.ui64StatusFallAt = ui64Time + STATUS_FALL_NS;
+    }
+
+    if (g_sModel.bRxPending && !g_sModel.bIrq && !g_sModel.bStatus &&
+        !g_sModel.bXfer && !g_sModel.ui64IrqFallAt)
+    {
+        g_sModel.bIrq = true;
+        BLEIF->INTSTAT |= BLEIF_INTSTAT_BLECIRQ_Msk;
+    }
+}
+
+static bool
+model_byte_ready(void)
+{
+    if (!g_sModel.bXfer)
+    {
+        return false;
+    }
+
+    if (g_sModel.ui32Cmd == AM_HAL_BLE_WRITE)
+    {
+        return g_sModel.ui32TxWords != 0;
+    }
+
+    return g_sModel.ui32RxWords < FIFO_WORDS;
+}
+
+static void
+model_xfer_end(void)
+{
+    g_sModel.bXfer = false;
+    BLEIF->INTSTAT |= BLEIF_INTSTAT_CMDCMP_Msk;
+
+    if (g_sModel.ui32Cmd == AM_HAL_BLE_WRITE)
+    {
+        g_sModel.bWriteDone = true;
+        g_sModel.ui32GotLength = g_sModel.ui32XferLen;
+        if (g_sModel.ui32TxWords)
+        {
+            g_sModel.ui32Errors++;
+        }
+        return;
+    }
+
+    model_rx_commit();
+
+    if (g_sModel.ui32RxPhase == 0)
+    {
+        g_sModel.ui32RxPhase = (g_sModel.ui32RxPos >= 2) ? 1 : 0;
+        g_sModel.ui32RxPos = 0;
+    }
+    else if (g_sModel.ui32RxPos == g_sModel.ui32RxLength)
+    {
+        g_sModel.bRxPending = false;
+        g_sModel.ui64IrqFallAt = g_sModel.ui64Time + IRQ_FALL_NS;
+    }
+}
+
+//
+// Clock one byte over the SPI.
+//
+static void
+model_byte(void)
+{
+    if (g_sModel.ui32Cmd == AM_HAL_BLE_WRITE)
+    {
+        fifo_word_t *psHead = &g_sModel.psTx[0];
+
+        if (g_sModel.ui32XferDone < MAX_PACKET + 4)
+        {
+            g_sModel.pui8Got[g_sModel.ui32XferDone] = psHead->ui32Data & 0xFF;
+        }
+        psHead->ui32Data >>= 8;
+        if (--psHead->ui32Valid == 0)
+        {
+            g_sModel.ui32TxWords--;
+            memmove(&g_sModel.psTx[0], &g_sModel.psTx[1], g_sModel.ui32TxWords * sizeof(fifo_word_t));
+        }
+    }
+    else
+    {
+        uint8_t ui8Byte = PAD_BYTE;
+
+        if (g_sModel.ui32RxPhase == 0)
+        {
+            if (g_sModel.ui32RxPos < 2)
+            {
+                ui8Byte = (g_sModel.ui32RxLength >> (8 * g_sModel.ui32RxPos)) & 0xFF;
+                g_sModel.ui32RxPos++;
+            }
+        }
+        else if (g_sModel.ui32RxPos < g_sModel.ui32RxLength)
+        {
+            ui8Byte = g_sModel.pui8RxPacket[g_sModel.ui32RxPos++];
+        }
+        else
+        {
+            g_sModel.ui32Errors++;
+        }
+
+        g_sModel.sRxPartial.ui32Data |= (uint32_t)ui8Byte << (8 * g_sModel.sRxPartial.ui32Valid);
+        if (++g_sModel.sRxPartial.ui32Valid == 4)
+        {
+            model_rx_commit();
+        }
+    }
+
+    g_sModel.ui64NextByteAt = g_sModel.ui64Time + BYTE_NS;
+    if (++g_sModel.ui32XferDone == g_sModel.ui32XferLen)
+    {
+        model_xfer_end();
+    }
+}
+
+//
+// Run the model up to the current time, one event at a time.
+//
+static void
+model_run(void)
+{
+    while (1)
+    {
+        uint64_t ui64Next = UINT64_MAX;
+        uint64_t ui64Byte = UINT64_MAX;
+
+        model_dma();
+        model_lines();
+
+        if (model_byte_ready())
+        {
+            ui64Byte = g_sModel.ui64NextByteAt > g_sModel.ui64Time ?
+                       g_sModel.ui64NextByteAt : g_sModel.ui64Time;
+            ui64Next = ui64Byte;
+        }
+        if (g_sModel.ui64StatusRiseAt && (g_sModel.ui64StatusRiseAt < ui64Next))
+        {
+            ui64Next = g_sModel.ui64StatusRiseAt;
+        }
+        if (g_sModel.ui64StatusFallAt && (g_sModel.ui64StatusFallAt < ui64Next))
+        {
+            ui64Next = g_sModel.ui64StatusFallAt;
+        }
+        if (g_sModel.ui64IrqFallAt && (g_sModel.ui64IrqFallAt < ui64Next))
+        {
+            ui64Next = g_sModel.ui64IrqFallAt;
+        }
+
+        if (ui64Next > g_ui64Now)
+        {
+            break;
+        }
+
+        g_sModel.ui64Time = ui64Next;
+
+        if (ui64Byte == ui64Next)
+        {
+            model_byte();
+        }
+        else if (g_sModel.ui64StatusRiseAt == ui64Next)
+        {
+            g_sModel.ui64StatusRiseAt = 0;
+            g_sModel.bStatus = true;
+            g_sModel.bWriteDone = false;
+            BLEIF->INTSTAT |= BLEIF_INTSTAT_BLECSSTAT_Msk;
+        }
+        else if (g_sModel.ui64StatusFallAt == ui64Next)
+        {
+            g_sModel.ui64StatusFallAt = 0;
+            g_sModel.bStatus = false;
+            g_sModel.bWriteDone = false;
+            g_sModel.ui64StatusFell = ui64Next;
+            BLEIF->INTSTAT |= BLEIF_INTSTAT_BLECSSTATN_Msk;
+        }
+        else
+        {
+            g_sModel.ui64IrqFallAt = 0;
+            g_sModel.bIrq = false;
+            g_sModel.ui64IrqFell = ui64Next;
+            BLEIF->INTSTAT |= BLEIF_INTSTAT_BLECIRQN_Msk;
+        }
+    }
+
+    g_sModel.ui64Time = g_ui64Now;
+}
+
+static void
+model_publish(void)
+{
+    BLEIF->FIFOPTR = _VAL2FLD(BLEIF_FIFOPTR_FIFO0SIZ, g_sModel.ui32TxWords * 4) |
+                     _VAL2FLD(BLEIF_FIFOPTR_FIFO0REM, (FIFO_WORDS - g_sModel.ui32TxWords) * 4) |
+                     _VAL2FLD(BLEIF_FIFOPTR_FIFO1SIZ, g_sModel.ui32RxWords * 4) |
+                     _VAL2FLD(BLEIF_FIFOPTR_FIFO1REM, (FIFO_WORDS - g_sModel.ui32RxWords) * 4);
+
+    BLEIF->BSTATUS = _VAL2FLD(BLEIF_BSTATUS_SPISTATUS, g_sModel.bStatus) |
+                     _VAL2FLD(BLEIF_BSTATUS_BLEIRQ, g_sModel.bIrq);
+
+    if (g_sModel.ui32RxWords)
+    {
+        g_sModel.ui32PopValue = g_sModel.psRx[0].ui32Data;
+        g_sModel.bPopPresented = true;
+    }
+    else
+    {
+        g_sModel.ui32PopValue = 0;
+        g_sModel.bPopPresented = false;
+    }
+    BLEIF->FIFOPOP = g_sModel.ui32PopValue;
+}
+
+static void
+model_update(void)
+{
+    model_apply();
+    model_run();
+    model_publish();
+}
+
+//
+// Called before every BLEIF access the HAL makes.
+//
+static void
+model_sync(void)
+{
+    g_ui64Now += REG_NS;
+    model_update();
+}
+
+//
+// Give the controller a packet for the host to read.
+//
+static void
+model_post_packet(uint32_t ui32Length)
+{
+    uint32_t i;
+
+    g_sModel.pui8RxPacket[0] = 0x04;
+    for (i = 1; i < ui32Length; i++)
+    {
+        g_sModel.pui8RxPacket[i] = rand_byte();
+    }
+
+    g_sModel.ui32RxLength = ui32Length;
+    g_sModel.ui32RxPhase = 0;
+    g_sModel.ui32RxPos = 0;
+    g_sModel.bRxPending = true;
+    model_update();
+}
+
+//*****************************************************************************
+//
+// Application: the BLE interrupt and the transfer callbacks, as the
+// nonblocking hci_drv_apollo3.c sets them up.  Reads start from the
+// interrupt, and a finished write raises WAKE again while more are queued.
+//
+//*****************************************************************************
+static void
+app_transfer_done(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
+{
+    (void)pui8Data;
+    (void)pvContext;
+
+    g_sApp.bDone = true;
+    g_sApp.ui64DoneAt = g_ui64Now;
+    g_sApp.bStatusAtDone = g_sModel.bStatus;
+    g_sApp.bIrqAtDone = g_sModel.bIrq;
+    g_sApp.ui32DoneLength = ui32Length;
+}
+
+static void
+app_write_done(uint8_t *pui8Data, uint32_t ui32Length, void *pvContext)
+{
+    if ((g_sModel.ui32GotLength != ui32Length) ||
+        memcmp(g_sModel.pui8Got, g_pui32TxBuffer, ui32Length))
+    {
+        g_sApp.ui32WritesBad++;
+    }
+
+    if (g_sApp.ui32WritesQueued && --g_sApp.ui32WritesQueued)
+    {
+        g_sApp.bWritePending = true;
+        am_hal_ble_wakeup_set(g_sApp.pvBle, 1);
+        return;
+    }
+
+    app_transfer_done(pui8Data, ui32Length, pvContext);
+}
+
+static void
+app_isr(void)
+{
+    uint32_t ui32Status = am_hal_ble_int_status(g_sApp.pvBle, true);
+
+    am_hal_ble_int_clear(g_sApp.pvBle, ui32Status);
+    CHECK(am_hal_ble_int_service(g_sApp.pvBle, ui32Status) == AM_HAL_STATUS_SUCCESS);
+
+    if (ui32Status & AM_HAL_BLE_INT_BLECIRQ)
+    {
+        am_hal_ble_wakeup_set(g_sApp.pvBle, 0);
+        CHECK(am_hal_ble_nonblocking_hci_read(g_sApp.pvBle, g_pui32RxBuffer,
+                                              app_transfer_done, 0) == AM_HAL_STATUS_SUCCESS);
+    }
+    else if ((ui32Status & AM_HAL_BLE_INT_BLECSSTAT) && g_sApp.bWritePending)
+    {
+        CHECK(am_hal_ble_nonblocking_hci_write(g_sApp.pvBle, AM_HAL_BLE_RAW,
+                                               g_pui32TxBuffer, g_sApp.ui32WriteLength,
+                                               app_write_done, 0) == AM_HAL_STATUS_SUCCESS);
+        g_sApp.bWritePending = false;
+    }
+}
+
+//
+// One idle CPU step, taking the BLE interrupt once its latency has passed.
+// Time spent in the interrupt counts as busy.
+//
+static void
+cpu_idle(void)
+{
+    g_ui64Now += IDLE_NS;
+    model_update();
+
+    if (BLEIF->INTSTAT & BLEIF->INTEN)
+    {
+        if (!g_sApp.bIrqPending)
+        {
+            g_sApp.bIrqPending = true;
+            g_sApp.ui64IrqAt = g_ui64Now + ISR_LATENCY_NS;
+        }
+
+        if (g_ui64Now >= g_sApp.ui64IrqAt)
+        {
+            uint64_t ui64Start = g_ui64Now;
+
+            g_sApp.bIrqPending = false;
+            app_isr();
+            g_sApp.ui64BusyNs += g_ui64Now - ui64Start;
+        }
+    }
+    else
+    {
+        g_sApp.bIrqPending = false;
+    }
+}
+
+static void
+cpu_idle_for(uint64_t ui64Ns)
+{
+    uint64_t ui64End = g_ui64Now + ui64Ns;
+
+    while (g_ui64Now < ui64End)
+    {
+        cpu_idle();
+    }
+}
+
+//
+// Idle until a flag or a line takes the given value.  False on timeout.
+//
+static bool
+cpu_idle_until(bool *pbFlag, bool bValue)
+{
+    uint64_t ui64End = g_ui64Now + PACKET_TIMEOUT_NS;
+
+    while (*pbFlag != bValue)
+    {
+        if (g_ui64Now >= ui64End)
+        {
+            return false;
+        }
+        cpu_idle();
+    }
+
+    return true;
+}
+
+static void
+ble_setup(bool bB0, bool bNonBlocking)
+{
+    am_hal_ble_state_t *pBle = g_sApp.pvBle;
+
+    model_reset();
+    model_set_chiprev(bB0);
+    memset(&pBle->sCurrentTransfer, 0, sizeof(pBle->sCurrentTransfer));
+    pBle->bPatchComplete = true;
+    pBle->bBusy = false;
+    pBle->bCmdComplete = false;
+    pBle->bDmaComplete = false;
+    pBle->bFlowControlComplete = false;
+    pBle->bLastPacketWasTX = false;
+    pBle->bHciReadLength = false;
+    pBle->ui32TransferIndex = 0;
+    g_sApp.bIrqPending = false;
+    g_sApp.bWritePending = false;
+    g_sApp.ui32WritesQueued = 0;
+    g_sApp.ui32WritesBad = 0;
+
+    if (bNonBlocking)
+    {
+        am_hal_ble_int_enable(g_sApp.pvBle, (AM_HAL_BLE_INT_CMDCMP |
+                                             AM_HAL_BLE_INT_DCMP |
+                                             AM_HAL_BLE_INT_BLECIRQ |
+                                             AM_HAL_BLE_INT_BLECSSTAT));
+        if (APOLLO3_GE_B0)
+        {
+            am_hal_ble_int_enable(g_sApp.pvBle, (AM_HAL_BLE_INT_BLECIRQN |
+                                                 AM_HAL_BLE_INT_BLECSSTATN));
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// One packet each way.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t    ui32Packets;
+    uint32_t    ui32Bad;
+    uint32_t    ui32EarlyDone;
+    uint64_t    ui64RoundTripNs;
+    uint64_t    ui64BusyNs;
+}
+xfer_result_t;
+
+static void
+fill_tx(void)
+{
+    uint8_t *pui8Tx = (uint8_t *)g_pui32TxBuffer;
+    uint32_t i;
+
+    pui8Tx[0] = 0x02;
+    for (i = 1; i < sizeof(g_pui32TxBuffer); i++)
+    {
+        pui8Tx[i] = rand_byte();
+    }
+}
+
+static void
+write_packet(bool bNonBlocking, uint32_t ui32Length, xfer_result_t *psResult)
+{
+    uint64_t ui64Start;
+    uint64_t ui64Fell = g_sModel.ui64StatusFell;
+    bool bOk = true;
+
+    fill_tx();
+    ui64Start = g_ui64Now;
+
+    if (bNonBlocking)
+    {
+        g_sApp.bDone = false;
+        g_sApp.ui64BusyNs = 0;
+        g_sApp.ui32WriteLength = ui32Length;
+        g_sApp.bWritePending = true;
+
+        am_hal_ble_wakeup_set(g_sApp.pvBle, 1);
+        g_sApp.ui64BusyNs += g_ui64Now - ui64Start;
+
+        bOk = cpu_idle_until(&g_sApp.bDone, true);
+        psResult->ui64RoundTripNs += g_sApp.ui64DoneAt - ui64Start;
+        psResult->ui64BusyNs += g_sApp.ui64BusyNs;
+
+        //
+        // Completion before STATUS has dropped leaves the bus to the caller
+        // to poll.
+        //
+        if (bOk && (g_sApp.bStatusAtDone || (g_sModel.ui64StatusFell == ui64Fell)))
+        {
+            psResult->ui32EarlyDone++;
+        }
+    }
+    else
+    {
+        bOk = am_hal_ble_blocking_hci_write(g_sApp.pvBle, AM_HAL_BLE_RAW,
+                                            g_pui32TxBuffer, ui32Length) == AM_HAL_STATUS_SUCCESS;
+        psResult->ui64RoundTripNs += g_ui64Now - ui64Start;
+        psResult->ui64BusyNs += g_ui64Now - ui64Start;
+    }
+
+    //
+    // Let STATUS settle before the next packet, as the driver's write
+    // callback does on parts without the falling-edge interrupt.
+    //
+    bOk = cpu_idle_until(&g_sModel.bStatus, false) && bOk;
+    cpu_idle_for(10000);
+
+    psResult->ui32Packets++;
+    if (!bOk || (g_sModel.ui32GotLength != ui32Length) ||
+        memcmp(g_sModel.pui8Got, g_pui32TxBuffer, ui32Length))
+    {
+        psResult->ui32Bad++;
+    }
+}
+
+static void
+read_packet(bool bNonBlocking, uint32_t ui32Length, xfer_result_t *psResult)
+{
+    uint64_t ui64Start;
+    uint64_t ui64Fell = g_sModel.ui64IrqFell;
+    uint32_t ui32Received = 0;
+    bool bOk = true;
+
+    memset(g_pui32RxBuffer, 0, sizeof(g_pui32RxBuffer));
+    model_post_packet(ui32Length);
+    ui64Start = g_ui64Now;
+
+    if (bNonBlocking)
+    {
+        g_sApp.bDone = false;
+        g_sApp.ui64BusyNs = 0;
+
+        bOk = cpu_idle_until(&g_sApp.bDone, true);
+        ui32Received = g_sApp.ui32DoneLength;
+        psResult->ui64RoundTripNs += g_sApp.ui64DoneAt - ui64Start;
+        psResult->ui64BusyNs += g_sApp.ui64BusyNs;
+
+        if (bOk && (g_sApp.bIrqAtDone || (g_sModel.ui64IrqFell == ui64Fell)))
+        {
+            psResult->ui32EarlyDone++;
+        }
+    }
+    else
+    {
+        bOk = am_hal_ble_blocking_hci_read(g_sApp.pvBle, g_pui32RxBuffer,
+                                           &ui32Received) == AM_HAL_STATUS_SUCCESS;
+        psResult->ui64RoundTripNs += g_ui64Now - ui64Start;
+        psResult->ui64BusyNs += g_ui64Now - ui64Start;
+    }
+
+    bOk = cpu_idle_until(&g_sModel.bIrq, false) && bOk;
+    cpu_idle_for(10000);
+
+    psResult->ui32Packets++;
+    if (!bOk || (ui32Received != ui32Length) ||
+        memcmp(g_pui32RxBuffer, g_sModel.pui8RxPacket, ui32Length))
+    {
+        psResult->ui32Bad++;
+    }
+}
+
+static void
+run_packets(bool bB0, bool bNonBlocking, bool bWrite, uint32_t ui32Length,
+            uint32_t ui32Count, xfer_result_t *psResult)
+{
+    uint32_t i;
+
+    memset(psResult, 0, sizeof(*psResult));
+    ble_setup(bB0, bNonBlocking);
+
+    for (i = 0; i < ui32Count; i++)
+    {
+        uint32_t ui32Len = ui32Length ? ui32Length : 4 + rand_next() % (MAX_PACKET - 4);
+
+        if (bWrite)
+        {
+            write_packet(bNonBlocking, ui32Len, psResult);
+        }
+        else
+        {
+            read_packet(bNonBlocking, ui32Len, psResult);
+        }
+    }
+
+    CHECK(psResult->ui32Bad == 0);
+    CHECK(g_sModel.ui32Errors == 0);
+}
+
+static double
+per_packet_us(uint64_t ui64Ns, const xfer_result_t *psResult)
+{
+    return (double)ui64Ns / 1000.0 / psResult->ui32Packets;
+}
+
+//*****************************************************************************
+//
+// Tests
+//
+//*****************************************************************************
+static void
+test_sizes(uint32_t ui32Count)
+{
+    static const uint32_t pui32Sizes[] = {8, 32, 64, 128, 251};
+    uint32_t i, ui32Dir;
+
+    printf("per packet, B0, WAKE to STATUS %u us:\n", (unsigned)(g_ui32WakeNs / 1000));
+    printf("  dir    bytes  blocking rtt/busy us  nonblocking rtt/busy us\n");
+
+    for (ui32Dir = 0; ui32Dir < 2; ui32Dir++)
+    {
+        for (i = 0; i < sizeof(pui32Sizes) / sizeof(pui32Sizes[0]); i++)
+        {
+            xfer_result_t sBlock, sNonBlock;
+            bool bWrite = (ui32Dir == 0);
+
+            run_packets(true, false, bWrite, pui32Sizes[i], ui32Count, &sBlock);
+            run_packets(true, true, bWrite, pui32Sizes[i], ui32Count, &sNonBlock);
+
+            printf("  %-5s  %5u  %9.1f / %-9.1f  %11.1f / %-9.1f\n",
+                   bWrite ? "write" : "read", (unsigned)pui32Sizes[i],
+                   per_packet_us(sBlock.ui64RoundTripNs, &sBlock),
+                   per_packet_us(sBlock.ui64BusyNs, &sBlock),
+                   per_packet_us(sNonBlock.ui64RoundTripNs, &sNonBlock),
+                   per_packet_us(sNonBlock.ui64BusyNs, &sNonBlock));
+
+            //
+            // The blocking calls hold the CPU for the whole transfer.  The
+            // nonblocking ones only cost the interrupt work, whatever the
+            // packet size, and less than the blocking transfer of the 2-byte
+            // length alone; the DMA path adds no more than the interrupt
+            // latency to the round trip.
+            //
+            CHECK(sBlock.ui64BusyNs == sBlock.ui64RoundTripNs);
+            CHECK(sBlock.ui64BusyNs > pui32Sizes[i] * BYTE_NS * ui32Count);
+            CHECK(per_packet_us(sNonBlock.ui64BusyNs, &sNonBlock) < 5.0);
+            CHECK(sNonBlock.ui64RoundTripNs < sBlock.ui64RoundTripNs +
+                                              (uint64_t)ui32Count * RTT_SLACK_NS);
+            CHECK(sNonBlock.ui32EarlyDone == 0);
+        }
+    }
+}
+
+static void
+test_random(uint32_t ui32Count)
+{
+    xfer_result_t sWrite, sRead;
+
+    run_packets(true, true, true, 0, ui32Count, &sWrite);
+    run_packets(true, true, false, 0, ui32Count, &sRead);
+
+    printf("random 4..255 byte packets, nonblocking: write %.1f / %.1f us, read %.1f / %.1f us\n",
+           per_packet_us(sWrite.ui64RoundTripNs, &sWrite), per_packet_us(sWrite.ui64BusyNs, &sWrite),
+           per_packet_us(sRead.ui64RoundTripNs, &sRead), per_packet_us(sRead.ui64BusyNs, &sRead));
+
+    CHECK(sWrite.ui32EarlyDone == 0);
+    CHECK(sRead.ui32EarlyDone == 0);
+}
+
+//
+// Packets queued back to back: each finished write raises WAKE for the next
+// one from the interrupt, so a queue drains at the single-packet rate.
+//
+static void
+test_queued_writes(uint32_t ui32Count)
+{
+    xfer_result_t sSingle;
+    uint64_t ui64Start;
+    bool bOk;
+
+    run_packets(true, true, true, 64, ui32Count, &sSingle);
+
+    ble_setup(true, true);
+    fill_tx();
+    ui64Start = g_ui64Now;
+    g_sApp.bDone = false;
+    g_sApp.ui64BusyNs = 0;
+    g_sApp.ui32WriteLength = 64;
+    g_sApp.ui32WritesQueued = ui32Count;
+    g_sApp.bWritePending = true;
+    am_hal_ble_wakeup_set(g_sApp.pvBle, 1);
+
+    bOk = cpu_idle_until(&g_sApp.bDone, true);
+
+    printf("%u queued 64 byte writes: %.1f us each, %.1f us busy\n", (unsigned)ui32Count,
+           (double)(g_sApp.ui64DoneAt - ui64Start) / 1000.0 / ui32Count,
+           (double)g_sApp.ui64BusyNs / 1000.0 / ui32Count);
+
+    CHECK(bOk);
+    CHECK(g_sApp.ui32WritesQueued == 0);
+    CHECK(g_sApp.ui32WritesBad == 0);
+    CHECK(g_sModel.ui32Errors == 0);
+    CHECK(g_sApp.ui64DoneAt - ui64Start < sSingle.ui64RoundTripNs + (uint64_t)ui32Count * RTT_SLACK_NS);
+}
+
+//
+// A zero length ends the read with nothing more on the bus.
+//
+static void
+test_bad_length(void)
+{
+    bool bOk;
+
+    ble_setup(true, true);
+    g_sApp.bDone = false;
+    g_sApp.ui32DoneLength = 1;
+    model_post_packet(0);
+
+    bOk = cpu_idle_until(&g_sApp.bDone, true);
+
+    CHECK(bOk);
+    CHECK(g_sApp.ui32DoneLength == 0);
+    CHECK(g_sModel.ui32Errors == 0);
+    CHECK(!((am_hal_ble_state_t *)g_sApp.pvBle)->bBusy);
+}
+
+//
+// Parts before B0 have no falling-edge interrupts, so the HAL reports a
+// nonblocking transfer complete while STATUS or IRQ may still be high; the
+// driver's write and read callbacks poll for them on those parts only.  IRQ
+// drops within the interrupt latency in this model, so only writes are
+// expected to complete early.
+//
+static void
+test_pre_b0(uint32_t ui32Count)
+{
+    xfer_result_t sWrite, sRead;
+
+    run_packets(false, true, true, 64, ui32Count, &sWrite);
+    run_packets(false, true, false, 64, ui32Count, &sRead);
+
+    printf("A1, 64 byte packets: %u of %u writes and %u of %u reads complete before the line drops\n",
+           (unsigned)sWrite.ui32EarlyDone, (unsigned)sWrite.ui32Packets,
+           (unsigned)sRead.ui32EarlyDone, (unsigned)sRead.ui32Packets);
+
+    CHECK(sWrite.ui32EarlyDone == sWrite.ui32Packets);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Count = 50;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Count = strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                g_ui32WakeNs = strtoul(optarg, NULL, 0) * 1000;
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n packets per run] [-w wake to status us] [-s seed]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    host_regs_map(BLEIF_BASE, BLEIF_REGS_SIZE);
+    host_regs_map(MCUCTRL_BASE, MCUCTRL_REGS_SIZE);
+    CHECK(am_hal_ble_initialize(0, &g_sApp.pvBle) == AM_HAL_STATUS_SUCCESS);
+
+    test_sizes(ui32Count);
+    test_random(ui32Count * 4);
+    test_queued_writes(ui32Count);
+    test_bad_length();
+    test_pre_b0(ui32Count);
+
+    return host_test_result();
+}
@@ -0,0 +1,691 @@
+//*****************************************************************************
+//
+//! @file burst_governor_test.c
+//!
+//! @brief Trace replay simulation of the burst mode governor.
+//!
+//! Replays a workload trace on a simulated single core that runs 48 cycles
+//! per microsecond in normal mode and 96 in burst mode, once with the core
+//! held in normal mode, once held in burst mode and once under
+//! am_util_burst_governor, and reports average current and job latency for
+//! each.  Jobs marked as compute regions run inside region_enter/exit, and
+//! the load over each window is reported with load_update.
+//!
+//! Without -t a trace is generated: a 4096 point FFT every 43.7 ms, random
+//! background jobs, and a two second stretch of heavy background load.  On
+//! that trace the governor must run every compute region at 96 MHz, use less
+//! charge than running in burst mode throughout, and switch to burst mode
+//! under the heavy load.  Its mode accounting is checked against the
+//! simulation, and a run with failing mode switches and a dwell time check
+//! exercise the rest of the API.
+//!
+//! Trace files hold one job per line: arrival time in microseconds, cycles,
+//! and 1 if the job is a compute region.  '#' starts a comment.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "am_util_burst_governor.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define MAX_JOBS                    200000
+
+//
+// Core speed in cycles per microsecond.
+//
+#define NORMAL_CYCLES_PER_US        48
+#define BURST_CYCLES_PER_US         96
+
+//
+// Supply current in microamps.  Burst mode raises the core voltage, so it
+// costs more per cycle while running and keeps a higher floor while the
+// core sleeps.  These are round numbers for comparing policies, not
+// datasheet values; override them with -c.
+//
+static uint32_t g_ui32NormalRunUA = 300;
+static uint32_t g_ui32BurstRunUA = 900;
+static uint32_t g_ui32NormalSleepUA = 5;
+static uint32_t g_ui32BurstSleepUA = 60;
+
+//
+// Load window, and the start of the simulated time base so that the 32-bit
+// governor time wraps during the run.
+//
+#define WINDOW_US                   10000
+#define TIME_BASE_START             0xFFF00000
+
+//
+// Generated trace.
+//
+#define GEN_DURATION_US             10000000
+#define GEN_FFT_PERIOD_US           43690
+#define GEN_FFT_CYCLES              600000
+#define GEN_HEAVY_START_US          4000000
+#define GEN_HEAVY_END_US            6000000
+
+//*****************************************************************************
+//
+// Types
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Arrival;
+    uint32_t ui32Cycles;
+    bool     bRegion;
+}
+job_t;
+
+typedef enum
+{
+    POLICY_NORMAL,
+    POLICY_BURST,
+    POLICY_GOVERNOR,
+}
+policy_e;
+
+typedef struct
+{
+    uint64_t ui64ChargeUAUS;
+    uint64_t ui64BurstUS;
+    uint64_t ui64HeavyBurstUS;
+    uint64_t ui64RegionNormalCycles;
+    uint64_t ui64LatencySum[2];
+    uint32_t ui32LatencyMax[2];
+    uint32_t ui32Jobs[2];
+    uint32_t ui32RegionsEntered;
+    uint32_t ui32ModeMismatches;
+    uint32_t ui32Duration;
+}
+result_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static const char *g_pcPolicyName[] = { "normal", "burst", "governor" };
+
+static job_t g_psJobs[MAX_JOBS];
+static uint32_t g_ui32NumJobs;
+
+//
+// Simulated time and burst mode.
+//
+static uint32_t g_ui32Now;
+static bool g_bBurst;
+
+//
+// When non-zero, every Nth mode switch fails.
+//
+static uint32_t g_ui32FailEvery;
+static uint32_t g_ui32Switches;
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the governor links against.
+//
+//*****************************************************************************
+uint32_t
+am_hal_burst_mode_initialize(am_hal_burst_avail_e *peBurstAvail)
+{
+    *peBurstAvail = AM_HAL_BURST_AVAIL;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static uint32_t
+burst_switch(bool bBurst, am_hal_burst_mode_e *peBurstStatus)
+{
+    if (g_ui32FailEvery && (++g_ui32Switches % g_ui32FailEvery) == 0)
+    {
+        *peBurstStatus = g_bBurst ? AM_HAL_BURST_MODE : AM_HAL_NORMAL_MODE;
+        return AM_HAL_STATUS_FAIL;
+    }
+
+    g_bBurst = bBurst;
+    *peBurstStatus = g_bBurst ? AM_HAL_BURST_MODE : AM_HAL_NORMAL_MODE;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_burst_mode_enable(am_hal_burst_mode_e *peBurstStatus)
+{
+    return burst_switch(true, peBurstStatus);
+}
+
+uint32_t
+am_hal_burst_mode_disable(am_hal_burst_mode_e *peBurstStatus)
+{
+    return burst_switch(false, peBurstStatus);
+}
+
+static uint32_t
+time_get(void)
+{
+    return g_ui32Now;
+}
+
+//*****************************************************************************
+//
+// Traces.
+//
+//*****************************************************************************
+static void
+job_add(uint32_t ui32Arrival, uint32_t ui32Cycles, bool bRegion)
+{
+    if (g_ui32NumJobs < MAX_JOBS)
+    {
+        g_psJobs[g_ui32NumJobs++] = (job_t) { ui32Arrival, ui32Cycles, bRegion };
+    }
+}
+
+static int
+job_compare(const void *pvA, const void *pvB)
+{
+    const job_t *psA = pvA;
+    const job_t *psB = pvB;
+
+    return (psA->ui32Arrival > psB->ui32Arrival) - (psA->ui32Arrival < psB->ui32Arrival);
+}
+
+static void
+trace_generate(void)
+{
+    uint32_t t;
+
+    g_ui32NumJobs = 0;
+
+    for (t = 1000; t < GEN_DURATION_US; t += GEN_FFT_PERIOD_US)
+    {
+        job_add(t, GEN_FFT_CYCLES, true);
+    }
+
+    //
+    // Background work: on average a 110k cycle job every 5 ms, or a 40k
+    // cycle job every 0.9 ms during the heavy stretch.
+    //
+    for (t = 0; t < GEN_DURATION_US; )
+    {
+        bool bHeavy = (t >= GEN_HEAVY_START_US) && (t < GEN_HEAVY_END_US);
+
+        if (bHeavy)
+        {
+            job_add(t, 30000 + rand_next() % 20000, false);
+            t += 400 + rand_next() % 1000;
+        }
+        else
+        {
+            job_add(t, 20000 + rand_next() % 180000, false);
+            t += 1000 + rand_next() % 8000;
+        }
+    }
+
+    qsort(g_psJobs, g_ui32NumJobs, sizeof(job_t), job_compare);
+}
+
+static bool
+trace_read(const char *pcFile)
+{
+    FILE *pFile = fopen(pcFile, "r");
+    char pcLine[128];
+
+    if (pFile == NULL)
+    {
+        perror(pcFile);
+        return false;
+    }
+
+    g_ui32NumJobs = 0;
+    while (fgets(pcLine, sizeof(pcLine), pFile))
+    {
+        unsigned uArrival, uCycles, uRegion = 0;
+        char *pcComment = strchr(pcLine, '#');
+
+        if (pcComment)
+        {
+            *pcComment = '\0';
+        }
+        if (sscanf(pcLine, "%u %u %u", &uArrival, &uCycles, &uRegion) >= 2)
+        {
+            job_add(uArrival, uCycles, uRegion != 0);
+        }
+    }
+    fclose(pFile);
+
+    qsort(g_psJobs, g_ui32NumJobs, sizeof(job_t), job_compare);
+    return g_ui32NumJobs != 0;
+}
+
+static void
+trace_write(const char *pcFile)
+{
+    FILE *pFile = fopen(pcFile, "w");
+
+    if (pFile == NULL)
+    {
+        perror(pcFile);
+        return;
+    }
+
+    fprintf(pFile, "# arrival_us cycles region\n");
+    for (uint32_t i = 0; i < g_ui32NumJobs; i++)
+    {
+        fprintf(pFile, "%u %u %u\n", (unsigned)g_psJobs[i].ui32Arrival,
+                (unsigned)g_psJobs[i].ui32Cycles, g_psJobs[i].bRegion ? 1u : 0u);
+    }
+    fclose(pFile);
+}
+
+//*****************************************************************************
+//
+// Replay the trace under one policy, a microsecond at a time.  Jobs run to
+// completion in arrival order.
+//
+//*****************************************************************************
+static void
+simulate(policy_e ePolicy, result_t *psResult)
+{
+    am_util_burst_governor_config_t sConfig =
+    {
+        .pfnTimeGet = time_get,
+        .ui32LoadHighPct = 80,
+        .ui32LoadLowPct = 30,
+        .ui32QueueHigh = 4,
+        .ui32DwellTicks = 20000,
+    };
+    uint32_t ui32Next = 0;          // Next job to arrive.
+    uint32_t ui32Head = 0;          // Job running, or next to run.
+    uint32_t ui32Remaining = 0;
+    bool bStarted = false;
+    uint32_t ui32WindowBusy = 0;
+    uint32_t t;
+
+    memset(psResult, 0, sizeof(*psResult));
+    g_ui32Now = TIME_BASE_START;
+    g_ui32Switches = 0;
+    g_bBurst = (ePolicy == POLICY_BURST);
+
+    if (ePolicy == POLICY_GOVERNOR)
+    {
+        CHECK(am_util_burst_governor_init(&sConfig) == AM_HAL_STATUS_SUCCESS);
+    }
+
+    for (t = 0; ui32Head < g_ui32NumJobs; t++)
+    {
+        bool bBusy = false;
+
+        while ((ui32Next < g_ui32NumJobs) && (g_psJobs[ui32Next].ui32Arrival <= t))
+        {
+            ui32Next++;
+        }
+
+        if (ui32Head < ui32Next)
+        {
+            const job_t *psJob = &g_psJobs[ui32Head];
+
+            if (!bStarted)
+            {
+                bStarted = true;
+                ui32Remaining = psJob->ui32Cycles;
+                if (psJob->bRegion && (ePolicy == POLICY_GOVERNOR))
+                {
+                    am_util_burst_governor_region_enter();
+                    psResult->ui32RegionsEntered++;
+                }
+            }
+
+            if (psJob->bRegion && !g_bBurst)
+            {
+                psResult->ui64RegionNormalCycles +=
+                    ui32Remaining < NORMAL_CYCLES_PER_US ? ui32Remaining : NORMAL_CYCLES_PER_US;
+            }
+
+            bBusy = true;
+            ui32Remaining -= ui32Remaining < (g_bBurst ? BURST_CYCLES_PER_US : NORMAL_CYCLES_PER_US) ?
+                             ui32Remaining : (g_bBurst ? BURST_CYCLES_PER_US : NORMAL_CYCLES_PER_US);
+        }
+
+        //
+        // Account this microsecond.
+        //
+        if (g_bBurst)
+        {
+            psResult->ui64ChargeUAUS += bBusy ? g_ui32BurstRunUA : g_ui32BurstSleepUA;
+            psResult->ui64BurstUS++;
+            if ((t >= GEN_HEAVY_START_US) && (t < GEN_HEAVY_END_US))
+            {
+                psResult->ui64HeavyBurstUS++;
+            }
+        }
+        else
+        {
+            psResult->ui64ChargeUAUS += bBusy ? g_ui32NormalRunUA : g_ui32NormalSleepUA;
+        }
+        ui32WindowBusy += bBusy;
+        g_ui32Now++;
+
+        if (bBusy && (ui32Remaining == 0))
+        {
+            const job_t *psJob = &g_psJobs[ui32Head];
+            uint32_t ui32Latency = t + 1 - psJob->ui32Arrival;
+
+            if (psJob->bRegion && (ePolicy == POLICY_GOVERNOR))
+            {
+                am_util_burst_governor_region_exit();
+            }
+
+            psResult->ui64LatencySum[psJob->bRegion] += ui32Latency;
+            psResult->ui32Jobs[psJob->bRegion]++;
+            if (ui32Latency > psResult->ui32LatencyMax[psJob->bRegion])
+            {
+                psResult->ui32LatencyMax[psJob->bRegion] = ui32Latency;
+            }
+
+            ui32Head++;
+            bStarted = false;
+        }
+
+        if (((t + 1) % WINDOW_US) == 0)
+        {
+            if (ePolicy == POLICY_GOVERNOR)
+            {
+                am_util_burst_governor_load_update(ui32WindowBusy, WINDOW_US,
+                                                   ui32Next - ui32Head);
+            }
+            ui32WindowBusy = 0;
+        }
+
+        if ((ePolicy == POLICY_GOVERNOR) && (am_util_burst_governor_active() != g_bBurst))
+        {
+            psResult->ui32ModeMismatches++;
+        }
+    }
+
+    psResult->ui32Duration = t;
+}
+
+static void
+result_print(policy_e ePolicy, const result_t *psResult)
+{
+    printf("%-9s %8.1f uA avg  %5.1f%% burst  region latency %7.1f us avg %7u max"
+           "  other %7.1f us avg %7u max\n",
+           g_pcPolicyName[ePolicy],
+           (double)psResult->ui64ChargeUAUS / psResult->ui32Duration,
+           100.0 * psResult->ui64BurstUS / psResult->ui32Duration,
+           psResult->ui32Jobs[1] ? (double)psResult->ui64LatencySum[1] / psResult->ui32Jobs[1] : 0.0,
+           (unsigned)psResult->ui32LatencyMax[1],
+           psResult->ui32Jobs[0] ? (double)psResult->ui64LatencySum[0] / psResult->ui32Jobs[0] : 0.0,
+           (unsigned)psResult->ui32LatencyMax[0]);
+}
+
+//*****************************************************************************
+//
+// Compare the governor's own accounting with the simulation.
+//
+//*****************************************************************************
+static void
+check_governor(const result_t *psResult)
+{
+    am_util_burst_governor_stats_t sStats;
+    uint32_t ui32Regions = 0;
+
+    for (uint32_t i = 0; i < g_ui32NumJobs; i++)
+    {
+        ui32Regions += g_psJobs[i].bRegion;
+    }
+
+    am_util_burst_governor_stats_get(&sStats);
+
+    CHECK(psResult->ui32ModeMismatches == 0);
+    CHECK(psResult->ui32RegionsEntered == ui32Regions);
+    CHECK(sStats.ui32RegionEntries == ui32Regions);
+    CHECK(sStats.ui64BurstTicks == psResult->ui64BurstUS);
+    CHECK(sStats.ui64BurstTicks + sStats.ui64NormalTicks == psResult->ui32Duration);
+}
+
+//*****************************************************************************
+//
+// Replay the trace under each policy and compare them.
+//
+//*****************************************************************************
+static void
+test_replay(bool bGenerated)
+{
+    result_t sResult[3];
+
+    for (uint32_t p = POLICY_NORMAL; p <= POLICY_GOVERNOR; p++)
+    {
+        simulate(p, &sResult[p]);
+        result_print(p, &sResult[p]);
+    }
+
+    check_governor(&sResult[POLICY_GOVERNOR]);
+    CHECK(sResult[POLICY_GOVERNOR].ui64RegionNormalCycles == 0);
+
+    if (bGenerated)
+    {
+        uint64_t ui64RegionLatency[3];
+
+        for (uint32_t p = POLICY_NORMAL; p <= POLICY_GOVERNOR; p++)
+        {
+            ui64RegionLatency[p] = sResult[p].ui64LatencySum[1] / sResult[p].ui32Jobs[1];
+        }
+
+        //
+        // Compute regions finish about as fast as in burst mode, at less
+        // charge than burst mode throughout.
+        //
+        CHECK(ui64RegionLatency[POLICY_GOVERNOR] < ui64RegionLatency[POLICY_NORMAL]);
+        CHECK(ui64RegionLatency[POLICY_GOVERNOR] * 10 <= ui64RegionLatency[POLICY_BURST] * 12);
+        CHECK(sResult[POLICY_GOVERNOR].ui64ChargeUAUS < sResult[POLICY_BURST].ui64ChargeUAUS);
+
+        //
+        // The heavy stretch runs mostly in burst mode.
+        //
+        CHECK(sResult[POLICY_GOVERNOR].ui64HeavyBurstUS * 2 >
+              GEN_HEAVY_END_US - GEN_HEAVY_START_US);
+    }
+}
+
+//*****************************************************************************
+//
+// Failed mode switches are counted and the governor reports the mode the
+// HAL is actually in.
+//
+//*****************************************************************************
+static void
+test_failures(void)
+{
+    am_util_burst_governor_stats_t sStats;
+    result_t sResult;
+
+    g_ui32FailEvery = 7;
+    simulate(POLICY_GOVERNOR, &sResult);
+    g_ui32FailEvery = 0;
+
+    am_util_burst_governor_stats_get(&sStats);
+    CHECK(sStats.ui32Failures > 0);
+    CHECK(sResult.ui32ModeMismatches == 0);
+    CHECK(sStats.ui64BurstTicks == sResult.ui64BurstUS);
+}
+
+//*****************************************************************************
+//
+// A load that swings across both thresholds every window switches at most
+// once per dwell time, and regions are not held back by it.
+//
+//*****************************************************************************
+static void
+test_dwell(void)
+{
+    am_util_burst_governor_config_t sConfig =
+    {
+        .pfnTimeGet = time_get,
+        .ui32LoadHighPct = 80,
+        .ui32LoadLowPct = 30,
+        .ui32QueueHigh = 0,
+        .ui32DwellTicks = 50000,
+    };
+    am_util_burst_governor_stats_t sStats;
+
+    g_ui32Now = TIME_BASE_START;
+    g_bBurst = false;
+    CHECK(am_util_burst_governor_init(&sConfig) == AM_HAL_STATUS_SUCCESS);
+
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        g_ui32Now += WINDOW_US;
+        CHECK(am_util_burst_governor_load_update((i & 1) ? 0 : WINDOW_US,
+                                                 WINDOW_US, 0) == AM_HAL_STATUS_SUCCESS);
+    }
+
+    am_util_burst_governor_stats_get(&sStats);
+    CHECK(sStats.ui32BurstEntries <= (1000 * WINDOW_US) / (2 * sConfig.ui32DwellTicks) + 1);
+    CHECK(sStats.ui32BurstEntries > 0);
+
+    //
+    // Straight after a switch, a region still gets burst mode at once, and
+    // leaving it returns to normal mode at once.
+    //
+    CHECK(am_util_burst_governor_load_update(0, WINDOW_US, 0) == AM_HAL_STATUS_SUCCESS);
+    while (am_util_burst_governor_active())
+    {
+        g_ui32Now += WINDOW_US;
+        am_util_burst_governor_load_update(0, WINDOW_US, 0);
+    }
+    CHECK(am_util_burst_governor_region_enter() == AM_HAL_STATUS_SUCCESS);
+    CHECK(g_bBurst && am_util_burst_governor_active());
+    CHECK(am_util_burst_governor_region_exit() == AM_HAL_STATUS_SUCCESS);
+    CHECK(!g_bBurst && !am_util_burst_governor_active());
+    CHECK(am_util_burst_governor_region_exit() == AM_HAL_STATUS_INVALID_OPERATION);
+
+    CHECK(am_util_burst_governor_load_update(2, 1, 0) == AM_HAL_STATUS_INVALID_ARG);
+    CHECK(am_util_burst_governor_load_update(0, 0, 0) == AM_HAL_STATUS_INVALID_ARG);
+    sConfig.ui32LoadLowPct = 80;
+    CHECK(am_util_burst_governor_init(&sConfig) == AM_HAL_STATUS_INVALID_ARG);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    const char *pcTrace = NULL;
+    const char *pcOut = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:o:s:c:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                pcTrace = optarg;
+                break;
+            case 'o':
+                pcOut = optarg;
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            case 'c':
+                if (sscanf(optarg, "%u,%u,%u,%u", &g_ui32NormalRunUA, &g_ui32BurstRunUA,
+                           &g_ui32NormalSleepUA, &g_ui32BurstSleepUA) == 4)
+                {
+                    break;
+                }
+                // fall through
+            default:
+                fprintf(stderr, "usage: %s [-t trace] [-o trace_out] [-s seed]"
+                        " [-c normal_run,burst_run,normal_sleep,burst_sleep uA]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (pcTrace)
+    {
+        if (!trace_read(pcTrace))
+        {
+            fprintf(stderr, "%s: no jobs\n", pcTrace);
+            return 2;
+        }
+    }
+    else
+    {
+        trace_generate();
+    }
+
+    if (pcOut)
+    {
+        trace_write(pcOut);
+    }
+
+    printf("%u jobs\n", (unsigned)g_ui32NumJobs);
+    test_replay(pcTrace == NULL);
+    test_failures();
+    test_dwell();
+
+    return host_test_result();
+}
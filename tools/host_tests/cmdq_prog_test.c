@@ -0,0 +1,251 @@
+//*****************************************************************************
+//
+//! @file cmdq_prog_test.c
+//!
+//! @brief Host test of the Command Queue program builder.
+//!
+//!
+//! Builds the ping-pong programs of the mspi_iom_transfer example (MSPI fills
+//! a buffer then signals the IOM, the IOM waits for it, writes it out and
+//! hands it back) with am_hal_cmdq_prog_*() and checks the entries: gates
+//! and signals, the exit slot, loops, the sizing pass and latched errors.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define TEST_MAX_ENTRIES            64
+
+//
+// Host pointers are truncated the same way the builder truncates them.
+//
+#define ADDR(p)                     ((uint32_t)(uintptr_t)(p))
+
+//
+// Flags as used by the mspi_iom_transfer example.
+//
+#define IOM_SIGNAL_MSPI_BUFFER0     (_VAL2FLD(IOM0_CQPAUSEEN_CQPEN, IOM0_CQPAUSEEN_CQPEN_SWFLAGEN0) << 8)
+#define IOM_WAIT_FOR_MSPI_BUFFER0   (_VAL2FLD(IOM0_CQPAUSEEN_CQPEN, IOM0_CQPAUSEEN_CQPEN_MSPI0XNOREN))
+#define MSPI_SIGNAL_IOM_BUFFER0     (MSPI_CQFLAGS_CQFLAGS_SWFLAG0 << 8)
+#define MSPI_WAIT_FOR_IOM_BUFFER0   (_VAL2FLD(MSPI_CQFLAGS_CQFLAGS, MSPI_CQFLAGS_CQFLAGS_IOM0READY))
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static uint32_t g_pui32Buffer[64];
+
+//*****************************************************************************
+//
+// HAL entry points referenced by am_hal_cmdq.c.
+//
+//*****************************************************************************
+void
+am_hal_flash_delay(uint32_t ui32Iterations)
+{
+    (void)ui32Iterations;
+}
+
+uint32_t
+am_hal_flash_delay_status_change(uint32_t ui32Iterations, uint32_t ui32Address,
+                                 uint32_t ui32Mask, uint32_t ui32Value)
+{
+    (void)ui32Iterations;
+    (void)ui32Address;
+    (void)ui32Mask;
+    (void)ui32Value;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static bool
+entry_is(const am_hal_cmdq_entry_t *pEntry, volatile uint32_t *pReg, uint32_t ui32Value)
+{
+    return (pEntry->address == ADDR(pReg)) && (pEntry->value == ui32Value);
+}
+
+//*****************************************************************************
+//
+// IOM block of the example: gate on the MSPI flag, DMA the buffer out,
+// signal MSPI.  Returns the exit slot.
+//
+//*****************************************************************************
+static uint32_t *
+build_iom(am_hal_cmdq_prog_t *pProg, am_hal_cmdq_entry_t *pBuf, uint32_t ui32Max)
+{
+    am_hal_cmdq_prog_init(pProg, AM_HAL_CMDQ_IF_IOM1, pBuf, ui32Max);
+    am_hal_cmdq_prog_wait(pProg, AM_HAL_IOM_PAUSE_FLAG_CQ | IOM_WAIT_FOR_MSPI_BUFFER0);
+    am_hal_cmdq_prog_write(pProg, ADDR(&IOM1->DMATOTCOUNT), 256);
+    am_hal_cmdq_prog_write(pProg, ADDR(&IOM1->DMATARGADDR), ADDR(g_pui32Buffer));
+    am_hal_cmdq_prog_signal(pProg, IOM_SIGNAL_MSPI_BUFFER0);
+    return am_hal_cmdq_prog_exit(pProg);
+}
+
+static void
+test_iom_program(void)
+{
+    am_hal_cmdq_entry_t sBuf[TEST_MAX_ENTRIES];
+    am_hal_cmdq_prog_t sProg;
+    uint32_t ui32Needed, ui32Used;
+    uint32_t *pui32Exit;
+
+    //
+    // Sizing pass.
+    //
+    CHECK(build_iom(&sProg, NULL, 0) == NULL);
+    CHECK(am_hal_cmdq_prog_end(&sProg, &ui32Needed) == AM_HAL_STATUS_SUCCESS);
+    CHECK(ui32Needed == 6);
+
+    memset(sBuf, 0xA5, sizeof(sBuf));
+    pui32Exit = build_iom(&sProg, sBuf, ui32Needed);
+    CHECK(am_hal_cmdq_prog_end(&sProg, &ui32Used) == AM_HAL_STATUS_SUCCESS);
+    CHECK(ui32Used == ui32Needed);
+
+    //
+    // The gate enables the flag with the index pause, then drops back to the
+    // index pause alone.
+    //
+    CHECK(entry_is(&sBuf[0], &IOM1->CQPAUSEEN,
+                   AM_HAL_IOM_PAUSE_FLAG_IDX | AM_HAL_IOM_PAUSE_FLAG_CQ | IOM_WAIT_FOR_MSPI_BUFFER0));
+    CHECK(entry_is(&sBuf[1], &IOM1->CQPAUSEEN, AM_HAL_IOM_PAUSE_FLAG_IDX));
+    CHECK(entry_is(&sBuf[2], &IOM1->DMATOTCOUNT, 256));
+    CHECK(entry_is(&sBuf[3], &IOM1->DMATARGADDR, ADDR(g_pui32Buffer)));
+    CHECK(entry_is(&sBuf[4], &IOM1->CQSETCLEAR, IOM_SIGNAL_MSPI_BUFFER0));
+
+    //
+    // The exit is a CQADDR write whose value the HAL patches.
+    //
+    CHECK(sBuf[5].address == ADDR(&IOM1->CQADDR));
+    CHECK(pui32Exit == &sBuf[5].value);
+}
+
+//*****************************************************************************
+//
+// MSPI side of the example, looping over two blocks.
+//
+//*****************************************************************************
+static void
+test_mspi_loop(void)
+{
+    am_hal_cmdq_entry_t sBuf[TEST_MAX_ENTRIES];
+    am_hal_cmdq_prog_t sProg;
+    uint32_t ui32Label, ui32Used, i;
+
+    CHECK(am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_MSPI, sBuf, TEST_MAX_ENTRIES) == AM_HAL_STATUS_SUCCESS);
+    ui32Label = am_hal_cmdq_prog_label(&sProg);
+    for (i = 0; i < 2; i++)
+    {
+        am_hal_cmdq_prog_wait(&sProg, AM_HAL_MSPI_PAUSE_FLAG_CQ | MSPI_WAIT_FOR_IOM_BUFFER0);
+        am_hal_cmdq_prog_write(&sProg, ADDR(&MSPI->DMADEVADDR), i * 256);
+        am_hal_cmdq_prog_signal(&sProg, MSPI_SIGNAL_IOM_BUFFER0);
+    }
+    am_hal_cmdq_prog_jump(&sProg, ui32Label);
+    CHECK(am_hal_cmdq_prog_end(&sProg, &ui32Used) == AM_HAL_STATUS_SUCCESS);
+    CHECK(ui32Used == 9);
+
+    CHECK(entry_is(&sBuf[0], &MSPI->CQPAUSE,
+                   AM_HAL_MSPI_PAUSE_FLAG_IDX | AM_HAL_MSPI_PAUSE_FLAG_CQ | MSPI_WAIT_FOR_IOM_BUFFER0));
+    CHECK(entry_is(&sBuf[1], &MSPI->CQPAUSE, AM_HAL_MSPI_PAUSE_FLAG_IDX));
+    CHECK(entry_is(&sBuf[6], &MSPI->DMADEVADDR, 256));
+    CHECK(entry_is(&sBuf[7], &MSPI->CQSETCLEAR, MSPI_SIGNAL_IOM_BUFFER0));
+    CHECK(entry_is(&sBuf[8], &MSPI->CQADDR, ADDR(&sBuf[ui32Label])));
+}
+
+//*****************************************************************************
+//
+// Latched errors.
+//
+//*****************************************************************************
+static void
+test_errors(void)
+{
+    am_hal_cmdq_entry_t sBuf[TEST_MAX_ENTRIES];
+    am_hal_cmdq_prog_t sProg;
+    uint32_t ui32Needed;
+
+    //
+    // Overflow keeps counting so the caller learns the size needed.
+    //
+    CHECK(build_iom(&sProg, sBuf, 3) == NULL);
+    CHECK(am_hal_cmdq_prog_end(&sProg, &ui32Needed) == AM_HAL_STATUS_OUT_OF_RANGE);
+    CHECK(ui32Needed == 6);
+
+    //
+    // Forward jumps, unaligned addresses and empty programs are rejected.
+    //
+    am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_IOM0, sBuf, TEST_MAX_ENTRIES);
+    am_hal_cmdq_prog_jump(&sProg, 1);
+    CHECK(am_hal_cmdq_prog_end(&sProg, NULL) == AM_HAL_STATUS_INVALID_ARG);
+
+    am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_IOM0, sBuf, TEST_MAX_ENTRIES);
+    am_hal_cmdq_prog_write(&sProg, ADDR(&IOM0->CMD) + 2, 0);
+    CHECK(am_hal_cmdq_prog_end(&sProg, NULL) == AM_HAL_STATUS_INVALID_ARG);
+
+    am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_IOM0, sBuf, TEST_MAX_ENTRIES);
+    CHECK(am_hal_cmdq_prog_end(&sProg, NULL) == AM_HAL_STATUS_INVALID_OPERATION);
+
+    CHECK(am_hal_cmdq_prog_init(&sProg, AM_HAL_CMDQ_IF_MAX, sBuf, TEST_MAX_ENTRIES) == AM_HAL_STATUS_OUT_OF_RANGE);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(void)
+{
+    test_iom_program();
+    test_mspi_loop();
+    test_errors();
+
+    return host_test_result();
+}
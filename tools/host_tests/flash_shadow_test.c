@@ -0,0 +1,409 @@
+//*****************************************************************************
+//
+//! @file flash_shadow_test.c
+//!
+//! @brief Host test of the flash write coalescing layer.
+//!
+//! A range of flash pages straddling the two flash instances is mapped into
+//! host memory and the BOOTROM erase, program and clear-bits helpers are
+//! modelled on it: programming can only clear bits, and programming a word
+//! that is not blank is an error.  Random writes, reads and flushes are
+//! checked against a reference image, with and without failing helpers.
+//! Every helper call must run with interrupts disabled, program at most
+//! AM_UTIL_FLASH_SHADOW_MAX_RUN words, and a flush may erase at most once.
+//! Writes that only clear bits must never erase.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "am_util_flash_shadow.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define FLASH_TEST_BASE             (AM_HAL_FLASH_INSTANCE_SIZE - 8 * AM_HAL_FLASH_PAGE_SIZE)
+#define FLASH_TEST_PAGES            16
+#define FLASH_TEST_SIZE             (FLASH_TEST_PAGES * AM_HAL_FLASH_PAGE_SIZE)
+#define PAGE_WORDS                  (AM_HAL_FLASH_PAGE_SIZE / 4)
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static am_util_flash_shadow_t g_sShadow;
+static uint32_t g_pui32PageBuffer[PAGE_WORDS];
+
+//
+// What the flash should hold once everything is flushed.
+//
+static uint8_t g_pui8Reference[FLASH_TEST_SIZE];
+
+//
+// Helper model state.
+//
+static uint32_t g_ui32FailEvery;
+static uint32_t g_ui32Calls;
+static uint32_t g_ui32Erases;
+static uint32_t g_ui32WordsProgrammed;
+static uint32_t g_ui32MaxRun;
+static uint32_t g_ui32BadCalls;
+static uint32_t g_ui32BytesWritten;
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the shadow links against.
+//
+//*****************************************************************************
+//
+// Common checks of a helper call.  Returns true if the call should fail.
+//
+static bool
+helper_call(uint32_t ui32Key, uint32_t ui32Addr, uint32_t ui32NumBytes)
+{
+    if ((ui32Key != AM_HAL_FLASH_PROGRAM_KEY) || !g_bIntDisabled ||
+        (ui32Addr < FLASH_TEST_BASE) || (ui32Addr & 3) ||
+        (ui32Addr + ui32NumBytes > FLASH_TEST_BASE + FLASH_TEST_SIZE))
+    {
+        g_ui32BadCalls++;
+        return true;
+    }
+
+    return g_ui32FailEvery && ((++g_ui32Calls % g_ui32FailEvery) == 0);
+}
+
+int
+am_hal_flash_page_erase(uint32_t ui32ProgramKey, uint32_t ui32FlashInst,
+                        uint32_t ui32PageNum)
+{
+    uint32_t ui32Addr = ui32FlashInst * AM_HAL_FLASH_INSTANCE_SIZE +
+                        ui32PageNum * AM_HAL_FLASH_PAGE_SIZE;
+
+    if (helper_call(ui32ProgramKey, ui32Addr, AM_HAL_FLASH_PAGE_SIZE))
+    {
+        return 1;
+    }
+
+    memset((void *)(uintptr_t)ui32Addr, 0xFF, AM_HAL_FLASH_PAGE_SIZE);
+    g_ui32Erases++;
+    return 0;
+}
+
+int
+am_hal_flash_program_main(uint32_t ui32ProgramKey, uint32_t *pui32Src,
+                          uint32_t *pui32Dst, uint32_t ui32NumWords)
+{
+    if (helper_call(ui32ProgramKey, (uint32_t)(uintptr_t)pui32Dst, ui32NumWords * 4))
+    {
+        return 1;
+    }
+
+    if (ui32NumWords > g_ui32MaxRun)
+    {
+        g_ui32MaxRun = ui32NumWords;
+    }
+
+    for (uint32_t i = 0; i < ui32NumWords; i++)
+    {
+        if (pui32Dst[i] != 0xFFFFFFFF)
+        {
+            g_ui32BadCalls++;
+        }
+        pui32Dst[i] &= pui32Src[i];
+    }
+    g_ui32WordsProgrammed += ui32NumWords;
+    return 0;
+}
+
+int
+am_hal_flash_clear_bits(uint32_t ui32ProgramKey, uint32_t *pui32Addr,
+                        uint32_t ui32BitMask)
+{
+    if (helper_call(ui32ProgramKey, (uint32_t)(uintptr_t)pui32Addr, 4))
+    {
+        return 1;
+    }
+
+    *pui32Addr &= ~ui32BitMask;
+    g_ui32WordsProgrammed++;
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+static uint8_t *
+flash_ptr(uint32_t ui32Offset)
+{
+    return (uint8_t *)(uintptr_t)(FLASH_TEST_BASE + ui32Offset);
+}
+
+static void
+flash_reset(void)
+{
+    for (uint32_t i = 0; i < FLASH_TEST_SIZE; i++)
+    {
+        g_pui8Reference[i] = rand_next() & 1 ? 0xFF : (uint8_t)rand_next();
+    }
+    memcpy(flash_ptr(0), g_pui8Reference, FLASH_TEST_SIZE);
+    CHECK(am_util_flash_shadow_init(&g_sShadow, g_pui32PageBuffer) == AM_HAL_STATUS_SUCCESS);
+    g_ui32Erases = 0;
+    g_ui32WordsProgrammed = 0;
+    g_ui32BytesWritten = 0;
+}
+
+static void
+shadow_flush(void)
+{
+    uint32_t ui32Erases = g_ui32Erases;
+    uint32_t ui32Status = am_util_flash_shadow_flush(&g_sShadow);
+    uint32_t ui32Retries = 0;
+
+    //
+    // With failures injected, retry until the flush goes through.  Each retry
+    // only has the words not yet programmed left to do, so it must get there.
+    //
+    while (g_ui32FailEvery && (ui32Status != AM_HAL_STATUS_SUCCESS) &&
+           (ui32Retries++ < PAGE_WORDS))
+    {
+        ui32Erases = g_ui32Erases;
+        ui32Status = am_util_flash_shadow_flush(&g_sShadow);
+    }
+
+    CHECK(ui32Status == AM_HAL_STATUS_SUCCESS);
+    CHECK(g_ui32Erases - ui32Erases <= 1);
+}
+
+static void
+shadow_write(uint32_t ui32Offset, const uint8_t *pui8Data, uint32_t ui32NumBytes)
+{
+    uint32_t ui32Status = am_util_flash_shadow_write(&g_sShadow, FLASH_TEST_BASE + ui32Offset,
+                                                     pui8Data, ui32NumBytes);
+
+    //
+    // A write fails only if flushing a page it leaves failed; flush that and
+    // try again.  A write spans at most four pages.
+    //
+    for (uint32_t i = 0; g_ui32FailEvery && (ui32Status != AM_HAL_STATUS_SUCCESS) && (i < 4); i++)
+    {
+        shadow_flush();
+        ui32Status = am_util_flash_shadow_write(&g_sShadow, FLASH_TEST_BASE + ui32Offset,
+                                                pui8Data, ui32NumBytes);
+    }
+
+    CHECK(ui32Status == AM_HAL_STATUS_SUCCESS);
+    memcpy(&g_pui8Reference[ui32Offset], pui8Data, ui32NumBytes);
+    g_ui32BytesWritten += ui32NumBytes;
+}
+
+//*****************************************************************************
+//
+// Random writes, reads and flushes.  bClearOnly restricts writes to clearing
+// bits.
+//
+//*****************************************************************************
+static void
+test_random(uint32_t ui32Events, uint32_t ui32FailEvery, bool bClearOnly)
+{
+    static uint8_t pui8Buf[3 * AM_HAL_FLASH_PAGE_SIZE];
+    am_util_flash_shadow_stats_t sStats;
+
+    flash_reset();
+    g_ui32FailEvery = ui32FailEvery;
+    g_ui32Calls = 0;
+
+    for (uint32_t n = 0; n < ui32Events; n++)
+    {
+        uint32_t ui32Roll = rand_next() % 100;
+        uint32_t ui32Len = (rand_next() % 4) ? 1 + rand_next() % 64 :
+                                                1 + rand_next() % sizeof(pui8Buf);
+        uint32_t ui32Offset;
+
+        if (ui32Len > FLASH_TEST_SIZE)
+        {
+            ui32Len = FLASH_TEST_SIZE;
+        }
+        ui32Offset = rand_next() % (FLASH_TEST_SIZE - ui32Len + 1);
+
+        if (ui32Roll < 60)
+        {
+            for (uint32_t i = 0; i < ui32Len; i++)
+            {
+                pui8Buf[i] = bClearOnly ? g_pui8Reference[ui32Offset + i] & rand_next() :
+                                          (uint8_t)rand_next();
+            }
+            shadow_write(ui32Offset, pui8Buf, ui32Len);
+        }
+        else if (ui32Roll < 90)
+        {
+            CHECK(am_util_flash_shadow_read(&g_sShadow, FLASH_TEST_BASE + ui32Offset,
+                                            pui8Buf, ui32Len) == AM_HAL_STATUS_SUCCESS);
+            CHECK(memcmp(pui8Buf, &g_pui8Reference[ui32Offset], ui32Len) == 0);
+        }
+        else
+        {
+            shadow_flush();
+        }
+    }
+
+    shadow_flush();
+    g_ui32FailEvery = 0;
+
+    CHECK(memcmp(flash_ptr(0), g_pui8Reference, FLASH_TEST_SIZE) == 0);
+    CHECK(g_ui32BadCalls == 0);
+    CHECK(g_ui32MaxRun <= AM_UTIL_FLASH_SHADOW_MAX_RUN);
+    CHECK(!g_bIntDisabled);
+
+    sStats = g_sShadow.sStats;
+    if (!ui32FailEvery)
+    {
+        CHECK(sStats.ui32Erases == g_ui32Erases);
+        CHECK(sStats.ui32WordsProgrammed == g_ui32WordsProgrammed);
+        CHECK(sStats.ui32BytesWritten == g_ui32BytesWritten);
+    }
+    if (bClearOnly)
+    {
+        CHECK(g_ui32Erases == 0);
+    }
+
+    printf("%s%s: %u flushes, %u erases, %u words programmed for %u bytes written,"
+           " longest program call %u words\n",
+           bClearOnly ? "clear only" : "random",
+           ui32FailEvery ? " with failures" : "",
+           (unsigned)sStats.ui32Flushes, (unsigned)g_ui32Erases,
+           (unsigned)g_ui32WordsProgrammed, (unsigned)sStats.ui32BytesWritten,
+           (unsigned)g_ui32MaxRun);
+}
+
+//*****************************************************************************
+//
+// A whole page rewritten after an erase is programmed in bounded runs.
+//
+//*****************************************************************************
+static void
+test_full_page(void)
+{
+    static uint8_t pui8Page[AM_HAL_FLASH_PAGE_SIZE];
+
+    flash_reset();
+    g_ui32MaxRun = 0;
+
+    memset(pui8Page, 0x5A, sizeof(pui8Page));
+    shadow_write(AM_HAL_FLASH_PAGE_SIZE, pui8Page, sizeof(pui8Page));
+    shadow_flush();
+
+    CHECK(g_ui32Erases == 1);
+    CHECK(g_ui32WordsProgrammed == PAGE_WORDS);
+    CHECK(g_ui32MaxRun == AM_UTIL_FLASH_SHADOW_MAX_RUN);
+    CHECK(memcmp(flash_ptr(0), g_pui8Reference, FLASH_TEST_SIZE) == 0);
+
+    //
+    // Nothing changed, nothing to do.
+    //
+    shadow_write(AM_HAL_FLASH_PAGE_SIZE, pui8Page, 16);
+    shadow_flush();
+    CHECK(g_ui32Erases == 1);
+    CHECK(g_ui32WordsProgrammed == PAGE_WORDS);
+
+    CHECK(am_util_flash_shadow_write(&g_sShadow, AM_HAL_FLASH_LARGEST_VALID_ADDR, pui8Page, 2) ==
+          AM_HAL_STATUS_INVALID_ARG);
+    CHECK(am_util_flash_shadow_read(&g_sShadow, 0, NULL, 4) == AM_HAL_STATUS_INVALID_ARG);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Events = 20000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Events = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n events] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    host_regs_map(FLASH_TEST_BASE, FLASH_TEST_SIZE);
+
+    test_full_page();
+    test_random(ui32Events, 0, false);
+    test_random(ui32Events, 0, true);
+    test_random(ui32Events, 5, false);
+
+    return host_test_result();
+}
@@ -0,0 +1,962 @@
+//*****************************************************************************
+//
+//! @file hci_fair_test.c
+//!
+//! @brief Fairness simulation of the HCI ACL transmit scheduler.
+//!
+//! Runs the real hci_core.c transmit path, hciCoreTxNextConn() and
+//! hciCoreTxQuota(), against a model of a controller with a shared pool of
+//! ACL buffers serving 4 to 8 connections.  Two connections are bulk senders
+//! of fragmented notifications; the others send small notifications and
+//! priority packets (L2CAP signaling and ATT responses) at random.
+//!
+//! Each run reports bulk throughput, the spread between the bulk senders and
+//! the latency of the light traffic in connection events, and compares them
+//! with a model of the previous scheduler: one FIFO for all connections,
+//! fragments sent back to back and no per-connection buffer quota.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "wsf_types.h"
+#include "wsf_buf.h"
+#include "wsf_msg.h"
+#include "wsf_os.h"
+#include "wsf_cs.h"
+#include "bstream.h"
+#include "hci_api.h"
+#include "hci_core.h"
+#include "hci_core_ps.h"
+#include "hci_tr.h"
+#include "hci_cmd.h"
+#include "hci_evt.h"
+#include "hci_main.h"
+#include "l2c_defs.h"
+#include "att_defs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define MAX_LINKS                   8
+#define NUM_BULK                    2
+
+//
+// Controller: 8 ACL buffers of 27 bytes.  All connections share one 7.5 ms
+// interval; an event sends as many buffers as fit in its share of it, at
+// about 708 us for a 27-byte PDU and the empty acknowledgement at 1M PHY.
+//
+#define NUM_BUFS                    8
+#define BUF_SIZE                    27
+#define CONN_INTERVAL_US            7500
+#define PDU_US                      708
+
+//
+// Traffic.  Bulk senders queue MTU-sized notifications as fast as flow
+// control lets them.  Each light connection queues a small notification in
+// one interval in DATA_ODDS and a priority packet in one in PRI_ODDS.
+//
+#define BULK_LENGTH                 244
+#define LIGHT_LENGTH                20
+#define DATA_ODDS                   4
+#define PRI_ODDS                    16
+
+#define SEQ_RING                    1024
+#define DRAIN_EVENTS                4000
+
+//*****************************************************************************
+//
+// Types
+//
+//*****************************************************************************
+typedef enum
+{
+    CLASS_BULK,
+    CLASS_DATA,
+    CLASS_PRI,
+    CLASS_COUNT
+}
+traffic_class_e;
+
+//
+// An ACL buffer held by the controller.
+//
+typedef struct
+{
+    uint16_t    ui16Length;
+    uint16_t    ui16Seq;
+    uint8_t     ui8Class;
+    bool        bLast;
+}
+ctrl_buf_t;
+
+//
+// The scheduler under test: how the host hands a packet to HCI, and how the
+// controller reports completed buffers.
+//
+typedef struct
+{
+    const char  *pcName;
+    void        (*pfnOpen)(uint32_t ui32Links, uint8_t ui8Quota);
+    void        (*pfnClose)(uint32_t ui32Links);
+    void        (*pfnSend)(uint8_t *pData);
+    void        (*pfnComplete)(uint16_t ui16Handle, uint8_t ui8Bufs);
+}
+sched_t;
+
+typedef struct
+{
+    double      dBulkTotal;
+    double      dBulkMin;
+    double      dBulkMax;
+    double      pdLatMean[CLASS_COUNT];
+    uint32_t    pui32LatMax[CLASS_COUNT];
+    uint32_t    ui32BulkHeldMax;
+}
+result_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static uint32_t g_ui32Event;
+static uint32_t g_ui32Links;
+static int32_t g_i32Bufs;
+static const sched_t *g_psSched;
+
+hciCb_t hciCb;
+
+//
+// Controller model.
+//
+static struct
+{
+    struct
+    {
+        ctrl_buf_t  psBuf[NUM_BUFS];
+        uint32_t    ui32Head;
+        uint32_t    ui32Count;
+        uint32_t    ui32MaxCount;
+        bool        bInPacket;
+        uint16_t    ui16Remaining;
+        uint16_t    ui16Pos;
+        uint16_t    ui16Seq;
+        uint8_t     ui8Class;
+    } psLink[MAX_LINKS];
+    uint32_t    ui32Held;
+    uint32_t    ui32Pdus;
+    uint32_t    ui32Overflows;
+    uint32_t    ui32BadFrags;
+} g_sCtrl;
+
+//
+// Host application on each connection.
+//
+static struct
+{
+    bool        bBulk;
+    bool        bFlowOff;
+    uint16_t    ui16Seq;
+    uint32_t    pui32SentAt[SEQ_RING];
+    uint64_t    ui64BulkBytes;
+} g_psApp[MAX_LINKS];
+
+static struct
+{
+    uint32_t    pui32Queued[CLASS_COUNT];
+    uint32_t    pui32Delivered[CLASS_COUNT];
+    uint64_t    pui64LatSum[CLASS_COUNT];
+    uint32_t    pui32LatMax[CLASS_COUNT];
+} g_sStats;
+
+//
+// The previous scheduler: one FIFO for all connections, a started packet's
+// fragments sent back to back, no buffer quota and no priority queue.
+//
+static struct
+{
+    wsfQueue_t  sQueue;
+    uint8_t     ui8AvailBufs;
+    struct
+    {
+        uint8_t     *pui8Pkt;
+        uint8_t     *pui8Next;
+        uint16_t    ui16Remaining;
+        bool        bFragmenting;
+        uint8_t     ui8Queued;
+        bool        bFlowOff;
+    } psConn[MAX_LINKS];
+} g_sLegacy;
+
+static uint64_t g_ui64Seed = 0x9e3779b97f4a7c15ull;
+static uint64_t g_ui64Rand;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// WSF and HCI entry points hci_core.c links against.
+//
+//*****************************************************************************
+void *
+WsfBufAlloc(uint16_t len)
+{
+    g_i32Bufs++;
+    return malloc(len);
+}
+
+void
+WsfBufFree(void *pBuf)
+{
+    g_i32Bufs--;
+    free(pBuf);
+}
+
+wsfQueue_t *WsfTaskMsgQueue(wsfHandlerId_t handlerId) { (void)handlerId; return NULL; }
+void WsfTaskSetReady(wsfHandlerId_t handlerId, wsfTaskEvent_t event) { (void)handlerId; (void)event; }
+void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event) { (void)handlerId; (void)event; }
+void WsfCsEnter(void) { }
+void WsfCsExit(void) { }
+
+void hciCoreResetStart(void) { }
+void hciCmdInit(void) { }
+void hciCmdTimeout(wsfMsgHdr_t *pMsg) { (void)pMsg; }
+void hciCoreResetSequence(uint8_t *pMsg) { (void)pMsg; }
+void hciEvtProcessMsg(uint8_t *pEvt) { (void)pEvt; }
+
+//*****************************************************************************
+//
+// Controller model.
+//
+//*****************************************************************************
+
+//
+// Take one ACL buffer from the host, checking the fragment sequence and the
+// payload of the packet it belongs to.
+//
+static void
+ctrl_receive(uint8_t *pData)
+{
+    uint16_t ui16Handle, ui16Length, ui16Cid, i;
+    uint32_t ui32Link;
+    ctrl_buf_t *psBuf;
+
+    BYTES_TO_UINT16(ui16Handle, pData);
+    BYTES_TO_UINT16(ui16Length, &pData[2]);
+    ui32Link = ui16Handle & ~HCI_PB_FLAG_MASK;
+
+    if (ui32Link >= g_ui32Links || ui16Length == 0 || ui16Length > BUF_SIZE)
+    {
+        g_sCtrl.ui32BadFrags++;
+        return;
+    }
+
+    if (g_sCtrl.ui32Held >= NUM_BUFS)
+    {
+        g_sCtrl.ui32Overflows++;
+        return;
+    }
+
+    if ((ui16Handle & HCI_PB_FLAG_MASK) == HCI_PB_START_H2C)
+    {
+        if (g_sCtrl.psLink[ui32Link].bInPacket)
+        {
+            g_sCtrl.ui32BadFrags++;
+        }
+
+        BYTES_TO_UINT16(g_sCtrl.psLink[ui32Link].ui16Remaining, &pData[HCI_ACL_HDR_LEN]);
+        g_sCtrl.psLink[ui32Link].ui16Remaining += L2C_HDR_LEN;
+        BYTES_TO_UINT16(ui16Cid, &pData[HCI_ACL_HDR_LEN + 2]);
+        BYTES_TO_UINT16(g_sCtrl.psLink[ui32Link].ui16Seq, &pData[L2C_PAYLOAD_START + 1]);
+        g_sCtrl.psLink[ui32Link].ui16Pos = 0;
+        g_sCtrl.psLink[ui32Link].bInPacket = true;
+
+        if (ui16Cid == L2C_CID_ATT && pData[L2C_PAYLOAD_START] == ATT_PDU_VALUE_NTF)
+        {
+            g_sCtrl.psLink[ui32Link].ui8Class = g_psApp[ui32Link].bBulk ? CLASS_BULK : CLASS_DATA;
+        }
+        else
+        {
+            g_sCtrl.psLink[ui32Link].ui8Class = CLASS_PRI;
+        }
+    }
+    else if ((ui16Handle & HCI_PB_FLAG_MASK) != HCI_PB_CONTINUE ||
+             !g_sCtrl.psLink[ui32Link].bInPacket)
+    {
+        g_sCtrl.ui32BadFrags++;
+        return;
+    }
+
+    if (ui16Length > g_sCtrl.psLink[ui32Link].ui16Remaining)
+    {
+        g_sCtrl.ui32BadFrags++;
+        return;
+    }
+
+    //
+    // Past the L2CAP header, opcode and sequence number the payload counts
+    // up from the sequence number.
+    //
+    for (i = 0; i < ui16Length; i++)
+    {
+        uint16_t ui16Pos = g_sCtrl.psLink[ui32Link].ui16Pos + i;
+
+        if (ui16Pos >= L2C_HDR_LEN + 3 &&
+            pData[HCI_ACL_HDR_LEN + i] != (uint8_t)(g_sCtrl.psLink[ui32Link].ui16Seq + ui16Pos))
+        {
+            g_sCtrl.ui32BadFrags++;
+            break;
+        }
+    }
+
+    g_sCtrl.psLink[ui32Link].ui16Pos += ui16Length;
+    g_sCtrl.psLink[ui32Link].ui16Remaining -= ui16Length;
+
+    psBuf = &g_sCtrl.psLink[ui32Link].psBuf[(g_sCtrl.psLink[ui32Link].ui32Head +
+                                             g_sCtrl.psLink[ui32Link].ui32Count) % NUM_BUFS];
+    psBuf->ui16Length = ui16Length;
+    psBuf->ui16Seq = g_sCtrl.psLink[ui32Link].ui16Seq;
+    psBuf->ui8Class = g_sCtrl.psLink[ui32Link].ui8Class;
+    psBuf->bLast = g_sCtrl.psLink[ui32Link].ui16Remaining == 0;
+
+    if (psBuf->bLast)
+    {
+        g_sCtrl.psLink[ui32Link].bInPacket = false;
+    }
+
+    g_sCtrl.ui32Held++;
+    if (++g_sCtrl.psLink[ui32Link].ui32Count > g_sCtrl.psLink[ui32Link].ui32MaxCount)
+    {
+        g_sCtrl.psLink[ui32Link].ui32MaxCount = g_sCtrl.psLink[ui32Link].ui32Count;
+    }
+}
+
+//
+// The transport: the whole buffer reaches the controller at once.
+//
+void
+hciTrSendAclData(void *pContext, uint8_t *pData)
+{
+    ctrl_receive(pData);
+    hciCoreTxAclComplete(pContext, pData);
+}
+
+//
+// One connection event: send what fits, then report the completed buffers.
+//
+static void
+ctrl_event(uint32_t ui32Link, bool bMeasure)
+{
+    uint32_t ui32Sent = 0;
+    uint32_t ui32Latency;
+    ctrl_buf_t *psBuf;
+
+    while (ui32Sent < g_sCtrl.ui32Pdus && g_sCtrl.psLink[ui32Link].ui32Count > 0)
+    {
+        psBuf = &g_sCtrl.psLink[ui32Link].psBuf[g_sCtrl.psLink[ui32Link].ui32Head];
+        g_sCtrl.psLink[ui32Link].ui32Head = (g_sCtrl.psLink[ui32Link].ui32Head + 1) % NUM_BUFS;
+        g_sCtrl.psLink[ui32Link].ui32Count--;
+        g_sCtrl.ui32Held--;
+        ui32Sent++;
+
+        if (bMeasure && psBuf->ui8Class == CLASS_BULK)
+        {
+            g_psApp[ui32Link].ui64BulkBytes += psBuf->ui16Length;
+        }
+
+        if (psBuf->bLast)
+        {
+            ui32Latency = g_ui32Event - g_psApp[ui32Link].pui32SentAt[psBuf->ui16Seq % SEQ_RING];
+            g_sStats.pui32Delivered[psBuf->ui8Class]++;
+            g_sStats.pui64LatSum[psBuf->ui8Class] += ui32Latency;
+            if (ui32Latency > g_sStats.pui32LatMax[psBuf->ui8Class])
+            {
+                g_sStats.pui32LatMax[psBuf->ui8Class] = ui32Latency;
+            }
+        }
+    }
+
+    if (ui32Sent > 0)
+    {
+        g_psSched->pfnComplete(ui32Link, ui32Sent);
+    }
+}
+
+//*****************************************************************************
+//
+// Host applications.
+//
+//*****************************************************************************
+static void
+app_flow(uint16_t handle, bool_t flowDisabled)
+{
+    g_psApp[handle].bFlowOff = flowDisabled;
+}
+
+//
+// Queue one packet: a notification, or for priority traffic an ATT read
+// response or an L2CAP signaling request.
+//
+static void
+app_send(uint32_t ui32Link, traffic_class_e eClass)
+{
+    uint16_t ui16Seq = g_psApp[ui32Link].ui16Seq++;
+    uint16_t ui16L2cLen = 1 + ((eClass == CLASS_BULK) ? BULK_LENGTH : LIGHT_LENGTH);
+    uint16_t ui16AclLen = ui16L2cLen + L2C_HDR_LEN;
+    uint16_t ui16Cid = L2C_CID_ATT;
+    uint8_t ui8Op = ATT_PDU_VALUE_NTF;
+    uint8_t *pData;
+    uint16_t i;
+
+    if (eClass == CLASS_PRI)
+    {
+        ui16Cid = (ui16Seq & 1) ? L2C_CID_LE_SIGNALING : L2C_CID_ATT;
+        ui8Op = (ui16Seq & 1) ? 0x12 : ATT_PDU_READ_RSP;
+    }
+
+    pData = WsfMsgDataAlloc(ui16AclLen + HCI_ACL_HDR_LEN, 0);
+    UINT16_TO_BUF(&pData[0], ui32Link | HCI_PB_START_H2C);
+    UINT16_TO_BUF(&pData[2], ui16AclLen);
+    UINT16_TO_BUF(&pData[4], ui16L2cLen);
+    UINT16_TO_BUF(&pData[6], ui16Cid);
+    pData[L2C_PAYLOAD_START] = ui8Op;
+    UINT16_TO_BUF(&pData[L2C_PAYLOAD_START + 1], ui16Seq);
+    for (i = L2C_HDR_LEN + 3; i < ui16AclLen; i++)
+    {
+        pData[HCI_ACL_HDR_LEN + i] = (uint8_t)(ui16Seq + i);
+    }
+
+    g_psApp[ui32Link].pui32SentAt[ui16Seq % SEQ_RING] = g_ui32Event;
+    g_sStats.pui32Queued[eClass]++;
+
+    g_psSched->pfnSend(pData);
+}
+
+static void
+app_light(void)
+{
+    uint32_t i;
+
+    for (i = NUM_BULK; i < g_ui32Links; i++)
+    {
+        if (g_psApp[i].bFlowOff)
+        {
+            continue;
+        }
+
+        if ((rand_next() % DATA_ODDS) == 0)
+        {
+            app_send(i, CLASS_DATA);
+        }
+
+        if ((rand_next() % PRI_ODDS) == 0)
+        {
+            app_send(i, CLASS_PRI);
+        }
+    }
+}
+
+static void
+app_bulk(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < NUM_BULK; i++)
+    {
+        while (!g_psApp[i].bFlowOff)
+        {
+            app_send(i, CLASS_BULK);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// hci_core.c scheduler.
+//
+//*****************************************************************************
+static void
+core_open(uint32_t ui32Links, uint8_t ui8Quota)
+{
+    uint32_t i;
+
+    HciCoreInit();
+    hciCoreCb.numBufs = NUM_BUFS;
+    hciCoreCb.availBufs = NUM_BUFS;
+    hciCoreCb.bufSize = BUF_SIZE;
+    HciSetAclConnQuota(ui8Quota);
+
+    for (i = 0; i < ui32Links; i++)
+    {
+        hciCoreConnOpen(i);
+    }
+}
+
+static void
+core_close(uint32_t ui32Links)
+{
+    uint32_t i;
+
+    for (i = 0; i < ui32Links; i++)
+    {
+        hciCoreConnClose(i);
+    }
+}
+
+static void
+core_complete(uint16_t ui16Handle, uint8_t ui8Bufs)
+{
+    uint8_t pui8Evt[5];
+
+    pui8Evt[0] = 1;
+    UINT16_TO_BUF(&pui8Evt[1], ui16Handle);
+    UINT16_TO_BUF(&pui8Evt[3], ui8Bufs);
+    hciCoreNumCmplPkts(pui8Evt);
+}
+
+static const sched_t g_sCoreSched =
+{
+    "hci_core", core_open, core_close, HciSendAclData, core_complete
+};
+
+//*****************************************************************************
+//
+// Model of the previous scheduler.
+//
+//*****************************************************************************
+static void
+legacy_xmit(uint32_t ui32Link, uint8_t *pData)
+{
+    g_sLegacy.ui8AvailBufs--;
+    ctrl_receive(pData);
+
+    if (g_sLegacy.psConn[ui32Link].bFragmenting)
+    {
+        if (g_sLegacy.psConn[ui32Link].ui16Remaining == 0)
+        {
+            WsfMsgFree(g_sLegacy.psConn[ui32Link].pui8Pkt);
+            g_sLegacy.psConn[ui32Link].pui8Pkt = NULL;
+            g_sLegacy.psConn[ui32Link].bFragmenting = false;
+        }
+    }
+    else
+    {
+        WsfMsgFree(pData);
+    }
+}
+
+//
+// Send the next fragment of the first connection still fragmenting.
+//
+static bool
+legacy_continue(void)
+{
+    uint32_t i;
+    uint16_t ui16Length;
+
+    for (i = 0; i < g_ui32Links; i++)
+    {
+        if (g_sLegacy.psConn[i].bFragmenting)
+        {
+            break;
+        }
+    }
+
+    if (i == g_ui32Links || g_sLegacy.psConn[i].ui16Remaining == 0)
+    {
+        return false;
+    }
+
+    ui16Length = (g_sLegacy.psConn[i].ui16Remaining < BUF_SIZE) ?
+                 g_sLegacy.psConn[i].ui16Remaining : BUF_SIZE;
+    g_sLegacy.psConn[i].ui16Remaining -= ui16Length;
+
+    UINT16_TO_BUF(g_sLegacy.psConn[i].pui8Next, i | HCI_PB_CONTINUE);
+    UINT16_TO_BUF(&g_sLegacy.psConn[i].pui8Next[2], ui16Length);
+    legacy_xmit(i, g_sLegacy.psConn[i].pui8Next);
+
+    if (g_sLegacy.psConn[i].ui16Remaining > 0)
+    {
+        g_sLegacy.psConn[i].pui8Next += ui16Length;
+    }
+
+    return true;
+}
+
+static void
+legacy_start(uint8_t *pData)
+{
+    uint16_t ui16Handle, ui16Length;
+
+    BYTES_TO_UINT16(ui16Handle, pData);
+    BYTES_TO_UINT16(ui16Length, &pData[2]);
+
+    if (ui16Length > BUF_SIZE)
+    {
+        g_sLegacy.psConn[ui16Handle].ui16Remaining = ui16Length - BUF_SIZE;
+        g_sLegacy.psConn[ui16Handle].pui8Next = pData + BUF_SIZE;
+        g_sLegacy.psConn[ui16Handle].pui8Pkt = pData;
+        g_sLegacy.psConn[ui16Handle].bFragmenting = true;
+        UINT16_TO_BUF(&pData[2], BUF_SIZE);
+        legacy_xmit(ui16Handle, pData);
+
+        while (g_sLegacy.ui8AvailBufs > 0 && legacy_continue())
+        {
+        }
+    }
+    else
+    {
+        legacy_xmit(ui16Handle, pData);
+    }
+}
+
+static void
+legacy_ready(void)
+{
+    uint8_t *pData;
+    wsfHandlerId_t handlerId;
+
+    while (g_sLegacy.ui8AvailBufs > 0)
+    {
+        if (!legacy_continue())
+        {
+            if ((pData = WsfMsgDeq(&g_sLegacy.sQueue, &handlerId)) == NULL)
+            {
+                break;
+            }
+
+            legacy_start(pData);
+        }
+    }
+}
+
+static void
+legacy_open(uint32_t ui32Links, uint8_t ui8Quota)
+{
+    (void)ui8Quota;
+
+    memset(&g_sLegacy, 0, sizeof(g_sLegacy));
+    WSF_QUEUE_INIT(&g_sLegacy.sQueue);
+    g_sLegacy.ui8AvailBufs = NUM_BUFS;
+}
+
+static void
+legacy_close(uint32_t ui32Links)
+{
+    uint8_t *pData;
+    wsfHandlerId_t handlerId;
+    uint32_t i;
+
+    while ((pData = WsfMsgDeq(&g_sLegacy.sQueue, &handlerId)) != NULL)
+    {
+        WsfMsgFree(pData);
+    }
+
+    for (i = 0; i < ui32Links; i++)
+    {
+        if (g_sLegacy.psConn[i].pui8Pkt != NULL)
+        {
+            WsfMsgFree(g_sLegacy.psConn[i].pui8Pkt);
+        }
+    }
+}
+
+static void
+legacy_send(uint8_t *pData)
+{
+    uint16_t ui16Handle, ui16Length;
+
+    BYTES_TO_UINT16(ui16Handle, pData);
+    BYTES_TO_UINT16(ui16Length, &pData[2]);
+
+    if (WsfQueueEmpty(&g_sLegacy.sQueue) && g_sLegacy.ui8AvailBufs > 0)
+    {
+        legacy_start(pData);
+    }
+    else
+    {
+        WsfMsgEnq(&g_sLegacy.sQueue, 0, pData);
+    }
+
+    g_sLegacy.psConn[ui16Handle].ui8Queued += ((ui16Length - 1) / BUF_SIZE) + 1;
+    if (g_sLegacy.psConn[ui16Handle].ui8Queued >= hciCoreCb.aclQueueHi &&
+        !g_sLegacy.psConn[ui16Handle].bFlowOff)
+    {
+        g_sLegacy.psConn[ui16Handle].bFlowOff = true;
+        app_flow(ui16Handle, TRUE);
+    }
+}
+
+static void
+legacy_complete(uint16_t ui16Handle, uint8_t ui8Bufs)
+{
+    g_sLegacy.psConn[ui16Handle].ui8Queued -= ui8Bufs;
+    g_sLegacy.ui8AvailBufs += ui8Bufs;
+
+    if (g_sLegacy.psConn[ui16Handle].bFlowOff &&
+        g_sLegacy.psConn[ui16Handle].ui8Queued <= hciCoreCb.aclQueueLo)
+    {
+        g_sLegacy.psConn[ui16Handle].bFlowOff = false;
+        app_flow(ui16Handle, FALSE);
+    }
+
+    legacy_ready();
+}
+
+static const sched_t g_sLegacySched =
+{
+    "FIFO", legacy_open, legacy_close, legacy_send, legacy_complete
+};
+
+//*****************************************************************************
+//
+// Simulation.
+//
+//*****************************************************************************
+static void
+run(const sched_t *psSched, uint32_t ui32Links, uint8_t ui8Quota, uint32_t ui32Events,
+    result_t *psResult)
+{
+    uint32_t i, ui32Event, ui32Pending = 0;
+
+    memset(&g_sCtrl, 0, sizeof(g_sCtrl));
+    memset(g_psApp, 0, sizeof(g_psApp));
+    memset(&g_sStats, 0, sizeof(g_sStats));
+    memset(psResult, 0, sizeof(*psResult));
+    g_ui64Rand = g_ui64Seed;
+    g_ui32Event = 0;
+    g_ui32Links = ui32Links;
+    g_psSched = psSched;
+
+    g_sCtrl.ui32Pdus = CONN_INTERVAL_US / (ui32Links * PDU_US);
+    if (g_sCtrl.ui32Pdus == 0)
+    {
+        g_sCtrl.ui32Pdus = 1;
+    }
+
+    for (i = 0; i < NUM_BULK; i++)
+    {
+        g_psApp[i].bBulk = true;
+    }
+
+    psSched->pfnOpen(ui32Links, ui8Quota);
+
+    //
+    // Traffic runs for ui32Events connection intervals, then the queues
+    // drain with no new packets.
+    //
+    for (ui32Event = 0; ui32Event < ui32Events + DRAIN_EVENTS; ui32Event++)
+    {
+        bool bMeasure = ui32Event < ui32Events;
+
+        g_ui32Event = ui32Event;
+
+        if (bMeasure)
+        {
+            app_light();
+        }
+
+        for (i = 0; i < ui32Links; i++)
+        {
+            ctrl_event(i, bMeasure);
+            if (bMeasure)
+            {
+                app_bulk();
+            }
+        }
+
+        ui32Pending = 0;
+        for (i = 0; i < CLASS_COUNT; i++)
+        {
+            ui32Pending += g_sStats.pui32Queued[i] - g_sStats.pui32Delivered[i];
+        }
+
+        if (!bMeasure && ui32Pending == 0)
+        {
+            break;
+        }
+    }
+
+    psSched->pfnClose(ui32Links);
+
+    CHECK(ui32Pending == 0);
+    CHECK(g_sCtrl.ui32Held == 0);
+    CHECK(g_sCtrl.ui32Overflows == 0);
+    CHECK(g_sCtrl.ui32BadFrags == 0);
+    CHECK(g_i32Bufs == 0);
+
+    psResult->dBulkMin = 1e9;
+    for (i = 0; i < NUM_BULK; i++)
+    {
+        double dBytes = (double)g_psApp[i].ui64BulkBytes / ui32Events;
+
+        psResult->dBulkTotal += dBytes;
+        psResult->dBulkMin = (dBytes < psResult->dBulkMin) ? dBytes : psResult->dBulkMin;
+        psResult->dBulkMax = (dBytes > psResult->dBulkMax) ? dBytes : psResult->dBulkMax;
+
+        if (g_sCtrl.psLink[i].ui32MaxCount > psResult->ui32BulkHeldMax)
+        {
+            psResult->ui32BulkHeldMax = g_sCtrl.psLink[i].ui32MaxCount;
+        }
+    }
+
+    for (i = 0; i < CLASS_COUNT; i++)
+    {
+        psResult->pdLatMean[i] = g_sStats.pui32Delivered[i] ?
+            (double)g_sStats.pui64LatSum[i] / g_sStats.pui32Delivered[i] : 0;
+        psResult->pui32LatMax[i] = g_sStats.pui32LatMax[i];
+    }
+
+    printf("  %u links %-8s quota %u: bulk %6.1f B/event (%5.1f..%5.1f), held max %u, "
+           "data latency %5.2f max %3u, priority %5.2f max %3u events\n",
+           (unsigned)ui32Links, psSched->pcName, (unsigned)ui8Quota, psResult->dBulkTotal,
+           psResult->dBulkMin, psResult->dBulkMax, (unsigned)psResult->ui32BulkHeldMax,
+           psResult->pdLatMean[CLASS_DATA], (unsigned)psResult->pui32LatMax[CLASS_DATA],
+           psResult->pdLatMean[CLASS_PRI], (unsigned)psResult->pui32LatMax[CLASS_PRI]);
+}
+
+//*****************************************************************************
+//
+// Tests.
+//
+//*****************************************************************************
+static void
+test_fairness(uint32_t ui32Events)
+{
+    result_t sCore, sFifo;
+    uint32_t ui32Links;
+
+    printf("fairness, %u controller buffers, %u bulk senders:\n", NUM_BUFS, NUM_BULK);
+
+    for (ui32Links = 4; ui32Links <= MAX_LINKS; ui32Links++)
+    {
+        uint32_t ui32Quota = NUM_BUFS - (ui32Links - 1);
+
+        run(&g_sLegacySched, ui32Links, 0, ui32Events, &sFifo);
+        run(&g_sCoreSched, ui32Links, 0, ui32Events, &sCore);
+
+        //
+        // Each bulk sender stays within the default quota and gets its
+        // share, and together they lose no throughput.
+        //
+        CHECK(sCore.ui32BulkHeldMax <= ui32Quota);
+        CHECK(sCore.dBulkMin >= 0.95 * sCore.dBulkMax);
+        CHECK(sCore.dBulkTotal >= 0.98 * sFifo.dBulkTotal);
+
+        //
+        // Light traffic no longer waits behind the bulk senders' packets.
+        //
+        CHECK(sCore.pui32LatMax[CLASS_DATA] <= 4);
+        CHECK(sCore.pui32LatMax[CLASS_PRI] <= 4);
+        CHECK(sCore.pdLatMean[CLASS_DATA] * 4 < sFifo.pdLatMean[CLASS_DATA]);
+        CHECK(sCore.pdLatMean[CLASS_PRI] * 4 < sFifo.pdLatMean[CLASS_PRI]);
+    }
+}
+
+static void
+test_quota(uint32_t ui32Events)
+{
+    result_t sResult;
+
+    printf("HciSetAclConnQuota:\n");
+
+    //
+    // A smaller quota caps the buffers a bulk sender holds; a quota of every
+    // buffer removes the cap.
+    //
+    run(&g_sCoreSched, 4, 2, ui32Events, &sResult);
+    CHECK(sResult.ui32BulkHeldMax == 2);
+
+    run(&g_sCoreSched, 6, NUM_BUFS, ui32Events, &sResult);
+    CHECK(sResult.ui32BulkHeldMax > NUM_BUFS - 5);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Events = 4000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Events = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Seed = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n connection events per run] [-s seed]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    hciCb.flowCback = app_flow;
+    HciCoreInit();
+
+    test_fairness(ui32Events);
+    test_quota(ui32Events);
+
+    return host_test_result();
+}
@@ -0,0 +1,797 @@
+//*****************************************************************************
+//
+//! @file hci_reasm_test.c
+//!
+//! @brief Benchmark of the allocations and copies per received L2CAP SDU.
+//!
+//! Feeds ACL fragments through hciTrSerialRxIncoming() and the HCI core
+//! handler, built from hci_tr.c and hci_core.c, and counts WSF buffer
+//! allocations and bytes copied per SDU.  The same traffic is also run with
+//! hciCoreAclRxDest() forced to decline, which is the receive path from
+//! before fragments were copied straight into the reassembly buffer.
+//!
+//! Also checks that the fallbacks deliver the same SDUs as the old path: a
+//! non-empty RX queue, a start fragment arriving during reassembly, a
+//! continuation longer than the remaining length, and random traffic over
+//! several connections with packets split across calls.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "wsf_types.h"
+#include "wsf_buf.h"
+#include "wsf_msg.h"
+#include "wsf_os.h"
+#include "wsf_cs.h"
+#include "wsf_assert.h"
+#include "bstream.h"
+#include "hci_api.h"
+#include "hci_core.h"
+#include "hci_core_ps.h"
+#include "hci_tr.h"
+#include "hci_tr_apollo.h"
+#include "hci_cmd.h"
+#include "hci_evt.h"
+#include "hci_drv.h"
+#include "hci_main.h"
+#include "l2c_defs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define MAX_RX_ACL_LEN              512
+#define MAX_PACKET                  (1 + HCI_ACL_HDR_LEN + 255)
+#define NUM_CONNS                   4
+#define MAX_SDUS                    4096
+#define NUM_RANDOM_SDUS             2000
+
+//*****************************************************************************
+//
+// Types
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t    ui32Sdus;
+    uint32_t    ui32Allocs;
+    uint32_t    ui32Copied;
+    uint32_t    ui32Direct;
+    uint32_t    ui32Fragments;
+}
+counts_t;
+
+//
+// An L2CAP SDU being sent by the controller on one connection.
+//
+typedef struct
+{
+    uint16_t    ui16Handle;
+    uint16_t    ui16Length;
+    uint16_t    ui16Sent;
+    uint32_t    ui32Id;
+}
+sdu_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static int32_t g_i32Bufs;
+static bool g_bCounting;
+static bool g_bLegacy;
+static counts_t g_sCounts;
+
+static uint32_t g_pui32Delivered[MAX_SDUS];
+static uint32_t g_ui32Delivered;
+static uint32_t g_ui32BadSdus;
+
+hciCb_t hciCb;
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// WSF and HCI entry points hci_tr.c and hci_core.c link against.
+//
+//*****************************************************************************
+void *
+WsfBufAlloc(uint16_t len)
+{
+    if (g_bCounting)
+    {
+        g_sCounts.ui32Allocs++;
+    }
+
+    g_i32Bufs++;
+    return malloc(len);
+}
+
+void
+WsfBufFree(void *pBuf)
+{
+    g_i32Bufs--;
+    free(pBuf);
+}
+
+wsfQueue_t *WsfTaskMsgQueue(wsfHandlerId_t handlerId) { (void)handlerId; return NULL; }
+void WsfTaskSetReady(wsfHandlerId_t handlerId, wsfTaskEvent_t event) { (void)handlerId; (void)event; }
+void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event) { (void)handlerId; (void)event; }
+void WsfCsEnter(void) { }
+void WsfCsExit(void) { }
+
+void hciCoreResetStart(void) { }
+void hciCmdInit(void) { }
+void hciCmdTimeout(wsfMsgHdr_t *pMsg) { (void)pMsg; }
+void hciCoreResetSequence(uint8_t *pMsg) { (void)pMsg; }
+void hciEvtProcessMsg(uint8_t *pEvt) { (void)pEvt; }
+
+uint16_t
+hciDrvWrite(uint8_t type, uint16_t len, uint8_t *pData)
+{
+    (void)type;
+    (void)pData;
+    return len;
+}
+
+//
+// Every memcpy() in the objects under test comes here (-Wl,--wrap=memcpy,
+// with the builtin disabled so that none are inlined).
+//
+void *__real_memcpy(void *pDest, const void *pSrc, size_t len);
+
+void *
+__wrap_memcpy(void *pDest, const void *pSrc, size_t len)
+{
+    if (g_bCounting)
+    {
+        g_sCounts.ui32Copied += len;
+    }
+
+    return __real_memcpy(pDest, pSrc, len);
+}
+
+//
+// The direct path, or the old one when it always declines.
+//
+uint8_t *__real_hciCoreAclRxDest(uint8_t *pHdr, uint8_t *pData);
+
+uint8_t *
+__wrap_hciCoreAclRxDest(uint8_t *pHdr, uint8_t *pData)
+{
+    uint8_t *pDest;
+
+    if (g_bLegacy)
+    {
+        return NULL;
+    }
+
+    pDest = __real_hciCoreAclRxDest(pHdr, pData);
+    if (pDest && g_bCounting)
+    {
+        g_sCounts.ui32Direct++;
+    }
+
+    return pDest;
+}
+
+//*****************************************************************************
+//
+// SDU contents and delivery.
+//
+//*****************************************************************************
+static uint8_t
+sdu_byte(uint32_t ui32Id, uint32_t ui32Index)
+{
+    return (uint8_t)(ui32Id * 31 + ui32Index * 7 + (ui32Index >> 8));
+}
+
+//
+// L2CAP packet byte i of an SDU: the header, then the SDU id, then the
+// pattern.
+//
+static uint8_t
+l2c_byte(const sdu_t *psSdu, uint32_t i)
+{
+    uint8_t pui8Hdr[L2C_HDR_LEN + 4];
+
+    if (i < L2C_HDR_LEN + 4)
+    {
+        pui8Hdr[0] = (uint8_t)psSdu->ui16Length;
+        pui8Hdr[1] = (uint8_t)(psSdu->ui16Length >> 8);
+        pui8Hdr[2] = 0x04;
+        pui8Hdr[3] = 0x00;
+        pui8Hdr[4] = (uint8_t)psSdu->ui32Id;
+        pui8Hdr[5] = (uint8_t)(psSdu->ui32Id >> 8);
+        pui8Hdr[6] = (uint8_t)(psSdu->ui32Id >> 16);
+        pui8Hdr[7] = (uint8_t)(psSdu->ui32Id >> 24);
+        return pui8Hdr[i];
+    }
+
+    return sdu_byte(psSdu->ui32Id, i);
+}
+
+static void
+acl_received(uint8_t *pData)
+{
+    uint16_t ui16Handle, ui16AclLen, ui16L2cLen;
+    uint32_t ui32Id, i;
+    bool bBad = false;
+
+    BYTES_TO_UINT16(ui16Handle, pData);
+    BYTES_TO_UINT16(ui16AclLen, &pData[2]);
+    BYTES_TO_UINT16(ui16L2cLen, &pData[HCI_ACL_HDR_LEN]);
+    BYTES_TO_UINT32(ui32Id, &pData[HCI_ACL_HDR_LEN + L2C_HDR_LEN]);
+
+    if ((ui16AclLen != ui16L2cLen + L2C_HDR_LEN) || (ui16L2cLen < 4) ||
+        ((ui16Handle & HCI_HANDLE_MASK) != 1 + ui32Id % NUM_CONNS))
+    {
+        bBad = true;
+    }
+    else
+    {
+        for (i = L2C_HDR_LEN + 4; i < ui16AclLen; i++)
+        {
+            if (pData[HCI_ACL_HDR_LEN + i] != sdu_byte(ui32Id, i))
+            {
+                bBad = true;
+                break;
+            }
+        }
+    }
+
+    if (bBad)
+    {
+        g_ui32BadSdus++;
+    }
+    else if (g_ui32Delivered < MAX_SDUS)
+    {
+        g_pui32Delivered[g_ui32Delivered++] = ui32Id;
+    }
+
+    if (g_bCounting)
+    {
+        g_sCounts.ui32Sdus++;
+    }
+
+    WsfMsgFree(pData);
+}
+
+//*****************************************************************************
+//
+// Controller side.
+//
+//*****************************************************************************
+static void
+rx_feed(uint8_t *pui8Packet, uint32_t ui32Length, bool bSplit)
+{
+    uint16_t ui16Done = 0;
+
+    g_bCounting = true;
+    if (bSplit && (ui32Length > 2))
+    {
+        uint16_t ui16Cut = 1 + rand_next() % (ui32Length - 1);
+
+        ui16Done = hciTrSerialRxIncoming(pui8Packet, ui16Cut);
+        CHECK(ui16Done == ui16Cut);
+    }
+    ui16Done += hciTrSerialRxIncoming(pui8Packet + ui16Done, ui32Length - ui16Done);
+    g_bCounting = false;
+
+    CHECK(ui16Done == ui32Length);
+}
+
+static void
+rx_handler(void)
+{
+    g_bCounting = true;
+    HciCoreHandler(HCI_EVT_RX, NULL);
+    g_bCounting = false;
+}
+
+//
+// Send the next fragment of an SDU, of at most ui32Frag payload bytes, or
+// ui32Len bytes exactly when that is non-zero.
+//
+static void
+send_fragment(sdu_t *psSdu, uint32_t ui32Frag, uint32_t ui32Len, bool bSplit)
+{
+    uint8_t pui8Packet[MAX_PACKET];
+    uint32_t ui32Total = psSdu->ui16Length + L2C_HDR_LEN;
+    uint32_t ui32Left = ui32Total - psSdu->ui16Sent;
+    uint32_t i;
+    uint16_t ui16Hdr;
+
+    if (ui32Len == 0)
+    {
+        ui32Len = (ui32Left < ui32Frag) ? ui32Left : ui32Frag;
+    }
+
+    ui16Hdr = psSdu->ui16Handle | (psSdu->ui16Sent ? HCI_PB_CONTINUE : HCI_PB_START_C2H);
+    pui8Packet[0] = HCI_ACL_TYPE;
+    pui8Packet[1] = (uint8_t)ui16Hdr;
+    pui8Packet[2] = (uint8_t)(ui16Hdr >> 8);
+    pui8Packet[3] = (uint8_t)ui32Len;
+    pui8Packet[4] = (uint8_t)(ui32Len >> 8);
+    for (i = 0; i < ui32Len; i++)
+    {
+        pui8Packet[1 + HCI_ACL_HDR_LEN + i] = l2c_byte(psSdu, psSdu->ui16Sent + i);
+    }
+
+    psSdu->ui16Sent += ui32Len;
+    g_sCounts.ui32Fragments++;
+    rx_feed(pui8Packet, 1 + HCI_ACL_HDR_LEN + ui32Len, bSplit);
+}
+
+static void
+send_event(void)
+{
+    uint8_t pui8Packet[1 + HCI_EVT_HDR_LEN + 8] =
+    {
+        HCI_EVT_TYPE, HCI_NUM_CMPL_PKTS_EVT, 5, 1, 0x01, 0x00, 0x01, 0x00
+    };
+
+    rx_feed(pui8Packet, 1 + HCI_EVT_HDR_LEN + 5, false);
+}
+
+static void
+sdu_init(sdu_t *psSdu, uint32_t ui32Id, uint16_t ui16Length)
+{
+    psSdu->ui32Id = ui32Id;
+    psSdu->ui16Handle = 1 + ui32Id % NUM_CONNS;
+    psSdu->ui16Length = ui16Length;
+    psSdu->ui16Sent = 0;
+}
+
+static bool
+sdu_done(const sdu_t *psSdu)
+{
+    return psSdu->ui16Sent == psSdu->ui16Length + L2C_HDR_LEN;
+}
+
+//
+// Send a whole SDU, running the HCI handler after each packet.
+//
+static void
+send_sdu(uint32_t ui32Id, uint16_t ui16Length, uint32_t ui32Frag)
+{
+    sdu_t sSdu;
+
+    sdu_init(&sSdu, ui32Id, ui16Length);
+    while (!sdu_done(&sSdu))
+    {
+        send_fragment(&sSdu, ui32Frag, 0, false);
+        rx_handler();
+    }
+}
+
+static void
+reset(bool bLegacy)
+{
+    uint16_t ui16Handle;
+
+    g_bLegacy = bLegacy;
+    memset(&g_sCounts, 0, sizeof(g_sCounts));
+    g_ui32Delivered = 0;
+    g_ui32BadSdus = 0;
+
+    for (ui16Handle = 1; ui16Handle <= NUM_CONNS; ui16Handle++)
+    {
+        hciCoreConnClose(ui16Handle);
+        hciCoreConnOpen(ui16Handle);
+    }
+}
+
+//*****************************************************************************
+//
+// Tests
+//
+//*****************************************************************************
+static void
+run_profile(bool bLegacy, uint16_t ui16Length, uint32_t ui32Frag, uint32_t ui32Count,
+            counts_t *psCounts)
+{
+    uint32_t i;
+
+    reset(bLegacy);
+    for (i = 0; i < ui32Count; i++)
+    {
+        send_sdu(i, ui16Length, ui32Frag);
+    }
+
+    *psCounts = g_sCounts;
+    CHECK(g_ui32Delivered == ui32Count);
+    CHECK(g_ui32BadSdus == 0);
+    CHECK(g_i32Bufs == 0);
+}
+
+static void
+test_profiles(uint32_t ui32Count)
+{
+    static const struct
+    {
+        uint16_t    ui16Length;
+        uint32_t    ui32Frag;
+    }
+    psProfiles[] =
+    {
+        {244, 27},
+        {244, 251},
+        {400, 251},
+        {20, 27},
+        {200, 251},
+    };
+    uint32_t i;
+
+    printf("per SDU, handler run after every packet:\n");
+    printf("  SDU bytes  fragment  fragments   allocs old/new   bytes copied old/new\n");
+
+    for (i = 0; i < sizeof(psProfiles) / sizeof(psProfiles[0]); i++)
+    {
+        uint32_t ui32L2c = psProfiles[i].ui16Length + L2C_HDR_LEN;
+        uint32_t ui32Frags = (ui32L2c + psProfiles[i].ui32Frag - 1) / psProfiles[i].ui32Frag;
+        counts_t sOld, sNew;
+
+        run_profile(true, psProfiles[i].ui16Length, psProfiles[i].ui32Frag, ui32Count, &sOld);
+        run_profile(false, psProfiles[i].ui16Length, psProfiles[i].ui32Frag, ui32Count, &sNew);
+
+        printf("  %9u  %8u  %9u  %7.1f / %-7.1f  %9.1f / %-9.1f\n",
+               (unsigned)psProfiles[i].ui16Length, (unsigned)psProfiles[i].ui32Frag,
+               (unsigned)ui32Frags,
+               (double)sOld.ui32Allocs / ui32Count, (double)sNew.ui32Allocs / ui32Count,
+               (double)sOld.ui32Copied / ui32Count, (double)sNew.ui32Copied / ui32Count);
+
+        CHECK(sOld.ui32Direct == 0);
+        CHECK(sOld.ui32Sdus == ui32Count);
+        CHECK(sNew.ui32Sdus == ui32Count);
+
+        if (ui32Frags == 1)
+        {
+            //
+            // Single-fragment SDUs keep their one buffer and one copy.
+            //
+            CHECK(sNew.ui32Direct == 0);
+            CHECK(sNew.ui32Allocs == sOld.ui32Allocs);
+            CHECK(sNew.ui32Copied == sOld.ui32Copied);
+            CHECK(sNew.ui32Allocs == ui32Count);
+            CHECK(sNew.ui32Copied == ui32Count * (HCI_ACL_HDR_LEN + ui32L2c));
+        }
+        else
+        {
+            //
+            // The old path allocates a buffer per fragment plus the
+            // reassembly buffer, and copies every byte twice.  The direct
+            // path allocates the reassembly buffer only and copies each
+            // payload byte once.
+            //
+            CHECK(sOld.ui32Allocs == ui32Count * (ui32Frags + 1));
+            CHECK(sOld.ui32Copied == ui32Count * (ui32Frags * HCI_ACL_HDR_LEN + 2 * ui32L2c));
+            CHECK(sNew.ui32Direct == ui32Count * ui32Frags);
+            CHECK(sNew.ui32Allocs == ui32Count);
+            CHECK(sNew.ui32Copied == ui32Count * ui32L2c);
+        }
+    }
+}
+
+//
+// An HCI event still queued when a start fragment arrives sends the whole
+// SDU down the old path; the next one goes direct again.
+//
+static void
+test_queue_not_empty(void)
+{
+    sdu_t sSdu;
+
+    reset(false);
+
+    sdu_init(&sSdu, 0, 244);
+    send_event();
+    while (!sdu_done(&sSdu))
+    {
+        send_fragment(&sSdu, 27, 0, false);
+    }
+    CHECK(g_sCounts.ui32Direct == 0);
+    CHECK(g_sCounts.ui32Allocs == 1 + 10);
+    rx_handler();
+
+    send_sdu(1, 244, 27);
+    CHECK(g_sCounts.ui32Direct == 10);
+
+    CHECK(g_ui32Delivered == 2);
+    CHECK(g_ui32BadSdus == 0);
+    CHECK(g_i32Bufs == 0);
+}
+
+//
+// A start fragment while an SDU is still being reassembled drops the partial
+// SDU, as the old path does, and the new SDU arrives intact.
+//
+static void
+test_start_during_reassembly(void)
+{
+    sdu_t sPartial, sNext;
+
+    reset(false);
+
+    sdu_init(&sPartial, 0, 244);
+    send_fragment(&sPartial, 27, 0, false);
+    rx_handler();
+    send_fragment(&sPartial, 27, 0, false);
+    rx_handler();
+    CHECK(g_sCounts.ui32Direct == 2);
+
+    //
+    // Same connection, so the same handle.
+    //
+    sdu_init(&sNext, NUM_CONNS, 100);
+    send_fragment(&sNext, 27, 0, false);
+    CHECK(g_sCounts.ui32Direct == 2);
+    rx_handler();
+    while (!sdu_done(&sNext))
+    {
+        send_fragment(&sNext, 27, 0, false);
+        rx_handler();
+    }
+    CHECK(g_sCounts.ui32Direct == 2 + 3);
+
+    CHECK(g_ui32Delivered == 1);
+    CHECK(g_pui32Delivered[0] == NUM_CONNS);
+    CHECK(g_ui32BadSdus == 0);
+    CHECK(g_i32Bufs == 0);
+}
+
+//
+// A continuation longer than what is left of the SDU is discarded, as the
+// old path does, and reassembly carries on with the next fragment.
+//
+static void
+test_continuation_too_long(void)
+{
+    uint8_t pui8Packet[1 + HCI_ACL_HDR_LEN + 64];
+    sdu_t sSdu;
+    uint16_t ui16Hdr;
+
+    reset(false);
+
+    sdu_init(&sSdu, 0, 100);
+    send_fragment(&sSdu, 27, 0, false);
+    rx_handler();
+    send_fragment(&sSdu, 27, 0, false);
+    rx_handler();
+    send_fragment(&sSdu, 27, 0, false);
+    rx_handler();
+    CHECK(g_sCounts.ui32Direct == 3);
+
+    //
+    // 23 bytes are left; send 60.
+    //
+    ui16Hdr = sSdu.ui16Handle | HCI_PB_CONTINUE;
+    memset(pui8Packet, 0xA5, sizeof(pui8Packet));
+    pui8Packet[0] = HCI_ACL_TYPE;
+    pui8Packet[1] = (uint8_t)ui16Hdr;
+    pui8Packet[2] = (uint8_t)(ui16Hdr >> 8);
+    pui8Packet[3] = 60;
+    pui8Packet[4] = 0;
+    rx_feed(pui8Packet, 1 + HCI_ACL_HDR_LEN + 60, false);
+    CHECK(g_sCounts.ui32Direct == 3);
+    rx_handler();
+
+    send_fragment(&sSdu, 27, 0, false);
+    rx_handler();
+    CHECK(sdu_done(&sSdu));
+    CHECK(g_sCounts.ui32Direct == 4);
+
+    CHECK(g_ui32Delivered == 1);
+    CHECK(g_ui32BadSdus == 0);
+    CHECK(g_i32Bufs == 0);
+}
+
+//
+// Random traffic: SDUs on several connections with their fragments
+// interleaved, HCI events in between, packets sometimes split across calls,
+// and the handler run at random.  The direct path must deliver exactly what
+// the old path does.
+//
+static void
+run_random(bool bLegacy, uint64_t ui64Seed, uint32_t ui32Count)
+{
+    sdu_t psSdus[NUM_CONNS];
+    uint32_t ui32Started = 0;
+    uint32_t i;
+
+    g_ui64Rand = ui64Seed;
+    reset(bLegacy);
+    memset(psSdus, 0, sizeof(psSdus));
+
+    for (i = 0; i < NUM_CONNS; i++)
+    {
+        sdu_init(&psSdus[i], ui32Started++, 4 + rand_next() % (MAX_RX_ACL_LEN - L2C_HDR_LEN - 4));
+    }
+
+    while (1)
+    {
+        sdu_t *psSdu = &psSdus[rand_next() % NUM_CONNS];
+        uint32_t ui32Frag = (rand_next() & 1) ? 27 : 1 + rand_next() % 251;
+
+        //
+        // A start fragment always carries the whole L2CAP header.
+        //
+        if ((psSdu->ui16Sent == 0) && (ui32Frag < L2C_HDR_LEN))
+        {
+            ui32Frag = L2C_HDR_LEN;
+        }
+
+        if (!(rand_next() % 8))
+        {
+            send_event();
+        }
+
+        if (psSdu->ui16Length)
+        {
+            send_fragment(psSdu, ui32Frag, 0, (rand_next() % 8) == 0);
+            if (sdu_done(psSdu))
+            {
+                if (ui32Started < ui32Count)
+                {
+                    //
+                    // Keep each connection on its own handle.
+                    //
+                    sdu_init(psSdu, ui32Started + NUM_CONNS - 1 -
+                             (ui32Started + NUM_CONNS - 1 - psSdu->ui32Id) % NUM_CONNS,
+                             4 + rand_next() % (MAX_RX_ACL_LEN - L2C_HDR_LEN - 4));
+                    ui32Started++;
+                }
+                else
+                {
+                    psSdu->ui16Length = 0;
+                }
+            }
+        }
+
+        if (rand_next() & 1)
+        {
+            rx_handler();
+        }
+
+        for (i = 0; i < NUM_CONNS; i++)
+        {
+            if (psSdus[i].ui16Length)
+            {
+                break;
+            }
+        }
+        if (i == NUM_CONNS)
+        {
+            break;
+        }
+    }
+
+    rx_handler();
+    CHECK(g_ui32BadSdus == 0);
+    CHECK(g_i32Bufs == 0);
+}
+
+static void
+test_random(uint64_t ui64Seed)
+{
+    static uint32_t pui32Old[MAX_SDUS];
+    uint32_t ui32Old;
+    counts_t sOld;
+
+    run_random(true, ui64Seed, NUM_RANDOM_SDUS);
+    memcpy(pui32Old, g_pui32Delivered, sizeof(pui32Old));
+    ui32Old = g_ui32Delivered;
+    sOld = g_sCounts;
+
+    run_random(false, ui64Seed, NUM_RANDOM_SDUS);
+
+    printf("random traffic, %u SDUs: allocs %.2f / %.2f, bytes copied %.1f / %.1f per SDU, "
+           "%.0f%% of fragments direct\n",
+           (unsigned)g_ui32Delivered,
+           (double)sOld.ui32Allocs / ui32Old, (double)g_sCounts.ui32Allocs / g_ui32Delivered,
+           (double)sOld.ui32Copied / ui32Old, (double)g_sCounts.ui32Copied / g_ui32Delivered,
+           100.0 * g_sCounts.ui32Direct / g_sCounts.ui32Fragments);
+
+    CHECK(ui32Old == NUM_RANDOM_SDUS);
+    CHECK(g_ui32Delivered == ui32Old);
+    CHECK(memcmp(g_pui32Delivered, pui32Old, ui32Old * sizeof(uint32_t)) == 0);
+    CHECK(g_sCounts.ui32Direct > 0);
+    CHECK(g_sCounts.ui32Allocs < sOld.ui32Allocs);
+    CHECK(g_sCounts.ui32Copied < sOld.ui32Copied);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Count = 1000;
+    uint64_t ui64Seed = g_ui64Rand;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                ui64Seed = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n SDUs per profile] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    HciCoreInit();
+    HciSetMaxRxAclLen(MAX_RX_ACL_LEN);
+    hciCb.aclCback = acl_received;
+
+    test_profiles(ui32Count);
+    test_queue_not_empty();
+    test_start_during_reassembly();
+    test_continuation_too_long();
+    test_random(ui64Seed);
+
+    return host_test_result();
+}
@@ -0,0 +1,592 @@
+//*****************************************************************************
+//
+//! @file hci_rx_test.c
+//!
+//! @brief Benchmark and regression test of the HCI transport receive path.
+//!
+//! Feeds a random mix of HCI events and ACL packets through
+//! hciTrSerialRxIncoming() in whole packets, as the Apollo3 BLEIF driver
+//! hands them over, and split at random points, and checks every packet
+//! delivered to the HCI core against what was sent.  Each arrival pattern is
+//! timed in cycles per byte against the byte-at-a-time receiver the current
+//! one replaced.
+//!
+//! Buffer allocation is also made to fail at random.  The receiver must then
+//! return with the rest of the input unconsumed and deliver the packet intact
+//! when the caller retries with it.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "wsf_types.h"
+#include "wsf_buf.h"
+#include "wsf_msg.h"
+#include "wsf_os.h"
+#include "wsf_cs.h"
+#include "wsf_assert.h"
+#include "bstream.h"
+#include "hci_api.h"
+#include "hci_core.h"
+#include "hci_core_ps.h"
+#include "hci_tr.h"
+#include "hci_tr_apollo.h"
+#include "hci_cmd.h"
+#include "hci_evt.h"
+#include "hci_drv.h"
+#include "hci_main.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define NUM_PACKETS                 4000
+#define STREAM_SIZE                 (NUM_PACKETS * (1 + HCI_ACL_HDR_LEN + 255))
+#define EVT_LEN_MAX                 64
+#define ACL_LEN_MAX                 251
+#define STALL_LIMIT                 100
+
+//*****************************************************************************
+//
+// Types
+//
+//*****************************************************************************
+typedef uint16_t (*rx_fn_t)(uint8_t *pBuf, uint16_t len);
+
+typedef struct
+{
+    uint32_t    ui32Offset;
+    uint16_t    ui16Length;
+}
+packet_t;
+
+typedef struct
+{
+    uint64_t    ui64Ticks;
+    uint32_t    ui32Calls;
+    uint32_t    ui32Retries;
+}
+feed_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static int32_t g_i32Bufs;
+static uint32_t g_ui32AllocFailOdds;
+static uint32_t g_ui32AllocFails;
+
+static uint8_t g_pui8Stream[STREAM_SIZE];
+static uint32_t g_ui32StreamSize;
+static packet_t g_psPackets[NUM_PACKETS];
+static uint32_t g_ui32Delivered;
+static uint32_t g_ui32BadPackets;
+
+hciCb_t hciCb;
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//
+// Cycle counter where the host has one, nanoseconds otherwise.
+//
+static uint64_t
+ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (uint64_t)sTime.tv_sec * 1000000000ull + sTime.tv_nsec;
+#endif
+}
+
+//*****************************************************************************
+//
+// WSF and HCI entry points hci_tr.c and hci_core.c link against.
+//
+//*****************************************************************************
+void *
+WsfBufAlloc(uint16_t len)
+{
+    if (g_ui32AllocFailOdds && (rand_next() % g_ui32AllocFailOdds) == 0)
+    {
+        g_ui32AllocFails++;
+        return NULL;
+    }
+
+    g_i32Bufs++;
+    return malloc(len);
+}
+
+void
+WsfBufFree(void *pBuf)
+{
+    g_i32Bufs--;
+    free(pBuf);
+}
+
+wsfQueue_t *WsfTaskMsgQueue(wsfHandlerId_t handlerId) { (void)handlerId; return NULL; }
+void WsfTaskSetReady(wsfHandlerId_t handlerId, wsfTaskEvent_t event) { (void)handlerId; (void)event; }
+void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event) { (void)handlerId; (void)event; }
+void WsfCsEnter(void) { }
+void WsfCsExit(void) { }
+
+void hciCoreResetStart(void) { }
+void hciCmdInit(void) { }
+void hciCmdTimeout(wsfMsgHdr_t *pMsg) { (void)pMsg; }
+void hciCoreResetSequence(uint8_t *pMsg) { (void)pMsg; }
+void hciEvtProcessMsg(uint8_t *pEvt) { (void)pEvt; }
+
+uint16_t
+hciDrvWrite(uint8_t type, uint16_t len, uint8_t *pData)
+{
+    (void)type;
+    (void)pData;
+    return len;
+}
+
+//*****************************************************************************
+//
+// The receiver hciTrSerialRxIncoming() replaced: one byte per pass of the
+// state machine, kept here as the benchmark baseline.
+//
+//*****************************************************************************
+enum
+{
+    REF_STATE_IDLE,
+    REF_STATE_HEADER,
+    REF_STATE_DATA,
+    REF_STATE_COMPLETE
+};
+
+static uint16_t
+ref_rx_incoming(uint8_t *pBuf, uint16_t len)
+{
+    static uint8_t  stateRx = REF_STATE_IDLE;
+    static uint8_t  pktIndRx;
+    static uint16_t iRx;
+    static uint8_t  hdrRx[HCI_ACL_HDR_LEN];
+    static uint8_t  *pPktRx;
+    static uint8_t  *pDataRx;
+
+    uint8_t         dataByte;
+    uint16_t        consumed_bytes = 0;
+
+    while (len)
+    {
+        dataByte = *pBuf;
+
+        if (stateRx == REF_STATE_IDLE)
+        {
+            pktIndRx = dataByte;
+            iRx = 0;
+            stateRx = REF_STATE_HEADER;
+            pBuf++;
+            consumed_bytes++;
+            len--;
+        }
+        else if (stateRx == REF_STATE_HEADER)
+        {
+            uint8_t hdrLen = (pktIndRx == HCI_EVT_TYPE) ? HCI_EVT_HDR_LEN : HCI_ACL_HDR_LEN;
+            uint16_t dataLen;
+            uint8_t i;
+
+            if (iRx != hdrLen)
+            {
+                hdrRx[iRx++] = dataByte;
+                pBuf++;
+                consumed_bytes++;
+                len--;
+            }
+
+            if (iRx == hdrLen)
+            {
+                if (pktIndRx == HCI_EVT_TYPE)
+                {
+                    dataLen = hdrRx[1];
+                    pPktRx = WsfMsgAlloc(hdrLen + dataLen);
+                }
+                else
+                {
+                    BYTES_TO_UINT16(dataLen, &hdrRx[2]);
+                    pPktRx = WsfMsgDataAlloc(hdrLen + dataLen, 0);
+                }
+
+                if (pPktRx == NULL)
+                {
+                    return consumed_bytes;
+                }
+
+                pDataRx = pPktRx;
+                for (i = 0; i < hdrLen; i++)
+                {
+                    *pDataRx++ = hdrRx[i];
+                }
+
+                iRx = dataLen;
+                stateRx = (iRx == 0) ? REF_STATE_COMPLETE : REF_STATE_DATA;
+            }
+        }
+        else if (stateRx == REF_STATE_DATA)
+        {
+            *pDataRx++ = dataByte;
+            if (--iRx == 0)
+            {
+                stateRx = REF_STATE_COMPLETE;
+            }
+            pBuf++;
+            consumed_bytes++;
+            len--;
+        }
+
+        if (stateRx == REF_STATE_COMPLETE)
+        {
+            hciCoreRecv(pktIndRx, pPktRx);
+            stateRx = REF_STATE_IDLE;
+        }
+    }
+
+    return consumed_bytes;
+}
+
+//*****************************************************************************
+//
+// Traffic.
+//
+//*****************************************************************************
+static void
+stream_build(void)
+{
+    uint32_t i, j, ui32Offset = 0;
+    uint16_t ui16Length;
+    uint8_t *pui8Pkt;
+
+    for (i = 0; i < NUM_PACKETS; i++)
+    {
+        pui8Pkt = &g_pui8Stream[ui32Offset];
+
+        if (rand_next() & 1)
+        {
+            ui16Length = 2 + rand_next() % (EVT_LEN_MAX - 1);
+            pui8Pkt[0] = HCI_EVT_TYPE;
+            pui8Pkt[1] = HCI_LE_META_EVT;
+            pui8Pkt[2] = (uint8_t)ui16Length;
+            j = 1 + HCI_EVT_HDR_LEN;
+        }
+        else
+        {
+            ui16Length = 4 + rand_next() % (ACL_LEN_MAX - 3);
+            pui8Pkt[0] = HCI_ACL_TYPE;
+            UINT16_TO_BUF(&pui8Pkt[1], 0x0001 | HCI_PB_START_C2H);
+            UINT16_TO_BUF(&pui8Pkt[3], ui16Length);
+            j = 1 + HCI_ACL_HDR_LEN;
+        }
+
+        g_psPackets[i].ui32Offset = ui32Offset;
+        g_psPackets[i].ui16Length = j + ui16Length;
+
+        for (; j < g_psPackets[i].ui16Length; j++)
+        {
+            pui8Pkt[j] = (uint8_t)rand_next();
+        }
+
+        ui32Offset += g_psPackets[i].ui16Length;
+    }
+
+    g_ui32StreamSize = ui32Offset;
+}
+
+//
+// Check what the receiver queued for the HCI core against the stream.
+//
+static void
+drain(void)
+{
+    wsfHandlerId_t ui8Type;
+    uint8_t *pMsg;
+    packet_t *psPkt;
+
+    while ((pMsg = WsfMsgDeq(&hciCb.rxQueue, &ui8Type)) != NULL)
+    {
+        if (g_ui32Delivered >= NUM_PACKETS)
+        {
+            g_ui32BadPackets++;
+        }
+        else
+        {
+            psPkt = &g_psPackets[g_ui32Delivered];
+            if (ui8Type != g_pui8Stream[psPkt->ui32Offset] ||
+                memcmp(pMsg, &g_pui8Stream[psPkt->ui32Offset + 1], psPkt->ui16Length - 1) != 0)
+            {
+                g_ui32BadPackets++;
+            }
+        }
+
+        g_ui32Delivered++;
+        WsfMsgFree(pMsg);
+    }
+}
+
+//
+// Hand the stream to the receiver in whole packets (ui32MaxChunk 0) or in
+// chunks of 1 to ui32MaxChunk bytes.  Whatever the receiver does not consume
+// is handed to it again, as the BLEIF driver does.
+//
+static void
+feed(rx_fn_t pfnRx, uint32_t ui32MaxChunk, feed_t *psFeed)
+{
+    uint32_t ui32Offset = 0, ui32Pkt = 0, ui32Stall = 0;
+    uint32_t ui32Chunk;
+    uint16_t ui16Consumed;
+    uint64_t ui64Start;
+
+    memset(psFeed, 0, sizeof(*psFeed));
+    g_ui32Delivered = 0;
+    g_ui32BadPackets = 0;
+
+    ui64Start = ticks();
+
+    while (ui32Offset < g_ui32StreamSize)
+    {
+        if (ui32MaxChunk == 0)
+        {
+            while (g_psPackets[ui32Pkt].ui32Offset + g_psPackets[ui32Pkt].ui16Length <= ui32Offset)
+            {
+                ui32Pkt++;
+            }
+            ui32Chunk = g_psPackets[ui32Pkt].ui32Offset + g_psPackets[ui32Pkt].ui16Length - ui32Offset;
+        }
+        else
+        {
+            ui32Chunk = 1 + rand_next() % ui32MaxChunk;
+            if (ui32Chunk > g_ui32StreamSize - ui32Offset)
+            {
+                ui32Chunk = g_ui32StreamSize - ui32Offset;
+            }
+        }
+
+        ui16Consumed = pfnRx(&g_pui8Stream[ui32Offset], ui32Chunk);
+        ui32Offset += ui16Consumed;
+        psFeed->ui32Calls++;
+
+        if (ui16Consumed < ui32Chunk)
+        {
+            psFeed->ui32Retries++;
+            if (pfnRx == hciTrSerialRxIncoming)
+            {
+                CHECK(hciTrReceivingPacket());
+            }
+        }
+
+        ui32Stall = ui16Consumed ? 0 : ui32Stall + 1;
+        if (ui32Stall == STALL_LIMIT)
+        {
+            CHECK(ui32Stall < STALL_LIMIT);
+            break;
+        }
+
+        drain();
+    }
+
+    psFeed->ui64Ticks = ticks() - ui64Start;
+}
+
+//*****************************************************************************
+//
+// Tests.
+//
+//*****************************************************************************
+static void
+check_feed(rx_fn_t pfnRx, uint32_t ui32MaxChunk, feed_t *psFeed)
+{
+    feed(pfnRx, ui32MaxChunk, psFeed);
+
+    CHECK(g_ui32Delivered == NUM_PACKETS);
+    CHECK(g_ui32BadPackets == 0);
+    CHECK(g_i32Bufs == 0);
+
+    if (pfnRx == hciTrSerialRxIncoming)
+    {
+        CHECK(!hciTrReceivingPacket());
+    }
+}
+
+static void
+test_throughput(uint32_t ui32Reps)
+{
+    static const uint32_t pui32Chunks[] = {0, 64, 8, 1};
+    feed_t sNew, sRef;
+    uint64_t ui64New, ui64Ref;
+    uint32_t i, r;
+
+    printf("receive cost, %u packets, %u bytes:\n", NUM_PACKETS, (unsigned)g_ui32StreamSize);
+
+    for (i = 0; i < sizeof(pui32Chunks) / sizeof(pui32Chunks[0]); i++)
+    {
+        ui64New = ui64Ref = ~0ull;
+
+        for (r = 0; r < ui32Reps; r++)
+        {
+            check_feed(ref_rx_incoming, pui32Chunks[i], &sRef);
+            ui64Ref = (sRef.ui64Ticks < ui64Ref) ? sRef.ui64Ticks : ui64Ref;
+
+            check_feed(hciTrSerialRxIncoming, pui32Chunks[i], &sNew);
+            ui64New = (sNew.ui64Ticks < ui64New) ? sNew.ui64Ticks : ui64New;
+        }
+
+        if (pui32Chunks[i] == 0)
+        {
+            printf("  whole packets:    ");
+        }
+        else if (pui32Chunks[i] == 1)
+        {
+            printf("  single bytes:     ");
+        }
+        else
+        {
+            printf("  1-%-2u byte chunks: ", (unsigned)pui32Chunks[i]);
+        }
+
+        printf("%6.2f cycles/byte, byte-at-a-time %6.2f\n",
+               (double)ui64New / g_ui32StreamSize, (double)ui64Ref / g_ui32StreamSize);
+
+        //
+        // No arrival size may be slower than byte-at-a-time.  The best of
+        // several runs is compared, with 10% allowed for timing noise.
+        //
+        CHECK(ui64New * 10 <= ui64Ref * 11);
+    }
+}
+
+static void
+test_alloc_retry(void)
+{
+    static const uint32_t pui32Chunks[] = {0, 64, 1};
+    feed_t sFeed;
+    uint32_t i;
+
+    //
+    // One allocation in four fails, often several in a row, on the whole
+    // packet path, in the header state and after a split header.
+    //
+    g_ui32AllocFailOdds = 4;
+
+    for (i = 0; i < sizeof(pui32Chunks) / sizeof(pui32Chunks[0]); i++)
+    {
+        g_ui32AllocFails = 0;
+        check_feed(hciTrSerialRxIncoming, pui32Chunks[i], &sFeed);
+        CHECK(g_ui32AllocFails > NUM_PACKETS / 8);
+        CHECK(sFeed.ui32Retries > 0);
+
+        if (pui32Chunks[i] == 0)
+        {
+            printf("allocation failures, whole packets:    ");
+        }
+        else if (pui32Chunks[i] == 1)
+        {
+            printf("allocation failures, single bytes:     ");
+        }
+        else
+        {
+            printf("allocation failures, 1-%-2u byte chunks: ", (unsigned)pui32Chunks[i]);
+        }
+
+        printf("%u failed, %u retries\n", (unsigned)g_ui32AllocFails,
+               (unsigned)sFeed.ui32Retries);
+    }
+
+    g_ui32AllocFailOdds = 0;
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Reps = 5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r':
+                ui32Reps = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-r timed repetitions] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    HciCoreInit();
+    stream_build();
+
+    test_throughput(ui32Reps);
+    test_alloc_retry();
+
+    return host_test_result();
+}
@@ -0,0 +1,542 @@
+//*****************************************************************************
+//
+//! @file hci_snoop_test.c
+//!
+//! @brief Test and benchmark of the HCI snoop capture ring.
+//!
+//! Includes am_util_hci_snoop.c with host versions of the exclusive access
+//! intrinsics, checks the btsnoop output of am_util_hci_snoop_drain(), drops
+//! when the ring is full, and records made from several threads at once,
+//! then times am_util_hci_snoop_record() per packet.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "am_mcu_apollo.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// LDREX/STREX for the host.  A store-exclusive succeeds if the word still
+// holds the value the load-exclusive returned, which is all the snoop ring
+// needs since its counters only ever increase.
+//
+//*****************************************************************************
+static __thread volatile uint32_t *g_pui32ExAddr;
+static __thread uint32_t g_ui32ExValue;
+
+//
+// Set by the concurrent test to give up the CPU where an interrupt could
+// preempt the recording code.
+//
+static volatile bool g_bPreempt;
+
+static inline uint32_t
+__LDREXW(volatile uint32_t *addr)
+{
+    g_pui32ExAddr = addr;
+    g_ui32ExValue = __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+    if (g_bPreempt)
+    {
+        sched_yield();
+    }
+    return g_ui32ExValue;
+}
+
+static inline uint32_t
+__STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    uint32_t ui32Expected = g_ui32ExValue;
+    bool bStored = (addr == g_pui32ExAddr) &&
+                   __atomic_compare_exchange_n(addr, &ui32Expected, value, false,
+                                               __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+
+    g_pui32ExAddr = NULL;
+    return bStored ? 0 : 1;
+}
+
+static inline void
+__CLREX(void)
+{
+    g_pui32ExAddr = NULL;
+}
+
+#include "am_util_hci_snoop.c"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define TIMER_HZ                    32768
+#define SNAP_LEN                    64
+#define BENCH_RECORDS               256
+#define NUM_PRODUCERS               3
+#define PACKETS_PER_PRODUCER        20000
+#define TARGET_NS                   1000
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32Ticks;
+static uint32_t g_pui32Ring[(64 * 1024) / 4];
+
+//
+// Drained btsnoop output.
+//
+static uint8_t g_pui8Out[1024 * 1024];
+static uint32_t g_ui32OutLen;
+
+//*****************************************************************************
+//
+// HAL entry points the snoop code calls.
+//
+//*****************************************************************************
+//
+// Called between reserving a record and publishing it.
+//
+uint32_t
+am_hal_stimer_counter_get(void)
+{
+    if (g_bPreempt)
+    {
+        sched_yield();
+    }
+    return g_ui32Ticks;
+}
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+static void
+out_write(void *pvContext, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    (void)pvContext;
+
+    if (g_ui32OutLen + ui32Length <= sizeof(g_pui8Out))
+    {
+        memcpy(&g_pui8Out[g_ui32OutLen], pui8Data, ui32Length);
+    }
+    g_ui32OutLen += ui32Length;
+}
+
+static void
+null_write(void *pvContext, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    (void)pui8Data;
+    *(uint32_t *)pvContext += ui32Length;
+}
+
+static uint32_t
+get_be32(const uint8_t *pui8Src)
+{
+    return ((uint32_t)pui8Src[0] << 24) | ((uint32_t)pui8Src[1] << 16) |
+           ((uint32_t)pui8Src[2] << 8) | pui8Src[3];
+}
+
+static void
+snoop_start(uint32_t ui32BufferSize, uint32_t ui32SnapLen)
+{
+    am_util_hci_snoop_config_t sConfig =
+    {
+        .pvBuffer = g_pui32Ring,
+        .ui32BufferSize = ui32BufferSize,
+        .ui32SnapLen = ui32SnapLen,
+        .ui32TimerHz = TIMER_HZ,
+    };
+
+    CHECK(am_util_hci_snoop_init(&sConfig) == AM_HAL_STATUS_SUCCESS);
+    g_ui32OutLen = 0;
+}
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (uint64_t)sTime.tv_sec * 1000000000ull + sTime.tv_nsec;
+}
+
+static int
+compare_u64(const void *pvA, const void *pvB)
+{
+    uint64_t a = *(const uint64_t *)pvA, b = *(const uint64_t *)pvB;
+
+    return (a > b) - (a < b);
+}
+
+//*****************************************************************************
+//
+// Tests
+//
+//*****************************************************************************
+//
+// Each field of the btsnoop output, including truncation to the snap length
+// and timestamps across a counter wrap.
+//
+static void
+test_format(void)
+{
+    static const uint8_t pui8Cmd[] = {0x03, 0x0C, 0x00};
+    uint8_t pui8Acl[200];
+    const uint8_t *p;
+    uint64_t ui64Us;
+
+    for (uint32_t i = 0; i < sizeof(pui8Acl); i++)
+    {
+        pui8Acl[i] = (uint8_t)(i * 3 + 1);
+    }
+
+    CHECK(am_util_hci_snoop_init(NULL) == AM_HAL_STATUS_INVALID_ARG);
+
+    g_ui32Ticks = 0xFFFF0000;
+    snoop_start(sizeof(g_pui32Ring), SNAP_LEN);
+
+    g_ui32Ticks += TIMER_HZ;
+    am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_SENT, 0x01, pui8Cmd, sizeof(pui8Cmd));
+    g_ui32Ticks += 0x20000;
+    am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_RECEIVED, 0x02, pui8Acl, sizeof(pui8Acl));
+
+    //
+    // An interrupt's packet can be recorded with an earlier timestamp.
+    //
+    g_ui32Ticks -= 100;
+    am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_RECEIVED, 0x04, pui8Cmd, 2);
+
+    CHECK(am_util_hci_snoop_drain(out_write, NULL, 0) == 3);
+    CHECK(g_ui32OutLen == 16 + (24 + 1 + 3) + (24 + 1 + SNAP_LEN - 1) + (24 + 1 + 2));
+
+    p = g_pui8Out;
+    CHECK(memcmp(p, "btsnoop", 8) == 0);
+    CHECK(get_be32(&p[8]) == 1);
+    CHECK(get_be32(&p[12]) == 1002);
+    p += 16;
+
+    CHECK(get_be32(&p[0]) == 4);
+    CHECK(get_be32(&p[4]) == 4);
+    CHECK(get_be32(&p[8]) == 0x02);
+    CHECK(get_be32(&p[12]) == 0);
+    ui64Us = ((uint64_t)get_be32(&p[16]) << 32) | get_be32(&p[20]);
+    CHECK(ui64Us == SNOOP_EPOCH_DELTA_US + (0xFFFF0000ull + TIMER_HZ) * 1000000 / TIMER_HZ);
+    CHECK(p[24] == 0x01);
+    CHECK(memcmp(&p[25], pui8Cmd, sizeof(pui8Cmd)) == 0);
+    p += 24 + 1 + 3;
+
+    CHECK(get_be32(&p[0]) == 1 + sizeof(pui8Acl));
+    CHECK(get_be32(&p[4]) == SNAP_LEN);
+    CHECK(get_be32(&p[8]) == 0x01);
+    ui64Us = ((uint64_t)get_be32(&p[16]) << 32) | get_be32(&p[20]);
+    CHECK(ui64Us == SNOOP_EPOCH_DELTA_US +
+                    (0xFFFF0000ull + TIMER_HZ + 0x20000) * 1000000 / TIMER_HZ);
+    CHECK(p[24] == 0x02);
+    CHECK(memcmp(&p[25], pui8Acl, SNAP_LEN - 1) == 0);
+    p += 24 + 1 + SNAP_LEN - 1;
+
+    CHECK(get_be32(&p[0]) == 3);
+    CHECK(get_be32(&p[8]) == 0x03);
+    ui64Us = ((uint64_t)get_be32(&p[16]) << 32) | get_be32(&p[20]);
+    CHECK(ui64Us == SNOOP_EPOCH_DELTA_US +
+                    (0xFFFF0000ull + TIMER_HZ + 0x20000 - 100) * 1000000 / TIMER_HZ);
+
+    //
+    // Nothing more, and no second file header.
+    //
+    CHECK(am_util_hci_snoop_drain(out_write, NULL, 0) == 0);
+    CHECK(g_ui32OutLen == 16 + (24 + 1 + 3) + (24 + 1 + SNAP_LEN - 1) + (24 + 1 + 2));
+
+    am_util_hci_snoop_disable();
+    am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_SENT, 0x01, pui8Cmd, sizeof(pui8Cmd));
+    CHECK(am_util_hci_snoop_drain(out_write, NULL, 0) == 0);
+}
+
+//
+// A full ring counts drops, and the count shows up in later records.
+//
+static void
+test_full(void)
+{
+    uint8_t pui8Data[8] = {0};
+    uint32_t ui32Records = 8;
+    const uint8_t *p;
+
+    snoop_start(ui32Records * AM_UTIL_HCI_SNOOP_RECORD_SIZE(SNAP_LEN) +
+                AM_UTIL_HCI_SNOOP_RECORD_SIZE(SNAP_LEN) / 2, SNAP_LEN);
+
+    for (uint32_t i = 0; i < ui32Records + 5; i++)
+    {
+        pui8Data[0] = (uint8_t)i;
+        am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_SENT, 0x02, pui8Data, sizeof(pui8Data));
+    }
+    CHECK(am_util_hci_snoop_dropped() == 5);
+
+    CHECK(am_util_hci_snoop_drain(out_write, NULL, 3) == 3);
+    am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_SENT, 0x02, pui8Data, sizeof(pui8Data));
+    CHECK(am_util_hci_snoop_drain(out_write, NULL, 0) == ui32Records - 3 + 1);
+    CHECK(g_ui32OutLen == 16 + (ui32Records + 1) * (24 + 1 + sizeof(pui8Data)));
+
+    p = &g_pui8Out[16];
+    for (uint32_t i = 0; i < ui32Records + 1; i++)
+    {
+        CHECK(get_be32(&p[12]) == 5);
+        CHECK(p[25] == ((i < ui32Records) ? i : ui32Records + 4));
+        p += 24 + 1 + sizeof(pui8Data);
+    }
+}
+
+//
+// Several producers and a reader at once: every record is either drained
+// intact, in order per producer, or counted as dropped.
+//
+static uint32_t g_ui32ProducersDone;
+
+static void *
+producer(void *pvArg)
+{
+    uint32_t ui32Producer = (uint32_t)(uintptr_t)pvArg;
+    uint8_t pui8Data[SNAP_LEN + 16];
+
+    for (uint32_t i = 0; i < PACKETS_PER_PRODUCER; i++)
+    {
+        uint32_t ui32Length = 8 + (i * 7 + ui32Producer) % (sizeof(pui8Data) - 8);
+
+        memcpy(pui8Data, &ui32Producer, 4);
+        memcpy(&pui8Data[4], &i, 4);
+        for (uint32_t j = 8; j < ui32Length; j++)
+        {
+            pui8Data[j] = (uint8_t)(i + j);
+        }
+
+        __atomic_fetch_add(&g_ui32Ticks, 1, __ATOMIC_RELAXED);
+        am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_RECEIVED, 0x02, pui8Data, ui32Length);
+    }
+
+    __atomic_fetch_add(&g_ui32ProducersDone, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static uint32_t g_pui32Next[NUM_PRODUCERS];
+static uint32_t g_ui32Received;
+static uint32_t g_ui32Corrupt;
+
+static void
+check_write(void *pvContext, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    static uint8_t pui8Record[24 + SNAP_LEN];
+    static uint32_t ui32Have;
+    static bool bFileHeader;
+    uint32_t ui32Producer, ui32Index, ui32Captured;
+
+    (void)pvContext;
+
+    //
+    // The file header comes first.  After that each record header arrives in
+    // one write and its packet in the next.
+    //
+    if (!bFileHeader)
+    {
+        bFileHeader = true;
+        return;
+    }
+    memcpy(&pui8Record[ui32Have], pui8Data, ui32Length);
+    ui32Have += ui32Length;
+    if (ui32Have == 25)
+    {
+        return;
+    }
+
+    ui32Captured = get_be32(&pui8Record[4]) - 1;
+    memcpy(&ui32Producer, &pui8Record[25], 4);
+    memcpy(&ui32Index, &pui8Record[29], 4);
+    ui32Have = 0;
+
+    if ((ui32Producer >= NUM_PRODUCERS) || (ui32Index < g_pui32Next[ui32Producer]) ||
+        (get_be32(&pui8Record[0]) - 1 != 8 + (ui32Index * 7 + ui32Producer) % (SNAP_LEN + 8)))
+    {
+        g_ui32Corrupt++;
+        return;
+    }
+
+    for (uint32_t j = 8; j < ui32Captured; j++)
+    {
+        if (pui8Record[25 + j] != (uint8_t)(ui32Index + j))
+        {
+            g_ui32Corrupt++;
+            return;
+        }
+    }
+
+    g_pui32Next[ui32Producer] = ui32Index + 1;
+    g_ui32Received++;
+}
+
+static void
+test_concurrent(void)
+{
+    pthread_t psThreads[NUM_PRODUCERS];
+
+    snoop_start(32 * AM_UTIL_HCI_SNOOP_RECORD_SIZE(SNAP_LEN), SNAP_LEN);
+    g_bPreempt = true;
+
+    for (uint32_t i = 0; i < NUM_PRODUCERS; i++)
+    {
+        CHECK(pthread_create(&psThreads[i], NULL, producer, (void *)(uintptr_t)i) == 0);
+    }
+
+    while (__atomic_load_n(&g_ui32ProducersDone, __ATOMIC_SEQ_CST) < NUM_PRODUCERS)
+    {
+        am_util_hci_snoop_drain(check_write, NULL, 4);
+        sched_yield();
+    }
+
+    for (uint32_t i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_join(psThreads[i], NULL);
+    }
+    am_util_hci_snoop_drain(check_write, NULL, 0);
+    g_bPreempt = false;
+
+    printf("%u producers: %u packets drained, %u dropped\n", NUM_PRODUCERS,
+           (unsigned)g_ui32Received, (unsigned)am_util_hci_snoop_dropped());
+
+    CHECK(g_ui32Corrupt == 0);
+    CHECK(g_ui32Received > 0);
+    CHECK(g_ui32Received + am_util_hci_snoop_dropped() == NUM_PRODUCERS * PACKETS_PER_PRODUCER);
+}
+
+//
+// Time per am_util_hci_snoop_record() call, and per record drained.  Each
+// batch fills most of the ring and is timed on its own; the ring is drained
+// between batches outside the timing.
+//
+static void
+bench(uint32_t ui32Packets)
+{
+    static const uint32_t pui32Sizes[] = {3, 27, 64, 251};
+    uint32_t ui32Batches = (ui32Packets + BENCH_RECORDS - 2) / (BENCH_RECORDS - 1);
+    uint64_t *pui64Batch = malloc(ui32Batches * sizeof(uint64_t));
+    uint8_t pui8Data[256];
+    uint32_t ui32Sink = 0;
+
+    memset(pui8Data, 0x5A, sizeof(pui8Data));
+
+    printf("am_util_hci_snoop_record(), snap length %u, median of %u batches of %u:\n",
+           SNAP_LEN, (unsigned)ui32Batches, BENCH_RECORDS - 1);
+
+    for (uint32_t s = 0; s < sizeof(pui32Sizes) / sizeof(pui32Sizes[0]); s++)
+    {
+        double dRecordNs, dDrainNs;
+        uint64_t ui64Drain = 0;
+
+        snoop_start(BENCH_RECORDS * AM_UTIL_HCI_SNOOP_RECORD_SIZE(SNAP_LEN), SNAP_LEN);
+
+        for (uint32_t b = 0; b < ui32Batches; b++)
+        {
+            uint64_t ui64Start = now_ns();
+
+            for (uint32_t i = 0; i < BENCH_RECORDS - 1; i++)
+            {
+                am_util_hci_snoop_record(AM_UTIL_HCI_SNOOP_SENT, 0x02, pui8Data, pui32Sizes[s]);
+            }
+            pui64Batch[b] = now_ns() - ui64Start;
+
+            ui64Start = now_ns();
+            CHECK(am_util_hci_snoop_drain(null_write, &ui32Sink, 0) == BENCH_RECORDS - 1);
+            ui64Drain += now_ns() - ui64Start;
+        }
+
+        qsort(pui64Batch, ui32Batches, sizeof(uint64_t), compare_u64);
+        dRecordNs = (double)pui64Batch[ui32Batches / 2] / (BENCH_RECORDS - 1);
+        dDrainNs = (double)ui64Drain / ((uint64_t)ui32Batches * (BENCH_RECORDS - 1));
+
+        printf("  %3u-byte packet: %6.1f ns per record, %6.1f ns per record drained\n",
+               (unsigned)pui32Sizes[s], dRecordNs, dDrainNs);
+
+        CHECK(am_util_hci_snoop_dropped() == 0);
+        CHECK(dRecordNs < TARGET_NS);
+    }
+
+    free(pui64Batch);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Packets = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Packets = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n packets per size]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    test_format();
+    test_full();
+    test_concurrent();
+    bench(ui32Packets);
+
+    return host_test_result();
+}
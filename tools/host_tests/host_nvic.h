@@ -0,0 +1,63 @@
+//*****************************************************************************
+//
+//! @file host_nvic.h
+//!
+//! @brief NVIC access macros for host builds.
+//!
+//!
+//! Selected with CMSIS_NVIC_VIRTUAL so that drivers which enable or disable
+//! their interrupt in the NVIC can be built and run on the host.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#ifndef HOST_NVIC_H
+#define HOST_NVIC_H
+
+#define NVIC_EnableIRQ(irq)             ((void)(irq))
+#define NVIC_DisableIRQ(irq)            ((void)(irq))
+#define NVIC_GetEnableIRQ(irq)          (0)
+#define NVIC_SetPriority(irq, prio)     ((void)(irq), (void)(prio))
+#define NVIC_GetPriority(irq)           (0)
+#define NVIC_ClearPendingIRQ(irq)       ((void)(irq))
+#define NVIC_SetPendingIRQ(irq)         ((void)(irq))
+#define NVIC_GetPendingIRQ(irq)         (0)
+
+#endif // HOST_NVIC_H
@@ -0,0 +1,86 @@
+//*****************************************************************************
+//
+//! @file host_regs.h
+//!
+//! @brief Peripheral register blocks for host builds.
+//!
+//!
+//! Maps RAM at the address of a peripheral's register block so a HAL module
+//! can be run unmodified on the host, with the test playing the hardware by
+//! reading and writing the same registers.  Tests that use it are linked
+//! -no-pie so the fixed mapping does not collide with the executable.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#ifndef HOST_REGS_H
+#define HOST_REGS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     0x100000
+#endif
+
+//*****************************************************************************
+//
+// Map zeroed RAM over [ui32Base, ui32Base + ui32Size).  Exits on failure.
+//
+//*****************************************************************************
+static inline void
+host_regs_map(uint32_t ui32Base, uint32_t ui32Size)
+{
+    uintptr_t uiStart = ui32Base & ~(uintptr_t)0xFFF;
+    uintptr_t uiEnd = ((uintptr_t)ui32Base + ui32Size + 0xFFF) & ~(uintptr_t)0xFFF;
+    void *pMap;
+
+    pMap = mmap((void *)uiStart, uiEnd - uiStart, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (pMap != (void *)uiStart)
+    {
+        fprintf(stderr, "Cannot map registers at 0x%08x\n", (unsigned)ui32Base);
+        exit(2);
+    }
+}
+
+#endif // HOST_REGS_H
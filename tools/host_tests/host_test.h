@@ -0,0 +1,125 @@
+//*****************************************************************************
+//
+//! @file host_test.h
+//!
+//! @brief Checks, result reporting and HAL stubs shared by the host tests.
+//!
+//!
+//! Each test is one translation unit that includes this header once.
+//! Include it after am_mcu_apollo.h to also get the interrupt master
+//! stubs, which track whether the code under test has interrupts masked
+//! in g_bIntDisabled.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//*****************************************************************************
+//
+// Count a failure, with its location, if cond is false.
+//
+//*****************************************************************************
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);         \
+            g_ui32Failures++;                                               \
+        }                                                                   \
+    } while (0)
+
+static uint32_t g_ui32Failures;
+
+//*****************************************************************************
+//
+// Print the result line "make run" looks for and return the exit status.
+//
+//*****************************************************************************
+static inline int
+host_test_result(void)
+{
+    printf("%s: %u failure(s)\n", g_ui32Failures ? "FAIL" : "PASS",
+           (unsigned)g_ui32Failures);
+
+    return g_ui32Failures ? 1 : 0;
+}
+
+#ifdef AM_HAL_INTERRUPT_H
+//*****************************************************************************
+//
+// Interrupt master stubs.  There is nothing to mask on the host, so these
+// only record the state for tests that check it.
+//
+//*****************************************************************************
+static bool g_bIntDisabled;
+
+uint32_t
+am_hal_interrupt_master_disable(void)
+{
+    uint32_t ui32Old = g_bIntDisabled;
+
+    g_bIntDisabled = true;
+    return ui32Old;
+}
+
+uint32_t
+am_hal_interrupt_master_enable(void)
+{
+    uint32_t ui32Old = g_bIntDisabled;
+
+    g_bIntDisabled = false;
+    return ui32Old;
+}
+
+void
+am_hal_interrupt_master_set(uint32_t ui32InterruptState)
+{
+    g_bIntDisabled = ui32InterruptState != 0;
+}
+#endif // AM_HAL_INTERRUPT_H
+
+#endif // HOST_TEST_H
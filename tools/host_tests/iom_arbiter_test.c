@@ -0,0 +1,789 @@
+//*****************************************************************************
+//
+//! @file iom_arbiter_test.c
+//!
+//! @brief Host test of the IOM arbiter.
+//!
+//!
+//! Runs am_util_iom_arbiter against a model of one IOM in SPI mode (1 byte
+//! per microsecond plus a fixed setup time per transaction) and checks:
+//!
+//! - Request priority: a later, higher priority request overtakes queued
+//!   work, requests of equal priority from one client stay in order.
+//! - Refused transfers: a queue of requests the IOM refuses completes in
+//!   submission order, without nesting callbacks.
+//! - Failed chains: a bContinue chain that fails part way is closed with a
+//!   transfer that releases CS before its callback runs.
+//! - Mixed load: sensor reads, FRAM writes and display streams share the bus.
+//!   Reports p50/p99 latency per client from the arbiter's histogram, checks
+//!   them against the exact values, and checks that priorities keep the
+//!   sensor p99 well below a run with every request at the same priority.
+//!
+//! Usage: iom_arbiter_test [-t run_ms]
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "am_util_iom_arbiter.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define IOM_SETUP_US                4
+#define TEST_CHUNK                  256
+#define TEST_POOL                   4
+#define TEST_MAX_LOG                64
+#define TEST_MAX_LATENCIES          (1 << 16)
+
+//*****************************************************************************
+//
+// IOM model.  One transaction at a time, completed by model_run_until().
+//
+//*****************************************************************************
+typedef struct
+{
+    bool                    bBusy;
+    am_hal_iom_transfer_t   sXfer;
+    am_hal_iom_callback_t   pfnCallback;
+    void                    *pCallbackCtxt;
+    uint32_t                ui32DoneAt;
+
+    //
+    // CS state: asserted from the start of a transaction until the end of
+    // one without bContinue.
+    //
+    bool                    bCs;
+    uint32_t                ui32CsOwner;
+    uint32_t                ui32CsViolations;
+
+    //
+    // Fault injection: refuse the next ui32Refuse transfers, report an
+    // error for the completion numbered ui32FailCompletion (1 = next).
+    //
+    uint32_t                ui32Refuse;
+    uint32_t                ui32FailCompletion;
+
+    am_hal_iom_transfer_t   sLog[TEST_MAX_LOG];
+    uint32_t                ui32NumLog;
+} iom_model_t;
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static iom_model_t g_sIom;
+static uint32_t g_ui32Now;
+static uint32_t g_ui32CallbackDepth;
+static uint32_t g_ui32MaxCallbackDepth;
+static uint32_t g_pui32Buffer[2048 / 4];
+
+//*****************************************************************************
+//
+// HAL entry points used by the arbiter.
+//
+//*****************************************************************************
+uint32_t
+am_hal_iom_nonblocking_transfer(void *pHandle,
+                                am_hal_iom_transfer_t *psTransaction,
+                                am_hal_iom_callback_t pfnCallback,
+                                void *pCallbackCtxt)
+{
+    (void)pHandle;
+
+    if (g_sIom.ui32Refuse)
+    {
+        g_sIom.ui32Refuse--;
+        return AM_HAL_STATUS_FAIL;
+    }
+
+    //
+    // The arbiter must never queue more than one transaction, nor address
+    // another device while a chain holds CS.
+    //
+    CHECK(!g_sIom.bBusy);
+    if (g_sIom.bCs &&
+        (psTransaction->uPeerInfo.ui32SpiChipSelect != g_sIom.ui32CsOwner))
+    {
+        g_sIom.ui32CsViolations++;
+    }
+
+    g_sIom.bBusy = true;
+    g_sIom.bCs = true;
+    g_sIom.ui32CsOwner = psTransaction->uPeerInfo.ui32SpiChipSelect;
+    g_sIom.sXfer = *psTransaction;
+    g_sIom.pfnCallback = pfnCallback;
+    g_sIom.pCallbackCtxt = pCallbackCtxt;
+    g_sIom.ui32DoneAt = g_ui32Now + IOM_SETUP_US +
+                        psTransaction->ui32InstrLen + psTransaction->ui32NumBytes;
+    if (g_sIom.ui32NumLog < TEST_MAX_LOG)
+    {
+        g_sIom.sLog[g_sIom.ui32NumLog++] = *psTransaction;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static uint32_t
+model_time_get(void)
+{
+    return g_ui32Now;
+}
+
+//*****************************************************************************
+//
+// Complete transactions due by ui32Time, then advance the clock to it.
+//
+//*****************************************************************************
+static void
+model_run_until(uint32_t ui32Time)
+{
+    while (g_sIom.bBusy && ((int32_t)(g_sIom.ui32DoneAt - ui32Time) <= 0))
+    {
+        uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+
+        g_ui32Now = g_sIom.ui32DoneAt;
+        g_sIom.bBusy = false;
+        g_sIom.bCs = g_sIom.sXfer.bContinue;
+        if (g_sIom.ui32FailCompletion && (--g_sIom.ui32FailCompletion == 0))
+        {
+            ui32Status = AM_HAL_STATUS_FAIL;
+        }
+        g_sIom.pfnCallback(g_sIom.pCallbackCtxt, ui32Status);
+    }
+    g_ui32Now = ui32Time;
+}
+
+static void
+model_drain(void)
+{
+    while (g_sIom.bBusy)
+    {
+        model_run_until(g_sIom.ui32DoneAt);
+    }
+}
+
+static void
+model_reset(void)
+{
+    memset(&g_sIom, 0, sizeof(g_sIom));
+    g_ui32Now = 0;
+    g_ui32CallbackDepth = 0;
+    g_ui32MaxCallbackDepth = 0;
+}
+
+static void
+arbiter_setup(am_util_iom_arbiter_t *pArbiter)
+{
+    am_util_iom_arbiter_config_t sConfig =
+    {
+        .pIomHandle = &g_sIom,
+        .ui32MaxChunk = TEST_CHUNK,
+        .ui32MaxSkips = 0,
+        .pfnTimeGet = model_time_get,
+    };
+
+    model_reset();
+    CHECK(am_util_iom_arbiter_init(pArbiter, &sConfig) == AM_HAL_STATUS_SUCCESS);
+}
+
+static void
+request_setup(am_util_iom_arbiter_request_t *pRequest, uint32_t ui32Cs,
+              uint32_t ui32Bytes, uint32_t ui32Priority, bool bAdvanceInstr)
+{
+    memset(pRequest, 0, sizeof(*pRequest));
+    pRequest->sTransfer.uPeerInfo.ui32SpiChipSelect = ui32Cs;
+    pRequest->sTransfer.ui32InstrLen = 1;
+    pRequest->sTransfer.ui32Instr = 0x02;
+    pRequest->sTransfer.ui32NumBytes = ui32Bytes;
+    pRequest->sTransfer.eDirection = AM_HAL_IOM_TX;
+    pRequest->sTransfer.pui32TxBuffer = g_pui32Buffer;
+    pRequest->bAdvanceInstr = bAdvanceInstr;
+    pRequest->ui32Priority = ui32Priority;
+}
+
+//*****************************************************************************
+//
+// Completion recorder for the functional tests.
+//
+//*****************************************************************************
+static uint32_t g_pui32Order[TEST_MAX_LOG];
+static uint32_t g_pui32OrderStatus[TEST_MAX_LOG];
+static bool g_pbOrderCs[TEST_MAX_LOG];     // CS 0 held during the callback
+static uint32_t g_ui32NumOrder;
+
+static void
+order_callback(void *pCallbackCtxt, uint32_t ui32Status)
+{
+    g_ui32CallbackDepth++;
+    if (g_ui32CallbackDepth > g_ui32MaxCallbackDepth)
+    {
+        g_ui32MaxCallbackDepth = g_ui32CallbackDepth;
+    }
+    if (g_ui32NumOrder < TEST_MAX_LOG)
+    {
+        g_pui32Order[g_ui32NumOrder] = (uint32_t)(uintptr_t)pCallbackCtxt;
+        g_pui32OrderStatus[g_ui32NumOrder] = ui32Status;
+        g_pbOrderCs[g_ui32NumOrder] = g_sIom.bCs && (g_sIom.ui32CsOwner == 0);
+        g_ui32NumOrder++;
+    }
+    g_ui32CallbackDepth--;
+}
+
+static void
+order_submit(am_util_iom_arbiter_t *pArbiter,
+             am_util_iom_arbiter_client_t *pClient,
+             am_util_iom_arbiter_request_t *pRequest, uint32_t ui32Id)
+{
+    pRequest->pfnCallback = order_callback;
+    pRequest->pCallbackCtxt = (void *)(uintptr_t)ui32Id;
+    CHECK(am_util_iom_arbiter_submit(pArbiter, pClient, pRequest) == AM_HAL_STATUS_SUCCESS);
+}
+
+//*****************************************************************************
+//
+// Request priority overtakes queued work; equal priorities stay in order.
+//
+//*****************************************************************************
+static void
+test_priority(void)
+{
+    static const uint32_t pui32Expected[] = { 0, 2, 4, 1, 3 };
+    am_util_iom_arbiter_t sArbiter;
+    am_util_iom_arbiter_client_t sClientX, sClientY;
+    am_util_iom_arbiter_request_t sReq[5];
+    uint32_t i;
+
+    arbiter_setup(&sArbiter);
+    am_util_iom_arbiter_client_add(&sArbiter, &sClientX);
+    am_util_iom_arbiter_client_add(&sArbiter, &sClientY);
+    g_ui32NumOrder = 0;
+
+    request_setup(&sReq[0], 0, 64, 0, false);
+    request_setup(&sReq[1], 0, 64, 0, false);
+    request_setup(&sReq[2], 0, 64, 5, false);
+    request_setup(&sReq[3], 0, 64, 0, false);
+    request_setup(&sReq[4], 1, 64, 2, false);
+
+    order_submit(&sArbiter, &sClientX, &sReq[0], 0);
+    order_submit(&sArbiter, &sClientX, &sReq[1], 1);
+    order_submit(&sArbiter, &sClientX, &sReq[2], 2);
+    order_submit(&sArbiter, &sClientX, &sReq[3], 3);
+    order_submit(&sArbiter, &sClientY, &sReq[4], 4);
+    model_drain();
+
+    CHECK(g_ui32NumOrder == 5);
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(g_pui32Order[i] == pui32Expected[i]);
+        CHECK(g_pui32OrderStatus[i] == AM_HAL_STATUS_SUCCESS);
+    }
+    CHECK(am_util_iom_arbiter_idle(&sArbiter));
+}
+
+//*****************************************************************************
+//
+// A queue of requests the IOM refuses drains in order, one callback at a
+// time, after the request that was on the bus.
+//
+//*****************************************************************************
+static void
+test_refused(void)
+{
+    am_util_iom_arbiter_t sArbiter;
+    am_util_iom_arbiter_client_t sClient;
+    static am_util_iom_arbiter_request_t sReq[TEST_MAX_LOG];
+    uint32_t i;
+
+    arbiter_setup(&sArbiter);
+    am_util_iom_arbiter_client_add(&sArbiter, &sClient);
+    g_ui32NumOrder = 0;
+
+    for (i = 0; i < TEST_MAX_LOG; i++)
+    {
+        request_setup(&sReq[i], 0, 16, 0, false);
+        order_submit(&sArbiter, &sClient, &sReq[i], i);
+    }
+
+    g_sIom.ui32Refuse = TEST_MAX_LOG;
+    model_drain();
+
+    CHECK(g_ui32NumOrder == TEST_MAX_LOG);
+    CHECK(g_ui32MaxCallbackDepth == 1);
+    CHECK(g_pui32OrderStatus[0] == AM_HAL_STATUS_SUCCESS);
+    for (i = 0; i < g_ui32NumOrder; i++)
+    {
+        CHECK(g_pui32Order[i] == i);
+        if (i)
+        {
+            CHECK(g_pui32OrderStatus[i] == AM_HAL_STATUS_FAIL);
+        }
+    }
+    CHECK(sClient.ui32Errors == TEST_MAX_LOG - 1);
+    CHECK(am_util_iom_arbiter_idle(&sArbiter));
+
+    //
+    // A refusal with the bus idle completes before submit returns.
+    //
+    g_ui32NumOrder = 0;
+    g_sIom.ui32Refuse = 1;
+    request_setup(&sReq[0], 0, 16, 0, false);
+    order_submit(&sArbiter, &sClient, &sReq[0], 7);
+    CHECK(g_ui32NumOrder == 1);
+    CHECK(g_pui32OrderStatus[0] == AM_HAL_STATUS_FAIL);
+    CHECK(am_util_iom_arbiter_idle(&sArbiter));
+}
+
+//*****************************************************************************
+//
+// A chain that fails part way releases CS before its callback, and no other
+// device is addressed while CS is held.
+//
+//*****************************************************************************
+static void
+test_failed_chain_case(bool bRefuse, uint32_t ui32FailAt, bool bExpectRelease)
+{
+    am_util_iom_arbiter_t sArbiter;
+    am_util_iom_arbiter_client_t sClientA, sClientB;
+    am_util_iom_arbiter_request_t sChain, sOther;
+    am_hal_iom_transfer_t *psLast;
+
+    arbiter_setup(&sArbiter);
+    am_util_iom_arbiter_client_add(&sArbiter, &sClientA);
+    am_util_iom_arbiter_client_add(&sArbiter, &sClientB);
+    g_ui32NumOrder = 0;
+
+    //
+    // 4 chunk chain on CS 0, and a higher priority request on CS 1 that
+    // must wait for the chain (or its release).
+    //
+    request_setup(&sChain, 0, 4 * TEST_CHUNK, 0, false);
+    request_setup(&sOther, 1, 8, 9, false);
+
+    if (bRefuse && (ui32FailAt == 0))
+    {
+        g_sIom.ui32Refuse = 1;
+    }
+    order_submit(&sArbiter, &sClientA, &sChain, 0);
+    order_submit(&sArbiter, &sClientB, &sOther, 1);
+
+    if (ui32FailAt)
+    {
+        //
+        // Run ui32FailAt chunks, then refuse the next one or have it
+        // complete with an error.
+        //
+        while (g_sIom.ui32NumLog < (bRefuse ? ui32FailAt : ui32FailAt + 1))
+        {
+            model_run_until(g_sIom.ui32DoneAt);
+        }
+        if (bRefuse)
+        {
+            g_sIom.ui32Refuse = 1;
+        }
+        else
+        {
+            g_sIom.ui32FailCompletion = 1;
+        }
+        model_run_until(g_sIom.ui32DoneAt);
+    }
+    model_drain();
+
+    CHECK(g_ui32NumOrder == 2);
+    CHECK(g_pui32Order[0] == 0);
+    CHECK(g_pui32OrderStatus[0] == AM_HAL_STATUS_FAIL);
+    CHECK(!g_pbOrderCs[0]);
+    CHECK(g_pui32Order[1] == 1);
+    CHECK(g_pui32OrderStatus[1] == AM_HAL_STATUS_SUCCESS);
+    CHECK(g_sIom.ui32CsViolations == 0);
+    CHECK(!g_sIom.bCs);
+
+    //
+    // The transfer before sOther's must be the release: an empty write on
+    // the chain's CS without bContinue.
+    //
+    if (bExpectRelease)
+    {
+        CHECK(g_sIom.ui32NumLog == ui32FailAt + 3 - (bRefuse ? 1 : 0));
+        psLast = &g_sIom.sLog[g_sIom.ui32NumLog - 2];
+        CHECK(psLast->ui32NumBytes == 0);
+        CHECK(psLast->ui32InstrLen == 0);
+        CHECK(!psLast->bContinue);
+        CHECK(psLast->uPeerInfo.ui32SpiChipSelect == 0);
+    }
+    else
+    {
+        CHECK(g_sIom.ui32NumLog == 1);
+    }
+    CHECK(am_util_iom_arbiter_idle(&sArbiter));
+}
+
+static void
+test_failed_chain(void)
+{
+    //
+    // First chunk refused: CS was never asserted, nothing to release.
+    //
+    test_failed_chain_case(true, 0, false);
+
+    //
+    // Second chunk refused, or third chunk completing with an error.  The
+    // chain holds CS in both cases.
+    //
+    test_failed_chain_case(true, 1, true);
+    test_failed_chain_case(false, 2, true);
+}
+
+//*****************************************************************************
+//
+// Mixed load.
+//
+//*****************************************************************************
+typedef struct load_s load_t;
+
+typedef struct
+{
+    load_t                          *psLoad;
+    am_util_iom_arbiter_request_t   sRequest;
+    uint32_t                        ui32SubmitAt;
+    bool                            bInUse;
+} load_slot_t;
+
+struct load_s
+{
+    const char                      *pcName;
+    uint32_t                        ui32Cs;
+    uint32_t                        ui32Priority;
+    uint32_t                        ui32Bytes;
+    bool                            bAdvanceInstr;
+    bool                            bRead;
+    uint32_t                        ui32Period;
+    uint32_t                        ui32Deadline;
+
+    am_util_iom_arbiter_client_t    sClient;
+    load_slot_t                     sSlot[TEST_POOL];
+    uint32_t                        ui32NextAt;
+    uint32_t                        ui32Dropped;
+    uint32_t                        *pui32Latency;
+    uint32_t                        ui32NumLatency;
+};
+
+#define NUM_LOADS   3
+
+static const load_t g_sLoadTemplate[NUM_LOADS] =
+{
+    //
+    // Accelerometer: 6 byte read every millisecond, due before the next.
+    //
+    { "sensor",  0, 3, 6,    true,  true,  1000, 1000 },
+
+    //
+    // FRAM log writes: 2 KB every 5 ms, address advanced per chunk.
+    //
+    { "fram",    1, 1, 2048, true,  false, 5000, 0 },
+
+    //
+    // Display stream: 512 bytes every 4 ms as one bContinue chain.
+    //
+    { "display", 2, 0, 512,  false, false, 4000, 0 },
+};
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+static void
+load_callback(void *pCallbackCtxt, uint32_t ui32Status)
+{
+    load_slot_t *psSlot = (load_slot_t *)pCallbackCtxt;
+    load_t *psLoad = psSlot->psLoad;
+
+    CHECK(ui32Status == AM_HAL_STATUS_SUCCESS);
+    if (psLoad->ui32NumLatency < TEST_MAX_LATENCIES)
+    {
+        psLoad->pui32Latency[psLoad->ui32NumLatency++] = g_ui32Now - psSlot->ui32SubmitAt;
+    }
+    psSlot->bInUse = false;
+}
+
+static void
+load_submit(am_util_iom_arbiter_t *pArbiter, load_t *psLoad, bool bPriorities)
+{
+    load_slot_t *psSlot = NULL;
+    am_util_iom_arbiter_request_t *pRequest;
+    uint32_t i;
+
+    for (i = 0; i < TEST_POOL; i++)
+    {
+        if (!psLoad->sSlot[i].bInUse)
+        {
+            psSlot = &psLoad->sSlot[i];
+            break;
+        }
+    }
+    if (psSlot == NULL)
+    {
+        psLoad->ui32Dropped++;
+        return;
+    }
+
+    pRequest = &psSlot->sRequest;
+    request_setup(pRequest, psLoad->ui32Cs, psLoad->ui32Bytes,
+                  bPriorities ? psLoad->ui32Priority : 0, psLoad->bAdvanceInstr);
+    if (psLoad->bRead)
+    {
+        pRequest->sTransfer.eDirection = AM_HAL_IOM_RX;
+        pRequest->sTransfer.pui32TxBuffer = NULL;
+        pRequest->sTransfer.pui32RxBuffer = g_pui32Buffer;
+    }
+    if (bPriorities && psLoad->ui32Deadline)
+    {
+        pRequest->ui32Deadline = g_ui32Now + psLoad->ui32Deadline;
+    }
+    pRequest->pfnCallback = load_callback;
+    pRequest->pCallbackCtxt = psSlot;
+    psSlot->psLoad = psLoad;
+    psSlot->ui32SubmitAt = g_ui32Now;
+    psSlot->bInUse = true;
+    CHECK(am_util_iom_arbiter_submit(pArbiter, &psLoad->sClient, pRequest) == AM_HAL_STATUS_SUCCESS);
+}
+
+static int
+compare_u32(const void *pA, const void *pB)
+{
+    uint32_t a = *(const uint32_t *)pA;
+    uint32_t b = *(const uint32_t *)pB;
+
+    return (a > b) - (a < b);
+}
+
+static uint32_t
+exact_percentile(const uint32_t *pui32Sorted, uint32_t ui32Count, uint32_t ui32Percent)
+{
+    uint32_t ui32Rank = (uint32_t)(((uint64_t)ui32Count * ui32Percent + 99) / 100);
+
+    return pui32Sorted[ui32Rank ? ui32Rank - 1 : 0];
+}
+
+//*****************************************************************************
+//
+// Run the mixed load for ui32RunUs and return the sensor p99 (exact).
+//
+//*****************************************************************************
+static uint32_t
+test_load(uint32_t ui32RunUs, bool bPriorities)
+{
+    am_util_iom_arbiter_t sArbiter;
+    load_t sLoad[NUM_LOADS];
+    uint32_t ui32SensorP99 = 0;
+    uint32_t ui32BusyUs = 0;
+    uint32_t i;
+
+    arbiter_setup(&sArbiter);
+    for (i = 0; i < NUM_LOADS; i++)
+    {
+        sLoad[i] = g_sLoadTemplate[i];
+        sLoad[i].ui32NextAt = rand_next() % sLoad[i].ui32Period;
+        sLoad[i].pui32Latency = malloc(TEST_MAX_LATENCIES * sizeof(uint32_t));
+        am_util_iom_arbiter_client_add(&sArbiter, &sLoad[i].sClient);
+    }
+
+    while ((int32_t)(g_ui32Now - ui32RunUs) < 0)
+    {
+        uint32_t ui32Next = ui32RunUs;
+        load_t *psDue = NULL;
+
+        for (i = 0; i < NUM_LOADS; i++)
+        {
+            if ((int32_t)(sLoad[i].ui32NextAt - ui32Next) < 0)
+            {
+                ui32Next = sLoad[i].ui32NextAt;
+                psDue = &sLoad[i];
+            }
+        }
+
+        //
+        // Bus completions up to the next arrival run first.
+        //
+        while (g_sIom.bBusy && ((int32_t)(g_sIom.ui32DoneAt - ui32Next) <= 0))
+        {
+            ui32BusyUs += g_sIom.ui32DoneAt - g_ui32Now;
+            model_run_until(g_sIom.ui32DoneAt);
+        }
+        if (g_sIom.bBusy)
+        {
+            ui32BusyUs += ui32Next - g_ui32Now;
+        }
+        model_run_until(ui32Next);
+
+        if (psDue)
+        {
+            load_submit(&sArbiter, psDue, bPriorities);
+
+            //
+            // Arrivals jitter by up to +/-10% of the period.
+            //
+            psDue->ui32NextAt += psDue->ui32Period - psDue->ui32Period / 10 +
+                                 rand_next() % (psDue->ui32Period / 5 + 1);
+        }
+    }
+    model_drain();
+    CHECK(am_util_iom_arbiter_idle(&sArbiter));
+    CHECK(g_sIom.ui32CsViolations == 0);
+
+    printf("%s, bus %u%% busy:\n", bPriorities ? "Priorities" : "No priorities",
+           (unsigned)((uint64_t)ui32BusyUs * 100 / ui32RunUs));
+    printf("  %-8s %8s %8s %8s %8s %8s %8s %8s\n", "client", "done",
+           "dropped", "p50", "p99", "max", "hist p50", "hist p99");
+
+    for (i = 0; i < NUM_LOADS; i++)
+    {
+        load_t *psLoad = &sLoad[i];
+        am_util_iom_arbiter_client_t *pClient = &psLoad->sClient;
+        uint32_t ui32P50, ui32P99, ui32H50, ui32H99;
+
+        qsort(psLoad->pui32Latency, psLoad->ui32NumLatency, sizeof(uint32_t),
+              compare_u32);
+        ui32P50 = exact_percentile(psLoad->pui32Latency, psLoad->ui32NumLatency, 50);
+        ui32P99 = exact_percentile(psLoad->pui32Latency, psLoad->ui32NumLatency, 99);
+        ui32H50 = am_util_iom_arbiter_latency_percentile(pClient, 50);
+        ui32H99 = am_util_iom_arbiter_latency_percentile(pClient, 99);
+
+        printf("  %-8s %8u %8u %8u %8u %8u %8u %8u\n", psLoad->pcName,
+               (unsigned)pClient->ui32Completed, (unsigned)psLoad->ui32Dropped,
+               (unsigned)ui32P50, (unsigned)ui32P99,
+               (unsigned)pClient->ui32MaxLatency,
+               (unsigned)ui32H50, (unsigned)ui32H99);
+
+        //
+        // The histogram is exact below 8 ticks and within one bin (25%)
+        // above.
+        //
+        CHECK(pClient->ui32Completed == psLoad->ui32NumLatency);
+        CHECK(pClient->ui32MaxLatency ==
+              psLoad->pui32Latency[psLoad->ui32NumLatency - 1]);
+        CHECK((ui32H50 >= ui32P50) && (ui32H50 <= ui32P50 + ui32P50 / 4 + 1));
+        CHECK((ui32H99 >= ui32P99) && (ui32H99 <= ui32P99 + ui32P99 / 4 + 1));
+        CHECK(pClient->ui32Errors == 0);
+
+        if (i == 0)
+        {
+            ui32SensorP99 = ui32P99;
+        }
+        free(psLoad->pui32Latency);
+    }
+
+    if (bPriorities)
+    {
+        //
+        // The sensor waits at most for the FRAM chunk on the bus when it
+        // arrives, then a display chain that reached the starvation bound.
+        //
+        uint32_t ui32Chunk = IOM_SETUP_US + 1 + TEST_CHUNK;
+        uint32_t ui32Chain = 2 * IOM_SETUP_US + 1 + g_sLoadTemplate[2].ui32Bytes;
+        uint32_t ui32Own = IOM_SETUP_US + 1 + g_sLoadTemplate[0].ui32Bytes;
+
+        CHECK(sLoad[0].sClient.ui32MaxLatency <= ui32Chunk + ui32Chain + ui32Own);
+        CHECK(sLoad[0].sClient.ui32MissedDeadlines == 0);
+    }
+    for (i = 0; i < NUM_LOADS; i++)
+    {
+        CHECK(sLoad[i].ui32Dropped == 0);
+    }
+
+    return ui32SensorP99;
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32RunMs = 2000;
+    uint32_t ui32WithP99, ui32WithoutP99;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                ui32RunMs = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t run_ms]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    test_priority();
+    test_refused();
+    test_failed_chain();
+
+    ui32WithP99 = test_load(ui32RunMs * 1000, true);
+    ui32WithoutP99 = test_load(ui32RunMs * 1000, false);
+
+    //
+    // Priorities must buy the sensor a clearly better tail.
+    //
+    CHECK(ui32WithP99 * 2 <= ui32WithoutP99);
+
+    return host_test_result();
+}
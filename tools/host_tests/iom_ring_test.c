@@ -0,0 +1,457 @@
+//*****************************************************************************
+//
+//! @file iom_ring_test.c
+//!
+//! @brief Tests of the IOM pending transaction ring on a command queue model.
+//!
+//! Builds the real am_hal_iom.c and am_hal_cmdq.c and plays the command queue
+//! itself: entries are executed from CQADDR until CQCURIDX reaches CQENDIDX,
+//! and every interrupting index update calls the IOM interrupt service.
+//! Checks the queue depth that AM_HAL_IOM_CQ_ENTRY_SIZE sizing gives, that
+//! callbacks survive many ring and hardware index wraps, and that sequences
+//! cannot overrun the ring.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// The IOM HAL.  Its high priority entry size check assumes 32-bit pointers,
+// so the compile time checks are left out on the host.
+//
+//*****************************************************************************
+#undef am_ct_assert
+#define am_ct_assert(e)
+
+#include "am_hal_iom.c"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define IOM_REGS_SIZE               sizeof(IOM0_Type)
+
+//
+// Interrupt request bit of a CQCURIDX update entry, as set by am_hal_cmdq.c.
+//
+#define CQ_UPD_INT                  0x1
+
+#define ENTRY_WORDS                 (AM_HAL_IOM_CQ_ENTRY_SIZE / 4)
+#define MAX_DEPTH                   200
+#define WRAP_STEPS                  20000
+#define SEQ_LENGTH                  4
+#define SEQ_PASSES                  3
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static uint32_t g_pui32TxnBuf[ENTRY_WORDS * (MAX_DEPTH + 1)];
+static uint32_t g_pui32Data[4];
+static void *g_pIOMHandle;
+
+//
+// Transactions queued and completed.  Each transaction's callback context is
+// its position in the queue, or in the sequence if g_ui32SeqLength is set.
+//
+static uint32_t g_ui32Queued;
+static uint32_t g_ui32Completed;
+static uint32_t g_ui32SeqLength;
+
+static uint64_t g_ui64Rand = 0x2545f4914f6cdd1dull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the IOM and CQ HALs link against.
+//
+//*****************************************************************************
+void
+am_hal_flash_delay(uint32_t ui32Iterations)
+{
+    (void)ui32Iterations;
+}
+
+uint32_t
+am_hal_flash_delay_status_change(uint32_t ui32Iterations, uint32_t ui32Address,
+                                 uint32_t ui32Mask, uint32_t ui32Value)
+{
+    (void)ui32Iterations;
+    (void)ui32Address;
+    (void)ui32Mask;
+    (void)ui32Value;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_flash_delay_status_check(uint32_t ui32usMaxDelay, uint32_t ui32Address,
+                                uint32_t ui32Mask, uint32_t ui32Value, bool bWaitForEqual)
+{
+    (void)ui32usMaxDelay;
+    (void)ui32Address;
+    (void)ui32Mask;
+    (void)ui32Value;
+    (void)bWaitForEqual;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+
+//*****************************************************************************
+//
+// Command queue model.  Executes entries from CQADDR until ui32Updates
+// interrupting index updates have been made or CQCURIDX reaches CQENDIDX,
+// and services the IOM interrupt after each update.
+//
+//*****************************************************************************
+static void
+cq_run(uint32_t ui32Updates)
+{
+    while (ui32Updates && ((IOM0->CQCURIDX & 0xFF) != (IOM0->CQENDIDX & 0xFF)))
+    {
+        am_hal_cmdq_entry_t *psEntry = (am_hal_cmdq_entry_t *)(uintptr_t)IOM0->CQADDR;
+        uint32_t ui32Reg = psEntry->address & ~CQ_UPD_INT;
+
+        //
+        // Only the IOM is modelled.  An entry that writes CQADDR, to wrap or
+        // loop, takes effect as the next entry is fetched.
+        //
+        if ((ui32Reg < REG_IOM_BASEADDR) || (ui32Reg >= REG_IOM_BASEADDR + IOM_REGS_SIZE))
+        {
+            printf("FAIL: CQ entry writes 0x%08x\n", (unsigned)ui32Reg);
+            g_ui32Failures++;
+            return;
+        }
+        IOM0->CQADDR += sizeof(am_hal_cmdq_entry_t);
+        AM_REGVAL(ui32Reg) = psEntry->value;
+
+        if ((ui32Reg == (uint32_t)(uintptr_t)&IOM0->CQCURIDX) && (psEntry->address & CQ_UPD_INT))
+        {
+            ui32Updates--;
+            am_hal_iom_interrupt_service(g_pIOMHandle, AM_HAL_IOM_INT_CQUPD);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Transactions and their callbacks.
+//
+//*****************************************************************************
+static void
+txn_callback(void *pCallbackCtxt, uint32_t ui32Status)
+{
+    uint32_t ui32Expected = g_ui32SeqLength ? (g_ui32Completed % g_ui32SeqLength) : g_ui32Completed;
+
+    CHECK(ui32Status == AM_HAL_STATUS_SUCCESS);
+    CHECK((uint32_t)(uintptr_t)pCallbackCtxt == ui32Expected);
+    g_ui32Completed++;
+}
+
+static uint32_t
+txn_queue(void)
+{
+    am_hal_iom_transfer_t sTxn;
+    uint32_t ui32Status;
+
+    memset(&sTxn, 0, sizeof(sTxn));
+    sTxn.ui32NumBytes = sizeof(g_pui32Data);
+    sTxn.eDirection = AM_HAL_IOM_TX;
+    sTxn.pui32TxBuffer = g_pui32Data;
+
+    ui32Status = am_hal_iom_nonblocking_transfer(g_pIOMHandle, &sTxn, txn_callback,
+                                                 (void *)(uintptr_t)g_ui32Queued);
+    if (ui32Status == AM_HAL_STATUS_SUCCESS)
+    {
+        g_ui32Queued++;
+    }
+
+    return ui32Status;
+}
+
+static am_hal_iom_status_t
+iom_status(void)
+{
+    am_hal_iom_status_t sStatus;
+
+    CHECK(am_hal_iom_status_get(g_pIOMHandle, &sStatus) == AM_HAL_STATUS_SUCCESS);
+    return sStatus;
+}
+
+//*****************************************************************************
+//
+// Bring up IOM0 in SPI mode with ui32Words of transaction buffer.  Returns
+// the status of am_hal_iom_enable().
+//
+//*****************************************************************************
+static uint32_t
+iom_open(uint32_t ui32Words)
+{
+    am_hal_iom_config_t sConfig =
+    {
+        .eInterfaceMode     = AM_HAL_IOM_SPI_MODE,
+        .ui32ClockFreq      = AM_HAL_IOM_1MHZ,
+        .eSpiMode           = AM_HAL_IOM_SPI_MODE_0,
+        .pNBTxnBuf          = g_pui32TxnBuf,
+        .ui32NBTxnBufLength = ui32Words,
+    };
+
+    memset((void *)IOM0, 0, IOM_REGS_SIZE);
+    g_ui32Queued = 0;
+    g_ui32Completed = 0;
+    g_ui32SeqLength = 0;
+
+    CHECK(am_hal_iom_initialize(0, &g_pIOMHandle) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_hal_iom_configure(g_pIOMHandle, &sConfig) == AM_HAL_STATUS_SUCCESS);
+
+    return am_hal_iom_enable(g_pIOMHandle);
+}
+
+static void
+iom_close(void)
+{
+    CHECK(am_hal_iom_disable(g_pIOMHandle) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_hal_iom_uninitialize(g_pIOMHandle) == AM_HAL_STATUS_SUCCESS);
+}
+
+//*****************************************************************************
+//
+// A buffer of AM_HAL_IOM_CQ_ENTRY_SIZE * (N + 1) bytes holds N transactions,
+// and anything smaller than one transaction is refused.
+//
+//*****************************************************************************
+static void
+test_depth(void)
+{
+    am_hal_iom_status_t sStatus;
+    uint32_t ui32Depth, ui32Spare = 0;
+
+    for (ui32Depth = 1; ui32Depth <= MAX_DEPTH; ui32Depth++)
+    {
+        CHECK(iom_open(ENTRY_WORDS * (ui32Depth + 1)) == AM_HAL_STATUS_SUCCESS);
+
+        while (txn_queue() == AM_HAL_STATUS_SUCCESS)
+        {
+        }
+
+        sStatus = iom_status();
+        CHECK(g_ui32Queued >= ui32Depth);
+        CHECK(g_ui32Queued <= sStatus.ui32MaxTransactions);
+        CHECK((sStatus.ui32MaxTransactions & (sStatus.ui32MaxTransactions - 1)) == 0);
+        CHECK(sStatus.ui32NumPendTransactions == g_ui32Queued);
+        ui32Spare += g_ui32Queued - ui32Depth;
+
+        cq_run(g_ui32Queued);
+        CHECK(g_ui32Completed == g_ui32Queued);
+        CHECK(iom_status().ui32NumPendTransactions == 0);
+
+        iom_close();
+    }
+
+    printf("Depth: buffers for 1 to %u transactions held %u more than sized for\n",
+           MAX_DEPTH, (unsigned)ui32Spare);
+
+    CHECK(iom_open(ENTRY_WORDS / 2) == AM_HAL_STATUS_OUT_OF_RANGE);
+    iom_close();
+}
+
+//*****************************************************************************
+//
+// Random queueing and completion through a small ring, long enough for both
+// the ring and the 8-bit hardware index to wrap many times.
+//
+//*****************************************************************************
+static void
+test_wrap(void)
+{
+    uint32_t i, j;
+
+    CHECK(iom_open(ENTRY_WORDS * (5 + 1)) == AM_HAL_STATUS_SUCCESS);
+
+    for (i = 0; i < WRAP_STEPS; i++)
+    {
+        uint32_t ui32Count = 1 + rand_next() % 4;
+
+        if (rand_next() % 2)
+        {
+            for (j = 0; j < ui32Count; j++)
+            {
+                txn_queue();
+            }
+        }
+        else
+        {
+            cq_run(ui32Count);
+        }
+        CHECK(iom_status().ui32NumPendTransactions == g_ui32Queued - g_ui32Completed);
+    }
+    cq_run(g_ui32Queued - g_ui32Completed);
+    CHECK(g_ui32Completed == g_ui32Queued);
+    CHECK(g_ui32Queued > 20 * 256);
+
+    printf("Wrap: %u transactions through a %u deep ring\n",
+           (unsigned)g_ui32Queued, (unsigned)iom_status().ui32MaxTransactions);
+
+    iom_close();
+}
+
+//*****************************************************************************
+//
+// Ending a sequence never takes the ring slot of a queued transaction, and
+// is refused when the ring is full.  A looping sequence delivers its
+// callbacks in order on every pass.
+//
+//*****************************************************************************
+static void
+test_sequence(void)
+{
+    am_hal_iom_state_t *pIOMState;
+    am_hal_iom_seq_end_t sEnd = { .bLoop = true };
+    am_hal_iom_status_t sStatus;
+    bool bSeq;
+    uint32_t ui32Depth, ui32Status, ui32Slots, ui32RingFull = 0, i;
+
+    for (ui32Depth = 1; ui32Depth <= 64; ui32Depth++)
+    {
+        CHECK(iom_open(ENTRY_WORDS * (ui32Depth + 1)) == AM_HAL_STATUS_SUCCESS);
+        pIOMState = (am_hal_iom_state_t *)g_pIOMHandle;
+
+        bSeq = true;
+        CHECK(am_hal_iom_control(g_pIOMHandle, AM_HAL_IOM_REQ_SET_SEQMODE, &bSeq) == AM_HAL_STATUS_SUCCESS);
+        while (txn_queue() == AM_HAL_STATUS_SUCCESS)
+        {
+        }
+
+        //
+        // Ending needs a ring slot for the loopback callback and one for the
+        // loop entry, and may not take one from a queued transaction.
+        //
+        sStatus = iom_status();
+        ui32Status = am_hal_iom_control(g_pIOMHandle, AM_HAL_IOM_REQ_SEQ_END, &sEnd);
+        if (sStatus.ui32NumPendTransactions == sStatus.ui32MaxTransactions)
+        {
+            CHECK(ui32Status == AM_HAL_STATUS_OUT_OF_RANGE);
+            ui32RingFull++;
+        }
+        for (i = 0, ui32Slots = 0; i < sStatus.ui32MaxTransactions; i++)
+        {
+            ui32Slots += (pIOMState->pfnCallback[i] == txn_callback);
+        }
+        CHECK(ui32Slots == g_ui32Queued);
+
+        //
+        // Stop it; the modelled CQ is idle, so it reads as disabled.
+        //
+        IOM0->CQCFG = 0;
+        bSeq = false;
+        CHECK(am_hal_iom_control(g_pIOMHandle, AM_HAL_IOM_REQ_SET_SEQMODE, &bSeq) == AM_HAL_STATUS_SUCCESS);
+        iom_close();
+    }
+
+    //
+    // Make sure some of those sequences were limited by the ring rather than
+    // by the CQ.
+    //
+    CHECK(ui32RingFull > 0);
+
+    CHECK(iom_open(ENTRY_WORDS * (SEQ_LENGTH + 2 + 1)) == AM_HAL_STATUS_SUCCESS);
+    bSeq = true;
+    CHECK(am_hal_iom_control(g_pIOMHandle, AM_HAL_IOM_REQ_SET_SEQMODE, &bSeq) == AM_HAL_STATUS_SUCCESS);
+    g_ui32SeqLength = SEQ_LENGTH;
+    for (i = 0; i < SEQ_LENGTH; i++)
+    {
+        CHECK(txn_queue() == AM_HAL_STATUS_SUCCESS);
+    }
+    CHECK(am_hal_iom_control(g_pIOMHandle, AM_HAL_IOM_REQ_SEQ_END, &sEnd) == AM_HAL_STATUS_SUCCESS);
+
+    //
+    // Each pass is the transactions plus the loopback callback.
+    //
+    cq_run((SEQ_LENGTH + 1) * SEQ_PASSES);
+    CHECK(g_ui32Completed == SEQ_LENGTH * SEQ_PASSES);
+
+    printf("Sequence: %u of 64 sequences filled the ring, %u passes of %u\n",
+           (unsigned)ui32RingFull, SEQ_PASSES, SEQ_LENGTH);
+
+    //
+    // Stop it; the modelled CQ is idle, so it reads as disabled.
+    //
+    IOM0->CQCFG = 0;
+    bSeq = false;
+    CHECK(am_hal_iom_control(g_pIOMHandle, AM_HAL_IOM_REQ_SET_SEQMODE, &bSeq) == AM_HAL_STATUS_SUCCESS);
+    iom_close();
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(void)
+{
+    host_regs_map(REG_IOM_BASEADDR, IOM_REGS_SIZE);
+
+    test_depth();
+    test_wrap();
+    test_sequence();
+
+    return host_test_result();
+}
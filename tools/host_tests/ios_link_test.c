@@ -0,0 +1,906 @@
+//*****************************************************************************
+//
+//! @file ios_link_test.c
+//!
+//! @brief End-to-end benchmark of the IOS link on a model of the IOS and IOM.
+//!
+//! Runs am_util_ios_link.c on the slave and am_util_ios_link_host.c on the
+//! host against each other.  The slave side drives the real am_hal_ios.c,
+//! which is built into this file so that every IOSLAVE register access first
+//! brings a model of the IOS hardware up to date: FIFO size and pointer,
+//! FIFOCTR, the IOINT lines and the slave interrupt status.  The host side
+//! goes through a model of am_hal_iom_blocking_transfer() that plays the
+//! host's IOS register map against the same state, one bus byte at a time,
+//! with the slave interrupt and the slave application running between bytes.
+//!
+//! Each run reports payload throughput against the raw bus rate, host and
+//! slave interrupts per KB and frame latency, for a per-frame doorbell and
+//! for batched doorbells, with a saturating and with a paced producer.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "am_util_ios_link.h"
+#include "am_util_ios_link_host.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// The IOS HAL, with every register access bringing the model up to date.
+//
+//*****************************************************************************
+static void model_sync(void);
+
+#undef IOSLAVEn
+#define IOSLAVEn(n)                 ((void)(n), model_sync(), IOSLAVE)
+
+#include "am_hal_ios.c"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define LRAM                        ((volatile uint8_t *)REG_IOSLAVE_BASEADDR)
+#define IOS_REGS_SIZE               0x400
+
+//
+// LRAM layout, as in the ios_fifo example.
+//
+#define IOS_RO_BASE                 0x78
+#define IOS_FIFO_BASE               0x80
+#define IOS_RAM_BASE                0x100
+#define IOS_FIFO_THR                0x20
+
+//
+// Host view of the IOS.
+//
+#define HOST_ADDR_IOINTEN           0x78
+#define HOST_ADDR_IOINT             0x79
+#define HOST_ADDR_IOINTCLR          0x7A
+#define HOST_ADDR_IOINTSET          0x7B
+#define HOST_ADDR_FIFOCTR_LO        0x7C
+#define HOST_ADDR_FIFOCTR_HI        0x7D
+#define HOST_ADDR_FIFO              0x7F
+
+//
+// Timing, in ns.  8 MHz SPI; chip select and IOM setup per transaction; slave
+// IOINT pin to the host's service call.
+//
+#define BYTE_NS                     1000
+#define XFER_NS                     2000
+#define HOST_LATENCY_NS             20000
+#define HOST_START_NS               50000
+
+//
+// Paced producer: small sensor-style frames, flushed by a periodic timer.
+//
+#define PACED_LENGTH                20
+#define PACED_PERIOD_NS             250000
+#define FLUSH_PERIOD_NS             5000000
+
+#define MBOX_PERIOD_NS              500000
+#define DRAIN_NS                    50000000
+#define FRAME_RING                  4096
+#define BUFFER_SIZE                 1024
+#define SPI_CS                      3
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static uint64_t g_ui64Now;
+static uint32_t g_ui32IsrLatencyNs = 2000;
+
+//
+// IOS hardware state not held in the registers.
+//
+static struct
+{
+    bool        bArmed;
+    uint32_t    ui32WritePtr;
+    uint8_t     ui8IoInt;
+    uint8_t     ui8IoIntEn;
+    uint32_t    ui32Underflows;
+    uint32_t    ui32Overflows;
+    uint32_t    ui32BadXfers;
+    uint32_t    ui32Transactions;
+    uint64_t    ui64BusBytes;
+} g_sModel;
+
+static struct
+{
+    void        *pIosHandle;
+    bool        bIrqPending;
+    uint64_t    ui64IrqAt;
+    uint32_t    ui32Isrs;
+    uint32_t    ui32BadIsrs;
+} g_sSlave;
+
+static struct
+{
+    bool        bActive;
+    bool        bSaturate;
+    uint32_t    ui32Seq;
+    uint32_t    ui32Length;
+    uint64_t    ui64Due;
+    uint64_t    ui64FlushAt;
+    uint64_t    pui64SentAt[FRAME_RING];
+    uint32_t    pui32SentLength[FRAME_RING];
+} g_sProducer;
+
+static struct
+{
+    am_util_ios_link_host_t sLink;
+    bool        bIrqPending;
+    uint64_t    ui64IrqAt;
+    uint32_t    ui32Seq;
+    uint32_t    ui32Bad;
+    uint64_t    ui64Payload;
+    uint64_t    ui64LatencySum;
+    uint64_t    ui64LatencyMax;
+} g_sHost;
+
+static struct
+{
+    bool        bEnabled;
+    uint64_t    ui64Due;
+    uint32_t    ui32Sent;
+    uint32_t    ui32Received;
+    uint32_t    ui32Bad;
+    uint32_t    pui32Length[16];
+} g_sMbox;
+
+static uint32_t g_ui32IomHandle;
+static uint32_t g_pui32ReadBuffer[BUFFER_SIZE / 4];
+static uint8_t g_pui8FrameBuffer[BUFFER_SIZE];
+static uint8_t g_pui8SramBuffer[BUFFER_SIZE];
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the IOS HAL links against.
+//
+//*****************************************************************************
+void
+am_hal_debug_error(const char *pcFile, uint32_t ui32Line, const char *pcMessage)
+{
+    printf("FAIL %s:%u: HAL assert %s\n", pcFile, (unsigned)ui32Line, pcMessage ? pcMessage : "");
+    g_ui32Failures++;
+}
+
+uint32_t am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+
+//*****************************************************************************
+//
+// IOS model.
+//
+//*****************************************************************************
+static void
+model_ioint_publish(void)
+{
+    IOSLAVE->IOINTCTL = _VAL2FLD(IOSLAVE_IOINTCTL_IOINTEN, g_sModel.ui8IoIntEn) |
+                        _VAL2FLD(IOSLAVE_IOINTCTL_IOINT, g_sModel.ui8IoInt);
+}
+
+//
+// Apply the slave's register writes and count the bytes it has put in the
+// FIFO since the last call.  The FIFO write pointer lives in the HAL state;
+// the HAL never fills the last byte, so a distance of zero means no writes.
+//
+static void
+model_sync(void)
+{
+    uint32_t ui32Ctl;
+
+    if (IOSLAVE->INTCLR)
+    {
+        IOSLAVE->INTSTAT &= ~IOSLAVE->INTCLR;
+        IOSLAVE->INTCLR = 0;
+    }
+
+    if (IOSLAVE->INTSET)
+    {
+        IOSLAVE->INTSTAT |= IOSLAVE->INTSET;
+        IOSLAVE->INTSET = 0;
+    }
+
+    ui32Ctl = IOSLAVE->IOINTCTL;
+    if (ui32Ctl & IOSLAVE_IOINTCTL_IOINTCLR_Msk)
+    {
+        g_sModel.ui8IoInt = 0;
+    }
+    g_sModel.ui8IoInt |= _FLD2VAL(IOSLAVE_IOINTCTL_IOINTSET, ui32Ctl);
+    model_ioint_publish();
+
+    if (g_sModel.bArmed)
+    {
+        am_hal_ios_state_t *psState = &g_IOShandles[0];
+        uint32_t ui32Size = psState->pui8FIFOEnd - psState->pui8FIFOBase;
+        uint32_t ui32Ptr = (uint32_t)(uintptr_t)psState->pui8FIFOPtr - REG_IOSLAVE_BASEADDR;
+        uint32_t ui32New = (ui32Ptr + ui32Size - g_sModel.ui32WritePtr) % ui32Size;
+
+        if (ui32New)
+        {
+            uint32_t ui32Fill = IOSLAVE->FIFOPTR_b.FIFOSIZ + ui32New;
+
+            if (ui32Fill >= ui32Size)
+            {
+                g_sModel.ui32Overflows++;
+                IOSLAVE->INTSTAT |= AM_HAL_IOS_INT_FOVFL;
+            }
+
+            IOSLAVE->FIFOPTR_b.FIFOSIZ = ui32Fill;
+            g_sModel.ui32WritePtr = ui32Ptr;
+        }
+    }
+}
+
+static uint8_t
+model_fifo_pop(void)
+{
+    uint32_t ui32Ptr;
+    uint8_t ui8Data;
+
+    model_sync();
+
+    if (IOSLAVE->FIFOPTR_b.FIFOSIZ == 0)
+    {
+        g_sModel.ui32Underflows++;
+        IOSLAVE->INTSTAT |= AM_HAL_IOS_INT_FUNDFL;
+        return 0xEE;
+    }
+
+    ui32Ptr = IOSLAVE->FIFOPTR_b.FIFOPTR;
+    ui8Data = LRAM[ui32Ptr++];
+    if (ui32Ptr == IOSLAVE->FIFOCFG_b.FIFOMAX * 8U)
+    {
+        ui32Ptr = IOSLAVE->FIFOCFG_b.FIFOBASE * 8U;
+    }
+
+    IOSLAVE->FIFOPTR_b.FIFOPTR = ui32Ptr;
+    IOSLAVE->FIFOPTR_b.FIFOSIZ--;
+    IOSLAVE->FIFOCTR_b.FIFOCTR--;
+
+    //
+    // FSIZE fires as the level drops to the threshold, not on every read
+    // below it.
+    //
+    if (IOSLAVE->FIFOPTR_b.FIFOSIZ == IOSLAVE->FIFOTHR_b.FIFOTHR)
+    {
+        IOSLAVE->INTSTAT |= AM_HAL_IOS_INT_FSIZE;
+    }
+
+    return ui8Data;
+}
+
+static uint8_t
+model_host_read(uint32_t ui32Addr)
+{
+    model_sync();
+
+    switch (ui32Addr)
+    {
+        case HOST_ADDR_IOINTEN:     return g_sModel.ui8IoIntEn;
+        case HOST_ADDR_IOINT:       return g_sModel.ui8IoInt;
+        case HOST_ADDR_FIFOCTR_LO:  return (uint8_t)IOSLAVE->FIFOCTR_b.FIFOCTR;
+        case HOST_ADDR_FIFOCTR_HI:  return (uint8_t)(IOSLAVE->FIFOCTR_b.FIFOCTR >> 8);
+        case HOST_ADDR_FIFO:        return model_fifo_pop();
+        default:
+            return (ui32Addr < IOS_RO_BASE) ? LRAM[ui32Addr] : 0;
+    }
+}
+
+static void
+model_host_write(uint32_t ui32Addr, uint8_t ui8Data)
+{
+    model_sync();
+
+    switch (ui32Addr)
+    {
+        case HOST_ADDR_IOINTEN:     g_sModel.ui8IoIntEn = ui8Data;      break;
+        case HOST_ADDR_IOINTCLR:    g_sModel.ui8IoInt &= ~ui8Data;      break;
+        case HOST_ADDR_IOINTSET:    g_sModel.ui8IoInt |= ui8Data;       break;
+        default:
+            if (ui32Addr < IOS_RO_BASE)
+            {
+                LRAM[ui32Addr] = ui8Data;
+            }
+            else
+            {
+                g_sModel.ui32BadXfers++;
+            }
+            break;
+    }
+
+    model_ioint_publish();
+}
+
+static bool
+model_ioint_line(void)
+{
+    model_sync();
+    return (g_sModel.ui8IoInt & g_sModel.ui8IoIntEn) != 0;
+}
+
+//*****************************************************************************
+//
+// Slave: interrupt handler and application.
+//
+//*****************************************************************************
+static void
+slave_isr(void)
+{
+    uint32_t ui32Status = 0;
+
+    if (g_bIntDisabled)
+    {
+        g_sSlave.ui32BadIsrs++;
+    }
+
+    am_hal_ios_interrupt_status_get(g_sSlave.pIosHandle, true, &ui32Status);
+    am_hal_ios_interrupt_clear(g_sSlave.pIosHandle, ui32Status);
+    am_util_ios_link_int_service(ui32Status);
+    g_sSlave.ui32Isrs++;
+}
+
+static uint8_t
+frame_byte(uint32_t ui32Seq, uint32_t ui32Index)
+{
+    return (uint8_t)(ui32Seq * 31 + ui32Index * 7);
+}
+
+static void
+producer_run(void)
+{
+    uint8_t pui8Frame[AM_UTIL_IOS_LINK_FIFOCTR_MAX];
+    uint32_t ui32Slot;
+    uint32_t ui32Status;
+
+    while (g_sProducer.bActive &&
+           (g_sProducer.bSaturate || (g_ui64Now >= g_sProducer.ui64Due)))
+    {
+        //
+        // A frame that did not fit is retried as is.
+        //
+        if (g_sProducer.ui32Length == 0)
+        {
+            g_sProducer.ui32Length = g_sProducer.bSaturate ? 4 + rand_next() % 253 :
+                                                             PACED_LENGTH;
+        }
+
+        memcpy(pui8Frame, &g_sProducer.ui32Seq, 4);
+        for (uint32_t i = 4; i < g_sProducer.ui32Length; i++)
+        {
+            pui8Frame[i] = frame_byte(g_sProducer.ui32Seq, i);
+        }
+
+        ui32Status = am_util_ios_link_send(g_sProducer.ui32Seq & 3, pui8Frame,
+                                           g_sProducer.ui32Length);
+        if (ui32Status == AM_HAL_STATUS_IN_USE)
+        {
+            break;
+        }
+        CHECK(ui32Status == AM_HAL_STATUS_SUCCESS);
+
+        ui32Slot = g_sProducer.ui32Seq % FRAME_RING;
+        g_sProducer.pui64SentAt[ui32Slot] = g_ui64Now;
+        g_sProducer.pui32SentLength[ui32Slot] = g_sProducer.ui32Length;
+        g_sProducer.ui32Seq++;
+        g_sProducer.ui32Length = 0;
+        g_sProducer.ui64Due += PACED_PERIOD_NS;
+    }
+
+    if (g_ui64Now >= g_sProducer.ui64FlushAt)
+    {
+        am_util_ios_link_flush();
+        g_sProducer.ui64FlushAt += FLUSH_PERIOD_NS;
+    }
+}
+
+static void
+slave_mbox_rx(uint8_t ui8Channel, uint8_t *pui8Data, uint32_t ui32Length,
+              void *pCallbackCtxt)
+{
+    uint32_t ui32Msg = g_sMbox.ui32Received++;
+    bool bOk = (pCallbackCtxt == &g_sMbox) &&
+               (ui8Channel == (uint8_t)ui32Msg) &&
+               (ui32Length == g_sMbox.pui32Length[ui32Msg % 16]);
+
+    for (uint32_t i = 0; bOk && (i < ui32Length); i++)
+    {
+        bOk = pui8Data[i] == frame_byte(ui32Msg, i);
+    }
+
+    if (!bOk)
+    {
+        g_sMbox.ui32Bad++;
+    }
+}
+
+//
+// One step of slave time: the IOS interrupt, once its latency has passed,
+// then the application.
+//
+static void
+sim_advance(uint32_t ui32Ns)
+{
+    g_ui64Now += ui32Ns;
+
+    model_sync();
+    if (IOSLAVE->INTSTAT & IOSLAVE->INTEN)
+    {
+        if (!g_sSlave.bIrqPending)
+        {
+            g_sSlave.bIrqPending = true;
+            g_sSlave.ui64IrqAt = g_ui64Now + g_ui32IsrLatencyNs;
+        }
+
+        if (g_ui64Now >= g_sSlave.ui64IrqAt)
+        {
+            g_sSlave.bIrqPending = false;
+            slave_isr();
+        }
+    }
+    else
+    {
+        g_sSlave.bIrqPending = false;
+    }
+
+    producer_run();
+}
+
+//*****************************************************************************
+//
+// Host: IOM model and application.
+//
+//*****************************************************************************
+uint32_t
+am_hal_iom_blocking_transfer(void *pHandle, am_hal_iom_transfer_t *psTransaction)
+{
+    uint32_t ui32Addr = psTransaction->ui32Instr & ~AM_UTIL_IOS_LINK_HOST_WRITE;
+    bool bWrite = (psTransaction->ui32Instr & AM_UTIL_IOS_LINK_HOST_WRITE) != 0;
+    uint8_t *pui8Data;
+
+    if ((pHandle != &g_ui32IomHandle) ||
+        (psTransaction->ui32InstrLen != 1) ||
+        (psTransaction->ui32Instr > 0xFF) ||
+        (psTransaction->ui32NumBytes == 0) ||
+        (psTransaction->ui32NumBytes > AM_HAL_IOM_MAX_TXNSIZE_SPI) ||
+        (psTransaction->uPeerInfo.ui32SpiChipSelect != SPI_CS) ||
+        psTransaction->bContinue ||
+        (bWrite != (psTransaction->eDirection == AM_HAL_IOM_TX)))
+    {
+        g_sModel.ui32BadXfers++;
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    pui8Data = (uint8_t *)(bWrite ? psTransaction->pui32TxBuffer :
+                                    psTransaction->pui32RxBuffer);
+
+    g_sModel.ui32Transactions++;
+    g_sModel.ui64BusBytes += 1 + psTransaction->ui32NumBytes;
+
+    //
+    // Chip select and the offset byte.
+    //
+    sim_advance(XFER_NS + BYTE_NS);
+
+    for (uint32_t i = 0; i < psTransaction->ui32NumBytes; i++)
+    {
+        if (bWrite)
+        {
+            model_host_write(ui32Addr, pui8Data[i]);
+        }
+        else
+        {
+            pui8Data[i] = model_host_read(ui32Addr);
+        }
+
+        //
+        // The IOS auto-increments the offset, except on the FIFO.
+        //
+        if (ui32Addr != HOST_ADDR_FIFO)
+        {
+            ui32Addr++;
+        }
+
+        sim_advance(BYTE_NS);
+    }
+
+    if (bWrite)
+    {
+        IOSLAVE->INTSTAT |= AM_HAL_IOS_INT_XCMPWR;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static void
+host_rx(uint8_t ui8Channel, uint8_t *pui8Data, uint32_t ui32Length,
+        void *pCallbackCtxt)
+{
+    uint32_t ui32Seq = g_sHost.ui32Seq++;
+    uint32_t ui32Slot = ui32Seq % FRAME_RING;
+    uint64_t ui64Latency = g_ui64Now - g_sProducer.pui64SentAt[ui32Slot];
+    bool bOk = (pCallbackCtxt == &g_sHost) &&
+               (ui32Seq < g_sProducer.ui32Seq) &&
+               (ui8Channel == (ui32Seq & 3)) &&
+               (ui32Length == g_sProducer.pui32SentLength[ui32Slot]) &&
+               (memcmp(pui8Data, &ui32Seq, 4) == 0);
+
+    for (uint32_t i = 4; bOk && (i < ui32Length); i++)
+    {
+        bOk = pui8Data[i] == frame_byte(ui32Seq, i);
+    }
+
+    if (!bOk)
+    {
+        if (!g_sHost.ui32Bad) { for (uint32_t k = 0; k < ui32Length; k++) printf("%02x%s", pui8Data[k], k == 3 ? "|" : ""); printf("\n"); }
+
+        g_sHost.ui32Bad++;
+    }
+
+    g_sHost.ui64Payload += ui32Length;
+    g_sHost.ui64LatencySum += ui64Latency;
+    if (ui64Latency > g_sHost.ui64LatencyMax)
+    {
+        g_sHost.ui64LatencyMax = ui64Latency;
+    }
+}
+
+static void
+host_mbox_send(void)
+{
+    uint8_t pui8Msg[AM_UTIL_IOS_LINK_MBOX_MAX];
+    uint32_t ui32Msg = g_sMbox.ui32Sent;
+    uint32_t ui32Length = rand_next() % (AM_UTIL_IOS_LINK_MBOX_MAX + 1);
+
+    for (uint32_t i = 0; i < ui32Length; i++)
+    {
+        pui8Msg[i] = frame_byte(ui32Msg, i);
+    }
+
+    g_sMbox.pui32Length[ui32Msg % 16] = ui32Length;
+    CHECK(am_util_ios_link_host_send(&g_sHost.sLink, (uint8_t)ui32Msg,
+                                     pui8Msg, ui32Length) == AM_HAL_STATUS_SUCCESS);
+    g_sMbox.ui32Sent++;
+    g_sMbox.ui64Due += MBOX_PERIOD_NS;
+}
+
+//
+// One step of the host: service the slave once its IOINT line has been up
+// for the interrupt latency, otherwise send mail or idle.
+//
+static void
+host_step(void)
+{
+    if (model_ioint_line())
+    {
+        if (!g_sHost.bIrqPending)
+        {
+            g_sHost.bIrqPending = true;
+            g_sHost.ui64IrqAt = g_ui64Now + HOST_LATENCY_NS;
+        }
+        else if (g_ui64Now >= g_sHost.ui64IrqAt)
+        {
+            g_sHost.bIrqPending = false;
+            CHECK(am_util_ios_link_host_service(&g_sHost.sLink) == AM_HAL_STATUS_SUCCESS);
+            return;
+        }
+    }
+    else
+    {
+        g_sHost.bIrqPending = false;
+    }
+
+    if (g_sMbox.bEnabled && (g_ui64Now >= g_sMbox.ui64Due) &&
+        am_util_ios_link_host_send_ready(&g_sHost.sLink))
+    {
+        host_mbox_send();
+        return;
+    }
+
+    sim_advance(BYTE_NS);
+}
+
+//*****************************************************************************
+//
+// One run of the link.
+//
+//*****************************************************************************
+typedef struct
+{
+    double      dKBps;
+    double      dBusPercent;
+    double      dHostIntPerKB;
+    double      dSlaveIsrPerKB;
+    double      dLatencyMeanUs;
+    double      dLatencyMaxUs;
+} link_result_t;
+
+static void
+run_link(uint32_t ui32Threshold, uint32_t ui32ReadBufferSize, bool bSaturate,
+         bool bMailbox, uint32_t ui32DurationMs, link_result_t *psResult)
+{
+    am_hal_ios_config_t sIosConfig =
+    {
+        .ui32InterfaceSelect = AM_HAL_IOS_USE_SPI,
+        .ui32ROBase = IOS_RO_BASE,
+        .ui32FIFOBase = IOS_FIFO_BASE,
+        .ui32RAMBase = IOS_RAM_BASE,
+        .ui32FIFOThreshold = IOS_FIFO_THR,
+        .pui8SRAMBuffer = g_pui8SramBuffer,
+        .ui32SRAMBufferCap = sizeof(g_pui8SramBuffer),
+    };
+    am_util_ios_link_config_t sSlaveConfig =
+    {
+        .ui32DoorbellThreshold = ui32Threshold,
+        .pfnRxCallback = slave_mbox_rx,
+        .pCallbackCtxt = &g_sMbox,
+    };
+    am_util_ios_link_host_config_t sHostConfig =
+    {
+        .pIomHandle = &g_ui32IomHandle,
+        .bSpi = true,
+        .ui32ChipSelect = SPI_CS,
+        .pui32ReadBuffer = g_pui32ReadBuffer,
+        .ui32ReadBufferSize = ui32ReadBufferSize,
+        .pui8FrameBuffer = g_pui8FrameBuffer,
+        .ui32FrameBufferSize = sizeof(g_pui8FrameBuffer),
+        .pfnRxCallback = host_rx,
+        .pCallbackCtxt = &g_sHost,
+    };
+    uint64_t ui64End = (uint64_t)ui32DurationMs * 1000000;
+    uint64_t ui64Payload;
+    am_util_ios_link_host_stats_t sHostStats;
+    am_util_ios_link_stats_t sSlaveStats;
+    uint8_t pui8Big[AM_UTIL_IOS_LINK_FIFOCTR_MAX + 1] = { 0 };
+
+    //
+    // Power-on state.
+    //
+    memset((void *)(uintptr_t)REG_IOSLAVE_BASEADDR, 0, IOS_REGS_SIZE);
+    memset(&g_sModel, 0, sizeof(g_sModel));
+    memset(&g_sProducer, 0, sizeof(g_sProducer));
+    memset(&g_sHost, 0, sizeof(g_sHost));
+    memset(&g_sMbox, 0, sizeof(g_sMbox));
+    g_sSlave.bIrqPending = false;
+    g_sSlave.ui32Isrs = 0;
+    g_ui64Now = 0;
+
+    CHECK(am_hal_ios_disable(g_sSlave.pIosHandle) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_hal_ios_configure(g_sSlave.pIosHandle, &sIosConfig) == AM_HAL_STATUS_SUCCESS);
+    g_sModel.bArmed = true;
+    g_sModel.ui32WritePtr = IOS_FIFO_BASE;
+
+    sSlaveConfig.pIosHandle = g_sSlave.pIosHandle;
+    CHECK(am_util_ios_link_init(&sSlaveConfig) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_util_ios_link_send(0, pui8Big, sizeof(pui8Big)) == AM_HAL_STATUS_OUT_OF_RANGE);
+    CHECK(am_util_ios_link_host_init(&g_sHost.sLink, &sHostConfig) == AM_HAL_STATUS_SUCCESS);
+
+    //
+    // The slave starts producing before the host is up.
+    //
+    g_sProducer.bActive = true;
+    g_sProducer.bSaturate = bSaturate;
+    g_sProducer.ui64FlushAt = FLUSH_PERIOD_NS;
+    while (g_ui64Now < HOST_START_NS)
+    {
+        sim_advance(BYTE_NS);
+    }
+
+    CHECK(am_util_ios_link_host_start(&g_sHost.sLink) == AM_HAL_STATUS_SUCCESS);
+    g_sMbox.bEnabled = bMailbox;
+    g_sMbox.ui64Due = g_ui64Now;
+
+    while (g_ui64Now < ui64End)
+    {
+        host_step();
+    }
+
+    ui64Payload = g_sHost.ui64Payload;
+
+    //
+    // Everything sent must arrive once the producer stops.
+    //
+    g_sProducer.bActive = false;
+    g_sMbox.bEnabled = false;
+    am_util_ios_link_flush();
+    while (((g_sHost.ui32Seq != g_sProducer.ui32Seq) ||
+            (g_sMbox.ui32Received != g_sMbox.ui32Sent)) &&
+           (g_ui64Now < ui64End + DRAIN_NS))
+    {
+        host_step();
+    }
+
+    am_util_ios_link_host_stats_get(&g_sHost.sLink, &sHostStats);
+    am_util_ios_link_stats_get(&sSlaveStats);
+
+    CHECK(g_sProducer.ui32Seq > 0);
+    CHECK(g_sHost.ui32Seq == g_sProducer.ui32Seq);
+    CHECK(g_sHost.ui32Bad == 0);
+    CHECK(sHostStats.ui32FramesRx == g_sProducer.ui32Seq);
+    CHECK(sHostStats.ui32SyncErrors == 0);
+    CHECK(sSlaveStats.ui32FramesTx == g_sProducer.ui32Seq);
+    CHECK(g_sMbox.ui32Received == g_sMbox.ui32Sent);
+    CHECK(g_sMbox.ui32Bad == 0);
+    CHECK(!bMailbox || (g_sMbox.ui32Sent > 0));
+    CHECK(g_sModel.ui32Underflows == 0);
+    CHECK(g_sModel.ui32Overflows == 0);
+    CHECK(g_sModel.ui32BadXfers == 0);
+    CHECK(g_sSlave.ui32BadIsrs == 0);
+    CHECK(!g_bIntDisabled);
+
+    CHECK(am_util_ios_link_host_stop(&g_sHost.sLink) == AM_HAL_STATUS_SUCCESS);
+    for (uint32_t i = 0; (i < 1000) && am_util_ios_link_host_active(); i++)
+    {
+        sim_advance(BYTE_NS);
+    }
+    CHECK(!am_util_ios_link_host_active());
+
+    psResult->dKBps = ui64Payload * 1e9 / 1024 / ui64End;
+    psResult->dBusPercent = 100.0 * ui64Payload * BYTE_NS / ui64End;
+    psResult->dHostIntPerKB = sHostStats.ui32Interrupts * 1024.0 / g_sHost.ui64Payload;
+    psResult->dSlaveIsrPerKB = g_sSlave.ui32Isrs * 1024.0 / g_sHost.ui64Payload;
+    psResult->dLatencyMeanUs = g_sHost.ui64LatencySum / 1e3 / g_sHost.ui32Seq;
+    psResult->dLatencyMaxUs = g_sHost.ui64LatencyMax / 1e3;
+
+    printf("  %-9s thr %3u buf %4u%s: %6.1f KB/s (%4.1f%% of bus), "
+           "host %5.2f int/KB, slave %5.2f isr/KB, latency %6.0f us mean %6.0f us max\n",
+           bSaturate ? "saturated" : "paced", (unsigned)ui32Threshold,
+           (unsigned)ui32ReadBufferSize, bMailbox ? " +mbox" : "",
+           psResult->dKBps, psResult->dBusPercent, psResult->dHostIntPerKB,
+           psResult->dSlaveIsrPerKB, psResult->dLatencyMeanUs,
+           psResult->dLatencyMaxUs);
+}
+
+//*****************************************************************************
+//
+// Tests
+//
+//*****************************************************************************
+static void
+test_saturated(uint32_t ui32DurationMs)
+{
+    link_result_t s64, s256, s1024, sMailbox;
+
+    printf("saturated producer, random 4..256 byte frames:\n");
+    run_link(512, 64, true, false, ui32DurationMs, &s64);
+    run_link(512, 256, true, false, ui32DurationMs, &s256);
+    run_link(512, BUFFER_SIZE, true, false, ui32DurationMs, &s1024);
+    run_link(512, BUFFER_SIZE, true, true, ui32DurationMs, &sMailbox);
+
+    //
+    // A full FIFO goes out as one batch per doorbell, so the host takes about
+    // one interrupt per KB whatever the read size; larger reads save the
+    // per-transaction overhead.
+    //
+    CHECK(s1024.dKBps > s256.dKBps);
+    CHECK(s256.dKBps > s64.dKBps);
+    CHECK(s1024.dBusPercent > 90.0);
+    CHECK(s1024.dHostIntPerKB < 1.5);
+    CHECK(sMailbox.dBusPercent > 80.0);
+}
+
+static void
+test_paced(uint32_t ui32DurationMs)
+{
+    link_result_t sPerFrame, s128, s512;
+
+    printf("paced producer, %u byte frames every %u us, flushed every %u ms:\n",
+           PACED_LENGTH, PACED_PERIOD_NS / 1000, FLUSH_PERIOD_NS / 1000000);
+    run_link(1, BUFFER_SIZE, false, false, ui32DurationMs, &sPerFrame);
+    run_link(128, BUFFER_SIZE, false, false, ui32DurationMs, &s128);
+    run_link(512, BUFFER_SIZE, false, false, ui32DurationMs, &s512);
+
+    //
+    // A per-frame doorbell costs a host interrupt per frame.  Batching cuts
+    // that by the batch size, up to what the flush timer lets accumulate,
+    // and the flush timer bounds the latency.  Frames queued while the host
+    // reads a large batch go out on its acknowledge, below the threshold, so
+    // a threshold of 512 gains less over 128 than the sizes suggest.
+    //
+    CHECK(sPerFrame.dHostIntPerKB > 0.9 * 1024 / PACED_LENGTH);
+    CHECK(sPerFrame.dLatencyMaxUs < 200);
+    CHECK(s128.dHostIntPerKB < sPerFrame.dHostIntPerKB / 4);
+    CHECK(s512.dHostIntPerKB < s128.dHostIntPerKB);
+    CHECK(s512.dLatencyMaxUs < (FLUSH_PERIOD_NS + HOST_LATENCY_NS) / 1000 + 1000);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32DurationMs = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:l:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                ui32DurationMs = strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                g_ui32IsrLatencyNs = strtoul(optarg, NULL, 0) * 1000;
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t ms per run] [-l slave isr latency us] [-s seed]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    host_regs_map(REG_IOSLAVE_BASEADDR, IOS_REGS_SIZE);
+    CHECK(am_hal_ios_initialize(0, &g_sSlave.pIosHandle) == AM_HAL_STATUS_SUCCESS);
+
+    test_saturated(ui32DurationMs);
+    test_paced(ui32DurationMs);
+
+    return host_test_result();
+}
@@ -0,0 +1,780 @@
+//*****************************************************************************
+//
+//! @file mspi_flash_test.c
+//!
+//! @brief Host test of the MSPI flash driver on a model of the MX25U12835F.
+//!
+//!
+//! The MSPI HAL is replaced by a model of the part with real timing: write
+//! enable latch, page programs that wrap within a page, 4K and 64K erases,
+//! program/erase suspend that takes effect after a latency, and resume that
+//! is ignored unless the part is suspended.  DMA completes after a transfer
+//! time and its callback runs as the interrupt would, from the delay calls.
+//!
+//! Covers the erase granularity of the blocking and asynchronous paths, page
+//! gathering, and the non-blocking suspend/resume/read protocol.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "am_bsp.h"
+#include "am_util_delay.h"
+#include "am_util_stdio.h"
+#include "am_devices_mspi_flash.h"
+#include "host_test.h"
+
+#if !defined (MACRONIX_MX25U12835F)
+#error "The flash model is an MX25U12835F; build with -DMACRONIX_MX25U12835F."
+#endif
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define MODEL_SIZE                  (256 * 1024)
+#define MODEL_PAGE                  256
+
+//
+// MX25U12835F commands and typical timings, in nanoseconds.
+//
+#define MX_WREN                     0x06
+#define MX_WRDI                     0x04
+#define MX_RDSR                     0x05
+#define MX_SE_4K                    0x20
+#define MX_BE_64K                   0xD8
+#define MX_SUSPEND                  0xB0
+#define MX_RESUME                   0x30
+
+#define MX_T_PP                     300000ull
+#define MX_T_SE                     30000000ull
+#define MX_T_BE                     250000000ull
+#define MX_T_SUSPEND                20000ull
+#define MX_T_BYTE                   40ull       // DMA time per byte.
+
+//*****************************************************************************
+//
+// Flash model.
+//
+//*****************************************************************************
+typedef enum
+{
+    MODEL_IDLE,
+    MODEL_PROGRAM,
+    MODEL_ERASE
+} model_op_e;
+
+typedef struct
+{
+    uint64_t                ui64Now;
+    uint8_t                 pui8Array[MODEL_SIZE];
+    bool                    bWel;
+
+    model_op_e              eOp;
+    uint32_t                ui32OpAddress;
+    uint32_t                ui32OpBytes;
+    uint8_t                 pui8OpData[MODEL_PAGE];
+    uint64_t                ui64OpEnd;          // Valid while not suspended.
+    uint64_t                ui64OpRemaining;    // Valid while suspended.
+    uint64_t                ui64SuspendAt;
+    bool                    bSuspended;
+
+    //
+    // DMA in flight.
+    //
+    bool                    bDMA;
+    uint64_t                ui64DMAEnd;
+    am_hal_mspi_callback_t  pfnDMACallback;
+    void                    *pDMACallbackCtxt;
+    bool                    bFailNextDMA;
+
+    //
+    // Counters.
+    //
+    uint32_t                ui32Programs;
+    uint32_t                ui32Erases;
+    uint32_t                ui32ErasedBytes;
+    uint32_t                ui32Suspends;
+    uint32_t                ui32IgnoredResumes;
+    uint32_t                ui32Violations;     // Commands the part would reject.
+    uint32_t                ui32BusyReads;      // Array reads while not readable.
+    uint32_t                ui32ModifiedReads;  // Reads of the region being modified.
+} flash_model_t;
+
+static flash_model_t g_sModel;
+
+static void
+model_complete(void)
+{
+    uint32_t i;
+
+    if (g_sModel.eOp == MODEL_ERASE)
+    {
+        memset(&g_sModel.pui8Array[g_sModel.ui32OpAddress], 0xFF, g_sModel.ui32OpBytes);
+    }
+    else if (g_sModel.eOp == MODEL_PROGRAM)
+    {
+        //
+        // Data past the end of the page wraps to its start, as on the part.
+        //
+        uint32_t ui32Page = g_sModel.ui32OpAddress & ~(MODEL_PAGE - 1);
+
+        for (i = 0; i < g_sModel.ui32OpBytes; i++)
+        {
+            uint32_t ui32Address = ui32Page + ((g_sModel.ui32OpAddress + i) & (MODEL_PAGE - 1));
+
+            g_sModel.pui8Array[ui32Address] &= g_sModel.pui8OpData[i];
+        }
+    }
+
+    g_sModel.eOp = MODEL_IDLE;
+    g_sModel.bWel = false;
+}
+
+//
+// Bring the model up to the current time and deliver a finished DMA, as the
+// MSPI interrupt would.
+//
+static void
+model_update(void)
+{
+    if ( (g_sModel.eOp != MODEL_IDLE) && !g_sModel.bSuspended )
+    {
+        if ( g_sModel.ui64SuspendAt && (g_sModel.ui64SuspendAt <= g_sModel.ui64Now) )
+        {
+            if (g_sModel.ui64OpEnd <= g_sModel.ui64SuspendAt)
+            {
+                model_complete();
+            }
+            else
+            {
+                g_sModel.bSuspended = true;
+                g_sModel.ui64OpRemaining = g_sModel.ui64OpEnd - g_sModel.ui64SuspendAt;
+                g_sModel.ui32Suspends++;
+            }
+            g_sModel.ui64SuspendAt = 0;
+        }
+        else if (g_sModel.ui64OpEnd <= g_sModel.ui64Now)
+        {
+            model_complete();
+            g_sModel.ui64SuspendAt = 0;
+        }
+    }
+
+    if ( g_sModel.bDMA && (g_sModel.ui64DMAEnd <= g_sModel.ui64Now) )
+    {
+        uint32_t ui32Status = g_sModel.bFailNextDMA ? AM_HAL_STATUS_FAIL : AM_HAL_STATUS_SUCCESS;
+
+        g_sModel.bDMA = false;
+        g_sModel.bFailNextDMA = false;
+        if (g_sModel.pfnDMACallback)
+        {
+            g_sModel.pfnDMACallback(g_sModel.pDMACallbackCtxt, ui32Status);
+        }
+    }
+}
+
+static void
+model_advance(uint64_t ui64Ns)
+{
+    g_sModel.ui64Now += ui64Ns;
+    model_update();
+}
+
+static bool
+model_busy(void)
+{
+    return (g_sModel.eOp != MODEL_IDLE) && !g_sModel.bSuspended;
+}
+
+static void
+model_start(model_op_e eOp, uint32_t ui32Address, uint32_t ui32Bytes, uint64_t ui64Time)
+{
+    if ( !g_sModel.bWel || (g_sModel.eOp != MODEL_IDLE) ||
+         (ui32Address + ui32Bytes > MODEL_SIZE) )
+    {
+        g_sModel.ui32Violations++;
+        return;
+    }
+
+    g_sModel.eOp = eOp;
+    g_sModel.ui32OpAddress = ui32Address;
+    g_sModel.ui32OpBytes = ui32Bytes;
+    g_sModel.ui64OpEnd = g_sModel.ui64Now + ui64Time;
+    g_sModel.ui64SuspendAt = 0;
+    g_sModel.bSuspended = false;
+}
+
+//*****************************************************************************
+//
+// MSPI HAL.
+//
+//*****************************************************************************
+uint32_t
+am_hal_mspi_blocking_transfer(void *pHandle,
+                              am_hal_mspi_pio_transfer_t *pTransaction,
+                              uint32_t ui32Timeout)
+{
+    (void)pHandle;
+    (void)ui32Timeout;
+
+    model_update();
+
+    if (pTransaction->eDirection == AM_HAL_MSPI_RX)
+    {
+        if (pTransaction->ui16DeviceInstr != MX_RDSR)
+        {
+            g_sModel.ui32Violations++;
+            return AM_HAL_STATUS_FAIL;
+        }
+        memset(pTransaction->pui32Buffer, 0, pTransaction->ui32NumBytes);
+        *(uint8_t *)pTransaction->pui32Buffer = (model_busy() ? 0x01 : 0) | (g_sModel.bWel ? 0x02 : 0);
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    switch (pTransaction->ui16DeviceInstr)
+    {
+        case MX_WREN:
+            g_sModel.bWel = true;
+            break;
+
+        case MX_WRDI:
+            g_sModel.bWel = false;
+            break;
+
+        case MX_SE_4K:
+            model_start(MODEL_ERASE, pTransaction->ui32DeviceAddr & ~0xFFFu, 0x1000, MX_T_SE);
+            g_sModel.ui32Erases++;
+            g_sModel.ui32ErasedBytes += 0x1000;
+            break;
+
+        case MX_BE_64K:
+            model_start(MODEL_ERASE, pTransaction->ui32DeviceAddr & ~0xFFFFu, 0x10000, MX_T_BE);
+            g_sModel.ui32Erases++;
+            g_sModel.ui32ErasedBytes += 0x10000;
+            break;
+
+        case MX_SUSPEND:
+            if ( model_busy() && (g_sModel.ui64SuspendAt == 0) )
+            {
+                g_sModel.ui64SuspendAt = g_sModel.ui64Now + MX_T_SUSPEND;
+            }
+            break;
+
+        case MX_RESUME:
+            if (g_sModel.bSuspended)
+            {
+                g_sModel.bSuspended = false;
+                g_sModel.ui64OpEnd = g_sModel.ui64Now + g_sModel.ui64OpRemaining;
+            }
+            else
+            {
+                g_sModel.ui32IgnoredResumes++;
+            }
+            break;
+
+        default:
+            g_sModel.ui32Violations++;
+            return AM_HAL_STATUS_FAIL;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t
+am_hal_mspi_nonblocking_transfer(void *pHandle, void *pTransfer,
+                                 am_hal_mspi_trans_e eMode,
+                                 am_hal_mspi_callback_t pfnCallback,
+                                 void *pCallbackCtxt)
+{
+    am_hal_mspi_dma_transfer_t *pDMA = (am_hal_mspi_dma_transfer_t *)pTransfer;
+    uint8_t *pui8SRAM = (uint8_t *)(uintptr_t)pDMA->ui32SRAMAddress;
+    uint32_t ui32Address = pDMA->ui32DeviceAddress;
+    uint32_t ui32Count = pDMA->ui32TransferCount;
+
+    (void)pHandle;
+    (void)eMode;
+
+    model_update();
+
+    if ( g_sModel.bDMA || (ui32Address + ui32Count > MODEL_SIZE) )
+    {
+        g_sModel.ui32Violations++;
+        return AM_HAL_STATUS_FAIL;
+    }
+
+    if (pDMA->eDirection == AM_HAL_MSPI_TX)
+    {
+        //
+        // Page program: the array starts programming when the DMA ends.
+        //
+        if (ui32Count > MODEL_PAGE)
+        {
+            g_sModel.ui32Violations++;
+            return AM_HAL_STATUS_FAIL;
+        }
+        model_start(MODEL_PROGRAM, ui32Address, ui32Count, ui32Count * MX_T_BYTE + MX_T_PP);
+        memcpy(g_sModel.pui8OpData, pui8SRAM, ui32Count);
+        g_sModel.ui32Programs++;
+    }
+    else
+    {
+        if (model_busy())
+        {
+            g_sModel.ui32BusyReads++;
+        }
+        else if ( (g_sModel.eOp != MODEL_IDLE) &&
+                  (ui32Address < g_sModel.ui32OpAddress + g_sModel.ui32OpBytes) &&
+                  (g_sModel.ui32OpAddress < ui32Address + ui32Count) )
+        {
+            g_sModel.ui32ModifiedReads++;
+        }
+        memcpy(pui8SRAM, &g_sModel.pui8Array[ui32Address], ui32Count);
+    }
+
+    g_sModel.bDMA = true;
+    g_sModel.ui64DMAEnd = g_sModel.ui64Now + ui32Count * MX_T_BYTE;
+    g_sModel.pfnDMACallback = pfnCallback;
+    g_sModel.pDMACallbackCtxt = pCallbackCtxt;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//
+// Delays move model time forward.  FLASH_CYCLES_US() counts
+// AM_HAL_CLKGEN_FREQ_MAX_MHZ / 3 iterations per microsecond.
+//
+void
+am_hal_flash_delay(uint32_t ui32Iterations)
+{
+    model_advance((uint64_t)ui32Iterations * 1000 / FLASH_CYCLES_US(1));
+}
+
+void
+am_util_delay_ms(uint32_t ui32MilliSeconds)
+{
+    model_advance((uint64_t)ui32MilliSeconds * 1000000);
+}
+
+void
+am_util_delay_us(uint32_t ui32MicroSeconds)
+{
+    model_advance((uint64_t)ui32MicroSeconds * 1000);
+}
+
+//
+// Entry points used only by init/deinit, which the test does not call.
+//
+uint32_t am_hal_mspi_initialize(uint32_t ui32Module, void **ppHandle) { (void)ui32Module; (void)ppHandle; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_deinitialize(void *pHandle) { (void)pHandle; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_device_configure(void *pHandle, am_hal_mspi_dev_config_t *pConfig) { (void)pHandle; (void)pConfig; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_enable(void *pHandle) { (void)pHandle; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_disable(void *pHandle) { (void)pHandle; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_control(void *pHandle, am_hal_mspi_request_e eRequest, void *pConfig) { (void)pHandle; (void)eRequest; (void)pConfig; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_interrupt_enable(void *pHandle, uint32_t ui32IntMask) { (void)pHandle; (void)ui32IntMask; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_interrupt_disable(void *pHandle, uint32_t ui32IntMask) { (void)pHandle; (void)ui32IntMask; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_interrupt_status_get(void *pHandle, uint32_t *pui32Status, bool bEnabledOnly) { (void)pHandle; (void)bEnabledOnly; *pui32Status = 0; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_interrupt_clear(void *pHandle, uint32_t ui32IntMask) { (void)pHandle; (void)ui32IntMask; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_interrupt_service(void *pHandle, uint32_t ui32IntStatus) { (void)pHandle; (void)ui32IntStatus; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_power_control(void *pHandle, am_hal_sysctrl_power_state_e ePowerState, bool bRetainState) { (void)pHandle; (void)ePowerState; (void)bRetainState; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_mspi_highprio_transfer(void *pHandle, am_hal_mspi_dma_transfer_t *pTransfer, am_hal_mspi_trans_e eMode, am_hal_mspi_callback_t pfnCallback, void *pCallbackCtxt) { return am_hal_mspi_nonblocking_transfer(pHandle, pTransfer, eMode, pfnCallback, pCallbackCtxt); }
+uint32_t am_hal_mcuctrl_control(am_hal_mcuctrl_control_e eControl, void *pArgs) { (void)eControl; (void)pArgs; return AM_HAL_STATUS_SUCCESS; }
+void am_bsp_mspi_pins_enable(uint32_t ui32Module, am_hal_mspi_device_e eMSPIDevice) { (void)ui32Module; (void)eMSPIDevice; }
+
+uint32_t
+am_util_stdio_printf(const char *pui8Fmt, ...)
+{
+    va_list args;
+    int n;
+
+    va_start(args, pui8Fmt);
+    n = vprintf(pui8Fmt, args);
+    va_end(args);
+
+    return (uint32_t)n;
+}
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+#define ASYNC_JOBS                  16
+#define SERVICE_PERIOD_NS           100000ull
+
+static am_devices_mspi_flash_async_job_t g_sJobs[ASYNC_JOBS];
+static uint32_t g_ui32Callbacks;
+static uint32_t g_ui32CallbackErrors;
+
+//
+// Buffers handed to the driver must have addresses that survive its 32-bit
+// SRAM address fields, so they are static (the test is linked -no-pie).
+//
+static uint8_t g_pui8Tx[4096];
+static uint8_t g_pui8Rx[4096];
+
+static void
+job_done(void *pCallbackCtxt, uint32_t ui32Status)
+{
+    (void)pCallbackCtxt;
+
+    g_ui32Callbacks++;
+    if (AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS != ui32Status)
+    {
+        g_ui32CallbackErrors++;
+    }
+}
+
+static void
+test_reset(void)
+{
+    memset(&g_sModel, 0, sizeof(g_sModel));
+    memset(g_sModel.pui8Array, 0x00, MODEL_SIZE);
+    g_ui32Callbacks = 0;
+    g_ui32CallbackErrors = 0;
+    CHECK(am_devices_mspi_flash_async_init(0, g_sJobs, ASYNC_JOBS) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+}
+
+//
+// Run the engine from a periodic service tick for up to ui64Ns.
+//
+static void
+run_for(uint64_t ui64Ns)
+{
+    uint64_t ui64End = g_sModel.ui64Now + ui64Ns;
+
+    while (g_sModel.ui64Now < ui64End)
+    {
+        model_advance(SERVICE_PERIOD_NS);
+        am_devices_mspi_flash_async_service();
+    }
+}
+
+static bool
+run_until_idle(uint64_t ui64Limit)
+{
+    uint64_t ui64End = g_sModel.ui64Now + ui64Limit;
+
+    while ( am_devices_mspi_flash_async_busy() && (g_sModel.ui64Now < ui64End) )
+    {
+        run_for(SERVICE_PERIOD_NS);
+    }
+
+    return !am_devices_mspi_flash_async_busy();
+}
+
+static bool
+range_is(uint32_t ui32Address, uint32_t ui32Bytes, uint8_t ui8Value)
+{
+    uint32_t i;
+
+    for (i = 0; i < ui32Bytes; i++)
+    {
+        if (g_sModel.pui8Array[ui32Address + i] != ui8Value)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Both erase paths erase exactly AM_DEVICES_MSPI_FLASH_SECTOR_SIZE.
+//
+//*****************************************************************************
+static void
+test_erase_granularity(void)
+{
+    test_reset();
+
+    CHECK(am_devices_mspi_flash_async_erase(0x11234, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(run_until_idle(100000000));
+    CHECK(g_ui32Callbacks == 1);
+    CHECK(g_ui32CallbackErrors == 0);
+    CHECK(g_sModel.ui32ErasedBytes == AM_DEVICES_MSPI_FLASH_SECTOR_SIZE);
+    CHECK(range_is(0x10000, 0x1000, 0x00));
+    CHECK(range_is(0x11000, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0xFF));
+    CHECK(range_is(0x11000 + AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0x1000, 0x00));
+
+    CHECK(am_devices_mspi_flash_sector_erase(0, 3 * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(g_sModel.ui32ErasedBytes == 2 * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE);
+    CHECK(range_is(2 * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0x00));
+    CHECK(range_is(3 * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0xFF));
+    CHECK(range_is(4 * AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0x00));
+    CHECK(g_sModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Small contiguous jobs are gathered into whole page programs that never
+// cross a page.
+//
+//*****************************************************************************
+static void
+test_program_gather(void)
+{
+    uint32_t ui32Start = 0x20F0, ui32Job = 13, ui32Jobs = 12, i;
+
+    test_reset();
+    memset(g_sModel.pui8Array, 0xFF, MODEL_SIZE);
+
+    for (i = 0; i < ui32Jobs * ui32Job; i++)
+    {
+        g_pui8Tx[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    //
+    // Hold the engine so all jobs are queued before the first starts.
+    //
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    for (i = 0; i < ui32Jobs; i++)
+    {
+        CHECK(am_devices_mspi_flash_async_program(&g_pui8Tx[i * ui32Job], ui32Start + i * ui32Job,
+                                                  ui32Job, job_done, NULL) ==
+              AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    }
+    CHECK(am_devices_mspi_flash_async_resume() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(run_until_idle(100000000));
+
+    CHECK(g_ui32Callbacks == ui32Jobs);
+    CHECK(g_ui32CallbackErrors == 0);
+    CHECK(g_sModel.ui32Programs == 2);
+    CHECK(memcmp(&g_sModel.pui8Array[ui32Start], g_pui8Tx, ui32Jobs * ui32Job) == 0);
+    CHECK(range_is(ui32Start - 16, 16, 0xFF));
+    CHECK(range_is(ui32Start + ui32Jobs * ui32Job, 64, 0xFF));
+    CHECK(g_sModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Suspend never waits: it reports BUSY until the part has suspended.  Reads
+// elsewhere in the array are then served; reads of the sector being erased
+// are refused.
+//
+//*****************************************************************************
+static void
+test_suspend_erase(void)
+{
+    uint64_t ui64Before;
+    uint32_t ui32Status;
+
+    test_reset();
+    memset(&g_sModel.pui8Array[0x30000], 0x5A, 0x1000);
+
+    CHECK(am_devices_mspi_flash_async_erase(0x20000, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    run_for(1000000);
+
+    ui64Before = g_sModel.ui64Now;
+    ui32Status = am_devices_mspi_flash_async_suspend();
+    CHECK(ui32Status == AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    CHECK(g_sModel.ui64Now == ui64Before);
+
+    //
+    // A read asked for before the part has suspended is not attempted.
+    //
+    CHECK(am_devices_mspi_flash_async_read(g_pui8Rx, 0x30000, 64) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    CHECK(g_sModel.ui64Now == ui64Before);
+
+    model_advance(MX_T_SUSPEND);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(g_sModel.bSuspended);
+
+    memset(g_pui8Rx, 0, sizeof(g_pui8Rx));
+    CHECK(am_devices_mspi_flash_async_read(g_pui8Rx, 0x30000, 64) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(g_pui8Rx[0] == 0x5A && g_pui8Rx[63] == 0x5A);
+
+    //
+    // The read resumed the erase, so suspend again before the refused read.
+    //
+    CHECK(!g_sModel.bSuspended);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    model_advance(MX_T_SUSPEND);
+    CHECK(am_devices_mspi_flash_async_read(g_pui8Rx, 0x20800, 16) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_ERROR);
+    CHECK(am_devices_mspi_flash_async_resume() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+
+    CHECK(run_until_idle(100000000));
+    CHECK(g_ui32Callbacks == 1);
+    CHECK(g_ui32CallbackErrors == 0);
+    CHECK(g_sModel.ui32Suspends == 2);
+    CHECK(range_is(0x20000, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0xFF));
+    CHECK(g_sModel.ui32BusyReads == 0);
+    CHECK(g_sModel.ui32ModifiedReads == 0);
+    CHECK(g_sModel.ui32IgnoredResumes == 0);
+    CHECK(g_sModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A suspend asked for while page data is still being sent is sent once the
+// transfer ends.
+//
+//*****************************************************************************
+static void
+test_suspend_program_dma(void)
+{
+    uint64_t ui64Before;
+
+    test_reset();
+    memset(g_sModel.pui8Array, 0xFF, MODEL_SIZE);
+    memset(g_pui8Tx, 0xA5, MODEL_PAGE);
+
+    CHECK(am_devices_mspi_flash_async_program(g_pui8Tx, 0x4000, MODEL_PAGE, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(g_sModel.bDMA);
+
+    ui64Before = g_sModel.ui64Now;
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    CHECK(g_sModel.ui64Now == ui64Before);
+
+    //
+    // The DMA interrupt ends the transfer; the next call sends the suspend.
+    //
+    model_advance(MODEL_PAGE * MX_T_BYTE);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    model_advance(MX_T_SUSPEND);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(g_sModel.bSuspended);
+    CHECK(am_devices_mspi_flash_async_resume() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+
+    CHECK(run_until_idle(10000000));
+    CHECK(g_ui32Callbacks == 1);
+    CHECK(g_ui32CallbackErrors == 0);
+    CHECK(range_is(0x4000, MODEL_PAGE, 0xA5));
+    CHECK(g_sModel.ui32IgnoredResumes == 0);
+    CHECK(g_sModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A resume that arrives before the suspend has taken effect is sent once it
+// has, so the part is never left suspended.  An operation that finishes
+// before the suspend lands completes normally.
+//
+//*****************************************************************************
+static void
+test_suspend_races(void)
+{
+    test_reset();
+
+    CHECK(am_devices_mspi_flash_async_erase(0x8000, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    run_for(1000000);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    CHECK(am_devices_mspi_flash_async_resume() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(run_until_idle(100000000));
+    CHECK(g_ui32Callbacks == 1);
+    CHECK(g_ui32CallbackErrors == 0);
+    CHECK(g_sModel.ui32Suspends == 1);
+    CHECK(g_sModel.ui32IgnoredResumes == 0);
+    CHECK(range_is(0x8000, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0xFF));
+
+    //
+    // Suspend in the last few microseconds of an erase.
+    //
+    CHECK(am_devices_mspi_flash_async_erase(0x9000, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    model_advance(MX_T_SE - MX_T_SUSPEND / 2);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_BUSY);
+    model_advance(MX_T_SUSPEND);
+    CHECK(am_devices_mspi_flash_async_suspend() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_flash_async_resume() == AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(run_until_idle(10000000));
+    CHECK(g_ui32Callbacks == 2);
+    CHECK(g_ui32CallbackErrors == 0);
+    CHECK(range_is(0x9000, AM_DEVICES_MSPI_FLASH_SECTOR_SIZE, 0xFF));
+    CHECK(g_sModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A failed page data transfer fails the jobs it carried and the queue moves
+// on.
+//
+//*****************************************************************************
+static void
+test_dma_error(void)
+{
+    test_reset();
+    memset(g_sModel.pui8Array, 0xFF, MODEL_SIZE);
+    memset(g_pui8Tx, 0x11, 2 * MODEL_PAGE);
+
+    g_sModel.bFailNextDMA = true;
+    CHECK(am_devices_mspi_flash_async_program(g_pui8Tx, 0x5000, MODEL_PAGE, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_flash_async_program(g_pui8Tx, 0x6000, MODEL_PAGE, job_done, NULL) ==
+          AM_DEVICES_MSPI_FLASH_STATUS_SUCCESS);
+    CHECK(run_until_idle(10000000));
+    CHECK(g_ui32Callbacks == 2);
+    CHECK(g_ui32CallbackErrors == 1);
+    CHECK(range_is(0x6000, MODEL_PAGE, 0x11));
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(void)
+{
+    test_erase_granularity();
+    test_program_gather();
+    test_suspend_erase();
+    test_suspend_program_dma();
+    test_suspend_races();
+    test_dma_error();
+
+    return host_test_result();
+}
@@ -0,0 +1,487 @@
+//*****************************************************************************
+//
+//! @file pdm_stream_test.c
+//!
+//! @brief Host test of the PDM streaming ring.
+//!
+//!
+//! The PDM register block is mapped into RAM and the test plays the DMA: it
+//! fills the frame the HAL armed (DMATARGADDR/DMATOTCOUNT) with a running
+//! sample count and calls am_hal_pdm_stream_service() as the interrupt
+//! handler would.  The consumer side checks that it sees frames in order,
+//! that every gap in the sample count is accounted for by an overrun or a
+//! DMA error, and that the DMA is never armed on a frame the consumer owns.
+//!
+//! Usage: pdm_stream_test [-n events] [-s seed]
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define MAX_FRAMES                  8
+#define MAX_FRAME_WORDS             64
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static void *g_pHandle;
+
+//
+// The ring must have an address that fits the HAL's 32-bit DMA target
+// register, so it is static and the test is linked -no-pie.
+//
+static uint32_t g_pui32Ring[MAX_FRAMES * MAX_FRAME_WORDS];
+
+static uint32_t g_ui32NumFrames;
+static uint32_t g_ui32FrameWords;
+
+//
+// Producer and consumer bookkeeping.
+//
+static uint32_t g_ui32NextSample;       // Next sample the "microphone" makes.
+static uint32_t g_ui32Expected;         // Next sample the consumer expects.
+static uint32_t g_ui32DroppedFrames;    // Frames missing from what was consumed.
+static uint32_t g_ui32Consumed;
+static uint32_t g_ui32DmaErrors;
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the PDM module links against.
+//
+//*****************************************************************************
+void am_hal_flash_delay(uint32_t ui32Iterations) { (void)ui32Iterations; }
+uint32_t am_hal_clkgen_status_get(am_hal_clkgen_status_t *psStatus) { psStatus->ui32SysclkFreq = 48000000; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_pwrctrl_periph_enable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+uint32_t am_hal_pwrctrl_periph_disable(am_hal_pwrctrl_periph_e ePeripheral) { (void)ePeripheral; return AM_HAL_STATUS_SUCCESS; }
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+static uint32_t
+frame_slot(const void *pFrame)
+{
+    return (uint32_t)(((const uint32_t *)pFrame - g_pui32Ring) / g_ui32FrameWords);
+}
+
+static void
+stream_begin(uint32_t ui32NumFrames, uint32_t ui32FrameWords)
+{
+    am_hal_pdm_stream_config_t sConfig =
+    {
+        .pui32Buffer = g_pui32Ring,
+        .ui32FrameBytes = ui32FrameWords * 4,
+        .ui32NumFrames = ui32NumFrames,
+    };
+
+    g_ui32NumFrames = ui32NumFrames;
+    g_ui32FrameWords = ui32FrameWords;
+    g_ui32NextSample = 0;
+    g_ui32Expected = 0;
+    g_ui32DroppedFrames = 0;
+    g_ui32Consumed = 0;
+    g_ui32DmaErrors = 0;
+    memset(g_pui32Ring, 0xFF, sizeof(g_pui32Ring));
+
+    CHECK(am_hal_pdm_stream_start(g_pHandle, &sConfig) == AM_HAL_STATUS_SUCCESS);
+}
+
+//
+// Play the DMA: check where it was armed, fill that frame, and raise the
+// interrupt.
+//
+static void
+dma_complete(bool bError)
+{
+    am_hal_pdm_stream_status_t sStatus;
+    uint32_t ui32Target = PDMn(0)->DMATARGADDR;
+    uint32_t ui32Ring = (uint32_t)(uintptr_t)g_pui32Ring;
+    uint32_t ui32Slot, i;
+    void *pOldest;
+
+    CHECK(PDMn(0)->DMACFG_b.DMAEN == PDM_DMACFG_DMAEN_EN);
+    CHECK(PDMn(0)->DMATOTCOUNT == g_ui32FrameWords * 4);
+    CHECK((PDMn(0)->DMATOTCOUNT % PDMn(0)->FIFOTHR) == 0);
+    CHECK(ui32Target >= ui32Ring);
+    CHECK(((ui32Target - ui32Ring) % (g_ui32FrameWords * 4)) == 0);
+
+    ui32Slot = (ui32Target - ui32Ring) / (g_ui32FrameWords * 4);
+    CHECK(ui32Slot < g_ui32NumFrames);
+
+    //
+    // The frames the consumer owns are the ready ones, oldest first.
+    //
+    am_hal_pdm_stream_status_get(g_pHandle, &sStatus);
+    CHECK(sStatus.ui32FramesReady < g_ui32NumFrames);
+    if (am_hal_pdm_stream_frame_get(g_pHandle, &pOldest) == AM_HAL_STATUS_SUCCESS)
+    {
+        uint32_t ui32Owned = (ui32Slot + g_ui32NumFrames - frame_slot(pOldest)) % g_ui32NumFrames;
+
+        CHECK(ui32Owned >= sStatus.ui32FramesReady);
+    }
+
+    for (i = 0; i < g_ui32FrameWords; i++)
+    {
+        g_pui32Ring[ui32Slot * g_ui32FrameWords + i] = bError ? 0xDEADBEEF : g_ui32NextSample + i;
+    }
+    g_ui32NextSample += g_ui32FrameWords;
+
+    if (bError)
+    {
+        g_ui32DmaErrors++;
+    }
+
+    PDMn(0)->DMACFG_b.DMAEN = PDM_DMACFG_DMAEN_DIS;
+    am_hal_pdm_stream_service(g_pHandle, bError ? AM_HAL_PDM_INT_DERR : AM_HAL_PDM_INT_DCMP);
+}
+
+//
+// Consume the oldest frame: it must be whole and in order, and any gap
+// before it is counted as dropped frames.
+//
+static bool
+consume(void)
+{
+    uint32_t *pui32Frame;
+    uint32_t i;
+
+    if (am_hal_pdm_stream_frame_get(g_pHandle, (void **)&pui32Frame) != AM_HAL_STATUS_SUCCESS)
+    {
+        CHECK(pui32Frame == NULL);
+        return false;
+    }
+
+    CHECK(pui32Frame[0] >= g_ui32Expected);
+    CHECK(((pui32Frame[0] - g_ui32Expected) % g_ui32FrameWords) == 0);
+    for (i = 1; i < g_ui32FrameWords; i++)
+    {
+        CHECK(pui32Frame[i] == pui32Frame[0] + i);
+    }
+
+    g_ui32DroppedFrames += (pui32Frame[0] - g_ui32Expected) / g_ui32FrameWords;
+    g_ui32Expected = pui32Frame[0] + g_ui32FrameWords;
+    g_ui32Consumed++;
+
+    CHECK(am_hal_pdm_stream_frame_release(g_pHandle) == AM_HAL_STATUS_SUCCESS);
+    return true;
+}
+
+//
+// Drain what is left and check that every frame produced was either
+// consumed or counted as an overrun or a DMA error.
+//
+static void
+stream_end(void)
+{
+    am_hal_pdm_stream_status_t sStatus;
+    uint32_t ui32Produced = g_ui32NextSample / g_ui32FrameWords;
+
+    CHECK(am_hal_pdm_stream_stop(g_pHandle) == AM_HAL_STATUS_SUCCESS);
+    while (consume())
+    {
+    }
+
+    //
+    // Frames captured after the last one consumed were dropped too.
+    //
+    g_ui32DroppedFrames += (g_ui32NextSample - g_ui32Expected) / g_ui32FrameWords;
+
+    am_hal_pdm_stream_status_get(g_pHandle, &sStatus);
+    CHECK(sStatus.ui32FramesReady == 0);
+    CHECK(sStatus.ui32DmaErrors == g_ui32DmaErrors);
+    CHECK(sStatus.ui32FramesCaptured == ui32Produced - g_ui32DmaErrors);
+    CHECK(g_ui32Consumed + sStatus.ui32Overruns + sStatus.ui32DmaErrors == ui32Produced);
+    CHECK(g_ui32DroppedFrames == sStatus.ui32Overruns + sStatus.ui32DmaErrors);
+}
+
+//*****************************************************************************
+//
+// A consumer that keeps up never loses a frame.
+//
+//*****************************************************************************
+static void
+test_steady(void)
+{
+    am_hal_pdm_stream_status_t sStatus;
+    uint32_t i;
+
+    stream_begin(2, 64);
+    for (i = 0; i < 10000; i++)
+    {
+        dma_complete(false);
+        CHECK(consume());
+    }
+    am_hal_pdm_stream_status_get(g_pHandle, &sStatus);
+    CHECK(sStatus.ui32Overruns == 0);
+    CHECK(g_ui32DroppedFrames == 0);
+    stream_end();
+}
+
+//*****************************************************************************
+//
+// A stalled consumer keeps the oldest N-1 frames; every later frame is an
+// overrun until it catches up, and the gap it then sees matches.
+//
+//*****************************************************************************
+static void
+test_stall(void)
+{
+    am_hal_pdm_stream_status_t sStatus;
+    uint32_t ui32Stall = 10, i;
+
+    stream_begin(4, 16);
+    for (i = 0; i < ui32Stall; i++)
+    {
+        dma_complete(false);
+    }
+
+    am_hal_pdm_stream_status_get(g_pHandle, &sStatus);
+    CHECK(sStatus.ui32FramesReady == 3);
+    CHECK(sStatus.ui32Overruns == ui32Stall - 3);
+    CHECK(sStatus.ui32FramesCaptured == ui32Stall);
+
+    //
+    // The oldest three are intact and in order.
+    //
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(consume());
+    }
+    CHECK(g_ui32Expected == 3 * 16);
+    CHECK(g_ui32DroppedFrames == 0);
+
+    //
+    // The next frame shows the gap left by the overruns.
+    //
+    dma_complete(false);
+    CHECK(consume());
+    CHECK(g_ui32DroppedFrames == ui32Stall - 3);
+
+    stream_end();
+}
+
+//*****************************************************************************
+//
+// A DMA error drops that frame only, and its slot is captured again.
+//
+//*****************************************************************************
+static void
+test_dma_error(void)
+{
+    am_hal_pdm_stream_status_t sStatus;
+    uint32_t ui32Target;
+
+    stream_begin(3, 32);
+    dma_complete(false);
+    ui32Target = PDMn(0)->DMATARGADDR;
+    dma_complete(true);
+    CHECK(PDMn(0)->DMATARGADDR == ui32Target);
+    dma_complete(false);
+
+    am_hal_pdm_stream_status_get(g_pHandle, &sStatus);
+    CHECK(sStatus.ui32DmaErrors == 1);
+    CHECK(sStatus.ui32FramesReady == 2);
+    CHECK(consume());
+    CHECK(consume());
+    CHECK(g_ui32DroppedFrames == 1);
+    stream_end();
+}
+
+//*****************************************************************************
+//
+// Random interleaving of DMA completions and a bursty consumer.
+//
+//*****************************************************************************
+static void
+test_random(uint32_t ui32Events)
+{
+    am_hal_pdm_stream_status_t sStatus;
+    uint32_t i;
+
+    stream_begin(2 + rand_next() % (MAX_FRAMES - 1), 4 * (1 + rand_next() % (MAX_FRAME_WORDS / 4)));
+
+    for (i = 0; i < ui32Events; i++)
+    {
+        uint32_t ui32Roll = rand_next() % 1000;
+
+        if (ui32Roll < 480)
+        {
+            dma_complete(ui32Roll < 5);
+        }
+        else if (ui32Roll < 980)
+        {
+            consume();
+        }
+        else
+        {
+            //
+            // A long stall.
+            //
+            uint32_t ui32Stall = rand_next() % (3 * g_ui32NumFrames);
+
+            while (ui32Stall--)
+            {
+                dma_complete(false);
+            }
+        }
+    }
+
+    am_hal_pdm_stream_status_get(g_pHandle, &sStatus);
+    printf("Random: %u frames x %u words, %u produced, %u consumed, "
+           "%u overruns, %u DMA errors\n",
+           (unsigned)g_ui32NumFrames, (unsigned)g_ui32FrameWords,
+           (unsigned)(g_ui32NextSample / g_ui32FrameWords), (unsigned)g_ui32Consumed,
+           (unsigned)sStatus.ui32Overruns, (unsigned)sStatus.ui32DmaErrors);
+
+    stream_end();
+}
+
+//*****************************************************************************
+//
+// API misuse.
+//
+//*****************************************************************************
+static void
+test_api(void)
+{
+    am_hal_pdm_stream_config_t sConfig =
+    {
+        .pui32Buffer = g_pui32Ring,
+        .ui32FrameBytes = 64,
+        .ui32NumFrames = 1,
+    };
+    void *pFrame = g_pui32Ring;
+
+    CHECK(am_hal_pdm_stream_start(g_pHandle, &sConfig) == AM_HAL_STATUS_INVALID_ARG);
+    sConfig.ui32NumFrames = 2;
+    sConfig.ui32FrameBytes = 62;
+    CHECK(am_hal_pdm_stream_start(g_pHandle, &sConfig) == AM_HAL_STATUS_INVALID_ARG);
+
+    stream_begin(2, 16);
+    sConfig.ui32FrameBytes = 64;
+    CHECK(am_hal_pdm_stream_start(g_pHandle, &sConfig) == AM_HAL_STATUS_INVALID_OPERATION);
+    CHECK(am_hal_pdm_stream_frame_get(g_pHandle, &pFrame) == AM_HAL_PDM_STATUS_NO_FRAME);
+    CHECK(pFrame == NULL);
+    CHECK(am_hal_pdm_stream_frame_release(g_pHandle) == AM_HAL_STATUS_INVALID_OPERATION);
+
+    //
+    // After a stop, a late interrupt does not re-arm the DMA and captured
+    // frames stay available.
+    //
+    dma_complete(false);
+    CHECK(am_hal_pdm_stream_stop(g_pHandle) == AM_HAL_STATUS_SUCCESS);
+    CHECK(PDMn(0)->DMACFG_b.DMAEN == PDM_DMACFG_DMAEN_DIS);
+    am_hal_pdm_stream_service(g_pHandle, AM_HAL_PDM_INT_DCMP);
+    CHECK(PDMn(0)->DMACFG_b.DMAEN == PDM_DMACFG_DMAEN_DIS);
+    CHECK(consume());
+    CHECK(!consume());
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Events = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Events = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n events] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    host_regs_map(PDM_BASE, sizeof(PDM_Type));
+    if (am_hal_pdm_initialize(0, &g_pHandle) != AM_HAL_STATUS_SUCCESS)
+    {
+        printf("FAIL: am_hal_pdm_initialize\n");
+        return 1;
+    }
+
+    test_steady();
+    test_stall();
+    test_dma_error();
+    test_random(ui32Events);
+    test_random(ui32Events);
+    test_api();
+
+    return host_test_result();
+}
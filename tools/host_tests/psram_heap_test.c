@@ -0,0 +1,588 @@
+//*****************************************************************************
+//
+//! @file psram_heap_test.c
+//!
+//! @brief Host test of the MSPI PSRAM heap on a RAM model of the device.
+//!
+//!
+//! The heap's pfnRead/pfnWrite hooks are pointed at a RAM array standing in
+//! for the PSRAM.  A random mix of allocations, frees, short and long reads
+//! and writes is checked against a shadow copy of every block, with and
+//! without the write-back cache, along with the block invariants (range,
+//! overlap, alignment, page crossing), coalescing, cache traffic and error
+//! propagation from the transfer functions.
+//!
+//! Usage: psram_heap_test [-n ops] [-s seed]
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "am_devices_mspi_psram.h"
+#include "am_devices_mspi_psram_heap.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define PSRAM_BASE                  0x10000
+#define PSRAM_SIZE                  (64 * 1024)
+#define PSRAM_PAGE                  AM_DEVICES_MSPI_PSRAM_PAGE_SIZE
+#define TEST_BLOCKS                 48
+#define TEST_LINE                   64
+#define TEST_MAX_ALLOC              3000
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+//
+// Device model.  Addresses are PSRAM addresses; the array covers the whole
+// part so accesses outside the heap range are caught.
+//
+static uint8_t g_pui8Psram[PSRAM_BASE + PSRAM_SIZE];
+static uint32_t g_ui32FailReads;
+static uint32_t g_ui32FailWrites;
+static uint32_t g_ui32BadAccesses;
+
+//
+// Shadow of each live block, indexed by handle.
+//
+typedef struct
+{
+    bool        bLive;
+    uint32_t    ui32Size;
+    uint32_t    ui32Align;
+    bool        bNoPageCross;
+    uint8_t     *pui8Data;
+} shadow_t;
+
+static shadow_t g_sShadow[TEST_BLOCKS + 1];
+
+static uint64_t g_ui64Rand = 0x2545f4914f6cdd1dull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// PSRAM transfer functions for the heap.
+//
+//*****************************************************************************
+static uint32_t
+model_read(uint8_t *pui8Buffer, uint32_t ui32Address, uint32_t ui32NumBytes,
+           bool bWaitForCompletion)
+{
+    (void)bWaitForCompletion;
+
+    if (g_ui32FailReads)
+    {
+        g_ui32FailReads--;
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+    if ((ui32Address < PSRAM_BASE) || (ui32Address + ui32NumBytes > PSRAM_BASE + PSRAM_SIZE))
+    {
+        g_ui32BadAccesses++;
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+    memcpy(pui8Buffer, &g_pui8Psram[ui32Address], ui32NumBytes);
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+static uint32_t
+model_write(uint8_t *pui8Buffer, uint32_t ui32Address, uint32_t ui32NumBytes,
+            bool bWaitForCompletion)
+{
+    (void)bWaitForCompletion;
+
+    if (g_ui32FailWrites)
+    {
+        g_ui32FailWrites--;
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+    if ((ui32Address < PSRAM_BASE) || (ui32Address + ui32NumBytes > PSRAM_BASE + PSRAM_SIZE))
+    {
+        g_ui32BadAccesses++;
+        return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+    }
+    memcpy(&g_pui8Psram[ui32Address], pui8Buffer, ui32NumBytes);
+    return AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS;
+}
+
+//
+// The default transfer functions are never used here.
+//
+uint32_t
+am_devices_mspi_psram_read(uint8_t *pui8RxBuffer, uint32_t ui32ReadAddress,
+                           uint32_t ui32NumBytes, bool bWaitForCompletion)
+{
+    (void)pui8RxBuffer;
+    (void)ui32ReadAddress;
+    (void)ui32NumBytes;
+    (void)bWaitForCompletion;
+    g_ui32BadAccesses++;
+    return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+}
+
+uint32_t
+am_devices_mspi_psram_write(uint8_t *ui8TxBuffer, uint32_t ui32WriteAddress,
+                            uint32_t ui32NumBytes, bool bWaitForCompletion)
+{
+    (void)ui8TxBuffer;
+    (void)ui32WriteAddress;
+    (void)ui32NumBytes;
+    (void)bWaitForCompletion;
+    g_ui32BadAccesses++;
+    return AM_DEVICES_MSPI_PSRAM_STATUS_ERROR;
+}
+
+//*****************************************************************************
+//
+// Heap setup.
+//
+//*****************************************************************************
+static am_devices_mspi_psram_heap_block_t g_sBlocks[TEST_BLOCKS];
+static uint32_t g_pui32Cache[TEST_LINE / 4];
+
+static void
+heap_setup(am_devices_mspi_psram_heap_t *pHeap, bool bCache)
+{
+    am_devices_mspi_psram_heap_config_t sConfig =
+    {
+        .ui32Base = PSRAM_BASE,
+        .ui32Size = PSRAM_SIZE,
+        .pBlocks = g_sBlocks,
+        .ui32NumBlocks = TEST_BLOCKS,
+        .pui32Cache = bCache ? g_pui32Cache : NULL,
+        .ui32CacheSize = TEST_LINE,
+        .pfnRead = model_read,
+        .pfnWrite = model_write,
+    };
+
+    memset(g_pui8Psram, 0xEE, sizeof(g_pui8Psram));
+    g_ui32FailReads = 0;
+    g_ui32FailWrites = 0;
+    CHECK(am_devices_mspi_psram_heap_init(pHeap, &sConfig) ==
+          AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+}
+
+//*****************************************************************************
+//
+// Check every live block: in range, aligned, not crossing a page when asked,
+// not overlapping another block, and (after a flush) holding its data on
+// the device.
+//
+//*****************************************************************************
+static void
+check_blocks(am_devices_mspi_psram_heap_t *pHeap, bool bCheckDevice)
+{
+    static uint8_t pui8Owner[PSRAM_SIZE / 4];
+    uint32_t h;
+
+    memset(pui8Owner, 0, sizeof(pui8Owner));
+
+    for (h = 1; h <= TEST_BLOCKS; h++)
+    {
+        shadow_t *psShadow = &g_sShadow[h];
+        uint32_t ui32Address, ui32Size, w;
+
+        if (!psShadow->bLive)
+        {
+            continue;
+        }
+
+        CHECK(am_devices_mspi_psram_heap_address(pHeap, h, &ui32Address, &ui32Size) ==
+              AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+        CHECK(ui32Size >= psShadow->ui32Size);
+        CHECK(ui32Address >= PSRAM_BASE);
+        CHECK(ui32Address + ui32Size <= PSRAM_BASE + PSRAM_SIZE);
+        CHECK((ui32Address & (psShadow->ui32Align - 1)) == 0);
+        if (psShadow->bNoPageCross && (psShadow->ui32Size <= PSRAM_PAGE))
+        {
+            CHECK((ui32Address / PSRAM_PAGE) ==
+                  ((ui32Address + psShadow->ui32Size - 1) / PSRAM_PAGE));
+        }
+
+        for (w = (ui32Address - PSRAM_BASE) / 4;
+             w < (ui32Address + ui32Size - PSRAM_BASE) / 4; w++)
+        {
+            if (w < PSRAM_SIZE / 4)
+            {
+                CHECK(pui8Owner[w] == 0);
+                pui8Owner[w] = (uint8_t)h;
+            }
+        }
+
+        if (bCheckDevice)
+        {
+            CHECK(memcmp(&g_pui8Psram[ui32Address], psShadow->pui8Data,
+                         psShadow->ui32Size) == 0);
+        }
+    }
+}
+
+static uint32_t
+random_align(void)
+{
+    static const uint32_t pui32Align[] = { 0, 4, 16, 64, 256, 1024, 4096 };
+
+    return pui32Align[rand_next() % (sizeof(pui32Align) / sizeof(pui32Align[0]))];
+}
+
+//*****************************************************************************
+//
+// Random operations checked against the shadow.
+//
+// Returns the number of device transfers the heap issued.
+//
+//*****************************************************************************
+static uint32_t
+test_random(uint32_t ui32Ops, bool bCache)
+{
+    am_devices_mspi_psram_heap_t sHeap;
+    am_devices_mspi_psram_heap_stats_t sStats;
+    static uint8_t pui8Buf[TEST_MAX_ALLOC];
+    uint32_t ui32Allocs = 0, ui32AllocFails = 0, ui32Reads = 0, ui32Writes = 0;
+    uint32_t i, h;
+
+    heap_setup(&sHeap, bCache);
+    memset(g_sShadow, 0, sizeof(g_sShadow));
+
+    for (i = 0; i < ui32Ops; i++)
+    {
+        uint32_t ui32Op = rand_next() % 100;
+
+        h = 1 + rand_next() % TEST_BLOCKS;
+
+        if (ui32Op < 15)
+        {
+            //
+            // Allocate.
+            //
+            am_devices_mspi_psram_heap_handle_t hNew;
+            uint32_t ui32Size = 1 + rand_next() % ((rand_next() % 4) ? 256 : TEST_MAX_ALLOC);
+            uint32_t ui32Align = random_align();
+            bool bNoCross = (rand_next() % 3) == 0;
+
+            if (am_devices_mspi_psram_heap_alloc(&sHeap, ui32Size, ui32Align,
+                                                 bNoCross ? AM_DEVICES_MSPI_PSRAM_HEAP_NO_PAGE_CROSS : 0,
+                                                 &hNew) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS)
+            {
+                CHECK(hNew == AM_DEVICES_MSPI_PSRAM_HEAP_INVALID_HANDLE);
+                ui32AllocFails++;
+                continue;
+            }
+            CHECK((hNew >= 1) && (hNew <= TEST_BLOCKS) && !g_sShadow[hNew].bLive);
+
+            //
+            // Fill the new block so stale data would be noticed.
+            //
+            g_sShadow[hNew].bLive = true;
+            g_sShadow[hNew].ui32Size = ui32Size;
+            g_sShadow[hNew].ui32Align = ui32Align ? ui32Align : 4;
+            g_sShadow[hNew].bNoPageCross = bNoCross;
+            g_sShadow[hNew].pui8Data = malloc(ui32Size);
+            memset(g_sShadow[hNew].pui8Data, (int)hNew, ui32Size);
+            CHECK(am_devices_mspi_psram_heap_write(&sHeap, hNew, 0, g_sShadow[hNew].pui8Data,
+                                                   ui32Size) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+            ui32Allocs++;
+        }
+        else if (ui32Op < 27)
+        {
+            //
+            // Free.
+            //
+            if (!g_sShadow[h].bLive)
+            {
+                CHECK(am_devices_mspi_psram_heap_free(&sHeap, h) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+                continue;
+            }
+            CHECK(am_devices_mspi_psram_heap_free(&sHeap, h) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+            free(g_sShadow[h].pui8Data);
+            memset(&g_sShadow[h], 0, sizeof(g_sShadow[h]));
+        }
+        else if (g_sShadow[h].bLive)
+        {
+            //
+            // Read or write a random range, mostly shorter than a line.
+            //
+            shadow_t *psShadow = &g_sShadow[h];
+            uint32_t ui32Offset = rand_next() % psShadow->ui32Size;
+            uint32_t ui32Max = psShadow->ui32Size - ui32Offset;
+            uint32_t ui32Len = (rand_next() % 4) ? (1 + rand_next() % 16) : (1 + rand_next() % ui32Max);
+
+            if (ui32Len > ui32Max)
+            {
+                ui32Len = ui32Max;
+            }
+
+            if (ui32Op < 60)
+            {
+                uint32_t j;
+
+                for (j = 0; j < ui32Len; j++)
+                {
+                    pui8Buf[j] = (uint8_t)rand_next();
+                }
+                CHECK(am_devices_mspi_psram_heap_write(&sHeap, h, ui32Offset, pui8Buf, ui32Len) ==
+                      AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+                memcpy(psShadow->pui8Data + ui32Offset, pui8Buf, ui32Len);
+                ui32Writes++;
+            }
+            else
+            {
+                CHECK(am_devices_mspi_psram_heap_read(&sHeap, h, ui32Offset, pui8Buf, ui32Len) ==
+                      AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+                CHECK(memcmp(pui8Buf, psShadow->pui8Data + ui32Offset, ui32Len) == 0);
+                ui32Reads++;
+            }
+
+            //
+            // Nothing may be accessed past the end of the granted block,
+            // which can be a little larger than requested.
+            //
+            {
+                uint32_t ui32Address, ui32Granted;
+
+                am_devices_mspi_psram_heap_address(&sHeap, h, &ui32Address, &ui32Granted);
+                CHECK(am_devices_mspi_psram_heap_read(&sHeap, h, ui32Offset, pui8Buf,
+                                                      ui32Granted - ui32Offset + 1) !=
+                      AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+            }
+        }
+
+        if ((i % 1000) == 999)
+        {
+            CHECK(am_devices_mspi_psram_heap_flush(&sHeap) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+            check_blocks(&sHeap, true);
+        }
+        else if ((i % 100) == 0)
+        {
+            check_blocks(&sHeap, false);
+        }
+    }
+
+    CHECK(am_devices_mspi_psram_heap_flush(&sHeap) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    check_blocks(&sHeap, true);
+    am_devices_mspi_psram_heap_stats(&sHeap, &sStats);
+
+    printf("%s cache: %u allocs (%u failed), %u writes, %u reads, "
+           "%u device reads, %u device writes, %u hits, %u misses\n",
+           bCache ? "With" : "No", (unsigned)ui32Allocs, (unsigned)ui32AllocFails,
+           (unsigned)ui32Writes, (unsigned)ui32Reads,
+           (unsigned)sStats.ui32DeviceReads, (unsigned)sStats.ui32DeviceWrites,
+           (unsigned)sStats.ui32CacheHits, (unsigned)sStats.ui32CacheMisses);
+
+    //
+    // Freeing everything coalesces back to one region.
+    //
+    for (h = 1; h <= TEST_BLOCKS; h++)
+    {
+        if (g_sShadow[h].bLive)
+        {
+            CHECK(am_devices_mspi_psram_heap_free(&sHeap, h) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+            CHECK(am_devices_mspi_psram_heap_free(&sHeap, h) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+            free(g_sShadow[h].pui8Data);
+            memset(&g_sShadow[h], 0, sizeof(g_sShadow[h]));
+        }
+    }
+    am_devices_mspi_psram_heap_stats(&sHeap, &sStats);
+    CHECK(sStats.ui32NumAllocated == 0);
+    CHECK(sStats.ui32BytesFree == PSRAM_SIZE);
+    CHECK(sStats.ui32LargestFree == PSRAM_SIZE);
+    CHECK(g_ui32BadAccesses == 0);
+
+    return sStats.ui32DeviceReads + sStats.ui32DeviceWrites;
+}
+
+//*****************************************************************************
+//
+// Small sequential writes cost one write back per line and no line loads.
+//
+//*****************************************************************************
+static void
+test_cache_traffic(void)
+{
+    am_devices_mspi_psram_heap_t sHeap;
+    am_devices_mspi_psram_heap_stats_t sStats;
+    am_devices_mspi_psram_heap_handle_t hBlock;
+    uint32_t ui32Word, i;
+
+    heap_setup(&sHeap, true);
+    CHECK(am_devices_mspi_psram_heap_alloc(&sHeap, 4 * TEST_LINE, TEST_LINE, 0, &hBlock) ==
+          AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+
+    for (i = 0; i < TEST_LINE; i++)
+    {
+        ui32Word = i;
+        CHECK(am_devices_mspi_psram_heap_write(&sHeap, hBlock, i * 4, (uint8_t *)&ui32Word, 4) ==
+              AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    }
+    CHECK(am_devices_mspi_psram_heap_flush(&sHeap) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+
+    am_devices_mspi_psram_heap_stats(&sHeap, &sStats);
+    CHECK(sStats.ui32DeviceReads == 0);
+    CHECK(sStats.ui32DeviceWrites == 4);
+    CHECK(sStats.ui32CacheMisses == 4);
+    CHECK(sStats.ui32CacheHits == TEST_LINE - 4);
+
+    for (i = 0; i < TEST_LINE; i++)
+    {
+        uint32_t ui32Address;
+
+        am_devices_mspi_psram_heap_address(&sHeap, hBlock, &ui32Address, NULL);
+        memcpy(&ui32Word, &g_pui8Psram[ui32Address + i * 4], 4);
+        CHECK(ui32Word == i);
+    }
+}
+
+//*****************************************************************************
+//
+// Transfer errors reach the caller and lose no data.
+//
+//*****************************************************************************
+static void
+test_errors(void)
+{
+    am_devices_mspi_psram_heap_t sHeap;
+    am_devices_mspi_psram_heap_handle_t hA, hB;
+    uint8_t pui8Data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint8_t pui8Back[8];
+    uint32_t ui32Address;
+
+    heap_setup(&sHeap, true);
+    CHECK(am_devices_mspi_psram_heap_alloc(&sHeap, 8, 0, 0, &hA) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_alloc(&sHeap, 8, TEST_LINE * 2, 0, &hB) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+
+    //
+    // A failed line load is reported.
+    //
+    g_ui32FailReads = 1;
+    CHECK(am_devices_mspi_psram_heap_read(&sHeap, hA, 0, pui8Back, 8) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+
+    //
+    // A failed write back keeps the line dirty; the next flush lands it.
+    //
+    CHECK(am_devices_mspi_psram_heap_write(&sHeap, hA, 0, pui8Data, 8) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    g_ui32FailWrites = 1;
+    CHECK(am_devices_mspi_psram_heap_flush(&sHeap) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_read(&sHeap, hA, 0, pui8Back, 8) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(memcmp(pui8Back, pui8Data, 8) == 0);
+
+    //
+    // Evicting the line for another one fails the same way without losing it.
+    //
+    g_ui32FailWrites = 1;
+    CHECK(am_devices_mspi_psram_heap_read(&sHeap, hB, 0, pui8Back, 8) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_flush(&sHeap) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    am_devices_mspi_psram_heap_address(&sHeap, hA, &ui32Address, NULL);
+    CHECK(memcmp(&g_pui8Psram[ui32Address], pui8Data, 8) == 0);
+
+    //
+    // Bad handles and ranges.
+    //
+    CHECK(am_devices_mspi_psram_heap_read(&sHeap, AM_DEVICES_MSPI_PSRAM_HEAP_INVALID_HANDLE, 0, pui8Back, 1) !=
+          AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_read(&sHeap, TEST_BLOCKS + 1, 0, pui8Back, 1) !=
+          AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_write(&sHeap, hA, 9, pui8Data, 1) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_free(&sHeap, hA) == AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(am_devices_mspi_psram_heap_read(&sHeap, hA, 0, pui8Back, 1) != AM_DEVICES_MSPI_PSRAM_STATUS_SUCCESS);
+    CHECK(g_ui32BadAccesses == 0);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    uint32_t ui32Ops = 200000;
+    uint32_t ui32Cached, ui32Uncached;
+    uint64_t ui64Seed;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Ops = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n ops] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    //
+    // Run the same operations with and without the cache; the cache must
+    // save device transfers.
+    //
+    ui64Seed = g_ui64Rand;
+    ui32Cached = test_random(ui32Ops, true);
+    g_ui64Rand = ui64Seed;
+    ui32Uncached = test_random(ui32Ops, false);
+    CHECK(ui32Cached < ui32Uncached);
+    test_cache_traffic();
+    test_errors();
+
+    return host_test_result();
+}
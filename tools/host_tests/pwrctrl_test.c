@@ -0,0 +1,592 @@
+//*****************************************************************************
+//
+//! @file pwrctrl_test.c
+//!
+//! @brief Host test of the reference counted power manager.
+//!
+//! The PWRCTRL registers are mapped into host memory and the power switch is
+//! modelled in am_hal_flash_delay(), which the HAL calls while it waits: each
+//! domain status bit follows the enables of the peripherals in that domain,
+//! from a table taken from the datasheet rather than from the HAL.  Checks
+//! that every peripheral is accounted to its own domain, that a random
+//! acquire/release/service sequence keeps the registers, the reference counts
+//! and the on-time statistics consistent with a model, that a direct
+//! am_hal_pwrctrl_periph_disable() under a holder is undone by the next
+//! acquire, and that a failed power up or an extra release leaves the counts
+//! alone.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "am_mcu_apollo.h"
+#include "host_regs.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define NUM_PERIPH                  AM_HAL_PWRCTRL_PERIPH_MAX
+#define NUM_DOMAIN                  AM_HAL_PWRCTRL_DOMAIN_MAX
+#define DEFAULT_IDLE                50
+
+//*****************************************************************************
+//
+// Power switch model.  DEVPWREN bit and DEVPWRSTATUS bit of each peripheral,
+// per the Apollo3 datasheet.
+//
+//*****************************************************************************
+static const struct
+{
+    uint32_t ui32EnableBit;
+    uint32_t ui32StatusBit;
+    am_hal_pwrctrl_domain_e eDomain;
+}
+g_sModel[NUM_PERIPH] =
+{
+    { 0,  0, AM_HAL_PWRCTRL_DOMAIN_MAX },   // NONE
+    { 0,  2, AM_HAL_PWRCTRL_DOMAIN_HCPA },  // IOS
+    { 1,  3, AM_HAL_PWRCTRL_DOMAIN_HCPB },  // IOM0
+    { 2,  3, AM_HAL_PWRCTRL_DOMAIN_HCPB },  // IOM1
+    { 3,  3, AM_HAL_PWRCTRL_DOMAIN_HCPB },  // IOM2
+    { 4,  4, AM_HAL_PWRCTRL_DOMAIN_HCPC },  // IOM3
+    { 5,  4, AM_HAL_PWRCTRL_DOMAIN_HCPC },  // IOM4
+    { 6,  4, AM_HAL_PWRCTRL_DOMAIN_HCPC },  // IOM5
+    { 7,  2, AM_HAL_PWRCTRL_DOMAIN_HCPA },  // UART0
+    { 8,  2, AM_HAL_PWRCTRL_DOMAIN_HCPA },  // UART1
+    { 9,  5, AM_HAL_PWRCTRL_DOMAIN_ADC },   // ADC
+    { 10, 2, AM_HAL_PWRCTRL_DOMAIN_HCPA },  // SCARD
+    { 11, 6, AM_HAL_PWRCTRL_DOMAIN_MSPI },  // MSPI
+    { 12, 7, AM_HAL_PWRCTRL_DOMAIN_PDM },   // PDM
+    { 13, 8, AM_HAL_PWRCTRL_DOMAIN_BLEL },  // BLEL
+};
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+//
+// When set the switch ignores DEVPWREN, so power ups and downs time out.
+//
+static bool g_bSwitchStuck;
+
+static uint32_t g_ui32Now;
+static uint32_t g_ui32Traces;
+
+//
+// What the test expects of each peripheral.
+//
+static struct
+{
+    uint32_t ui32RefCount;
+    uint32_t ui32IdleTicks;
+    bool     bPowered;
+    bool     bOffPending;
+    uint32_t ui32OffTime;
+    uint32_t ui32PowerOns;
+    uint64_t ui64OnTicks;
+}
+g_sExpect[NUM_PERIPH];
+
+static uint64_t g_ui64DomainOnTicks[NUM_DOMAIN];
+static uint32_t g_ui32DomainPowerOns[NUM_DOMAIN];
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// HAL entry points the power control module links against.
+//
+//*****************************************************************************
+uint32_t gAmHalResetStatus;
+
+uint32_t am_hal_flash_delay_status_check(uint32_t ui32usMaxDelay, uint32_t ui32Address, uint32_t ui32Mask, uint32_t ui32Value, bool bWaitForEqual)
+{
+    (void)ui32usMaxDelay; (void)ui32Address; (void)ui32Mask; (void)ui32Value; (void)bWaitForEqual;
+    return AM_HAL_STATUS_SUCCESS;
+}
+uint32_t am_hal_cachectrl_control(am_hal_cachectrl_control_e eControl, void *pArgs)
+{
+    (void)eControl; (void)pArgs;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+void
+am_hal_flash_delay(uint32_t ui32Iterations)
+{
+    uint32_t ui32Status = 0;
+
+    (void)ui32Iterations;
+
+    if (g_bSwitchStuck)
+    {
+        return;
+    }
+
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        if (PWRCTRL->DEVPWREN & (1u << g_sModel[i].ui32EnableBit))
+        {
+            ui32Status |= 1u << g_sModel[i].ui32StatusBit;
+        }
+    }
+    PWRCTRL->DEVPWRSTATUS = ui32Status;
+}
+
+static uint32_t
+time_get(void)
+{
+    return g_ui32Now;
+}
+
+static void
+trace(am_hal_pwrctrl_periph_e ePeripheral, bool bPowered, uint32_t ui32Time)
+{
+    CHECK(ePeripheral > AM_HAL_PWRCTRL_PERIPH_NONE && ePeripheral < NUM_PERIPH);
+    CHECK(ui32Time == g_ui32Now);
+    CHECK(bPowered != g_sExpect[ePeripheral].bPowered);
+    g_ui32Traces++;
+}
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+static bool
+periph_enabled(uint32_t ui32Periph)
+{
+    return (PWRCTRL->DEVPWREN & (1u << g_sModel[ui32Periph].ui32EnableBit)) != 0;
+}
+
+static void
+expect_on(uint32_t ui32Periph)
+{
+    am_hal_pwrctrl_domain_e eDomain = g_sModel[ui32Periph].eDomain;
+    bool bDomainOn = false;
+
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        bDomainOn |= (g_sModel[i].eDomain == eDomain) && g_sExpect[i].bPowered;
+    }
+    if (!bDomainOn)
+    {
+        g_ui32DomainPowerOns[eDomain]++;
+    }
+
+    g_sExpect[ui32Periph].bPowered = true;
+    g_sExpect[ui32Periph].ui32PowerOns++;
+}
+
+//
+// Advance the time base, accruing on-time to whatever is powered.
+//
+static void
+time_advance(uint32_t ui32Ticks)
+{
+    bool bDomainOn[NUM_DOMAIN] = { false };
+
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        if (g_sExpect[i].bPowered)
+        {
+            g_sExpect[i].ui64OnTicks += ui32Ticks;
+            bDomainOn[g_sModel[i].eDomain] = true;
+        }
+    }
+    for (uint32_t d = 0; d < NUM_DOMAIN; d++)
+    {
+        if (bDomainOn[d])
+        {
+            g_ui64DomainOnTicks[d] += ui32Ticks;
+        }
+    }
+
+    g_ui32Now += ui32Ticks;
+}
+
+//
+// Compare the registers and statistics against the model.
+//
+static void
+check_state(void)
+{
+    uint32_t ui32Held[NUM_DOMAIN] = { 0 };
+    am_hal_pwrctrl_stats_t sStats;
+
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        CHECK(am_hal_pwrctrl_periph_stats_get(i, &sStats) == AM_HAL_STATUS_SUCCESS);
+        CHECK(sStats.ui32RefCount == g_sExpect[i].ui32RefCount);
+        CHECK(sStats.bPowered == g_sExpect[i].bPowered);
+        CHECK(sStats.ui32PowerOns == g_sExpect[i].ui32PowerOns);
+        CHECK(sStats.ui64OnTicks == g_sExpect[i].ui64OnTicks);
+        CHECK(periph_enabled(i) == g_sExpect[i].bPowered);
+
+        if (g_sExpect[i].bPowered)
+        {
+            ui32Held[g_sModel[i].eDomain]++;
+        }
+    }
+
+    for (uint32_t d = 0; d < NUM_DOMAIN; d++)
+    {
+        bool bStatus = false;
+
+        for (uint32_t i = 1; i < NUM_PERIPH; i++)
+        {
+            if (g_sModel[i].eDomain == d)
+            {
+                bStatus = (PWRCTRL->DEVPWRSTATUS & (1u << g_sModel[i].ui32StatusBit)) != 0;
+                break;
+            }
+        }
+
+        CHECK(am_hal_pwrctrl_domain_stats_get(d, &sStats) == AM_HAL_STATUS_SUCCESS);
+        CHECK(sStats.ui32RefCount == ui32Held[d]);
+        CHECK(sStats.bPowered == bStatus);
+        CHECK(sStats.ui32PowerOns == g_ui32DomainPowerOns[d]);
+        CHECK(sStats.ui64OnTicks == g_ui64DomainOnTicks[d]);
+    }
+}
+
+static void
+do_acquire(uint32_t ui32Periph)
+{
+    CHECK(am_hal_pwrctrl_periph_acquire(ui32Periph) == AM_HAL_STATUS_SUCCESS);
+
+    g_sExpect[ui32Periph].ui32RefCount++;
+    g_sExpect[ui32Periph].bOffPending = false;
+    if (!g_sExpect[ui32Periph].bPowered)
+    {
+        expect_on(ui32Periph);
+    }
+}
+
+static void
+do_release(uint32_t ui32Periph)
+{
+    CHECK(am_hal_pwrctrl_periph_release(ui32Periph) == AM_HAL_STATUS_SUCCESS);
+
+    if (--g_sExpect[ui32Periph].ui32RefCount == 0)
+    {
+        if (g_sExpect[ui32Periph].ui32IdleTicks == 0)
+        {
+            g_sExpect[ui32Periph].bPowered = false;
+        }
+        else
+        {
+            g_sExpect[ui32Periph].bOffPending = true;
+            g_sExpect[ui32Periph].ui32OffTime =
+                g_ui32Now + g_sExpect[ui32Periph].ui32IdleTicks;
+        }
+    }
+}
+
+static void
+do_service(void)
+{
+    uint32_t ui32Next = 0xFFFFFFFF;
+    uint32_t ui32Reported;
+
+    CHECK(am_hal_pwrctrl_auto_service(&ui32Reported) == AM_HAL_STATUS_SUCCESS);
+
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        int32_t i32Remaining;
+
+        if (!g_sExpect[i].bOffPending)
+        {
+            continue;
+        }
+
+        i32Remaining = (int32_t)(g_sExpect[i].ui32OffTime - g_ui32Now);
+        if (i32Remaining > 0)
+        {
+            if ((uint32_t)i32Remaining < ui32Next)
+            {
+                ui32Next = i32Remaining;
+            }
+        }
+        else
+        {
+            g_sExpect[i].bOffPending = false;
+            g_sExpect[i].bPowered = false;
+        }
+    }
+
+    CHECK(ui32Reported == ui32Next);
+}
+
+//
+// Release everything and let it expire.
+//
+static void
+drain(void)
+{
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        while (g_sExpect[i].ui32RefCount)
+        {
+            do_release(i);
+        }
+    }
+    time_advance(0x10000);
+    do_service();
+    check_state();
+}
+
+//*****************************************************************************
+//
+// Each peripheral powers the domain its status bit belongs to, and is
+// counted there.
+//
+//*****************************************************************************
+static void
+test_domains(void)
+{
+    am_hal_pwrctrl_stats_t sStats;
+
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        do_acquire(i);
+        CHECK(PWRCTRL->DEVPWRSTATUS == (1u << g_sModel[i].ui32StatusBit));
+
+        for (uint32_t d = 0; d < NUM_DOMAIN; d++)
+        {
+            CHECK(am_hal_pwrctrl_domain_stats_get(d, &sStats) == AM_HAL_STATUS_SUCCESS);
+            CHECK(sStats.ui32RefCount == (d == g_sModel[i].eDomain ? 1u : 0u));
+        }
+
+        time_advance(1 + i);
+        check_state();
+
+        g_sExpect[i].ui32IdleTicks = 0;
+        CHECK(am_hal_pwrctrl_periph_idle_set(i, 0) == AM_HAL_STATUS_SUCCESS);
+        do_release(i);
+        CHECK(PWRCTRL->DEVPWRSTATUS == 0);
+        check_state();
+
+        g_sExpect[i].ui32IdleTicks = DEFAULT_IDLE;
+        CHECK(am_hal_pwrctrl_periph_idle_set(i, DEFAULT_IDLE) == AM_HAL_STATUS_SUCCESS);
+    }
+}
+
+//*****************************************************************************
+//
+// A direct disable under a holder is undone by the next acquire.  The
+// statistics do not see the gap.
+//
+//*****************************************************************************
+static void
+test_direct_disable(void)
+{
+    uint32_t ui32Periph = AM_HAL_PWRCTRL_PERIPH_IOM2;
+    uint32_t ui32Traces;
+
+    do_acquire(ui32Periph);
+    do_acquire(AM_HAL_PWRCTRL_PERIPH_IOM1);
+    check_state();
+
+    CHECK(am_hal_pwrctrl_periph_disable(ui32Periph) == AM_HAL_STATUS_SUCCESS);
+    CHECK(!periph_enabled(ui32Periph));
+
+    ui32Traces = g_ui32Traces;
+    time_advance(10);
+    do_acquire(ui32Periph);
+    CHECK(g_ui32Traces == ui32Traces);
+    check_state();
+
+    do_release(ui32Periph);
+    do_release(ui32Periph);
+    do_release(AM_HAL_PWRCTRL_PERIPH_IOM1);
+    drain();
+}
+
+//*****************************************************************************
+//
+// A failed power up takes no reference, and an extra release is refused.
+//
+//*****************************************************************************
+static void
+test_errors(void)
+{
+    uint32_t ui32Periph = AM_HAL_PWRCTRL_PERIPH_PDM;
+    am_hal_pwrctrl_stats_t sStats;
+
+    CHECK(am_hal_pwrctrl_periph_release(ui32Periph) == AM_HAL_STATUS_INVALID_OPERATION);
+    CHECK(am_hal_pwrctrl_periph_acquire(AM_HAL_PWRCTRL_PERIPH_NONE) == AM_HAL_STATUS_INVALID_ARG);
+    CHECK(am_hal_pwrctrl_periph_acquire(AM_HAL_PWRCTRL_PERIPH_MAX) == AM_HAL_STATUS_INVALID_ARG);
+    CHECK(am_hal_pwrctrl_domain_stats_get(AM_HAL_PWRCTRL_DOMAIN_MAX, &sStats) == AM_HAL_STATUS_INVALID_ARG);
+    check_state();
+
+    g_bSwitchStuck = true;
+    CHECK(am_hal_pwrctrl_periph_acquire(ui32Periph) == AM_HAL_STATUS_FAIL);
+    g_bSwitchStuck = false;
+    PWRCTRL->DEVPWREN &= ~(1u << g_sModel[ui32Periph].ui32EnableBit);
+    check_state();
+
+    do_acquire(ui32Periph);
+    do_release(ui32Periph);
+    CHECK(am_hal_pwrctrl_periph_release(ui32Periph) == AM_HAL_STATUS_INVALID_OPERATION);
+    drain();
+}
+
+//*****************************************************************************
+//
+// Random acquire, release, service and time steps.
+//
+//*****************************************************************************
+static void
+test_random(uint32_t ui32Events)
+{
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        g_sExpect[i].ui32IdleTicks = rand_next() % 100;
+        CHECK(am_hal_pwrctrl_periph_idle_set(i, g_sExpect[i].ui32IdleTicks) == AM_HAL_STATUS_SUCCESS);
+    }
+
+    for (uint32_t n = 0; n < ui32Events; n++)
+    {
+        uint32_t ui32Periph = 1 + rand_next() % (NUM_PERIPH - 1);
+        uint32_t ui32Roll = rand_next() % 100;
+
+        if (ui32Roll < 35)
+        {
+            if (g_sExpect[ui32Periph].ui32RefCount < 3)
+            {
+                do_acquire(ui32Periph);
+            }
+        }
+        else if (ui32Roll < 70)
+        {
+            if (g_sExpect[ui32Periph].ui32RefCount)
+            {
+                do_release(ui32Periph);
+            }
+        }
+        else if (ui32Roll < 85)
+        {
+            do_service();
+        }
+        else
+        {
+            time_advance(rand_next() % 40);
+        }
+
+        if ((n & 63) == 0)
+        {
+            check_state();
+        }
+    }
+
+    drain();
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    am_hal_pwrctrl_auto_config_t sConfig =
+    {
+        .pfnTimeGet = time_get,
+        .ui32IdleTicks = DEFAULT_IDLE,
+        .pfnTrace = trace,
+    };
+    uint32_t ui32Events = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                ui32Events = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n events] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    host_regs_map(PWRCTRL_BASE, sizeof(PWRCTRL_Type));
+
+    //
+    // Start near the wrap of the time base.
+    //
+    g_ui32Now = 0xFFFFF000;
+    CHECK(am_hal_pwrctrl_auto_config(&sConfig) == AM_HAL_STATUS_SUCCESS);
+    for (uint32_t i = 1; i < NUM_PERIPH; i++)
+    {
+        g_sExpect[i].ui32IdleTicks = DEFAULT_IDLE;
+    }
+
+    test_domains();
+    test_direct_disable();
+    test_errors();
+    test_random(ui32Events);
+    test_random(ui32Events);
+
+    return host_test_result();
+}
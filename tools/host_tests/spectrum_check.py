@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+# Check pdm_fft spectra against NumPy.
+#
+# Reads the text pdm_fft prints with PRINT_PDM_DATA and PRINT_FFT_DATA set
+# (or the file spectrum_test -o writes in the same format), recomputes every
+# window with a float64 periodic Hann window and numpy.fft.rfft, and checks
+# the power spectrum, the loudest bin and the band energies.
+#
+# The device computes in float32 with a different FFT ordering, so the
+# powers cannot match to the bit.  Bin and band indices are integers and must
+# match exactly; powers must agree to within --tol of the window's peak.
+
+import argparse
+import re
+import sys
+
+import numpy as np
+
+BAND_RE = re.compile(r'Band (\d+)-(\d+) Hz:\s*(\S+)')
+PEAK_RE = re.compile(r'Loudest frequency bin:\s*(\d+)')
+RATE_RE = re.compile(r'Effective Sample Freq\.:\s*(\d+)')
+SIZE_RE = re.compile(r'FFT Length:\s*(\d+)')
+
+#******************************************************************************
+#
+# Split the log into PCM frames and spectra.
+#
+#******************************************************************************
+def parse(lines):
+
+    rate = None
+    size = None
+    pcm = []
+    spectra = []
+    block = []
+
+    for line in lines:
+        line = line.strip()
+        if not line:
+            continue
+
+        m = RATE_RE.search(line)
+        if m:
+            rate = int(m.group(1))
+            continue
+
+        m = SIZE_RE.search(line)
+        if m:
+            size = int(m.group(1))
+            continue
+
+        m = PEAK_RE.search(line)
+        if m:
+            # The block just closed was a spectrum, not PCM.
+            spectra.append({'power': np.array(pcm.pop(), dtype=np.float64),
+                            'peak': int(m.group(1)), 'bands': []})
+            continue
+
+        m = BAND_RE.search(line)
+        if m and spectra:
+            spectra[-1]['bands'].append((int(m.group(1)), int(m.group(2)),
+                                         float(m.group(3))))
+            continue
+
+        if line == 'END':
+            pcm.append(block)
+            block = []
+            continue
+
+        try:
+            block.append(float(line))
+        except ValueError:
+            pass
+
+    samples = np.array([s for frame in pcm for s in frame], dtype=np.float64)
+
+    return rate, size, samples, spectra
+
+#******************************************************************************
+#
+# First bin at or above a frequency, as spectrum.c computes band edges.
+#
+#******************************************************************************
+def band_bin(hz, n, rate):
+    return (hz * n + rate - 1) // rate
+
+#******************************************************************************
+#
+# Main function
+#
+#******************************************************************************
+def main():
+
+    with open(args.input) as f:
+        rate, size, samples, spectra = parse(f)
+
+    rate = args.rate or rate
+    n = args.size or size
+    if not rate or not n:
+        sys.exit('Sample rate and FFT size not found; use --rate and --size')
+
+    window = 0.5 - 0.5 * np.cos(2.0 * np.pi * np.arange(n) / n)
+    failures = 0
+    checked = 0
+    worst = 0.0
+
+    for k, spec in enumerate(spectra):
+        start = k * n // 2
+        if start + n > len(samples):
+            print('Window {}: no PCM captured for it, skipped'.format(k))
+            continue
+
+        ref = np.abs(np.fft.rfft(samples[start:start + n] * window)) ** 2
+        peak = ref[1:].max()
+        checked += 1
+
+        if len(spec['power']) != len(ref):
+            print('Window {}: {} bins, expected {}'.format(k, len(spec['power']), len(ref)))
+            failures += 1
+            continue
+
+        error = np.abs(spec['power'] - ref).max() / peak
+        worst = max(worst, error)
+        if error > args.tol:
+            print('Window {}: power error {:.3g} of peak'.format(k, error))
+            failures += 1
+
+        if ref[spec['peak']] < peak * (1.0 - args.tol):
+            print('Window {}: loudest bin {}, NumPy has {}'.format(
+                k, spec['peak'], 1 + int(np.argmax(ref[1:]))))
+            failures += 1
+
+        for lo, hi, energy in spec['bands']:
+            ref_energy = ref[band_bin(lo, n, rate):band_bin(hi, n, rate)].sum()
+            if abs(energy - ref_energy) > peak * args.tol * 16:
+                print('Window {}: band {}-{} Hz energy {:.9g}, NumPy has {:.9g}'.format(
+                    k, lo, hi, energy, ref_energy))
+                failures += 1
+
+    if checked == 0:
+        sys.exit('No windows to check')
+
+    print('Checked {} windows, worst power error {:.3g} of peak'.format(checked, worst))
+    print('{}: {} failure(s)'.format('FAIL' if failures else 'PASS', failures))
+
+    sys.exit(1 if failures else 0)
+
+#******************************************************************************
+#
+# Main program flow
+#
+#******************************************************************************
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(
+        description='Check pdm_fft spectra against NumPy.')
+
+    parser.add_argument('input',
+                        help='pdm_fft console log or spectrum_test -o output')
+    parser.add_argument('--rate', type=int,
+                        help='Sample rate, if the log does not print it')
+    parser.add_argument('--size', type=int,
+                        help='FFT size, if the log does not print it')
+    parser.add_argument('--tol', type=float, default=1e-5,
+                        help='Allowed power error relative to the peak (default 1e-5)')
+
+    args = parser.parse_args()
+
+    main()
@@ -0,0 +1,532 @@
+//*****************************************************************************
+//
+//! @file spectrum_test.c
+//!
+//! @brief Host test of the pdm_fft spectrum analyzer.
+//!
+//!
+//! Builds boards/apollo3_evb/examples/pdm_fft/src/spectrum.c with the few
+//! CMSIS-DSP routines it uses implemented here (same output packing as
+//! arm_rfft_fast_f32) and checks every analysis window against a float64
+//! DFT of the same Hann-windowed samples.
+//!
+//! With -o <file> the windows are also written in the format pdm_fft prints
+//! with PRINT_PDM_DATA and PRINT_FFT_DATA, for spectrum_check.py to verify
+//! against NumPy.
+//!
+//! Usage: spectrum_test [-o file] [-s seed]
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "spectrum.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define FFT_SIZE                    4096
+#define SAMPLE_RATE                 46875
+#define NUM_WINDOWS                 24
+#define NUM_SAMPLES                 (FFT_SIZE + (NUM_WINDOWS - 1) * FFT_SIZE / 2)
+
+//
+// Error allowed in any power bin, relative to the window's peak power.
+//
+#define POWER_TOLERANCE             1e-5
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+//
+// The bands pdm_fft uses.
+//
+static const spectrum_band_t g_sBands[] =
+{
+    {    0,   500 },
+    {  500,  2000 },
+    { 2000,  8000 },
+    { 8000, 23437 },
+};
+
+#define NUM_BANDS   (sizeof(g_sBands) / sizeof(g_sBands[0]))
+
+static spectrum_t g_sSpectrum;
+static float g_fWork[SPECTRUM_WORK_FLOATS(FFT_SIZE)];
+static int16_t g_i16History[SPECTRUM_HISTORY_SAMPLES(FFT_SIZE)];
+static float g_fBandEnergy[NUM_BANDS];
+
+static int16_t g_i16Samples[NUM_SAMPLES];
+static uint32_t g_ui32Windows;
+static uint32_t g_ui32LastPeakBin;
+static double g_dWorstError;
+static FILE *g_pDump;
+
+static uint64_t g_ui64Rand = 0x9e3779b97f4a7c15ull;
+
+static uint32_t
+rand_next(void)
+{
+    g_ui64Rand ^= g_ui64Rand >> 12;
+    g_ui64Rand ^= g_ui64Rand << 25;
+    g_ui64Rand ^= g_ui64Rand >> 27;
+    return (uint32_t)((g_ui64Rand * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+//*****************************************************************************
+//
+// In-place radix-2 complex FFT, X[k] = sum x[n] exp(-2 pi i k n / N).
+//
+//*****************************************************************************
+static void
+fft_f64(double *pdRe, double *pdIm, uint32_t ui32N)
+{
+    uint32_t i, j, k, ui32Len;
+
+    for (i = 1, j = 0; i < ui32N; i++)
+    {
+        uint32_t ui32Bit = ui32N >> 1;
+
+        for (; j & ui32Bit; ui32Bit >>= 1)
+        {
+            j ^= ui32Bit;
+        }
+        j |= ui32Bit;
+
+        if (i < j)
+        {
+            double t;
+            t = pdRe[i]; pdRe[i] = pdRe[j]; pdRe[j] = t;
+            t = pdIm[i]; pdIm[i] = pdIm[j]; pdIm[j] = t;
+        }
+    }
+
+    for (ui32Len = 2; ui32Len <= ui32N; ui32Len <<= 1)
+    {
+        double dAngle = -2.0 * M_PI / ui32Len;
+
+        for (i = 0; i < ui32N; i += ui32Len)
+        {
+            for (k = 0; k < ui32Len / 2; k++)
+            {
+                double dWr = cos(dAngle * k), dWi = sin(dAngle * k);
+                double *pRe = &pdRe[i + k], *pIm = &pdIm[i + k];
+                double dTr = pRe[ui32Len / 2] * dWr - pIm[ui32Len / 2] * dWi;
+                double dTi = pRe[ui32Len / 2] * dWi + pIm[ui32Len / 2] * dWr;
+
+                pRe[ui32Len / 2] = *pRe - dTr;
+                pIm[ui32Len / 2] = *pIm - dTi;
+                *pRe += dTr;
+                *pIm += dTi;
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// The CMSIS-DSP routines spectrum.c calls.
+//
+//*****************************************************************************
+arm_status
+arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen)
+{
+    if ((fftLen < 32) || (fftLen > 4096) || (fftLen & (fftLen - 1)))
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    memset(S, 0, sizeof(*S));
+    S->fftLenRFFT = fftLen;
+    return ARM_MATH_SUCCESS;
+}
+
+//
+// Output is packed as {X[0], X[N/2], Re X[1], Im X[1], ...}.
+//
+void
+arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut,
+                  uint8_t ifftFlag)
+{
+    static double dRe[4096], dIm[4096];
+    uint32_t ui32N = S->fftLenRFFT;
+
+    (void)ifftFlag;
+
+    for (uint32_t i = 0; i < ui32N; i++)
+    {
+        dRe[i] = p[i];
+        dIm[i] = 0.0;
+    }
+
+    fft_f64(dRe, dIm, ui32N);
+
+    pOut[0] = (float) dRe[0];
+    pOut[1] = (float) dRe[ui32N / 2];
+    for (uint32_t k = 1; k < ui32N / 2; k++)
+    {
+        pOut[2 * k] = (float) dRe[k];
+        pOut[2 * k + 1] = (float) dIm[k];
+    }
+}
+
+void
+arm_cmplx_mag_squared_f32(float32_t *pSrc, float32_t *pDst, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        pDst[i] = pSrc[2 * i] * pSrc[2 * i] + pSrc[2 * i + 1] * pSrc[2 * i + 1];
+    }
+}
+
+void
+arm_max_f32(float32_t *pSrc, uint32_t blockSize, float32_t *pResult, uint32_t *pIndex)
+{
+    *pResult = pSrc[0];
+    *pIndex = 0;
+
+    for (uint32_t i = 1; i < blockSize; i++)
+    {
+        if (pSrc[i] > *pResult)
+        {
+            *pResult = pSrc[i];
+            *pIndex = i;
+        }
+    }
+}
+
+float32_t
+arm_cos_f32(float32_t x)
+{
+    return cosf(x);
+}
+
+//*****************************************************************************
+//
+// First bin at or above a frequency, as spectrum.c computes band edges.
+//
+//*****************************************************************************
+static uint32_t
+band_bin(uint32_t ui32Hz)
+{
+    return (uint32_t)(((uint64_t) ui32Hz * FFT_SIZE + SAMPLE_RATE - 1) / SAMPLE_RATE);
+}
+
+//*****************************************************************************
+//
+// Compare one analysis window against the float64 reference.
+//
+//*****************************************************************************
+static void
+window_check(const spectrum_result_t *psResult, void *pvContext)
+{
+    static double dRe[FFT_SIZE], dIm[FFT_SIZE], dPower[FFT_SIZE / 2 + 1];
+    const int16_t *pi16Window = &g_i16Samples[g_ui32Windows * FFT_SIZE / 2];
+    double dPeak = 0.0, dWorst = 0.0;
+    uint32_t ui32Bins = SPECTRUM_NUM_BINS(FFT_SIZE);
+
+    (void)pvContext;
+
+    for (uint32_t i = 0; i < FFT_SIZE; i++)
+    {
+        dRe[i] = pi16Window[i] * (0.5 - 0.5 * cos(2.0 * M_PI * i / FFT_SIZE));
+        dIm[i] = 0.0;
+    }
+    fft_f64(dRe, dIm, FFT_SIZE);
+
+    for (uint32_t k = 0; k < ui32Bins; k++)
+    {
+        dPower[k] = dRe[k] * dRe[k] + dIm[k] * dIm[k];
+        if ((k > 0) && (dPower[k] > dPeak))
+        {
+            dPeak = dPower[k];
+        }
+    }
+
+    for (uint32_t k = 0; k < ui32Bins; k++)
+    {
+        double dError = fabs(psResult->pfPower[k] - dPower[k]) / dPeak;
+
+        if (dError > dWorst)
+        {
+            dWorst = dError;
+        }
+    }
+    CHECK(dWorst <= POWER_TOLERANCE);
+    if (dWorst > g_dWorstError)
+    {
+        g_dWorstError = dWorst;
+    }
+
+    //
+    // The reported peak must be a peak of the reference, and its frequency
+    // the bin's frequency.
+    //
+    CHECK(psResult->ui32PeakBin >= 1 && psResult->ui32PeakBin < ui32Bins);
+    CHECK(dPower[psResult->ui32PeakBin] >= dPeak * (1.0 - POWER_TOLERANCE));
+    CHECK(psResult->ui32PeakHz == (uint32_t)((uint64_t) psResult->ui32PeakBin * SAMPLE_RATE / FFT_SIZE));
+
+    for (uint32_t b = 0; b < NUM_BANDS; b++)
+    {
+        double dEnergy = 0.0;
+
+        for (uint32_t k = band_bin(g_sBands[b].ui32LowHz); k < band_bin(g_sBands[b].ui32HighHz) && k < ui32Bins; k++)
+        {
+            dEnergy += dPower[k];
+        }
+
+        CHECK(fabs(psResult->pfBandEnergy[b] - dEnergy) <= dPeak * POWER_TOLERANCE * 16);
+    }
+
+    if (g_pDump)
+    {
+        for (uint32_t k = 0; k < ui32Bins; k++)
+        {
+            fprintf(g_pDump, "%.9g\n", psResult->pfPower[k]);
+        }
+        fprintf(g_pDump, "END\n");
+        fprintf(g_pDump, "Loudest frequency bin: %u\n", (unsigned)psResult->ui32PeakBin);
+        for (uint32_t b = 0; b < NUM_BANDS; b++)
+        {
+            fprintf(g_pDump, "Band %u-%u Hz: %.9g\n", (unsigned)g_sBands[b].ui32LowHz,
+                    (unsigned)g_sBands[b].ui32HighHz, psResult->pfBandEnergy[b]);
+        }
+    }
+
+    g_ui32LastPeakBin = psResult->ui32PeakBin;
+    g_ui32Windows++;
+}
+
+//*****************************************************************************
+//
+// Configuration checks.
+//
+//*****************************************************************************
+static spectrum_config_t
+config_default(void)
+{
+    spectrum_config_t sConfig =
+    {
+        .ui32FFTSize = FFT_SIZE,
+        .ui32SampleRate = SAMPLE_RATE,
+        .psBands = g_sBands,
+        .ui32NumBands = NUM_BANDS,
+        .pfBandEnergy = g_fBandEnergy,
+        .pfWork = g_fWork,
+        .pi16History = g_i16History,
+        .pfnCallback = window_check,
+        .pvContext = NULL,
+    };
+
+    return sConfig;
+}
+
+static void
+test_config(void)
+{
+    static const spectrum_band_t sPastNyquist[] = { { 8000, 24000 } };
+    static const spectrum_band_t sEmpty[] = { { 500, 500 } };
+    spectrum_config_t sConfig;
+
+    sConfig = config_default();
+    CHECK(spectrum_init(&g_sSpectrum, &sConfig));
+
+    sConfig.psBands = sPastNyquist;
+    sConfig.ui32NumBands = 1;
+    CHECK(!spectrum_init(&g_sSpectrum, &sConfig));
+
+    sConfig.psBands = sEmpty;
+    CHECK(!spectrum_init(&g_sSpectrum, &sConfig));
+
+    sConfig = config_default();
+    sConfig.ui32FFTSize = 1000;
+    CHECK(!spectrum_init(&g_sSpectrum, &sConfig));
+}
+
+//*****************************************************************************
+//
+// Tones on and between bins plus noise, fed in random chunk sizes.
+//
+//*****************************************************************************
+static void
+test_signal(void)
+{
+    spectrum_config_t sConfig = config_default();
+    uint32_t ui32Fed = 0, ui32Windows = 0;
+
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+    {
+        //
+        // The tone sweeps across bins so some windows land between them.
+        //
+        double dHz = 440.0 + 9000.0 * i / NUM_SAMPLES;
+        double dNoise = (double)(int32_t)(rand_next() % 2001 - 1000);
+
+        g_i16Samples[i] = (int16_t) lrint(12000.0 * sin(2.0 * M_PI * dHz * i / SAMPLE_RATE) +
+                                          3000.0 * sin(2.0 * M_PI * 15000.0 * i / SAMPLE_RATE) +
+                                          dNoise);
+    }
+
+    CHECK(spectrum_init(&g_sSpectrum, &sConfig));
+    g_ui32Windows = 0;
+
+    if (g_pDump)
+    {
+        //
+        // pdm_fft prints the sample rate and then each frame as it is fed.
+        //
+        fprintf(g_pDump, "Effective Sample Freq.: %12d\n", SAMPLE_RATE);
+        fprintf(g_pDump, "FFT Length:             %12d\n\n", FFT_SIZE);
+    }
+
+    while (ui32Fed < NUM_SAMPLES)
+    {
+        uint32_t ui32Chunk = 1 + rand_next() % (FFT_SIZE + FFT_SIZE / 2);
+
+        if (ui32Chunk > NUM_SAMPLES - ui32Fed)
+        {
+            ui32Chunk = NUM_SAMPLES - ui32Fed;
+        }
+
+        if (g_pDump)
+        {
+            for (uint32_t i = 0; i < ui32Chunk; i++)
+            {
+                fprintf(g_pDump, "%d\n", g_i16Samples[ui32Fed + i]);
+            }
+            fprintf(g_pDump, "END\n");
+        }
+
+        ui32Windows += spectrum_feed(&g_sSpectrum, &g_i16Samples[ui32Fed], ui32Chunk);
+        ui32Fed += ui32Chunk;
+    }
+
+    CHECK(ui32Windows == NUM_WINDOWS);
+    CHECK(g_ui32Windows == NUM_WINDOWS);
+}
+
+//*****************************************************************************
+//
+// A tone centred on a bin is reported in exactly that bin.
+//
+//*****************************************************************************
+static void
+test_bin_tone(void)
+{
+    spectrum_config_t sConfig = config_default();
+    uint32_t ui32Bin = 300;
+    FILE *pDump = g_pDump;
+
+    //
+    // Only the streamed signal goes in the dump.
+    //
+    g_pDump = NULL;
+
+    for (uint32_t i = 0; i < FFT_SIZE; i++)
+    {
+        g_i16Samples[i] = (int16_t) lrint(20000.0 * cos(2.0 * M_PI * ui32Bin * i / FFT_SIZE));
+    }
+
+    CHECK(spectrum_init(&g_sSpectrum, &sConfig));
+    g_ui32Windows = 0;
+    CHECK(spectrum_feed(&g_sSpectrum, g_i16Samples, FFT_SIZE) == 1);
+    CHECK(g_ui32Windows == 1);
+    CHECK(g_ui32LastPeakBin == ui32Bin);
+    CHECK(g_fBandEnergy[2] > 0.99f * (g_fBandEnergy[0] + g_fBandEnergy[1] +
+                                      g_fBandEnergy[2] + g_fBandEnergy[3]));
+    g_pDump = pDump;
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o':
+                g_pDump = fopen(optarg, "w");
+                if (!g_pDump)
+                {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            case 's':
+                g_ui64Rand = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-o file] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    test_config();
+    test_bin_tone();
+    test_signal();
+
+    printf("Worst power error: %.3g of peak over %u windows\n",
+           g_dWorstError, (unsigned)NUM_WINDOWS + 1);
+
+    if (g_pDump)
+    {
+        fclose(g_pDump);
+    }
+
+    return host_test_result();
+}
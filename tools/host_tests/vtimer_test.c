@@ -0,0 +1,412 @@
+//*****************************************************************************
+//
+//! @file vtimer_test.c
+//!
+//! @brief Host test of the virtual timer interrupt service.
+//!
+//!
+//! The STIMER is modelled by a counter the test advances and a compare that
+//! raises the interrupt when the counter reaches it.  Checks that a storm of
+//! due timers is dispatched AM_UTIL_VTIMER_MAX_BATCH callbacks per interrupt
+//! with the compare re-armed in between, that a callback that keeps
+//! restarting itself cannot hold the handler, and that re-initializing the
+//! service stops timers left in the old heap.  Time comes from
+//! am_util_timestamp, so the overflow interrupt is modelled as well, and a
+//! deadline across a counter wrap is checked.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "am_util_timestamp.h"
+#include "am_util_vtimer.h"
+#include "host_test.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define NUM_TIMERS                  100
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+//
+// STIMER model.
+//
+static uint32_t g_ui32Counter;
+static uint32_t g_ui32Compare;
+static bool g_bCompareArmed;
+static bool g_bIntPending;
+static bool g_bOverflowPending;
+static uint32_t g_ui32CounterReads;
+
+static am_util_vtimer_t *g_ppsHeap[NUM_TIMERS];
+static am_util_vtimer_t *g_ppsHeap2[NUM_TIMERS];
+static am_util_vtimer_t g_sTimers[NUM_TIMERS];
+static uint32_t g_ui32Calls[NUM_TIMERS];
+
+//*****************************************************************************
+//
+// HAL entry points the service links against.
+//
+//*****************************************************************************
+void am_hal_stimer_int_enable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+void am_hal_stimer_int_disable(uint32_t ui32Interrupt) { (void)ui32Interrupt; }
+void am_hal_stimer_capture_start(uint32_t ui32CaptureNum, uint32_t ui32GPIONumber, bool bPolarity) { (void)ui32CaptureNum; (void)ui32GPIONumber; (void)bPolarity; }
+void am_hal_stimer_capture_stop(uint32_t ui32CaptureNum) { (void)ui32CaptureNum; }
+uint32_t am_hal_stimer_capture_get(uint32_t ui32CaptureNum) { (void)ui32CaptureNum; return 0; }
+
+void
+am_hal_stimer_int_clear(uint32_t ui32Interrupt)
+{
+    if (ui32Interrupt & AM_HAL_STIMER_INT_OVERFLOW)
+    {
+        g_bOverflowPending = false;
+    }
+    if (ui32Interrupt & AM_HAL_STIMER_INT_COMPAREA)
+    {
+        g_bIntPending = false;
+    }
+}
+
+void
+am_hal_stimer_int_set(uint32_t ui32Interrupt)
+{
+    if (ui32Interrupt & AM_HAL_STIMER_INT_COMPAREA)
+    {
+        g_bIntPending = true;
+    }
+}
+
+uint32_t
+am_hal_stimer_int_status_get(bool bEnabledOnly)
+{
+    (void)bEnabledOnly;
+    return (g_bOverflowPending ? AM_HAL_STIMER_INT_OVERFLOW : 0) |
+           (g_bIntPending ? AM_HAL_STIMER_INT_COMPAREA : 0);
+}
+
+static void
+counter_advance(uint32_t ui32Ticks)
+{
+    if (g_ui32Counter + ui32Ticks < g_ui32Counter)
+    {
+        g_bOverflowPending = true;
+    }
+    g_ui32Counter += ui32Ticks;
+}
+
+//
+// Every read takes a tick, so a handler that never returns is noticed by the
+// time it would take.
+//
+uint32_t
+am_hal_stimer_counter_get(void)
+{
+    uint32_t ui32Count = g_ui32Counter;
+
+    g_ui32CounterReads++;
+    counter_advance(1);
+    return ui32Count;
+}
+
+void
+am_hal_stimer_compare_delta_set(uint32_t ui32CmprInstance, uint32_t ui32Delta)
+{
+    (void)ui32CmprInstance;
+    g_ui32Compare = g_ui32Counter + ui32Delta;
+    g_bCompareArmed = true;
+}
+
+//*****************************************************************************
+//
+// Helpers.
+//
+//*****************************************************************************
+static void
+service_init(am_util_vtimer_t **ppsHeap)
+{
+    am_util_vtimer_config_t sConfig =
+    {
+        .ui32CompareInstance = 0,
+        .ppsHeap = ppsHeap,
+        .ui32HeapSize = NUM_TIMERS,
+    };
+
+    CHECK(am_util_vtimer_init(&sConfig) == AM_HAL_STATUS_SUCCESS);
+}
+
+//
+// Advance time to the compare and take the interrupt.  Returns the number of
+// callbacks the interrupt ran.
+//
+static uint32_t
+take_interrupt(void)
+{
+    am_util_vtimer_stats_t sBefore, sAfter;
+
+    if (!g_bIntPending)
+    {
+        CHECK(g_bCompareArmed);
+        if ((int32_t)(g_ui32Compare - g_ui32Counter) > 0)
+        {
+            counter_advance(g_ui32Compare - g_ui32Counter);
+        }
+    }
+    g_bCompareArmed = false;
+    g_bIntPending = true;
+
+    am_util_vtimer_stats_get(&sBefore);
+    am_util_vtimer_int_service();
+    am_util_vtimer_stats_get(&sAfter);
+
+    //
+    // The handler must always leave the next interrupt scheduled.
+    //
+    CHECK(g_bCompareArmed || g_bIntPending);
+
+    return sAfter.ui32Expirations - sBefore.ui32Expirations;
+}
+
+static void
+count_cb(am_util_vtimer_t *psTimer, void *pCtxt)
+{
+    (void)pCtxt;
+    g_ui32Calls[psTimer - g_sTimers]++;
+}
+
+static void
+restart_cb(am_util_vtimer_t *psTimer, void *pCtxt)
+{
+    (void)pCtxt;
+    g_ui32Calls[psTimer - g_sTimers]++;
+    am_util_vtimer_start(psTimer, 0, 0, restart_cb, NULL);
+}
+
+//*****************************************************************************
+//
+// Many timers due at once are spread over several interrupts.
+//
+//*****************************************************************************
+static void
+test_storm(void)
+{
+    am_util_vtimer_stats_t sStats;
+    uint32_t ui32Total = 0, ui32Interrupts = 0;
+
+    memset(g_ui32Calls, 0, sizeof(g_ui32Calls));
+    service_init(g_ppsHeap);
+
+    for (uint32_t i = 0; i < NUM_TIMERS; i++)
+    {
+        CHECK(am_util_vtimer_start(&g_sTimers[i], 1000, 0, count_cb, NULL) == AM_HAL_STATUS_SUCCESS);
+    }
+
+    //
+    // Let them all fall due before the first interrupt is taken.
+    //
+    counter_advance(5000);
+
+    while (ui32Total < NUM_TIMERS && ui32Interrupts < 2 * NUM_TIMERS)
+    {
+        uint32_t ui32Ran = take_interrupt();
+
+        CHECK(ui32Ran <= AM_UTIL_VTIMER_MAX_BATCH);
+        if (ui32Total + AM_UTIL_VTIMER_MAX_BATCH <= NUM_TIMERS)
+        {
+            CHECK(ui32Ran == AM_UTIL_VTIMER_MAX_BATCH);
+
+            //
+            // Deferred work comes back after the minimum delta, not at once.
+            //
+            CHECK(!g_bIntPending);
+            CHECK(g_ui32Compare - g_ui32Counter == AM_UTIL_VTIMER_MIN_DELTA);
+        }
+        ui32Total += ui32Ran;
+        ui32Interrupts++;
+    }
+
+    CHECK(ui32Total == NUM_TIMERS);
+    CHECK(ui32Interrupts == (NUM_TIMERS + AM_UTIL_VTIMER_MAX_BATCH - 1) / AM_UTIL_VTIMER_MAX_BATCH);
+    for (uint32_t i = 0; i < NUM_TIMERS; i++)
+    {
+        CHECK(g_ui32Calls[i] == 1);
+        CHECK(!am_util_vtimer_active(&g_sTimers[i]));
+    }
+
+    am_util_vtimer_stats_get(&sStats);
+    CHECK(sStats.ui32MaxBatch == AM_UTIL_VTIMER_MAX_BATCH);
+    CHECK(sStats.ui32Deferrals == NUM_TIMERS / AM_UTIL_VTIMER_MAX_BATCH);
+
+    //
+    // Nothing left: the next interrupt runs nothing.
+    //
+    CHECK(take_interrupt() == 0);
+}
+
+//*****************************************************************************
+//
+// A callback that restarts itself with no delay is always due.  The handler
+// must still return.
+//
+//*****************************************************************************
+static void
+test_self_restart(void)
+{
+    uint32_t ui32Reads;
+
+    memset(g_ui32Calls, 0, sizeof(g_ui32Calls));
+    service_init(g_ppsHeap);
+    CHECK(am_util_vtimer_start(&g_sTimers[0], 0, 0, restart_cb, NULL) == AM_HAL_STATUS_SUCCESS);
+
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        g_ui32CounterReads = 0;
+        CHECK(take_interrupt() == AM_UTIL_VTIMER_MAX_BATCH);
+        ui32Reads = g_ui32CounterReads;
+        CHECK(ui32Reads < 4 * AM_UTIL_VTIMER_MAX_BATCH + 8);
+    }
+
+    CHECK(g_ui32Calls[0] == 10 * AM_UTIL_VTIMER_MAX_BATCH);
+    CHECK(am_util_vtimer_stop(&g_sTimers[0]) == AM_HAL_STATUS_SUCCESS);
+}
+
+//*****************************************************************************
+//
+// Re-initializing stops timers queued in the old heap.
+//
+//*****************************************************************************
+static void
+test_reinit(void)
+{
+    memset(g_ui32Calls, 0, sizeof(g_ui32Calls));
+    service_init(g_ppsHeap);
+
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        CHECK(am_util_vtimer_start(&g_sTimers[i], 100 + i, 0, count_cb, NULL) == AM_HAL_STATUS_SUCCESS);
+    }
+
+    service_init(g_ppsHeap2);
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        CHECK(!am_util_vtimer_active(&g_sTimers[i]));
+    }
+
+    //
+    // Restarting one must not try to remove it from a slot in the new heap.
+    //
+    CHECK(am_util_vtimer_start(&g_sTimers[7], 50, 0, count_cb, NULL) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_util_vtimer_start(&g_sTimers[3], 60, 0, count_cb, NULL) == AM_HAL_STATUS_SUCCESS);
+    CHECK(g_ppsHeap2[0] == &g_sTimers[7]);
+    CHECK(g_ppsHeap2[1] == &g_sTimers[3]);
+    CHECK(am_util_vtimer_stop(&g_sTimers[5]) == AM_HAL_STATUS_SUCCESS);
+    CHECK(am_util_vtimer_active(&g_sTimers[7]));
+    CHECK(am_util_vtimer_active(&g_sTimers[3]));
+
+    counter_advance(100);
+    CHECK(take_interrupt() == 2);
+    CHECK(g_ui32Calls[7] == 1 && g_ui32Calls[3] == 1);
+    CHECK(g_ui32Calls[0] == 0 && g_ui32Calls[9] == 0);
+}
+
+//*****************************************************************************
+//
+// Deadlines across a counter wrap, with the overflow interrupt taken late.
+//
+//*****************************************************************************
+static void
+test_wrap(void)
+{
+    uint64_t ui64Before, ui64Deadline;
+
+    memset(g_ui32Calls, 0, sizeof(g_ui32Calls));
+    service_init(g_ppsHeap);
+
+    counter_advance(0xFFFFFF00 - g_ui32Counter);
+    if (g_bOverflowPending)
+    {
+        am_util_timestamp_int_service(AM_HAL_STIMER_INT_OVERFLOW);
+    }
+
+    ui64Before = am_util_vtimer_now();
+    CHECK(am_util_vtimer_start(&g_sTimers[0], 0x200, 0, count_cb, NULL) == AM_HAL_STATUS_SUCCESS);
+    ui64Deadline = g_sTimers[0].ui64Deadline;
+    CHECK(ui64Deadline > ui64Before);
+    CHECK((ui64Deadline >> 32) == (ui64Before >> 32) + 1);
+
+    //
+    // The compare fires after the wrap but before the overflow interrupt is
+    // serviced.  The pending overflow must still be counted.
+    //
+    CHECK(take_interrupt() == 1);
+    CHECK(g_bOverflowPending);
+    CHECK(g_ui32Calls[0] == 1);
+    CHECK(am_util_vtimer_now() >= ui64Deadline);
+
+    am_util_timestamp_int_service(AM_HAL_STIMER_INT_OVERFLOW);
+    CHECK(!g_bOverflowPending);
+    CHECK(am_util_vtimer_now() >= ui64Deadline);
+    CHECK(am_util_vtimer_now() == am_util_timestamp_get() - 1);
+}
+
+//*****************************************************************************
+//
+// Main
+//
+//*****************************************************************************
+int
+main(void)
+{
+    test_storm();
+    test_self_restart();
+    test_reinit();
+    test_wrap();
+
+    return host_test_result();
+}
@@ -0,0 +1,330 @@
+//*****************************************************************************
+//
+//! @file am_util_burst_governor.c
+//!
+//! @brief Workload driven TurboSPOT burst mode governor.
+//!
+//!
+//! Burst mode is held for the duration of registered compute regions (FFT,
+//! codec, ECC) and is otherwise switched on the reported load: the busy
+//! fraction of the last sample window (e.g. from the FreeRTOS idle run time)
+//! and the run queue depth.  Load driven switches are damped by separate
+//! enter and leave thresholds and a minimum dwell time.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_mcu_apollo.h"
+#include "am_util_burst_governor.h"
+
+//*****************************************************************************
+//
+// Governor state.
+//
+//*****************************************************************************
+static struct
+{
+    am_util_burst_governor_config_t sConfig;
+    bool                            bInitialized;
+    bool                            bBurst;
+    bool                            bLoadHigh;
+    uint32_t                        ui32Regions;
+    uint32_t                        ui32ModeStart;
+    uint32_t                        ui32AccountStart;
+    am_util_burst_governor_stats_t  sStats;
+} g_sBurstGov;
+
+//*****************************************************************************
+//
+// Add the time since the last call to the current mode and return the
+// current time.  Must be called in a critical section.
+//
+//*****************************************************************************
+static uint32_t
+burst_governor_account(void)
+{
+    uint32_t ui32Now = g_sBurstGov.sConfig.pfnTimeGet();
+    uint32_t ui32Elapsed = ui32Now - g_sBurstGov.ui32AccountStart;
+
+    if ( g_sBurstGov.bBurst )
+    {
+        g_sBurstGov.sStats.ui64BurstTicks += ui32Elapsed;
+    }
+    else
+    {
+        g_sBurstGov.sStats.ui64NormalTicks += ui32Elapsed;
+    }
+    g_sBurstGov.ui32AccountStart = ui32Now;
+
+    return ui32Now;
+}
+
+//*****************************************************************************
+//
+// Switch to the mode wanted by the current regions and load.  Load driven
+// switches wait for the dwell time unless bForce is set.  Must be called in a
+// critical section.
+//
+//*****************************************************************************
+static uint32_t
+burst_governor_update(bool bForce)
+{
+    am_hal_burst_mode_e eMode;
+    uint32_t ui32Status;
+    bool bWant = (g_sBurstGov.ui32Regions != 0) || g_sBurstGov.bLoadHigh;
+
+    if ( bWant == g_sBurstGov.bBurst )
+    {
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    if ( !bForce &&
+         (g_sBurstGov.sConfig.pfnTimeGet() - g_sBurstGov.ui32ModeStart <
+          g_sBurstGov.sConfig.ui32DwellTicks) )
+    {
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    if ( bWant )
+    {
+        ui32Status = am_hal_burst_mode_enable(&eMode);
+    }
+    else
+    {
+        ui32Status = am_hal_burst_mode_disable(&eMode);
+    }
+
+    if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+    {
+        g_sBurstGov.sStats.ui32Failures++;
+        return ui32Status;
+    }
+
+    g_sBurstGov.ui32ModeStart = burst_governor_account();
+    g_sBurstGov.bBurst = (eMode == AM_HAL_BURST_MODE);
+    if ( g_sBurstGov.bBurst )
+    {
+        g_sBurstGov.sStats.ui32BurstEntries++;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Initialize the governor.  Returns AM_HAL_STATUS_INVALID_OPERATION if this
+// part does not support burst mode.
+//
+//*****************************************************************************
+uint32_t
+am_util_burst_governor_init(const am_util_burst_governor_config_t *psConfig)
+{
+    am_hal_burst_avail_e eAvail;
+    am_hal_burst_mode_e eMode;
+    uint32_t ui32Status;
+
+    if ( (psConfig == NULL) || (psConfig->pfnTimeGet == NULL) ||
+         (psConfig->ui32LoadHighPct > 100) ||
+         (psConfig->ui32LoadLowPct >= psConfig->ui32LoadHighPct) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    ui32Status = am_hal_burst_mode_initialize(&eAvail);
+    if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+    {
+        return ui32Status;
+    }
+
+    //
+    // Start from normal mode with clean accounting.
+    //
+    ui32Status = am_hal_burst_mode_disable(&eMode);
+    if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+    {
+        return ui32Status;
+    }
+
+    AM_CRITICAL_BEGIN
+    g_sBurstGov.sConfig = *psConfig;
+    g_sBurstGov.bBurst = false;
+    g_sBurstGov.bLoadHigh = false;
+    g_sBurstGov.ui32Regions = 0;
+    g_sBurstGov.ui32ModeStart = psConfig->pfnTimeGet();
+    g_sBurstGov.ui32AccountStart = g_sBurstGov.ui32ModeStart;
+    g_sBurstGov.sStats = (am_util_burst_governor_stats_t) { 0 };
+    g_sBurstGov.bInitialized = true;
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Enter a compute region.  Burst mode is on when this returns successfully
+// and stays on until the matching region exit.  Regions may nest.
+//
+//*****************************************************************************
+uint32_t
+am_util_burst_governor_region_enter(void)
+{
+    uint32_t ui32Status;
+
+    if ( !g_sBurstGov.bInitialized )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    AM_CRITICAL_BEGIN
+    g_sBurstGov.ui32Regions++;
+    g_sBurstGov.sStats.ui32RegionEntries++;
+    ui32Status = burst_governor_update(true);
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Leave a compute region.  When the last region exits, burst mode stays on
+// only if the load calls for it.
+//
+//*****************************************************************************
+uint32_t
+am_util_burst_governor_region_exit(void)
+{
+    uint32_t ui32Status = AM_HAL_STATUS_INVALID_OPERATION;
+
+    if ( !g_sBurstGov.bInitialized )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    AM_CRITICAL_BEGIN
+    if ( g_sBurstGov.ui32Regions )
+    {
+        g_sBurstGov.ui32Regions--;
+        ui32Status = burst_governor_update(true);
+    }
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Report the load over the last sample window: ui32BusyTicks of
+// ui32TotalTicks were spent outside the idle task, and ui32ReadyTasks tasks
+// are waiting to run.
+//
+//*****************************************************************************
+uint32_t
+am_util_burst_governor_load_update(uint32_t ui32BusyTicks,
+                                   uint32_t ui32TotalTicks,
+                                   uint32_t ui32ReadyTasks)
+{
+    uint32_t ui32Status;
+    uint32_t ui32LoadPct;
+    bool bQueueHigh;
+
+    if ( !g_sBurstGov.bInitialized )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    if ( (ui32TotalTicks == 0) || (ui32BusyTicks > ui32TotalTicks) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    ui32LoadPct = (uint32_t)(((uint64_t)ui32BusyTicks * 100) / ui32TotalTicks);
+    bQueueHigh = g_sBurstGov.sConfig.ui32QueueHigh &&
+                 (ui32ReadyTasks >= g_sBurstGov.sConfig.ui32QueueHigh);
+
+    AM_CRITICAL_BEGIN
+
+    //
+    // Between the two thresholds the previous decision stands.
+    //
+    if ( bQueueHigh || (ui32LoadPct >= g_sBurstGov.sConfig.ui32LoadHighPct) )
+    {
+        g_sBurstGov.bLoadHigh = true;
+    }
+    else if ( ui32LoadPct <= g_sBurstGov.sConfig.ui32LoadLowPct )
+    {
+        g_sBurstGov.bLoadHigh = false;
+    }
+
+    ui32Status = burst_governor_update(false);
+
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Returns true if the governor has burst mode on.
+//
+//*****************************************************************************
+bool
+am_util_burst_governor_active(void)
+{
+    return g_sBurstGov.bBurst;
+}
+
+//*****************************************************************************
+//
+// Returns a copy of the governor statistics.
+//
+//*****************************************************************************
+void
+am_util_burst_governor_stats_get(am_util_burst_governor_stats_t *psStats)
+{
+    AM_CRITICAL_BEGIN
+    if ( g_sBurstGov.bInitialized )
+    {
+        burst_governor_account();
+    }
+    *psStats = g_sBurstGov.sStats;
+    AM_CRITICAL_END
+}
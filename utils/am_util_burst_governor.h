@@ -0,0 +1,126 @@
+//*****************************************************************************
+//
+//! @file am_util_burst_governor.h
+//!
+//! @brief Workload driven TurboSPOT burst mode governor.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_BURST_GOVERNOR_H
+#define AM_UTIL_BURST_GOVERNOR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! Time base used for dwell times and mode accounting.
+//
+//*****************************************************************************
+typedef uint32_t (*am_util_burst_governor_time_get_t)(void);
+
+//*****************************************************************************
+//
+//! Governor configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Time base (e.g. am_hal_stimer_counter_get).
+    //
+    am_util_burst_governor_time_get_t   pfnTimeGet;
+
+    //
+    //! Load (percent busy) at or above which burst mode is entered, and at or
+    //! below which it is left.  ui32LoadLowPct must be below ui32LoadHighPct.
+    //
+    uint32_t                            ui32LoadHighPct;
+    uint32_t                            ui32LoadLowPct;
+
+    //
+    //! Number of ready tasks at or above which burst mode is entered.  0
+    //! ignores the run queue depth.
+    //
+    uint32_t                            ui32QueueHigh;
+
+    //
+    //! Minimum time spent in a mode before a load change may leave it.
+    //! Compute regions are not subject to the dwell time.
+    //
+    uint32_t                            ui32DwellTicks;
+} am_util_burst_governor_config_t;
+
+//*****************************************************************************
+//
+//! Governor statistics.  Times are in time base ticks and include the current
+//! period.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint64_t                            ui64BurstTicks;
+    uint64_t                            ui64NormalTicks;
+    uint32_t                            ui32BurstEntries;
+    uint32_t                            ui32RegionEntries;
+    uint32_t                            ui32Failures;
+} am_util_burst_governor_stats_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_burst_governor_init(const am_util_burst_governor_config_t *psConfig);
+extern uint32_t am_util_burst_governor_region_enter(void);
+extern uint32_t am_util_burst_governor_region_exit(void);
+extern uint32_t am_util_burst_governor_load_update(uint32_t ui32BusyTicks,
+                                                   uint32_t ui32TotalTicks,
+                                                   uint32_t ui32ReadyTasks);
+extern bool am_util_burst_governor_active(void);
+extern void am_util_burst_governor_stats_get(am_util_burst_governor_stats_t *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_BURST_GOVERNOR_H
@@ -0,0 +1,345 @@
+//*****************************************************************************
+//
+//! @file am_util_cache_profile.c
+//!
+//! @brief Flash cache profiling and configuration tuning.
+//!
+//!
+//! Region profiling accumulates the cache monitor counters and elapsed time
+//! between begin/end pairs.  The tuner runs a workload under each cache
+//! configuration and keeps the best one for the chosen objective.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_mcu_apollo.h"
+#include "am_util_stdio.h"
+#include "am_util_cache_profile.h"
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+static am_util_cache_time_get_t g_pfnCacheProfileTime;
+
+//*****************************************************************************
+//
+// Candidate settings searched by the tuner.
+//
+//*****************************************************************************
+static const am_hal_cachectrl_descr_e g_eCacheTuneDescr[] =
+{
+    AM_HAL_CACHECTRL_DESCR_1WAY_128B_512E,
+    AM_HAL_CACHECTRL_DESCR_2WAY_128B_512E,
+    AM_HAL_CACHECTRL_DESCR_1WAY_128B_1024E,
+};
+
+static const am_hal_cachectrl_config_mode_e g_eCacheTuneMode[] =
+{
+    AM_HAL_CACHECTRL_CONFIG_MODE_INSTR,
+    AM_HAL_CACHECTRL_CONFIG_MODE_DATA,
+    AM_HAL_CACHECTRL_CONFIG_MODE_INSTR_DATA,
+};
+
+#define CACHE_TUNE_NUM_DESCR    (sizeof(g_eCacheTuneDescr) / sizeof(g_eCacheTuneDescr[0]))
+#define CACHE_TUNE_NUM_MODE     (sizeof(g_eCacheTuneMode) / sizeof(g_eCacheTuneMode[0]))
+#define CACHE_TUNE_NUM_ENABLED  (CACHE_TUNE_NUM_DESCR * CACHE_TUNE_NUM_MODE * 2)
+
+//*****************************************************************************
+//
+// Turn the cache monitor on.  am_hal_cachectrl_config() turns it off.
+//
+//*****************************************************************************
+static void
+cache_monitor_start(void)
+{
+    am_hal_cachectrl_control(AM_HAL_CACHECTRL_CONTROL_MONITOR_ENABLE, 0);
+}
+
+//*****************************************************************************
+//
+// Enable profiling.  The cache must already be configured and enabled.
+//
+//*****************************************************************************
+uint32_t
+am_util_cache_profile_init(am_util_cache_time_get_t pfnTimeGet)
+{
+    if ( pfnTimeGet == NULL )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    g_pfnCacheProfileTime = pfnTimeGet;
+    cache_monitor_start();
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Clear a region's totals.
+//
+//*****************************************************************************
+void
+am_util_cache_profile_region_init(am_util_cache_profile_region_t *psRegion,
+                                  const char *pcName)
+{
+    *psRegion = (am_util_cache_profile_region_t) { 0 };
+    psRegion->pcName = pcName;
+}
+
+//*****************************************************************************
+//
+// Mark the start of a pass through a region.  Regions may nest or overlap.
+//
+//*****************************************************************************
+void
+am_util_cache_profile_begin(am_util_cache_profile_region_t *psRegion)
+{
+    am_hal_cachectrl_monitor_get(&psRegion->sStart);
+    psRegion->ui32StartTime = g_pfnCacheProfileTime();
+}
+
+//*****************************************************************************
+//
+// Mark the end of a pass through a region and add it to the totals.
+//
+//*****************************************************************************
+void
+am_util_cache_profile_end(am_util_cache_profile_region_t *psRegion)
+{
+    am_hal_cachectrl_monitor_t sEnd;
+    uint32_t ui32EndTime = g_pfnCacheProfileTime();
+
+    am_hal_cachectrl_monitor_get(&sEnd);
+
+    psRegion->ui32Calls++;
+    psRegion->ui64Ticks += ui32EndTime - psRegion->ui32StartTime;
+    psRegion->ui64InstrLookups += sEnd.ui32InstrLookups - psRegion->sStart.ui32InstrLookups;
+    psRegion->ui64InstrHits += sEnd.ui32InstrHits - psRegion->sStart.ui32InstrHits;
+    psRegion->ui64DataLookups += sEnd.ui32DataLookups - psRegion->sStart.ui32DataLookups;
+    psRegion->ui64DataHits += sEnd.ui32DataHits - psRegion->sStart.ui32DataHits;
+}
+
+//*****************************************************************************
+//
+// Print a region's totals.  Hit rates are shown to 0.1%.
+//
+//*****************************************************************************
+void
+am_util_cache_profile_print(const am_util_cache_profile_region_t *psRegion)
+{
+    uint32_t ui32IRate = 0;
+    uint32_t ui32DRate = 0;
+
+    if ( psRegion->ui64InstrLookups )
+    {
+        ui32IRate = (uint32_t)(psRegion->ui64InstrHits * 1000 / psRegion->ui64InstrLookups);
+    }
+    if ( psRegion->ui64DataLookups )
+    {
+        ui32DRate = (uint32_t)(psRegion->ui64DataHits * 1000 / psRegion->ui64DataLookups);
+    }
+
+    am_util_stdio_printf("%s: %d calls, %d ticks, I hit %d.%d%% of %d, D hit %d.%d%% of %d\n",
+                         psRegion->pcName ? psRegion->pcName : "?",
+                         psRegion->ui32Calls, (uint32_t)psRegion->ui64Ticks,
+                         ui32IRate / 10, ui32IRate % 10,
+                         (uint32_t)psRegion->ui64InstrLookups,
+                         ui32DRate / 10, ui32DRate % 10,
+                         (uint32_t)psRegion->ui64DataLookups);
+}
+
+//*****************************************************************************
+//
+// Apply a cache configuration and measure the workload under it.
+//
+//*****************************************************************************
+static void
+cache_tune_measure(const am_util_cache_tune_config_t *psConfig,
+                   am_util_cache_tune_result_t *psResult)
+{
+    am_hal_cachectrl_monitor_t sStart, sEnd;
+    uint32_t ui32Start;
+
+    am_hal_cachectrl_config(&psResult->sConfig);
+    if ( psResult->sConfig.eMode != AM_HAL_CACHECTRL_CONFIG_MODE_DISABLE )
+    {
+        am_hal_cachectrl_enable();
+    }
+    am_hal_cachectrl_control(AM_HAL_CACHECTRL_CONTROL_FLASH_CACHE_INVALIDATE, 0);
+    cache_monitor_start();
+
+    //
+    // One warm-up pass so every candidate is measured from a warm cache.
+    //
+    psConfig->pfnWorkload(psConfig->pCtxt);
+
+    am_hal_cachectrl_monitor_get(&sStart);
+    ui32Start = psConfig->pfnTimeGet();
+
+    for ( uint32_t i = 0; i < psConfig->ui32Iterations; i++ )
+    {
+        psConfig->pfnWorkload(psConfig->pCtxt);
+    }
+
+    psResult->ui32Ticks = psConfig->pfnTimeGet() - ui32Start;
+    am_hal_cachectrl_monitor_get(&sEnd);
+
+    psResult->ui32Accesses = (sEnd.ui32InstrAccesses - sStart.ui32InstrAccesses) +
+                             (sEnd.ui32DataAccesses - sStart.ui32DataAccesses);
+
+    //
+    // Accesses served from the line buffers never look up the cache, so a
+    // miss is a lookup without a hit.
+    //
+    psResult->ui32Misses = ((sEnd.ui32DataLookups - sStart.ui32DataLookups) -
+                            (sEnd.ui32DataHits - sStart.ui32DataHits)) +
+                           ((sEnd.ui32InstrLookups - sStart.ui32InstrLookups) -
+                            (sEnd.ui32InstrHits - sStart.ui32InstrHits));
+
+    if ( psConfig->eObjective == AM_UTIL_CACHE_TUNE_FASTEST )
+    {
+        psResult->ui32Cost = psResult->ui32Ticks;
+    }
+    else if ( psConfig->pfnEnergy )
+    {
+        psResult->ui32Cost = psConfig->pfnEnergy(psResult);
+    }
+    else
+    {
+        psResult->ui32Cost = psResult->ui32Misses;
+    }
+}
+
+//*****************************************************************************
+//
+// Run the workload under every cache configuration and leave the cache set up
+// with the best one for the objective.  Ties go to the faster configuration.
+//
+// The fully disabled cache is only a candidate for AM_UTIL_CACHE_TUNE_FASTEST
+// since the monitor does not count accesses while the cache is off.  Run this
+// with interrupts quiet; anything else executing from flash skews the result.
+//
+//*****************************************************************************
+uint32_t
+am_util_cache_tune(const am_util_cache_tune_config_t *psConfig,
+                   am_hal_cachectrl_config_t *psBest,
+                   uint32_t *pui32NumResults)
+{
+    am_util_cache_tune_result_t sResult, sBest;
+    uint32_t ui32NumResults = 0;
+    bool bHaveBest = false;
+    uint32_t ui32Candidates;
+
+    if ( (psConfig == NULL) || (psConfig->pfnWorkload == NULL) ||
+         (psConfig->pfnTimeGet == NULL) || (psConfig->ui32Iterations == 0) ||
+         ((psConfig->psResults == NULL) && psConfig->ui32MaxResults) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    //
+    // Every descriptor, enable mode and replacement policy, plus the cache
+    // off when timing is all that matters.
+    //
+    ui32Candidates = CACHE_TUNE_NUM_ENABLED;
+    if ( psConfig->eObjective == AM_UTIL_CACHE_TUNE_FASTEST )
+    {
+        ui32Candidates++;
+    }
+
+    for ( uint32_t i = 0; i < ui32Candidates; i++ )
+    {
+        if ( i < CACHE_TUNE_NUM_ENABLED )
+        {
+            sResult.sConfig.eDescript = g_eCacheTuneDescr[i % CACHE_TUNE_NUM_DESCR];
+            sResult.sConfig.eMode = g_eCacheTuneMode[(i / CACHE_TUNE_NUM_DESCR) % CACHE_TUNE_NUM_MODE];
+            sResult.sConfig.bLRU = (i / (CACHE_TUNE_NUM_DESCR * CACHE_TUNE_NUM_MODE)) != 0;
+        }
+        else
+        {
+            sResult.sConfig = am_hal_cachectrl_defaults;
+            sResult.sConfig.eMode = AM_HAL_CACHECTRL_CONFIG_MODE_DISABLE;
+        }
+
+        cache_tune_measure(psConfig, &sResult);
+
+        if ( ui32NumResults < psConfig->ui32MaxResults )
+        {
+            psConfig->psResults[ui32NumResults] = sResult;
+        }
+        ui32NumResults++;
+
+        if ( !bHaveBest || (sResult.ui32Cost < sBest.ui32Cost) ||
+             ((sResult.ui32Cost == sBest.ui32Cost) &&
+              (sResult.ui32Ticks < sBest.ui32Ticks)) )
+        {
+            sBest = sResult;
+            bHaveBest = true;
+        }
+    }
+
+    //
+    // Leave the winner in place, with the monitor running for profiling.
+    //
+    am_hal_cachectrl_config(&sBest.sConfig);
+    if ( sBest.sConfig.eMode != AM_HAL_CACHECTRL_CONFIG_MODE_DISABLE )
+    {
+        am_hal_cachectrl_enable();
+    }
+    cache_monitor_start();
+
+    if ( psBest )
+    {
+        *psBest = sBest.sConfig;
+    }
+
+    if ( pui32NumResults )
+    {
+        *pui32NumResults = ui32NumResults < psConfig->ui32MaxResults ?
+                           ui32NumResults : psConfig->ui32MaxResults;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
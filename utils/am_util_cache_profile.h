@@ -0,0 +1,169 @@
+//*****************************************************************************
+//
+//! @file am_util_cache_profile.h
+//!
+//! @brief Flash cache profiling and configuration tuning.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_CACHE_PROFILE_H
+#define AM_UTIL_CACHE_PROFILE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! Time base used for region and workload timing.
+//
+//*****************************************************************************
+typedef uint32_t (*am_util_cache_time_get_t)(void);
+
+//*****************************************************************************
+//
+//! Profiled code region.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char                  *pcName;
+
+    //
+    //! Totals over all completed passes through the region.
+    //
+    uint32_t                    ui32Calls;
+    uint64_t                    ui64Ticks;
+    uint64_t                    ui64InstrLookups;
+    uint64_t                    ui64InstrHits;
+    uint64_t                    ui64DataLookups;
+    uint64_t                    ui64DataHits;
+
+    //
+    // Internal state.
+    //
+    am_hal_cachectrl_monitor_t  sStart;
+    uint32_t                    ui32StartTime;
+} am_util_cache_profile_region_t;
+
+//*****************************************************************************
+//
+//! Tuning objective.
+//
+//*****************************************************************************
+typedef enum
+{
+    //
+    //! Shortest workload run time.
+    //
+    AM_UTIL_CACHE_TUNE_FASTEST,
+
+    //
+    //! Lowest energy estimate.  Unless a model is supplied, the estimate is
+    //! the number of flash accesses not served by the cache.
+    //
+    AM_UTIL_CACHE_TUNE_LOWEST_ENERGY
+} am_util_cache_tune_objective_e;
+
+//*****************************************************************************
+//
+//! Measurement of one candidate configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    am_hal_cachectrl_config_t   sConfig;
+    uint32_t                    ui32Ticks;
+    uint32_t                    ui32Accesses;
+    uint32_t                    ui32Misses;
+    uint32_t                    ui32Cost;
+} am_util_cache_tune_result_t;
+
+//*****************************************************************************
+//
+//! Tuner configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Workload to measure.  It is run ui32Iterations times per candidate
+    //! after one untimed warm-up run.
+    //
+    void                        (*pfnWorkload)(void *pCtxt);
+    void                        *pCtxt;
+    uint32_t                    ui32Iterations;
+
+    am_util_cache_time_get_t    pfnTimeGet;
+    am_util_cache_tune_objective_e eObjective;
+
+    //
+    //! Optional energy model for AM_UTIL_CACHE_TUNE_LOWEST_ENERGY.
+    //
+    uint32_t                    (*pfnEnergy)(const am_util_cache_tune_result_t *psResult);
+
+    //
+    //! Optional storage for every candidate's measurement.
+    //
+    am_util_cache_tune_result_t *psResults;
+    uint32_t                    ui32MaxResults;
+} am_util_cache_tune_config_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_cache_profile_init(am_util_cache_time_get_t pfnTimeGet);
+extern void am_util_cache_profile_region_init(am_util_cache_profile_region_t *psRegion,
+                                              const char *pcName);
+extern void am_util_cache_profile_begin(am_util_cache_profile_region_t *psRegion);
+extern void am_util_cache_profile_end(am_util_cache_profile_region_t *psRegion);
+extern void am_util_cache_profile_print(const am_util_cache_profile_region_t *psRegion);
+extern uint32_t am_util_cache_tune(const am_util_cache_tune_config_t *psConfig,
+                                   am_hal_cachectrl_config_t *psBest,
+                                   uint32_t *pui32NumResults);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_CACHE_PROFILE_H
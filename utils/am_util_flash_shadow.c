@@ -0,0 +1,405 @@
+//*****************************************************************************
+//
+//! @file am_util_flash_shadow.c
+//!
+//! @brief Write coalescing layer for internal flash.
+//!
+//!
+//! Writes are gathered in a RAM copy of one flash page and reach the flash
+//! when another page is written or am_util_flash_shadow_flush() is called.
+//! A flush that only clears bits is programmed in place, one word run at a
+//! time, so counters, flags and append-only records never erase the page.
+//! Otherwise the page is erased once and only its non-blank words are
+//! programmed.
+//!
+//! Program and erase run in the BOOTROM helpers, which execute outside
+//! flash.  Interrupts are held off around each helper call so that no
+//! flash-resident handler runs while the array is busy; see the header for
+//! the latency this adds.
+//!
+//! Writes not yet flushed are lost on reset.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "am_util_flash_shadow.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define FLASH_SHADOW_PAGE_WORDS     (AM_HAL_FLASH_PAGE_SIZE / 4)
+#define FLASH_SHADOW_BLANK          0xFFFFFFFF
+
+//*****************************************************************************
+//
+// Program a run of words with the ROM helper.
+//
+//*****************************************************************************
+static uint32_t
+flash_shadow_program(am_util_flash_shadow_t *psShadow, uint32_t ui32Word,
+                     uint32_t ui32NumWords)
+{
+    uint32_t ui32Critical;
+    int iRet;
+
+    ui32Critical = am_hal_interrupt_master_disable();
+    iRet = am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY,
+                                     &psShadow->pui32Page[ui32Word],
+                                     (uint32_t *)(psShadow->ui32PageAddr + ui32Word * 4),
+                                     ui32NumWords);
+    am_hal_interrupt_master_set(ui32Critical);
+
+    psShadow->sStats.ui32WordsProgrammed += ui32NumWords;
+
+    return iRet ? AM_HAL_STATUS_FAIL : AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Clear bits of one flash word with the ROM helper.
+//
+//*****************************************************************************
+static uint32_t
+flash_shadow_clear(am_util_flash_shadow_t *psShadow, uint32_t ui32Word,
+                   uint32_t ui32Mask)
+{
+    uint32_t ui32Critical;
+    int iRet;
+
+    ui32Critical = am_hal_interrupt_master_disable();
+    iRet = am_hal_flash_clear_bits(AM_HAL_FLASH_PROGRAM_KEY,
+                                   (uint32_t *)(psShadow->ui32PageAddr + ui32Word * 4),
+                                   ui32Mask);
+    am_hal_interrupt_master_set(ui32Critical);
+
+    psShadow->sStats.ui32WordsProgrammed++;
+
+    return iRet ? AM_HAL_STATUS_FAIL : AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Program the words in [ui32First, ui32Last) of the shadow, merging up to
+// AM_UTIL_FLASH_SHADOW_MAX_RUN neighbouring words into one helper call.
+// bInPlace selects a page that has not been erased, where only bit clearing
+// is possible.
+//
+//*****************************************************************************
+static uint32_t
+flash_shadow_program_runs(am_util_flash_shadow_t *psShadow,
+                          uint32_t ui32First, uint32_t ui32Last,
+                          bool bInPlace)
+{
+    const uint32_t *pui32Flash = (const uint32_t *)psShadow->ui32PageAddr;
+    uint32_t ui32RunStart = 0;
+    uint32_t ui32RunLength = 0;
+
+    for ( uint32_t i = ui32First; i <= ui32Last; i++ )
+    {
+        bool bProgram = false;
+
+        if ( i < ui32Last )
+        {
+            uint32_t ui32New = psShadow->pui32Page[i];
+
+            //
+            // After an erase, program everything that is not blank.  In place,
+            // only words that are still blank in flash can join a run; others
+            // have their bits cleared one word at a time.
+            //
+            if ( !bInPlace )
+            {
+                bProgram = (ui32New != FLASH_SHADOW_BLANK);
+            }
+            else if ( ui32New != pui32Flash[i] )
+            {
+                if ( pui32Flash[i] == FLASH_SHADOW_BLANK )
+                {
+                    bProgram = true;
+                }
+                else if ( flash_shadow_clear(psShadow, i, pui32Flash[i] & ~ui32New) !=
+                          AM_HAL_STATUS_SUCCESS )
+                {
+                    return AM_HAL_STATUS_FAIL;
+                }
+            }
+        }
+
+        if ( bProgram )
+        {
+            if ( ui32RunLength == 0 )
+            {
+                ui32RunStart = i;
+            }
+            ui32RunLength++;
+        }
+
+        if ( ui32RunLength &&
+             (!bProgram || (ui32RunLength == AM_UTIL_FLASH_SHADOW_MAX_RUN)) )
+        {
+            if ( flash_shadow_program(psShadow, ui32RunStart, ui32RunLength) !=
+                 AM_HAL_STATUS_SUCCESS )
+            {
+                return AM_HAL_STATUS_FAIL;
+            }
+            ui32RunLength = 0;
+        }
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Initialize a shadow.  pui32PageBuffer must hold AM_HAL_FLASH_PAGE_SIZE
+// bytes.
+//
+//*****************************************************************************
+uint32_t
+am_util_flash_shadow_init(am_util_flash_shadow_t *psShadow,
+                          uint32_t *pui32PageBuffer)
+{
+    if ( (psShadow == NULL) || (pui32PageBuffer == NULL) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    psShadow->pui32Page = pui32PageBuffer;
+    psShadow->ui32PageAddr = AM_UTIL_FLASH_SHADOW_NO_PAGE;
+    psShadow->ui32DirtyFirst = FLASH_SHADOW_PAGE_WORDS;
+    psShadow->ui32DirtyLast = 0;
+    psShadow->sStats = (am_util_flash_shadow_stats_t) { 0 };
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Write the shadowed page back to flash if it has changed.
+//
+//*****************************************************************************
+uint32_t
+am_util_flash_shadow_flush(am_util_flash_shadow_t *psShadow)
+{
+    const uint32_t *pui32Flash;
+    uint32_t ui32First = psShadow->ui32DirtyFirst;
+    uint32_t ui32Last = psShadow->ui32DirtyLast;
+    bool bErase = false;
+    uint32_t ui32Status;
+
+    if ( ui32First >= ui32Last )
+    {
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    psShadow->sStats.ui32Flushes++;
+
+    //
+    // Flash bits can only be cleared without an erase.
+    //
+    pui32Flash = (const uint32_t *)psShadow->ui32PageAddr;
+    for ( uint32_t i = ui32First; i < ui32Last; i++ )
+    {
+        if ( psShadow->pui32Page[i] & ~pui32Flash[i] )
+        {
+            bErase = true;
+            break;
+        }
+    }
+
+    if ( !bErase )
+    {
+        ui32Status = flash_shadow_program_runs(psShadow, ui32First, ui32Last, true);
+    }
+    else
+    {
+        //
+        // The shadow still holds the rest of the page as loaded, so the whole
+        // page is rewritten from it.
+        //
+        uint32_t ui32Critical = am_hal_interrupt_master_disable();
+        int iRet = am_hal_flash_page_erase(AM_HAL_FLASH_PROGRAM_KEY,
+                                           AM_HAL_FLASH_ADDR2INST(psShadow->ui32PageAddr),
+                                           AM_HAL_FLASH_ADDR2PAGE(psShadow->ui32PageAddr));
+        am_hal_interrupt_master_set(ui32Critical);
+
+        psShadow->sStats.ui32Erases++;
+        if ( iRet )
+        {
+            return AM_HAL_STATUS_FAIL;
+        }
+
+        psShadow->ui32DirtyFirst = 0;
+        psShadow->ui32DirtyLast = FLASH_SHADOW_PAGE_WORDS;
+        ui32Status = flash_shadow_program_runs(psShadow, 0,
+                                               FLASH_SHADOW_PAGE_WORDS, false);
+    }
+
+    //
+    // On failure the page stays dirty so the flush can be retried.
+    //
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        psShadow->ui32DirtyFirst = FLASH_SHADOW_PAGE_WORDS;
+        psShadow->ui32DirtyLast = 0;
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Write to flash through the shadow.  Writes to a page other than the
+// shadowed one flush the shadow first.
+//
+//*****************************************************************************
+uint32_t
+am_util_flash_shadow_write(am_util_flash_shadow_t *psShadow,
+                           uint32_t ui32Addr,
+                           const void *pData,
+                           uint32_t ui32NumBytes)
+{
+    const uint8_t *pui8Data = pData;
+
+    if ( (psShadow == NULL) || ((pData == NULL) && ui32NumBytes) ||
+         (ui32Addr > AM_HAL_FLASH_LARGEST_VALID_ADDR) ||
+         (ui32NumBytes > AM_HAL_FLASH_LARGEST_VALID_ADDR - ui32Addr + 1) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    while ( ui32NumBytes )
+    {
+        uint32_t ui32PageAddr = ui32Addr & ~(AM_HAL_FLASH_PAGE_SIZE - 1);
+        uint32_t ui32Offset = ui32Addr - ui32PageAddr;
+        uint32_t ui32Chunk = AM_HAL_FLASH_PAGE_SIZE - ui32Offset;
+
+        if ( ui32Chunk > ui32NumBytes )
+        {
+            ui32Chunk = ui32NumBytes;
+        }
+
+        if ( ui32PageAddr != psShadow->ui32PageAddr )
+        {
+            uint32_t ui32Status = am_util_flash_shadow_flush(psShadow);
+
+            if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+            {
+                return ui32Status;
+            }
+
+            memcpy(psShadow->pui32Page, (const void *)ui32PageAddr,
+                   AM_HAL_FLASH_PAGE_SIZE);
+            psShadow->ui32PageAddr = ui32PageAddr;
+        }
+
+        memcpy((uint8_t *)psShadow->pui32Page + ui32Offset, pui8Data, ui32Chunk);
+        psShadow->sStats.ui32BytesWritten += ui32Chunk;
+
+        if ( ui32Offset / 4 < psShadow->ui32DirtyFirst )
+        {
+            psShadow->ui32DirtyFirst = ui32Offset / 4;
+        }
+        if ( (ui32Offset + ui32Chunk + 3) / 4 > psShadow->ui32DirtyLast )
+        {
+            psShadow->ui32DirtyLast = (ui32Offset + ui32Chunk + 3) / 4;
+        }
+
+        ui32Addr += ui32Chunk;
+        pui8Data += ui32Chunk;
+        ui32NumBytes -= ui32Chunk;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Read flash through the shadow, so that unflushed writes are visible.
+//
+//*****************************************************************************
+uint32_t
+am_util_flash_shadow_read(am_util_flash_shadow_t *psShadow,
+                          uint32_t ui32Addr,
+                          void *pData,
+                          uint32_t ui32NumBytes)
+{
+    uint8_t *pui8Data = pData;
+
+    if ( (psShadow == NULL) || ((pData == NULL) && ui32NumBytes) ||
+         (ui32Addr > AM_HAL_FLASH_LARGEST_VALID_ADDR) ||
+         (ui32NumBytes > AM_HAL_FLASH_LARGEST_VALID_ADDR - ui32Addr + 1) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    while ( ui32NumBytes )
+    {
+        uint32_t ui32PageAddr = ui32Addr & ~(AM_HAL_FLASH_PAGE_SIZE - 1);
+        uint32_t ui32Offset = ui32Addr - ui32PageAddr;
+        uint32_t ui32Chunk = AM_HAL_FLASH_PAGE_SIZE - ui32Offset;
+
+        if ( ui32Chunk > ui32NumBytes )
+        {
+            ui32Chunk = ui32NumBytes;
+        }
+
+        if ( ui32PageAddr == psShadow->ui32PageAddr )
+        {
+            memcpy(pui8Data, (uint8_t *)psShadow->pui32Page + ui32Offset, ui32Chunk);
+        }
+        else
+        {
+            memcpy(pui8Data, (const void *)ui32Addr, ui32Chunk);
+        }
+
+        ui32Addr += ui32Chunk;
+        pui8Data += ui32Chunk;
+        ui32NumBytes -= ui32Chunk;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
@@ -0,0 +1,141 @@
+//*****************************************************************************
+//
+//! @file am_util_flash_shadow.h
+//!
+//! @brief Write coalescing layer for internal flash.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_FLASH_SHADOW_H
+#define AM_UTIL_FLASH_SHADOW_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Interrupt latency
+//
+// Interrupts are disabled around each BOOTROM helper call, since no code may
+// run from flash while the array is busy.  The longest such call is a page
+// erase, so a flush that has to erase delays every interrupt by up to the
+// part's page erase time, several milliseconds.  Program calls are split
+// into runs of at most AM_UTIL_FLASH_SHADOW_MAX_RUN words, so the page
+// rewrite after an erase does not hold interrupts off for longer than that.
+// Writes that only clear bits never erase.  Writes within the shadowed page
+// never touch the flash; flushes happen on am_util_flash_shadow_flush() and
+// on a write to another page, so call those where the latency is acceptable.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_FLASH_SHADOW_MAX_RUN
+#define AM_UTIL_FLASH_SHADOW_MAX_RUN    64
+#endif
+
+//*****************************************************************************
+//
+//! Value of am_util_flash_shadow_t.ui32PageAddr when no page is shadowed.
+//
+//*****************************************************************************
+#define AM_UTIL_FLASH_SHADOW_NO_PAGE    0xFFFFFFFF
+
+//*****************************************************************************
+//
+//! Write statistics.  Write amplification is
+//! ui32WordsProgrammed * 4 / ui32BytesWritten.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t                ui32BytesWritten;
+    uint32_t                ui32Flushes;
+    uint32_t                ui32Erases;
+    uint32_t                ui32WordsProgrammed;
+} am_util_flash_shadow_stats_t;
+
+//*****************************************************************************
+//
+//! Shadow state.  Allocated by the caller.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! RAM copy of one flash page, AM_HAL_FLASH_PAGE_SIZE bytes.
+    //
+    uint32_t                *pui32Page;
+
+    //
+    //! Flash address of the shadowed page.
+    //
+    uint32_t                ui32PageAddr;
+
+    //
+    //! Word range of the page written since the last flush, [first, last).
+    //
+    uint32_t                ui32DirtyFirst;
+    uint32_t                ui32DirtyLast;
+
+    am_util_flash_shadow_stats_t sStats;
+} am_util_flash_shadow_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_flash_shadow_init(am_util_flash_shadow_t *psShadow,
+                                          uint32_t *pui32PageBuffer);
+extern uint32_t am_util_flash_shadow_write(am_util_flash_shadow_t *psShadow,
+                                           uint32_t ui32Addr,
+                                           const void *pData,
+                                           uint32_t ui32NumBytes);
+extern uint32_t am_util_flash_shadow_read(am_util_flash_shadow_t *psShadow,
+                                          uint32_t ui32Addr,
+                                          void *pData,
+                                          uint32_t ui32NumBytes);
+extern uint32_t am_util_flash_shadow_flush(am_util_flash_shadow_t *psShadow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_FLASH_SHADOW_H
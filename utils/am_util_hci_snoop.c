@@ -0,0 +1,391 @@
+//*****************************************************************************
+//
+//! @file am_util_hci_snoop.c
+//!
+//! @brief HCI packet capture in btsnoop format.
+//!
+//! Records HCI packets into a RAM ring with very little overhead, and drains
+//! them later as a btsnoop stream that Wireshark can open.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "am_util_hci_snoop.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+//
+// btsnoop datalink type for H4 framed HCI (the packet type byte is included
+// with each record).
+//
+#define SNOOP_DATALINK_H4               1002
+
+//
+// btsnoop record flags.
+//
+#define SNOOP_FLAG_RECEIVED             0x01
+#define SNOOP_FLAG_CMD_EVT              0x02
+
+//
+// btsnoop timestamps count microseconds from midnight, January 1st, 0 AD.
+// Captures are reported relative to January 1st, 1970.
+//
+#define SNOOP_EPOCH_DELTA_US            0x00DCDDB30F2F8000ULL
+
+//
+// H4 packet types that btsnoop flags as command/event.
+//
+#define SNOOP_H4_CMD                    0x01
+#define SNOOP_H4_EVT                    0x04
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+//
+// Capture ring.  Producers reserve records with LDREX/STREX on ui32Head, so
+// the task and interrupt context may record at the same time.  The single
+// reader owns ui32Tail.
+//
+static struct
+{
+    uint8_t                 *pui8Buffer;
+    uint32_t                ui32RecordSize;
+    uint32_t                ui32SnapLen;
+    uint32_t                ui32Mask;
+    uint32_t                ui32TimerHz;
+    volatile uint32_t       ui32Head;
+    volatile uint32_t       ui32Tail;
+    volatile uint32_t       ui32Dropped;
+    uint64_t                ui64LastTicks;
+    volatile bool           bEnabled;
+    bool                    bHeaderPending;
+} g_sHciSnoop;
+
+//*****************************************************************************
+//
+// Store a 32-bit value big-endian.
+//
+//*****************************************************************************
+static void
+put_be32(uint8_t *pui8Dest, uint32_t ui32Value)
+{
+    pui8Dest[0] = (uint8_t)(ui32Value >> 24);
+    pui8Dest[1] = (uint8_t)(ui32Value >> 16);
+    pui8Dest[2] = (uint8_t)(ui32Value >> 8);
+    pui8Dest[3] = (uint8_t)ui32Value;
+}
+
+//*****************************************************************************
+//
+// Count a dropped packet.  May be called from any context.
+//
+//*****************************************************************************
+static void
+count_drop(void)
+{
+    uint32_t ui32Dropped;
+
+    do
+    {
+        ui32Dropped = __LDREXW(&g_sHciSnoop.ui32Dropped);
+    } while ( __STREXW(ui32Dropped + 1, &g_sHciSnoop.ui32Dropped) );
+}
+
+//*****************************************************************************
+//
+// Set up the capture ring and start recording.
+//
+// The buffer is divided into fixed-size records; the number of records is
+// rounded down to a power of 2.
+//
+//*****************************************************************************
+uint32_t
+am_util_hci_snoop_init(const am_util_hci_snoop_config_t *psConfig)
+{
+    uint32_t ui32RecordSize;
+    uint32_t ui32NumRecords;
+
+    if ( (psConfig == NULL) || (psConfig->pvBuffer == NULL) ||
+         ((uint32_t)psConfig->pvBuffer & 0x3) ||
+         (psConfig->ui32SnapLen == 0) || (psConfig->ui32SnapLen > 0xFFFF) ||
+         (psConfig->ui32TimerHz == 0) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    ui32RecordSize = AM_UTIL_HCI_SNOOP_RECORD_SIZE(psConfig->ui32SnapLen);
+    ui32NumRecords = psConfig->ui32BufferSize / ui32RecordSize;
+
+    if ( ui32NumRecords == 0 )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    while ( ui32NumRecords & (ui32NumRecords - 1) )
+    {
+        ui32NumRecords &= ui32NumRecords - 1;
+    }
+
+    //
+    // Stop recording while the ring is rebuilt.
+    //
+    g_sHciSnoop.bEnabled = false;
+    g_sHciSnoop.pui8Buffer = NULL;
+    __DMB();
+
+    //
+    // A zero sequence number never matches a live record, so stale data in
+    // the buffer can't be mistaken for a capture.
+    //
+    for ( uint32_t i = 0; i < ui32NumRecords; i++ )
+    {
+        ((am_util_hci_snoop_record_t *)
+         ((uint8_t *)psConfig->pvBuffer + i * ui32RecordSize))->ui32Seq = 0;
+    }
+
+    AM_CRITICAL_BEGIN
+    g_sHciSnoop.ui32RecordSize = ui32RecordSize;
+    g_sHciSnoop.ui32SnapLen = psConfig->ui32SnapLen;
+    g_sHciSnoop.ui32Mask = ui32NumRecords - 1;
+    g_sHciSnoop.ui32TimerHz = psConfig->ui32TimerHz;
+    g_sHciSnoop.ui32Head = 0;
+    g_sHciSnoop.ui32Tail = 0;
+    g_sHciSnoop.ui32Dropped = 0;
+    g_sHciSnoop.ui64LastTicks = am_hal_stimer_counter_get();
+    g_sHciSnoop.bHeaderPending = true;
+    g_sHciSnoop.bEnabled = true;
+    __DMB();
+    g_sHciSnoop.pui8Buffer = psConfig->pvBuffer;
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Stop recording.  Records already in the ring can still be drained.
+//
+//*****************************************************************************
+void
+am_util_hci_snoop_disable(void)
+{
+    g_sHciSnoop.bEnabled = false;
+}
+
+//*****************************************************************************
+//
+// Record one HCI packet.
+//
+// ui8Type is the H4 packet type and pui8Data/ui32Length the packet that
+// follows it.  Safe to call from any context; if the ring is full the packet
+// is counted as dropped.
+//
+//*****************************************************************************
+void
+am_util_hci_snoop_record(uint32_t ui32Direction, uint8_t ui8Type,
+                         const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    am_util_hci_snoop_record_t *psRecord;
+    uint32_t ui32Head;
+
+    if ( (g_sHciSnoop.pui8Buffer == NULL) || !g_sHciSnoop.bEnabled )
+    {
+        return;
+    }
+
+    //
+    // Reserve a record.
+    //
+    do
+    {
+        ui32Head = __LDREXW(&g_sHciSnoop.ui32Head);
+
+        if ( ui32Head - g_sHciSnoop.ui32Tail > g_sHciSnoop.ui32Mask )
+        {
+            __CLREX();
+            count_drop();
+            return;
+        }
+    } while ( __STREXW(ui32Head + 1, &g_sHciSnoop.ui32Head) );
+
+    psRecord = (am_util_hci_snoop_record_t *)
+        (g_sHciSnoop.pui8Buffer +
+         (ui32Head & g_sHciSnoop.ui32Mask) * g_sHciSnoop.ui32RecordSize);
+
+    psRecord->ui32Timestamp = am_hal_stimer_counter_get();
+    psRecord->ui16Length = (uint16_t)ui32Length;
+    psRecord->ui8Type = ui8Type;
+    psRecord->ui8Direction = (uint8_t)ui32Direction;
+
+    //
+    // The H4 type byte takes one byte of the snap length.
+    //
+    if ( ui32Length > g_sHciSnoop.ui32SnapLen - 1 )
+    {
+        ui32Length = g_sHciSnoop.ui32SnapLen - 1;
+    }
+
+    memcpy(psRecord + 1, pui8Data, ui32Length);
+
+    //
+    // Publish the record only after it has been written.
+    //
+    __DMB();
+    psRecord->ui32Seq = ui32Head + 1;
+}
+
+//*****************************************************************************
+//
+// Send recorded packets through pfnWrite in btsnoop format.
+//
+// The btsnoop file header is sent before the first record after
+// am_util_hci_snoop_init().  Draining stops at the first record that is still
+// being written, or after ui32MaxRecords records (0 for no limit).  Returns
+// the number of records sent.
+//
+//*****************************************************************************
+uint32_t
+am_util_hci_snoop_drain(am_util_hci_snoop_write_t pfnWrite, void *pvContext,
+                        uint32_t ui32MaxRecords)
+{
+    uint8_t pui8Hdr[25];
+    uint32_t ui32Count = 0;
+
+    if ( (pfnWrite == NULL) || (g_sHciSnoop.pui8Buffer == NULL) )
+    {
+        return 0;
+    }
+
+    if ( g_sHciSnoop.bHeaderPending )
+    {
+        memcpy(pui8Hdr, "btsnoop", 8);
+        put_be32(&pui8Hdr[8], 1);
+        put_be32(&pui8Hdr[12], SNOOP_DATALINK_H4);
+        pfnWrite(pvContext, pui8Hdr, 16);
+        g_sHciSnoop.bHeaderPending = false;
+    }
+
+    while ( (ui32MaxRecords == 0) || (ui32Count < ui32MaxRecords) )
+    {
+        uint32_t ui32Tail = g_sHciSnoop.ui32Tail;
+        am_util_hci_snoop_record_t *psRecord = (am_util_hci_snoop_record_t *)
+            (g_sHciSnoop.pui8Buffer +
+             (ui32Tail & g_sHciSnoop.ui32Mask) * g_sHciSnoop.ui32RecordSize);
+        uint32_t ui32Captured;
+        uint32_t ui32Flags;
+        uint64_t ui64Us;
+
+        if ( psRecord->ui32Seq != ui32Tail + 1 )
+        {
+            break;
+        }
+
+        __DMB();
+
+        //
+        // Extend the timestamp.  Records can be a little out of order when
+        // an interrupt records a packet, so treat the difference as signed.
+        //
+        g_sHciSnoop.ui64LastTicks +=
+            (int32_t)(psRecord->ui32Timestamp - (uint32_t)g_sHciSnoop.ui64LastTicks);
+
+        ui64Us = (g_sHciSnoop.ui64LastTicks / g_sHciSnoop.ui32TimerHz) * 1000000 +
+                 ((g_sHciSnoop.ui64LastTicks % g_sHciSnoop.ui32TimerHz) * 1000000) /
+                 g_sHciSnoop.ui32TimerHz;
+        ui64Us += SNOOP_EPOCH_DELTA_US;
+
+        ui32Captured = psRecord->ui16Length;
+        if ( ui32Captured > g_sHciSnoop.ui32SnapLen - 1 )
+        {
+            ui32Captured = g_sHciSnoop.ui32SnapLen - 1;
+        }
+
+        ui32Flags = (psRecord->ui8Direction == AM_UTIL_HCI_SNOOP_RECEIVED) ?
+                    SNOOP_FLAG_RECEIVED : 0;
+        if ( (psRecord->ui8Type == SNOOP_H4_CMD) ||
+             (psRecord->ui8Type == SNOOP_H4_EVT) )
+        {
+            ui32Flags |= SNOOP_FLAG_CMD_EVT;
+        }
+
+        put_be32(&pui8Hdr[0], psRecord->ui16Length + 1);
+        put_be32(&pui8Hdr[4], ui32Captured + 1);
+        put_be32(&pui8Hdr[8], ui32Flags);
+        put_be32(&pui8Hdr[12], g_sHciSnoop.ui32Dropped);
+        put_be32(&pui8Hdr[16], (uint32_t)(ui64Us >> 32));
+        put_be32(&pui8Hdr[20], (uint32_t)ui64Us);
+        pui8Hdr[24] = psRecord->ui8Type;
+
+        pfnWrite(pvContext, pui8Hdr, sizeof(pui8Hdr));
+        if ( ui32Captured )
+        {
+            pfnWrite(pvContext, (const uint8_t *)(psRecord + 1), ui32Captured);
+        }
+
+        //
+        // Hand the record back to the producers.
+        //
+        __DMB();
+        g_sHciSnoop.ui32Tail = ui32Tail + 1;
+        ui32Count++;
+    }
+
+    return ui32Count;
+}
+
+//*****************************************************************************
+//
+// Returns the number of packets dropped because the ring was full.
+//
+//*****************************************************************************
+uint32_t
+am_util_hci_snoop_dropped(void)
+{
+    return g_sHciSnoop.ui32Dropped;
+}
@@ -0,0 +1,167 @@
+//*****************************************************************************
+//
+//! @file am_util_hci_snoop.h
+//!
+//! @brief HCI packet capture in btsnoop format.
+//!
+//! Records HCI packets into a RAM ring with very little overhead, and drains
+//! them later as a btsnoop stream that Wireshark can open.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_HCI_SNOOP_H
+#define AM_UTIL_HCI_SNOOP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+//
+// Packet direction, as seen from the host.
+//
+#define AM_UTIL_HCI_SNOOP_SENT          0
+#define AM_UTIL_HCI_SNOOP_RECEIVED      1
+
+//
+// Bytes of ring storage needed for one record with the given snap length.
+//
+#define AM_UTIL_HCI_SNOOP_RECORD_SIZE(snaplen)                              \
+    (sizeof(am_util_hci_snoop_record_t) + (((snaplen) + 3) & ~3))
+
+//*****************************************************************************
+//
+//! Ring record header.  The captured packet bytes follow it.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Set to the record's sequence number plus one once the record is
+    //! complete.
+    //
+    volatile uint32_t       ui32Seq;
+
+    //
+    //! STIMER count when the packet was recorded.
+    //
+    uint32_t                ui32Timestamp;
+
+    //
+    //! Original packet length, not counting the H4 packet type.
+    //
+    uint16_t                ui16Length;
+
+    //
+    //! H4 packet type.
+    //
+    uint8_t                 ui8Type;
+
+    //
+    //! AM_UTIL_HCI_SNOOP_SENT or AM_UTIL_HCI_SNOOP_RECEIVED.
+    //
+    uint8_t                 ui8Direction;
+} am_util_hci_snoop_record_t;
+
+//*****************************************************************************
+//
+//! Capture configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Ring storage, word aligned.  Any memory the CPU can write directly
+    //! works, including PSRAM mapped through the MSPI XIP aperture.
+    //
+    void                    *pvBuffer;
+
+    //
+    //! Size of pvBuffer in bytes.
+    //
+    uint32_t                ui32BufferSize;
+
+    //
+    //! Maximum packet bytes kept per record.  Longer packets are truncated,
+    //! but their original length is still reported.
+    //
+    uint32_t                ui32SnapLen;
+
+    //
+    //! STIMER frequency in Hz, used to convert timestamps when draining.
+    //
+    uint32_t                ui32TimerHz;
+} am_util_hci_snoop_config_t;
+
+//*****************************************************************************
+//
+//! Function used to send drained btsnoop data (to a UART, ITM, a BLE
+//! characteristic...).
+//
+//*****************************************************************************
+typedef void (*am_util_hci_snoop_write_t)(void *pvContext,
+                                          const uint8_t *pui8Data,
+                                          uint32_t ui32Length);
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_hci_snoop_init(const am_util_hci_snoop_config_t *psConfig);
+extern void am_util_hci_snoop_disable(void);
+extern void am_util_hci_snoop_record(uint32_t ui32Direction, uint8_t ui8Type,
+                                     const uint8_t *pui8Data,
+                                     uint32_t ui32Length);
+extern uint32_t am_util_hci_snoop_drain(am_util_hci_snoop_write_t pfnWrite,
+                                        void *pvContext,
+                                        uint32_t ui32MaxRecords);
+extern uint32_t am_util_hci_snoop_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_HCI_SNOOP_H
@@ -0,0 +1,749 @@
+//*****************************************************************************
+//
+//! @file am_util_iom_arbiter.c
+//!
+//! @brief Priority aware scheduler for devices sharing one IOM.
+//!
+//! Each device on the bus registers as a client with its own request queue.
+//! Requests are issued to the IOM one chunk at a time, so a short high
+//! priority transfer can run between the chunks of a long burst from another
+//! client.  A client passed over too many times is served next regardless of
+//! priority, which bounds starvation.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_mcu_apollo.h"
+#include "am_util_iom_arbiter.h"
+
+//*****************************************************************************
+//
+// Forward declarations.
+//
+//*****************************************************************************
+static am_util_iom_arbiter_request_t *arbiter_issue(am_util_iom_arbiter_t *pArbiter);
+
+//*****************************************************************************
+//
+// Returns true if request A should run before request B based on deadline.
+//
+//*****************************************************************************
+static bool
+arbiter_deadline_before(am_util_iom_arbiter_request_t *pA,
+                        am_util_iom_arbiter_request_t *pB)
+{
+    if (pA->ui32Deadline == 0)
+    {
+        return false;
+    }
+    if (pB->ui32Deadline == 0)
+    {
+        return true;
+    }
+    return (int32_t)(pA->ui32Deadline - pB->ui32Deadline) < 0;
+}
+
+//*****************************************************************************
+//
+// Insert a request in its client queue.  The queue is kept in priority order;
+// bHead places the request ahead of others with the same priority (used for
+// the remainder of a split request), otherwise it goes behind them.  Must be
+// called in a critical section.
+//
+//*****************************************************************************
+static void
+arbiter_enqueue(am_util_iom_arbiter_client_t *pClient,
+                am_util_iom_arbiter_request_t *pRequest, bool bHead)
+{
+    am_util_iom_arbiter_request_t **ppLink = &pClient->pHead;
+
+    while (*ppLink)
+    {
+        uint32_t ui32Priority = (*ppLink)->ui32Priority;
+
+        if (bHead ? (ui32Priority <= pRequest->ui32Priority) :
+                    (ui32Priority < pRequest->ui32Priority))
+        {
+            break;
+        }
+        ppLink = &(*ppLink)->pNext;
+    }
+
+    pRequest->pNext = *ppLink;
+    *ppLink = pRequest;
+    if (pRequest->pNext == NULL)
+    {
+        pClient->pTail = pRequest;
+    }
+}
+
+//*****************************************************************************
+//
+// Pick the client to serve next.  Must be called in a critical section.
+//
+//*****************************************************************************
+static am_util_iom_arbiter_client_t *
+arbiter_select(am_util_iom_arbiter_t *pArbiter)
+{
+    am_util_iom_arbiter_client_t *pClient;
+    am_util_iom_arbiter_client_t *pBest = NULL;
+    uint32_t ui32MaxSkips = pArbiter->sConfig.ui32MaxSkips;
+
+    for (pClient = pArbiter->pClients; pClient != NULL; pClient = pClient->pNext)
+    {
+        bool bStarved, bBestStarved;
+
+        if (pClient->pHead == NULL)
+        {
+            continue;
+        }
+        if (pBest == NULL)
+        {
+            pBest = pClient;
+            continue;
+        }
+
+        bStarved = (pClient->ui32Skipped >= ui32MaxSkips);
+        bBestStarved = (pBest->ui32Skipped >= ui32MaxSkips);
+        if (bStarved != bBestStarved)
+        {
+            if (bStarved)
+            {
+                pBest = pClient;
+            }
+        }
+        else if (bStarved)
+        {
+            if (pClient->ui32Skipped > pBest->ui32Skipped)
+            {
+                pBest = pClient;
+            }
+        }
+        else if (pClient->pHead->ui32Priority != pBest->pHead->ui32Priority)
+        {
+            if (pClient->pHead->ui32Priority > pBest->pHead->ui32Priority)
+            {
+                pBest = pClient;
+            }
+        }
+        else if (arbiter_deadline_before(pClient->pHead, pBest->pHead))
+        {
+            pBest = pClient;
+        }
+    }
+
+    if (pBest == NULL)
+    {
+        return NULL;
+    }
+
+    //
+    // Age everyone who had work and was passed over.
+    //
+    for (pClient = pArbiter->pClients; pClient != NULL; pClient = pClient->pNext)
+    {
+        if ((pClient != pBest) && (pClient->pHead != NULL))
+        {
+            pClient->ui32Skipped++;
+        }
+    }
+    pBest->ui32Skipped = 0;
+
+    return pBest;
+}
+
+//*****************************************************************************
+//
+// Latency histogram bin of a value, and the largest value held by a bin.
+//
+//*****************************************************************************
+static uint32_t
+arbiter_latency_bin(uint32_t ui32Latency)
+{
+    uint32_t ui32Msb, ui32Bin;
+
+    if (ui32Latency < 8)
+    {
+        return ui32Latency;
+    }
+
+#ifdef __IAR_SYSTEMS_ICC__
+    ui32Msb = 31 - __CLZ(ui32Latency);
+#else
+    ui32Msb = 31 - __builtin_clz(ui32Latency);
+#endif
+    ui32Bin = (ui32Msb - 1) * 4 + ((ui32Latency >> (ui32Msb - 2)) & 0x3);
+
+    return (ui32Bin < AM_UTIL_IOM_ARBITER_LATENCY_BINS) ?
+           ui32Bin : (AM_UTIL_IOM_ARBITER_LATENCY_BINS - 1);
+}
+
+static uint32_t
+arbiter_latency_bin_max(uint32_t ui32Bin)
+{
+    uint32_t ui32Shift;
+
+    if (ui32Bin < 8)
+    {
+        return ui32Bin;
+    }
+
+    ui32Shift = ui32Bin / 4 - 1;
+    return ((4 + (ui32Bin & 0x3) + 1) << ui32Shift) - 1;
+}
+
+//*****************************************************************************
+//
+// Record statistics and notify the owner of a finished request.
+//
+//*****************************************************************************
+static void
+arbiter_complete(am_util_iom_arbiter_t *pArbiter,
+                 am_util_iom_arbiter_request_t *pRequest)
+{
+    am_util_iom_arbiter_client_t *pClient = pRequest->pClient;
+
+    if (pRequest->ui32Status != AM_HAL_STATUS_SUCCESS)
+    {
+        pClient->ui32Errors++;
+    }
+    pClient->ui32Completed++;
+
+    if (pArbiter->sConfig.pfnTimeGet)
+    {
+        uint32_t ui32Now = pArbiter->sConfig.pfnTimeGet();
+        uint32_t ui32Latency = ui32Now - pRequest->ui32Submitted;
+
+        pClient->ui64TotalLatency += ui32Latency;
+        pClient->ui32LatencyHist[arbiter_latency_bin(ui32Latency)]++;
+        if (ui32Latency > pClient->ui32MaxLatency)
+        {
+            pClient->ui32MaxLatency = ui32Latency;
+        }
+        if (pRequest->ui32Deadline &&
+            ((int32_t)(ui32Now - pRequest->ui32Deadline) > 0))
+        {
+            pClient->ui32MissedDeadlines++;
+        }
+    }
+
+    if (pRequest->pfnCallback)
+    {
+        pRequest->pfnCallback(pRequest->pCallbackCtxt, pRequest->ui32Status);
+    }
+}
+
+//*****************************************************************************
+//
+// Complete a list of requests (linked through pNext) in order.
+//
+//*****************************************************************************
+static void
+arbiter_complete_list(am_util_iom_arbiter_t *pArbiter,
+                      am_util_iom_arbiter_request_t *pList)
+{
+    while (pList)
+    {
+        am_util_iom_arbiter_request_t *pRequest = pList;
+
+        pList = pList->pNext;
+        arbiter_complete(pArbiter, pRequest);
+    }
+}
+
+//*****************************************************************************
+//
+// Build the next chunk of the active request.
+//
+//*****************************************************************************
+static void
+arbiter_chunk_build(am_util_iom_arbiter_t *pArbiter,
+                    am_util_iom_arbiter_request_t *pRequest,
+                    am_hal_iom_transfer_t *psChunk)
+{
+    uint32_t ui32Remaining;
+
+    *psChunk = pRequest->sTransfer;
+
+    if (pRequest->ui32Status != AM_HAL_STATUS_SUCCESS)
+    {
+        //
+        // The request failed in the middle of a bContinue chain.  Close the
+        // chain with an empty write so the IOM releases CS.
+        //
+        psChunk->eDirection = AM_HAL_IOM_TX;
+        psChunk->ui32InstrLen = 0;
+        psChunk->ui32Instr = 0;
+        psChunk->ui32NumBytes = 0;
+        psChunk->bContinue = false;
+        psChunk->ui8RepeatCount = 0;
+        psChunk->ui32PauseCondition = 0;
+        psChunk->ui32StatusSetClr = 0;
+        return;
+    }
+
+    //
+    // The chunk size is a word multiple, so the buffer offset always lands
+    // on a word boundary.
+    //
+    ui32Remaining = pRequest->sTransfer.ui32NumBytes - pRequest->ui32Offset;
+    psChunk->ui32NumBytes = (ui32Remaining > pArbiter->sConfig.ui32MaxChunk) ?
+                            pArbiter->sConfig.ui32MaxChunk : ui32Remaining;
+    if (psChunk->eDirection == AM_HAL_IOM_TX)
+    {
+        psChunk->pui32TxBuffer = pRequest->sTransfer.pui32TxBuffer + pRequest->ui32Offset / 4;
+    }
+    else
+    {
+        psChunk->pui32RxBuffer = pRequest->sTransfer.pui32RxBuffer + pRequest->ui32Offset / 4;
+    }
+
+    if (pRequest->bAdvanceInstr)
+    {
+        psChunk->ui32Instr = pRequest->sTransfer.ui32Instr + pRequest->ui32Offset;
+    }
+    else
+    {
+        if (pRequest->ui32Offset)
+        {
+            psChunk->ui32InstrLen = 0;
+        }
+        if (psChunk->ui32NumBytes < ui32Remaining)
+        {
+            psChunk->bContinue = true;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// IOM completion callback for one chunk.
+//
+//*****************************************************************************
+static void
+arbiter_chunk_done(void *pCallbackCtxt, uint32_t ui32Status)
+{
+    am_util_iom_arbiter_t *pArbiter = (am_util_iom_arbiter_t *)pCallbackCtxt;
+    am_util_iom_arbiter_request_t *pRequest = pArbiter->pActive;
+    am_util_iom_arbiter_request_t *pFailed;
+    bool bDone;
+
+    if (pRequest->ui32Status == AM_HAL_STATUS_SUCCESS)
+    {
+        if (ui32Status == AM_HAL_STATUS_SUCCESS)
+        {
+            pRequest->ui32Offset += pArbiter->ui32ActiveBytes;
+            pArbiter->bCsHeld = pArbiter->bActiveContinue;
+        }
+        else
+        {
+            pRequest->ui32Status = ui32Status;
+            pArbiter->bCsHeld |= pArbiter->bActiveContinue;
+        }
+    }
+    else
+    {
+        //
+        // The chain release finished.  CS is back up either way.
+        //
+        pArbiter->bCsHeld = false;
+    }
+
+    if (pRequest->ui32Status != AM_HAL_STATUS_SUCCESS)
+    {
+        bDone = !pArbiter->bCsHeld;
+    }
+    else
+    {
+        bDone = (pRequest->ui32Offset >= pRequest->sTransfer.ui32NumBytes);
+    }
+
+    AM_CRITICAL_BEGIN
+    if (bDone)
+    {
+        pArbiter->pActive = NULL;
+        pArbiter->pActiveClient = NULL;
+    }
+    else if (pRequest->bAdvanceInstr)
+    {
+        //
+        // Put the remainder back at the head of its queue so that other
+        // clients can be considered before the next chunk.
+        //
+        arbiter_enqueue(pRequest->pClient, pRequest, true);
+        pArbiter->pActive = NULL;
+        pArbiter->pActiveClient = NULL;
+    }
+    pArbiter->bBusy = false;
+    AM_CRITICAL_END
+
+    //
+    // Keep the bus busy before running the owners' callbacks.
+    //
+    pFailed = arbiter_issue(pArbiter);
+
+    if (bDone)
+    {
+        arbiter_complete(pArbiter, pRequest);
+    }
+    arbiter_complete_list(pArbiter, pFailed);
+}
+
+//*****************************************************************************
+//
+// Issue the next chunk if the bus is free.  Requests the IOM refuses are
+// removed and returned as a list, in the order they failed, for the caller to
+// complete once the arbiter state is consistent.
+//
+//*****************************************************************************
+static am_util_iom_arbiter_request_t *
+arbiter_issue(am_util_iom_arbiter_t *pArbiter)
+{
+    am_util_iom_arbiter_request_t *pFailed = NULL;
+    am_util_iom_arbiter_request_t **ppFailedTail = &pFailed;
+
+    while (1)
+    {
+        am_util_iom_arbiter_request_t *pRequest = NULL;
+        am_hal_iom_transfer_t sChunk;
+        uint32_t ui32Status;
+
+        AM_CRITICAL_BEGIN
+        if (!pArbiter->bBusy)
+        {
+            if (pArbiter->pActive == NULL)
+            {
+                am_util_iom_arbiter_client_t *pClient = arbiter_select(pArbiter);
+
+                if (pClient)
+                {
+                    pArbiter->pActive = pClient->pHead;
+                    pArbiter->pActiveClient = pClient;
+                    pClient->pHead = pClient->pHead->pNext;
+                    if (pClient->pHead == NULL)
+                    {
+                        pClient->pTail = NULL;
+                    }
+                }
+            }
+            pRequest = pArbiter->pActive;
+            if (pRequest)
+            {
+                pArbiter->bBusy = true;
+            }
+        }
+        AM_CRITICAL_END
+
+        if (pRequest == NULL)
+        {
+            break;
+        }
+
+        arbiter_chunk_build(pArbiter, pRequest, &sChunk);
+        pArbiter->ui32ActiveBytes = sChunk.ui32NumBytes;
+        pArbiter->bActiveContinue = sChunk.bContinue;
+
+        ui32Status = am_hal_iom_nonblocking_transfer(pArbiter->sConfig.pIomHandle,
+                                                     &sChunk, arbiter_chunk_done,
+                                                     pArbiter);
+        if (ui32Status == AM_HAL_STATUS_SUCCESS)
+        {
+            break;
+        }
+
+        //
+        // No callback will come for a refused transfer.  A refused chunk
+        // fails the request (a release is tried next if an earlier chunk of
+        // the chain left CS asserted); a refused release is given up on.
+        //
+        if (pRequest->ui32Status == AM_HAL_STATUS_SUCCESS)
+        {
+            pRequest->ui32Status = ui32Status;
+        }
+        else
+        {
+            pArbiter->bCsHeld = false;
+        }
+
+        AM_CRITICAL_BEGIN
+        if (!pArbiter->bCsHeld)
+        {
+            pArbiter->pActive = NULL;
+            pArbiter->pActiveClient = NULL;
+            pRequest->pNext = NULL;
+            *ppFailedTail = pRequest;
+            ppFailedTail = &pRequest->pNext;
+        }
+        pArbiter->bBusy = false;
+        AM_CRITICAL_END
+    }
+
+    return pFailed;
+}
+
+//*****************************************************************************
+//
+//! @brief Initialize an IOM arbiter.
+//!
+//! @param pArbiter - caller allocated arbiter state.
+//! @param psConfig - arbiter configuration.
+//!
+//! The IOM must already be configured and enabled with a non-blocking
+//! transaction buffer.  Once an IOM is under an arbiter, all non-blocking
+//! traffic on it should go through am_util_iom_arbiter_submit().
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+uint32_t
+am_util_iom_arbiter_init(am_util_iom_arbiter_t *pArbiter,
+                         const am_util_iom_arbiter_config_t *psConfig)
+{
+    if (!pArbiter || !psConfig || !psConfig->pIomHandle)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    pArbiter->sConfig = *psConfig;
+    if (pArbiter->sConfig.ui32MaxChunk == 0)
+    {
+        pArbiter->sConfig.ui32MaxChunk = AM_UTIL_IOM_ARBITER_DEFAULT_CHUNK;
+    }
+    pArbiter->sConfig.ui32MaxChunk &= ~0x3;
+    if (pArbiter->sConfig.ui32MaxChunk == 0)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+    if (pArbiter->sConfig.ui32MaxSkips == 0)
+    {
+        pArbiter->sConfig.ui32MaxSkips = AM_UTIL_IOM_ARBITER_DEFAULT_SKIPS;
+    }
+
+    pArbiter->pClients = NULL;
+    pArbiter->pActive = NULL;
+    pArbiter->pActiveClient = NULL;
+    pArbiter->ui32ActiveBytes = 0;
+    pArbiter->bActiveContinue = false;
+    pArbiter->bCsHeld = false;
+    pArbiter->bBusy = false;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Register a client (device) with an arbiter.
+//!
+//! @param pArbiter - arbiter state.
+//! @param pClient  - caller allocated client state.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+uint32_t
+am_util_iom_arbiter_client_add(am_util_iom_arbiter_t *pArbiter,
+                               am_util_iom_arbiter_client_t *pClient)
+{
+    uint32_t i;
+
+    if (!pArbiter || !pClient)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    pClient->ui32Completed = 0;
+    pClient->ui32Errors = 0;
+    pClient->ui32MissedDeadlines = 0;
+    pClient->ui32MaxLatency = 0;
+    pClient->ui64TotalLatency = 0;
+    for (i = 0; i < AM_UTIL_IOM_ARBITER_LATENCY_BINS; i++)
+    {
+        pClient->ui32LatencyHist[i] = 0;
+    }
+    pClient->pHead = NULL;
+    pClient->pTail = NULL;
+    pClient->ui32Skipped = 0;
+
+    AM_CRITICAL_BEGIN
+    pClient->pNext = pArbiter->pClients;
+    pArbiter->pClients = pClient;
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Queue a request for a client.
+//!
+//! @param pArbiter - arbiter state.
+//! @param pClient  - client issuing the request.
+//! @param pRequest - caller allocated request, valid until its callback runs.
+//!
+//! Requests are served by priority across all clients.  Requests from one
+//! client with the same priority complete in order.  The callback runs in the
+//! IOM interrupt context, or before this function returns if the IOM refuses
+//! the transfer.
+//!
+//! @return status - generic or interface specific status.
+//
+//*****************************************************************************
+uint32_t
+am_util_iom_arbiter_submit(am_util_iom_arbiter_t *pArbiter,
+                           am_util_iom_arbiter_client_t *pClient,
+                           am_util_iom_arbiter_request_t *pRequest)
+{
+    if (!pArbiter || !pClient || !pRequest)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+    if (pRequest->sTransfer.ui32NumBytes == 0)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    pRequest->pClient = pClient;
+    pRequest->ui32Offset = 0;
+    pRequest->ui32Status = AM_HAL_STATUS_SUCCESS;
+    pRequest->ui32Submitted = pArbiter->sConfig.pfnTimeGet ?
+                              pArbiter->sConfig.pfnTimeGet() : 0;
+
+    AM_CRITICAL_BEGIN
+    arbiter_enqueue(pClient, pRequest, false);
+    AM_CRITICAL_END
+
+    arbiter_complete_list(pArbiter, arbiter_issue(pArbiter));
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+//! @brief Check whether an arbiter has no queued or active work.
+//!
+//! @param pArbiter - arbiter state.
+//!
+//! @return true if the arbiter is idle.
+//
+//*****************************************************************************
+bool
+am_util_iom_arbiter_idle(am_util_iom_arbiter_t *pArbiter)
+{
+    am_util_iom_arbiter_client_t *pClient;
+    bool bIdle = true;
+
+    AM_CRITICAL_BEGIN
+    if (pArbiter->bBusy || pArbiter->pActive)
+    {
+        bIdle = false;
+    }
+    for (pClient = pArbiter->pClients; bIdle && pClient; pClient = pClient->pNext)
+    {
+        if (pClient->pHead)
+        {
+            bIdle = false;
+        }
+    }
+    AM_CRITICAL_END
+
+    return bIdle;
+}
+
+//*****************************************************************************
+//
+//! @brief Read a latency percentile from a client's histogram.
+//!
+//! @param pClient     - client state.
+//! @param ui32Percent - percentile, 1 to 100.
+//!
+//! The result is the upper edge of the histogram bin holding the percentile
+//! (at most 25% above the exact value), capped at the largest latency seen.
+//!
+//! @return latency in time base ticks, or 0 if nothing completed yet.
+//
+//*****************************************************************************
+uint32_t
+am_util_iom_arbiter_latency_percentile(const am_util_iom_arbiter_client_t *pClient,
+                                       uint32_t ui32Percent)
+{
+    uint32_t ui32Total = 0;
+    uint32_t ui32Rank, ui32Seen, i;
+
+    for (i = 0; i < AM_UTIL_IOM_ARBITER_LATENCY_BINS; i++)
+    {
+        ui32Total += pClient->ui32LatencyHist[i];
+    }
+    if ((ui32Total == 0) || (ui32Percent == 0))
+    {
+        return 0;
+    }
+    if (ui32Percent > 100)
+    {
+        ui32Percent = 100;
+    }
+
+    //
+    // Rank of the percentile sample, rounded up.
+    //
+    ui32Rank = (uint32_t)(((uint64_t)ui32Total * ui32Percent + 99) / 100);
+
+    ui32Seen = 0;
+    for (i = 0; i < AM_UTIL_IOM_ARBITER_LATENCY_BINS; i++)
+    {
+        ui32Seen += pClient->ui32LatencyHist[i];
+        if (ui32Seen >= ui32Rank)
+        {
+            break;
+        }
+    }
+
+    //
+    // The last bin also holds everything beyond its range.
+    //
+    if ((i >= AM_UTIL_IOM_ARBITER_LATENCY_BINS - 1) ||
+        (arbiter_latency_bin_max(i) > pClient->ui32MaxLatency))
+    {
+        return pClient->ui32MaxLatency;
+    }
+
+    return arbiter_latency_bin_max(i);
+}
@@ -0,0 +1,233 @@
+//*****************************************************************************
+//
+//! @file am_util_iom_arbiter.h
+//!
+//! @brief Priority aware scheduler for devices sharing one IOM.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_IOM_ARBITER_H
+#define AM_UTIL_IOM_ARBITER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+//
+// Default chunk size used to split long transfers (word multiple so that
+// every chunk starts on a word boundary of the caller's buffer).
+//
+#define AM_UTIL_IOM_ARBITER_DEFAULT_CHUNK   (AM_HAL_IOM_MAX_TXNSIZE_SPI & ~0x3)
+
+//
+// Default number of times a client may be passed over before it is served
+// regardless of priority.
+//
+#define AM_UTIL_IOM_ARBITER_DEFAULT_SKIPS   8
+
+//
+// Latency histogram size.  Latencies below 8 ticks get a bin each, above that
+// every power of two is split in 4 bins (25% resolution).  64 bins cover up to
+// 2^17 ticks; longer latencies land in the last bin.
+//
+#define AM_UTIL_IOM_ARBITER_LATENCY_BINS    64
+
+//*****************************************************************************
+//
+//! Time base used for deadlines and latency statistics.
+//
+//*****************************************************************************
+typedef uint32_t (*am_util_iom_arbiter_time_get_t)(void);
+
+struct am_util_iom_arbiter_client_s;
+
+//*****************************************************************************
+//
+//! Arbiter request.
+//!
+//! The request is owned by the caller and must stay valid until its callback
+//! runs.
+//
+//*****************************************************************************
+typedef struct am_util_iom_arbiter_request_s
+{
+    //
+    //! Transfer to perform.  ui32NumBytes may exceed the IOM transfer limit.
+    //
+    am_hal_iom_transfer_t                   sTransfer;
+
+    //
+    //! Split mode for long transfers.  If true, ui32Instr is advanced by the
+    //! bytes already moved (memory style devices) and other clients may run
+    //! between chunks.  Otherwise the chunks are chained with bContinue and
+    //! the request holds the bus until it completes.
+    //
+    bool                                    bAdvanceInstr;
+
+    //
+    //! Request priority.  Higher values are served first, across all clients.
+    //
+    uint32_t                                ui32Priority;
+
+    //
+    //! Absolute deadline in time base ticks.  0 means no deadline.
+    //
+    uint32_t                                ui32Deadline;
+
+    //
+    //! Completion callback, called once for the whole request.
+    //
+    am_hal_iom_callback_t                   pfnCallback;
+    void                                    *pCallbackCtxt;
+
+    //
+    // Internal state.
+    //
+    struct am_util_iom_arbiter_request_s    *pNext;
+    struct am_util_iom_arbiter_client_s     *pClient;
+    uint32_t                                ui32Offset;
+    uint32_t                                ui32Submitted;
+    uint32_t                                ui32Status;
+} am_util_iom_arbiter_request_t;
+
+//*****************************************************************************
+//
+//! Arbiter client (one per device on the bus).
+//
+//*****************************************************************************
+typedef struct am_util_iom_arbiter_client_s
+{
+    //
+    //! Read-only statistics.  Latencies are in time base ticks, measured from
+    //! submission to completion.  Use am_util_iom_arbiter_latency_percentile()
+    //! to read the histogram.
+    //
+    uint32_t                                ui32Completed;
+    uint32_t                                ui32Errors;
+    uint32_t                                ui32MissedDeadlines;
+    uint32_t                                ui32MaxLatency;
+    uint64_t                                ui64TotalLatency;
+    uint32_t                                ui32LatencyHist[AM_UTIL_IOM_ARBITER_LATENCY_BINS];
+
+    //
+    // Internal state.
+    //
+    am_util_iom_arbiter_request_t           *pHead;
+    am_util_iom_arbiter_request_t           *pTail;
+    uint32_t                                ui32Skipped;
+    struct am_util_iom_arbiter_client_s     *pNext;
+} am_util_iom_arbiter_client_t;
+
+//*****************************************************************************
+//
+//! Arbiter configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Handle of an enabled IOM with a non-blocking transaction buffer.
+    //
+    void                                    *pIomHandle;
+
+    //
+    //! Largest chunk issued to the IOM.  0 selects
+    //! AM_UTIL_IOM_ARBITER_DEFAULT_CHUNK.  Use at most AM_HAL_IOM_MAX_TXNSIZE_I2C
+    //! for I2C.
+    //
+    uint32_t                                ui32MaxChunk;
+
+    //
+    //! Starvation bound in dispatches.  0 selects
+    //! AM_UTIL_IOM_ARBITER_DEFAULT_SKIPS.
+    //
+    uint32_t                                ui32MaxSkips;
+
+    //
+    //! Time base (e.g. am_hal_stimer_counter_get).  May be NULL, in which
+    //! case deadlines are ignored and no latency is recorded.
+    //
+    am_util_iom_arbiter_time_get_t          pfnTimeGet;
+} am_util_iom_arbiter_config_t;
+
+//*****************************************************************************
+//
+//! Arbiter state.  Allocated by the caller, one per IOM module.
+//
+//*****************************************************************************
+typedef struct
+{
+    am_util_iom_arbiter_config_t            sConfig;
+    am_util_iom_arbiter_client_t            *pClients;
+    am_util_iom_arbiter_client_t            *pActiveClient;
+    am_util_iom_arbiter_request_t           *pActive;
+    uint32_t                                ui32ActiveBytes;
+    bool                                    bActiveContinue;
+    bool                                    bCsHeld;
+    volatile bool                           bBusy;
+} am_util_iom_arbiter_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_iom_arbiter_init(am_util_iom_arbiter_t *pArbiter,
+                                         const am_util_iom_arbiter_config_t *psConfig);
+extern uint32_t am_util_iom_arbiter_client_add(am_util_iom_arbiter_t *pArbiter,
+                                               am_util_iom_arbiter_client_t *pClient);
+extern uint32_t am_util_iom_arbiter_submit(am_util_iom_arbiter_t *pArbiter,
+                                           am_util_iom_arbiter_client_t *pClient,
+                                           am_util_iom_arbiter_request_t *pRequest);
+extern bool am_util_iom_arbiter_idle(am_util_iom_arbiter_t *pArbiter);
+extern uint32_t am_util_iom_arbiter_latency_percentile(const am_util_iom_arbiter_client_t *pClient,
+                                                       uint32_t ui32Percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_IOM_ARBITER_H
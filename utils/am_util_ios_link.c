@@ -0,0 +1,404 @@
+//*****************************************************************************
+//
+//! @file am_util_ios_link.c
+//!
+//! @brief Framed streaming link over the IOS FIFO (slave side).
+//!
+//! Frames are packed back to back into the IOS FIFO and announced to the host
+//! with a single IOINT doorbell per batch, so one host interrupt can move
+//! many frames.  The host drains the whole batch, then acknowledges it through
+//! the direct area, which re-arms the doorbell if more data has been queued.
+//! Host to slave messages use a single mailbox in the direct area with its
+//! own doorbell.  See am_util_ios_link_host.c for the matching host side,
+//! and tools/host_tests/ios_link_test.c for the two run against each other.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_mcu_apollo.h"
+#include "am_util_ios_link.h"
+
+//*****************************************************************************
+//
+// Link state.
+//
+//*****************************************************************************
+static struct
+{
+    bool                        bInitialized;
+    am_util_ios_link_config_t   sConfig;
+
+    //
+    // Largest frame, header included, that can ever fit in the FIFO.
+    //
+    uint32_t                    ui32FifoCapacity;
+
+    //
+    // Host state as last seen in the direct area.
+    //
+    bool                        bStarted;
+    uint8_t                     ui8AckSeq;
+    uint8_t                     ui8MboxSeq;
+
+    //
+    // Set while a DATA doorbell is waiting for the host to acknowledge it.
+    // FIFOCTR is only rewritten while this is clear, since the host is not
+    // reading the FIFO then.
+    //
+    bool                        bDoorbell;
+
+    am_util_ios_link_stats_t    sStats;
+} g_sIosLink;
+
+//*****************************************************************************
+//
+// Ring the DATA doorbell if the host is idle and enough data is queued.
+// Must be called from a critical section or the IOS interrupt.
+//
+//*****************************************************************************
+static void
+ios_link_kick(bool bForce)
+{
+    uint32_t ui32Used = 0;
+    uint32_t ui32Arg = AM_UTIL_IOS_LINK_IOINT_DATA;
+
+    if ( !g_sIosLink.bStarted || g_sIosLink.bDoorbell )
+    {
+        return;
+    }
+
+    am_hal_ios_fifo_space_used(g_sIosLink.sConfig.pIosHandle, &ui32Used);
+
+    if ( (ui32Used == 0) ||
+         (!bForce && (ui32Used < g_sIosLink.sConfig.ui32DoorbellThreshold)) )
+    {
+        return;
+    }
+
+    //
+    // Publish everything queued so far as one batch, then interrupt the host.
+    //
+    am_hal_ios_control(g_sIosLink.sConfig.pIosHandle,
+                       AM_HAL_IOS_REQ_FIFO_UPDATE_CTR, NULL);
+    am_hal_ios_control(g_sIosLink.sConfig.pIosHandle,
+                       AM_HAL_IOS_REQ_HOST_INTSET, &ui32Arg);
+
+    g_sIosLink.bDoorbell = true;
+    g_sIosLink.sStats.ui32Doorbells++;
+}
+
+//*****************************************************************************
+//
+// Handle a host write to the direct area.
+//
+//*****************************************************************************
+static void
+ios_link_host_write(void)
+{
+    volatile uint8_t *pui8Direct = am_hal_ios_pui8LRAM;
+    bool bAcked = false;
+    uint32_t ui32Arg;
+
+    if ( (pui8Direct[AM_UTIL_IOS_LINK_OFFSET_CONTROL] != 0) != g_sIosLink.bStarted )
+    {
+        g_sIosLink.bStarted = !g_sIosLink.bStarted;
+        g_sIosLink.bDoorbell = false;
+
+        if ( g_sIosLink.bStarted )
+        {
+            //
+            // The host writes its sequence numbers before raising CONTROL,
+            // so take them as the starting point.
+            //
+            g_sIosLink.ui8AckSeq = pui8Direct[AM_UTIL_IOS_LINK_OFFSET_ACK];
+            g_sIosLink.ui8MboxSeq = pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX_SEQ];
+        }
+        else
+        {
+            ui32Arg = AM_UTIL_IOS_LINK_IOINT_DATA | AM_UTIL_IOS_LINK_IOINT_MBOX_FREE;
+            am_hal_ios_control(g_sIosLink.sConfig.pIosHandle,
+                               AM_HAL_IOS_REQ_HOST_INTCLR, &ui32Arg);
+        }
+    }
+
+    if ( !g_sIosLink.bStarted )
+    {
+        return;
+    }
+
+    if ( pui8Direct[AM_UTIL_IOS_LINK_OFFSET_ACK] != g_sIosLink.ui8AckSeq )
+    {
+        g_sIosLink.ui8AckSeq = pui8Direct[AM_UTIL_IOS_LINK_OFFSET_ACK];
+        g_sIosLink.bDoorbell = false;
+        bAcked = true;
+    }
+
+    if ( pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX_SEQ] != g_sIosLink.ui8MboxSeq )
+    {
+        uint8_t ui8Channel = pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX];
+        uint32_t ui32Length = pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX + 2] |
+                              (pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX + 3] << 8);
+
+        g_sIosLink.ui8MboxSeq = pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX_SEQ];
+
+        if ( ui32Length <= AM_UTIL_IOS_LINK_MBOX_MAX )
+        {
+            g_sIosLink.sStats.ui32FramesRx++;
+            g_sIosLink.sStats.ui32BytesRx += ui32Length;
+
+            if ( g_sIosLink.sConfig.pfnRxCallback )
+            {
+                g_sIosLink.sConfig.pfnRxCallback(ui8Channel,
+                    (uint8_t *)&pui8Direct[AM_UTIL_IOS_LINK_OFFSET_MBOX_DATA],
+                    ui32Length, g_sIosLink.sConfig.pCallbackCtxt);
+            }
+        }
+
+        //
+        // The mailbox is free again once the callback returns.
+        //
+        ui32Arg = AM_UTIL_IOS_LINK_IOINT_MBOX_FREE;
+        am_hal_ios_control(g_sIosLink.sConfig.pIosHandle,
+                           AM_HAL_IOS_REQ_HOST_INTSET, &ui32Arg);
+    }
+
+    //
+    // Whatever piled up while the host was reading the last batch goes out
+    // straight away, regardless of the threshold.
+    //
+    ios_link_kick(bAcked);
+}
+
+//*****************************************************************************
+//
+// Initialize the link.
+//
+// The IOS must be configured and its FIFO empty.  This enables the FSIZE and
+// XCMPWR interrupts; the application enables IOSLAVE_IRQn.
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_init(const am_util_ios_link_config_t *psConfig)
+{
+    uint32_t ui32Space = 0;
+
+    if ( (psConfig == NULL) || (psConfig->pIosHandle == NULL) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    am_hal_ios_fifo_space_left(psConfig->pIosHandle, &ui32Space);
+
+    //
+    // FIFOCTR could not describe a fuller FIFO.
+    //
+    if ( (ui32Space <= AM_UTIL_IOS_LINK_FRAME_HDR_SIZE) ||
+         (ui32Space > AM_UTIL_IOS_LINK_FIFOCTR_MAX) )
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    AM_CRITICAL_BEGIN
+
+    g_sIosLink.sConfig = *psConfig;
+    g_sIosLink.ui32FifoCapacity = ui32Space;
+    g_sIosLink.bStarted = false;
+    g_sIosLink.bDoorbell = false;
+    g_sIosLink.sStats = (am_util_ios_link_stats_t) { 0 };
+    g_sIosLink.bInitialized = true;
+
+    AM_CRITICAL_END
+
+    am_hal_ios_interrupt_clear(psConfig->pIosHandle,
+                               AM_HAL_IOS_INT_FSIZE | AM_HAL_IOS_INT_XCMPWR);
+    am_hal_ios_interrupt_enable(psConfig->pIosHandle,
+                                AM_HAL_IOS_INT_FSIZE | AM_HAL_IOS_INT_XCMPWR);
+
+    //
+    // Pick up a host that started before we did.
+    //
+    AM_CRITICAL_BEGIN
+    ios_link_host_write();
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Queue one frame for the host.
+//
+// Frames are never split: AM_HAL_STATUS_IN_USE means the FIFO has no room
+// right now and the call can be retried, AM_HAL_STATUS_OUT_OF_RANGE means
+// the frame can never fit.  Frames are queued while the host is stopped and
+// delivered once it starts.
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_send(uint8_t ui8Channel, uint8_t *pui8Data,
+                      uint32_t ui32Length)
+{
+    uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+    uint32_t ui32Space = 0;
+    uint32_t ui32Written;
+    uint8_t pui8Header[AM_UTIL_IOS_LINK_FRAME_HDR_SIZE];
+
+    if ( !g_sIosLink.bInitialized )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    if ( (pui8Data == NULL) && ui32Length )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    if ( ui32Length + AM_UTIL_IOS_LINK_FRAME_HDR_SIZE > g_sIosLink.ui32FifoCapacity )
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    pui8Header[0] = AM_UTIL_IOS_LINK_FRAME_SYNC;
+    pui8Header[1] = ui8Channel;
+    pui8Header[2] = (uint8_t)ui32Length;
+    pui8Header[3] = (uint8_t)(ui32Length >> 8);
+
+    //
+    // Header and payload must land in the FIFO back to back, so no other
+    // sender may get in between.
+    //
+    AM_CRITICAL_BEGIN
+
+    am_hal_ios_fifo_space_left(g_sIosLink.sConfig.pIosHandle, &ui32Space);
+
+    if ( ui32Length + AM_UTIL_IOS_LINK_FRAME_HDR_SIZE > ui32Space )
+    {
+        g_sIosLink.sStats.ui32FifoFull++;
+        ui32Status = AM_HAL_STATUS_IN_USE;
+    }
+    else
+    {
+        am_hal_ios_fifo_write(g_sIosLink.sConfig.pIosHandle, pui8Header,
+                              AM_UTIL_IOS_LINK_FRAME_HDR_SIZE, &ui32Written);
+
+        if ( ui32Length )
+        {
+            am_hal_ios_fifo_write(g_sIosLink.sConfig.pIosHandle, pui8Data,
+                                  ui32Length, &ui32Written);
+        }
+
+        g_sIosLink.sStats.ui32FramesTx++;
+        g_sIosLink.sStats.ui32BytesTx += ui32Length;
+
+        ios_link_kick(false);
+    }
+
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Announce queued frames to the host even if the doorbell threshold has not
+// been reached.
+//
+//*****************************************************************************
+void
+am_util_ios_link_flush(void)
+{
+    AM_CRITICAL_BEGIN
+    ios_link_kick(true);
+    AM_CRITICAL_END
+}
+
+//*****************************************************************************
+//
+// Check whether the host has started the link.
+//
+//*****************************************************************************
+bool
+am_util_ios_link_host_active(void)
+{
+    return g_sIosLink.bStarted;
+}
+
+//*****************************************************************************
+//
+// IOS interrupt service.
+//
+// Call from am_ioslave_ios_isr() with the status already read and cleared.
+// This refills the LRAM FIFO from the SRAM buffer and handles host writes;
+// error interrupts are left to the application.
+//
+//*****************************************************************************
+void
+am_util_ios_link_int_service(uint32_t ui32Status)
+{
+    if ( !g_sIosLink.bInitialized )
+    {
+        return;
+    }
+
+    if ( ui32Status & AM_HAL_IOS_INT_FSIZE )
+    {
+        am_hal_ios_interrupt_service(g_sIosLink.sConfig.pIosHandle, ui32Status);
+    }
+
+    if ( ui32Status & AM_HAL_IOS_INT_XCMPWR )
+    {
+        ios_link_host_write();
+    }
+}
+
+//*****************************************************************************
+//
+// Read the link statistics.
+//
+//*****************************************************************************
+void
+am_util_ios_link_stats_get(am_util_ios_link_stats_t *psStats)
+{
+    AM_CRITICAL_BEGIN
+    *psStats = g_sIosLink.sStats;
+    AM_CRITICAL_END
+}
@@ -0,0 +1,192 @@
+//*****************************************************************************
+//
+//! @file am_util_ios_link.h
+//!
+//! @brief Framed streaming link over the IOS FIFO (slave side).
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_IOS_LINK_H
+#define AM_UTIL_IOS_LINK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Protocol definitions shared by the slave and host sides.
+//
+//*****************************************************************************
+//
+// Frame header placed in the IOS FIFO ahead of each payload: sync byte,
+// channel, then the payload length in little-endian order.
+//
+#define AM_UTIL_IOS_LINK_FRAME_SYNC         0xA5
+#define AM_UTIL_IOS_LINK_FRAME_HDR_SIZE     4
+
+//
+// IOINT bits used as doorbells towards the host.
+//
+#define AM_UTIL_IOS_LINK_IOINT_DATA         0x01
+#define AM_UTIL_IOS_LINK_IOINT_MBOX_FREE    0x02
+
+//
+// Direct area layout (host writable).  Every field is a level or a sequence
+// number rather than a one-shot command, so back to back host writes that
+// coalesce into one XCMPWR interrupt are never lost.
+//
+//  CONTROL     1 while the host wants data, 0 otherwise.
+//  ACK         Incremented by the host after draining each batch.
+//  MBOX_SEQ    Incremented by the host after filling the mailbox.
+//  MBOX        Mailbox header (channel, reserved, length low, length high)
+//              followed by the payload.
+//
+#define AM_UTIL_IOS_LINK_OFFSET_CONTROL     0x00
+#define AM_UTIL_IOS_LINK_OFFSET_ACK         0x01
+#define AM_UTIL_IOS_LINK_OFFSET_MBOX_SEQ    0x02
+#define AM_UTIL_IOS_LINK_OFFSET_MBOX        0x04
+#define AM_UTIL_IOS_LINK_OFFSET_MBOX_DATA   0x08
+
+//
+// End of the direct area used by the link.  The IOS ui32ROBase must be at
+// least this value, and ui32FIFOBase must follow it.
+//
+#define AM_UTIL_IOS_LINK_DIRECT_SIZE        0x78
+#define AM_UTIL_IOS_LINK_MBOX_MAX           (AM_UTIL_IOS_LINK_DIRECT_SIZE -   \
+                                             AM_UTIL_IOS_LINK_OFFSET_MBOX_DATA)
+
+//
+// Host side register offsets.  Writes to the direct area set bit 7.
+//
+#define AM_UTIL_IOS_LINK_HOST_WRITE         0x80
+#define AM_UTIL_IOS_LINK_HOST_READ_INTSTAT  0x79
+#define AM_UTIL_IOS_LINK_HOST_READ_FIFOCTR  0x7C
+#define AM_UTIL_IOS_LINK_HOST_READ_FIFO     0x7F
+#define AM_UTIL_IOS_LINK_HOST_WRITE_INTEN   0xF8
+#define AM_UTIL_IOS_LINK_HOST_WRITE_INTCLR  0xFA
+
+//
+// FIFOCTR is 10 bits wide, so the total FIFO (LRAM plus SRAM buffer) must not
+// hold more than this many bytes.
+//
+#define AM_UTIL_IOS_LINK_FIFOCTR_MAX        0x3FF
+
+//*****************************************************************************
+//
+//! Receive callback for mailbox messages from the host, called from the IOS
+//! interrupt.  The payload is only valid for the duration of the call.
+//
+//*****************************************************************************
+typedef void (*am_util_ios_link_rx_callback_t)(uint8_t ui8Channel,
+                                               uint8_t *pui8Data,
+                                               uint32_t ui32Length,
+                                               void *pCtxt);
+
+//*****************************************************************************
+//
+//! Slave side configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! IOS handle.  The IOS must already be configured with an SRAM FIFO
+    //! buffer and a direct area of at least AM_UTIL_IOS_LINK_DIRECT_SIZE
+    //! bytes.  The application calls am_util_ios_link_int_service() from
+    //! am_ioslave_ios_isr().
+    //
+    void                            *pIosHandle;
+
+    //
+    //! Bytes queued before the host is interrupted.  Smaller batches are sent
+    //! by am_util_ios_link_flush(), or when the host acknowledges the previous
+    //! batch.  0 or 1 rings the doorbell as soon as anything is queued.
+    //
+    uint32_t                        ui32DoorbellThreshold;
+
+    am_util_ios_link_rx_callback_t  pfnRxCallback;
+    void                            *pCallbackCtxt;
+} am_util_ios_link_config_t;
+
+//*****************************************************************************
+//
+//! Slave side statistics.  Byte counts are payload bytes.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t                        ui32FramesTx;
+    uint32_t                        ui32BytesTx;
+
+    //
+    //! Host interrupts raised for FIFO data.  Dividing ui32BytesTx by this
+    //! gives the average batch size.
+    //
+    uint32_t                        ui32Doorbells;
+
+    //
+    //! Frames refused because the FIFO was full.
+    //
+    uint32_t                        ui32FifoFull;
+
+    uint32_t                        ui32FramesRx;
+    uint32_t                        ui32BytesRx;
+} am_util_ios_link_stats_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_ios_link_init(const am_util_ios_link_config_t *psConfig);
+extern uint32_t am_util_ios_link_send(uint8_t ui8Channel, uint8_t *pui8Data,
+                                      uint32_t ui32Length);
+extern void am_util_ios_link_flush(void);
+extern bool am_util_ios_link_host_active(void);
+extern void am_util_ios_link_int_service(uint32_t ui32Status);
+extern void am_util_ios_link_stats_get(am_util_ios_link_stats_t *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_IOS_LINK_H
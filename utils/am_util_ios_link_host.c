@@ -0,0 +1,525 @@
+//*****************************************************************************
+//
+//! @file am_util_ios_link_host.c
+//!
+//! @brief Host side of the IOS FIFO streaming link, built on the IOM.
+//!
+//! Each DATA doorbell is serviced by reading FIFOCTR once and then draining
+//! the whole batch in as few IOM transactions as the read buffer allows.
+//! Frames that straddle two reads are reassembled in the frame buffer; frames
+//! that arrive whole are passed to the callback straight from the read buffer.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "am_mcu_apollo.h"
+#include "am_util_ios_link_host.h"
+
+//*****************************************************************************
+//
+// Run one blocking transaction against the slave.
+//
+//*****************************************************************************
+static uint32_t
+ios_link_host_xfer(am_util_ios_link_host_t *psLink, uint32_t ui32Offset,
+                   am_hal_iom_dir_e eDirection, uint32_t *pui32Buffer,
+                   uint32_t ui32NumBytes)
+{
+    am_hal_iom_transfer_t Transaction;
+
+    Transaction.ui32InstrLen        = 1;
+    Transaction.ui32Instr           = ui32Offset;
+    Transaction.eDirection          = eDirection;
+    Transaction.ui32NumBytes        = ui32NumBytes;
+    Transaction.pui32TxBuffer       = pui32Buffer;
+    Transaction.pui32RxBuffer       = pui32Buffer;
+    Transaction.bContinue           = false;
+    Transaction.ui8RepeatCount      = 0;
+    Transaction.ui32PauseCondition  = 0;
+    Transaction.ui32StatusSetClr    = 0;
+
+    if ( psLink->sConfig.bSpi )
+    {
+        Transaction.uPeerInfo.ui32SpiChipSelect = psLink->sConfig.ui32ChipSelect;
+    }
+    else
+    {
+        Transaction.uPeerInfo.ui32I2CDevAddr = psLink->sConfig.ui32I2CAddr;
+    }
+
+    return am_hal_iom_blocking_transfer(psLink->sConfig.pIomHandle, &Transaction);
+}
+
+//*****************************************************************************
+//
+// Write one byte to the slave.
+//
+//*****************************************************************************
+static uint32_t
+ios_link_host_write_byte(am_util_ios_link_host_t *psLink, uint32_t ui32Offset,
+                         uint8_t ui8Value)
+{
+    uint32_t ui32Word = ui8Value;
+
+    return ios_link_host_xfer(psLink, ui32Offset, AM_HAL_IOM_TX, &ui32Word, 1);
+}
+
+//*****************************************************************************
+//
+// Hand a complete frame to the application.
+//
+//*****************************************************************************
+static void
+ios_link_host_deliver(am_util_ios_link_host_t *psLink, uint8_t ui8Channel,
+                      uint8_t *pui8Data, uint32_t ui32Length)
+{
+    psLink->sStats.ui32FramesRx++;
+
+    if ( psLink->sConfig.pfnRxCallback )
+    {
+        psLink->sConfig.pfnRxCallback(ui8Channel, pui8Data, ui32Length,
+                                      psLink->sConfig.pCallbackCtxt);
+    }
+}
+
+//*****************************************************************************
+//
+// Split a block of FIFO bytes into frames.
+//
+//*****************************************************************************
+static void
+ios_link_host_parse(am_util_ios_link_host_t *psLink, uint8_t *pui8Data,
+                    uint32_t ui32Length)
+{
+    uint32_t ui32Size;
+
+    while ( ui32Length )
+    {
+        if ( psLink->ui32HeaderFill < AM_UTIL_IOS_LINK_FRAME_HDR_SIZE )
+        {
+            if ( psLink->ui32HeaderFill == 0 )
+            {
+                if ( pui8Data[0] != AM_UTIL_IOS_LINK_FRAME_SYNC )
+                {
+                    psLink->sStats.ui32SyncErrors++;
+                    pui8Data++;
+                    ui32Length--;
+                    continue;
+                }
+
+                //
+                // Common case: the whole frame is in this block, so it can be
+                // delivered without copying.
+                //
+                if ( ui32Length >= AM_UTIL_IOS_LINK_FRAME_HDR_SIZE )
+                {
+                    ui32Size = pui8Data[2] | (pui8Data[3] << 8);
+
+                    if ( (ui32Size <= psLink->sConfig.ui32FrameBufferSize) &&
+                         (ui32Length >= ui32Size + AM_UTIL_IOS_LINK_FRAME_HDR_SIZE) )
+                    {
+                        ios_link_host_deliver(psLink, pui8Data[1],
+                                              pui8Data + AM_UTIL_IOS_LINK_FRAME_HDR_SIZE,
+                                              ui32Size);
+                        pui8Data += ui32Size + AM_UTIL_IOS_LINK_FRAME_HDR_SIZE;
+                        ui32Length -= ui32Size + AM_UTIL_IOS_LINK_FRAME_HDR_SIZE;
+                        continue;
+                    }
+                }
+            }
+
+            psLink->pui8Header[psLink->ui32HeaderFill++] = *pui8Data++;
+            ui32Length--;
+
+            if ( psLink->ui32HeaderFill == AM_UTIL_IOS_LINK_FRAME_HDR_SIZE )
+            {
+                psLink->ui32FrameLength = psLink->pui8Header[2] |
+                                          (psLink->pui8Header[3] << 8);
+                psLink->ui32FrameFill = 0;
+
+                if ( psLink->ui32FrameLength > psLink->sConfig.ui32FrameBufferSize )
+                {
+                    //
+                    // Not a frame we can take.  Hunt for the next sync byte.
+                    //
+                    psLink->sStats.ui32SyncErrors++;
+                    psLink->ui32HeaderFill = 0;
+                }
+                else if ( psLink->ui32FrameLength == 0 )
+                {
+                    ios_link_host_deliver(psLink, psLink->pui8Header[1],
+                                          psLink->sConfig.pui8FrameBuffer, 0);
+                    psLink->ui32HeaderFill = 0;
+                }
+            }
+            continue;
+        }
+
+        ui32Size = psLink->ui32FrameLength - psLink->ui32FrameFill;
+        if ( ui32Size > ui32Length )
+        {
+            ui32Size = ui32Length;
+        }
+
+        memcpy(psLink->sConfig.pui8FrameBuffer + psLink->ui32FrameFill,
+               pui8Data, ui32Size);
+        psLink->ui32FrameFill += ui32Size;
+        pui8Data += ui32Size;
+        ui32Length -= ui32Size;
+
+        if ( psLink->ui32FrameFill == psLink->ui32FrameLength )
+        {
+            ios_link_host_deliver(psLink, psLink->pui8Header[1],
+                                  psLink->sConfig.pui8FrameBuffer,
+                                  psLink->ui32FrameLength);
+            psLink->ui32HeaderFill = 0;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Read the batch announced by a DATA doorbell, then acknowledge it.
+//
+//*****************************************************************************
+static uint32_t
+ios_link_host_drain(am_util_ios_link_host_t *psLink)
+{
+    uint32_t ui32Status;
+    uint32_t ui32Count = 0;
+    uint32_t ui32Chunk;
+    uint32_t ui32MaxChunk;
+
+    ui32Status = ios_link_host_xfer(psLink, AM_UTIL_IOS_LINK_HOST_READ_FIFOCTR,
+                                    AM_HAL_IOM_RX, &ui32Count, 2);
+    if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+    {
+        return ui32Status;
+    }
+
+    ui32Count &= AM_UTIL_IOS_LINK_FIFOCTR_MAX;
+
+    ui32MaxChunk = psLink->sConfig.bSpi ? AM_HAL_IOM_MAX_TXNSIZE_SPI :
+                                          AM_HAL_IOM_MAX_TXNSIZE_I2C;
+    if ( ui32MaxChunk > psLink->sConfig.ui32ReadBufferSize )
+    {
+        ui32MaxChunk = psLink->sConfig.ui32ReadBufferSize;
+    }
+
+    psLink->sStats.ui32Batches++;
+
+    while ( ui32Count )
+    {
+        ui32Chunk = (ui32Count > ui32MaxChunk) ? ui32MaxChunk : ui32Count;
+
+        ui32Status = ios_link_host_xfer(psLink, AM_UTIL_IOS_LINK_HOST_READ_FIFO,
+                                        AM_HAL_IOM_RX,
+                                        psLink->sConfig.pui32ReadBuffer,
+                                        ui32Chunk);
+        if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+        {
+            return ui32Status;
+        }
+
+        psLink->sStats.ui32Reads++;
+        psLink->sStats.ui32BytesRx += ui32Chunk;
+
+        ios_link_host_parse(psLink, (uint8_t *)psLink->sConfig.pui32ReadBuffer,
+                            ui32Chunk);
+        ui32Count -= ui32Chunk;
+    }
+
+    //
+    // The ACK tells the slave FIFOCTR is free to be rewritten.
+    //
+    return ios_link_host_write_byte(psLink,
+                                    AM_UTIL_IOS_LINK_HOST_WRITE |
+                                    AM_UTIL_IOS_LINK_OFFSET_ACK,
+                                    ++psLink->ui8AckSeq);
+}
+
+//*****************************************************************************
+//
+// Initialize a link instance.  No bus traffic happens until
+// am_util_ios_link_host_start().
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_host_init(am_util_ios_link_host_t *psLink,
+                           const am_util_ios_link_host_config_t *psConfig)
+{
+    if ( (psLink == NULL) || (psConfig == NULL) ||
+         (psConfig->pIomHandle == NULL) ||
+         (psConfig->pui32ReadBuffer == NULL) ||
+         (psConfig->ui32ReadBufferSize < 4) ||
+         (psConfig->ui32ReadBufferSize & 0x3) ||
+         ((psConfig->pui8FrameBuffer == NULL) && psConfig->ui32FrameBufferSize) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    memset(psLink, 0, sizeof(*psLink));
+    psLink->sConfig = *psConfig;
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Start the link: enable the slave doorbells and ask for data.
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_host_start(am_util_ios_link_host_t *psLink)
+{
+    uint32_t ui32Status;
+    uint32_t ui32Word;
+
+    ui32Status = ios_link_host_write_byte(psLink,
+                                          AM_UTIL_IOS_LINK_HOST_WRITE_INTCLR,
+                                          AM_UTIL_IOS_LINK_IOINT_DATA |
+                                          AM_UTIL_IOS_LINK_IOINT_MBOX_FREE);
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        ui32Status = ios_link_host_write_byte(psLink,
+                                              AM_UTIL_IOS_LINK_HOST_WRITE_INTEN,
+                                              AM_UTIL_IOS_LINK_IOINT_DATA |
+                                              AM_UTIL_IOS_LINK_IOINT_MBOX_FREE);
+    }
+
+    //
+    // Sequence numbers first, so the slave sees them when CONTROL changes.
+    //
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        ui32Word = psLink->ui8AckSeq | (psLink->ui8MboxSeq << 8);
+        ui32Status = ios_link_host_xfer(psLink,
+                                        AM_UTIL_IOS_LINK_HOST_WRITE |
+                                        AM_UTIL_IOS_LINK_OFFSET_ACK,
+                                        AM_HAL_IOM_TX, &ui32Word, 2);
+    }
+
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        ui32Status = ios_link_host_write_byte(psLink,
+                                              AM_UTIL_IOS_LINK_HOST_WRITE |
+                                              AM_UTIL_IOS_LINK_OFFSET_CONTROL,
+                                              1);
+    }
+
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        psLink->bStarted = true;
+        psLink->bMboxBusy = false;
+        psLink->ui32HeaderFill = 0;
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Stop the link.  Data already queued on the slave stays there.
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_host_stop(am_util_ios_link_host_t *psLink)
+{
+    psLink->bStarted = false;
+
+    return ios_link_host_write_byte(psLink,
+                                    AM_UTIL_IOS_LINK_HOST_WRITE |
+                                    AM_UTIL_IOS_LINK_OFFSET_CONTROL,
+                                    0);
+}
+
+//*****************************************************************************
+//
+// Service the slave interrupt line.
+//
+// Call from thread context whenever the slave IOINT pin is asserted (the
+// GPIO handler should only set a flag, since this runs blocking IOM
+// transactions).  Calling it with nothing pending costs one status read.
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_host_service(am_util_ios_link_host_t *psLink)
+{
+    uint32_t ui32Status;
+    uint32_t ui32IntStatus = 0;
+
+    if ( !psLink->bStarted )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    ui32Status = ios_link_host_xfer(psLink, AM_UTIL_IOS_LINK_HOST_READ_INTSTAT,
+                                    AM_HAL_IOM_RX, &ui32IntStatus, 1);
+    if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+    {
+        return ui32Status;
+    }
+
+    ui32IntStatus &= AM_UTIL_IOS_LINK_IOINT_DATA | AM_UTIL_IOS_LINK_IOINT_MBOX_FREE;
+    if ( ui32IntStatus == 0 )
+    {
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    psLink->sStats.ui32Interrupts++;
+
+    //
+    // Clear before acting, so a doorbell raised while we work is not lost.
+    //
+    ui32Status = ios_link_host_write_byte(psLink,
+                                          AM_UTIL_IOS_LINK_HOST_WRITE_INTCLR,
+                                          (uint8_t)ui32IntStatus);
+    if ( ui32Status != AM_HAL_STATUS_SUCCESS )
+    {
+        return ui32Status;
+    }
+
+    if ( ui32IntStatus & AM_UTIL_IOS_LINK_IOINT_MBOX_FREE )
+    {
+        psLink->bMboxBusy = false;
+    }
+
+    if ( ui32IntStatus & AM_UTIL_IOS_LINK_IOINT_DATA )
+    {
+        ui32Status = ios_link_host_drain(psLink);
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Send a message to the slave through the mailbox.
+//
+// Returns AM_HAL_STATUS_IN_USE until the slave has consumed the previous
+// message, which am_util_ios_link_host_service() picks up.
+//
+//*****************************************************************************
+uint32_t
+am_util_ios_link_host_send(am_util_ios_link_host_t *psLink, uint8_t ui8Channel,
+                           uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t pui32Mbox[(AM_UTIL_IOS_LINK_DIRECT_SIZE -
+                        AM_UTIL_IOS_LINK_OFFSET_MBOX + 3) / 4];
+    uint8_t *pui8Mbox = (uint8_t *)pui32Mbox;
+    uint32_t ui32Status;
+
+    if ( !psLink->bStarted )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    if ( ((pui8Data == NULL) && ui32Length) ||
+         (ui32Length > AM_UTIL_IOS_LINK_MBOX_MAX) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    if ( psLink->bMboxBusy )
+    {
+        return AM_HAL_STATUS_IN_USE;
+    }
+
+    pui8Mbox[0] = ui8Channel;
+    pui8Mbox[1] = 0;
+    pui8Mbox[2] = (uint8_t)ui32Length;
+    pui8Mbox[3] = (uint8_t)(ui32Length >> 8);
+    if ( ui32Length )
+    {
+        memcpy(pui8Mbox + 4, pui8Data, ui32Length);
+    }
+
+    ui32Status = ios_link_host_xfer(psLink,
+                                    AM_UTIL_IOS_LINK_HOST_WRITE |
+                                    AM_UTIL_IOS_LINK_OFFSET_MBOX,
+                                    AM_HAL_IOM_TX, pui32Mbox, ui32Length + 4);
+
+    //
+    // The sequence number goes in a separate write, so the slave never acts
+    // on a half written mailbox.
+    //
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        ui32Status = ios_link_host_write_byte(psLink,
+                                              AM_UTIL_IOS_LINK_HOST_WRITE |
+                                              AM_UTIL_IOS_LINK_OFFSET_MBOX_SEQ,
+                                              ++psLink->ui8MboxSeq);
+    }
+
+    if ( ui32Status == AM_HAL_STATUS_SUCCESS )
+    {
+        psLink->bMboxBusy = true;
+        psLink->sStats.ui32FramesTx++;
+        psLink->sStats.ui32BytesTx += ui32Length;
+    }
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Check whether the mailbox can take another message.
+//
+//*****************************************************************************
+bool
+am_util_ios_link_host_send_ready(am_util_ios_link_host_t *psLink)
+{
+    return psLink->bStarted && !psLink->bMboxBusy;
+}
+
+//*****************************************************************************
+//
+// Read the link statistics.
+//
+//*****************************************************************************
+void
+am_util_ios_link_host_stats_get(am_util_ios_link_host_t *psLink,
+                                am_util_ios_link_host_stats_t *psStats)
+{
+    *psStats = psLink->sStats;
+}
@@ -0,0 +1,164 @@
+//*****************************************************************************
+//
+//! @file am_util_ios_link_host.h
+//!
+//! @brief Host side of the IOS FIFO streaming link, built on the IOM.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_IOS_LINK_HOST_H
+#define AM_UTIL_IOS_LINK_HOST_H
+
+#include "am_util_ios_link.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! Host side configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! IOM handle, already configured for SPI or I2C to the slave.
+    //
+    void                            *pIomHandle;
+    bool                            bSpi;
+
+    //
+    //! SPI chip select, or I2C address of the slave.
+    //
+    uint32_t                        ui32ChipSelect;
+    uint32_t                        ui32I2CAddr;
+
+    //
+    //! Buffer for FIFO reads.  The size is in bytes and must be a multiple of
+    //! four.  Larger buffers mean fewer IOM transactions per batch; there is
+    //! no gain beyond AM_UTIL_IOS_LINK_FIFOCTR_MAX + 1 bytes.
+    //
+    uint32_t                        *pui32ReadBuffer;
+    uint32_t                        ui32ReadBufferSize;
+
+    //
+    //! Buffer for reassembling frames split across reads.  Its size is also
+    //! the largest payload accepted; longer frames count as sync errors.
+    //
+    uint8_t                         *pui8FrameBuffer;
+    uint32_t                        ui32FrameBufferSize;
+
+    am_util_ios_link_rx_callback_t  pfnRxCallback;
+    void                            *pCallbackCtxt;
+} am_util_ios_link_host_config_t;
+
+//*****************************************************************************
+//
+//! Host side statistics.  ui32BytesRx counts raw FIFO bytes, headers
+//! included; ui32BytesTx counts mailbox payload bytes.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Slave interrupts serviced.  (ui32Interrupts * 1024) / ui32BytesRx is
+    //! the interrupt cost per KB received.
+    //
+    uint32_t                        ui32Interrupts;
+    uint32_t                        ui32Batches;
+    uint32_t                        ui32Reads;
+    uint32_t                        ui32BytesRx;
+    uint32_t                        ui32FramesRx;
+    uint32_t                        ui32SyncErrors;
+    uint32_t                        ui32FramesTx;
+    uint32_t                        ui32BytesTx;
+} am_util_ios_link_host_stats_t;
+
+//*****************************************************************************
+//
+//! Link instance, one per slave.  Owned by the caller; the contents are
+//! private.
+//
+//*****************************************************************************
+typedef struct
+{
+    am_util_ios_link_host_config_t  sConfig;
+
+    bool                            bStarted;
+    bool                            bMboxBusy;
+    uint8_t                         ui8AckSeq;
+    uint8_t                         ui8MboxSeq;
+
+    //
+    // Frame reassembly state.
+    //
+    uint8_t                         pui8Header[AM_UTIL_IOS_LINK_FRAME_HDR_SIZE];
+    uint32_t                        ui32HeaderFill;
+    uint32_t                        ui32FrameLength;
+    uint32_t                        ui32FrameFill;
+
+    am_util_ios_link_host_stats_t   sStats;
+} am_util_ios_link_host_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_ios_link_host_init(am_util_ios_link_host_t *psLink,
+                                           const am_util_ios_link_host_config_t *psConfig);
+extern uint32_t am_util_ios_link_host_start(am_util_ios_link_host_t *psLink);
+extern uint32_t am_util_ios_link_host_stop(am_util_ios_link_host_t *psLink);
+extern uint32_t am_util_ios_link_host_service(am_util_ios_link_host_t *psLink);
+extern uint32_t am_util_ios_link_host_send(am_util_ios_link_host_t *psLink,
+                                           uint8_t ui8Channel,
+                                           uint8_t *pui8Data,
+                                           uint32_t ui32Length);
+extern bool am_util_ios_link_host_send_ready(am_util_ios_link_host_t *psLink);
+extern void am_util_ios_link_host_stats_get(am_util_ios_link_host_t *psLink,
+                                            am_util_ios_link_host_stats_t *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_IOS_LINK_HOST_H
@@ -0,0 +1,336 @@
+//*****************************************************************************
+//
+//! @file am_util_timestamp.c
+//!
+//! @brief 64-bit STIMER timestamps and GPIO edge capture logging.
+//!
+//!
+//! The 32-bit STIMER counter is extended with an epoch counted by the
+//! overflow interrupt.  Reads are lock-free.  GPIO edges latched by the
+//! STIMER capture registers are logged with 64-bit timestamps into a ring
+//! from the STIMER interrupt.
+//!
+//! The application enables STIMER_IRQn and calls
+//! am_util_timestamp_int_service() from am_stimer_isr() with the interrupt
+//! status.
+//!
+//! This is the one 64-bit STIMER time base; am_util_vtimer uses it too.
+//! CTIMER captures are not handled: the CTIMERs count on their own clocks
+//! and are at most 32 bits wide, so their values cannot be extended against
+//! the STIMER.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_mcu_apollo.h"
+#include "am_util_timestamp.h"
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+#define TIMESTAMP_CAPTURE_INTS                                              \
+    (AM_HAL_STIMER_INT_CAPTUREA | AM_HAL_STIMER_INT_CAPTUREB |              \
+     AM_HAL_STIMER_INT_CAPTUREC | AM_HAL_STIMER_INT_CAPTURED)
+
+//*****************************************************************************
+//
+// Globals
+//
+//*****************************************************************************
+//
+// Number of STIMER counter wraps handled by the overflow interrupt.
+//
+static volatile uint32_t g_ui32TimestampEpoch;
+static bool g_bTimestampRunning;
+
+//
+// Capture log.  Written only by the interrupt service and read only by
+// am_util_timestamp_log_read(), so the indices need no lock.
+//
+static struct
+{
+    am_util_timestamp_event_t   *psBuffer;
+    uint32_t                    ui32Mask;
+    volatile uint32_t           ui32Head;
+    volatile uint32_t           ui32Tail;
+    volatile uint32_t           ui32Dropped;
+} g_sTimestampLog;
+
+//*****************************************************************************
+//
+// Start counting STIMER overflows.  The STIMER must already be configured
+// and running.  Later calls do nothing, so every user of the time base may
+// call this without moving time for the others.
+//
+//*****************************************************************************
+void
+am_util_timestamp_init(void)
+{
+    AM_CRITICAL_BEGIN
+
+    if ( !g_bTimestampRunning )
+    {
+        am_hal_stimer_int_clear(AM_HAL_STIMER_INT_OVERFLOW);
+        am_hal_stimer_int_enable(AM_HAL_STIMER_INT_OVERFLOW);
+        g_bTimestampRunning = true;
+    }
+
+    AM_CRITICAL_END
+}
+
+//*****************************************************************************
+//
+// Returns the STIMER count extended to 64 bits.
+//
+// The counter is sampled between two reads of the epoch, and the sample is
+// retried if the overflow interrupt ran in between.  An overflow that is
+// still pending (the caller has interrupts masked, or outranks the STIMER
+// interrupt) is accounted for when the sample has already wrapped.
+//
+//*****************************************************************************
+uint64_t
+am_util_timestamp_get(void)
+{
+    uint32_t ui32Epoch;
+    uint32_t ui32Count;
+    uint32_t ui32Status;
+
+    do
+    {
+        ui32Epoch = g_ui32TimestampEpoch;
+        ui32Count = am_hal_stimer_counter_get();
+        ui32Status = am_hal_stimer_int_status_get(false);
+    } while ( ui32Epoch != g_ui32TimestampEpoch );
+
+    if ( (ui32Status & AM_HAL_STIMER_INT_OVERFLOW) && (ui32Count < 0x80000000) )
+    {
+        ui32Epoch++;
+    }
+
+    return ((uint64_t)ui32Epoch << 32) | ui32Count;
+}
+
+//*****************************************************************************
+//
+// Extend a 32-bit STIMER count from the recent past (such as a capture
+// register value) to 64 bits.
+//
+//*****************************************************************************
+uint64_t
+am_util_timestamp_extend(uint32_t ui32Count)
+{
+    uint64_t ui64Now = am_util_timestamp_get();
+
+    return ui64Now - (uint32_t)((uint32_t)ui64Now - ui32Count);
+}
+
+//*****************************************************************************
+//
+// STIMER interrupt service.  Handles the overflow and capture interrupts in
+// ui32Status and clears them.  Other STIMER interrupts are left alone.
+//
+//*****************************************************************************
+void
+am_util_timestamp_int_service(uint32_t ui32Status)
+{
+    uint32_t ui32Captures = ui32Status & TIMESTAMP_CAPTURE_INTS;
+
+    if ( ui32Status & AM_HAL_STIMER_INT_OVERFLOW )
+    {
+        //
+        // Clearing the flag and advancing the epoch must look atomic to a
+        // higher priority reader, or it could count this overflow twice or
+        // not at all.
+        //
+        AM_CRITICAL_BEGIN
+        am_hal_stimer_int_clear(AM_HAL_STIMER_INT_OVERFLOW);
+        g_ui32TimestampEpoch++;
+        AM_CRITICAL_END
+    }
+
+    if ( ui32Captures == 0 )
+    {
+        return;
+    }
+
+    am_hal_stimer_int_clear(ui32Captures);
+
+    for ( uint32_t i = 0; i < 4; i++ )
+    {
+        uint32_t ui32Head;
+
+        if ( !(ui32Captures & (AM_HAL_STIMER_INT_CAPTUREA << i)) )
+        {
+            continue;
+        }
+
+        if ( g_sTimestampLog.psBuffer == NULL )
+        {
+            continue;
+        }
+
+        ui32Head = g_sTimestampLog.ui32Head;
+        if ( ui32Head - g_sTimestampLog.ui32Tail > g_sTimestampLog.ui32Mask )
+        {
+            g_sTimestampLog.ui32Dropped++;
+            continue;
+        }
+
+        g_sTimestampLog.psBuffer[ui32Head & g_sTimestampLog.ui32Mask] =
+            (am_util_timestamp_event_t)
+            {
+                .ui64Timestamp = am_util_timestamp_extend(am_hal_stimer_capture_get(i)),
+                .ui32CaptureNum = i,
+            };
+
+        //
+        // Publish the entry only after it has been written.
+        //
+        __DMB();
+        g_sTimestampLog.ui32Head = ui32Head + 1;
+    }
+}
+
+//*****************************************************************************
+//
+// Set the storage for the capture log and empty it.
+//
+//*****************************************************************************
+uint32_t
+am_util_timestamp_log_init(const am_util_timestamp_log_config_t *psConfig)
+{
+    if ( (psConfig == NULL) || (psConfig->psBuffer == NULL) ||
+         (psConfig->ui32NumEvents == 0) ||
+         (psConfig->ui32NumEvents & (psConfig->ui32NumEvents - 1)) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    AM_CRITICAL_BEGIN
+    g_sTimestampLog.psBuffer = psConfig->psBuffer;
+    g_sTimestampLog.ui32Mask = psConfig->ui32NumEvents - 1;
+    g_sTimestampLog.ui32Head = 0;
+    g_sTimestampLog.ui32Tail = 0;
+    g_sTimestampLog.ui32Dropped = 0;
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Start logging edges on a GPIO through a capture register.  Only one edge
+// per capture register can be latched between interrupts.
+//
+//*****************************************************************************
+uint32_t
+am_util_timestamp_capture_start(uint32_t ui32CaptureNum,
+                                uint32_t ui32GPIONumber,
+                                bool bPolarity)
+{
+    if ( (ui32CaptureNum > 3) || (ui32GPIONumber >= AM_HAL_GPIO_MAX_PADS) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_CAPTUREA << ui32CaptureNum);
+    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_CAPTUREA << ui32CaptureNum);
+    am_hal_stimer_capture_start(ui32CaptureNum, ui32GPIONumber, bPolarity);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Stop logging edges through a capture register.
+//
+//*****************************************************************************
+uint32_t
+am_util_timestamp_capture_stop(uint32_t ui32CaptureNum)
+{
+    if ( ui32CaptureNum > 3 )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    am_hal_stimer_capture_stop(ui32CaptureNum);
+    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_CAPTUREA << ui32CaptureNum);
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Remove the oldest event from the capture log.  Returns false if the log is
+// empty.
+//
+//*****************************************************************************
+bool
+am_util_timestamp_log_read(am_util_timestamp_event_t *psEvent)
+{
+    uint32_t ui32Tail = g_sTimestampLog.ui32Tail;
+
+    if ( ui32Tail == g_sTimestampLog.ui32Head )
+    {
+        return false;
+    }
+
+    __DMB();
+    *psEvent = g_sTimestampLog.psBuffer[ui32Tail & g_sTimestampLog.ui32Mask];
+    __DMB();
+    g_sTimestampLog.ui32Tail = ui32Tail + 1;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Returns the number of edges dropped because the capture log was full.
+//
+//*****************************************************************************
+uint32_t
+am_util_timestamp_log_dropped(void)
+{
+    return g_sTimestampLog.ui32Dropped;
+}
@@ -0,0 +1,107 @@
+//*****************************************************************************
+//
+//! @file am_util_timestamp.h
+//!
+//! @brief 64-bit STIMER timestamps and GPIO edge capture logging.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_TIMESTAMP_H
+#define AM_UTIL_TIMESTAMP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+//! Captured edge.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! STIMER count at the edge, extended to 64 bits.
+    //
+    uint64_t                ui64Timestamp;
+
+    //
+    //! Capture register (0-3) that latched the edge.
+    //
+    uint32_t                ui32CaptureNum;
+} am_util_timestamp_event_t;
+
+//*****************************************************************************
+//
+//! Capture log configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! Event storage.  The number of entries must be a power of 2.
+    //
+    am_util_timestamp_event_t   *psBuffer;
+    uint32_t                    ui32NumEvents;
+} am_util_timestamp_log_config_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern void am_util_timestamp_init(void);
+extern uint64_t am_util_timestamp_get(void);
+extern uint64_t am_util_timestamp_extend(uint32_t ui32Count);
+extern void am_util_timestamp_int_service(uint32_t ui32Status);
+extern uint32_t am_util_timestamp_log_init(const am_util_timestamp_log_config_t *psConfig);
+extern uint32_t am_util_timestamp_capture_start(uint32_t ui32CaptureNum,
+                                                uint32_t ui32GPIONumber,
+                                                bool bPolarity);
+extern uint32_t am_util_timestamp_capture_stop(uint32_t ui32CaptureNum);
+extern bool am_util_timestamp_log_read(am_util_timestamp_event_t *psEvent);
+extern uint32_t am_util_timestamp_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_TIMESTAMP_H
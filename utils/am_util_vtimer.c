@@ -0,0 +1,489 @@
+//*****************************************************************************
+//
+//! @file am_util_vtimer.c
+//!
+//! @brief Virtual timers multiplexed on one STIMER compare channel.
+//!
+//!
+//! Any number of one-shot and periodic timers share a single STIMER compare
+//! register.  Running timers are kept in a binary min-heap ordered by a 64-bit
+//! deadline, and only the earliest deadline is programmed into the hardware.
+//! The compare interrupt runs every expired callback in one pass.
+//!
+//! Deadlines are on the am_util_timestamp time base, so they can be compared
+//! with captured edge times and am_util_timestamp_get().
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_mcu_apollo.h"
+#include "am_util_timestamp.h"
+#include "am_util_vtimer.h"
+
+//*****************************************************************************
+//
+// Service state.
+//
+//*****************************************************************************
+static struct
+{
+    bool                    bInitialized;
+    uint32_t                ui32CompareInstance;
+    uint32_t                ui32CompareInt;
+    am_util_vtimer_t        **ppsHeap;
+    uint32_t                ui32HeapSize;
+    uint32_t                ui32Count;
+    am_util_vtimer_stats_t  sStats;
+} g_sVTimer;
+
+//*****************************************************************************
+//
+// Heap helpers.  Must be called in a critical section.
+//
+//*****************************************************************************
+static void
+vtimer_heap_place(uint32_t ui32Index, am_util_vtimer_t *psTimer)
+{
+    g_sVTimer.ppsHeap[ui32Index] = psTimer;
+    psTimer->ui32Slot = ui32Index + 1;
+}
+
+static void
+vtimer_heap_sift_up(uint32_t ui32Index)
+{
+    am_util_vtimer_t *psTimer = g_sVTimer.ppsHeap[ui32Index];
+
+    while ( ui32Index > 0 )
+    {
+        uint32_t ui32Parent = (ui32Index - 1) / 2;
+
+        if ( g_sVTimer.ppsHeap[ui32Parent]->ui64Deadline <= psTimer->ui64Deadline )
+        {
+            break;
+        }
+
+        vtimer_heap_place(ui32Index, g_sVTimer.ppsHeap[ui32Parent]);
+        ui32Index = ui32Parent;
+    }
+
+    vtimer_heap_place(ui32Index, psTimer);
+}
+
+static void
+vtimer_heap_sift_down(uint32_t ui32Index)
+{
+    am_util_vtimer_t *psTimer = g_sVTimer.ppsHeap[ui32Index];
+    uint32_t ui32Count = g_sVTimer.ui32Count;
+
+    while ( 1 )
+    {
+        uint32_t ui32Child = 2 * ui32Index + 1;
+
+        if ( ui32Child >= ui32Count )
+        {
+            break;
+        }
+
+        if ( (ui32Child + 1 < ui32Count) &&
+             (g_sVTimer.ppsHeap[ui32Child + 1]->ui64Deadline <
+              g_sVTimer.ppsHeap[ui32Child]->ui64Deadline) )
+        {
+            ui32Child++;
+        }
+
+        if ( psTimer->ui64Deadline <= g_sVTimer.ppsHeap[ui32Child]->ui64Deadline )
+        {
+            break;
+        }
+
+        vtimer_heap_place(ui32Index, g_sVTimer.ppsHeap[ui32Child]);
+        ui32Index = ui32Child;
+    }
+
+    vtimer_heap_place(ui32Index, psTimer);
+}
+
+static void
+vtimer_heap_insert(am_util_vtimer_t *psTimer)
+{
+    g_sVTimer.ppsHeap[g_sVTimer.ui32Count] = psTimer;
+    vtimer_heap_sift_up(g_sVTimer.ui32Count++);
+}
+
+static void
+vtimer_heap_remove(am_util_vtimer_t *psTimer)
+{
+    uint32_t ui32Index = psTimer->ui32Slot - 1;
+    am_util_vtimer_t *psLast = g_sVTimer.ppsHeap[--g_sVTimer.ui32Count];
+
+    psTimer->ui32Slot = 0;
+    if ( psLast == psTimer )
+    {
+        return;
+    }
+
+    //
+    // Move the last entry into the hole and restore the heap order in
+    // whichever direction it is violated.
+    //
+    vtimer_heap_place(ui32Index, psLast);
+    if ( (ui32Index > 0) &&
+         (psLast->ui64Deadline < g_sVTimer.ppsHeap[(ui32Index - 1) / 2]->ui64Deadline) )
+    {
+        vtimer_heap_sift_up(ui32Index);
+    }
+    else
+    {
+        vtimer_heap_sift_down(ui32Index);
+    }
+}
+
+//*****************************************************************************
+//
+// Program the compare register for the earliest deadline.  Returns false if
+// that deadline is already due, in which case nothing is programmed.  Must
+// be called in a critical section.
+//
+//*****************************************************************************
+static bool
+vtimer_arm(void)
+{
+    uint64_t ui64Now = am_util_timestamp_get();
+    uint64_t ui64Delta = AM_UTIL_VTIMER_MAX_DELTA;
+
+    if ( g_sVTimer.ui32Count )
+    {
+        uint64_t ui64Deadline = g_sVTimer.ppsHeap[0]->ui64Deadline;
+
+        if ( ui64Deadline <= ui64Now )
+        {
+            return false;
+        }
+
+        if ( ui64Deadline - ui64Now < ui64Delta )
+        {
+            ui64Delta = ui64Deadline - ui64Now;
+        }
+
+        if ( ui64Delta < AM_UTIL_VTIMER_MIN_DELTA )
+        {
+            ui64Delta = AM_UTIL_VTIMER_MIN_DELTA;
+        }
+    }
+
+    am_hal_stimer_compare_delta_set(g_sVTimer.ui32CompareInstance,
+                                    (uint32_t)ui64Delta);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Initialize the virtual timer service.
+//
+//*****************************************************************************
+uint32_t
+am_util_vtimer_init(const am_util_vtimer_config_t *psConfig)
+{
+    if ( (psConfig == NULL) || (psConfig->ui32CompareInstance > 7) ||
+         (psConfig->ppsHeap == NULL) || (psConfig->ui32HeapSize == 0) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    AM_CRITICAL_BEGIN
+
+    //
+    // Timers still queued from a previous init are stopped, so a later
+    // start or stop does not take their stale slot as a place in the new
+    // heap.
+    //
+    if ( g_sVTimer.bInitialized )
+    {
+        for ( uint32_t i = 0; i < g_sVTimer.ui32Count; i++ )
+        {
+            g_sVTimer.ppsHeap[i]->ui32Slot = 0;
+        }
+    }
+
+    g_sVTimer.ui32CompareInstance = psConfig->ui32CompareInstance;
+    g_sVTimer.ui32CompareInt = AM_HAL_STIMER_INT_COMPAREA << psConfig->ui32CompareInstance;
+    g_sVTimer.ppsHeap = psConfig->ppsHeap;
+    g_sVTimer.ui32HeapSize = psConfig->ui32HeapSize;
+    g_sVTimer.ui32Count = 0;
+    g_sVTimer.sStats = (am_util_vtimer_stats_t) { 0 };
+
+    am_util_timestamp_init();
+    g_sVTimer.bInitialized = true;
+
+    am_hal_stimer_int_clear(g_sVTimer.ui32CompareInt);
+    am_hal_stimer_int_enable(g_sVTimer.ui32CompareInt);
+    vtimer_arm();
+
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Start (or restart) a timer.  The first expiry is ui32Delay ticks from now,
+// then every ui32Period ticks if ui32Period is not 0.
+//
+//*****************************************************************************
+uint32_t
+am_util_vtimer_start(am_util_vtimer_t *psTimer,
+                     uint32_t ui32Delay,
+                     uint32_t ui32Period,
+                     am_util_vtimer_callback_t pfnCallback,
+                     void *pCallbackCtxt)
+{
+    uint32_t ui32Status = AM_HAL_STATUS_SUCCESS;
+
+    if ( (psTimer == NULL) || (pfnCallback == NULL) )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    if ( !g_sVTimer.bInitialized )
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    AM_CRITICAL_BEGIN
+
+    if ( psTimer->ui32Slot )
+    {
+        vtimer_heap_remove(psTimer);
+    }
+
+    if ( g_sVTimer.ui32Count < g_sVTimer.ui32HeapSize )
+    {
+        psTimer->ui64Deadline = am_util_timestamp_get() + ui32Delay;
+        psTimer->ui32Period = ui32Period;
+        psTimer->pfnCallback = pfnCallback;
+        psTimer->pCallbackCtxt = pCallbackCtxt;
+        vtimer_heap_insert(psTimer);
+
+        //
+        // Only a new earliest deadline needs the hardware reprogrammed.  If
+        // it is already due, let the interrupt handler dispatch it.
+        //
+        if ( (psTimer->ui32Slot == 1) && !vtimer_arm() )
+        {
+            am_hal_stimer_int_set(g_sVTimer.ui32CompareInt);
+        }
+    }
+    else
+    {
+        ui32Status = AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    AM_CRITICAL_END
+
+    return ui32Status;
+}
+
+//*****************************************************************************
+//
+// Stop a timer.  Stopping a timer that is not running is not an error.
+//
+//*****************************************************************************
+uint32_t
+am_util_vtimer_stop(am_util_vtimer_t *psTimer)
+{
+    if ( psTimer == NULL )
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    //
+    // The compare register is left alone.  If this was the earliest timer the
+    // next interrupt simply finds nothing due and re-arms.
+    //
+    AM_CRITICAL_BEGIN
+
+    if ( psTimer->ui32Slot )
+    {
+        vtimer_heap_remove(psTimer);
+    }
+
+    AM_CRITICAL_END
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Returns true if the timer is running.
+//
+//*****************************************************************************
+bool
+am_util_vtimer_active(am_util_vtimer_t *psTimer)
+{
+    return psTimer->ui32Slot != 0;
+}
+
+//*****************************************************************************
+//
+// Returns the current time in STIMER ticks, extended to 64 bits.
+//
+//*****************************************************************************
+uint64_t
+am_util_vtimer_now(void)
+{
+    return am_util_timestamp_get();
+}
+
+//*****************************************************************************
+//
+// Compare interrupt service.  Runs the callback of every expired timer, up to
+// AM_UTIL_VTIMER_MAX_BATCH, then programs the next deadline.
+//
+//*****************************************************************************
+void
+am_util_vtimer_int_service(void)
+{
+    uint32_t ui32Batch = 0;
+
+    am_hal_stimer_int_clear(g_sVTimer.ui32CompareInt);
+    g_sVTimer.sStats.ui32Interrupts++;
+
+    while ( 1 )
+    {
+        am_util_vtimer_t *psTimer = NULL;
+        uint64_t ui64Now;
+        bool bArmed = false;
+
+        AM_CRITICAL_BEGIN
+
+        ui64Now = am_util_timestamp_get();
+
+        if ( g_sVTimer.ui32Count &&
+             (g_sVTimer.ppsHeap[0]->ui64Deadline <= ui64Now) &&
+             (ui32Batch < AM_UTIL_VTIMER_MAX_BATCH) )
+        {
+            uint32_t ui32Late;
+
+            psTimer = g_sVTimer.ppsHeap[0];
+            ui32Late = (uint32_t)(ui64Now - psTimer->ui64Deadline);
+            if ( ui32Late > g_sVTimer.sStats.ui32MaxLateness )
+            {
+                g_sVTimer.sStats.ui32MaxLateness = ui32Late;
+            }
+
+            if ( psTimer->ui32Period )
+            {
+                //
+                // Reload in place, keeping the timer on its original phase.
+                // Whole periods that have already passed are skipped rather
+                // than delivered as a burst of late callbacks.
+                //
+                psTimer->ui64Deadline += psTimer->ui32Period;
+                if ( psTimer->ui64Deadline <= ui64Now )
+                {
+                    uint64_t ui64Missed = (ui64Now - psTimer->ui64Deadline) /
+                                          psTimer->ui32Period + 1;
+
+                    psTimer->ui64Deadline += ui64Missed * psTimer->ui32Period;
+                    g_sVTimer.sStats.ui32Overruns += (uint32_t)ui64Missed;
+                }
+                vtimer_heap_sift_down(0);
+            }
+            else
+            {
+                vtimer_heap_remove(psTimer);
+            }
+        }
+        else
+        {
+            bArmed = vtimer_arm();
+
+            //
+            // At the batch limit with timers still due, come back shortly
+            // instead of looping here.
+            //
+            if ( !bArmed && (ui32Batch >= AM_UTIL_VTIMER_MAX_BATCH) )
+            {
+                am_hal_stimer_compare_delta_set(g_sVTimer.ui32CompareInstance,
+                                                AM_UTIL_VTIMER_MIN_DELTA);
+                g_sVTimer.sStats.ui32Deferrals++;
+                bArmed = true;
+            }
+        }
+
+        AM_CRITICAL_END
+
+        if ( psTimer )
+        {
+            //
+            // Callbacks run outside the critical section and may start or
+            // stop any timer, including their own.
+            //
+            ui32Batch++;
+            psTimer->pfnCallback(psTimer, psTimer->pCallbackCtxt);
+        }
+        else if ( bArmed )
+        {
+            break;
+        }
+    }
+
+    g_sVTimer.sStats.ui32Expirations += ui32Batch;
+    if ( ui32Batch > g_sVTimer.sStats.ui32MaxBatch )
+    {
+        g_sVTimer.sStats.ui32MaxBatch = ui32Batch;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns a copy of the service statistics.
+//
+//*****************************************************************************
+void
+am_util_vtimer_stats_get(am_util_vtimer_stats_t *psStats)
+{
+    AM_CRITICAL_BEGIN
+    *psStats = g_sVTimer.sStats;
+    AM_CRITICAL_END
+}
@@ -0,0 +1,197 @@
+//*****************************************************************************
+//
+//! @file am_util_vtimer.h
+//!
+//! @brief Virtual timers multiplexed on one STIMER compare channel.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2019, Ambiq Micro
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+// 
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision v2.2.0-7-g63f7c2ba1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#ifndef AM_UTIL_VTIMER_H
+#define AM_UTIL_VTIMER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Macro definitions
+//
+//*****************************************************************************
+//
+// Longest delta programmed into the compare register, well inside the range
+// of the 32-bit compare.
+//
+#define AM_UTIL_VTIMER_MAX_DELTA    0x40000000
+
+//
+// Smallest delta programmed into the compare register, since
+// am_hal_stimer_compare_delta_set() cannot reliably hit a closer one.
+//
+#define AM_UTIL_VTIMER_MIN_DELTA    2
+
+//
+// Most callbacks run by one interrupt. If more timers are still due, the
+// compare is set AM_UTIL_VTIMER_MIN_DELTA ticks out and the handler returns,
+// so a timer storm cannot hold off lower priority code indefinitely.
+//
+#ifndef AM_UTIL_VTIMER_MAX_BATCH
+#define AM_UTIL_VTIMER_MAX_BATCH    16
+#endif
+
+//*****************************************************************************
+//
+//! Timer callback, called from the STIMER compare interrupt.
+//
+//*****************************************************************************
+struct am_util_vtimer_s;
+typedef void (*am_util_vtimer_callback_t)(struct am_util_vtimer_s *psTimer,
+                                          void *pCtxt);
+
+//*****************************************************************************
+//
+//! Virtual timer.
+//!
+//! The timer is owned by the caller and must stay valid while it is running.
+//
+//*****************************************************************************
+typedef struct am_util_vtimer_s
+{
+    //
+    //! Absolute expiry time in STIMER ticks.
+    //
+    uint64_t                    ui64Deadline;
+
+    //
+    //! Reload period in STIMER ticks.  0 for a one-shot timer.
+    //
+    uint32_t                    ui32Period;
+
+    am_util_vtimer_callback_t   pfnCallback;
+    void                        *pCallbackCtxt;
+
+    //
+    // Internal state.  Position in the deadline heap plus one, 0 if stopped.
+    //
+    uint32_t                    ui32Slot;
+} am_util_vtimer_t;
+
+//*****************************************************************************
+//
+//! Service configuration.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    //! STIMER compare instance (0-7) owned by the service.  The STIMER must be
+    //! configured with the matching AM_HAL_STIMER_CFG_COMPARE_x_ENABLE, and
+    //! the application enables STIMER_CMPRn_IRQn and calls
+    //! am_util_vtimer_int_service() from am_stimer_cmprn_isr().
+    //!
+    //! Time is read from am_util_timestamp_get(), which am_util_vtimer_init()
+    //! starts, so the application must also enable STIMER_IRQn and call
+    //! am_util_timestamp_int_service() from am_stimer_isr().
+    //
+    uint32_t                    ui32CompareInstance;
+
+    //
+    //! Storage for the deadline heap, one entry per timer that may run at
+    //! the same time.
+    //
+    am_util_vtimer_t            **ppsHeap;
+    uint32_t                    ui32HeapSize;
+} am_util_vtimer_config_t;
+
+//*****************************************************************************
+//
+//! Service statistics.  Times are in STIMER ticks.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t                    ui32Interrupts;
+    uint32_t                    ui32Expirations;
+
+    //
+    //! Largest number of callbacks run by a single interrupt.
+    //
+    uint32_t                    ui32MaxBatch;
+
+    //
+    //! Largest delay from a deadline to its callback being called.
+    //
+    uint32_t                    ui32MaxLateness;
+
+    //
+    //! Periods skipped because a periodic timer fell a full period behind.
+    //
+    uint32_t                    ui32Overruns;
+
+    //
+    //! Interrupts that stopped at AM_UTIL_VTIMER_MAX_BATCH callbacks with
+    //! timers still due.
+    //
+    uint32_t                    ui32Deferrals;
+} am_util_vtimer_stats_t;
+
+//*****************************************************************************
+//
+// External function definitions
+//
+//*****************************************************************************
+extern uint32_t am_util_vtimer_init(const am_util_vtimer_config_t *psConfig);
+extern uint32_t am_util_vtimer_start(am_util_vtimer_t *psTimer,
+                                     uint32_t ui32Delay,
+                                     uint32_t ui32Period,
+                                     am_util_vtimer_callback_t pfnCallback,
+                                     void *pCallbackCtxt);
+extern uint32_t am_util_vtimer_stop(am_util_vtimer_t *psTimer);
+extern bool am_util_vtimer_active(am_util_vtimer_t *psTimer);
+extern uint64_t am_util_vtimer_now(void);
+extern void am_util_vtimer_int_service(void);
+extern void am_util_vtimer_stats_get(am_util_vtimer_stats_t *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_UTIL_VTIMER_H